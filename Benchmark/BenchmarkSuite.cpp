@@ -0,0 +1,172 @@
+#include "BenchmarkSuite.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace enco {
+	namespace {
+		const uint maxSamples = 10000;
+		const u32 fileVersion = 1;
+
+		std::string escape(const std::string &string) {
+			std::string escaped;
+			for (size_t i = 0; i < string.size(); ++i) {
+				char c = string[i];
+				if (c == '"' || c == '\\') {
+					escaped += '\\';
+					escaped += c;
+				}
+				else if ((u8)c >= 0x20) {
+					escaped += c;
+				}
+			}
+			return escaped;
+		}
+
+		// Only reads what save() writes: the string after "name" and the number after the next "median"
+		bool readString(const std::string &json, size_t &cursor, std::string &string) {
+			string.clear();
+			for (; cursor < json.size() && json[cursor] != '"'; ++cursor) {
+				if (json[cursor] == '\\' && cursor + 1 < json.size()) {
+					++cursor;
+				}
+				string += json[cursor];
+			}
+			return cursor < json.size();
+		}
+	}
+
+	BenchmarkSuite::BenchmarkSuite() : m_minTime(0.5), m_minSamples(10) {
+	}
+
+	void BenchmarkSuite::add(const std::string &name, uint items, Run run, Run prepare) {
+		Benchmark benchmark;
+		benchmark.name = name;
+		benchmark.items = items;
+		benchmark.run = run;
+		benchmark.prepare = prepare;
+		m_benchmarks.push_back(benchmark);
+	}
+
+	void BenchmarkSuite::run() {
+		for (size_t i = 0; i < m_benchmarks.size(); ++i) {
+			const Benchmark &benchmark = m_benchmarks[i];
+			if (!m_filter.empty() && benchmark.name.find(m_filter) == std::string::npos) {
+				continue;
+			}
+
+			// One untimed run warms caches, lazily built state and the worker threads
+			if (benchmark.prepare) {
+				benchmark.prepare();
+			}
+			benchmark.run();
+
+			std::vector<f64> samples;
+			f64 total = 0.0;
+			while ((samples.size() < m_minSamples || total < m_minTime * 1000.0) && samples.size() < maxSamples) {
+				if (benchmark.prepare) {
+					benchmark.prepare();
+				}
+				std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+				benchmark.run();
+				f64 time = std::chrono::duration<f64, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+				samples.push_back(time);
+				total += time;
+			}
+
+			std::sort(samples.begin(), samples.end());
+			BenchmarkResult result;
+			result.name = benchmark.name;
+			result.items = benchmark.items;
+			result.samples = (uint)samples.size();
+			result.mean = total / samples.size();
+			result.median = samples[samples.size() / 2];
+			result.min = samples.front();
+			result.p95 = samples[std::min(samples.size() - 1, (size_t)(samples.size() * 0.95))];
+			m_results.push_back(result);
+
+			printf("%-36s %10.4f ms %10.2f ns/item %6u samples\n", result.name.c_str(), result.median, result.getNanosecondsPerItem(), result.samples);
+		}
+		m_benchmarks.clear();
+	}
+
+	bool BenchmarkSuite::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out);
+		if (!file) {
+			return false;
+		}
+
+		file.precision(6);
+		file << "{\n\t\"version\": " << fileVersion << ",\n";
+		for (std::map<std::string, std::string>::const_iterator it = m_info.begin(); it != m_info.end(); ++it) {
+			file << "\t\"" << escape(it->first) << "\": \"" << escape(it->second) << "\",\n";
+		}
+		file << "\t\"results\": [\n";
+		for (size_t i = 0; i < m_results.size(); ++i) {
+			const BenchmarkResult &result = m_results[i];
+			file << "\t\t{ \"name\": \"" << escape(result.name) << "\", \"items\": " << result.items << ", \"samples\": " << result.samples;
+			file << ", \"mean\": " << result.mean << ", \"median\": " << result.median << ", \"min\": " << result.min << ", \"p95\": " << result.p95;
+			file << ", \"nsPerItem\": " << result.getNanosecondsPerItem() << " }" << (i + 1 < m_results.size() ? ",\n" : "\n");
+		}
+		file << "\t]\n}\n";
+		return file.good();
+	}
+
+	bool BenchmarkSuite::loadBaseline(const std::string &path) {
+		m_baseline.clear();
+
+		std::ifstream file(path.c_str(), std::ios::in);
+		if (!file) {
+			printf("Benchmark Error: could not read %s\n", path.c_str());
+			return false;
+		}
+		std::stringstream stream;
+		stream << file.rdbuf();
+		std::string json = stream.str();
+
+		const std::string nameKey = "\"name\": \"", medianKey = "\"median\": ";
+		size_t cursor = json.find(nameKey);
+		while (cursor != std::string::npos) {
+			cursor += nameKey.size();
+			std::string name;
+			if (!readString(json, cursor, name)) {
+				break;
+			}
+
+			size_t next = json.find(nameKey, cursor);
+			size_t median = json.find(medianKey, cursor);
+			if (median != std::string::npos && median < next) {
+				m_baseline[name] = strtod(json.c_str() + median + medianKey.size(), nullptr);
+			}
+			cursor = next;
+		}
+
+		if (m_baseline.empty()) {
+			printf("Benchmark Error: %s holds no results\n", path.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	uint BenchmarkSuite::compare(f64 tolerance) const {
+		uint regressions = 0;
+		for (size_t i = 0; i < m_results.size(); ++i) {
+			const BenchmarkResult &result = m_results[i];
+			std::map<std::string, f64>::const_iterator it = m_baseline.find(result.name);
+			if (it == m_baseline.end() || it->second <= 0.0) {
+				printf("%-36s %10.4f ms (no baseline)\n", result.name.c_str(), result.median);
+				continue;
+			}
+
+			f64 change = result.median / it->second - 1.0;
+			bool regression = change > tolerance;
+			regressions += regression ? 1 : 0;
+			printf("%-36s %10.4f ms %10.4f ms %+7.1f%%%s\n", result.name.c_str(), result.median, it->second, change * 100.0, regression ? "  REGRESSION" : "");
+		}
+		return regressions;
+	}
+}
\ No newline at end of file
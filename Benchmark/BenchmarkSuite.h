@@ -0,0 +1,76 @@
+#ifndef __BENCHMARK_BENCHMARKSUITE_H__
+#define __BENCHMARK_BENCHMARKSUITE_H__
+
+#pragma once
+
+#include <EncoShared\EncoShared.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Milliseconds per run
+	struct BenchmarkResult {
+		std::string name;
+		// Items one run processes, e.g. entities or jobs
+		uint items;
+		uint samples;
+		f64 mean, median, min, p95;
+
+		inline f64 getNanosecondsPerItem() const { return items ? median * 1000000.0 / items : 0.0; }
+	};
+
+	// Runs every benchmark until it has enough samples and ran long enough, writes the results as JSON and
+	// compares them with the medians of an earlier run.
+	class BenchmarkSuite {
+	public:
+		typedef std::function<void()> Run;
+
+		BenchmarkSuite();
+
+		inline void setMinTime(f64 seconds) { m_minTime = seconds; }
+		inline void setMinSamples(uint samples) { m_minSamples = samples; }
+		// Only benchmarks whose name contains filter run, all of them with an empty one
+		inline void setFilter(const std::string &filter) { m_filter = filter; }
+		// Shows up in the JSON next to the results, e.g. the GL renderer that ran the frames
+		inline void setInfo(const std::string &key, const std::string &value) { m_info[key] = value; }
+
+		// prepare runs untimed before every run, e.g. to mark transforms dirty again
+		void add(const std::string &name, uint items, Run run, Run prepare = Run());
+		// Runs the benchmarks added since the last call, appends their results and drops them, so the state they
+		// captured can be released before the next group is added
+		void run();
+
+		inline const std::vector<BenchmarkResult> &getResults() const { return m_results; }
+
+		bool save(const std::string &path) const;
+		bool loadBaseline(const std::string &path);
+		// Prints every result next to its baseline and returns the number of medians that grew by more than
+		// tolerance, e.g. 0.02 for 2%
+		uint compare(f64 tolerance) const;
+
+	private:
+		struct Benchmark {
+			std::string name;
+			uint items;
+			Run run;
+			Run prepare;
+		};
+
+		BenchmarkSuite(const BenchmarkSuite &) = delete;
+		BenchmarkSuite &operator=(const BenchmarkSuite &) = delete;
+
+		f64 m_minTime;
+		uint m_minSamples;
+		std::string m_filter;
+		std::map<std::string, std::string> m_info;
+		std::vector<Benchmark> m_benchmarks;
+		std::vector<BenchmarkResult> m_results;
+		// Median per name
+		std::map<std::string, f64> m_baseline;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,344 @@
+#include "CoreBenchmarks.h"
+
+#include <glm\gtc\matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+namespace enco {
+	namespace {
+		const uint matrixCount = 4096;
+		const uint boxCount = 16384;
+		const uint rootCount = 256;
+		const uint childCount = 64;
+		const uint movedLeafCount = 1024;
+		const uint churnCount = 16384;
+		const uint blockCount = 16384;
+		const uint spriteCount = 16384;
+		const uint regionCount = 16;
+		const uint debugBoxCount = 4096;
+		const uint jobCount = 4096;
+		const uint parallelForCount = 65536;
+		const uint parallelForBatch = 64;
+		const uint savedEntityCount = 200000;
+		const uint savedChildCount = 7;
+
+		// Results are written here so the optimizer cannot drop the work
+		volatile f32 sink = 0.0f;
+
+		template<typename T>
+		void shuffle(std::vector<T> &values, Random &random) {
+			for (size_t i = values.size(); i > 1; --i) {
+				std::swap(values[i - 1], values[random.nextBelow((u32)i)]);
+			}
+		}
+
+		glm::mat4 randomMatrix(Random &random) {
+			glm::mat4 matrix = glm::translate(glm::mat4(1.0f), glm::vec3(random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f)));
+			return glm::rotate(matrix, random.nextFloat(0.0f, 360.0f), glm::normalize(glm::vec3(random.nextFloat(-1.0f, 1.0f), 1.0f, random.nextFloat(-1.0f, 1.0f))));
+		}
+
+		struct MathData {
+			std::vector<glm::mat4> a, b, products;
+			std::vector<AABB> boxes, transformed;
+		};
+
+		struct CullingData {
+			Frustum frustum;
+			std::vector<AABB> boxes;
+			std::vector<BoundingSphere> spheres;
+			std::vector<f32> centerX, centerY, centerZ, extentX, extentY, extentZ;
+			std::vector<u8> visible;
+		};
+
+		struct TransformData {
+			Scene scene;
+			std::vector<Entity> roots;
+			std::vector<Entity> leaves;
+			f32 angle;
+
+			inline TransformData() : angle(0.0f) {  }
+		};
+
+		struct AllocationData {
+			Scene scene;
+			std::vector<Entity> entities;
+			std::vector<uint> sizes;
+			std::vector<uint> order;
+			std::vector<u8 *> blocks;
+		};
+
+		struct CommandData {
+			SpriteAtlas atlas;
+			SpriteBatch batch;
+			std::vector<SpriteInstance> instances;
+			DebugDraw debugDraw;
+			std::vector<AABB> boxes;
+			std::vector<DebugVertex> lines;
+			std::vector<DebugTextVertex> text;
+
+			inline CommandData() : atlas(128, 4), batch(atlas) {  }
+		};
+
+		struct SceneData {
+			Scene scene;
+			std::unique_ptr<Scene> loaded;
+			std::string path;
+
+			inline SceneData() : path("benchmark_scene.bin") {  }
+			inline ~SceneData() { std::remove(path.c_str()); }
+		};
+
+		void addMathBenchmarks(BenchmarkSuite &suite) {
+			std::shared_ptr<MathData> data = std::make_shared<MathData>();
+			Random random(1);
+			for (uint i = 0; i < matrixCount; ++i) {
+				data->a.push_back(randomMatrix(random));
+				data->b.push_back(randomMatrix(random));
+				glm::vec3 center(random.nextFloat(-10.0f, 10.0f), random.nextFloat(-10.0f, 10.0f), random.nextFloat(-10.0f, 10.0f));
+				data->boxes.push_back(AABB(center - glm::vec3(1.0f), center + glm::vec3(1.0f)));
+			}
+			data->products.resize(matrixCount);
+			data->transformed.resize(matrixCount);
+
+			suite.add("math/simdMultiplyMatrix", matrixCount, [data]() {
+				for (uint i = 0; i < matrixCount; ++i) {
+					simdMultiplyMatrix(&data->a[i][0][0], &data->b[i][0][0], &data->products[i][0][0]);
+				}
+				sink = data->products[matrixCount / 2][3][0];
+			});
+			suite.add("math/glmMultiplyMatrix", matrixCount, [data]() {
+				for (uint i = 0; i < matrixCount; ++i) {
+					data->products[i] = data->a[i] * data->b[i];
+				}
+				sink = data->products[matrixCount / 2][3][0];
+			});
+			suite.add("math/aabbTransform", matrixCount, [data]() {
+				for (uint i = 0; i < matrixCount; ++i) {
+					data->transformed[i] = data->boxes[i].transform(data->a[i]);
+				}
+				sink = data->transformed[matrixCount / 2].max.x;
+			});
+		}
+
+		void addCullingBenchmarks(BenchmarkSuite &suite) {
+			std::shared_ptr<CullingData> data = std::make_shared<CullingData>();
+			glm::mat4 projection = glm::perspective(60.0f, 16.0f / 9.0f, 0.1f, 1000.0f);
+			data->frustum.set(projection * glm::lookAt(glm::vec3(0.0f, 20.0f, 0.0f), glm::vec3(100.0f, 0.0f, 100.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+			Random random(2);
+			for (uint i = 0; i < boxCount; ++i) {
+				glm::vec3 center(random.nextFloat(-500.0f, 500.0f), random.nextFloat(-50.0f, 50.0f), random.nextFloat(-500.0f, 500.0f));
+				glm::vec3 extent(random.nextFloat(0.5f, 4.0f), random.nextFloat(0.5f, 4.0f), random.nextFloat(0.5f, 4.0f));
+				data->boxes.push_back(AABB(center - extent, center + extent));
+				data->spheres.push_back(BoundingSphere(center, glm::length(extent)));
+				data->centerX.push_back(center.x);
+				data->centerY.push_back(center.y);
+				data->centerZ.push_back(center.z);
+				data->extentX.push_back(extent.x);
+				data->extentY.push_back(extent.y);
+				data->extentZ.push_back(extent.z);
+			}
+			data->visible.resize(boxCount);
+
+			suite.add("culling/frustumSphere", boxCount, [data]() {
+				for (uint i = 0; i < boxCount; ++i) {
+					data->visible[i] = data->frustum.intersects(data->spheres[i]) ? 1 : 0;
+				}
+				sink = data->visible[boxCount / 2];
+			});
+			suite.add("culling/frustumAabb", boxCount, [data]() {
+				for (uint i = 0; i < boxCount; ++i) {
+					data->visible[i] = data->frustum.intersects(data->boxes[i]) ? 1 : 0;
+				}
+				sink = data->visible[boxCount / 2];
+			});
+			suite.add("culling/frustumAabbSoa", boxCount, [data]() {
+				data->frustum.intersects(&data->centerX[0], &data->centerY[0], &data->centerZ[0], &data->extentX[0], &data->extentY[0], &data->extentZ[0], boxCount, &data->visible[0]);
+				sink = data->visible[boxCount / 2];
+			});
+		}
+
+		void addTransformBenchmarks(BenchmarkSuite &suite) {
+			std::shared_ptr<TransformData> data = std::make_shared<TransformData>();
+			Random random(3);
+			for (uint i = 0; i < rootCount; ++i) {
+				Entity root = data->scene.createEntity(Scene::invalidEntity, Transform(glm::vec3(random.nextFloat(-500.0f, 500.0f), 0.0f, random.nextFloat(-500.0f, 500.0f)), glm::quat(), glm::vec3(1.0f)));
+				data->roots.push_back(root);
+				// Chains of four under every root, so updates walk a few levels deep
+				Entity parent = root;
+				for (uint j = 0; j < childCount; ++j) {
+					Entity child = data->scene.createEntity(j % 4 == 0 ? root : parent, Transform(glm::vec3(random.nextFloat(-4.0f, 4.0f), 1.0f, random.nextFloat(-4.0f, 4.0f)), glm::quat(), glm::vec3(1.0f)));
+					parent = child;
+					if (j % 4 == 3) {
+						data->leaves.push_back(child);
+					}
+				}
+			}
+			data->scene.updateTransforms();
+			shuffle(data->leaves, random);
+			data->leaves.resize(std::min((uint)data->leaves.size(), movedLeafCount));
+
+			suite.add("transforms/updateAll", rootCount * (childCount + 1), [data]() {
+				data->scene.updateTransforms();
+				sink = data->scene.getWorldMatrix(data->roots.back())[3][0];
+			}, [data]() {
+				data->angle += 1.0f;
+				for (size_t i = 0; i < data->roots.size(); ++i) {
+					Transform transform = data->scene.getTransform(data->roots[i]);
+					transform.rotation = glm::angleAxis(data->angle, glm::vec3(0.0f, 1.0f, 0.0f));
+					data->scene.setTransform(data->roots[i], transform);
+				}
+			});
+			suite.add("transforms/updateSparse", movedLeafCount, [data]() {
+				data->scene.updateTransforms();
+				sink = data->scene.getWorldMatrix(data->leaves.back())[3][0];
+			}, [data]() {
+				data->angle += 1.0f;
+				for (size_t i = 0; i < data->leaves.size(); ++i) {
+					Transform transform = data->scene.getTransform(data->leaves[i]);
+					transform.rotation = glm::angleAxis(data->angle, glm::vec3(0.0f, 1.0f, 0.0f));
+					data->scene.setTransform(data->leaves[i], transform);
+				}
+			});
+		}
+
+		void addAllocationBenchmarks(BenchmarkSuite &suite) {
+			std::shared_ptr<AllocationData> data = std::make_shared<AllocationData>();
+			Random random(4);
+			for (uint i = 0; i < blockCount; ++i) {
+				data->sizes.push_back(16 + random.nextBelow(241));
+				data->order.push_back(i);
+			}
+			// Frees in a different order than the allocations, like objects with unrelated lifetimes
+			shuffle(data->order, random);
+			data->entities.resize(churnCount);
+			data->blocks.resize(blockCount);
+
+			// Scene slots come from chunks with a free list, entities are reused after the first run
+			suite.add("allocation/sceneEntityChurn", churnCount, [data]() {
+				for (uint i = 0; i < churnCount; ++i) {
+					data->entities[i] = data->scene.createEntity();
+				}
+				for (uint i = 0; i < churnCount; ++i) {
+					data->scene.destroyEntity(data->entities[data->order[i]]);
+				}
+			});
+			// The same pattern on the heap, 16 to 256 bytes at a time
+			suite.add("allocation/heapSmallBlocks", blockCount, [data]() {
+				for (uint i = 0; i < blockCount; ++i) {
+					data->blocks[i] = new u8[data->sizes[i]];
+					data->blocks[i][0] = (u8)i;
+				}
+				uint sum = 0;
+				for (uint i = 0; i < blockCount; ++i) {
+					u8 *block = data->blocks[data->order[i]];
+					sum += block[0];
+					delete[] block;
+				}
+				sink = (f32)sum;
+			});
+		}
+
+		void addCommandBenchmarks(BenchmarkSuite &suite, JobSystem &jobSystem) {
+			std::shared_ptr<CommandData> data = std::make_shared<CommandData>();
+			std::vector<u8> pixels(32 * 32 * 4, 255);
+			for (uint i = 0; i < regionCount; ++i) {
+				data->atlas.add("sprite" + std::to_string(i), &pixels[0], 32, 32);
+			}
+			Random random(5);
+			for (uint i = 0; i < debugBoxCount; ++i) {
+				glm::vec3 center(random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f), random.nextFloat(-100.0f, 100.0f));
+				data->boxes.push_back(AABB(center - glm::vec3(1.0f), center + glm::vec3(1.0f)));
+			}
+
+			// Recording, sorting and gathering one frame of sprites across pages and layers
+			suite.add("commands/spriteBatch", spriteCount, [data]() {
+				for (uint i = 0; i < spriteCount; ++i) {
+					data->batch.add(i % regionCount, glm::vec2((f32)(i % 256) * 8.0f, (f32)(i / 256) * 8.0f), glm::vec4(1.0f), 0.0f, (i16)(i % 8));
+				}
+				data->batch.sort();
+				data->instances.resize(data->batch.getCount());
+				data->batch.gather(&data->instances[0]);
+				sink = data->instances.back().center.x;
+			}, [data]() {
+				data->batch.clear();
+			});
+			// Debug boxes recorded from every worker into their own buffers, then gathered like the renderer does
+			JobSystem *jobs = &jobSystem;
+			suite.add("commands/debugDrawParallel", debugBoxCount, [data, jobs]() {
+				const glm::vec4 color(0.0f, 1.0f, 0.0f, 1.0f);
+				jobs->parallelFor(debugBoxCount, 256, [&data, &color](uint begin, uint end) {
+					for (uint i = begin; i < end; ++i) {
+						data->debugDraw.box(data->boxes[i], color);
+					}
+				});
+				data->lines.resize(data->debugDraw.getLineVertexCount());
+				data->text.resize(data->debugDraw.getTextVertexCount());
+				data->debugDraw.gather(data->lines.empty() ? nullptr : &data->lines[0], data->text.empty() ? nullptr : &data->text[0]);
+				sink = data->lines.empty() ? 0.0f : data->lines.back().position.x;
+			}, [data]() {
+				data->debugDraw.clear();
+			});
+		}
+
+		void addSceneBenchmarks(BenchmarkSuite &suite) {
+			std::shared_ptr<SceneData> data = std::make_shared<SceneData>();
+			Random random(6);
+			Entity root = Scene::invalidEntity;
+			for (uint i = 0; i < savedEntityCount; ++i) {
+				Transform transform(glm::vec3(random.nextFloat(-500.0f, 500.0f), random.nextFloat(-10.0f, 10.0f), random.nextFloat(-500.0f, 500.0f)), glm::quat(), glm::vec3(1.0f));
+				Entity entity = data->scene.createEntity(i % (savedChildCount + 1) == 0 ? Scene::invalidEntity : root, transform);
+				if (i % (savedChildCount + 1) == 0) {
+					root = entity;
+				}
+			}
+			// The load benchmarks read what the first save wrote
+			data->scene.save(data->path);
+
+			suite.add("scene/save", savedEntityCount, [data]() {
+				data->scene.save(data->path);
+			});
+			// Only reading the blob, the components are used in place
+			suite.add("scene/loadBlob", savedEntityCount, [data]() {
+				SceneBlob blob;
+				blob.load(data->path);
+				sink = (f32)blob.getEntityCount();
+			});
+			// Reading the blob and creating every entity of it in an empty scene
+			suite.add("scene/load", savedEntityCount, [data]() {
+				data->loaded->load(data->path);
+				sink = (f32)data->loaded->getEntityCount();
+			}, [data]() {
+				data->loaded.reset(new Scene());
+			});
+		}
+
+		void addJobBenchmarks(BenchmarkSuite &suite, JobSystem &jobSystem) {
+			JobSystem *jobs = &jobSystem;
+			// Pure scheduling cost: queueing, stealing by the workers and waiting on the counter
+			suite.add("jobs/runEmpty", jobCount, [jobs]() {
+				JobCounter counter;
+				for (uint i = 0; i < jobCount; ++i) {
+					jobs->run([]() {}, &counter);
+				}
+				jobs->wait(counter);
+			});
+			suite.add("jobs/parallelForEmpty", parallelForCount / parallelForBatch, [jobs]() {
+				jobs->parallelFor(parallelForCount, parallelForBatch, [](uint begin, uint end) {});
+			});
+		}
+	}
+
+	void addCoreBenchmarks(BenchmarkSuite &suite, JobSystem &jobSystem) {
+		addMathBenchmarks(suite);
+		addCullingBenchmarks(suite);
+		addTransformBenchmarks(suite);
+		addAllocationBenchmarks(suite);
+		addCommandBenchmarks(suite, jobSystem);
+		addSceneBenchmarks(suite);
+		addJobBenchmarks(suite, jobSystem);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#ifndef __BENCHMARK_COREBENCHMARKS_H__
+#define __BENCHMARK_COREBENCHMARKS_H__
+
+#pragma once
+
+#include "BenchmarkSuite.h"
+
+namespace enco {
+	// Math kernels, culling, transform updates, allocation, command recording, scene save and load and job system
+	// overhead, each at the scale of a large scene
+	void addCoreBenchmarks(BenchmarkSuite &suite, JobSystem &jobSystem);
+}
+
+#endif
\ No newline at end of file
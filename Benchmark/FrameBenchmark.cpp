@@ -0,0 +1,100 @@
+#include "FrameBenchmark.h"
+
+#include <glm\gtc\matrix_transform.hpp>
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const uint rootCount = 256;
+		const uint childCount = 64;
+		const uint regionCount = 16;
+		const uint spriteCount = 2048;
+		const uint maxDebugBoxes = 4096;
+	}
+
+	FrameBenchmark::FrameBenchmark(std::shared_ptr<IRenderer> renderer, const glm::u32vec2 &size) : m_atlas(new SpriteAtlas(256, 4)), m_visibleCount(0), m_angle(0.0f) {
+		m_sprites.reset(new SpriteBatch(*m_atlas));
+		std::vector<u8> pixels(32 * 32 * 4, 255);
+		for (uint i = 0; i < regionCount; ++i) {
+			m_atlas->add("sprite" + std::to_string(i), &pixels[0], 32, 32);
+		}
+
+		m_context.reset(new EncoContext(std::make_shared<OffscreenView>("Benchmark", size), renderer));
+		m_context->setRenderCallback([this](IView &view, IRenderer &renderer) { render(view, renderer); });
+		m_context->start();
+
+		Scene &scene = m_context->getScene();
+		Random random(6);
+		for (uint i = 0; i < rootCount; ++i) {
+			Entity root = scene.createEntity(Scene::invalidEntity, Transform(glm::vec3(random.nextFloat(-300.0f, 300.0f), 0.0f, random.nextFloat(-300.0f, 300.0f)), glm::quat(), glm::vec3(1.0f)));
+			m_roots.push_back(root);
+			m_entities.push_back(root);
+			Entity parent = root;
+			for (uint j = 0; j < childCount; ++j) {
+				parent = scene.createEntity(j % 4 == 0 ? root : parent, Transform(glm::vec3(random.nextFloat(-4.0f, 4.0f), 1.0f, random.nextFloat(-4.0f, 4.0f)), glm::quat(), glm::vec3(1.0f)));
+				m_entities.push_back(parent);
+			}
+		}
+
+		for (uint i = 0; i < 3; ++i) {
+			m_centers[i].resize(m_entities.size());
+			m_extents[i].assign(m_entities.size(), 1.0f);
+		}
+		m_visible.resize(m_entities.size());
+	}
+
+	FrameBenchmark::~FrameBenchmark() {
+		m_context->stop();
+	}
+
+	void FrameBenchmark::update() {
+		m_angle += 1.0f;
+		Scene &scene = m_context->getScene();
+		for (size_t i = 0; i < m_roots.size(); ++i) {
+			Transform transform = scene.getTransform(m_roots[i]);
+			transform.rotation = glm::angleAxis(m_angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			scene.setTransform(m_roots[i], transform);
+		}
+		m_context->update();
+	}
+
+	void FrameBenchmark::render(IView &view, IRenderer &renderer) {
+		glm::u32vec2 size = view.getSize();
+		glm::mat4 projection = glm::perspective(60.0f, (f32)size.x / (f32)std::max(size.y, 1u), 0.1f, 1000.0f);
+		glm::mat4 viewProjection = projection * glm::lookAt(glm::vec3(0.0f, 80.0f, -400.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+
+		renderer.setClearColor(0.1f, 0.1f, 0.1f);
+		renderer.clearBuffer(colorBuffer | depthBuffer);
+
+		const Scene &scene = m_context->getScene();
+		for (size_t i = 0; i < m_entities.size(); ++i) {
+			const glm::mat4 &world = scene.getWorldMatrix(m_entities[i]);
+			m_centers[0][i] = world[3].x;
+			m_centers[1][i] = world[3].y;
+			m_centers[2][i] = world[3].z;
+		}
+		Frustum frustum(viewProjection);
+		frustum.intersects(&m_centers[0][0], &m_centers[1][0], &m_centers[2][0], &m_extents[0][0], &m_extents[1][0], &m_extents[2][0], (uint)m_entities.size(), &m_visible[0]);
+
+		DebugDraw &debugDraw = m_context->getDebugDraw();
+		const glm::vec4 color(0.0f, 1.0f, 0.0f, 1.0f);
+		m_visibleCount = 0;
+		for (size_t i = 0; i < m_entities.size(); ++i) {
+			if (m_visible[i] && m_visibleCount++ < maxDebugBoxes) {
+				glm::vec3 center(m_centers[0][i], m_centers[1][i], m_centers[2][i]);
+				debugDraw.box(AABB(center - glm::vec3(1.0f), center + glm::vec3(1.0f)), color);
+			}
+		}
+		if (m_debugDrawCallback) {
+			m_debugDrawCallback(debugDraw, viewProjection);
+		}
+
+		m_sprites->clear();
+		for (uint i = 0; i < spriteCount; ++i) {
+			glm::vec2 center((f32)(i % 64) * (f32)size.x / 64.0f, (f32)(i / 64) * (f32)size.y / 32.0f);
+			m_sprites->add(i % regionCount, center, glm::vec2(16.0f), glm::vec4(1.0f), m_angle * 0.01f, (i16)(i % 4));
+		}
+		renderer.drawSprites(*m_sprites);
+	}
+}
\ No newline at end of file
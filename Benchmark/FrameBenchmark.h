@@ -0,0 +1,52 @@
+#ifndef __BENCHMARK_FRAMEBENCHMARK_H__
+#define __BENCHMARK_FRAMEBENCHMARK_H__
+
+#pragma once
+
+#include <EncoShared\EncoShared.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace enco {
+	// Whole EncoContext frames of a fixed scene drawn into an OffscreenView: moving hierarchies, SoA culling of
+	// every entity, debug boxes for the visible ones and a screen of sprites. The same frames run on any
+	// renderer, so the null renderer gives the engine's cost and a GL renderer adds the driver's.
+	class FrameBenchmark {
+	public:
+		// Draws what IRenderer has no call for, e.g. OpenGLRenderer::drawDebug
+		typedef std::function<void(const DebugDraw &debugDraw, const glm::mat4 &viewProjection)> DebugDrawCallback;
+
+		FrameBenchmark(std::shared_ptr<IRenderer> renderer, const glm::u32vec2 &size);
+		~FrameBenchmark();
+
+		inline void setDebugDrawCallback(DebugDrawCallback callback) { m_debugDrawCallback = callback; }
+
+		void update();
+
+		inline EncoContext &getContext() { return *m_context; }
+		inline uint getEntityCount() const { return (uint)m_entities.size(); }
+		inline uint getVisibleCount() const { return m_visibleCount; }
+
+	private:
+		FrameBenchmark(const FrameBenchmark &) = delete;
+		FrameBenchmark &operator=(const FrameBenchmark &) = delete;
+
+		void render(IView &view, IRenderer &renderer);
+
+		std::unique_ptr<EncoContext> m_context;
+		std::unique_ptr<SpriteAtlas> m_atlas;
+		std::unique_ptr<SpriteBatch> m_sprites;
+		DebugDrawCallback m_debugDrawCallback;
+		std::vector<Entity> m_roots;
+		std::vector<Entity> m_entities;
+		std::vector<f32> m_centers[3];
+		std::vector<f32> m_extents[3];
+		std::vector<u8> m_visible;
+		uint m_visibleCount;
+		f32 m_angle;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#include "NullRenderer.h"
+
+namespace enco {
+	NullRenderer::NullRenderer() : m_frame(0), m_spriteCount(0) {
+	}
+
+	void NullRenderer::createContext(int x, int y, uint width, uint height, uint colorBits, uint depthBits, uint stencilBits, bool fullscreen, SDL_WINDOW sdlWindow) {
+	}
+
+	void NullRenderer::deleteContext(SDL_WINDOW sdlWindow) {
+		m_readbacks.clear();
+	}
+
+	void NullRenderer::beginFrame() {
+		m_spriteCount = 0;
+	}
+
+	void NullRenderer::endFrame() {
+		std::vector<Readback> readbacks;
+		readbacks.swap(m_readbacks);
+		for (size_t i = 0; i < readbacks.size(); ++i) {
+			std::vector<u8> pixels((size_t)readbacks[i].width * readbacks[i].height * 4, 0);
+			readbacks[i].callback(pixels.empty() ? nullptr : &pixels[0], readbacks[i].width, readbacks[i].height, m_frame);
+		}
+		++m_frame;
+	}
+
+	std::shared_ptr<IRenderTarget> NullRenderer::createRenderTarget(const RenderTargetDescription &description) {
+		return std::make_shared<NullRenderTarget>(description);
+	}
+
+	void NullRenderer::readback(IRenderTarget *target, ReadbackCallback callback) {
+		Readback readback;
+		readback.width = target ? target->getWidth() : 0;
+		readback.height = target ? target->getHeight() : 0;
+		readback.callback = callback;
+		m_readbacks.push_back(readback);
+	}
+
+	void NullRenderer::drawSprites(SpriteBatch &batch) {
+		batch.sort();
+		m_sprites.resize(batch.getCount());
+		if (!m_sprites.empty()) {
+			batch.gather(&m_sprites[0]);
+		}
+		m_spriteCount += batch.getCount();
+	}
+}
\ No newline at end of file
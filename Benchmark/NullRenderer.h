@@ -0,0 +1,71 @@
+#ifndef __BENCHMARK_NULLRENDERER_H__
+#define __BENCHMARK_NULLRENDERER_H__
+
+#pragma once
+
+#include <EncoShared\EncoShared.h>
+
+#include <vector>
+
+namespace enco {
+	class NullRenderTarget : public IRenderTarget {
+	public:
+		inline NullRenderTarget(const RenderTargetDescription &description) : m_description(description) {  }
+
+		inline virtual const RenderTargetDescription &getDescription() const { return m_description; }
+
+	private:
+		RenderTargetDescription m_description;
+	};
+
+	// A renderer without a GPU. It still does the CPU side of what it is handed, like sorting and gathering
+	// sprite batches, so frames measured with it are the engine's cost without the driver's.
+	class NullRenderer : public IRenderer {
+	public:
+		NullRenderer();
+
+		virtual void createContext(int x, int y, uint width, uint height, uint colorBits, uint depthBits, uint stencilBits, bool fullscreen, SDL_WINDOW sdlWindow);
+		virtual void deleteContext(SDL_WINDOW sdlWindow);
+
+		inline virtual int getSDLOptions() { return 0; }
+
+		virtual void beginFrame();
+		virtual void endFrame();
+
+		inline virtual void beginView(SDL_WINDOW sdlWindow, uint width, uint height) {  }
+		inline virtual void endView(SDL_WINDOW sdlWindow) {  }
+
+		virtual std::shared_ptr<IRenderTarget> createRenderTarget(const RenderTargetDescription &description);
+		inline virtual void bindRenderTarget(IRenderTarget *target) {  }
+
+		// Answered from endFrame with a blank image
+		virtual void readback(IRenderTarget *target, ReadbackCallback callback);
+
+		inline virtual void setClearColor(f32 r, f32 g, f32 b) {  }
+		inline virtual void setClearDepth(f64 clearDepth) {  }
+		inline virtual void clearBuffer(int buffers) {  }
+
+		virtual void drawSprites(SpriteBatch &batch);
+
+		inline virtual f32 getGpuFrameTime() const { return 0.0f; }
+
+		inline u64 getFrameIndex() const { return m_frame; }
+		inline uint getSpriteCount() const { return m_spriteCount; }
+
+	private:
+		struct Readback {
+			uint width, height;
+			ReadbackCallback callback;
+		};
+
+		NullRenderer(const NullRenderer &) = delete;
+		NullRenderer &operator=(const NullRenderer &) = delete;
+
+		u64 m_frame;
+		uint m_spriteCount;
+		std::vector<SpriteInstance> m_sprites;
+		std::vector<Readback> m_readbacks;
+	};
+}
+
+#endif
\ No newline at end of file
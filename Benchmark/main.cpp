@@ -0,0 +1,117 @@
+#include <EncoShared\EncoShared.h>
+#include <EncoOpenGL\EncoOpenGL.h>
+
+#include "BenchmarkSuite.h"
+#include "CoreBenchmarks.h"
+#include "FrameBenchmark.h"
+#include "NullRenderer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace enco;
+
+namespace {
+	const glm::u32vec2 frameSize(1280, 720);
+
+	void printUsage() {
+		printf("Benchmark [--filter text] [--output results.json] [--baseline results.json] [--tolerance 0.05]\n");
+		printf("          [--min-time seconds] [--no-gl] [--llvmpipe]\n");
+	}
+}
+
+int main(int argc, char **argv) {
+	std::string output = "benchmark.json", baseline;
+	f64 tolerance = 0.05;
+	bool openGL = true;
+
+	BenchmarkSuite suite;
+	for (int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--filter") == 0 && hasValue) {
+			suite.setFilter(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--output") == 0 && hasValue) {
+			output = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && hasValue) {
+			baseline = argv[++i];
+		}
+		else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) {
+			tolerance = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--min-time") == 0 && hasValue) {
+			suite.setMinTime(atof(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--no-gl") == 0) {
+			openGL = false;
+		}
+		else if (strcmp(argv[i], "--llvmpipe") == 0) {
+			OpenGLRenderer::forceLlvmpipe();
+		}
+		else {
+			printUsage();
+			return 2;
+		}
+	}
+
+	// Read before anything runs, the output may overwrite the same file
+	if (!baseline.empty() && !suite.loadBaseline(baseline)) {
+		return 2;
+	}
+
+#ifdef _DEBUG
+	suite.setInfo("build", "debug");
+#else
+	suite.setInfo("build", "release");
+#endif
+#ifdef ENCO_SIMD_SSE
+	suite.setInfo("simd", "sse2");
+#else
+	suite.setInfo("simd", "none");
+#endif
+
+	{
+		JobSystem jobSystem;
+		suite.setInfo("workers", std::to_string(jobSystem.getWorkerCount()));
+		addCoreBenchmarks(suite, jobSystem);
+		suite.run();
+	}
+
+	{
+		FrameBenchmark frames(std::make_shared<NullRenderer>(), frameSize);
+		suite.add("frame/null", 1, [&frames]() { frames.update(); });
+		suite.run();
+	}
+
+	if (openGL) {
+		std::shared_ptr<OpenGLRenderer> renderer = std::make_shared<OpenGLRenderer>();
+		renderer->setVSync(false);
+		FrameBenchmark frames(renderer, frameSize);
+		const char *name = renderer->isHeadless() ? (const char *)glGetString(GL_RENDERER) : nullptr;
+		if (name) {
+			suite.setInfo("glRenderer", name);
+			frames.setDebugDrawCallback([&renderer](const DebugDraw &debugDraw, const glm::mat4 &viewProjection) { renderer->drawDebug(debugDraw, viewProjection); });
+			// glFinish keeps the rasterizer's work in the frame that issued it instead of the ones after
+			suite.add("frame/opengl", 1, [&frames]() { frames.update(); glFinish(); });
+			suite.run();
+		}
+		else {
+			printf("Benchmark: no headless GL context, frame/opengl is skipped\n");
+		}
+	}
+
+	if (!output.empty() && !suite.save(output)) {
+		printf("Benchmark Error: could not write %s\n", output.c_str());
+	}
+
+	uint regressions = 0;
+	if (!baseline.empty()) {
+		printf("\n");
+		regressions = suite.compare(tolerance);
+		printf("%u regression(s) above %.1f%%\n", regressions, tolerance * 100.0);
+	}
+	return regressions > 0 ? 1 : 0;
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "DesktopAudio.h"
+
+namespace enco {
+	ENCODESKTOPAPI DesktopAudio::DesktopAudio() : m_mixer(nullptr), m_device(0) {
+	}
+
+	ENCODESKTOPAPI DesktopAudio::~DesktopAudio() {
+		close();
+	}
+
+	ENCODESKTOPAPI bool DesktopAudio::open(AudioMixer *mixer, uint bufferFrames) {
+		close();
+		if (!mixer || SDL_InitSubSystem(SDL_INIT_AUDIO) != 0) {
+			return false;
+		}
+
+		SDL_AudioSpec desired, obtained;
+		SDL_zero(desired);
+		desired.freq = (int)mixer->getSampleRate();
+		desired.format = AUDIO_F32SYS;
+		desired.channels = 2;
+		desired.samples = (Uint16)bufferFrames;
+		desired.callback = callback;
+		desired.userdata = this;
+
+		// No allowed changes, SDL converts if the device wants something else
+		m_mixer = mixer;
+		m_device = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+		if (m_device == 0) {
+#ifdef _DEBUG
+			printf("DesktopAudio Error: %s\n", SDL_GetError());
+#endif
+			m_mixer = nullptr;
+			SDL_QuitSubSystem(SDL_INIT_AUDIO);
+			return false;
+		}
+
+		SDL_PauseAudioDevice(m_device, 0);
+		return true;
+	}
+
+	ENCODESKTOPAPI void DesktopAudio::close() {
+		if (m_device == 0) {
+			return;
+		}
+
+		SDL_CloseAudioDevice(m_device);
+		m_device = 0;
+		m_mixer = nullptr;
+		SDL_QuitSubSystem(SDL_INIT_AUDIO);
+	}
+
+	ENCODESKTOPAPI void DesktopAudio::setPaused(bool paused) {
+		if (m_device != 0) {
+			SDL_PauseAudioDevice(m_device, paused ? 1 : 0);
+		}
+	}
+
+	void SDLCALL DesktopAudio::callback(void *userdata, Uint8 *stream, int length) {
+		DesktopAudio *audio = (DesktopAudio *)userdata;
+		audio->m_mixer->mix((f32 *)stream, (uint)length / (2 * sizeof(f32)));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef __ENCODESKTOP_DESKTOPAUDIO_H__
+#define __ENCODESKTOP_DESKTOPAUDIO_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+namespace enco {
+	// Plays an AudioMixer on the default SDL audio device. The SDL callback runs on SDL's audio thread and only calls mix().
+	class DesktopAudio {
+	public:
+		ENCODESKTOPAPI DesktopAudio();
+		ENCODESKTOPAPI ~DesktopAudio();
+
+		// The device is opened with the sample rate of the mixer, bufferFrames is the latency in frames
+		ENCODESKTOPAPI bool open(AudioMixer *mixer, uint bufferFrames = AudioMixer::maxBlockFrames);
+		ENCODESKTOPAPI void close();
+
+		ENCODESKTOPAPI void setPaused(bool paused);
+		inline bool isOpen() const { return m_device != 0; }
+
+	private:
+		DesktopAudio(const DesktopAudio &) = delete;
+		DesktopAudio &operator=(const DesktopAudio &) = delete;
+
+		static void SDLCALL callback(void *userdata, Uint8 *stream, int length);
+
+		AudioMixer *m_mixer;
+		SDL_AudioDeviceID m_device;
+	};
+}
+
+#endif
\ No newline at end of file
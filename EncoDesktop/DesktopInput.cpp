@@ -0,0 +1,230 @@
+#include "stdafx.h"
+#include "DesktopInput.h"
+
+#include <algorithm>
+
+namespace enco {
+	std::vector<DesktopInput *> DesktopInput::s_instances;
+	SDL_GameController *DesktopInput::s_gamepads[InputState::maxGamepads] = {};
+	SDL_JoystickID DesktopInput::s_gamepadIds[InputState::maxGamepads] = { -1, -1, -1, -1 };
+	bool DesktopInput::s_quit = false;
+
+	ENCODESKTOPAPI DesktopInput::DesktopInput() : m_windowId(0), m_input(nullptr), m_closed(false), m_rawMouse(false) {
+	}
+
+	ENCODESKTOPAPI void DesktopInput::open(SDL_Window *window, Input *input) {
+		if (s_instances.empty()) {
+			SDL_InitSubSystem(SDL_INIT_GAMECONTROLLER);
+			SDL_SetHint(SDL_HINT_MOUSE_RELATIVE_MODE_WARP, "0");
+
+			// Input nobody reads does not need to be queued
+			SDL_EventState(SDL_TEXTEDITING, SDL_IGNORE);
+			SDL_EventState(SDL_JOYAXISMOTION, SDL_IGNORE);
+			SDL_EventState(SDL_JOYBALLMOTION, SDL_IGNORE);
+			SDL_EventState(SDL_JOYHATMOTION, SDL_IGNORE);
+			SDL_EventState(SDL_JOYBUTTONDOWN, SDL_IGNORE);
+			SDL_EventState(SDL_JOYBUTTONUP, SDL_IGNORE);
+
+			s_quit = false;
+		}
+
+		m_windowId = window ? SDL_GetWindowID(window) : 0;
+		m_input = input;
+		m_closed = false;
+		s_instances.push_back(this);
+	}
+
+	ENCODESKTOPAPI void DesktopInput::close() {
+		std::vector<DesktopInput *>::iterator it = std::find(s_instances.begin(), s_instances.end(), this);
+		if (it == s_instances.end()) {
+			return;
+		}
+		s_instances.erase(it);
+
+		if (m_rawMouse) {
+			setRawMouse(false);
+		}
+		m_input = nullptr;
+
+		if (s_instances.empty()) {
+			for (uint i = 0; i < InputState::maxGamepads; ++i) {
+				if (s_gamepads[i]) {
+					SDL_GameControllerClose(s_gamepads[i]);
+					s_gamepads[i] = nullptr;
+					s_gamepadIds[i] = -1;
+				}
+			}
+			SDL_QuitSubSystem(SDL_INIT_GAMECONTROLLER);
+		}
+	}
+
+	ENCODESKTOPAPI bool DesktopInput::pump() {
+		SDL_PumpEvents();
+
+		SDL_Event events[eventBatchSize];
+
+		int count;
+		while ((count = SDL_PeepEvents(events, eventBatchSize, SDL_GETEVENT, SDL_FIRSTEVENT, SDL_LASTEVENT)) > 0) {
+			for (int i = 0; i < count; ++i) {
+				dispatch(events[i]);
+			}
+
+			if (count < eventBatchSize) {
+				break;
+			}
+		}
+
+		if (m_input) {
+			m_input->swap();
+		}
+		return !s_quit && !m_closed;
+	}
+
+	ENCODESKTOPAPI void DesktopInput::setRawMouse(bool enabled) {
+		if (SDL_SetRelativeMouseMode(enabled ? SDL_TRUE : SDL_FALSE) == 0) {
+			m_rawMouse = enabled;
+		}
+	}
+
+	void DesktopInput::dispatch(const SDL_Event &sdlEvent) {
+		InputEvent event;
+		event.device = 0;
+		event.code = 0;
+		event.timestamp = sdlEvent.common.timestamp;
+
+		Uint32 windowId = 0;
+
+		switch (sdlEvent.type) {
+		case SDL_QUIT:
+			s_quit = true;
+			return;
+
+		case SDL_WINDOWEVENT:
+			if (sdlEvent.window.event == SDL_WINDOWEVENT_CLOSE) {
+				if (DesktopInput *target = findWindow(sdlEvent.window.windowID)) {
+					target->m_closed = true;
+				}
+			}
+			return;
+
+		case SDL_KEYDOWN:
+		case SDL_KEYUP:
+			if (sdlEvent.key.repeat) {
+				return;
+			}
+			event.type = sdlEvent.type == SDL_KEYDOWN ? InputEventType::keyDownEvent : InputEventType::keyUpEvent;
+			event.code = (uint16)sdlEvent.key.keysym.scancode;
+			windowId = sdlEvent.key.windowID;
+			break;
+
+		case SDL_MOUSEMOTION:
+			event.type = InputEventType::mouseMotionEvent;
+			event.motion.x = sdlEvent.motion.x;
+			event.motion.y = sdlEvent.motion.y;
+			event.motion.dx = sdlEvent.motion.xrel;
+			event.motion.dy = sdlEvent.motion.yrel;
+			windowId = sdlEvent.motion.windowID;
+			break;
+
+		case SDL_MOUSEBUTTONDOWN:
+		case SDL_MOUSEBUTTONUP:
+			event.type = sdlEvent.type == SDL_MOUSEBUTTONDOWN ? InputEventType::mouseButtonDownEvent : InputEventType::mouseButtonUpEvent;
+			event.code = (uint16)(sdlEvent.button.button - SDL_BUTTON_LEFT);
+			windowId = sdlEvent.button.windowID;
+			break;
+
+		case SDL_MOUSEWHEEL:
+			event.type = InputEventType::mouseWheelEvent;
+			event.wheel.x = sdlEvent.wheel.x;
+			event.wheel.y = sdlEvent.wheel.y;
+			windowId = sdlEvent.wheel.windowID;
+			break;
+
+		case SDL_CONTROLLERDEVICEADDED: {
+			int slot = findGamepad(-1);
+			if (slot < 0) {
+				return;
+			}
+			s_gamepads[slot] = SDL_GameControllerOpen(sdlEvent.cdevice.which);
+			if (!s_gamepads[slot]) {
+				return;
+			}
+			s_gamepadIds[slot] = SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(s_gamepads[slot]));
+			event.type = InputEventType::gamepadConnectedEvent;
+			event.device = (uint8)slot;
+			break;
+		}
+
+		case SDL_CONTROLLERDEVICEREMOVED: {
+			int slot = findGamepad(sdlEvent.cdevice.which);
+			if (slot < 0) {
+				return;
+			}
+			SDL_GameControllerClose(s_gamepads[slot]);
+			s_gamepads[slot] = nullptr;
+			s_gamepadIds[slot] = -1;
+			event.type = InputEventType::gamepadDisconnectedEvent;
+			event.device = (uint8)slot;
+			break;
+		}
+
+		case SDL_CONTROLLERBUTTONDOWN:
+		case SDL_CONTROLLERBUTTONUP: {
+			int slot = findGamepad(sdlEvent.cbutton.which);
+			if (slot < 0) {
+				return;
+			}
+			event.type = sdlEvent.type == SDL_CONTROLLERBUTTONDOWN ? InputEventType::gamepadButtonDownEvent : InputEventType::gamepadButtonUpEvent;
+			event.device = (uint8)slot;
+			event.code = sdlEvent.cbutton.button;
+			break;
+		}
+
+		case SDL_CONTROLLERAXISMOTION: {
+			int slot = findGamepad(sdlEvent.caxis.which);
+			if (slot < 0) {
+				return;
+			}
+			event.type = InputEventType::gamepadAxisEvent;
+			event.device = (uint8)slot;
+			event.code = sdlEvent.caxis.axis;
+			event.axis = sdlEvent.caxis.value < 0 ? sdlEvent.caxis.value / 32768.0f : sdlEvent.caxis.value / 32767.0f;
+			break;
+		}
+
+		default:
+			return;
+		}
+
+		if (windowId == 0) {
+			broadcast(event);
+		}
+		else if (DesktopInput *target = findWindow(windowId)) {
+			target->m_input->push(event);
+		}
+	}
+
+	void DesktopInput::broadcast(const InputEvent &event) {
+		for (size_t i = 0; i < s_instances.size(); ++i) {
+			s_instances[i]->m_input->push(event);
+		}
+	}
+
+	DesktopInput *DesktopInput::findWindow(Uint32 windowId) {
+		for (size_t i = 0; i < s_instances.size(); ++i) {
+			if (s_instances[i]->m_windowId == windowId) {
+				return s_instances[i];
+			}
+		}
+		return nullptr;
+	}
+
+	int DesktopInput::findGamepad(SDL_JoystickID instance) {
+		for (uint i = 0; i < InputState::maxGamepads; ++i) {
+			if (s_gamepadIds[i] == instance) {
+				return (int)i;
+			}
+		}
+		return -1;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef __ENCODESKTOP_DESKTOPINPUT_H__
+#define __ENCODESKTOP_DESKTOPINPUT_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include <vector>
+
+namespace enco {
+	// Drains the SDL event queue in batches and translates it into InputEvents.
+	// SDL has one event queue per process, so every pump dispatches to the Input of the window an event belongs to.
+	// Device events without a window (game controllers) go to every open window.
+	class DesktopInput {
+	public:
+		static const int eventBatchSize = 128;
+
+		ENCODESKTOPAPI DesktopInput();
+
+		ENCODESKTOPAPI void open(SDL_Window *window, Input *input);
+		ENCODESKTOPAPI void close();
+
+		// Returns false once SDL_QUIT was received or this window was closed
+		ENCODESKTOPAPI bool pump();
+
+		// Relative mode reads raw device deltas (WM_INPUT on Windows) instead of the accelerated cursor
+		ENCODESKTOPAPI void setRawMouse(bool enabled);
+		inline bool isRawMouse() const { return m_rawMouse; }
+
+	private:
+		static void dispatch(const SDL_Event &event);
+		static void broadcast(const InputEvent &event);
+		static DesktopInput *findWindow(Uint32 windowId);
+		static int findGamepad(SDL_JoystickID instance);
+
+		static std::vector<DesktopInput *> s_instances;
+		static SDL_GameController *s_gamepads[InputState::maxGamepads];
+		static SDL_JoystickID s_gamepadIds[InputState::maxGamepads];
+		static bool s_quit;
+
+		Uint32 m_windowId;
+		Input *m_input;
+		bool m_closed;
+		bool m_rawMouse;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -2,10 +2,14 @@
 #include "DesktopView.h"
 
 namespace enco {
+	uint DesktopView::s_viewCount = 0;
+
 	ENCODESKTOPAPI void DesktopView::create(IRenderer *renderer) {
 		m_renderer = renderer;
 		
-		SDL_Init(SDL_INIT_VIDEO);
+		if (s_viewCount++ == 0) {
+			SDL_Init(SDL_INIT_VIDEO);
+		}
 
 		m_window = SDL_CreateWindow(m_name.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, (int)m_size.x, (int)m_size.y, SDL_WINDOW_SHOWN | renderer->getSDLOptions());
 		if (!m_window) {
@@ -14,6 +18,8 @@ namespace enco {
 		}
 
 		m_renderer->createContext(0, 0, m_size.x, m_size.y, 32, 16, 0, false, m_window);
+
+		m_desktopInput.open(m_window, &m_input);
 	}
 
 	ENCODESKTOPAPI void DesktopView::destroy() {
@@ -21,26 +27,22 @@ namespace enco {
 			m_openGLContext.reset();
 		}*/
 
-		m_renderer->deleteContext();
+		m_desktopInput.close();
 
+		// Without a window create() never made a context, and a null window would release the shared one
 		if (m_window) {
+			m_renderer->deleteContext(m_window);
 			SDL_DestroyWindow(m_window);
 			m_window = nullptr;
 		}
 
-		SDL_Quit();
+		if (--s_viewCount == 0) {
+			SDL_Quit();
+		}
 	}
 
 	ENCODESKTOPAPI bool DesktopView::update(float deltaTime) {
-		SDL_Event event;
-		while (SDL_PollEvent(&event)) {
-			switch (event.type) {
-			case SDL_QUIT:
-				return false;
-			}
-		}
-
-		return true;
+		return m_desktopInput.pump();
 	}
 
 	/*ENCODESKTOPAPI void DesktopView::createOpenGLContext(const OpenGLContextParameters &parameters) {
@@ -7,6 +7,8 @@
 
 #include <EncoShared\EncoShared.h>
 
+#include "DesktopInput.h"
+
 namespace enco {
 	class DesktopView : public IView {
 	public:
@@ -18,12 +20,19 @@ namespace enco {
 
 		ENCODESKTOPAPI virtual bool update(float deltaTime);
 
+		inline virtual SDL_WINDOW getSDLWindow() const { return m_window; }
+
 		ENCODESKTOPAPI virtual void onResize();
 		ENCODESKTOPAPI virtual void onRename();
 
+		inline DesktopInput &getDesktopInput() { return m_desktopInput; }
+
 	private:
+		static uint s_viewCount;
+
 		SDL_Window *m_window;
 		IRenderer *m_renderer;
+		DesktopInput m_desktopInput;
 	};
 }
 
@@ -5,6 +5,8 @@
 
 #include "stdafx.h"
 
+#include "DesktopAudio.h"
+#include "DesktopInput.h"
 #include "DesktopView.h"
 
 #endif
\ No newline at end of file
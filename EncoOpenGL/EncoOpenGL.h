@@ -5,6 +5,20 @@
 
 #include "stdafx.h"
 
+#include "OpenGLRenderTarget.h"
+#include "OpenGLReadback.h"
+#include "OpenGLFrameTimer.h"
+#include "OpenGLStreamBuffer.h"
+#include "OpenGLCapture.h"
+#include "OpenGLShader.h"
+#include "OpenGLClusteredLighting.h"
+#include "OpenGLShadowMap.h"
+#include "OpenGLMesh.h"
+#include "OpenGLSkinning.h"
+#include "OpenGLParticles.h"
+#include "OpenGLDebugDraw.h"
+#include "OpenGLText.h"
+#include "OpenGLSprites.h"
 #include "OpenGLRenderer.h"
 
 #endif
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef __ENCOOPENGL_OPENGLCAPTURE_H__
+#define __ENCOOPENGL_OPENGLCAPTURE_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+// Every GL function a capture can contain: the ones the library calls, plus the ones a snapshot of the state at
+// the start of the frame needs to rebuild it
+#define ENCO_GL_CAPTURE_CALLS(X) \
+	X(ActiveTexture) X(AttachShader) X(BindBuffer) X(BindBufferBase) X(BindBufferRange) X(BindFramebuffer) \
+	X(BindRenderbuffer) X(BindTexture) X(BindVertexArray) X(BindVertexBuffer) X(BlendFunc) X(BlendFuncSeparate) \
+	X(BlitFramebuffer) X(BufferData) X(BufferStorage) X(BufferSubData) X(CheckFramebufferStatus) X(Clear) \
+	X(ClearColor) X(ClearDepth) X(ClientWaitSync) X(CompileShader) X(CopyImageSubData) X(CreateProgram) \
+	X(CreateShader) X(DeleteBuffers) X(DeleteFramebuffers) X(DeleteProgram) X(DeleteQueries) \
+	X(DeleteRenderbuffers) X(DeleteShader) X(DeleteSync) X(DeleteTextures) X(DeleteVertexArrays) X(DepthFunc) \
+	X(DepthMask) X(Disable) X(DrawArrays) X(DrawArraysInstanced) X(DrawArraysInstancedBaseInstance) \
+	X(DrawBuffer) X(DrawBuffers) X(DrawElements) X(DrawElementsInstanced) X(DrawElementsInstancedBaseVertex) \
+	X(DrawElementsInstancedBaseVertexBaseInstance) X(Enable) X(EnableVertexAttribArray) X(FenceSync) \
+	X(FramebufferRenderbuffer) X(FramebufferTexture2D) X(FramebufferTextureLayer) X(GenBuffers) X(GenFramebuffers) \
+	X(GenQueries) X(GenRenderbuffers) X(GenTextures) X(GenVertexArrays) X(GetBooleanv) \
+	X(GetError) X(GetIntegerv) X(GetProgramInfoLog) X(GetProgramiv) X(GetQueryObjectiv) X(GetQueryObjectui64v) \
+	X(GetShaderInfoLog) X(GetShaderiv) X(GetUniformLocation) X(IsEnabled) X(LinkProgram) X(MapBufferRange) \
+	X(MultiDrawElementsIndirect) X(PixelStorei) X(PolygonOffset) X(QueryCounter) X(ReadBuffer) X(ReadPixels) \
+	X(RenderbufferStorageMultisample) X(ShaderSource) X(TexImage2D) X(TexImage3D) X(TexParameteri) \
+	X(TexSubImage2D) X(TexSubImage3D) X(Uniform1f) X(Uniform1fv) X(Uniform1i) X(Uniform1iv) X(Uniform1uiv) \
+	X(Uniform2f) X(Uniform2fv) X(Uniform2iv) X(Uniform2uiv) X(Uniform3fv) X(Uniform3iv) X(Uniform3ui) \
+	X(Uniform3uiv) X(Uniform4fv) X(Uniform4iv) X(Uniform4uiv) X(UniformMatrix2fv) X(UniformMatrix3fv) \
+	X(UniformMatrix4fv) X(UnmapBuffer) X(UseProgram) X(VertexAttribBinding) X(VertexAttribFormat) \
+	X(VertexAttribIFormat) X(VertexAttribIPointer) X(VertexAttribPointer) X(VertexBindingDivisor) X(Viewport)
+
+namespace enco {
+	enum GLCaptureCall : u16 {
+#define ENCO_GL_CAPTURE_ENUM(name) gl##name##Call,
+		ENCO_GL_CAPTURE_CALLS(ENCO_GL_CAPTURE_ENUM)
+#undef ENCO_GL_CAPTURE_ENUM
+		// buffer, offset and the bytes the CPU wrote through a mapping since the last draw
+		mappedWriteCall,
+		// program, location and the name of the uniform, so a replay can look up its own location
+		uniformNameCall,
+		glCaptureCallCount
+	};
+
+	inline const char *getGLCaptureCallName(GLCaptureCall call) {
+		static const char *names[] = {
+#define ENCO_GL_CAPTURE_NAME(name) "gl" #name,
+			ENCO_GL_CAPTURE_CALLS(ENCO_GL_CAPTURE_NAME)
+#undef ENCO_GL_CAPTURE_NAME
+			"mappedWrite",
+			"uniformName"
+		};
+		return call < glCaptureCallCount ? names[call] : "unknown";
+	}
+
+	// A capture holds three lists of calls. Setup creates every object the frame used, with the contents it had
+	// when the frame first used it, reset restores the bindings and state of the start of the frame, and frame
+	// is every call from OpenGLRenderer::beginFrame() to endFrame().
+	enum GLCaptureSection : u8 {
+		glCaptureSetup,
+		glCaptureReset,
+		glCaptureFrame,
+		glCaptureSectionCount
+	};
+
+	// Followed by the sections in order. A call is its GLCaptureCall as u16, the u8 number of arguments, a u8
+	// that is 1 when a blob follows, the arguments as u64 each and the blob as u64 size and bytes. Integers are
+	// stored sign extended, floats and doubles as their bits, offsets into bound buffers as the pointer value.
+	// Calls that return a value (names, syncs, locations, status) store it as an extra last argument.
+	struct GLCaptureFileHeader {
+		char magic[4];
+		u32 version;
+		u32 width;
+		u32 height;
+		u32 callCounts[glCaptureSectionCount];
+		u32 reserved;
+		u64 sectionSizes[glCaptureSectionCount];
+	};
+
+	static const u32 glCaptureFileVersion = 2;
+}
+
+#endif
\ No newline at end of file
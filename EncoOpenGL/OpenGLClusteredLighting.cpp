@@ -0,0 +1,122 @@
+#include "stdafx.h"
+#include "OpenGLClusteredLighting.h"
+
+#include <cstring>
+
+namespace enco {
+	static const char *s_clusteredLightingSource =
+		"struct ClusterLight {\n"
+		"	vec4 positionRange;\n"
+		"	vec4 colorIntensity;\n"
+		"	vec4 directionOuterCone;\n"
+		"	vec4 innerConeType;\n"
+		"};\n"
+		"\n"
+		"layout(std430, binding = 0) readonly buffer ClusterLights { ClusterLight clusterLights[]; };\n"
+		"layout(std430, binding = 1) readonly buffer ClusterRanges { uvec2 clusterRanges[]; };\n"
+		"layout(std430, binding = 2) readonly buffer ClusterLightIndices { uint clusterLightIndices[]; };\n"
+		"\n"
+		"uniform uvec3 u_clusterGrid;\n"
+		"uniform vec2 u_clusterTileSize;\n"
+		"uniform vec2 u_clusterSliceScaleBias;\n"
+		"\n"
+		"uint getClusterIndex(vec2 fragCoord, float viewDepth) {\n"
+		"	float slice = floor(log(max(viewDepth, 1e-4)) * u_clusterSliceScaleBias.x + u_clusterSliceScaleBias.y);\n"
+		"	uint z = uint(clamp(slice, 0.0, float(u_clusterGrid.z - 1u)));\n"
+		"	uvec2 tile = min(uvec2(fragCoord / u_clusterTileSize), u_clusterGrid.xy - 1u);\n"
+		"	return (z * u_clusterGrid.y + tile.y) * u_clusterGrid.x + tile.x;\n"
+		"}\n"
+		"\n"
+		"vec3 computeClusteredLighting(vec3 viewPosition, vec3 viewNormal, vec3 albedo, float shininess, vec2 fragCoord) {\n"
+		"	uvec2 range = clusterRanges[getClusterIndex(fragCoord, -viewPosition.z)];\n"
+		"	vec3 normal = normalize(viewNormal);\n"
+		"	vec3 toEye = normalize(-viewPosition);\n"
+		"	vec3 result = vec3(0.0);\n"
+		"	for (uint i = 0u; i < range.y; ++i) {\n"
+		"		ClusterLight light = clusterLights[clusterLightIndices[range.x + i]];\n"
+		"		vec3 toLight = light.positionRange.xyz - viewPosition;\n"
+		"		float distance = length(toLight);\n"
+		"		if (distance >= light.positionRange.w) {\n"
+		"			continue;\n"
+		"		}\n"
+		"		toLight /= distance;\n"
+		"\n"
+		"		float falloff = distance / light.positionRange.w;\n"
+		"		falloff = clamp(1.0 - falloff * falloff * falloff * falloff, 0.0, 1.0);\n"
+		"		float attenuation = falloff * falloff / (distance * distance + 1.0);\n"
+		"		if (light.innerConeType.y > 0.5) {\n"
+		"			float cosAngle = dot(-toLight, light.directionOuterCone.xyz);\n"
+		"			attenuation *= smoothstep(light.directionOuterCone.w, light.innerConeType.x, cosAngle);\n"
+		"		}\n"
+		"\n"
+		"		float diffuse = max(dot(normal, toLight), 0.0);\n"
+		"		float specular = diffuse > 0.0 ? pow(max(dot(normal, normalize(toLight + toEye)), 0.0), shininess) : 0.0;\n"
+		"		result += (albedo * diffuse + specular) * light.colorIntensity.rgb * light.colorIntensity.a * attenuation;\n"
+		"	}\n"
+		"	return result;\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLClusteredLighting::OpenGLClusteredLighting() : m_offsetAlignment(0), m_tilesX(1), m_tilesY(1), m_slices(1), m_sliceScale(0.0f), m_sliceBias(0.0f), m_lightCount(0), m_indexCount(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLClusteredLighting::~OpenGLClusteredLighting() {
+	}
+
+	ENCOOPENGLAPI bool OpenGLClusteredLighting::upload(const LightClusterGrid &grid, OpenGLStreamBuffer &streamBuffer) {
+		if (!isSupported()) {
+			return false;
+		}
+
+		if (m_offsetAlignment == 0) {
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_offsetAlignment);
+			if (m_offsetAlignment <= 0) {
+				m_offsetAlignment = 256;
+			}
+		}
+
+		m_tilesX = grid.getTilesX();
+		m_tilesY = grid.getTilesY();
+		m_slices = grid.getSlices();
+		m_sliceScale = grid.getSliceScale();
+		m_sliceBias = grid.getSliceBias();
+		m_lightCount = (uint)grid.getLights().size();
+		m_indexCount = (uint)grid.getLightIndices().size();
+
+		bool uploaded = true;
+		uploaded &= bindRange(lightBinding, grid.getLights().empty() ? nullptr : &grid.getLights()[0], m_lightCount * sizeof(LightShaderData), streamBuffer);
+		uploaded &= bindRange(clusterBinding, &grid.getClusters()[0], grid.getClusterCount() * sizeof(LightCluster), streamBuffer);
+		uploaded &= bindRange(indexBinding, grid.getLightIndices().empty() ? nullptr : &grid.getLightIndices()[0], m_indexCount * sizeof(u32), streamBuffer);
+
+		streamBuffer.flush();
+		return uploaded;
+	}
+
+	ENCOOPENGLAPI void OpenGLClusteredLighting::setUniforms(OpenGLShader &shader, uint viewportWidth, uint viewportHeight) const {
+		glUniform3ui(shader.getUniformLocation("u_clusterGrid"), m_tilesX, m_tilesY, m_slices);
+		glUniform2f(shader.getUniformLocation("u_clusterTileSize"), (f32)viewportWidth / m_tilesX, (f32)viewportHeight / m_tilesY);
+		glUniform2f(shader.getUniformLocation("u_clusterSliceScaleBias"), m_sliceScale, m_sliceBias);
+	}
+
+	ENCOOPENGLAPI const char *OpenGLClusteredLighting::getShaderSource() {
+		return s_clusteredLightingSource;
+	}
+
+	ENCOOPENGLAPI bool OpenGLClusteredLighting::isSupported() {
+		return GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object;
+	}
+
+	bool OpenGLClusteredLighting::bindRange(GLuint binding, const void *data, GLsizeiptr size, OpenGLStreamBuffer &streamBuffer) {
+		// Zero sized ranges cannot be bound, an empty list still gets a few bytes
+		GLsizeiptr allocationSize = size > 0 ? size : 16;
+		OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(allocationSize, m_offsetAlignment);
+		if (!allocation.data) {
+			return false;
+		}
+
+		if (size > 0) {
+			memcpy(allocation.data, data, (size_t)size);
+		}
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, streamBuffer.getBuffer(), allocation.offset, allocationSize);
+		return true;
+	}
+}
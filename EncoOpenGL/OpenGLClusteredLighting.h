@@ -0,0 +1,49 @@
+#ifndef __ENCOOPENGL_OPENGLCLUSTEREDLIGHTING_H__
+#define __ENCOOPENGL_OPENGLCLUSTEREDLIGHTING_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+#include "OpenGLStreamBuffer.h"
+
+namespace enco {
+	// Uploads the result of a LightClusterGrid into shader storage buffers (OpenGL 4.3 or ARB_shader_storage_buffer_object).
+	// Shaders prepend getShaderSource() and call computeClusteredLighting() with view space inputs.
+	// Without shader storage buffers upload() returns false and shaders have to light without clusters.
+	class OpenGLClusteredLighting {
+	public:
+		static const GLuint lightBinding = 0;
+		static const GLuint clusterBinding = 1;
+		static const GLuint indexBinding = 2;
+
+		ENCOOPENGLAPI OpenGLClusteredLighting();
+		ENCOOPENGLAPI ~OpenGLClusteredLighting();
+
+		// Copies lights, cluster ranges and indices into this frame's region of the stream buffer and binds them
+		ENCOOPENGLAPI bool upload(const LightClusterGrid &grid, OpenGLStreamBuffer &streamBuffer);
+
+		// viewport is the size of the target the shader renders to
+		ENCOOPENGLAPI void setUniforms(OpenGLShader &shader, uint viewportWidth, uint viewportHeight) const;
+
+		ENCOOPENGLAPI static const char *getShaderSource();
+		// Needs the context current
+		ENCOOPENGLAPI static bool isSupported();
+
+		inline uint getLightCount() const { return m_lightCount; }
+		inline uint getIndexCount() const { return m_indexCount; }
+
+	private:
+		bool bindRange(GLuint binding, const void *data, GLsizeiptr size, OpenGLStreamBuffer &streamBuffer);
+
+		GLint m_offsetAlignment;
+		uint m_tilesX, m_tilesY, m_slices;
+		f32 m_sliceScale, m_sliceBias;
+		uint m_lightCount, m_indexCount;
+	};
+}
+
+#endif
@@ -0,0 +1,165 @@
+#include "stdafx.h"
+#include "OpenGLDebugDraw.h"
+
+#include <cstddef>
+
+namespace enco {
+	static const char *s_lineVertexSource =
+		"#version 430\n"
+		"\n"
+		"layout(location = 0) in vec3 a_position;\n"
+		"layout(location = 1) in vec4 a_color;\n"
+		"\n"
+		"uniform mat4 u_viewProjection;\n"
+		"\n"
+		"out vec4 v_color;\n"
+		"\n"
+		"void main() {\n"
+		"	v_color = a_color;\n"
+		"	gl_Position = u_viewProjection * vec4(a_position, 1.0);\n"
+		"}\n";
+
+	static const char *s_textVertexSource =
+		"#version 430\n"
+		"\n"
+		"layout(location = 0) in vec3 a_anchor;\n"
+		"layout(location = 1) in vec2 a_offset;\n"
+		"layout(location = 2) in vec4 a_color;\n"
+		"\n"
+		"uniform mat4 u_viewProjection;\n"
+		"uniform vec2 u_pixelSize;\n"
+		"\n"
+		"out vec4 v_color;\n"
+		"\n"
+		"void main() {\n"
+		"	v_color = a_color;\n"
+		"	vec4 anchor = u_viewProjection * vec4(a_anchor, 1.0);\n"
+		"	// Labels behind the camera are moved out of the clip volume\n"
+		"	if (anchor.w <= 0.0) {\n"
+		"		gl_Position = vec4(2.0, 2.0, 2.0, 1.0);\n"
+		"		return;\n"
+		"	}\n"
+		"	vec2 position = floor((anchor.xy / anchor.w * 0.5 + 0.5) / u_pixelSize + 0.5) + a_offset;\n"
+		"	gl_Position = vec4((position * u_pixelSize) * 2.0 - 1.0, 0.0, 1.0);\n"
+		"}\n";
+
+	static const char *s_fragmentSource =
+		"#version 430\n"
+		"\n"
+		"in vec4 v_color;\n"
+		"out vec4 f_color;\n"
+		"\n"
+		"void main() {\n"
+		"	f_color = v_color;\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLDebugDraw::OpenGLDebugDraw() : m_lineVertexArray(0), m_textVertexArray(0), m_droppedVertices(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLDebugDraw::~OpenGLDebugDraw() {
+	}
+
+	ENCOOPENGLAPI void OpenGLDebugDraw::release() {
+		m_lineShader.release();
+		m_textShader.release();
+		if (m_lineVertexArray) {
+			glDeleteVertexArrays(1, &m_lineVertexArray);
+		}
+		if (m_textVertexArray) {
+			glDeleteVertexArrays(1, &m_textVertexArray);
+		}
+		m_lineVertexArray = m_textVertexArray = 0;
+	}
+
+	ENCOOPENGLAPI bool OpenGLDebugDraw::draw(const DebugDraw &debugDraw, const glm::mat4 &viewProjection, uint viewportWidth, uint viewportHeight, OpenGLStreamBuffer &streamBuffer) {
+		uint lineCount = debugDraw.getLineVertexCount();
+		uint textCount = debugDraw.getTextVertexCount();
+		if (lineCount == 0 && textCount == 0) {
+			return true;
+		}
+		if (!m_lineVertexArray && !initialize()) {
+			return false;
+		}
+
+		OpenGLStreamBuffer::Allocation lines, text;
+		if (lineCount > 0) {
+			lines = streamBuffer.allocate(lineCount * sizeof(DebugVertex), sizeof(DebugVertex));
+		}
+		if (textCount > 0) {
+			text = streamBuffer.allocate(textCount * sizeof(DebugTextVertex), sizeof(DebugTextVertex));
+		}
+		if (!lines.data && !text.data) {
+			m_droppedVertices += lineCount + textCount;
+			return false;
+		}
+
+		// A primitive type that does not fit is skipped as a whole
+		if (!lines.data) {
+			m_droppedVertices += lineCount;
+			lineCount = 0;
+		}
+		if (!text.data) {
+			m_droppedVertices += textCount;
+			textCount = 0;
+		}
+		debugDraw.gather((DebugVertex *)lines.data, (DebugTextVertex *)text.data);
+		streamBuffer.flush();
+
+		if (lineCount > 0) {
+			m_lineShader.bind();
+			glUniformMatrix4fv(m_lineShader.getUniformLocation("u_viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+			glBindVertexArray(m_lineVertexArray);
+			glBindVertexBuffer(0, streamBuffer.getBuffer(), lines.offset, sizeof(DebugVertex));
+			glDrawArrays(GL_LINES, 0, (GLsizei)lineCount);
+		}
+
+		if (textCount > 0) {
+			GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+			glDisable(GL_DEPTH_TEST);
+
+			m_textShader.bind();
+			glUniformMatrix4fv(m_textShader.getUniformLocation("u_viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+			glUniform2f(m_textShader.getUniformLocation("u_pixelSize"), 1.0f / (viewportWidth ? viewportWidth : 1), 1.0f / (viewportHeight ? viewportHeight : 1));
+			glBindVertexArray(m_textVertexArray);
+			glBindVertexBuffer(0, streamBuffer.getBuffer(), text.offset, sizeof(DebugTextVertex));
+			glDrawArrays(GL_TRIANGLES, 0, (GLsizei)textCount);
+
+			if (depthTest) {
+				glEnable(GL_DEPTH_TEST);
+			}
+		}
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	bool OpenGLDebugDraw::initialize() {
+		if (!m_lineShader.create(s_lineVertexSource, s_fragmentSource) || !m_textShader.create(s_textVertexSource, s_fragmentSource)) {
+			return false;
+		}
+
+		glGenVertexArrays(1, &m_lineVertexArray);
+		glBindVertexArray(m_lineVertexArray);
+		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(DebugVertex, position));
+		glVertexAttribBinding(0, 0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribFormat(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(DebugVertex, color));
+		glVertexAttribBinding(1, 0);
+
+		glGenVertexArrays(1, &m_textVertexArray);
+		glBindVertexArray(m_textVertexArray);
+		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(DebugTextVertex, anchor));
+		glVertexAttribBinding(0, 0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(DebugTextVertex, offset));
+		glVertexAttribBinding(1, 0);
+		glEnableVertexAttribArray(2);
+		glVertexAttribFormat(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(DebugTextVertex, color));
+		glVertexAttribBinding(2, 0);
+
+		glBindVertexArray(0);
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#ifndef __ENCOOPENGL_OPENGLDEBUGDRAW_H__
+#define __ENCOOPENGL_OPENGLDEBUGDRAW_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+#include "OpenGLStreamBuffer.h"
+
+namespace enco {
+	// Gathers the per-thread buffers of a DebugDraw straight into the stream buffer and draws them
+	// with one call for all lines and one for all text
+	class OpenGLDebugDraw {
+	public:
+		ENCOOPENGLAPI OpenGLDebugDraw();
+		ENCOOPENGLAPI ~OpenGLDebugDraw();
+
+		ENCOOPENGLAPI void release();
+
+		// Lines are depth tested against the bound target when depth testing is enabled, text is always on top
+		ENCOOPENGLAPI bool draw(const DebugDraw &debugDraw, const glm::mat4 &viewProjection, uint viewportWidth, uint viewportHeight, OpenGLStreamBuffer &streamBuffer);
+
+		// Vertices that did not fit into the stream buffer
+		inline u64 getDroppedVertexCount() const { return m_droppedVertices; }
+
+	private:
+		OpenGLDebugDraw(const OpenGLDebugDraw &) = delete;
+		OpenGLDebugDraw &operator=(const OpenGLDebugDraw &) = delete;
+
+		bool initialize();
+
+		OpenGLShader m_lineShader;
+		OpenGLShader m_textShader;
+		GLuint m_lineVertexArray;
+		GLuint m_textVertexArray;
+		u64 m_droppedVertices;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "stdafx.h"
+#include "OpenGLFrameTimer.h"
+
+namespace enco {
+	ENCOOPENGLAPI OpenGLFrameTimer::OpenGLFrameTimer() : m_next(0), m_frameTime(0.0f) {
+		for (uint i = 0; i < ringSize; ++i) {
+			m_queries[i][0] = m_queries[i][1] = 0;
+			m_pending[i] = false;
+		}
+	}
+
+	ENCOOPENGLAPI OpenGLFrameTimer::~OpenGLFrameTimer() {
+	}
+
+	ENCOOPENGLAPI void OpenGLFrameTimer::beginFrame() {
+		// Oldest first, so the time reported is always the one of the latest finished frame
+		for (uint i = 0; i < ringSize; ++i) {
+			uint slot = (m_next + i) % ringSize;
+			if (!m_pending[slot]) {
+				continue;
+			}
+
+			GLint available = 0;
+			glGetQueryObjectiv(m_queries[slot][1], GL_QUERY_RESULT_AVAILABLE, &available);
+			if (!available) {
+				break;
+			}
+
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(m_queries[slot][0], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(m_queries[slot][1], GL_QUERY_RESULT, &end);
+			m_frameTime = (f32)((f64)(end - begin) * 1e-6);
+			m_pending[slot] = false;
+		}
+
+		// The ring is full of frames the GPU has not finished, this one goes unmeasured
+		if (m_pending[m_next]) {
+			return;
+		}
+		if (!m_queries[m_next][0]) {
+			glGenQueries(2, m_queries[m_next]);
+		}
+		glQueryCounter(m_queries[m_next][0], GL_TIMESTAMP);
+	}
+
+	ENCOOPENGLAPI void OpenGLFrameTimer::endFrame() {
+		if (!m_pending[m_next] && m_queries[m_next][0]) {
+			glQueryCounter(m_queries[m_next][1], GL_TIMESTAMP);
+			m_pending[m_next] = true;
+			m_next = (m_next + 1) % ringSize;
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLFrameTimer::release() {
+		for (uint i = 0; i < ringSize; ++i) {
+			if (m_queries[i][0]) {
+				glDeleteQueries(2, m_queries[i]);
+				m_queries[i][0] = m_queries[i][1] = 0;
+			}
+			m_pending[i] = false;
+		}
+		m_next = 0;
+		m_frameTime = 0.0f;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#ifndef __ENCOOPENGL_OPENGLFRAMETIMER_H__
+#define __ENCOOPENGL_OPENGLFRAMETIMER_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+namespace enco {
+	// Measures the GPU time of whole frames with timestamp queries. The results of frame N are read in a later
+	// frame once they are available, so measuring never waits for the GPU.
+	class OpenGLFrameTimer {
+	public:
+		static const uint ringSize = 4;
+
+		ENCOOPENGLAPI OpenGLFrameTimer();
+		ENCOOPENGLAPI ~OpenGLFrameTimer();
+
+		ENCOOPENGLAPI void beginFrame();
+		ENCOOPENGLAPI void endFrame();
+
+		ENCOOPENGLAPI void release();
+
+		// Milliseconds of the latest frame whose queries finished
+		inline f32 getFrameTime() const { return m_frameTime; }
+
+	private:
+		OpenGLFrameTimer(const OpenGLFrameTimer &) = delete;
+		OpenGLFrameTimer &operator=(const OpenGLFrameTimer &) = delete;
+
+		// A begin and an end timestamp per frame in flight
+		GLuint m_queries[ringSize][2];
+		bool m_pending[ringSize];
+		uint m_next;
+		f32 m_frameTime;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,117 @@
+#include "stdafx.h"
+#include "OpenGLMemory.h"
+#include "OpenGLTrace.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const uint maxTextureLevels = 16;
+		const uint cubeFaces = 6;
+	}
+
+	std::unordered_map<GLuint, i64> OpenGLMemory::s_buffers;
+	std::unordered_map<GLuint, std::vector<i64>> OpenGLMemory::s_textures;
+	std::unordered_map<GLuint, i64> OpenGLMemory::s_renderbuffers;
+
+	ENCOOPENGLAPI void OpenGLMemory::setBufferSize(GLenum target, GLsizeiptr size) {
+		GLuint buffer = OpenGLTrace::getBoundBuffer(target);
+		if (buffer == 0) {
+			return;
+		}
+
+		i64 &current = s_buffers[buffer];
+		MemoryTracker::add(gpuBufferMemory, (i64)size - current);
+		current = (i64)size;
+	}
+
+	ENCOOPENGLAPI void OpenGLMemory::setTextureImage(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth) {
+		GLuint texture = OpenGLTrace::getBoundTexture(target);
+		if (texture == 0 || level < 0 || (uint)level >= maxTextureLevels) {
+			return;
+		}
+
+		uint face = target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z ? target - GL_TEXTURE_CUBE_MAP_POSITIVE_X : 0;
+		std::vector<i64> &images = s_textures[texture];
+		if (images.empty()) {
+			images.resize(cubeFaces * maxTextureLevels, 0);
+		}
+
+		i64 size = (i64)std::max(width, 0) * std::max(height, 0) * std::max(depth, 0) * getTexelSize((GLenum)internalFormat);
+		i64 &current = images[face * maxTextureLevels + level];
+		MemoryTracker::add(gpuTextureMemory, size - current);
+		current = size;
+	}
+
+	ENCOOPENGLAPI void OpenGLMemory::setRenderbufferStorage(GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height) {
+		GLint renderbuffer = 0;
+		::glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+		if (renderbuffer == 0) {
+			return;
+		}
+
+		i64 size = (i64)std::max(width, 0) * std::max(height, 0) * std::max(samples, 1) * getTexelSize(internalFormat);
+		i64 &current = s_renderbuffers[(GLuint)renderbuffer];
+		MemoryTracker::add(gpuTextureMemory, size - current);
+		current = size;
+	}
+
+	ENCOOPENGLAPI void OpenGLMemory::removeBuffers(GLsizei count, const GLuint *buffers) {
+		remove(s_buffers, gpuBufferMemory, count, buffers);
+	}
+
+	ENCOOPENGLAPI void OpenGLMemory::removeTextures(GLsizei count, const GLuint *textures) {
+		for (GLsizei i = 0; i < count; ++i) {
+			std::unordered_map<GLuint, std::vector<i64>>::iterator texture = s_textures.find(textures[i]);
+			if (texture == s_textures.end()) {
+				continue;
+			}
+
+			i64 size = 0;
+			for (size_t j = 0; j < texture->second.size(); ++j) {
+				size += texture->second[j];
+			}
+			MemoryTracker::add(gpuTextureMemory, -size);
+			s_textures.erase(texture);
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLMemory::removeRenderbuffers(GLsizei count, const GLuint *renderbuffers) {
+		remove(s_renderbuffers, gpuTextureMemory, count, renderbuffers);
+	}
+
+	ENCOOPENGLAPI uint OpenGLMemory::getTexelSize(GLenum internalFormat) {
+		switch (internalFormat) {
+		case GL_R8: case GL_R8I: case GL_R8UI: case GL_R8_SNORM: case GL_STENCIL_INDEX8:
+			return 1;
+		case GL_R16: case GL_R16F: case GL_R16I: case GL_R16UI: case GL_RG8: case GL_RG8I: case GL_RG8UI:
+		case GL_DEPTH_COMPONENT16: case GL_RGB565:
+			return 2;
+		// Drivers store 24 bit depth and 8 bit RGB in 32 bits
+		case GL_RGB8: case GL_SRGB8: case GL_RGBA8: case GL_SRGB8_ALPHA8: case GL_RGBA8I: case GL_RGBA8UI: case GL_RGB10_A2:
+		case GL_R11F_G11F_B10F: case GL_RGB9_E5: case GL_RG16: case GL_RG16F: case GL_RG16I: case GL_RG16UI:
+		case GL_R32F: case GL_R32I: case GL_R32UI: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32: case GL_DEPTH_COMPONENT32F:
+		case GL_DEPTH24_STENCIL8: case GL_DEPTH_COMPONENT: case GL_RGBA: case GL_RGB:
+			return 4;
+		case GL_DEPTH32F_STENCIL8: case GL_RGBA16: case GL_RGBA16F: case GL_RGBA16I: case GL_RGBA16UI: case GL_RGB16F:
+		case GL_RG32F: case GL_RG32I: case GL_RG32UI:
+			return 8;
+		case GL_RGB32F: case GL_RGB32I: case GL_RGB32UI:
+			return 12;
+		case GL_RGBA32F: case GL_RGBA32I: case GL_RGBA32UI:
+			return 16;
+		default:
+			return 4;
+		}
+	}
+
+	void OpenGLMemory::remove(std::unordered_map<GLuint, i64> &sizes, MemoryTag tag, GLsizei count, const GLuint *names) {
+		for (GLsizei i = 0; i < count; ++i) {
+			std::unordered_map<GLuint, i64>::iterator object = sizes.find(names[i]);
+			if (object != sizes.end()) {
+				MemoryTracker::add(tag, -object->second);
+				sizes.erase(object);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#ifndef __ENCOOPENGL_OPENGLMEMORY_H__
+#define __ENCOOPENGL_OPENGLMEMORY_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	// Counts the GPU memory of the buffers, textures and renderbuffers of the library under gpuBufferMemory and
+	// gpuTextureMemory of MemoryTracker. The GL functions of OpenGLTrace.h report every call that gives an object
+	// storage or deletes it, the size is what the object needs at its internal format, before driver padding.
+	class OpenGLMemory {
+	public:
+		// The object is the one bound to target, call after the GL call
+		ENCOOPENGLAPI static void setBufferSize(GLenum target, GLsizeiptr size);
+		ENCOOPENGLAPI static void setTextureImage(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth);
+		ENCOOPENGLAPI static void setRenderbufferStorage(GLsizei samples, GLenum internalFormat, GLsizei width, GLsizei height);
+
+		// Call before the GL call
+		ENCOOPENGLAPI static void removeBuffers(GLsizei count, const GLuint *buffers);
+		ENCOOPENGLAPI static void removeTextures(GLsizei count, const GLuint *textures);
+		ENCOOPENGLAPI static void removeRenderbuffers(GLsizei count, const GLuint *renderbuffers);
+
+		// Bytes of a texel of an internal format, 4 for formats it does not know
+		ENCOOPENGLAPI static uint getTexelSize(GLenum internalFormat);
+
+	private:
+		OpenGLMemory() = delete;
+
+		static void remove(std::unordered_map<GLuint, i64> &sizes, MemoryTag tag, GLsizei count, const GLuint *names);
+
+		static std::unordered_map<GLuint, i64> s_buffers;
+		// Every face and level of a texture has its own image, by face * maxTextureLevels + level
+		static std::unordered_map<GLuint, std::vector<i64>> s_textures;
+		static std::unordered_map<GLuint, i64> s_renderbuffers;
+	};
+}
+
+#endif
\ No newline at end of file
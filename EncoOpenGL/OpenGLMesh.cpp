@@ -0,0 +1,130 @@
+#include "stdafx.h"
+#include "OpenGLMesh.h"
+
+#include <cstddef>
+
+namespace enco {
+	static const char *s_ditherSource =
+		"uniform float u_lodFade;\n"
+		"\n"
+		"void lodDither(float fade) {\n"
+		"	const float bayer[16] = float[16](0.0, 8.0, 2.0, 10.0, 12.0, 4.0, 14.0, 6.0, 3.0, 11.0, 1.0, 9.0, 15.0, 7.0, 13.0, 5.0);\n"
+		"	ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;\n"
+		"	float threshold = (bayer[pixel.y * 4 + pixel.x] + 0.5) / 16.0;\n"
+		"	// Positive fades keep the pixels below the threshold, negative ones exactly the others\n"
+		"	if (fade >= 0.0 ? threshold > fade : threshold <= -fade) {\n"
+		"		discard;\n"
+		"	}\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLMesh::OpenGLMesh() : m_vertexArray(0), m_vertexBuffer(0), m_indexBuffer(0), m_skinBuffer(0), m_vertexCount(0), m_byteSize(0), m_lodCount(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLMesh::~OpenGLMesh() {
+	}
+
+	ENCOOPENGLAPI bool OpenGLMesh::create(const MeshData &mesh) {
+		release();
+		if (mesh.vertices.empty() || mesh.indices.empty()) {
+			return false;
+		}
+
+		glGenVertexArrays(1, &m_vertexArray);
+		glBindVertexArray(m_vertexArray);
+
+		glGenBuffers(1, &m_vertexBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(MeshVertex), &mesh.vertices[0], GL_STATIC_DRAW);
+
+		glGenBuffers(1, &m_indexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(u32), &mesh.indices[0], GL_STATIC_DRAW);
+
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void *)offsetof(MeshVertex, position));
+		glEnableVertexAttribArray(1);
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void *)offsetof(MeshVertex, normal));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void *)offsetof(MeshVertex, texCoord));
+
+		m_byteSize = (GLsizeiptr)(mesh.vertices.size() * sizeof(MeshVertex) + mesh.indices.size() * sizeof(u32));
+		if (mesh.isSkinned()) {
+			glGenBuffers(1, &m_skinBuffer);
+			glBindBuffer(GL_ARRAY_BUFFER, m_skinBuffer);
+			glBufferData(GL_ARRAY_BUFFER, mesh.skinWeights.size() * sizeof(SkinWeights), &mesh.skinWeights[0], GL_STATIC_DRAW);
+
+			glEnableVertexAttribArray(jointsLocation);
+			glVertexAttribIPointer(jointsLocation, 4, GL_UNSIGNED_BYTE, sizeof(SkinWeights), (const void *)offsetof(SkinWeights, joints));
+			glEnableVertexAttribArray(weightsLocation);
+			glVertexAttribPointer(weightsLocation, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(SkinWeights), (const void *)offsetof(SkinWeights, weights));
+			m_byteSize += (GLsizeiptr)(mesh.skinWeights.size() * sizeof(SkinWeights));
+		}
+
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		m_vertexCount = (uint)mesh.vertices.size();
+		m_lodCount = mesh.getLodCount();
+		for (uint i = 0; i < m_lodCount; ++i) {
+			m_lods[i] = mesh.getLod(i);
+		}
+		return true;
+	}
+
+	ENCOOPENGLAPI void OpenGLMesh::release() {
+		if (m_vertexArray) {
+			glDeleteVertexArrays(1, &m_vertexArray);
+		}
+		if (m_vertexBuffer) {
+			glDeleteBuffers(1, &m_vertexBuffer);
+		}
+		if (m_indexBuffer) {
+			glDeleteBuffers(1, &m_indexBuffer);
+		}
+		if (m_skinBuffer) {
+			glDeleteBuffers(1, &m_skinBuffer);
+		}
+		m_vertexArray = m_vertexBuffer = m_indexBuffer = m_skinBuffer = 0;
+		m_vertexCount = 0;
+		m_byteSize = 0;
+		m_lodCount = 0;
+	}
+
+	ENCOOPENGLAPI void OpenGLMesh::draw(uint lod) const {
+		if (!m_vertexArray) {
+			return;
+		}
+
+		const MeshLod &range = m_lods[lod < m_lodCount ? lod : m_lodCount - 1];
+		glBindVertexArray(m_vertexArray);
+		glDrawElements(GL_TRIANGLES, (GLsizei)range.indexCount, GL_UNSIGNED_INT, (const void *)(range.indexOffset * sizeof(u32)));
+	}
+
+	ENCOOPENGLAPI void OpenGLMesh::draw(uint lod, uint instanceCount) const {
+		if (!m_vertexArray || instanceCount == 0) {
+			return;
+		}
+
+		const MeshLod &range = getLod(lod);
+		glBindVertexArray(m_vertexArray);
+		glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)range.indexCount, GL_UNSIGNED_INT, (const void *)(range.indexOffset * sizeof(u32)), (GLsizei)instanceCount);
+	}
+
+	ENCOOPENGLAPI void OpenGLMesh::draw(const LodInstance &instance, OpenGLShader &shader) const {
+		GLint fadeLocation = shader.getUniformLocation("u_lodFade");
+		if (instance.fade >= 1.0f || instance.lod == instance.previousLod) {
+			glUniform1f(fadeLocation, 1.0f);
+			draw(instance.lod);
+			return;
+		}
+
+		glUniform1f(fadeLocation, instance.fade);
+		draw(instance.lod);
+		glUniform1f(fadeLocation, -instance.fade);
+		draw(instance.previousLod);
+	}
+
+	ENCOOPENGLAPI const char *OpenGLMesh::getDitherShaderSource() {
+		return s_ditherSource;
+	}
+}
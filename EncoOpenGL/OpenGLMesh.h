@@ -0,0 +1,60 @@
+#ifndef __ENCOOPENGL_OPENGLMESH_H__
+#define __ENCOOPENGL_OPENGLMESH_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+
+namespace enco {
+	// Vertex and index buffer of a MeshData with all its lods. Attribute locations: 0 position, 1 normal, 2 texCoord,
+	// and for skinned meshes 3 joint indices (uvec4) and 4 joint weights (vec4).
+	class OpenGLMesh {
+	public:
+		static const GLuint jointsLocation = 3;
+		static const GLuint weightsLocation = 4;
+
+		ENCOOPENGLAPI OpenGLMesh();
+		ENCOOPENGLAPI ~OpenGLMesh();
+
+		ENCOOPENGLAPI bool create(const MeshData &mesh);
+		ENCOOPENGLAPI void release();
+
+		ENCOOPENGLAPI void draw(uint lod) const;
+		ENCOOPENGLAPI void draw(uint lod, uint instanceCount) const;
+
+		// Draws both levels of a cross-fading instance, the shader has to call lodDither(u_lodFade)
+		ENCOOPENGLAPI void draw(const LodInstance &instance, OpenGLShader &shader) const;
+
+		// Defines u_lodFade and lodDither(), which discards fragments in a 4x4 ordered dither pattern
+		ENCOOPENGLAPI static const char *getDitherShaderSource();
+
+		inline GLuint getVertexArray() const { return m_vertexArray; }
+		inline GLuint getVertexBuffer() const { return m_vertexBuffer; }
+		inline GLuint getIndexBuffer() const { return m_indexBuffer; }
+		inline GLuint getSkinBuffer() const { return m_skinBuffer; }
+		inline bool isSkinned() const { return m_skinBuffer != 0; }
+		inline uint getVertexCount() const { return m_vertexCount; }
+		inline uint getLodCount() const { return m_lodCount; }
+		inline const MeshLod &getLod(uint lod) const { return m_lods[lod < m_lodCount ? lod : m_lodCount - 1]; }
+		inline GLsizeiptr getByteSize() const { return m_byteSize; }
+
+	private:
+		OpenGLMesh(const OpenGLMesh &) = delete;
+		OpenGLMesh &operator=(const OpenGLMesh &) = delete;
+
+		GLuint m_vertexArray;
+		GLuint m_vertexBuffer;
+		GLuint m_indexBuffer;
+		GLuint m_skinBuffer;
+		uint m_vertexCount;
+		GLsizeiptr m_byteSize;
+		MeshLod m_lods[MeshData::maxLods];
+		uint m_lodCount;
+	};
+}
+
+#endif
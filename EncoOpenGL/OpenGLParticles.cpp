@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "OpenGLParticles.h"
+
+#include <algorithm>
+
+namespace enco {
+	static const char *s_particleVertexSource =
+		"#version 430\n"
+		"\n"
+		"layout(location = 0) in float a_positionX;\n"
+		"layout(location = 1) in float a_positionY;\n"
+		"layout(location = 2) in float a_positionZ;\n"
+		"layout(location = 3) in float a_life;\n"
+		"\n"
+		"uniform mat4 u_view;\n"
+		"uniform mat4 u_projection;\n"
+		"uniform vec2 u_size;\n"
+		"uniform vec4 u_startColor;\n"
+		"uniform vec4 u_endColor;\n"
+		"\n"
+		"out vec4 v_color;\n"
+		"out vec2 v_corner;\n"
+		"\n"
+		"void main() {\n"
+		"	const vec2 corners[4] = vec2[4](vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(-1.0, 1.0), vec2(1.0, 1.0));\n"
+		"	v_corner = corners[gl_VertexID];\n"
+		"	v_color = mix(u_startColor, u_endColor, a_life);\n"
+		"\n"
+		"	// Expanding in view space keeps the quads facing the camera\n"
+		"	vec4 viewPosition = u_view * vec4(a_positionX, a_positionY, a_positionZ, 1.0);\n"
+		"	viewPosition.xy += v_corner * mix(u_size.x, u_size.y, a_life) * 0.5;\n"
+		"	gl_Position = u_projection * viewPosition;\n"
+		"}\n";
+
+	static const char *s_particleFragmentSource =
+		"#version 430\n"
+		"\n"
+		"in vec4 v_color;\n"
+		"in vec2 v_corner;\n"
+		"\n"
+		"out vec4 f_color;\n"
+		"\n"
+		"void main() {\n"
+		"	float distance = dot(v_corner, v_corner);\n"
+		"	if (distance > 1.0) {\n"
+		"		discard;\n"
+		"	}\n"
+		"	f_color = vec4(v_color.rgb, v_color.a * (1.0 - distance));\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLParticles::OpenGLParticles() : m_vertexArray(0), m_buffer(0), m_bufferSize(0), m_drawnParticles(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLParticles::~OpenGLParticles() {
+	}
+
+	ENCOOPENGLAPI void OpenGLParticles::release() {
+		m_shader.release();
+		if (m_vertexArray) {
+			glDeleteVertexArrays(1, &m_vertexArray);
+		}
+		if (m_buffer) {
+			glDeleteBuffers(1, &m_buffer);
+		}
+		m_vertexArray = m_buffer = 0;
+		m_bufferSize = 0;
+	}
+
+	ENCOOPENGLAPI bool OpenGLParticles::draw(const ParticleEmitter &emitter, const glm::mat4 &view, const glm::mat4 &projection) {
+		uint count = emitter.getCount();
+		if (count == 0) {
+			return true;
+		}
+		if (!m_vertexArray && !initialize()) {
+			return false;
+		}
+
+		// Orphaning lets the driver hand out fresh storage while earlier draws still read the old one
+		GLsizeiptr streamSize = (GLsizeiptr)count * sizeof(f32);
+		glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		m_bufferSize = std::max(m_bufferSize, streamSize * 4);
+		glBufferData(GL_ARRAY_BUFFER, m_bufferSize, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, streamSize, emitter.getPositionsX());
+		glBufferSubData(GL_ARRAY_BUFFER, streamSize, streamSize, emitter.getPositionsY());
+		glBufferSubData(GL_ARRAY_BUFFER, streamSize * 2, streamSize, emitter.getPositionsZ());
+		glBufferSubData(GL_ARRAY_BUFFER, streamSize * 3, streamSize, emitter.getLife());
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glBindVertexArray(m_vertexArray);
+		for (GLuint i = 0; i < 4; ++i) {
+			glBindVertexBuffer(i, m_buffer, streamSize * i, sizeof(f32));
+		}
+
+		const ParticleEmitterSettings &settings = emitter.getSettings();
+		m_shader.bind();
+		glUniformMatrix4fv(m_shader.getUniformLocation("u_view"), 1, GL_FALSE, &view[0][0]);
+		glUniformMatrix4fv(m_shader.getUniformLocation("u_projection"), 1, GL_FALSE, &projection[0][0]);
+		glUniform2f(m_shader.getUniformLocation("u_size"), settings.startSize, settings.endSize);
+		glUniform4fv(m_shader.getUniformLocation("u_startColor"), 1, &settings.startColor[0]);
+		glUniform4fv(m_shader.getUniformLocation("u_endColor"), 1, &settings.endColor[0]);
+
+		GLboolean blend = glIsEnabled(GL_BLEND);
+		GLboolean depthMask;
+		glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDepthMask(GL_FALSE);
+
+		glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)count);
+		m_drawnParticles += count;
+
+		glDepthMask(depthMask);
+		if (!blend) {
+			glDisable(GL_BLEND);
+		}
+		glBindVertexArray(0);
+		return true;
+	}
+
+	bool OpenGLParticles::initialize() {
+		if (!m_shader.create(s_particleVertexSource, s_particleFragmentSource)) {
+			return false;
+		}
+
+		glGenBuffers(1, &m_buffer);
+		glGenVertexArrays(1, &m_vertexArray);
+		glBindVertexArray(m_vertexArray);
+		for (GLuint i = 0; i < 4; ++i) {
+			glEnableVertexAttribArray(i);
+			glVertexAttribFormat(i, 1, GL_FLOAT, GL_FALSE, 0);
+			glVertexAttribBinding(i, i);
+			glVertexBindingDivisor(i, 1);
+		}
+		glBindVertexArray(0);
+		return true;
+	}
+}
\ No newline at end of file
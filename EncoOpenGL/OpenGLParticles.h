@@ -0,0 +1,41 @@
+#ifndef __ENCOOPENGL_OPENGLPARTICLES_H__
+#define __ENCOOPENGL_OPENGLPARTICLES_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+
+namespace enco {
+	// Draws all particles of an emitter as camera facing quads with one instanced draw. The position and life
+	// arrays are uploaded as they are, one instanced attribute each, so nothing is interleaved on the CPU.
+	class OpenGLParticles {
+	public:
+		ENCOOPENGLAPI OpenGLParticles();
+		ENCOOPENGLAPI ~OpenGLParticles();
+
+		ENCOOPENGLAPI void release();
+
+		// Alpha blended without depth writes, the blend and depth state is restored afterwards
+		ENCOOPENGLAPI bool draw(const ParticleEmitter &emitter, const glm::mat4 &view, const glm::mat4 &projection);
+
+		inline u64 getDrawnParticleCount() const { return m_drawnParticles; }
+
+	private:
+		OpenGLParticles(const OpenGLParticles &) = delete;
+		OpenGLParticles &operator=(const OpenGLParticles &) = delete;
+
+		bool initialize();
+
+		OpenGLShader m_shader;
+		GLuint m_vertexArray;
+		GLuint m_buffer;
+		GLsizeiptr m_bufferSize;
+		u64 m_drawnParticles;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,114 @@
+#include "stdafx.h"
+#include "OpenGLReadback.h"
+#include "OpenGLTrace.h"
+
+namespace enco {
+	ENCOOPENGLAPI OpenGLReadback::OpenGLReadback() : m_next(0), m_pendingCount(0), m_stalls(0) {
+		for (uint i = 0; i < ringSize; ++i) {
+			m_slots[i].buffer = 0;
+			m_slots[i].capacity = 0;
+			m_slots[i].size = 0;
+			m_slots[i].fence = nullptr;
+			m_slots[i].width = m_slots[i].height = 0;
+			m_slots[i].frame = 0;
+		}
+	}
+
+	ENCOOPENGLAPI OpenGLReadback::~OpenGLReadback() {
+	}
+
+	ENCOOPENGLAPI void OpenGLReadback::request(GLuint framebuffer, uint width, uint height, u64 frame, ReadbackCallback callback, GLenum format, GLenum type) {
+		Slot &slot = m_slots[m_next];
+		if (slot.fence) {
+			// The ring is full, this is the only place that ever waits for the GPU. Without a timeout deliver() only
+			// returns once the slot is free again, a failed wait drops the readback.
+			++m_stalls;
+			deliver(slot, GL_TIMEOUT_IGNORED);
+		}
+
+		GLsizeiptr size = (GLsizeiptr)width * height * OpenGLTrace::getPixelSize(format, type);
+		if (!slot.buffer) {
+			glGenBuffers(1, &slot.buffer);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		if (slot.capacity < size) {
+			glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+			slot.capacity = size;
+		}
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glReadBuffer(framebuffer ? GL_COLOR_ATTACHMENT0 : GL_BACK);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, format, type, nullptr);
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.width = width;
+		slot.height = height;
+		slot.size = size;
+		slot.frame = frame;
+		slot.callback = callback;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		m_next = (m_next + 1) % ringSize;
+		++m_pendingCount;
+	}
+
+	ENCOOPENGLAPI void OpenGLReadback::poll(bool wait) {
+		// Deliver oldest first and stop at the first unfinished one so callbacks arrive in frame order
+		for (uint i = 0; i < ringSize && m_pendingCount > 0; ++i) {
+			Slot &slot = m_slots[(m_next + i) % ringSize];
+			if (slot.fence && !deliver(slot, wait ? GL_TIMEOUT_IGNORED : 0)) {
+				break;
+			}
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLReadback::release() {
+		for (uint i = 0; i < ringSize; ++i) {
+			Slot &slot = m_slots[i];
+			if (slot.fence) {
+				glDeleteSync(slot.fence);
+				slot.fence = nullptr;
+			}
+			if (slot.buffer) {
+				glDeleteBuffers(1, &slot.buffer);
+				slot.buffer = 0;
+			}
+			slot.capacity = 0;
+			slot.callback = nullptr;
+		}
+		m_pendingCount = 0;
+	}
+
+	bool OpenGLReadback::deliver(Slot &slot, GLuint64 timeout) {
+		GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+		if (status == GL_TIMEOUT_EXPIRED) {
+			return false;
+		}
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+		--m_pendingCount;
+
+		// The fence can never signal, e.g. after a lost context, so the data is dropped instead of waiting forever
+		if (status == GL_WAIT_FAILED) {
+#ifdef _DEBUG
+			printf("OpenGL Error: Waiting for the readback of frame %llu failed\n", slot.frame);
+#endif
+			slot.callback = nullptr;
+			return true;
+		}
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+		const u8 *pixels = (const u8 *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, slot.size, GL_MAP_READ_BIT);
+		if (pixels) {
+			slot.callback(pixels, slot.width, slot.height, slot.frame);
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		slot.callback = nullptr;
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef __ENCOOPENGL_OPENGLREADBACK_H__
+#define __ENCOOPENGL_OPENGLREADBACK_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+namespace enco {
+	// Asynchronous framebuffer readback through a ring of pixel buffer objects.
+	// glReadPixels into a bound PBO returns immediately, a fence tells when the copy landed. With three
+	// buffers in flight the data of frame N is mapped in frame N+2 when the GPU is long done with it.
+	class OpenGLReadback {
+	public:
+		static const uint ringSize = 3;
+
+		ENCOOPENGLAPI OpenGLReadback();
+		ENCOOPENGLAPI ~OpenGLReadback();
+
+		// The callback gets the pixels tightly packed in format and type, e.g. GL_DEPTH_COMPONENT and GL_FLOAT for depth
+		ENCOOPENGLAPI void request(GLuint framebuffer, uint width, uint height, u64 frame, ReadbackCallback callback, GLenum format = GL_RGBA, GLenum type = GL_UNSIGNED_BYTE);
+
+		// Delivers every finished readback. With wait set it blocks until all pending ones are done.
+		// Readbacks whose fence cannot be waited for are dropped without calling their callback.
+		ENCOOPENGLAPI void poll(bool wait = false);
+
+		ENCOOPENGLAPI void release();
+
+		inline uint getPendingCount() const { return m_pendingCount; }
+		inline u64 getStallCount() const { return m_stalls; }
+
+	private:
+		struct Slot {
+			GLuint buffer;
+			GLsizeiptr capacity;
+			// Bytes of the pending readback
+			GLsizeiptr size;
+			GLsync fence;
+			uint width, height;
+			u64 frame;
+			ReadbackCallback callback;
+		};
+
+		bool deliver(Slot &slot, GLuint64 timeout);
+
+		Slot m_slots[ringSize];
+		uint m_next;
+		uint m_pendingCount;
+		u64 m_stalls;
+	};
+}
+
+#endif
\ No newline at end of file
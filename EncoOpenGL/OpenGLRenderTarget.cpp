@@ -0,0 +1,157 @@
+#include "stdafx.h"
+#include "OpenGLRenderTarget.h"
+
+#include <cstring>
+
+namespace enco {
+	ENCOOPENGLAPI OpenGLRenderTarget::OpenGLRenderTarget(const RenderTargetDescription &description) : m_description(description), m_framebuffer(0), m_depthTexture(0), m_multisampleFramebuffer(0), m_byteSize(0) {
+		memset(m_colorTextures, 0, sizeof(m_colorTextures));
+		memset(m_multisampleRenderbuffers, 0, sizeof(m_multisampleRenderbuffers));
+
+		uint colorCount = m_description.getColorCount();
+		uint samples = m_description.samples > 1 ? m_description.samples : 1;
+		GLenum drawBuffers[RenderTargetDescription::maxColorAttachments];
+
+		GLenum internalFormat, pixelFormat, pixelType;
+
+		glGenFramebuffers(1, &m_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+
+		glGenTextures(colorCount, m_colorTextures);
+		for (uint i = 0; i < colorCount; ++i) {
+			getFormat(m_description.colorFormats[i], internalFormat, pixelFormat, pixelType);
+
+			glBindTexture(GL_TEXTURE_2D, m_colorTextures[i]);
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_description.width, m_description.height, 0, pixelFormat, pixelType, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, m_colorTextures[i], 0);
+
+			drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+			m_byteSize += (u64)m_description.width * m_description.height * getBytesPerPixel(m_description.colorFormats[i]) * (samples > 1 ? samples + 1 : 1);
+		}
+
+		GLenum depthAttachment = m_description.depthFormat == depth24Stencil8Format ? GL_DEPTH_STENCIL_ATTACHMENT : GL_DEPTH_ATTACHMENT;
+		if (m_description.depthFormat != noFormat) {
+			getFormat(m_description.depthFormat, internalFormat, pixelFormat, pixelType);
+
+			glGenTextures(1, &m_depthTexture);
+			glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, m_description.width, m_description.height, 0, pixelFormat, pixelType, nullptr);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			glFramebufferTexture2D(GL_FRAMEBUFFER, depthAttachment, GL_TEXTURE_2D, m_depthTexture, 0);
+
+			m_byteSize += (u64)m_description.width * m_description.height * getBytesPerPixel(m_description.depthFormat) * (samples > 1 ? samples + 1 : 1);
+		}
+
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glDrawBuffers(colorCount, drawBuffers);
+		if (colorCount == 0) {
+			glReadBuffer(GL_NONE);
+		}
+
+		if (samples > 1) {
+			glGenFramebuffers(1, &m_multisampleFramebuffer);
+			glBindFramebuffer(GL_FRAMEBUFFER, m_multisampleFramebuffer);
+
+			glGenRenderbuffers(colorCount + 1, m_multisampleRenderbuffers);
+			for (uint i = 0; i < colorCount; ++i) {
+				getFormat(m_description.colorFormats[i], internalFormat, pixelFormat, pixelType);
+				glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleRenderbuffers[i]);
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalFormat, m_description.width, m_description.height);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_RENDERBUFFER, m_multisampleRenderbuffers[i]);
+			}
+
+			if (m_description.depthFormat != noFormat) {
+				getFormat(m_description.depthFormat, internalFormat, pixelFormat, pixelType);
+				glBindRenderbuffer(GL_RENDERBUFFER, m_multisampleRenderbuffers[colorCount]);
+				glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, internalFormat, m_description.width, m_description.height);
+				glFramebufferRenderbuffer(GL_FRAMEBUFFER, depthAttachment, GL_RENDERBUFFER, m_multisampleRenderbuffers[colorCount]);
+			}
+
+			glBindRenderbuffer(GL_RENDERBUFFER, 0);
+			glDrawBuffers(colorCount, drawBuffers);
+		}
+
+		if (!checkStatus(m_framebuffer) || (m_multisampleFramebuffer && !checkStatus(m_multisampleFramebuffer))) {
+#ifdef _DEBUG
+			printf("OpenGL Error: Incomplete framebuffer (%ux%u, %u samples)\n", m_description.width, m_description.height, samples);
+#endif
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	ENCOOPENGLAPI OpenGLRenderTarget::~OpenGLRenderTarget() {
+		glDeleteFramebuffers(1, &m_framebuffer);
+		glDeleteTextures(RenderTargetDescription::maxColorAttachments, m_colorTextures);
+		glDeleteTextures(1, &m_depthTexture);
+
+		if (m_multisampleFramebuffer) {
+			glDeleteFramebuffers(1, &m_multisampleFramebuffer);
+			glDeleteRenderbuffers(RenderTargetDescription::maxColorAttachments + 1, m_multisampleRenderbuffers);
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderTarget::resolve() {
+		if (!m_multisampleFramebuffer) {
+			return;
+		}
+
+		uint colorCount = m_description.getColorCount();
+		uint width = m_description.width, height = m_description.height;
+
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_multisampleFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+
+		for (uint i = 0; i < colorCount; ++i) {
+			glReadBuffer(GL_COLOR_ATTACHMENT0 + i);
+			glDrawBuffer(GL_COLOR_ATTACHMENT0 + i);
+			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, i == 0 && m_description.depthFormat != noFormat ? GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT : GL_COLOR_BUFFER_BIT, GL_NEAREST);
+		}
+		if (colorCount == 0 && m_description.depthFormat != noFormat) {
+			glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		}
+
+		GLenum drawBuffers[RenderTargetDescription::maxColorAttachments];
+		for (uint i = 0; i < colorCount; ++i) {
+			drawBuffers[i] = GL_COLOR_ATTACHMENT0 + i;
+		}
+		glDrawBuffers(colorCount, drawBuffers);
+		glReadBuffer(colorCount ? GL_COLOR_ATTACHMENT0 : GL_NONE);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderTarget::getFormat(TextureFormat format, GLenum &internalFormat, GLenum &pixelFormat, GLenum &pixelType) {
+		switch (format) {
+		case rgba16fFormat:         internalFormat = GL_RGBA16F;            pixelFormat = GL_RGBA;            pixelType = GL_HALF_FLOAT;        break;
+		case rgba32fFormat:         internalFormat = GL_RGBA32F;            pixelFormat = GL_RGBA;            pixelType = GL_FLOAT;             break;
+		case rg16fFormat:           internalFormat = GL_RG16F;              pixelFormat = GL_RG;              pixelType = GL_HALF_FLOAT;        break;
+		case r32fFormat:            internalFormat = GL_R32F;               pixelFormat = GL_RED;             pixelType = GL_FLOAT;             break;
+		case depth24Format:         internalFormat = GL_DEPTH_COMPONENT24;  pixelFormat = GL_DEPTH_COMPONENT; pixelType = GL_UNSIGNED_INT;      break;
+		case depth32fFormat:        internalFormat = GL_DEPTH_COMPONENT32F; pixelFormat = GL_DEPTH_COMPONENT; pixelType = GL_FLOAT;             break;
+		case depth24Stencil8Format: internalFormat = GL_DEPTH24_STENCIL8;   pixelFormat = GL_DEPTH_STENCIL;   pixelType = GL_UNSIGNED_INT_24_8; break;
+		default:                    internalFormat = GL_RGBA8;              pixelFormat = GL_RGBA;            pixelType = GL_UNSIGNED_BYTE;     break;
+		}
+	}
+
+	ENCOOPENGLAPI uint OpenGLRenderTarget::getBytesPerPixel(TextureFormat format) {
+		switch (format) {
+		case rgba16fFormat: return 8;
+		case rgba32fFormat: return 16;
+		case noFormat:      return 0;
+		default:            return 4;
+		}
+	}
+
+	bool OpenGLRenderTarget::checkStatus(GLuint framebuffer) const {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef __ENCOOPENGL_OPENGLRENDERTARGET_H__
+#define __ENCOOPENGL_OPENGLRENDERTARGET_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+namespace enco {
+	// Framebuffer object with texture attachments. Multisampled targets render into renderbuffers
+	// and resolve() blits them into the textures, which are what samplers and readbacks see.
+	class OpenGLRenderTarget : public IRenderTarget {
+	public:
+		ENCOOPENGLAPI OpenGLRenderTarget(const RenderTargetDescription &description);
+		ENCOOPENGLAPI virtual ~OpenGLRenderTarget();
+
+		inline virtual const RenderTargetDescription &getDescription() const { return m_description; }
+
+		inline bool isValid() const { return m_framebuffer != 0; }
+		inline bool isMultisampled() const { return m_multisampleFramebuffer != 0; }
+
+		// The framebuffer draw calls go to
+		inline GLuint getDrawFramebuffer() const { return m_multisampleFramebuffer ? m_multisampleFramebuffer : m_framebuffer; }
+		// The single-sampled framebuffer with the textures attached
+		inline GLuint getFramebuffer() const { return m_framebuffer; }
+
+		inline GLuint getColorTexture(uint index) const { return m_colorTextures[index]; }
+		inline GLuint getDepthTexture() const { return m_depthTexture; }
+
+		ENCOOPENGLAPI void resolve();
+
+		inline u64 getByteSize() const { return m_byteSize; }
+
+		ENCOOPENGLAPI static void getFormat(TextureFormat format, GLenum &internalFormat, GLenum &pixelFormat, GLenum &pixelType);
+		ENCOOPENGLAPI static uint getBytesPerPixel(TextureFormat format);
+
+	private:
+		OpenGLRenderTarget(const OpenGLRenderTarget &) = delete;
+		OpenGLRenderTarget &operator=(const OpenGLRenderTarget &) = delete;
+
+		bool checkStatus(GLuint framebuffer) const;
+
+		RenderTargetDescription m_description;
+
+		GLuint m_framebuffer;
+		GLuint m_colorTextures[RenderTargetDescription::maxColorAttachments];
+		GLuint m_depthTexture;
+
+		GLuint m_multisampleFramebuffer;
+		GLuint m_multisampleRenderbuffers[RenderTargetDescription::maxColorAttachments + 1];
+
+		u64 m_byteSize;
+	};
+}
+
+#endif
\ No newline at end of file
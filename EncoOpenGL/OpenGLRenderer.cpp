@@ -1,48 +1,277 @@
 #include "stdafx.h"
 #include "OpenGLRenderer.h"
+#include "OpenGLTrace.h"
 
 #include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #ifdef _WIN32
 #	pragma comment (lib, "SDL2.lib")
-#	include <glew/glew.h>
+#endif
+
+#if defined(ENCO_OPENGL_EGL)
+#	include <EGL/egl.h>
+#elif defined(ENCO_OPENGL_OSMESA)
+#	include <GL/osmesa.h>
 #endif
 
 namespace enco {
+#if defined(ENCO_OPENGL_EGL) || defined(ENCO_OPENGL_OSMESA)
+	namespace {
+		struct EntryPoint {
+			const char *name;
+			void **pointer;
+		};
+
+#		define ENCO_GL_ENTRY_POINT(name) { "gl" #name, (void **)&__glew##name }
+		// Every GL function above 1.1 that the library, GLReplay and Benchmark call
+		const EntryPoint entryPoints[] = {
+			ENCO_GL_ENTRY_POINT(ActiveTexture), ENCO_GL_ENTRY_POINT(AttachShader), ENCO_GL_ENTRY_POINT(BindBuffer),
+			ENCO_GL_ENTRY_POINT(BindBufferBase), ENCO_GL_ENTRY_POINT(BindBufferRange), ENCO_GL_ENTRY_POINT(BindFramebuffer),
+			ENCO_GL_ENTRY_POINT(BindRenderbuffer), ENCO_GL_ENTRY_POINT(BindVertexArray), ENCO_GL_ENTRY_POINT(BindVertexBuffer),
+			ENCO_GL_ENTRY_POINT(BlendFuncSeparate), ENCO_GL_ENTRY_POINT(BlitFramebuffer), ENCO_GL_ENTRY_POINT(BufferData),
+			ENCO_GL_ENTRY_POINT(BufferStorage), ENCO_GL_ENTRY_POINT(BufferSubData), ENCO_GL_ENTRY_POINT(CheckFramebufferStatus),
+			ENCO_GL_ENTRY_POINT(ClientWaitSync), ENCO_GL_ENTRY_POINT(CompileShader), ENCO_GL_ENTRY_POINT(CopyImageSubData),
+			ENCO_GL_ENTRY_POINT(CreateProgram), ENCO_GL_ENTRY_POINT(CreateShader), ENCO_GL_ENTRY_POINT(DeleteBuffers),
+			ENCO_GL_ENTRY_POINT(DeleteFramebuffers), ENCO_GL_ENTRY_POINT(DeleteProgram), ENCO_GL_ENTRY_POINT(DeleteQueries),
+			ENCO_GL_ENTRY_POINT(DeleteRenderbuffers), ENCO_GL_ENTRY_POINT(DeleteShader), ENCO_GL_ENTRY_POINT(DeleteSync),
+			ENCO_GL_ENTRY_POINT(DeleteVertexArrays), ENCO_GL_ENTRY_POINT(DrawArraysInstanced),
+			ENCO_GL_ENTRY_POINT(DrawArraysInstancedBaseInstance), ENCO_GL_ENTRY_POINT(DrawBuffers),
+			ENCO_GL_ENTRY_POINT(DrawElementsInstanced), ENCO_GL_ENTRY_POINT(DrawElementsInstancedBaseVertex),
+			ENCO_GL_ENTRY_POINT(DrawElementsInstancedBaseVertexBaseInstance), ENCO_GL_ENTRY_POINT(EnableVertexAttribArray), ENCO_GL_ENTRY_POINT(FenceSync),
+			ENCO_GL_ENTRY_POINT(FramebufferRenderbuffer), ENCO_GL_ENTRY_POINT(FramebufferTexture2D),
+			ENCO_GL_ENTRY_POINT(FramebufferTextureLayer), ENCO_GL_ENTRY_POINT(GenBuffers), ENCO_GL_ENTRY_POINT(GenFramebuffers),
+			ENCO_GL_ENTRY_POINT(GenQueries), ENCO_GL_ENTRY_POINT(GenRenderbuffers), ENCO_GL_ENTRY_POINT(GenVertexArrays),
+			ENCO_GL_ENTRY_POINT(GetActiveUniform), ENCO_GL_ENTRY_POINT(GetActiveUniformsiv), ENCO_GL_ENTRY_POINT(GetAttachedShaders),
+			ENCO_GL_ENTRY_POINT(GetBufferParameteri64v), ENCO_GL_ENTRY_POINT(GetBufferParameteriv), ENCO_GL_ENTRY_POINT(GetBufferSubData),
+			ENCO_GL_ENTRY_POINT(GetFramebufferAttachmentParameteriv), ENCO_GL_ENTRY_POINT(GetInteger64i_v),
+			ENCO_GL_ENTRY_POINT(GetIntegeri_v), ENCO_GL_ENTRY_POINT(GetProgramInfoLog), ENCO_GL_ENTRY_POINT(GetProgramiv),
+			ENCO_GL_ENTRY_POINT(GetQueryObjectiv), ENCO_GL_ENTRY_POINT(GetQueryObjectui64v),
+			ENCO_GL_ENTRY_POINT(GetRenderbufferParameteriv), ENCO_GL_ENTRY_POINT(GetShaderInfoLog), ENCO_GL_ENTRY_POINT(GetShaderiv),
+			ENCO_GL_ENTRY_POINT(GetShaderSource), ENCO_GL_ENTRY_POINT(GetStringi), ENCO_GL_ENTRY_POINT(GetUniformfv),
+			ENCO_GL_ENTRY_POINT(GetUniformiv), ENCO_GL_ENTRY_POINT(GetUniformLocation), ENCO_GL_ENTRY_POINT(GetUniformuiv),
+			ENCO_GL_ENTRY_POINT(GetVertexAttribiv), ENCO_GL_ENTRY_POINT(IsProgram), ENCO_GL_ENTRY_POINT(LinkProgram),
+			ENCO_GL_ENTRY_POINT(MapBufferRange), ENCO_GL_ENTRY_POINT(MultiDrawElementsIndirect), ENCO_GL_ENTRY_POINT(QueryCounter),
+			ENCO_GL_ENTRY_POINT(RenderbufferStorageMultisample), ENCO_GL_ENTRY_POINT(ShaderSource), ENCO_GL_ENTRY_POINT(TexImage3D),
+			ENCO_GL_ENTRY_POINT(TexSubImage3D), ENCO_GL_ENTRY_POINT(Uniform1f), ENCO_GL_ENTRY_POINT(Uniform1fv),
+			ENCO_GL_ENTRY_POINT(Uniform1i), ENCO_GL_ENTRY_POINT(Uniform1iv), ENCO_GL_ENTRY_POINT(Uniform1uiv),
+			ENCO_GL_ENTRY_POINT(Uniform2f), ENCO_GL_ENTRY_POINT(Uniform2fv), ENCO_GL_ENTRY_POINT(Uniform2iv),
+			ENCO_GL_ENTRY_POINT(Uniform2uiv), ENCO_GL_ENTRY_POINT(Uniform3fv), ENCO_GL_ENTRY_POINT(Uniform3iv),
+			ENCO_GL_ENTRY_POINT(Uniform3ui), ENCO_GL_ENTRY_POINT(Uniform3uiv), ENCO_GL_ENTRY_POINT(Uniform4fv),
+			ENCO_GL_ENTRY_POINT(Uniform4iv), ENCO_GL_ENTRY_POINT(Uniform4uiv), ENCO_GL_ENTRY_POINT(UniformMatrix2fv),
+			ENCO_GL_ENTRY_POINT(UniformMatrix3fv), ENCO_GL_ENTRY_POINT(UniformMatrix4fv), ENCO_GL_ENTRY_POINT(UnmapBuffer),
+			ENCO_GL_ENTRY_POINT(UseProgram), ENCO_GL_ENTRY_POINT(VertexAttribBinding), ENCO_GL_ENTRY_POINT(VertexAttribFormat),
+			ENCO_GL_ENTRY_POINT(VertexAttribIFormat), ENCO_GL_ENTRY_POINT(VertexAttribIPointer), ENCO_GL_ENTRY_POINT(VertexAttribPointer),
+			ENCO_GL_ENTRY_POINT(VertexBindingDivisor)
+		};
+#		undef ENCO_GL_ENTRY_POINT
+
+		void *getProcAddress(const char *name) {
+#	if defined(ENCO_OPENGL_EGL)
+			return (void *)eglGetProcAddress(name);
+#	else
+			return (void *)OSMesaGetProcAddress(name);
+#	endif
+		}
+
+		bool hasExtension(const char *name) {
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+			for (GLint i = 0; i < count; ++i) {
+				const char *extension = (const char *)__glewGetStringi(GL_EXTENSIONS, (GLuint)i);
+				if (extension && strcmp(extension, name) == 0) {
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+#endif
+
 	ENCOOPENGLAPI void OpenGLRenderer::createContext(int x, int y, uint width, uint height, uint colorBits, uint depthBits, uint stencilBits, bool fullscreen, SDL_WINDOW sdlWindow) {
-		if (sdlWindow) {
-			m_sdlWindow = sdlWindow;
+		if (!sdlWindow) {
+			++m_headlessUsers;
+			if (!hasContext()) {
+				createHeadlessContext(width, height);
+			}
+			return;
+		}
 
-			m_sdlGlContext = SDL_GL_CreateContext((SDL_Window *)m_sdlWindow);
-			if (!m_sdlGlContext) {
+		if (m_headlessContext) {
 #ifdef _DEBUG
-				const char *error = SDL_GetError();
-				if (*error != '\0') {
-					printf("SDL Error: %s\n", error);
-					SDL_ClearError();
-				}
+			printf("OpenGL Error: Windows cannot share an EGL/OSMesa headless context\n");
 #endif
+			return;
+		}
+
+		if (m_sdlGlContext) {
+			m_sdlWindows.push_back(sdlWindow);
+			return;
+		}
+
+		m_sdlGlContext = SDL_GL_CreateContext((SDL_Window *)sdlWindow);
+		if (!m_sdlGlContext) {
+#ifdef _DEBUG
+			const char *error = SDL_GetError();
+			if (*error != '\0') {
+				printf("SDL Error: %s\n", error);
+				SDL_ClearError();
 			}
+#endif
+			return;
 		}
+
+		m_sdlWindows.push_back(sdlWindow);
+		m_currentWindow = sdlWindow;
+		initializeExtensions();
 	}
 
-	ENCOOPENGLAPI void OpenGLRenderer::deleteContext() {
-		if (m_sdlGlContext) {
-			SDL_GL_DeleteContext((SDL_GLContext)m_sdlGlContext);
-			m_sdlGlContext = nullptr;
+	ENCOOPENGLAPI void OpenGLRenderer::deleteContext(SDL_WINDOW sdlWindow) {
+		if (sdlWindow) {
+			std::vector<SDL_WINDOW>::iterator it = std::find(m_sdlWindows.begin(), m_sdlWindows.end(), sdlWindow);
+			if (it != m_sdlWindows.end()) {
+				m_sdlWindows.erase(it);
+			}
+
+			if (m_currentWindow == sdlWindow) {
+				m_currentWindow = nullptr;
+				if (!m_sdlWindows.empty()) {
+					makeCurrent(m_sdlWindows.front());
+				}
+				else if (m_hiddenWindow) {
+					makeCurrent(m_hiddenWindow);
+				}
+			}
+		}
+		else if (m_headlessUsers > 0) {
+			--m_headlessUsers;
+		}
+
+		if (m_sdlWindows.empty() && m_headlessUsers == 0) {
+			releaseContext();
 		}
 	}
 
+	ENCOOPENGLAPI void OpenGLRenderer::forceLlvmpipe() {
+#ifdef _WIN32
+		_putenv("LIBGL_ALWAYS_SOFTWARE=1");
+		_putenv("GALLIUM_DRIVER=llvmpipe");
+#else
+		setenv("LIBGL_ALWAYS_SOFTWARE", "1", 1);
+		setenv("GALLIUM_DRIVER", "llvmpipe", 1);
+#endif
+	}
+
 	ENCOOPENGLAPI int OpenGLRenderer::getSDLOptions() {
 		return SDL_WINDOW_OPENGL;
 	}
 
 	ENCOOPENGLAPI void OpenGLRenderer::beginFrame() {
+		if (hasContext()) {
+			if (!m_capturePath.empty()) {
+				OpenGLTrace::start();
+			}
+			m_frameTimer.beginFrame();
+			m_streamBuffer.beginFrame();
+		}
 	}
 
 	ENCOOPENGLAPI void OpenGLRenderer::endFrame() {
-		if (m_sdlGlContext) {
-			SDL_GL_SwapWindow((SDL_Window *)m_sdlWindow);
+		if (hasContext()) {
+			m_streamBuffer.endFrame();
+			m_readback.poll();
+			m_frameTimer.endFrame();
+			if (OpenGLTrace::isCapturing()) {
+				OpenGLTrace::stop(m_capturePath, m_viewWidth, m_viewHeight);
+				m_capturePath.clear();
+			}
+		}
+		++m_frame;
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::captureFrame(const std::string &path) {
+		m_capturePath = path;
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::beginView(SDL_WINDOW sdlWindow, uint width, uint height) {
+		if (!hasContext()) {
+			return;
+		}
+
+		m_viewWidth = width;
+		m_viewHeight = height;
+		m_boundTarget = nullptr;
+
+		if (sdlWindow) {
+			makeCurrent(sdlWindow);
+
+			// Waiting for vblank once per frame is enough, otherwise N windows would run at 1/N of the refresh rate
+			int swapInterval = m_vsync && sdlWindow == m_sdlWindows.back() ? 1 : 0;
+			if (swapInterval != m_swapInterval) {
+				SDL_GL_SetSwapInterval(swapInterval);
+				m_swapInterval = swapInterval;
+			}
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::endView(SDL_WINDOW sdlWindow) {
+		if (!hasContext()) {
+			return;
 		}
+
+		if (m_boundTarget) {
+			m_boundTarget->resolve();
+			m_boundTarget = nullptr;
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		}
+
+		if (sdlWindow) {
+			SDL_GL_SwapWindow((SDL_Window *)sdlWindow);
+		}
+	}
+
+	ENCOOPENGLAPI std::shared_ptr<IRenderTarget> OpenGLRenderer::createRenderTarget(const RenderTargetDescription &description) {
+		if (!hasContext()) {
+			return nullptr;
+		}
+
+		std::shared_ptr<OpenGLRenderTarget> target = std::make_shared<OpenGLRenderTarget>(description);
+		if (m_boundTarget) {
+			glBindFramebuffer(GL_FRAMEBUFFER, m_boundTarget->getDrawFramebuffer());
+		}
+		return target;
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::bindRenderTarget(IRenderTarget *target) {
+		if (m_boundTarget == target) {
+			return;
+		}
+
+		if (m_boundTarget) {
+			m_boundTarget->resolve();
+		}
+
+		m_boundTarget = static_cast<OpenGLRenderTarget *>(target);
+		if (m_boundTarget) {
+			glBindFramebuffer(GL_FRAMEBUFFER, m_boundTarget->getDrawFramebuffer());
+			glViewport(0, 0, (GLsizei)m_boundTarget->getWidth(), (GLsizei)m_boundTarget->getHeight());
+		}
+		else {
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, (GLsizei)m_viewWidth, (GLsizei)m_viewHeight);
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::readback(IRenderTarget *target, ReadbackCallback callback) {
+		requestReadback(target, callback, GL_RGBA, GL_UNSIGNED_BYTE);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::readbackDepth(IRenderTarget *target, ReadbackCallback callback) {
+		requestReadback(target, callback, GL_DEPTH_COMPONENT, GL_FLOAT);
 	}
 
 	ENCOOPENGLAPI void OpenGLRenderer::setClearColor(f32 r, f32 g, f32 b) {
@@ -54,14 +283,325 @@ namespace enco {
 	}
 
 	ENCOOPENGLAPI void OpenGLRenderer::clearBuffer(int buffers) {
+		GLbitfield mask = 0;
 		if ((buffers & RenderingBuffer::colorBuffer) == RenderingBuffer::colorBuffer) {
-			glClear(GL_COLOR_BUFFER_BIT);
+			mask |= GL_COLOR_BUFFER_BIT;
 		}
 		if ((buffers & RenderingBuffer::depthBuffer) == RenderingBuffer::depthBuffer) {
-			glClear(GL_DEPTH_BUFFER_BIT);
+			mask |= GL_DEPTH_BUFFER_BIT;
 		}
 		if ((buffers & RenderingBuffer::stencilBuffer) == RenderingBuffer::stencilBuffer) {
-			glClear(GL_STENCIL_BUFFER_BIT);
+			mask |= GL_STENCIL_BUFFER_BIT;
+		}
+
+		// One glClear for all buffers lets the driver clear them in a single fast-clear operation
+		if (mask) {
+			glClear(mask);
+		}
+	}
+
+	ENCOOPENGLAPI bool OpenGLRenderer::uploadLights(const LightClusterGrid &grid) {
+		if (!hasContext()) {
+			return false;
+		}
+		return m_clusteredLighting.upload(grid, m_streamBuffer);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::renderShadows(ShadowCascades &cascades, ShadowDrawCallback draw) {
+		if (!hasContext()) {
+			return;
+		}
+
+		if (m_shadowMap.getResolution() != cascades.getResolution() || m_shadowMap.getCascadeCount() != cascades.getCascadeCount()) {
+			m_shadowMap.create(cascades.getResolution(), cascades.getCascadeCount());
+			cascades.invalidateStatic();
+		}
+		m_shadowMap.render(cascades, draw);
+
+		if (m_boundTarget) {
+			glBindFramebuffer(GL_FRAMEBUFFER, m_boundTarget->getDrawFramebuffer());
+			glViewport(0, 0, (GLsizei)m_boundTarget->getWidth(), (GLsizei)m_boundTarget->getHeight());
+		}
+		else {
+			glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(0, 0, (GLsizei)m_viewWidth, (GLsizei)m_viewHeight);
 		}
 	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawIndirect(const OpenGLMesh &mesh, const std::vector<DrawIndirectCommand> &commands) {
+		if (!hasContext() || commands.empty() || !mesh.getVertexArray()) {
+			return;
+		}
+
+		if (!isMultiDrawIndirectSupported()) {
+			// One draw per command from the CPU copy, baseInstance needs GL 4.2 or ARB_base_instance
+			bool baseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+			glBindVertexArray(mesh.getVertexArray());
+			for (size_t i = 0; i < commands.size(); ++i) {
+				const DrawIndirectCommand &command = commands[i];
+				const void *indices = (const void *)(command.firstIndex * sizeof(u32));
+				if (baseInstance) {
+					glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, (GLsizei)command.count, GL_UNSIGNED_INT, indices, (GLsizei)command.instanceCount, command.baseVertex, command.baseInstance);
+				}
+				else {
+					glDrawElementsInstancedBaseVertex(GL_TRIANGLES, (GLsizei)command.count, GL_UNSIGNED_INT, indices, (GLsizei)command.instanceCount, command.baseVertex);
+				}
+			}
+			return;
+		}
+
+		GLsizeiptr size = (GLsizeiptr)(commands.size() * sizeof(DrawIndirectCommand));
+		OpenGLStreamBuffer::Allocation allocation = m_streamBuffer.allocate(size, sizeof(DrawIndirectCommand));
+		if (!allocation.data) {
+			return;
+		}
+		memcpy(allocation.data, &commands[0], (size_t)size);
+		m_streamBuffer.flush();
+
+		glBindVertexArray(mesh.getVertexArray());
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_streamBuffer.getBuffer());
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void *)allocation.offset, (GLsizei)commands.size(), 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+
+	ENCOOPENGLAPI bool OpenGLRenderer::isMultiDrawIndirectSupported() {
+		return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawSkinned(const OpenGLMesh &mesh, const MeshData &data, const AnimationInstance *instances, uint count, OpenGLShader &shader, uint lod, JobSystem *jobSystem) {
+		if (!hasContext() || count == 0) {
+			return;
+		}
+
+		if (getSoftwareSkinning() || !OpenGLSkinning::isSupported()) {
+			m_skinning.drawSoftware(mesh, data, instances, count, shader, lod, jobSystem);
+		}
+		else {
+			m_skinning.draw(mesh, instances, count, shader, lod, m_streamBuffer);
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawParticles(const ParticleEmitter &emitter, const glm::mat4 &view, const glm::mat4 &projection) {
+		if (!hasContext()) {
+			return;
+		}
+		m_particles.draw(emitter, view, projection);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawDebug(const DebugDraw &debugDraw, const glm::mat4 &viewProjection) {
+		if (!hasContext()) {
+			return;
+		}
+
+		uint width = m_boundTarget ? m_boundTarget->getDescription().width : m_viewWidth;
+		uint height = m_boundTarget ? m_boundTarget->getDescription().height : m_viewHeight;
+		m_debugDraw.draw(debugDraw, viewProjection, width, height, m_streamBuffer);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawText(TextBatch &batch) {
+		if (!hasContext()) {
+			return;
+		}
+
+		uint width = m_boundTarget ? m_boundTarget->getDescription().width : m_viewWidth;
+		uint height = m_boundTarget ? m_boundTarget->getDescription().height : m_viewHeight;
+		m_text.draw(batch, width, height, m_streamBuffer);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawSprites(SpriteBatch &batch) {
+		if (!hasContext()) {
+			return;
+		}
+
+		uint width = m_boundTarget ? m_boundTarget->getDescription().width : m_viewWidth;
+		uint height = m_boundTarget ? m_boundTarget->getDescription().height : m_viewHeight;
+		m_sprites.draw(batch, width, height, m_streamBuffer);
+	}
+
+	ENCOOPENGLAPI void OpenGLRenderer::drawTerrain(Terrain &terrain, const glm::mat4 &viewProjection) {
+		if (!hasContext()) {
+			return;
+		}
+		m_terrain.draw(terrain, viewProjection, m_streamBuffer);
+	}
+
+	void OpenGLRenderer::makeCurrent(SDL_WINDOW sdlWindow) {
+		if (m_currentWindow != sdlWindow) {
+			SDL_GL_MakeCurrent((SDL_Window *)sdlWindow, (SDL_GLContext)m_sdlGlContext);
+			m_currentWindow = sdlWindow;
+		}
+	}
+
+	bool OpenGLRenderer::createHeadlessContext(uint width, uint height) {
+		width = width ? width : 1;
+		height = height ? height : 1;
+
+#if defined(ENCO_OPENGL_EGL)
+		EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+			return false;
+		}
+
+		const EGLint configAttributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configCount = 0;
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+			eglTerminate(display);
+			return false;
+		}
+
+		const EGLint surfaceAttributes[] = { EGL_WIDTH, (EGLint)width, EGL_HEIGHT, (EGLint)height, EGL_NONE };
+		EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+
+		eglBindAPI(EGL_OPENGL_API);
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+		if (surface == EGL_NO_SURFACE || context == EGL_NO_CONTEXT || !eglMakeCurrent(display, surface, surface, context)) {
+			eglTerminate(display);
+			return false;
+		}
+
+		m_headlessDisplay = display;
+		m_headlessSurface = surface;
+		m_headlessContext = context;
+#elif defined(ENCO_OPENGL_OSMESA)
+		OSMesaContext context = OSMesaCreateContextExt(OSMESA_RGBA, 24, 8, 0, nullptr);
+		if (!context) {
+			return false;
+		}
+
+		m_headlessBuffer.resize((size_t)width * height * 4);
+		if (!OSMesaMakeCurrent(context, &m_headlessBuffer[0], GL_UNSIGNED_BYTE, (GLsizei)width, (GLsizei)height)) {
+			OSMesaDestroyContext(context);
+			m_headlessBuffer.clear();
+			return false;
+		}
+
+		m_headlessContext = context;
+#else
+		SDL_InitSubSystem(SDL_INIT_VIDEO);
+
+		m_hiddenWindow = SDL_CreateWindow("", 0, 0, (int)width, (int)height, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+		if (!m_hiddenWindow) {
+			SDL_QuitSubSystem(SDL_INIT_VIDEO);
+			return false;
+		}
+
+		m_sdlGlContext = SDL_GL_CreateContext((SDL_Window *)m_hiddenWindow);
+		if (!m_sdlGlContext) {
+			SDL_DestroyWindow((SDL_Window *)m_hiddenWindow);
+			SDL_QuitSubSystem(SDL_INIT_VIDEO);
+			m_hiddenWindow = nullptr;
+			return false;
+		}
+		m_currentWindow = m_hiddenWindow;
+#endif
+
+		initializeExtensions();
+		return true;
+	}
+
+	void OpenGLRenderer::deleteHeadlessContext() {
+#if defined(ENCO_OPENGL_EGL)
+		if (m_headlessContext) {
+			eglMakeCurrent(m_headlessDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+			eglDestroyContext(m_headlessDisplay, m_headlessContext);
+			eglDestroySurface(m_headlessDisplay, m_headlessSurface);
+			eglTerminate(m_headlessDisplay);
+		}
+#elif defined(ENCO_OPENGL_OSMESA)
+		if (m_headlessContext) {
+			OSMesaDestroyContext((OSMesaContext)m_headlessContext);
+		}
+#endif
+		m_headlessDisplay = m_headlessSurface = m_headlessContext = nullptr;
+		m_headlessBuffer.clear();
+
+		if (m_hiddenWindow) {
+			SDL_DestroyWindow((SDL_Window *)m_hiddenWindow);
+			SDL_QuitSubSystem(SDL_INIT_VIDEO);
+			m_hiddenWindow = nullptr;
+		}
+	}
+
+	void OpenGLRenderer::initializeExtensions() {
+		glewExperimental = GL_TRUE;
+		GLenum error = glewInit();
+#if defined(ENCO_OPENGL_EGL) || defined(ENCO_OPENGL_OSMESA)
+		// GLEW resolves its pointers through WGL or GLX, which know nothing of EGL and OSMesa contexts, and its GLX part
+		// fails without an X display. The version flags come from GL_VERSION and are valid, the entry points and the
+		// extension flags the library checks are loaded from the context API instead.
+		for (size_t i = 0; i < sizeof(entryPoints) / sizeof(entryPoints[0]); ++i) {
+			*entryPoints[i].pointer = getProcAddress(entryPoints[i].name);
+		}
+		if (__glewGetStringi) {
+			__GLEW_ARB_base_instance = hasExtension("GL_ARB_base_instance");
+			__GLEW_ARB_buffer_storage = hasExtension("GL_ARB_buffer_storage");
+			__GLEW_ARB_copy_image = hasExtension("GL_ARB_copy_image");
+			__GLEW_ARB_multi_draw_indirect = hasExtension("GL_ARB_multi_draw_indirect");
+			__GLEW_ARB_shader_storage_buffer_object = hasExtension("GL_ARB_shader_storage_buffer_object");
+			__GLEW_ARB_sync = hasExtension("GL_ARB_sync");
+		}
+		if (error == GLEW_ERROR_GLX_VERSION_11_ONLY) {
+			error = GLEW_OK;
+		}
+#endif
+		if (error != GLEW_OK) {
+#ifdef _DEBUG
+			printf("GLEW Error: %s\n", (const char *)glewGetErrorString(error));
+#endif
+		}
+
+		m_streamBuffer.create(streamBufferFrameSize);
+	}
+
+	void OpenGLRenderer::requestReadback(IRenderTarget *target, ReadbackCallback callback, GLenum format, GLenum type) {
+		if (!hasContext()) {
+			return;
+		}
+
+		OpenGLRenderTarget *renderTarget = static_cast<OpenGLRenderTarget *>(target);
+		if (renderTarget) {
+			renderTarget->resolve();
+			m_readback.request(renderTarget->getFramebuffer(), renderTarget->getWidth(), renderTarget->getHeight(), m_frame, callback, format, type);
+		}
+		else {
+			m_readback.request(0, m_viewWidth, m_viewHeight, m_frame, callback, format, type);
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_boundTarget ? m_boundTarget->getDrawFramebuffer() : 0);
+	}
+
+	void OpenGLRenderer::releaseContext() {
+		if (!hasContext()) {
+			return;
+		}
+
+		m_readback.release();
+		m_frameTimer.release();
+		m_streamBuffer.release();
+		m_shadowMap.release();
+		m_skinning.release();
+		m_particles.release();
+		m_debugDraw.release();
+		m_text.release();
+		m_sprites.release();
+		m_terrain.release();
+		m_boundTarget = nullptr;
+
+		if (m_sdlGlContext) {
+			SDL_GL_DeleteContext((SDL_GLContext)m_sdlGlContext);
+			m_sdlGlContext = nullptr;
+		}
+		deleteHeadlessContext();
+
+		m_sdlWindows.clear();
+		m_currentWindow = nullptr;
+		m_swapInterval = -1;
+	}
 }
\ No newline at end of file
@@ -7,29 +7,159 @@
 
 #include <EncoShared\EncoShared.h>
 
+#include "OpenGLRenderTarget.h"
+#include "OpenGLFrameTimer.h"
+#include "OpenGLReadback.h"
+#include "OpenGLStreamBuffer.h"
+#include "OpenGLClusteredLighting.h"
+#include "OpenGLShadowMap.h"
+#include "OpenGLMesh.h"
+#include "OpenGLSkinning.h"
+#include "OpenGLParticles.h"
+#include "OpenGLDebugDraw.h"
+#include "OpenGLText.h"
+#include "OpenGLSprites.h"
+#include "OpenGLTerrain.h"
+
+#include <string>
+#include <vector>
+
 namespace enco {
 	typedef void *SDL_GLCONTEXT;
 
 	class OpenGLRenderer : public IRenderer {
 	public:
-		inline OpenGLRenderer() : m_sdlWindow(nullptr), m_sdlGlContext(nullptr) {  }
+		// Bytes of per-frame data (lights, skinning palettes, debug geometry, ...) that can be streamed each frame
+		static const GLsizeiptr streamBufferFrameSize = 16 * 1024 * 1024;
 
+		inline OpenGLRenderer() : m_currentWindow(nullptr), m_sdlGlContext(nullptr), m_hiddenWindow(nullptr), m_headlessDisplay(nullptr), m_headlessSurface(nullptr), m_headlessContext(nullptr), m_headlessUsers(0), m_vsync(true), m_swapInterval(-1), m_softwareSkinning(false), m_boundTarget(nullptr), m_viewWidth(0), m_viewHeight(0), m_frame(0) {  }
+
+		// Without a window (sdlWindow == nullptr) and no context yet, a headless context is created:
+		// EGL with ENCO_OPENGL_EGL, OSMesa with ENCO_OPENGL_OSMESA and a hidden SDL window otherwise
 		ENCOOPENGLAPI virtual void createContext(int x, int y, uint width, uint height, uint colorBits, uint depthBits, uint stencilBits, bool fullscreen, SDL_WINDOW sdlWindow);
-		ENCOOPENGLAPI virtual void deleteContext();
+		ENCOOPENGLAPI virtual void deleteContext(SDL_WINDOW sdlWindow);
+		// Makes Mesa create the following contexts on llvmpipe. Mesa reads this from the environment, so it has to
+		// be called before the context exists.
+		ENCOOPENGLAPI static void forceLlvmpipe();
 
 		ENCOOPENGLAPI virtual int getSDLOptions();
 
 		ENCOOPENGLAPI virtual void beginFrame();
 		ENCOOPENGLAPI virtual void endFrame();
 
+		ENCOOPENGLAPI virtual void beginView(SDL_WINDOW sdlWindow, uint width, uint height);
+		ENCOOPENGLAPI virtual void endView(SDL_WINDOW sdlWindow);
+
+		ENCOOPENGLAPI virtual std::shared_ptr<IRenderTarget> createRenderTarget(const RenderTargetDescription &description);
+		ENCOOPENGLAPI virtual void bindRenderTarget(IRenderTarget *target);
+
+		ENCOOPENGLAPI virtual void readback(IRenderTarget *target, ReadbackCallback callback);
+		// Same as readback but delivers the depth buffer as f32 values in [0, 1], e.g. for a DepthPyramid
+		ENCOOPENGLAPI void readbackDepth(IRenderTarget *target, ReadbackCallback callback);
+
 		ENCOOPENGLAPI virtual void setClearColor(f32 r, f32 g, f32 b);
 		ENCOOPENGLAPI virtual void setClearDepth(f64 clearDepth);
 
 		ENCOOPENGLAPI virtual void clearBuffer(int buffers);
 
+		ENCOOPENGLAPI virtual void drawSprites(SpriteBatch &batch);
+
+		inline virtual f32 getGpuFrameTime() const { return m_frameTimer.getFrameTime(); }
+
+		inline void setVSync(bool vsync) { m_vsync = vsync; }
+		inline bool getVSync() const { return m_vsync; }
+
+		// Binds the binned lights of grid for shaders that use OpenGLClusteredLighting::getShaderSource(),
+		// false when the context has no shader storage buffers (OpenGLClusteredLighting::isSupported())
+		ENCOOPENGLAPI bool uploadLights(const LightClusterGrid &grid);
+
+		// Renders the cascades into the shadow map, which is (re)created to match them, and restores the bound target.
+		// Recreating the map invalidates the static casters of cascades, they are culled again on the next update.
+		ENCOOPENGLAPI void renderShadows(ShadowCascades &cascades, ShadowDrawCallback draw);
+
+		// Streams the commands and issues them with one glMultiDrawElementsIndirect over the mesh buffers. Contexts
+		// without isMultiDrawIndirectSupported() draw the commands one by one instead.
+		ENCOOPENGLAPI void drawIndirect(const OpenGLMesh &mesh, const std::vector<DrawIndirectCommand> &commands);
+		ENCOOPENGLAPI static bool isMultiDrawIndirectSupported();
+
+		// Draws count characters that share mesh (created from data) with one instanced draw, the bound shader
+		// calls skinVertex() of OpenGLSkinning::getShaderSource(). Headless renderers, contexts without
+		// OpenGLSkinning::isSupported() and any renderer after setSoftwareSkinning(true) skin on the CPU instead,
+		// spread over jobSystem when one is given.
+		ENCOOPENGLAPI void drawSkinned(const OpenGLMesh &mesh, const MeshData &data, const AnimationInstance *instances, uint count, OpenGLShader &shader, uint lod = 0, JobSystem *jobSystem = nullptr);
+
+		// One instanced draw for all live particles of the emitter into the bound target
+		ENCOOPENGLAPI void drawParticles(const ParticleEmitter &emitter, const glm::mat4 &view, const glm::mat4 &projection);
+
+		// Streams everything added to debugDraw since it was last cleared and draws it with one call per primitive type
+		ENCOOPENGLAPI void drawDebug(const DebugDraw &debugDraw, const glm::mat4 &viewProjection);
+
+		// Draws the text added to batch this frame on top of the bound target, one instanced draw per atlas page
+		ENCOOPENGLAPI void drawText(TextBatch &batch);
+
+		// Uploads the tiles that streamed in and draws what terrain selected in its last update() into the bound target
+		ENCOOPENGLAPI void drawTerrain(Terrain &terrain, const glm::mat4 &viewProjection);
+
+		inline void setSoftwareSkinning(bool software) { m_softwareSkinning = software; }
+		inline bool getSoftwareSkinning() const { return m_softwareSkinning || isHeadless(); }
+
+		inline OpenGLStreamBuffer &getStreamBuffer() { return m_streamBuffer; }
+		inline OpenGLClusteredLighting &getClusteredLighting() { return m_clusteredLighting; }
+		inline OpenGLShadowMap &getShadowMap() { return m_shadowMap; }
+		inline OpenGLSkinning &getSkinning() { return m_skinning; }
+		inline OpenGLParticles &getParticles() { return m_particles; }
+		inline OpenGLDebugDraw &getDebugDraw() { return m_debugDraw; }
+		inline OpenGLText &getText() { return m_text; }
+		inline OpenGLSprites &getSprites() { return m_sprites; }
+		inline OpenGLTerrain &getTerrain() { return m_terrain; }
+
+		inline bool isHeadless() const { return m_headlessContext != nullptr || m_hiddenWindow != nullptr; }
+		inline u64 getFrameIndex() const { return m_frame; }
+
+		// Writes every GL call of the next frame, with the objects and state it uses, to path for GLReplay
+		ENCOOPENGLAPI void captureFrame(const std::string &path);
+
 	private:
-		SDL_WINDOW m_sdlWindow;
+		inline bool hasContext() const { return m_sdlGlContext != nullptr || m_headlessContext != nullptr; }
+
+		void makeCurrent(SDL_WINDOW sdlWindow);
+		bool createHeadlessContext(uint width, uint height);
+		void deleteHeadlessContext();
+		void initializeExtensions();
+		void releaseContext();
+		void requestReadback(IRenderTarget *target, ReadbackCallback callback, GLenum format, GLenum type);
+
+		std::vector<SDL_WINDOW> m_sdlWindows;
+		SDL_WINDOW m_currentWindow;
 		SDL_GLCONTEXT m_sdlGlContext;
+
+		SDL_WINDOW m_hiddenWindow;
+		void *m_headlessDisplay;
+		void *m_headlessSurface;
+		void *m_headlessContext;
+		TaggedVector<u8, rendererMemory> m_headlessBuffer;
+		uint m_headlessUsers;
+
+		bool m_vsync;
+		int m_swapInterval;
+		bool m_softwareSkinning;
+
+		OpenGLRenderTarget *m_boundTarget;
+		uint m_viewWidth, m_viewHeight;
+
+		OpenGLReadback m_readback;
+		OpenGLFrameTimer m_frameTimer;
+		OpenGLStreamBuffer m_streamBuffer;
+		OpenGLClusteredLighting m_clusteredLighting;
+		OpenGLShadowMap m_shadowMap;
+		OpenGLSkinning m_skinning;
+		OpenGLParticles m_particles;
+		OpenGLDebugDraw m_debugDraw;
+		OpenGLText m_text;
+		OpenGLSprites m_sprites;
+		OpenGLTerrain m_terrain;
+		u64 m_frame;
+		std::string m_capturePath;
 	};
 }
 
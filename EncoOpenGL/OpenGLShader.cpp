@@ -0,0 +1,105 @@
+#include "stdafx.h"
+#include "OpenGLShader.h"
+
+#include <vector>
+
+namespace enco {
+	ENCOOPENGLAPI OpenGLShader::OpenGLShader() : m_program(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLShader::~OpenGLShader() {
+	}
+
+	ENCOOPENGLAPI bool OpenGLShader::create(const std::string &vertexSource, const std::string &fragmentSource, const std::string &geometrySource) {
+		GLuint shaders[3] = {
+			compile(GL_VERTEX_SHADER, vertexSource),
+			compile(GL_FRAGMENT_SHADER, fragmentSource),
+			geometrySource.empty() ? 0 : compile(GL_GEOMETRY_SHADER, geometrySource)
+		};
+
+		bool compiled = shaders[0] && shaders[1] && (geometrySource.empty() || shaders[2]);
+		GLuint program = 0;
+		if (compiled) {
+			program = glCreateProgram();
+			for (int i = 0; i < 3; ++i) {
+				if (shaders[i]) {
+					glAttachShader(program, shaders[i]);
+				}
+			}
+			glLinkProgram(program);
+
+			GLint linked = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &linked);
+			if (!linked) {
+#ifdef _DEBUG
+				GLint length = 0;
+				glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+				std::vector<GLchar> log(length + 1);
+				glGetProgramInfoLog(program, length, nullptr, &log[0]);
+				printf("OpenGL Error: Program link failed\n%s\n", &log[0]);
+#endif
+				glDeleteProgram(program);
+				program = 0;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			if (shaders[i]) {
+				glDeleteShader(shaders[i]);
+			}
+		}
+
+		if (!program) {
+			return false;
+		}
+
+		release();
+		m_program = program;
+		return true;
+	}
+
+	ENCOOPENGLAPI void OpenGLShader::release() {
+		if (m_program) {
+			glDeleteProgram(m_program);
+			m_program = 0;
+		}
+		m_uniforms.clear();
+	}
+
+	ENCOOPENGLAPI void OpenGLShader::bind() const {
+		glUseProgram(m_program);
+	}
+
+	ENCOOPENGLAPI GLint OpenGLShader::getUniformLocation(const std::string &name) {
+		std::map<std::string, GLint>::iterator it = m_uniforms.find(name);
+		if (it != m_uniforms.end()) {
+			return it->second;
+		}
+
+		GLint location = glGetUniformLocation(m_program, name.c_str());
+		m_uniforms[name] = location;
+		return location;
+	}
+
+	GLuint OpenGLShader::compile(GLenum type, const std::string &source) {
+		GLuint shader = glCreateShader(type);
+		const GLchar *sourcePointer = source.c_str();
+		glShaderSource(shader, 1, &sourcePointer, nullptr);
+		glCompileShader(shader);
+
+		GLint compiled = GL_FALSE;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+		if (!compiled) {
+#ifdef _DEBUG
+			GLint length = 0;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			std::vector<GLchar> log(length + 1);
+			glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+			printf("OpenGL Error: Shader compilation failed\n%s\n", &log[0]);
+#endif
+			glDeleteShader(shader);
+			return 0;
+		}
+		return shader;
+	}
+}
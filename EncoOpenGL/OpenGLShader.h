@@ -0,0 +1,42 @@
+#ifndef __ENCOOPENGL_OPENGLSHADER_H__
+#define __ENCOOPENGL_OPENGLSHADER_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include <map>
+#include <string>
+
+namespace enco {
+	class OpenGLShader {
+	public:
+		ENCOOPENGLAPI OpenGLShader();
+		ENCOOPENGLAPI ~OpenGLShader();
+
+		// An empty geometry source skips that stage. On failure the previous program is kept.
+		ENCOOPENGLAPI bool create(const std::string &vertexSource, const std::string &fragmentSource, const std::string &geometrySource = "");
+		ENCOOPENGLAPI void release();
+
+		ENCOOPENGLAPI void bind() const;
+
+		// Locations are looked up once and cached, -1 if the uniform does not exist
+		ENCOOPENGLAPI GLint getUniformLocation(const std::string &name);
+
+		inline GLuint getProgram() const { return m_program; }
+		inline bool isValid() const { return m_program != 0; }
+
+	private:
+		OpenGLShader(const OpenGLShader &) = delete;
+		OpenGLShader &operator=(const OpenGLShader &) = delete;
+
+		static GLuint compile(GLenum type, const std::string &source);
+
+		GLuint m_program;
+		std::map<std::string, GLint> m_uniforms;
+	};
+}
+
+#endif
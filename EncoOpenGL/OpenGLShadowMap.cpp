@@ -0,0 +1,197 @@
+#include "stdafx.h"
+#include "OpenGLShadowMap.h"
+
+namespace enco {
+	static const char *s_shadowSource =
+		"uniform sampler2DArrayShadow u_shadowMap;\n"
+		"uniform mat4 u_shadowMatrices[4];\n"
+		"uniform vec4 u_shadowSplits;\n"
+		"uniform int u_shadowCascadeCount;\n"
+		"\n"
+		"float computeShadow(vec3 worldPosition, float viewDepth) {\n"
+		"	if (viewDepth >= u_shadowSplits[u_shadowCascadeCount - 1]) {\n"
+		"		return 1.0;\n"
+		"	}\n"
+		"	int cascade = u_shadowCascadeCount - 1;\n"
+		"	for (int i = 0; i < u_shadowCascadeCount; ++i) {\n"
+		"		if (viewDepth < u_shadowSplits[i]) {\n"
+		"			cascade = i;\n"
+		"			break;\n"
+		"		}\n"
+		"	}\n"
+		"\n"
+		"	vec4 position = u_shadowMatrices[cascade] * vec4(worldPosition, 1.0);\n"
+		"	vec2 texel = 1.0 / vec2(textureSize(u_shadowMap, 0).xy);\n"
+		"	float lit = 0.0;\n"
+		"	for (int y = -1; y <= 1; ++y) {\n"
+		"		for (int x = -1; x <= 1; ++x) {\n"
+		"			lit += texture(u_shadowMap, vec4(position.xy + vec2(x, y) * texel, float(cascade), position.z));\n"
+		"		}\n"
+		"	}\n"
+		"	return lit / 9.0;\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLShadowMap::OpenGLShadowMap() : m_framebuffer(0), m_copyFramebuffer(0), m_texture(0), m_cache(0), m_resolution(0), m_cascadeCount(0), m_drawnCasters(0), m_cachedLayers(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLShadowMap::~OpenGLShadowMap() {
+	}
+
+	ENCOOPENGLAPI bool OpenGLShadowMap::create(uint resolution, uint cascadeCount) {
+		release();
+
+		m_resolution = resolution;
+		m_cascadeCount = cascadeCount;
+		m_texture = createArray(true);
+
+		glGenFramebuffers(1, &m_framebuffer);
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_texture, 0, 0);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+
+		GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		if (status != GL_FRAMEBUFFER_COMPLETE) {
+#ifdef _DEBUG
+			printf("OpenGL Error: Shadow map framebuffer incomplete (0x%x)\n", status);
+#endif
+			release();
+			return false;
+		}
+		return true;
+	}
+
+	ENCOOPENGLAPI void OpenGLShadowMap::release() {
+		if (m_framebuffer) {
+			glDeleteFramebuffers(1, &m_framebuffer);
+		}
+		if (m_copyFramebuffer) {
+			glDeleteFramebuffers(1, &m_copyFramebuffer);
+		}
+		if (m_texture) {
+			glDeleteTextures(1, &m_texture);
+		}
+		if (m_cache) {
+			glDeleteTextures(1, &m_cache);
+		}
+		m_framebuffer = m_copyFramebuffer = m_texture = m_cache = 0;
+		m_resolution = m_cascadeCount = 0;
+		m_cachedLayers = 0;
+	}
+
+	ENCOOPENGLAPI void OpenGLShadowMap::render(const ShadowCascades &cascades, ShadowDrawCallback draw) {
+		m_drawnCasters = 0;
+		if (!m_framebuffer) {
+			return;
+		}
+
+		glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+		glViewport(0, 0, (GLsizei)m_resolution, (GLsizei)m_resolution);
+		glEnable(GL_DEPTH_TEST);
+		glDepthMask(GL_TRUE);
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(1.5f, 4.0f);
+
+		for (uint i = 0; i < cascades.getCascadeCount() && i < m_cascadeCount; ++i) {
+			const ShadowCascade &cascade = cascades.getCascade(i);
+
+			if (cascade.isCached) {
+				if (!m_cache) {
+					m_cache = createArray(false);
+					m_cachedLayers = 0;
+				}
+
+				if (cascade.needsStaticUpdate || (m_cachedLayers & (1u << i)) == 0) {
+					m_cachedLayers |= 1u << i;
+					bindLayer(m_cache, i, true);
+					if (!cascade.staticCasters.empty()) {
+						draw(i, cascade.staticCasters);
+					}
+					m_drawnCasters += (uint)cascade.staticCasters.size();
+				}
+
+				bindLayer(m_texture, i, false);
+				copyLayer(i);
+			}
+			else {
+				bindLayer(m_texture, i, true);
+				if (!cascade.staticCasters.empty()) {
+					draw(i, cascade.staticCasters);
+				}
+				m_drawnCasters += (uint)cascade.staticCasters.size();
+			}
+
+			if (!cascade.dynamicCasters.empty()) {
+				draw(i, cascade.dynamicCasters);
+			}
+			m_drawnCasters += (uint)cascade.dynamicCasters.size();
+		}
+
+		glDisable(GL_POLYGON_OFFSET_FILL);
+	}
+
+	ENCOOPENGLAPI void OpenGLShadowMap::bind(const ShadowCascades &cascades, OpenGLShader &shader, GLuint unit) const {
+		glActiveTexture(GL_TEXTURE0 + unit);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+		glActiveTexture(GL_TEXTURE0);
+
+		glm::mat4 matrices[ShadowCascades::maxCascades];
+		glm::vec4 splits(0.0f);
+		uint count = cascades.getCascadeCount() < m_cascadeCount ? cascades.getCascadeCount() : m_cascadeCount;
+		for (uint i = 0; i < count; ++i) {
+			matrices[i] = cascades.getCascade(i).shadowMatrix;
+			splits[i] = cascades.getCascade(i).splitFar;
+		}
+
+		glUniform1i(shader.getUniformLocation("u_shadowMap"), (GLint)unit);
+		glUniformMatrix4fv(shader.getUniformLocation("u_shadowMatrices"), (GLsizei)count, GL_FALSE, &matrices[0][0][0]);
+		glUniform4fv(shader.getUniformLocation("u_shadowSplits"), 1, &splits[0]);
+		glUniform1i(shader.getUniformLocation("u_shadowCascadeCount"), (GLint)count);
+	}
+
+	ENCOOPENGLAPI const char *OpenGLShadowMap::getShaderSource() {
+		return s_shadowSource;
+	}
+
+	GLuint OpenGLShadowMap::createArray(bool comparison) {
+		GLuint texture = 0;
+		glGenTextures(1, &texture);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32F, (GLsizei)m_resolution, (GLsizei)m_resolution, (GLsizei)m_cascadeCount, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, comparison ? GL_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, comparison ? GL_LINEAR : GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		if (comparison) {
+			// Hardware 2x2 PCF
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+		}
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return texture;
+	}
+
+	void OpenGLShadowMap::bindLayer(GLuint texture, uint layer, bool clear) {
+		glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture, 0, (GLint)layer);
+		if (clear) {
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+	}
+
+	void OpenGLShadowMap::copyLayer(uint layer) {
+		if (GLEW_VERSION_4_3 || GLEW_ARB_copy_image) {
+			glCopyImageSubData(m_cache, GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, m_texture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)layer, (GLsizei)m_resolution, (GLsizei)m_resolution, 1);
+			return;
+		}
+
+		if (!m_copyFramebuffer) {
+			glGenFramebuffers(1, &m_copyFramebuffer);
+		}
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_copyFramebuffer);
+		glFramebufferTextureLayer(GL_READ_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, m_cache, 0, (GLint)layer);
+		glReadBuffer(GL_NONE);
+		glBlitFramebuffer(0, 0, (GLint)m_resolution, (GLint)m_resolution, 0, 0, (GLint)m_resolution, (GLint)m_resolution, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebuffer);
+	}
+}
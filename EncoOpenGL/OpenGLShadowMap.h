@@ -0,0 +1,70 @@
+#ifndef __ENCOOPENGL_OPENGLSHADOWMAP_H__
+#define __ENCOOPENGL_OPENGLSHADOWMAP_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+
+#include <functional>
+#include <vector>
+
+namespace enco {
+	// Draws the given casters (indices into the list passed to ShadowCascades::cull) with the depth-only
+	// shader of the application, the light viewProjection is ShadowCascades::getCascade(cascade).viewProjection
+	typedef std::function<void(uint cascade, const std::vector<u32> &casters)> ShadowDrawCallback;
+
+	// Depth texture array with one layer per cascade. Cached cascades render their static casters into a
+	// second array only when ShadowCascade::needsStaticUpdate is set; every frame that layer is copied into
+	// the sampled array and just the dynamic casters are drawn on top. The copy is glCopyImageSubData() with
+	// OpenGL 4.3 or ARB_copy_image and a depth blit between two framebuffers otherwise. Layers of a cache that
+	// was just (re)created are cleared and rendered regardless of the flag, never copied from stale memory.
+	class OpenGLShadowMap {
+	public:
+		ENCOOPENGLAPI OpenGLShadowMap();
+		ENCOOPENGLAPI ~OpenGLShadowMap();
+
+		ENCOOPENGLAPI bool create(uint resolution, uint cascadeCount);
+		ENCOOPENGLAPI void release();
+
+		// Leaves the shadow framebuffer bound, OpenGLRenderer::renderShadows restores the previous target
+		ENCOOPENGLAPI void render(const ShadowCascades &cascades, ShadowDrawCallback draw);
+
+		// Binds the texture to unit and sets the uniforms used by getShaderSource()
+		ENCOOPENGLAPI void bind(const ShadowCascades &cascades, OpenGLShader &shader, GLuint unit) const;
+
+		ENCOOPENGLAPI static const char *getShaderSource();
+
+		inline GLuint getTexture() const { return m_texture; }
+		inline uint getResolution() const { return m_resolution; }
+		inline uint getCascadeCount() const { return m_cascadeCount; }
+
+		// Caster draws issued by the last render()
+		inline uint getDrawnCasterCount() const { return m_drawnCasters; }
+
+	private:
+		OpenGLShadowMap(const OpenGLShadowMap &) = delete;
+		OpenGLShadowMap &operator=(const OpenGLShadowMap &) = delete;
+
+		GLuint createArray(bool comparison);
+		void bindLayer(GLuint texture, uint layer, bool clear);
+		// Copies a layer of the cache into the same layer of the texture, which is the bound depth attachment
+		void copyLayer(uint layer);
+
+		GLuint m_framebuffer;
+		// Reads the cache for the blit fallback of copyLayer()
+		GLuint m_copyFramebuffer;
+		GLuint m_texture;
+		GLuint m_cache;
+		uint m_resolution;
+		uint m_cascadeCount;
+		uint m_drawnCasters;
+		// Bit i is set once layer i of the cache holds the static casters of cascade i
+		u32 m_cachedLayers;
+	};
+}
+
+#endif
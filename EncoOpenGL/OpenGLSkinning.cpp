@@ -0,0 +1,188 @@
+#include "stdafx.h"
+#include "OpenGLSkinning.h"
+
+#include <cstddef>
+
+namespace enco {
+	static const char *s_skinningSource =
+		"layout(std430, binding = 3) readonly buffer SkinPalettes { vec4 skinPalettes[]; };\n"
+		"\n"
+		"layout(location = 3) in uvec4 a_skinJoints;\n"
+		"layout(location = 4) in vec4 a_skinWeights;\n"
+		"\n"
+		"uniform int u_skinJointCount;\n"
+		"uniform bool u_softwareSkinning;\n"
+		"\n"
+		"// Moves a bind pose vertex to world space, vertices skinned on the CPU already are\n"
+		"void skinVertex(inout vec3 position, inout vec3 normal) {\n"
+		"	if (u_softwareSkinning) {\n"
+		"		return;\n"
+		"	}\n"
+		"\n"
+		"	int base = gl_InstanceID * u_skinJointCount * 3;\n"
+		"	vec4 row0 = vec4(0.0), row1 = vec4(0.0), row2 = vec4(0.0);\n"
+		"	for (int i = 0; i < 4; ++i) {\n"
+		"		if (int(a_skinJoints[i]) >= u_skinJointCount) {\n"
+		"			continue;\n"
+		"		}\n"
+		"		int joint = base + int(a_skinJoints[i]) * 3;\n"
+		"		row0 += skinPalettes[joint] * a_skinWeights[i];\n"
+		"		row1 += skinPalettes[joint + 1] * a_skinWeights[i];\n"
+		"		row2 += skinPalettes[joint + 2] * a_skinWeights[i];\n"
+		"	}\n"
+		"\n"
+		"	vec4 bindPosition = vec4(position, 1.0);\n"
+		"	position = vec3(dot(row0, bindPosition), dot(row1, bindPosition), dot(row2, bindPosition));\n"
+		"	normal = normalize(vec3(dot(row0.xyz, normal), dot(row1.xyz, normal), dot(row2.xyz, normal)));\n"
+		"}\n";
+
+	// Without shader storage buffers every vertex arrives skinned on the CPU
+	static const char *s_softwareSkinningSource =
+		"void skinVertex(inout vec3 position, inout vec3 normal) {\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLSkinning::OpenGLSkinning() : m_offsetAlignment(0), m_softwareVertexArray(0), m_softwareBuffer(0), m_softwareBufferSize(0), m_skinnedVertices(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLSkinning::~OpenGLSkinning() {
+	}
+
+	ENCOOPENGLAPI void OpenGLSkinning::release() {
+		if (m_softwareVertexArray) {
+			glDeleteVertexArrays(1, &m_softwareVertexArray);
+			m_softwareVertexArray = 0;
+		}
+		if (m_softwareBuffer) {
+			glDeleteBuffers(1, &m_softwareBuffer);
+			m_softwareBuffer = 0;
+		}
+		m_softwareBufferSize = 0;
+		m_offsetAlignment = 0;
+	}
+
+	ENCOOPENGLAPI bool OpenGLSkinning::draw(const OpenGLMesh &mesh, const AnimationInstance *instances, uint count, OpenGLShader &shader, uint lod, OpenGLStreamBuffer &streamBuffer) {
+		if (count == 0 || !mesh.isSkinned() || !instances[0].skeleton || !isSupported()) {
+			return false;
+		}
+
+		if (m_offsetAlignment == 0) {
+			glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &m_offsetAlignment);
+			if (m_offsetAlignment <= 0) {
+				m_offsetAlignment = 256;
+			}
+		}
+
+		uint jointCount = instances[0].skeleton->getJointCount();
+		GLsizeiptr size = (GLsizeiptr)count * jointCount * 3 * sizeof(glm::vec4);
+		OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(size, m_offsetAlignment);
+		if (!allocation.data) {
+			return false;
+		}
+
+		// Only the top three rows of the affine palette matrices are needed
+		f32 *rows = (f32 *)allocation.data;
+		for (uint i = 0; i < count; ++i) {
+			const std::vector<glm::mat4> &palette = instances[i].palette;
+			for (uint joint = 0; joint < jointCount; ++joint) {
+				const glm::mat4 &matrix = joint < palette.size() ? palette[joint] : glm::mat4(1.0f);
+				for (int row = 0; row < 3; ++row) {
+					rows[0] = matrix[0][row];
+					rows[1] = matrix[1][row];
+					rows[2] = matrix[2][row];
+					rows[3] = matrix[3][row];
+					rows += 4;
+				}
+			}
+		}
+		streamBuffer.flush();
+
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, paletteBinding, streamBuffer.getBuffer(), allocation.offset, size);
+		glUniform1i(shader.getUniformLocation("u_skinJointCount"), (GLint)jointCount);
+		glUniform1i(shader.getUniformLocation("u_softwareSkinning"), 0);
+		mesh.draw(lod, count);
+		return true;
+	}
+
+	ENCOOPENGLAPI bool OpenGLSkinning::drawSoftware(const OpenGLMesh &mesh, const MeshData &data, const AnimationInstance *instances, uint count, OpenGLShader &shader, uint lod, JobSystem *jobSystem) {
+		if (count == 0 || !data.isSkinned() || !mesh.getIndexBuffer() || mesh.getVertexCount() != data.vertices.size()) {
+			return false;
+		}
+
+		if (!m_softwareVertexArray) {
+			glGenBuffers(1, &m_softwareBuffer);
+			glGenVertexArrays(1, &m_softwareVertexArray);
+			glBindVertexArray(m_softwareVertexArray);
+			glEnableVertexAttribArray(0);
+			glEnableVertexAttribArray(1);
+			glEnableVertexAttribArray(2);
+			glBindVertexArray(0);
+		}
+
+		// Skinned vertices of a crowd easily exceed the stream buffer, so they go to a buffer of their own that is
+		// orphaned on every call instead of synchronizing with the draws of the previous one
+		GLsizeiptr instanceSize = (GLsizeiptr)(data.vertices.size() * sizeof(MeshVertex));
+		GLsizeiptr size = instanceSize * count;
+		glBindBuffer(GL_ARRAY_BUFFER, m_softwareBuffer);
+		if (m_softwareBufferSize < size) {
+			m_softwareBufferSize = size;
+		}
+		glBufferData(GL_ARRAY_BUFFER, m_softwareBufferSize, nullptr, GL_STREAM_DRAW);
+		u8 *vertices = (u8 *)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (!vertices) {
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			return false;
+		}
+
+		if (jobSystem && count > 1) {
+			jobSystem->parallelFor(count, 1, [&data, instances, vertices, instanceSize](uint begin, uint end) {
+				for (uint i = begin; i < end; ++i) {
+					if (!instances[i].palette.empty()) {
+						Skinning::skin(data, &instances[i].palette[0], (uint)instances[i].palette.size(), (MeshVertex *)(vertices + instanceSize * i));
+					}
+				}
+			});
+		}
+		else {
+			for (uint i = 0; i < count; ++i) {
+				if (!instances[i].palette.empty()) {
+					Skinning::skin(data, &instances[i].palette[0], (uint)instances[i].palette.size(), (MeshVertex *)(vertices + instanceSize * i), jobSystem);
+				}
+			}
+		}
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+
+		glUniform1i(shader.getUniformLocation("u_softwareSkinning"), 1);
+		glBindVertexArray(m_softwareVertexArray);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.getIndexBuffer());
+
+		// Base vertex draws need GL 3.2, so the attributes are pointed at each instance instead
+		const MeshLod &range = mesh.getLod(lod);
+		for (uint i = 0; i < count; ++i) {
+			if (instances[i].palette.empty()) {
+				continue;
+			}
+
+			size_t base = (size_t)instanceSize * i;
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void *)(base + offsetof(MeshVertex, position)));
+			glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void *)(base + offsetof(MeshVertex, normal)));
+			glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MeshVertex), (const void *)(base + offsetof(MeshVertex, texCoord)));
+			glDrawElements(GL_TRIANGLES, (GLsizei)range.indexCount, GL_UNSIGNED_INT, (const void *)(range.indexOffset * sizeof(u32)));
+			m_skinnedVertices += data.vertices.size();
+		}
+		glBindVertexArray(0);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return true;
+	}
+
+	ENCOOPENGLAPI const char *OpenGLSkinning::getShaderSource() {
+		return s_skinningSource;
+	}
+
+	ENCOOPENGLAPI const char *OpenGLSkinning::getSoftwareShaderSource() {
+		return s_softwareSkinningSource;
+	}
+
+	ENCOOPENGLAPI bool OpenGLSkinning::isSupported() {
+		return GLEW_VERSION_4_3 || GLEW_ARB_shader_storage_buffer_object;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#ifndef __ENCOOPENGL_OPENGLSKINNING_H__
+#define __ENCOOPENGL_OPENGLSKINNING_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLMesh.h"
+#include "OpenGLShader.h"
+#include "OpenGLStreamBuffer.h"
+
+namespace enco {
+	// Draws many characters that share a skinned mesh. On the GPU path the palettes of all of them are streamed
+	// into one shader storage buffer as three rows per joint and drawn with a single instanced draw, the
+	// vertex shader prepends getShaderSource() and calls skinVertex(). The software path skins every instance
+	// on the CPU into a vertex buffer instead and the same shader passes the vertices through. Contexts without
+	// shader storage buffers (isSupported()) cannot compile getShaderSource() and only have the software path,
+	// their shaders prepend getSoftwareShaderSource() instead.
+	class OpenGLSkinning {
+	public:
+		static const GLuint paletteBinding = 3;
+
+		ENCOOPENGLAPI OpenGLSkinning();
+		ENCOOPENGLAPI ~OpenGLSkinning();
+
+		ENCOOPENGLAPI void release();
+
+		// All instances need the skeleton the mesh was skinned to and an up to date palette
+		ENCOOPENGLAPI bool draw(const OpenGLMesh &mesh, const AnimationInstance *instances, uint count, OpenGLShader &shader, uint lod, OpenGLStreamBuffer &streamBuffer);
+		ENCOOPENGLAPI bool drawSoftware(const OpenGLMesh &mesh, const MeshData &data, const AnimationInstance *instances, uint count, OpenGLShader &shader, uint lod, JobSystem *jobSystem);
+
+		ENCOOPENGLAPI static const char *getShaderSource();
+		ENCOOPENGLAPI static const char *getSoftwareShaderSource();
+		ENCOOPENGLAPI static bool isSupported();
+
+		inline u64 getSkinnedVertexCount() const { return m_skinnedVertices; }
+
+	private:
+		OpenGLSkinning(const OpenGLSkinning &) = delete;
+		OpenGLSkinning &operator=(const OpenGLSkinning &) = delete;
+
+		GLint m_offsetAlignment;
+		GLuint m_softwareVertexArray;
+		GLuint m_softwareBuffer;
+		GLsizeiptr m_softwareBufferSize;
+		u64 m_skinnedVertices;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "stdafx.h"
+#include "OpenGLSprites.h"
+
+#include <cstddef>
+
+namespace enco {
+	static const char *s_vertexSource =
+		"#version 430\n"
+		"\n"
+		"layout(location = 0) in vec2 a_center;\n"
+		"layout(location = 1) in vec2 a_size;\n"
+		"layout(location = 2) in float a_rotation;\n"
+		"layout(location = 3) in vec4 a_texels;\n"
+		"layout(location = 4) in vec4 a_color;\n"
+		"\n"
+		"uniform vec2 u_pixelSize;\n"
+		"uniform float u_texelSize;\n"
+		"\n"
+		"out vec2 v_texCoord;\n"
+		"out vec4 v_color;\n"
+		"\n"
+		"void main() {\n"
+		"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+		"	vec2 offset = (corner - 0.5) * a_size;\n"
+		"	float c = cos(a_rotation), s = sin(a_rotation);\n"
+		"	vec2 position = (a_center + vec2(c * offset.x - s * offset.y, s * offset.x + c * offset.y)) * u_pixelSize;\n"
+		"	v_texCoord = mix(a_texels.xy, a_texels.zw, corner) * u_texelSize;\n"
+		"	v_color = a_color;\n"
+		"	gl_Position = vec4(position.x * 2.0 - 1.0, 1.0 - position.y * 2.0, 0.0, 1.0);\n"
+		"}\n";
+
+	static const char *s_fragmentSource =
+		"#version 430\n"
+		"\n"
+		"uniform sampler2D u_atlas;\n"
+		"\n"
+		"in vec2 v_texCoord;\n"
+		"in vec4 v_color;\n"
+		"out vec4 f_color;\n"
+		"\n"
+		"void main() {\n"
+		"	f_color = texture(u_atlas, v_texCoord) * v_color;\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLSprites::OpenGLSprites() : m_vertexArray(0), m_atlas(nullptr), m_generation(0), m_drawCalls(0), m_droppedSprites(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLSprites::~OpenGLSprites() {
+	}
+
+	ENCOOPENGLAPI void OpenGLSprites::release() {
+		m_shader.release();
+		if (m_vertexArray) {
+			glDeleteVertexArrays(1, &m_vertexArray);
+			m_vertexArray = 0;
+		}
+		releasePages();
+		m_atlas = nullptr;
+	}
+
+	ENCOOPENGLAPI bool OpenGLSprites::draw(SpriteBatch &batch, uint viewportWidth, uint viewportHeight, OpenGLStreamBuffer &streamBuffer) {
+		m_drawCalls = 0;
+		if (!m_vertexArray && !initialize()) {
+			return false;
+		}
+
+		upload(batch.getAtlas());
+
+		uint count = batch.getCount();
+		if (count == 0) {
+			return true;
+		}
+
+		OpenGLStreamBuffer::Allocation instances = streamBuffer.allocate(count * sizeof(SpriteInstance), sizeof(SpriteInstance));
+		if (!instances.data) {
+			m_droppedSprites += count;
+			return false;
+		}
+		batch.sort();
+		batch.gather((SpriteInstance *)instances.data);
+		streamBuffer.flush();
+
+		m_shader.bind();
+		glUniform2f(m_shader.getUniformLocation("u_pixelSize"), 1.0f / (viewportWidth ? viewportWidth : 1), 1.0f / (viewportHeight ? viewportHeight : 1));
+		glUniform1f(m_shader.getUniformLocation("u_texelSize"), 1.0f / batch.getAtlas().getPageSize());
+		glUniform1i(m_shader.getUniformLocation("u_atlas"), 0);
+		glBindVertexArray(m_vertexArray);
+		glBindVertexBuffer(0, streamBuffer.getBuffer(), instances.offset, sizeof(SpriteInstance));
+
+		GLboolean blend = glIsEnabled(GL_BLEND);
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+
+		const std::vector<SpriteDraw> &draws = batch.getDraws();
+		for (size_t i = 0; i < draws.size(); ++i) {
+			if (draws[i].page >= m_pages.size()) {
+				continue;
+			}
+			glBindTexture(GL_TEXTURE_2D, m_pages[draws[i].page]);
+			glDrawArraysInstancedBaseInstance(GL_TRIANGLE_STRIP, 0, 4, (GLsizei)draws[i].count, draws[i].first);
+			++m_drawCalls;
+		}
+
+		if (depthTest) {
+			glEnable(GL_DEPTH_TEST);
+		}
+		if (!blend) {
+			glDisable(GL_BLEND);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindVertexArray(0);
+		return true;
+	}
+
+	bool OpenGLSprites::initialize() {
+		if (!m_shader.create(s_vertexSource, s_fragmentSource)) {
+			return false;
+		}
+
+		glGenVertexArrays(1, &m_vertexArray);
+		glBindVertexArray(m_vertexArray);
+		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, center));
+		glVertexAttribBinding(0, 0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, size));
+		glVertexAttribBinding(1, 0);
+		glEnableVertexAttribArray(2);
+		glVertexAttribFormat(2, 1, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, rotation));
+		glVertexAttribBinding(2, 0);
+		glEnableVertexAttribArray(3);
+		glVertexAttribFormat(3, 4, GL_UNSIGNED_SHORT, GL_FALSE, offsetof(SpriteInstance, texels));
+		glVertexAttribBinding(3, 0);
+		glEnableVertexAttribArray(4);
+		glVertexAttribFormat(4, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(SpriteInstance, color));
+		glVertexAttribBinding(4, 0);
+		glVertexBindingDivisor(0, 1);
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	void OpenGLSprites::upload(SpriteAtlas &atlas) {
+		if (m_atlas != &atlas || m_generation != atlas.getGeneration()) {
+			releasePages();
+			m_atlas = &atlas;
+			m_generation = atlas.getGeneration();
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+
+		// New pages are uploaded whole, which covers their dirty rectangles as well
+		uint known = (uint)m_pages.size();
+		GLsizei size = (GLsizei)atlas.getPageSize();
+		for (uint page = known; page < atlas.getPageCount(); ++page) {
+			GLuint texture;
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, atlas.getPageData(page));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			m_pages.push_back(texture);
+		}
+
+		const std::vector<SpriteAtlas::DirtyRect> &dirty = atlas.getDirtyRects();
+		if (!dirty.empty()) {
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, size);
+			for (size_t i = 0; i < dirty.size(); ++i) {
+				if (dirty[i].page < known) {
+					glBindTexture(GL_TEXTURE_2D, m_pages[dirty[i].page]);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, dirty[i].x, dirty[i].y, dirty[i].width, dirty[i].height, GL_RGBA, GL_UNSIGNED_BYTE, atlas.getPageData(dirty[i].page) + ((size_t)dirty[i].y * size + dirty[i].x) * 4);
+				}
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		}
+		atlas.clearDirtyRects();
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	void OpenGLSprites::releasePages() {
+		if (!m_pages.empty()) {
+			glDeleteTextures((GLsizei)m_pages.size(), &m_pages[0]);
+			m_pages.clear();
+		}
+	}
+}
\ No newline at end of file
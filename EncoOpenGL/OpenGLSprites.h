@@ -0,0 +1,51 @@
+#ifndef __ENCOOPENGL_OPENGLSPRITES_H__
+#define __ENCOOPENGL_OPENGLSPRITES_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+#include "OpenGLStreamBuffer.h"
+
+#include <vector>
+
+namespace enco {
+	// Mirrors the pages of a SpriteAtlas in textures and draws a SpriteBatch from the stream buffer with one
+	// instanced draw per run of sprites that share a page
+	class OpenGLSprites {
+	public:
+		ENCOOPENGLAPI OpenGLSprites();
+		ENCOOPENGLAPI ~OpenGLSprites();
+
+		ENCOOPENGLAPI void release();
+
+		// Sorts the batch, uploads what changed in its atlas and draws on top of the bound target
+		ENCOOPENGLAPI bool draw(SpriteBatch &batch, uint viewportWidth, uint viewportHeight, OpenGLStreamBuffer &streamBuffer);
+
+		inline uint getDrawCallCount() const { return m_drawCalls; }
+		// Sprites that did not fit into the stream buffer
+		inline u64 getDroppedSpriteCount() const { return m_droppedSprites; }
+
+	private:
+		OpenGLSprites(const OpenGLSprites &) = delete;
+		OpenGLSprites &operator=(const OpenGLSprites &) = delete;
+
+		bool initialize();
+		void upload(SpriteAtlas &atlas);
+		void releasePages();
+
+		OpenGLShader m_shader;
+		GLuint m_vertexArray;
+		// Textures of the pages of m_atlas as of m_generation
+		const SpriteAtlas *m_atlas;
+		u32 m_generation;
+		std::vector<GLuint> m_pages;
+		uint m_drawCalls;
+		u64 m_droppedSprites;
+	};
+}
+
+#endif
\ No newline at end of file
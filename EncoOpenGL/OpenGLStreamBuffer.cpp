@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "OpenGLStreamBuffer.h"
+
+namespace enco {
+	namespace {
+		inline bool hasSync() {
+			return GLEW_VERSION_3_2 || GLEW_ARB_sync;
+		}
+	}
+
+	ENCOOPENGLAPI OpenGLStreamBuffer::OpenGLStreamBuffer() : m_buffer(0), m_frameSize(0), m_mapped(nullptr), m_region(0), m_head(0), m_flushed(0), m_stalls(0), m_failedAllocations(0) {
+		for (uint i = 0; i < frameCount; ++i) {
+			m_fences[i] = nullptr;
+		}
+	}
+
+	ENCOOPENGLAPI OpenGLStreamBuffer::~OpenGLStreamBuffer() {
+	}
+
+	ENCOOPENGLAPI bool OpenGLStreamBuffer::create(GLsizeiptr frameSize) {
+		release();
+
+		// Regions start on a 256 byte boundary, which satisfies every uniform and storage buffer offset alignment
+		m_frameSize = (frameSize + 255) / 256 * 256;
+		GLsizeiptr size = m_frameSize * frameCount;
+
+		glGenBuffers(1, &m_buffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+
+		// A persistent mapping is only safe to write while fences tell which regions the GPU is done with
+		if (GLEW_ARB_buffer_storage && hasSync()) {
+			GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+			glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+			m_mapped = (u8 *)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+
+			if (!m_mapped) {
+				// Immutable storage can not be respecified by glBufferData(), the fallback needs a new buffer.
+				// The error of the failed mapping is discarded so it does not fail create().
+				glGetError();
+				glDeleteBuffers(1, &m_buffer);
+				glGenBuffers(1, &m_buffer);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+			}
+		}
+		if (!m_mapped) {
+			glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+			m_staging.resize((size_t)m_frameSize);
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+		m_region = 0;
+		m_head = m_flushed = 0;
+		return glGetError() == GL_NO_ERROR;
+	}
+
+	ENCOOPENGLAPI void OpenGLStreamBuffer::release() {
+		for (uint i = 0; i < frameCount; ++i) {
+			if (m_fences[i]) {
+				glDeleteSync(m_fences[i]);
+				m_fences[i] = nullptr;
+			}
+		}
+
+		if (m_buffer) {
+			if (m_mapped) {
+				glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+				glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			}
+			glDeleteBuffers(1, &m_buffer);
+		}
+
+		m_buffer = 0;
+		m_mapped = nullptr;
+		m_staging.clear();
+		m_frameSize = 0;
+	}
+
+	ENCOOPENGLAPI void OpenGLStreamBuffer::beginFrame() {
+		GLsync &fence = m_fences[m_region];
+		if (fence) {
+			if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED) {
+				++m_stalls;
+				glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+			}
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+
+		m_head = m_flushed = 0;
+	}
+
+	ENCOOPENGLAPI void OpenGLStreamBuffer::endFrame() {
+		if (!m_buffer) {
+			return;
+		}
+
+		flush();
+		if (hasSync()) {
+			m_fences[m_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+		m_region = (m_region + 1) % frameCount;
+	}
+
+	ENCOOPENGLAPI OpenGLStreamBuffer::Allocation OpenGLStreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+		Allocation allocation;
+
+		GLsizeiptr start = (m_head + alignment - 1) / alignment * alignment;
+		if (!m_buffer || start + size > m_frameSize) {
+			++m_failedAllocations;
+#ifdef _DEBUG
+			printf("OpenGL Error: Stream buffer region of %d bytes exhausted\n", (int)m_frameSize);
+#endif
+			return allocation;
+		}
+
+		allocation.offset = m_region * m_frameSize + start;
+		allocation.size = size;
+		allocation.data = m_mapped ? m_mapped + allocation.offset : &m_staging[(size_t)start];
+
+		m_head = start + size;
+		return allocation;
+	}
+
+	ENCOOPENGLAPI void OpenGLStreamBuffer::flush() {
+		if (m_mapped || m_flushed == m_head) {
+			m_flushed = m_head;
+			return;
+		}
+
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, m_region * m_frameSize + m_flushed, m_head - m_flushed, &m_staging[(size_t)m_flushed]);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_flushed = m_head;
+	}
+}
@@ -0,0 +1,72 @@
+#ifndef __ENCOOPENGL_OPENGLSTREAMBUFFER_H__
+#define __ENCOOPENGL_OPENGLSTREAMBUFFER_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include <vector>
+
+namespace enco {
+	// One buffer split into a region per frame in flight for data that is rewritten every frame.
+	// With ARB_buffer_storage the buffer stays persistently mapped and writes go straight to it,
+	// otherwise they are staged in system memory and uploaded by flush(). A fence per region makes
+	// beginFrame() wait only if the GPU still reads the region from frameCount frames ago. Contexts
+	// without OpenGL 3.2 or ARB_sync have no fences and always stage, glBufferSubData() synchronizes.
+	class OpenGLStreamBuffer {
+	public:
+		static const uint frameCount = 3;
+
+		struct Allocation {
+			void *data;
+			GLintptr offset;
+			GLsizeiptr size;
+
+			inline Allocation() : data(nullptr), offset(0), size(0) {  }
+		};
+
+		ENCOOPENGLAPI OpenGLStreamBuffer();
+		ENCOOPENGLAPI ~OpenGLStreamBuffer();
+
+		// frameSize bytes are available per frame
+		ENCOOPENGLAPI bool create(GLsizeiptr frameSize);
+		ENCOOPENGLAPI void release();
+
+		ENCOOPENGLAPI void beginFrame();
+		ENCOOPENGLAPI void endFrame();
+
+		// data is nullptr when the region of this frame is exhausted
+		ENCOOPENGLAPI Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+
+		// Makes everything allocated so far visible to the GPU, call before drawing with it
+		ENCOOPENGLAPI void flush();
+
+		inline GLuint getBuffer() const { return m_buffer; }
+		inline GLsizeiptr getFrameSize() const { return m_frameSize; }
+		inline bool isPersistent() const { return m_mapped != nullptr; }
+
+		inline u64 getStallCount() const { return m_stalls; }
+		inline u64 getFailedAllocationCount() const { return m_failedAllocations; }
+
+	private:
+		OpenGLStreamBuffer(const OpenGLStreamBuffer &) = delete;
+		OpenGLStreamBuffer &operator=(const OpenGLStreamBuffer &) = delete;
+
+		GLuint m_buffer;
+		GLsizeiptr m_frameSize;
+		u8 *m_mapped;
+		TaggedVector<u8, rendererMemory> m_staging;
+
+		GLsync m_fences[frameCount];
+		uint m_region;
+		GLsizeiptr m_head;
+		GLsizeiptr m_flushed;
+
+		u64 m_stalls;
+		u64 m_failedAllocations;
+	};
+}
+
+#endif
@@ -0,0 +1,282 @@
+#include "stdafx.h"
+#include "OpenGLTerrain.h"
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace enco {
+	static const char *s_terrainVertexSource =
+		"#version 430\n"
+		"\n"
+		"layout(location = 0) in vec3 a_grid;\n"
+		"layout(location = 1) in vec4 a_placement;\n"
+		"layout(location = 2) in vec2 a_texelOffset;\n"
+		"layout(location = 3) in vec2 a_morph;\n"
+		"layout(location = 4) in vec2 a_height;\n"
+		"\n"
+		"uniform mat4 u_viewProjection;\n"
+		"uniform vec3 u_camera;\n"
+		"uniform float u_gridSize;\n"
+		"uniform float u_resolution;\n"
+		"uniform float u_skirtDepth;\n"
+		"uniform sampler2DArray u_heights;\n"
+		"\n"
+		"out vec3 v_normal;\n"
+		"out vec2 v_texel;\n"
+		"flat out float v_page;\n"
+		"\n"
+		"float sampleHeight(vec2 texel) {\n"
+		"	return textureLod(u_heights, vec3((texel + 0.5) / u_resolution, a_placement.w), 0.0).r;\n"
+		"}\n"
+		"\n"
+		"void main() {\n"
+		"	float cell = a_placement.z / u_gridSize;\n"
+		"	vec2 grid = a_grid.xy;\n"
+		"	vec2 world = a_placement.xy + grid * cell;\n"
+		"	float height = a_height.x + sampleHeight(a_texelOffset + grid) * a_height.y;\n"
+		"\n"
+		"	// Odd vertices slide onto their even neighbors, fully morphed the grid has half the resolution\n"
+		"	float morph = clamp((distance(vec3(world.x, height, world.y), u_camera) - a_morph.x) / (a_morph.y - a_morph.x), 0.0, 1.0);\n"
+		"	grid -= fract(grid * 0.5) * 2.0 * morph;\n"
+		"	vec2 texel = a_texelOffset + grid;\n"
+		"	world = a_placement.xy + grid * cell;\n"
+		"	height = a_height.x + sampleHeight(texel) * a_height.y;\n"
+		"\n"
+		"	float left = sampleHeight(texel - vec2(1.0, 0.0)), right = sampleHeight(texel + vec2(1.0, 0.0));\n"
+		"	float back = sampleHeight(texel - vec2(0.0, 1.0)), front = sampleHeight(texel + vec2(0.0, 1.0));\n"
+		"	v_normal = vec3((left - right) * a_height.y, 2.0 * cell, (back - front) * a_height.y);\n"
+		"	v_texel = texel;\n"
+		"	v_page = a_placement.w;\n"
+		"\n"
+		"	gl_Position = u_viewProjection * vec4(world.x, height - a_grid.z * u_skirtDepth, world.y, 1.0);\n"
+		"}\n";
+
+	static const char *s_terrainFragmentSource =
+		"#version 430\n"
+		"\n"
+		"uniform usampler2DArray u_materials;\n"
+		"uniform vec3 u_materialColors[16];\n"
+		"uniform vec3 u_lightDirection;\n"
+		"\n"
+		"in vec3 v_normal;\n"
+		"in vec2 v_texel;\n"
+		"flat in float v_page;\n"
+		"\n"
+		"out vec4 f_color;\n"
+		"\n"
+		"void main() {\n"
+		"	uint material = texelFetch(u_materials, ivec3(ivec2(v_texel + 0.5), int(v_page + 0.5)), 0).r;\n"
+		"	float light = max(dot(normalize(v_normal), u_lightDirection), 0.0) * 0.8 + 0.2;\n"
+		"	f_color = vec4(u_materialColors[material & 15u] * light, 1.0);\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLTerrain::OpenGLTerrain() : m_vertexArray(0), m_gridBuffer(0), m_indexBuffer(0), m_indexCount(0), m_terrain(nullptr), m_heights(0), m_materials(0), m_tileResolution(0), m_pageCount(0), m_lightDirection(glm::normalize(glm::vec3(0.3f, 1.0f, 0.2f))), m_skirtDepth(8.0f), m_drawnInstances(0), m_uploadedTiles(0) {
+		for (uint i = 0; i < maxMaterials; ++i) {
+			m_materialColors[i] = glm::vec3(0.5f);
+		}
+	}
+
+	ENCOOPENGLAPI OpenGLTerrain::~OpenGLTerrain() {
+	}
+
+	ENCOOPENGLAPI void OpenGLTerrain::release() {
+		m_shader.release();
+		if (m_vertexArray) {
+			glDeleteVertexArrays(1, &m_vertexArray);
+			m_vertexArray = 0;
+		}
+		releaseResources();
+	}
+
+	ENCOOPENGLAPI bool OpenGLTerrain::draw(Terrain &terrain, const glm::mat4 &viewProjection, OpenGLStreamBuffer &streamBuffer) {
+		if (!m_vertexArray && !initialize()) {
+			return false;
+		}
+
+		// Another terrain, or one with other settings, starts over with every resident tile
+		const TerrainSettings &settings = terrain.getSettings();
+		if (m_terrain != &terrain || m_tileResolution != settings.tileResolution || m_pageCount != settings.pageCount) {
+			createResources(settings);
+			m_terrain = &terrain;
+			for (u32 page = 0; page < m_pageCount; ++page) {
+				upload(terrain, page);
+			}
+		}
+		else {
+			const std::vector<u32> &uploads = terrain.getUploads();
+			for (size_t i = 0; i < uploads.size(); ++i) {
+				upload(terrain, uploads[i]);
+			}
+		}
+		terrain.clearUploads();
+
+		const std::vector<TerrainInstance> &instances = terrain.getInstances();
+		if (instances.empty()) {
+			return true;
+		}
+
+		OpenGLStreamBuffer::Allocation allocation = streamBuffer.allocate(instances.size() * sizeof(TerrainInstance));
+		if (!allocation.data) {
+			return false;
+		}
+		memcpy(allocation.data, &instances[0], instances.size() * sizeof(TerrainInstance));
+		streamBuffer.flush();
+
+		m_shader.bind();
+		glUniformMatrix4fv(m_shader.getUniformLocation("u_viewProjection"), 1, GL_FALSE, &viewProjection[0][0]);
+		glUniform3fv(m_shader.getUniformLocation("u_camera"), 1, &terrain.getCameraPosition()[0]);
+		glUniform1f(m_shader.getUniformLocation("u_gridSize"), (f32)((m_tileResolution - 1) / 2));
+		glUniform1f(m_shader.getUniformLocation("u_resolution"), (f32)m_tileResolution);
+		glUniform1f(m_shader.getUniformLocation("u_skirtDepth"), m_skirtDepth);
+		glUniform3fv(m_shader.getUniformLocation("u_lightDirection"), 1, &m_lightDirection[0]);
+		glUniform3fv(m_shader.getUniformLocation("u_materialColors"), maxMaterials, &m_materialColors[0][0]);
+		glUniform1i(m_shader.getUniformLocation("u_heights"), 0);
+		glUniform1i(m_shader.getUniformLocation("u_materials"), 1);
+
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_heights);
+		glActiveTexture(GL_TEXTURE1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_materials);
+
+		glBindVertexArray(m_vertexArray);
+		glBindVertexBuffer(1, streamBuffer.getBuffer(), allocation.offset, sizeof(TerrainInstance));
+		glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, nullptr, (GLsizei)instances.size());
+		m_drawnInstances += instances.size();
+		glBindVertexArray(0);
+
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		return true;
+	}
+
+	bool OpenGLTerrain::initialize() {
+		if (!m_shader.create(s_terrainVertexSource, s_terrainFragmentSource)) {
+			return false;
+		}
+
+		glGenVertexArrays(1, &m_vertexArray);
+		glBindVertexArray(m_vertexArray);
+		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
+		glVertexAttribBinding(0, 0);
+
+		glEnableVertexAttribArray(1);
+		glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, offsetof(TerrainInstance, offset));
+		glVertexAttribBinding(1, 1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribFormat(2, 2, GL_FLOAT, GL_FALSE, offsetof(TerrainInstance, texelOffset));
+		glVertexAttribBinding(2, 1);
+		glEnableVertexAttribArray(3);
+		glVertexAttribFormat(3, 2, GL_FLOAT, GL_FALSE, offsetof(TerrainInstance, morph));
+		glVertexAttribBinding(3, 1);
+		glEnableVertexAttribArray(4);
+		glVertexAttribFormat(4, 2, GL_FLOAT, GL_FALSE, offsetof(TerrainInstance, height));
+		glVertexAttribBinding(4, 1);
+		glVertexBindingDivisor(1, 1);
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	void OpenGLTerrain::createResources(const TerrainSettings &settings) {
+		releaseResources();
+		m_tileResolution = settings.tileResolution;
+		m_pageCount = settings.pageCount;
+
+		// A quarter tile, with an extra ring of vertices around it that is clamped onto the edge and lowered by the
+		// skirt depth. Triangles wind counter-clockwise seen from above, the skirts face outwards.
+		int size = (int)(m_tileResolution - 1) / 2;
+		int side = size + 3;
+		std::vector<f32> vertices;
+		vertices.reserve(side * side * 3);
+		for (int z = -1; z <= size + 1; ++z) {
+			for (int x = -1; x <= size + 1; ++x) {
+				vertices.push_back((f32)glm::clamp(x, 0, size));
+				vertices.push_back((f32)glm::clamp(z, 0, size));
+				vertices.push_back(x < 0 || z < 0 || x > size || z > size ? 1.0f : 0.0f);
+			}
+		}
+
+		std::vector<u32> indices;
+		indices.reserve((side - 1) * (side - 1) * 6);
+		for (int z = 0; z + 1 < side; ++z) {
+			for (int x = 0; x + 1 < side; ++x) {
+				u32 corner = (u32)(z * side + x);
+				u32 quad[6] = { corner, corner + side, corner + 1, corner + 1, corner + side, corner + side + 1 };
+				indices.insert(indices.end(), quad, quad + 6);
+			}
+		}
+		m_indexCount = (GLsizei)indices.size();
+
+		glGenBuffers(1, &m_gridBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, m_gridBuffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(f32), &vertices[0], GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glBindVertexArray(m_vertexArray);
+		glGenBuffers(1, &m_indexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(u32), &indices[0], GL_STATIC_DRAW);
+		glBindVertexBuffer(0, m_gridBuffer, 0, 3 * sizeof(f32));
+		glBindVertexArray(0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		// Heights are filtered so morphing vertices glide between samples, materials are indices and are not
+		GLsizei resolution = (GLsizei)m_tileResolution, layers = (GLsizei)m_pageCount;
+		glGenTextures(1, &m_heights);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_heights);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R16, resolution, resolution, layers, 0, GL_RED, GL_UNSIGNED_SHORT, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glGenTextures(1, &m_materials);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_materials);
+		glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8UI, resolution, resolution, layers, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	}
+
+	void OpenGLTerrain::releaseResources() {
+		if (m_gridBuffer) {
+			glDeleteBuffers(1, &m_gridBuffer);
+		}
+		if (m_indexBuffer) {
+			glDeleteBuffers(1, &m_indexBuffer);
+		}
+		if (m_heights) {
+			glDeleteTextures(1, &m_heights);
+		}
+		if (m_materials) {
+			glDeleteTextures(1, &m_materials);
+		}
+		m_gridBuffer = m_indexBuffer = m_heights = m_materials = 0;
+		m_indexCount = 0;
+		m_tileResolution = m_pageCount = 0;
+		m_terrain = nullptr;
+	}
+
+	void OpenGLTerrain::upload(const Terrain &terrain, u32 page) {
+		const TerrainTile *tile = terrain.getPageTile(page);
+		if (!tile || page >= m_pageCount) {
+			return;
+		}
+
+		// Rows of an odd number of samples are not 4 byte aligned
+		GLsizei resolution = (GLsizei)m_tileResolution;
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_heights);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)page, resolution, resolution, 1, GL_RED, GL_UNSIGNED_SHORT, &tile->heights[0]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_materials);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)page, resolution, resolution, 1, GL_RED_INTEGER, GL_UNSIGNED_BYTE, &tile->materials[0]);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		++m_uploadedTiles;
+	}
+}
\ No newline at end of file
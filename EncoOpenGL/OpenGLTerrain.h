@@ -0,0 +1,69 @@
+#ifndef __ENCOOPENGL_OPENGLTERRAIN_H__
+#define __ENCOOPENGL_OPENGLTERRAIN_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+#include "OpenGLStreamBuffer.h"
+
+namespace enco {
+	// Draws the tiles a Terrain selected with one instanced draw of a single grid. Resident tiles live in the
+	// layers of a height and a material texture array, the vertex shader reads the heights and morphs the grid
+	// between levels so nothing pops. A skirt around each grid hides cracks while parents stand in for tiles
+	// that are still loading.
+	class OpenGLTerrain {
+	public:
+		static const uint maxMaterials = 16;
+
+		ENCOOPENGLAPI OpenGLTerrain();
+		ENCOOPENGLAPI ~OpenGLTerrain();
+
+		ENCOOPENGLAPI void release();
+
+		// Towards the light
+		inline void setLightDirection(const glm::vec3 &direction) { m_lightDirection = glm::normalize(direction); }
+		inline void setMaterialColor(uint material, const glm::vec3 &color) { m_materialColors[material % maxMaterials] = color; }
+		inline void setSkirtDepth(f32 depth) { m_skirtDepth = depth; }
+
+		// Uploads the tiles that arrived since the last draw and draws the selection of the last Terrain::update()
+		ENCOOPENGLAPI bool draw(Terrain &terrain, const glm::mat4 &viewProjection, OpenGLStreamBuffer &streamBuffer);
+
+		inline u64 getDrawnInstanceCount() const { return m_drawnInstances; }
+		inline u64 getUploadedTileCount() const { return m_uploadedTiles; }
+
+	private:
+		OpenGLTerrain(const OpenGLTerrain &) = delete;
+		OpenGLTerrain &operator=(const OpenGLTerrain &) = delete;
+
+		bool initialize();
+		void createResources(const TerrainSettings &settings);
+		void releaseResources();
+		void upload(const Terrain &terrain, u32 page);
+
+		OpenGLShader m_shader;
+		GLuint m_vertexArray;
+		GLuint m_gridBuffer;
+		GLuint m_indexBuffer;
+		GLsizei m_indexCount;
+
+		// Texture arrays with one layer per page of m_terrain
+		const Terrain *m_terrain;
+		GLuint m_heights;
+		GLuint m_materials;
+		uint m_tileResolution;
+		uint m_pageCount;
+
+		glm::vec3 m_lightDirection;
+		glm::vec3 m_materialColors[maxMaterials];
+		f32 m_skirtDepth;
+
+		u64 m_drawnInstances;
+		u64 m_uploadedTiles;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,199 @@
+#include "stdafx.h"
+#include "OpenGLText.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace enco {
+	static const char *s_vertexSource =
+		"#version 430\n"
+		"\n"
+		"layout(location = 0) in vec2 a_position;\n"
+		"layout(location = 1) in vec2 a_size;\n"
+		"layout(location = 2) in vec4 a_texels;\n"
+		"layout(location = 3) in vec4 a_color;\n"
+		"\n"
+		"uniform vec2 u_pixelSize;\n"
+		"uniform float u_texelSize;\n"
+		"\n"
+		"out vec2 v_texCoord;\n"
+		"out vec4 v_color;\n"
+		"\n"
+		"void main() {\n"
+		"	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+		"	vec2 position = (a_position + corner * a_size) * u_pixelSize;\n"
+		"	v_texCoord = mix(a_texels.xy, a_texels.zw, corner) * u_texelSize;\n"
+		"	v_color = a_color;\n"
+		"	gl_Position = vec4(position.x * 2.0 - 1.0, 1.0 - position.y * 2.0, 0.0, 1.0);\n"
+		"}\n";
+
+	static const char *s_fragmentSource =
+		"#version 430\n"
+		"\n"
+		"uniform sampler2D u_atlas;\n"
+		"\n"
+		"in vec2 v_texCoord;\n"
+		"in vec4 v_color;\n"
+		"out vec4 f_color;\n"
+		"\n"
+		"void main() {\n"
+		"	float distance = texture(u_atlas, v_texCoord).r;\n"
+		"	float width = max(fwidth(distance), 1.0 / 255.0);\n"
+		"	float coverage = clamp((distance - 0.5) / width + 0.5, 0.0, 1.0);\n"
+		"	f_color = vec4(v_color.rgb, v_color.a * coverage);\n"
+		"}\n";
+
+	ENCOOPENGLAPI OpenGLText::OpenGLText() : m_vertexArray(0), m_atlas(nullptr), m_drawCalls(0), m_droppedGlyphs(0) {
+	}
+
+	ENCOOPENGLAPI OpenGLText::~OpenGLText() {
+	}
+
+	ENCOOPENGLAPI void OpenGLText::release() {
+		m_shader.release();
+		if (m_vertexArray) {
+			glDeleteVertexArrays(1, &m_vertexArray);
+			m_vertexArray = 0;
+		}
+		if (!m_pages.empty()) {
+			glDeleteTextures((GLsizei)m_pages.size(), &m_pages[0]);
+			m_pages.clear();
+		}
+		m_atlas = nullptr;
+	}
+
+	ENCOOPENGLAPI bool OpenGLText::draw(TextBatch &batch, uint viewportWidth, uint viewportHeight, OpenGLStreamBuffer &streamBuffer) {
+		m_drawCalls = 0;
+		if (!m_vertexArray && !initialize()) {
+			return false;
+		}
+
+		upload(batch.getAtlas());
+
+		uint count = batch.getInstanceCount();
+		if (count == 0) {
+			return true;
+		}
+
+		OpenGLStreamBuffer::Allocation instances = streamBuffer.allocate(count * sizeof(TextGlyphInstance), sizeof(TextGlyphInstance));
+		if (!instances.data) {
+			m_droppedGlyphs += count;
+			return false;
+		}
+
+		u8 *target = (u8 *)instances.data;
+		for (uint page = 0; page < batch.getPageCount(); ++page) {
+			const std::vector<TextGlyphInstance> &source = batch.getInstances(page);
+			if (!source.empty()) {
+				memcpy(target, &source[0], source.size() * sizeof(TextGlyphInstance));
+				target += source.size() * sizeof(TextGlyphInstance);
+			}
+		}
+		streamBuffer.flush();
+
+		m_shader.bind();
+		glUniform2f(m_shader.getUniformLocation("u_pixelSize"), 1.0f / (viewportWidth ? viewportWidth : 1), 1.0f / (viewportHeight ? viewportHeight : 1));
+		glUniform1f(m_shader.getUniformLocation("u_texelSize"), 1.0f / GlyphAtlas::pageSize);
+		glUniform1i(m_shader.getUniformLocation("u_atlas"), 0);
+		glBindVertexArray(m_vertexArray);
+
+		GLboolean blend = glIsEnabled(GL_BLEND);
+		GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		glDisable(GL_DEPTH_TEST);
+
+		GLintptr offset = instances.offset;
+		for (uint page = 0; page < batch.getPageCount() && page < m_pages.size(); ++page) {
+			GLsizei pageCount = (GLsizei)batch.getInstances(page).size();
+			if (pageCount == 0) {
+				continue;
+			}
+
+			glBindTexture(GL_TEXTURE_2D, m_pages[page]);
+			glBindVertexBuffer(0, streamBuffer.getBuffer(), offset, sizeof(TextGlyphInstance));
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, pageCount);
+			offset += pageCount * sizeof(TextGlyphInstance);
+			++m_drawCalls;
+		}
+
+		if (depthTest) {
+			glEnable(GL_DEPTH_TEST);
+		}
+		if (!blend) {
+			glDisable(GL_BLEND);
+		}
+		glBindTexture(GL_TEXTURE_2D, 0);
+		glBindVertexArray(0);
+		return true;
+	}
+
+	bool OpenGLText::initialize() {
+		if (!m_shader.create(s_vertexSource, s_fragmentSource)) {
+			return false;
+		}
+
+		glGenVertexArrays(1, &m_vertexArray);
+		glBindVertexArray(m_vertexArray);
+		glEnableVertexAttribArray(0);
+		glVertexAttribFormat(0, 2, GL_FLOAT, GL_FALSE, offsetof(TextGlyphInstance, position));
+		glVertexAttribBinding(0, 0);
+		glEnableVertexAttribArray(1);
+		glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(TextGlyphInstance, size));
+		glVertexAttribBinding(1, 0);
+		glEnableVertexAttribArray(2);
+		glVertexAttribFormat(2, 4, GL_UNSIGNED_SHORT, GL_FALSE, offsetof(TextGlyphInstance, texels));
+		glVertexAttribBinding(2, 0);
+		glEnableVertexAttribArray(3);
+		glVertexAttribFormat(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(TextGlyphInstance, color));
+		glVertexAttribBinding(3, 0);
+		glVertexBindingDivisor(0, 1);
+
+		glBindVertexArray(0);
+		return true;
+	}
+
+	void OpenGLText::upload(GlyphAtlas &atlas) {
+		if (m_atlas != &atlas) {
+			if (!m_pages.empty()) {
+				glDeleteTextures((GLsizei)m_pages.size(), &m_pages[0]);
+				m_pages.clear();
+			}
+			m_atlas = &atlas;
+		}
+
+		glActiveTexture(GL_TEXTURE0);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		// New pages are uploaded whole, which covers their dirty cells as well
+		uint known = (uint)m_pages.size();
+		for (uint page = known; page < atlas.getPageCount(); ++page) {
+			GLuint texture;
+			glGenTextures(1, &texture);
+			glBindTexture(GL_TEXTURE_2D, texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, GlyphAtlas::pageSize, GlyphAtlas::pageSize, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.getPageData(page));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			m_pages.push_back(texture);
+		}
+
+		const std::vector<GlyphAtlas::DirtyCell> &dirty = atlas.getDirtyCells();
+		if (!dirty.empty()) {
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, GlyphAtlas::pageSize);
+			for (size_t i = 0; i < dirty.size(); ++i) {
+				if (dirty[i].page < known) {
+					glBindTexture(GL_TEXTURE_2D, m_pages[dirty[i].page]);
+					glTexSubImage2D(GL_TEXTURE_2D, 0, dirty[i].x, dirty[i].y, GlyphAtlas::cellSize, GlyphAtlas::cellSize, GL_RED, GL_UNSIGNED_BYTE, atlas.getPageData(dirty[i].page) + dirty[i].y * GlyphAtlas::pageSize + dirty[i].x);
+				}
+			}
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		}
+		atlas.clearDirtyCells();
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+}
\ No newline at end of file
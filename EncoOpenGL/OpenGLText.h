@@ -0,0 +1,49 @@
+#ifndef __ENCOOPENGL_OPENGLTEXT_H__
+#define __ENCOOPENGL_OPENGLTEXT_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include "OpenGLShader.h"
+#include "OpenGLStreamBuffer.h"
+
+#include <vector>
+
+namespace enco {
+	// Mirrors the pages of a GlyphAtlas in textures and draws a TextBatch with one instanced draw per page.
+	// The distance fields are antialiased over one screen pixel, whatever size the text is drawn at.
+	class OpenGLText {
+	public:
+		ENCOOPENGLAPI OpenGLText();
+		ENCOOPENGLAPI ~OpenGLText();
+
+		ENCOOPENGLAPI void release();
+
+		// Uploads the cells the atlas rasterized since the last call, then draws on top of the bound target
+		ENCOOPENGLAPI bool draw(TextBatch &batch, uint viewportWidth, uint viewportHeight, OpenGLStreamBuffer &streamBuffer);
+
+		inline uint getDrawCallCount() const { return m_drawCalls; }
+		// Instances that did not fit into the stream buffer
+		inline u64 getDroppedGlyphCount() const { return m_droppedGlyphs; }
+
+	private:
+		OpenGLText(const OpenGLText &) = delete;
+		OpenGLText &operator=(const OpenGLText &) = delete;
+
+		bool initialize();
+		void upload(GlyphAtlas &atlas);
+
+		OpenGLShader m_shader;
+		GLuint m_vertexArray;
+		// Textures of the pages of m_atlas, drawing a batch of another atlas starts over
+		const GlyphAtlas *m_atlas;
+		std::vector<GLuint> m_pages;
+		uint m_drawCalls;
+		u64 m_droppedGlyphs;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,916 @@
+#include "stdafx.h"
+#include "OpenGLTrace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace enco {
+	namespace {
+		// Granularity at which persistent mappings are compared against their shadow copy
+		const size_t pageSize = 4096;
+		const GLint maxTextureUnits = 16;
+		const GLint maxBufferBindings = 8;
+		const GLint maxColorAttachments = 8;
+		const GLint maxVertexAttribs = 16;
+		const GLint maxTextureLevels = 16;
+
+		struct TextureTarget {
+			GLenum target;
+			GLenum binding;
+		};
+
+		const TextureTarget textureTargets[] = {
+			{ GL_TEXTURE_2D, GL_TEXTURE_BINDING_2D },
+			{ GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BINDING_2D_ARRAY },
+			{ GL_TEXTURE_3D, GL_TEXTURE_BINDING_3D },
+			{ GL_TEXTURE_CUBE_MAP, GL_TEXTURE_BINDING_CUBE_MAP }
+		};
+
+		const GLenum bufferTargets[] = {
+			GL_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_PIXEL_PACK_BUFFER,
+			GL_PIXEL_UNPACK_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER
+		};
+
+		const GLenum capabilities[] = { GL_DEPTH_TEST, GL_BLEND, GL_CULL_FACE, GL_SCISSOR_TEST, GL_STENCIL_TEST, GL_POLYGON_OFFSET_FILL };
+
+		const GLenum textureParameters[] = {
+			GL_TEXTURE_MIN_FILTER, GL_TEXTURE_MAG_FILTER, GL_TEXTURE_WRAP_S, GL_TEXTURE_WRAP_T, GL_TEXTURE_WRAP_R,
+			GL_TEXTURE_COMPARE_MODE, GL_TEXTURE_COMPARE_FUNC, GL_TEXTURE_BASE_LEVEL, GL_TEXTURE_MAX_LEVEL
+		};
+
+		// Uniform types a snapshot restores, with the call that sets them and their number of components
+		struct UniformType {
+			GLenum type;
+			GLCaptureCall call;
+			u8 components;
+		};
+
+		const UniformType uniformTypes[] = {
+			{ GL_FLOAT, glUniform1fvCall, 1 }, { GL_FLOAT_VEC2, glUniform2fvCall, 2 },
+			{ GL_FLOAT_VEC3, glUniform3fvCall, 3 }, { GL_FLOAT_VEC4, glUniform4fvCall, 4 },
+			{ GL_INT, glUniform1ivCall, 1 }, { GL_INT_VEC2, glUniform2ivCall, 2 },
+			{ GL_INT_VEC3, glUniform3ivCall, 3 }, { GL_INT_VEC4, glUniform4ivCall, 4 },
+			{ GL_BOOL, glUniform1ivCall, 1 }, { GL_BOOL_VEC2, glUniform2ivCall, 2 },
+			{ GL_BOOL_VEC3, glUniform3ivCall, 3 }, { GL_BOOL_VEC4, glUniform4ivCall, 4 },
+			{ GL_UNSIGNED_INT, glUniform1uivCall, 1 }, { GL_UNSIGNED_INT_VEC2, glUniform2uivCall, 2 },
+			{ GL_UNSIGNED_INT_VEC3, glUniform3uivCall, 3 }, { GL_UNSIGNED_INT_VEC4, glUniform4uivCall, 4 },
+			{ GL_FLOAT_MAT2, glUniformMatrix2fvCall, 4 }, { GL_FLOAT_MAT3, glUniformMatrix3fvCall, 9 },
+			{ GL_FLOAT_MAT4, glUniformMatrix4fvCall, 16 }
+		};
+
+		GLenum getBufferBinding(GLenum target) {
+			switch (target) {
+			case GL_ARRAY_BUFFER: return GL_ARRAY_BUFFER_BINDING;
+			case GL_ELEMENT_ARRAY_BUFFER: return GL_ELEMENT_ARRAY_BUFFER_BINDING;
+			// The targets double as their binding queries
+			case GL_COPY_READ_BUFFER: return GL_COPY_READ_BUFFER;
+			case GL_COPY_WRITE_BUFFER: return GL_COPY_WRITE_BUFFER;
+			case GL_DRAW_INDIRECT_BUFFER: return GL_DRAW_INDIRECT_BUFFER_BINDING;
+			case GL_PIXEL_PACK_BUFFER: return GL_PIXEL_PACK_BUFFER_BINDING;
+			case GL_PIXEL_UNPACK_BUFFER: return GL_PIXEL_UNPACK_BUFFER_BINDING;
+			case GL_UNIFORM_BUFFER: return GL_UNIFORM_BUFFER_BINDING;
+			case GL_SHADER_STORAGE_BUFFER: return GL_SHADER_STORAGE_BUFFER_BINDING;
+			default: return 0;
+			}
+		}
+
+		GLenum getTextureBinding(GLenum target) {
+			for (size_t i = 0; i < sizeof(textureTargets) / sizeof(textureTargets[0]); ++i) {
+				if (textureTargets[i].target == target) {
+					return textureTargets[i].binding;
+				}
+			}
+			return 0;
+		}
+
+		// A format and type that read an image of internalFormat back without losing anything
+		void getReadFormat(GLint internalFormat, GLenum &format, GLenum &type) {
+			switch (internalFormat) {
+			case GL_RGBA8: format = GL_RGBA; type = GL_UNSIGNED_BYTE; break;
+			case GL_RGBA16F: format = GL_RGBA; type = GL_HALF_FLOAT; break;
+			case GL_RG16F: format = GL_RG; type = GL_HALF_FLOAT; break;
+			case GL_R32F: format = GL_RED; type = GL_FLOAT; break;
+			case GL_R16: format = GL_RED; type = GL_UNSIGNED_SHORT; break;
+			case GL_R8: format = GL_RED; type = GL_UNSIGNED_BYTE; break;
+			case GL_R8UI: format = GL_RED_INTEGER; type = GL_UNSIGNED_BYTE; break;
+			case GL_DEPTH_COMPONENT16: case GL_DEPTH_COMPONENT24: case GL_DEPTH_COMPONENT32: format = GL_DEPTH_COMPONENT; type = GL_UNSIGNED_INT; break;
+			case GL_DEPTH_COMPONENT32F: format = GL_DEPTH_COMPONENT; type = GL_FLOAT; break;
+			case GL_DEPTH24_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_UNSIGNED_INT_24_8; break;
+			case GL_DEPTH32F_STENCIL8: format = GL_DEPTH_STENCIL; type = GL_FLOAT_32_UNSIGNED_INT_24_8_REV; break;
+			// Every other color format fits into floats
+			default: format = GL_RGBA; type = GL_FLOAT; break;
+			}
+		}
+
+		const UniformType *getUniformType(GLenum type) {
+			for (size_t i = 0; i < sizeof(uniformTypes) / sizeof(uniformTypes[0]); ++i) {
+				if (uniformTypes[i].type == type) {
+					return &uniformTypes[i];
+				}
+			}
+			return nullptr;
+		}
+
+		// Samplers and images are set like ints, doubles and non-square matrices are not restored
+		bool isIntUniform(GLenum type) {
+			switch (type) {
+			case GL_DOUBLE: case GL_DOUBLE_VEC2: case GL_DOUBLE_VEC3: case GL_DOUBLE_VEC4:
+			case GL_DOUBLE_MAT2: case GL_DOUBLE_MAT3: case GL_DOUBLE_MAT4: case GL_DOUBLE_MAT2x3: case GL_DOUBLE_MAT2x4:
+			case GL_DOUBLE_MAT3x2: case GL_DOUBLE_MAT3x4: case GL_DOUBLE_MAT4x2: case GL_DOUBLE_MAT4x3:
+			case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT3x2: case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x2:
+			case GL_FLOAT_MAT4x3:
+				return false;
+			default:
+				return true;
+			}
+		}
+
+		template<typename T>
+		inline void append(std::vector<u8> &data, const T &value) {
+			const u8 *bytes = (const u8 *)&value;
+			data.insert(data.end(), bytes, bytes + sizeof(T));
+		}
+	}
+
+	bool OpenGLTrace::s_capturing = false;
+	std::unordered_map<GLuint, GLenum> OpenGLTrace::s_objects[glObjectTypeCount];
+	std::unordered_map<GLuint, OpenGLTrace::Mapping> OpenGLTrace::s_mappings;
+	std::unordered_set<GLuint> OpenGLTrace::s_captured[glObjectTypeCount];
+	std::unordered_map<GLuint, std::vector<u8>> OpenGLTrace::s_shadows;
+	std::vector<u8> OpenGLTrace::s_sections[glCaptureSectionCount];
+	u32 OpenGLTrace::s_callCounts[glCaptureSectionCount];
+
+	ENCOOPENGLAPI void OpenGLTrace::start() {
+		if (s_capturing) {
+			return;
+		}
+
+		for (uint i = 0; i < glCaptureSectionCount; ++i) {
+			s_sections[i].clear();
+			s_callCounts[i] = 0;
+		}
+		for (uint i = 0; i < glObjectTypeCount; ++i) {
+			s_captured[i].clear();
+		}
+		s_shadows.clear();
+
+		// Snapshots upload tightly packed images from client memory into unit 0
+		recordSetup(glBindBufferCall, GL_PIXEL_UNPACK_BUFFER, 0);
+		recordSetup(glPixelStoreiCall, GL_UNPACK_ALIGNMENT, 1);
+		recordSetup(glPixelStoreiCall, GL_UNPACK_ROW_LENGTH, 0);
+		recordSetup(glActiveTextureCall, GL_TEXTURE0);
+
+		snapshotState();
+		s_capturing = true;
+	}
+
+	ENCOOPENGLAPI bool OpenGLTrace::stop(const std::string &path, uint width, uint height) {
+		if (!s_capturing) {
+			return false;
+		}
+
+		flushMappedWrites();
+		s_capturing = false;
+		s_shadows.clear();
+
+		GLCaptureFileHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "EGLC", 4);
+		header.version = glCaptureFileVersion;
+		header.width = width;
+		header.height = height;
+		for (uint i = 0; i < glCaptureSectionCount; ++i) {
+			header.callCounts[i] = s_callCounts[i];
+			header.sectionSizes[i] = s_sections[i].size();
+		}
+
+		std::ofstream file(path, std::ios::binary);
+		bool written = false;
+		if (file) {
+			file.write((const char *)&header, sizeof(header));
+			for (uint i = 0; i < glCaptureSectionCount; ++i) {
+				if (!s_sections[i].empty()) {
+					file.write((const char *)&s_sections[i][0], s_sections[i].size());
+				}
+			}
+			written = file.good();
+		}
+#ifdef _DEBUG
+		if (!written) {
+			printf("OpenGLTrace Error: could not write %s\n", path.c_str());
+		}
+#endif
+
+		// Captures of texture heavy frames are large, the memory goes back right away
+		for (uint i = 0; i < glCaptureSectionCount; ++i) {
+			std::vector<u8>().swap(s_sections[i]);
+		}
+		return written;
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::addObjects(GLObjectType type, GLsizei count, const GLuint *names) {
+		for (GLsizei i = 0; i < count; ++i) {
+			s_objects[type][names[i]] = 0;
+			if (s_capturing) {
+				s_captured[type].insert(names[i]);
+			}
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::removeObjects(GLObjectType type, GLsizei count, const GLuint *names) {
+		for (GLsizei i = 0; i < count; ++i) {
+			if (s_capturing) {
+				reference(type, names[i]);
+			}
+			s_objects[type].erase(names[i]);
+			if (type == bufferObject) {
+				s_mappings.erase(names[i]);
+				s_shadows.erase(names[i]);
+			}
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::setTextureTarget(GLenum target) {
+		if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+			target = GL_TEXTURE_CUBE_MAP;
+		}
+		GLuint texture = getBoundTexture(target);
+		if (texture == 0) {
+			return;
+		}
+
+		std::unordered_map<GLuint, GLenum>::iterator object = s_objects[textureObject].find(texture);
+		if (object != s_objects[textureObject].end()) {
+			object->second = target;
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::addMapping(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access, void *pointer) {
+		if (buffer == 0 || pointer == nullptr) {
+			return;
+		}
+
+		Mapping mapping = { pointer, offset, length, access };
+		s_mappings[buffer] = mapping;
+		if (s_capturing && (access & GL_MAP_PERSISTENT_BIT) != 0 && (access & GL_MAP_WRITE_BIT) != 0) {
+			const u8 *bytes = (const u8 *)pointer;
+			s_shadows[buffer].assign(bytes, bytes + length);
+		}
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::removeMapping(GLuint buffer) {
+		std::unordered_map<GLuint, Mapping>::iterator mapping = s_mappings.find(buffer);
+		if (mapping == s_mappings.end()) {
+			return;
+		}
+
+		if (s_capturing && (mapping->second.access & GL_MAP_WRITE_BIT) != 0) {
+			std::unordered_map<GLuint, std::vector<u8>>::iterator shadow = s_shadows.find(buffer);
+			if (shadow != s_shadows.end()) {
+				recordWrites(buffer, mapping->second, shadow->second);
+				s_shadows.erase(shadow);
+			}
+			else {
+				recordIn(glCaptureFrame, mappedWriteCall, mapping->second.pointer, (size_t)mapping->second.length, buffer, mapping->second.offset);
+			}
+		}
+		s_mappings.erase(mapping);
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::flushMappedWrites() {
+		for (std::unordered_map<GLuint, std::vector<u8>>::iterator shadow = s_shadows.begin(); shadow != s_shadows.end(); ++shadow) {
+			std::unordered_map<GLuint, Mapping>::const_iterator mapping = s_mappings.find(shadow->first);
+			if (mapping != s_mappings.end()) {
+				recordWrites(shadow->first, mapping->second, shadow->second);
+			}
+		}
+	}
+
+	ENCOOPENGLAPI GLuint OpenGLTrace::getBoundBuffer(GLenum target) {
+		GLenum binding = getBufferBinding(target);
+		GLint buffer = 0;
+		if (binding != 0) {
+			::glGetIntegerv(binding, &buffer);
+		}
+		return (GLuint)buffer;
+	}
+
+	ENCOOPENGLAPI GLuint OpenGLTrace::getBoundTexture(GLenum target) {
+		if (target >= GL_TEXTURE_CUBE_MAP_POSITIVE_X && target <= GL_TEXTURE_CUBE_MAP_NEGATIVE_Z) {
+			target = GL_TEXTURE_CUBE_MAP;
+		}
+		GLenum binding = getTextureBinding(target);
+		GLint texture = 0;
+		if (binding != 0) {
+			::glGetIntegerv(binding, &texture);
+		}
+		return (GLuint)texture;
+	}
+
+	ENCOOPENGLAPI const void *OpenGLTrace::getClientData(GLenum target, const void *pointer) {
+		return pointer != nullptr && getBoundBuffer(target) == 0 ? pointer : nullptr;
+	}
+
+	ENCOOPENGLAPI size_t OpenGLTrace::getTypeSize(GLenum type) {
+		switch (type) {
+		case GL_BYTE: case GL_UNSIGNED_BYTE: return 1;
+		case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: return 2;
+		case GL_DOUBLE: return 8;
+		default: return 4;
+		}
+	}
+
+	ENCOOPENGLAPI size_t OpenGLTrace::getPixelSize(GLenum format, GLenum type) {
+		switch (type) {
+		case GL_UNSIGNED_BYTE_3_3_2: case GL_UNSIGNED_BYTE_2_3_3_REV:
+			return 1;
+		case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_5_6_5_REV: case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_4_4_4_4_REV: case GL_UNSIGNED_SHORT_5_5_5_1: case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+			return 2;
+		case GL_UNSIGNED_INT_8_8_8_8: case GL_UNSIGNED_INT_8_8_8_8_REV: case GL_UNSIGNED_INT_10_10_10_2:
+		case GL_UNSIGNED_INT_2_10_10_10_REV: case GL_UNSIGNED_INT_24_8: case GL_UNSIGNED_INT_10F_11F_11F_REV:
+		case GL_UNSIGNED_INT_5_9_9_9_REV:
+			return 4;
+		case GL_FLOAT_32_UNSIGNED_INT_24_8_REV:
+			return 8;
+		}
+
+		size_t components = 4;
+		switch (format) {
+		case GL_RED: case GL_RED_INTEGER: case GL_GREEN: case GL_BLUE: case GL_ALPHA: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX:
+			components = 1;
+			break;
+		case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL:
+			components = 2;
+			break;
+		case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: case GL_BGR_INTEGER:
+			components = 3;
+			break;
+		}
+		return components * getTypeSize(type);
+	}
+
+	ENCOOPENGLAPI size_t OpenGLTrace::getImageSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type) {
+		if (width <= 0 || height <= 0 || depth <= 0) {
+			return 0;
+		}
+
+		GLint alignment = 4, rowLength = 0, imageHeight = 0;
+		::glGetIntegerv(GL_UNPACK_ALIGNMENT, &alignment);
+		::glGetIntegerv(GL_UNPACK_ROW_LENGTH, &rowLength);
+		::glGetIntegerv(GL_UNPACK_IMAGE_HEIGHT, &imageHeight);
+
+		size_t pixelSize = getPixelSize(format, type);
+		size_t rowSize = (size_t)(rowLength > 0 ? rowLength : width) * pixelSize;
+		rowSize = (rowSize + alignment - 1) / alignment * alignment;
+		size_t imageSize = (size_t)(imageHeight > 0 ? imageHeight : height) * rowSize;
+		return (size_t)(depth - 1) * imageSize + (size_t)(height - 1) * rowSize + (size_t)width * pixelSize;
+	}
+
+	ENCOOPENGLAPI void OpenGLTrace::recordShaderSource(GLuint shader, GLsizei count, const GLchar *const *strings, const GLint *lengths) {
+		std::string source;
+		for (GLsizei i = 0; i < count; ++i) {
+			if (lengths && lengths[i] >= 0) {
+				source.append(strings[i], (size_t)lengths[i]);
+			}
+			else {
+				source.append(strings[i]);
+			}
+		}
+		recordBlob(glShaderSourceCall, source.data(), source.size(), shader, 1);
+	}
+
+	void OpenGLTrace::write(GLCaptureSection section, GLCaptureCall call, const u64 *args, uint argCount, const void *blob, size_t blobSize) {
+		std::vector<u8> &data = s_sections[section];
+		append(data, (u16)call);
+		append(data, (u8)argCount);
+		append(data, (u8)(blob != nullptr ? 1 : 0));
+		const u8 *argBytes = (const u8 *)args;
+		data.insert(data.end(), argBytes, argBytes + argCount * sizeof(u64));
+		if (blob) {
+			append(data, (u64)blobSize);
+			const u8 *blobBytes = (const u8 *)blob;
+			data.insert(data.end(), blobBytes, blobBytes + blobSize);
+		}
+		++s_callCounts[section];
+	}
+
+	void OpenGLTrace::snapshot(GLObjectType type, GLuint name) {
+		s_captured[type].insert(name);
+
+		// Reading the object binds it here and there, none of which belongs to the frame
+		bool capturing = s_capturing;
+		s_capturing = false;
+		switch (type) {
+		case bufferObject: snapshotBuffer(name); break;
+		case textureObject: snapshotTexture(name); break;
+		case vertexArrayObject: snapshotVertexArray(name); break;
+		case framebufferObject: snapshotFramebuffer(name); break;
+		case renderbufferObject: snapshotRenderbuffer(name); break;
+		case queryObject:
+			// The library only has timestamp queries, a frame reads the ones of earlier frames
+			recordIn(glCaptureSetup, glGenQueriesCall, &name, sizeof(name), 1);
+			recordSetup(glQueryCounterCall, name, GL_TIMESTAMP);
+			break;
+		case programObject: snapshotProgram(name); break;
+		case shaderObject: snapshotShader(name); break;
+		default: break;
+		}
+		s_capturing = capturing;
+	}
+
+	void OpenGLTrace::snapshotBuffer(GLuint buffer) {
+		GLint previous = 0;
+		::glGetIntegerv(GL_COPY_READ_BUFFER, &previous);
+		glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+
+		GLint64 size = 0;
+		GLint usage = GL_STATIC_DRAW, immutable = GL_FALSE, flags = 0, mapped = GL_FALSE;
+		glGetBufferParameteri64v(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_USAGE, &usage);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_IMMUTABLE_STORAGE, &immutable);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_STORAGE_FLAGS, &flags);
+		glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_MAPPED, &mapped);
+
+		std::unordered_map<GLuint, Mapping>::const_iterator mapping = s_mappings.find(buffer);
+		bool persistent = mapping != s_mappings.end() && (mapping->second.access & GL_MAP_PERSISTENT_BIT) != 0;
+
+		// Buffers mapped without GL_MAP_PERSISTENT_BIT cannot be read, their writes are recorded at the unmap
+		std::vector<u8> data;
+		if (size > 0 && (!mapped || persistent)) {
+			data.resize((size_t)size);
+			glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (GLsizeiptr)size, &data[0]);
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, (GLuint)previous);
+
+		recordIn(glCaptureSetup, glGenBuffersCall, &buffer, sizeof(buffer), 1);
+		recordSetup(glBindBufferCall, GL_COPY_WRITE_BUFFER, buffer);
+		const void *contents = data.empty() ? nullptr : &data[0];
+		if (immutable) {
+			recordIn(glCaptureSetup, glBufferStorageCall, contents, data.size(), GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, flags);
+		}
+		else {
+			recordIn(glCaptureSetup, glBufferDataCall, contents, data.size(), GL_COPY_WRITE_BUFFER, (GLsizeiptr)size, usage);
+		}
+
+		if (persistent) {
+			const Mapping &range = mapping->second;
+			recordSetup(glMapBufferRangeCall, GL_COPY_WRITE_BUFFER, range.offset, range.length, range.access, buffer);
+			if ((range.access & GL_MAP_WRITE_BIT) != 0) {
+				const u8 *bytes = (const u8 *)range.pointer;
+				s_shadows[buffer].assign(bytes, bytes + range.length);
+			}
+		}
+	}
+
+	void OpenGLTrace::snapshotTexture(GLuint texture) {
+		recordIn(glCaptureSetup, glGenTexturesCall, &texture, sizeof(texture), 1);
+
+		// A texture that never got an image has no target yet and nothing to restore
+		std::unordered_map<GLuint, GLenum>::const_iterator object = s_objects[textureObject].find(texture);
+		GLenum target = object != s_objects[textureObject].end() ? object->second : 0;
+		if (target == 0) {
+			return;
+		}
+
+		GLint previous = 0, packAlignment = 4, packRowLength = 0, packBuffer = 0;
+		::glGetIntegerv(getTextureBinding(target), &previous);
+		::glGetIntegerv(GL_PACK_ALIGNMENT, &packAlignment);
+		::glGetIntegerv(GL_PACK_ROW_LENGTH, &packRowLength);
+		::glGetIntegerv(GL_PIXEL_PACK_BUFFER_BINDING, &packBuffer);
+		glBindTexture(target, texture);
+		::glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		::glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+		recordSetup(glBindTextureCall, target, texture);
+		bool cube = target == GL_TEXTURE_CUBE_MAP;
+		bool layered = target == GL_TEXTURE_2D_ARRAY || target == GL_TEXTURE_3D;
+		std::vector<u8> pixels;
+		for (GLint level = 0; level < maxTextureLevels; ++level) {
+			GLenum levelTarget = cube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X : target;
+			GLint width = 0, height = 0, depth = 0, internalFormat = 0, compressed = GL_FALSE;
+			::glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_WIDTH, &width);
+			if (width == 0) {
+				break;
+			}
+			::glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_HEIGHT, &height);
+			::glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_DEPTH, &depth);
+			::glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_INTERNAL_FORMAT, &internalFormat);
+			::glGetTexLevelParameteriv(levelTarget, level, GL_TEXTURE_COMPRESSED, &compressed);
+
+			GLenum format, type;
+			getReadFormat(internalFormat, format, type);
+			for (GLenum face = 0; face < (cube ? 6u : 1u); ++face) {
+				GLenum imageTarget = cube ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+				// Compressed images keep their storage but not their contents
+				const void *blob = nullptr;
+				size_t size = 0;
+				if (!compressed) {
+					size = (size_t)width * height * depth * getPixelSize(format, type);
+					pixels.resize(size);
+					::glGetTexImage(imageTarget, level, format, type, &pixels[0]);
+					blob = &pixels[0];
+				}
+
+				if (layered) {
+					recordIn(glCaptureSetup, glTexImage3DCall, blob, size, imageTarget, level, internalFormat, width, height, depth, 0, format, type, (const void *)nullptr);
+				}
+				else {
+					recordIn(glCaptureSetup, glTexImage2DCall, blob, size, imageTarget, level, internalFormat, width, height, 0, format, type, (const void *)nullptr);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < sizeof(textureParameters) / sizeof(textureParameters[0]); ++i) {
+			GLint value = 0;
+			::glGetTexParameteriv(target, textureParameters[i], &value);
+			recordSetup(glTexParameteriCall, target, textureParameters[i], value);
+		}
+
+		::glPixelStorei(GL_PACK_ALIGNMENT, packAlignment);
+		::glPixelStorei(GL_PACK_ROW_LENGTH, packRowLength);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, (GLuint)packBuffer);
+		glBindTexture(target, (GLuint)previous);
+	}
+
+	void OpenGLTrace::snapshotVertexArray(GLuint vertexArray) {
+		struct Attrib {
+			GLint enabled, size, type, normalized, integer, relativeOffset, binding;
+		};
+		struct Binding {
+			GLint buffer, stride, divisor;
+			GLint64 offset;
+		};
+
+		GLint previous = 0, attribCount = 0, elementBuffer = 0;
+		::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &previous);
+		::glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attribCount);
+		attribCount = std::min(attribCount, maxVertexAttribs);
+		glBindVertexArray(vertexArray);
+
+		Attrib attribs[maxVertexAttribs];
+		Binding bindings[maxVertexAttribs];
+		bool used[maxVertexAttribs] = {};
+		for (GLint i = 0; i < attribCount; ++i) {
+			Attrib &attrib = attribs[i];
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &attrib.enabled);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_SIZE, &attrib.size);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_TYPE, &attrib.type);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &attrib.normalized);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &attrib.integer);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_RELATIVE_OFFSET, &attrib.relativeOffset);
+			glGetVertexAttribiv(i, GL_VERTEX_ATTRIB_BINDING, &attrib.binding);
+			if (attrib.enabled && attrib.binding >= 0 && attrib.binding < attribCount) {
+				used[attrib.binding] = true;
+			}
+		}
+		for (GLint i = 0; i < attribCount; ++i) {
+			if (used[i]) {
+				glGetIntegeri_v(GL_VERTEX_BINDING_BUFFER, i, &bindings[i].buffer);
+				glGetIntegeri_v(GL_VERTEX_BINDING_STRIDE, i, &bindings[i].stride);
+				glGetIntegeri_v(GL_VERTEX_BINDING_DIVISOR, i, &bindings[i].divisor);
+				glGetInteger64i_v(GL_VERTEX_BINDING_OFFSET, i, &bindings[i].offset);
+			}
+		}
+		::glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &elementBuffer);
+		glBindVertexArray((GLuint)previous);
+
+		reference(bufferObject, (GLuint)elementBuffer);
+		for (GLint i = 0; i < attribCount; ++i) {
+			if (used[i]) {
+				reference(bufferObject, (GLuint)bindings[i].buffer);
+			}
+		}
+
+		recordIn(glCaptureSetup, glGenVertexArraysCall, &vertexArray, sizeof(vertexArray), 1);
+		recordSetup(glBindVertexArrayCall, vertexArray);
+		for (GLint i = 0; i < attribCount; ++i) {
+			const Attrib &attrib = attribs[i];
+			if (!attrib.enabled) {
+				continue;
+			}
+			if (attrib.integer) {
+				recordSetup(glVertexAttribIFormatCall, i, attrib.size, attrib.type, attrib.relativeOffset);
+			}
+			else {
+				recordSetup(glVertexAttribFormatCall, i, attrib.size, attrib.type, attrib.normalized, attrib.relativeOffset);
+			}
+			recordSetup(glVertexAttribBindingCall, i, attrib.binding);
+			recordSetup(glEnableVertexAttribArrayCall, i);
+		}
+		for (GLint i = 0; i < attribCount; ++i) {
+			if (used[i]) {
+				recordSetup(glBindVertexBufferCall, i, bindings[i].buffer, bindings[i].offset, bindings[i].stride);
+				recordSetup(glVertexBindingDivisorCall, i, bindings[i].divisor);
+			}
+		}
+		recordSetup(glBindBufferCall, GL_ELEMENT_ARRAY_BUFFER, elementBuffer);
+		recordSetup(glBindVertexArrayCall, 0);
+	}
+
+	void OpenGLTrace::snapshotFramebuffer(GLuint framebuffer) {
+		struct Attachment {
+			GLenum attachment;
+			GLint type, name, level, layer, face;
+		};
+
+		GLint previousRead = 0, previousDraw = 0, colorCount = 0, drawBufferCount = 0, readBuffer = GL_NONE;
+		::glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+		::glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousDraw);
+		::glGetIntegerv(GL_MAX_COLOR_ATTACHMENTS, &colorCount);
+		::glGetIntegerv(GL_MAX_DRAW_BUFFERS, &drawBufferCount);
+		colorCount = std::min(colorCount, maxColorAttachments);
+		drawBufferCount = std::min(drawBufferCount, maxColorAttachments);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+
+		std::vector<Attachment> attachments;
+		for (GLint i = 0; i < colorCount + 2; ++i) {
+			Attachment attachment = { i < colorCount ? (GLenum)(GL_COLOR_ATTACHMENT0 + i) : i == colorCount ? (GLenum)GL_DEPTH_ATTACHMENT : (GLenum)GL_STENCIL_ATTACHMENT, GL_NONE, 0, 0, 0, 0 };
+			glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment.attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_TYPE, &attachment.type);
+			if (attachment.type != GL_TEXTURE && attachment.type != GL_RENDERBUFFER) {
+				continue;
+			}
+			glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment.attachment, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &attachment.name);
+			if (attachment.type == GL_TEXTURE) {
+				glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment.attachment, GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_LEVEL, &attachment.level);
+				glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment.attachment, GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_LAYER, &attachment.layer);
+				glGetFramebufferAttachmentParameteriv(GL_READ_FRAMEBUFFER, attachment.attachment, GL_FRAMEBUFFER_ATTACHMENT_TEXTURE_CUBE_MAP_FACE, &attachment.face);
+			}
+			attachments.push_back(attachment);
+		}
+
+		std::vector<GLenum> drawBuffers((size_t)std::max(drawBufferCount, 1), GL_NONE);
+		for (GLint i = 0; i < drawBufferCount; ++i) {
+			GLint drawBuffer = GL_NONE;
+			::glGetIntegerv(GL_DRAW_BUFFER0 + i, &drawBuffer);
+			drawBuffers[i] = (GLenum)drawBuffer;
+		}
+		::glGetIntegerv(GL_READ_BUFFER, &readBuffer);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)previousRead);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, (GLuint)previousDraw);
+
+		for (size_t i = 0; i < attachments.size(); ++i) {
+			reference(attachments[i].type == GL_TEXTURE ? textureObject : renderbufferObject, (GLuint)attachments[i].name);
+		}
+
+		recordIn(glCaptureSetup, glGenFramebuffersCall, &framebuffer, sizeof(framebuffer), 1);
+		recordSetup(glBindFramebufferCall, GL_FRAMEBUFFER, framebuffer);
+		for (size_t i = 0; i < attachments.size(); ++i) {
+			const Attachment &attachment = attachments[i];
+			if (attachment.type == GL_RENDERBUFFER) {
+				recordSetup(glFramebufferRenderbufferCall, GL_FRAMEBUFFER, attachment.attachment, GL_RENDERBUFFER, attachment.name);
+				continue;
+			}
+
+			std::unordered_map<GLuint, GLenum>::const_iterator object = s_objects[textureObject].find((GLuint)attachment.name);
+			GLenum target = object != s_objects[textureObject].end() && object->second != 0 ? object->second : GL_TEXTURE_2D;
+			if (target == GL_TEXTURE_2D_ARRAY || target == GL_TEXTURE_3D) {
+				recordSetup(glFramebufferTextureLayerCall, GL_FRAMEBUFFER, attachment.attachment, attachment.name, attachment.level, attachment.layer);
+			}
+			else {
+				recordSetup(glFramebufferTexture2DCall, GL_FRAMEBUFFER, attachment.attachment, target == GL_TEXTURE_CUBE_MAP ? (GLenum)attachment.face : target, attachment.name, attachment.level);
+			}
+		}
+		recordIn(glCaptureSetup, glDrawBuffersCall, &drawBuffers[0], drawBuffers.size() * sizeof(GLenum), (GLsizei)drawBuffers.size());
+		recordSetup(glReadBufferCall, readBuffer);
+		recordSetup(glBindFramebufferCall, GL_FRAMEBUFFER, 0);
+	}
+
+	void OpenGLTrace::snapshotRenderbuffer(GLuint renderbuffer) {
+		GLint previous = 0, width = 0, height = 0, internalFormat = 0, samples = 0;
+		::glGetIntegerv(GL_RENDERBUFFER_BINDING, &previous);
+		glBindRenderbuffer(GL_RENDERBUFFER, renderbuffer);
+		glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_WIDTH, &width);
+		glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_HEIGHT, &height);
+		glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_INTERNAL_FORMAT, &internalFormat);
+		glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_SAMPLES, &samples);
+		glBindRenderbuffer(GL_RENDERBUFFER, (GLuint)previous);
+
+		recordIn(glCaptureSetup, glGenRenderbuffersCall, &renderbuffer, sizeof(renderbuffer), 1);
+		recordSetup(glBindRenderbufferCall, GL_RENDERBUFFER, renderbuffer);
+		if (width > 0 && height > 0) {
+			recordSetup(glRenderbufferStorageMultisampleCall, GL_RENDERBUFFER, samples, internalFormat, width, height);
+		}
+	}
+
+	void OpenGLTrace::snapshotProgram(GLuint program) {
+		GLint linked = GL_FALSE;
+		GLsizei shaderCount = 0;
+		GLuint shaders[8];
+		glGetProgramiv(program, GL_LINK_STATUS, &linked);
+		glGetAttachedShaders(program, 8, &shaderCount, shaders);
+		for (GLsizei i = 0; i < shaderCount; ++i) {
+			reference(shaderObject, shaders[i]);
+		}
+
+		recordSetup(glCreateProgramCall, program);
+		for (GLsizei i = 0; i < shaderCount; ++i) {
+			recordSetup(glAttachShaderCall, program, shaders[i]);
+		}
+		if (linked) {
+			recordSetup(glLinkProgramCall, program);
+			snapshotUniforms(program);
+		}
+	}
+
+	void OpenGLTrace::snapshotShader(GLuint shader) {
+		GLint type = 0, length = 0;
+		glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+		glGetShaderiv(shader, GL_SHADER_SOURCE_LENGTH, &length);
+		std::string source;
+		if (length > 0) {
+			source.resize((size_t)length);
+			glGetShaderSource(shader, length, nullptr, &source[0]);
+			source.resize(strlen(source.c_str()));
+		}
+
+		recordSetup(glCreateShaderCall, type, shader);
+		recordIn(glCaptureSetup, glShaderSourceCall, source.data(), source.size(), shader, 1);
+		recordSetup(glCompileShaderCall, shader);
+	}
+
+	void OpenGLTrace::snapshotUniforms(GLuint program) {
+		GLint uniformCount = 0, maxLength = 0;
+		glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+		glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		if (uniformCount <= 0) {
+			return;
+		}
+
+		recordSetup(glUseProgramCall, program);
+		std::vector<GLchar> name((size_t)std::max(maxLength, 1));
+		for (GLuint i = 0; i < (GLuint)uniformCount; ++i) {
+			GLint size = 0, block = -1;
+			GLenum type = 0;
+			glGetActiveUniform(program, i, (GLsizei)name.size(), nullptr, &size, &type, &name[0]);
+			glGetActiveUniformsiv(program, 1, &i, GL_UNIFORM_BLOCK_INDEX, &block);
+			// Uniforms in blocks live in buffers
+			const UniformType *uniformType = getUniformType(type);
+			if (block != -1 || (!uniformType && !isIntUniform(type))) {
+				continue;
+			}
+
+			std::string base(&name[0]);
+			if (base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0) {
+				base.resize(base.size() - 3);
+			}
+			GLCaptureCall call = uniformType ? uniformType->call : glUniform1ivCall;
+			uint components = uniformType ? uniformType->components : 1;
+			bool matrix = call == glUniformMatrix2fvCall || call == glUniformMatrix3fvCall || call == glUniformMatrix4fvCall;
+			for (GLint element = 0; element < size; ++element) {
+				std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+				GLint location = glGetUniformLocation(program, elementName.c_str());
+				if (location < 0) {
+					continue;
+				}
+				recordIn(glCaptureSetup, uniformNameCall, elementName.data(), elementName.size(), program, location);
+
+				u32 values[16];
+				if (call == glUniform1uivCall || call == glUniform2uivCall || call == glUniform3uivCall || call == glUniform4uivCall) {
+					glGetUniformuiv(program, location, (GLuint *)values);
+				}
+				else if (call == glUniform1ivCall || call == glUniform2ivCall || call == glUniform3ivCall || call == glUniform4ivCall) {
+					glGetUniformiv(program, location, (GLint *)values);
+				}
+				else {
+					glGetUniformfv(program, location, (GLfloat *)values);
+				}
+
+				if (matrix) {
+					recordIn(glCaptureSetup, call, values, components * sizeof(u32), location, 1, GL_FALSE);
+				}
+				else {
+					recordIn(glCaptureSetup, call, values, components * sizeof(u32), location, 1);
+				}
+			}
+		}
+	}
+
+	void OpenGLTrace::snapshotState() {
+		GLint activeTexture = GL_TEXTURE0, unitCount = 0;
+		::glGetIntegerv(GL_ACTIVE_TEXTURE, &activeTexture);
+		::glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &unitCount);
+		unitCount = std::min(unitCount, maxTextureUnits);
+		for (GLint unit = 0; unit < unitCount; ++unit) {
+			glActiveTexture(GL_TEXTURE0 + unit);
+			recordReset(glActiveTextureCall, GL_TEXTURE0 + unit);
+			for (size_t i = 0; i < sizeof(textureTargets) / sizeof(textureTargets[0]); ++i) {
+				GLint texture = 0;
+				::glGetIntegerv(textureTargets[i].binding, &texture);
+				reference(textureObject, (GLuint)texture);
+				recordReset(glBindTextureCall, textureTargets[i].target, texture);
+			}
+		}
+		glActiveTexture(activeTexture);
+		recordReset(glActiveTextureCall, activeTexture);
+
+		// Indexed bindings first, binding a range also sets the generic binding
+		const GLenum indexedTargets[][4] = {
+			{ GL_UNIFORM_BUFFER, GL_UNIFORM_BUFFER_BINDING, GL_UNIFORM_BUFFER_START, GL_UNIFORM_BUFFER_SIZE },
+			{ GL_SHADER_STORAGE_BUFFER, GL_SHADER_STORAGE_BUFFER_BINDING, GL_SHADER_STORAGE_BUFFER_START, GL_SHADER_STORAGE_BUFFER_SIZE }
+		};
+		for (size_t i = 0; i < 2; ++i) {
+			for (GLint index = 0; index < maxBufferBindings; ++index) {
+				GLint buffer = 0;
+				GLint64 offset = 0, size = 0;
+				glGetIntegeri_v(indexedTargets[i][1], index, &buffer);
+				glGetInteger64i_v(indexedTargets[i][2], index, &offset);
+				glGetInteger64i_v(indexedTargets[i][3], index, &size);
+				reference(bufferObject, (GLuint)buffer);
+				if (buffer != 0 && size > 0) {
+					recordReset(glBindBufferRangeCall, indexedTargets[i][0], index, buffer, (GLintptr)offset, (GLsizeiptr)size);
+				}
+				else {
+					recordReset(glBindBufferBaseCall, indexedTargets[i][0], index, buffer);
+				}
+			}
+		}
+		for (size_t i = 0; i < sizeof(bufferTargets) / sizeof(bufferTargets[0]); ++i) {
+			GLuint buffer = getBoundBuffer(bufferTargets[i]);
+			reference(bufferObject, buffer);
+			recordReset(glBindBufferCall, bufferTargets[i], buffer);
+		}
+
+		GLint vertexArray = 0, drawFramebuffer = 0, readFramebuffer = 0, renderbuffer = 0, program = 0;
+		::glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &vertexArray);
+		::glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &drawFramebuffer);
+		::glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &readFramebuffer);
+		::glGetIntegerv(GL_RENDERBUFFER_BINDING, &renderbuffer);
+		::glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+		reference(vertexArrayObject, (GLuint)vertexArray);
+		reference(framebufferObject, (GLuint)drawFramebuffer);
+		reference(framebufferObject, (GLuint)readFramebuffer);
+		reference(renderbufferObject, (GLuint)renderbuffer);
+		reference(programObject, (GLuint)program);
+		recordReset(glBindVertexArrayCall, vertexArray);
+		recordReset(glBindFramebufferCall, GL_DRAW_FRAMEBUFFER, drawFramebuffer);
+		recordReset(glBindFramebufferCall, GL_READ_FRAMEBUFFER, readFramebuffer);
+		recordReset(glBindRenderbufferCall, GL_RENDERBUFFER, renderbuffer);
+		recordReset(glUseProgramCall, program);
+
+		for (size_t i = 0; i < sizeof(capabilities) / sizeof(capabilities[0]); ++i) {
+			recordReset(::glIsEnabled(capabilities[i]) ? glEnableCall : glDisableCall, capabilities[i]);
+		}
+
+		GLint blend[4] = {}, depthFunc = GL_LESS, viewport[4] = {};
+		GLint pixelStore[4] = {};
+		const GLenum pixelStoreNames[4] = { GL_UNPACK_ALIGNMENT, GL_UNPACK_ROW_LENGTH, GL_PACK_ALIGNMENT, GL_PACK_ROW_LENGTH };
+		GLboolean depthMask = GL_TRUE;
+		GLfloat polygonOffset[2] = {}, clearColor[4] = {};
+		GLdouble clearDepth = 1.0;
+		::glGetIntegerv(GL_BLEND_SRC_RGB, &blend[0]);
+		::glGetIntegerv(GL_BLEND_DST_RGB, &blend[1]);
+		::glGetIntegerv(GL_BLEND_SRC_ALPHA, &blend[2]);
+		::glGetIntegerv(GL_BLEND_DST_ALPHA, &blend[3]);
+		::glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+		::glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+		::glGetFloatv(GL_POLYGON_OFFSET_FACTOR, &polygonOffset[0]);
+		::glGetFloatv(GL_POLYGON_OFFSET_UNITS, &polygonOffset[1]);
+		::glGetIntegerv(GL_VIEWPORT, viewport);
+		::glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+		::glGetDoublev(GL_DEPTH_CLEAR_VALUE, &clearDepth);
+		for (uint i = 0; i < 4; ++i) {
+			::glGetIntegerv(pixelStoreNames[i], &pixelStore[i]);
+		}
+
+		recordReset(glBlendFuncSeparateCall, blend[0], blend[1], blend[2], blend[3]);
+		recordReset(glDepthFuncCall, depthFunc);
+		recordReset(glDepthMaskCall, depthMask);
+		recordReset(glPolygonOffsetCall, polygonOffset[0], polygonOffset[1]);
+		recordReset(glViewportCall, viewport[0], viewport[1], viewport[2], viewport[3]);
+		recordReset(glClearColorCall, clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		recordReset(glClearDepthCall, clearDepth);
+		for (uint i = 0; i < 4; ++i) {
+			recordReset(glPixelStoreiCall, pixelStoreNames[i], pixelStore[i]);
+		}
+	}
+
+	void OpenGLTrace::recordWrites(GLuint buffer, const Mapping &mapping, std::vector<u8> &shadow) {
+		const u8 *bytes = (const u8 *)mapping.pointer;
+		size_t length = std::min(shadow.size(), (size_t)mapping.length);
+		size_t page = 0;
+		while (page < length) {
+			size_t end = std::min(page + pageSize, length);
+			if (memcmp(bytes + page, &shadow[page], end - page) == 0) {
+				page = end;
+				continue;
+			}
+
+			// Neighbouring dirty pages go out as one write
+			size_t start = page;
+			while (end < length) {
+				size_t next = std::min(end + pageSize, length);
+				if (memcmp(bytes + end, &shadow[end], next - end) == 0) {
+					break;
+				}
+				end = next;
+			}
+			recordIn(glCaptureFrame, mappedWriteCall, bytes + start, end - start, buffer, mapping.offset + (GLintptr)start);
+			memcpy(&shadow[start], bytes + start, end - start);
+			page = end;
+		}
+	}
+}
\ No newline at end of file
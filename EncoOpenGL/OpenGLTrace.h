@@ -0,0 +1,983 @@
+#ifndef __ENCOOPENGL_OPENGLTRACE_H__
+#define __ENCOOPENGL_OPENGLTRACE_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "OpenGLCapture.h"
+#include "OpenGLMemory.h"
+
+#include <EncoShared\EncoShared.h>
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace enco {
+	enum GLObjectType : u8 {
+		bufferObject,
+		textureObject,
+		vertexArrayObject,
+		framebufferObject,
+		renderbufferObject,
+		queryObject,
+		programObject,
+		shaderObject,
+		glObjectTypeCount
+	};
+
+	// Captures the GL calls of a frame for the GLReplay tool. stdafx.h includes this inside the library only, where
+	// the functions at the end of this file shadow the GL functions for all code in namespace enco. They keep a
+	// registry of the live objects and their sizes for OpenGLMemory, which costs nothing per draw, and record a
+	// call only while a capture runs.
+	// Objects that existed before the frame are snapshotted into the setup section when the frame first uses them.
+	class OpenGLTrace {
+	public:
+		inline static bool isCapturing() { return s_capturing; }
+
+		// Records the state at the start of the frame and every call until stop(), which writes the capture
+		ENCOOPENGLAPI static void start();
+		ENCOOPENGLAPI static bool stop(const std::string &path, uint width, uint height);
+
+		ENCOOPENGLAPI static void addObjects(GLObjectType type, GLsizei count, const GLuint *names);
+		// Snapshots objects that existed before the capture, so the replay has something to delete
+		ENCOOPENGLAPI static void removeObjects(GLObjectType type, GLsizei count, const GLuint *names);
+		// Textures only learn their target from the calls that give them images
+		ENCOOPENGLAPI static void setTextureTarget(GLenum target);
+
+		ENCOOPENGLAPI static void addMapping(GLuint buffer, GLintptr offset, GLsizeiptr length, GLbitfield access, void *pointer);
+		// Records what the CPU wrote through the mapping before it goes away
+		ENCOOPENGLAPI static void removeMapping(GLuint buffer);
+
+		// Snapshots the object into the setup section unless it is already there or the frame created it
+		inline static void reference(GLObjectType type, GLuint name) {
+			if (name != 0 && s_captured[type].count(name) == 0) {
+				snapshot(type, name);
+			}
+		}
+
+		// Records the bytes written through persistent mappings since the last call, before the GPU reads them
+		ENCOOPENGLAPI static void flushMappedWrites();
+
+		ENCOOPENGLAPI static GLuint getBoundBuffer(GLenum target);
+		// Cube map faces give the cube map
+		ENCOOPENGLAPI static GLuint getBoundTexture(GLenum target);
+		// pointer when no buffer is bound to target and pointer is client memory, nullptr when it is an offset
+		ENCOOPENGLAPI static const void *getClientData(GLenum target, const void *pointer);
+		ENCOOPENGLAPI static size_t getTypeSize(GLenum type);
+		// Bytes of a pixel in client memory, packed types included
+		ENCOOPENGLAPI static size_t getPixelSize(GLenum format, GLenum type);
+		// Bytes a pixel transfer reads from client memory under the current unpack state
+		ENCOOPENGLAPI static size_t getImageSize(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type);
+		ENCOOPENGLAPI static void recordShaderSource(GLuint shader, GLsizei count, const GLchar *const *strings, const GLint *lengths);
+
+		template<typename... Args>
+		static inline void record(GLCaptureCall call, Args... args) {
+			recordIn(glCaptureFrame, call, nullptr, 0, args...);
+		}
+
+		// blob may be nullptr, then no blob is stored
+		template<typename... Args>
+		static inline void recordBlob(GLCaptureCall call, const void *blob, size_t blobSize, Args... args) {
+			recordIn(glCaptureFrame, call, blob, blobSize, args...);
+		}
+
+		static inline void recordNames(GLCaptureCall call, GLsizei count, const GLuint *names) {
+			recordIn(glCaptureFrame, call, names, (size_t)count * sizeof(GLuint), count);
+		}
+
+	private:
+		OpenGLTrace() = delete;
+
+		struct Mapping {
+			void *pointer;
+			GLintptr offset;
+			GLsizeiptr length;
+			GLbitfield access;
+		};
+
+		template<typename T>
+		static inline u64 toArg(T value) { return (u64)(i64)value; }
+		template<typename T>
+		static inline u64 toArg(T *value) { return (u64)(size_t)value; }
+		static inline u64 toArg(f32 value) { u32 bits; memcpy(&bits, &value, sizeof(bits)); return bits; }
+		static inline u64 toArg(f64 value) { u64 bits; memcpy(&bits, &value, sizeof(bits)); return bits; }
+
+		template<typename... Args>
+		static inline void recordIn(GLCaptureSection section, GLCaptureCall call, const void *blob, size_t blobSize, Args... args) {
+			// The trailing 0 keeps the array valid for calls without arguments
+			const u64 values[] = { toArg(args)..., 0 };
+			write(section, call, values, (uint)sizeof...(Args), blob, blobSize);
+		}
+
+		template<typename... Args>
+		static inline void recordSetup(GLCaptureCall call, Args... args) {
+			recordIn(glCaptureSetup, call, nullptr, 0, args...);
+		}
+
+		template<typename... Args>
+		static inline void recordReset(GLCaptureCall call, Args... args) {
+			recordIn(glCaptureReset, call, nullptr, 0, args...);
+		}
+
+		static void write(GLCaptureSection section, GLCaptureCall call, const u64 *args, uint argCount, const void *blob, size_t blobSize);
+
+		static void snapshot(GLObjectType type, GLuint name);
+		static void snapshotBuffer(GLuint buffer);
+		static void snapshotTexture(GLuint texture);
+		static void snapshotVertexArray(GLuint vertexArray);
+		static void snapshotFramebuffer(GLuint framebuffer);
+		static void snapshotRenderbuffer(GLuint renderbuffer);
+		static void snapshotProgram(GLuint program);
+		static void snapshotShader(GLuint shader);
+		static void snapshotUniforms(GLuint program);
+		// The bindings and state of the start of the frame, into the reset section
+		static void snapshotState();
+		static void recordWrites(GLuint buffer, const Mapping &mapping, std::vector<u8> &shadow);
+
+		static bool s_capturing;
+		// name -> target for textures, 0 for all other types
+		static std::unordered_map<GLuint, GLenum> s_objects[glObjectTypeCount];
+		static std::unordered_map<GLuint, Mapping> s_mappings;
+		// Per capture: the objects in the setup section or created by the frame, and a copy of the persistently
+		// mapped ranges as of the last flushMappedWrites()
+		static std::unordered_set<GLuint> s_captured[glObjectTypeCount];
+		static std::unordered_map<GLuint, std::vector<u8>> s_shadows;
+		static std::vector<u8> s_sections[glCaptureSectionCount];
+		static u32 s_callCounts[glCaptureSectionCount];
+	};
+
+	// The GL functions the library calls, in the order of the capture call list. GL 1.1 functions are called
+	// through the global declarations, the rest through the GLEW pointers, whose macros are undefined first.
+#undef glActiveTexture
+#undef glAttachShader
+#undef glBindBuffer
+#undef glBindBufferRange
+#undef glBindFramebuffer
+#undef glBindRenderbuffer
+#undef glBindVertexArray
+#undef glBindVertexBuffer
+#undef glBlitFramebuffer
+#undef glBufferData
+#undef glBufferStorage
+#undef glBufferSubData
+#undef glCheckFramebufferStatus
+#undef glClientWaitSync
+#undef glCompileShader
+#undef glCopyImageSubData
+#undef glCreateProgram
+#undef glCreateShader
+#undef glDeleteBuffers
+#undef glDeleteFramebuffers
+#undef glDeleteProgram
+#undef glDeleteQueries
+#undef glDeleteRenderbuffers
+#undef glDeleteShader
+#undef glDeleteSync
+#undef glDeleteVertexArrays
+#undef glDrawArraysInstanced
+#undef glDrawArraysInstancedBaseInstance
+#undef glDrawBuffers
+#undef glDrawElementsInstanced
+#undef glDrawElementsInstancedBaseVertex
+#undef glDrawElementsInstancedBaseVertexBaseInstance
+#undef glEnableVertexAttribArray
+#undef glFenceSync
+#undef glFramebufferRenderbuffer
+#undef glFramebufferTexture2D
+#undef glFramebufferTextureLayer
+#undef glGenBuffers
+#undef glGenFramebuffers
+#undef glGenQueries
+#undef glGenRenderbuffers
+#undef glGenVertexArrays
+#undef glGetProgramInfoLog
+#undef glGetProgramiv
+#undef glGetQueryObjectiv
+#undef glGetQueryObjectui64v
+#undef glGetShaderInfoLog
+#undef glGetShaderiv
+#undef glGetUniformLocation
+#undef glLinkProgram
+#undef glMapBufferRange
+#undef glMultiDrawElementsIndirect
+#undef glQueryCounter
+#undef glRenderbufferStorageMultisample
+#undef glShaderSource
+#undef glTexImage3D
+#undef glTexSubImage3D
+#undef glUniform1f
+#undef glUniform1i
+#undef glUniform2f
+#undef glUniform3fv
+#undef glUniform3ui
+#undef glUniform4fv
+#undef glUniformMatrix4fv
+#undef glUnmapBuffer
+#undef glUseProgram
+#undef glVertexAttribBinding
+#undef glVertexAttribFormat
+#undef glVertexAttribIPointer
+#undef glVertexAttribPointer
+#undef glVertexBindingDivisor
+
+	inline void glActiveTexture(GLenum texture) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glActiveTextureCall, texture);
+		}
+		GLEW_GET_FUN(__glewActiveTexture)(texture);
+	}
+
+	inline void glAttachShader(GLuint program, GLuint shader) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(programObject, program);
+			OpenGLTrace::reference(shaderObject, shader);
+			OpenGLTrace::record(glAttachShaderCall, program, shader);
+		}
+		GLEW_GET_FUN(__glewAttachShader)(program, shader);
+	}
+
+	inline void glBindBuffer(GLenum target, GLuint buffer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(bufferObject, buffer);
+			OpenGLTrace::record(glBindBufferCall, target, buffer);
+		}
+		GLEW_GET_FUN(__glewBindBuffer)(target, buffer);
+	}
+
+	inline void glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(bufferObject, buffer);
+			OpenGLTrace::record(glBindBufferRangeCall, target, index, buffer, offset, size);
+		}
+		GLEW_GET_FUN(__glewBindBufferRange)(target, index, buffer, offset, size);
+	}
+
+	inline void glBindFramebuffer(GLenum target, GLuint framebuffer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(framebufferObject, framebuffer);
+			OpenGLTrace::record(glBindFramebufferCall, target, framebuffer);
+		}
+		GLEW_GET_FUN(__glewBindFramebuffer)(target, framebuffer);
+	}
+
+	inline void glBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(renderbufferObject, renderbuffer);
+			OpenGLTrace::record(glBindRenderbufferCall, target, renderbuffer);
+		}
+		GLEW_GET_FUN(__glewBindRenderbuffer)(target, renderbuffer);
+	}
+
+	inline void glBindTexture(GLenum target, GLuint texture) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(textureObject, texture);
+			OpenGLTrace::record(glBindTextureCall, target, texture);
+		}
+		::glBindTexture(target, texture);
+	}
+
+	inline void glBindVertexArray(GLuint array) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(vertexArrayObject, array);
+			OpenGLTrace::record(glBindVertexArrayCall, array);
+		}
+		GLEW_GET_FUN(__glewBindVertexArray)(array);
+	}
+
+	inline void glBindVertexBuffer(GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(bufferObject, buffer);
+			OpenGLTrace::record(glBindVertexBufferCall, bindingindex, buffer, offset, stride);
+		}
+		GLEW_GET_FUN(__glewBindVertexBuffer)(bindingindex, buffer, offset, stride);
+	}
+
+	inline void glBlendFunc(GLenum sfactor, GLenum dfactor) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glBlendFuncCall, sfactor, dfactor);
+		}
+		::glBlendFunc(sfactor, dfactor);
+	}
+
+	inline void glBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1, GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1, GLbitfield mask, GLenum filter) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glBlitFramebufferCall, srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+		}
+		GLEW_GET_FUN(__glewBlitFramebuffer)(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask, filter);
+	}
+
+	inline void glBufferData(GLenum target, GLsizeiptr size, const void *data, GLenum usage) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glBufferDataCall, data, (size_t)size, target, size, usage);
+		}
+		GLEW_GET_FUN(__glewBufferData)(target, size, data, usage);
+		OpenGLMemory::setBufferSize(target, size);
+	}
+
+	inline void glBufferStorage(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glBufferStorageCall, data, (size_t)size, target, size, flags);
+		}
+		GLEW_GET_FUN(__glewBufferStorage)(target, size, data, flags);
+		OpenGLMemory::setBufferSize(target, size);
+	}
+
+	inline void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void *data) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glBufferSubDataCall, data, (size_t)size, target, offset, size);
+		}
+		GLEW_GET_FUN(__glewBufferSubData)(target, offset, size, data);
+	}
+
+	inline GLenum glCheckFramebufferStatus(GLenum target) {
+		GLenum status = GLEW_GET_FUN(__glewCheckFramebufferStatus)(target);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glCheckFramebufferStatusCall, target, status);
+		}
+		return status;
+	}
+
+	inline void glClear(GLbitfield mask) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glClearCall, mask);
+		}
+		::glClear(mask);
+	}
+
+	inline void glClearColor(GLclampf red, GLclampf green, GLclampf blue, GLclampf alpha) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glClearColorCall, red, green, blue, alpha);
+		}
+		::glClearColor(red, green, blue, alpha);
+	}
+
+	inline void glClearDepth(GLclampd depth) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glClearDepthCall, depth);
+		}
+		::glClearDepth(depth);
+	}
+
+	inline GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glClientWaitSyncCall, sync, flags, timeout);
+		}
+		return GLEW_GET_FUN(__glewClientWaitSync)(sync, flags, timeout);
+	}
+
+	inline void glCompileShader(GLuint shader) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(shaderObject, shader);
+			OpenGLTrace::record(glCompileShaderCall, shader);
+		}
+		GLEW_GET_FUN(__glewCompileShader)(shader);
+	}
+
+	inline void glCopyImageSubData(GLuint srcName, GLenum srcTarget, GLint srcLevel, GLint srcX, GLint srcY, GLint srcZ, GLuint dstName, GLenum dstTarget, GLint dstLevel, GLint dstX, GLint dstY, GLint dstZ, GLsizei srcWidth, GLsizei srcHeight, GLsizei srcDepth) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(srcTarget == GL_RENDERBUFFER ? renderbufferObject : textureObject, srcName);
+			OpenGLTrace::reference(dstTarget == GL_RENDERBUFFER ? renderbufferObject : textureObject, dstName);
+			OpenGLTrace::record(glCopyImageSubDataCall, srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
+		}
+		GLEW_GET_FUN(__glewCopyImageSubData)(srcName, srcTarget, srcLevel, srcX, srcY, srcZ, dstName, dstTarget, dstLevel, dstX, dstY, dstZ, srcWidth, srcHeight, srcDepth);
+	}
+
+	inline GLuint glCreateProgram() {
+		GLuint program = GLEW_GET_FUN(__glewCreateProgram)();
+		OpenGLTrace::addObjects(programObject, 1, &program);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glCreateProgramCall, program);
+		}
+		return program;
+	}
+
+	inline GLuint glCreateShader(GLenum type) {
+		GLuint shader = GLEW_GET_FUN(__glewCreateShader)(type);
+		OpenGLTrace::addObjects(shaderObject, 1, &shader);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glCreateShaderCall, type, shader);
+		}
+		return shader;
+	}
+
+	inline void glDeleteBuffers(GLsizei n, const GLuint *buffers) {
+		OpenGLTrace::removeObjects(bufferObject, n, buffers);
+		OpenGLMemory::removeBuffers(n, buffers);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glDeleteBuffersCall, n, buffers);
+		}
+		GLEW_GET_FUN(__glewDeleteBuffers)(n, buffers);
+	}
+
+	inline void glDeleteFramebuffers(GLsizei n, const GLuint *framebuffers) {
+		OpenGLTrace::removeObjects(framebufferObject, n, framebuffers);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glDeleteFramebuffersCall, n, framebuffers);
+		}
+		GLEW_GET_FUN(__glewDeleteFramebuffers)(n, framebuffers);
+	}
+
+	inline void glDeleteProgram(GLuint program) {
+		OpenGLTrace::removeObjects(programObject, 1, &program);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glDeleteProgramCall, program);
+		}
+		GLEW_GET_FUN(__glewDeleteProgram)(program);
+	}
+
+	inline void glDeleteQueries(GLsizei n, const GLuint *ids) {
+		OpenGLTrace::removeObjects(queryObject, n, ids);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glDeleteQueriesCall, n, ids);
+		}
+		GLEW_GET_FUN(__glewDeleteQueries)(n, ids);
+	}
+
+	inline void glDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers) {
+		OpenGLTrace::removeObjects(renderbufferObject, n, renderbuffers);
+		OpenGLMemory::removeRenderbuffers(n, renderbuffers);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glDeleteRenderbuffersCall, n, renderbuffers);
+		}
+		GLEW_GET_FUN(__glewDeleteRenderbuffers)(n, renderbuffers);
+	}
+
+	inline void glDeleteShader(GLuint shader) {
+		OpenGLTrace::removeObjects(shaderObject, 1, &shader);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glDeleteShaderCall, shader);
+		}
+		GLEW_GET_FUN(__glewDeleteShader)(shader);
+	}
+
+	inline void glDeleteSync(GLsync sync) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glDeleteSyncCall, sync);
+		}
+		GLEW_GET_FUN(__glewDeleteSync)(sync);
+	}
+
+	inline void glDeleteTextures(GLsizei n, const GLuint *textures) {
+		OpenGLTrace::removeObjects(textureObject, n, textures);
+		OpenGLMemory::removeTextures(n, textures);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glDeleteTexturesCall, n, textures);
+		}
+		::glDeleteTextures(n, textures);
+	}
+
+	inline void glDeleteVertexArrays(GLsizei n, const GLuint *arrays) {
+		OpenGLTrace::removeObjects(vertexArrayObject, n, arrays);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glDeleteVertexArraysCall, n, arrays);
+		}
+		GLEW_GET_FUN(__glewDeleteVertexArrays)(n, arrays);
+	}
+
+	inline void glDepthMask(GLboolean flag) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glDepthMaskCall, flag);
+		}
+		::glDepthMask(flag);
+	}
+
+	inline void glDisable(GLenum cap) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glDisableCall, cap);
+		}
+		::glDisable(cap);
+	}
+
+	inline void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			OpenGLTrace::record(glDrawArraysCall, mode, first, count);
+		}
+		::glDrawArrays(mode, first, count);
+	}
+
+	inline void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei primcount) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			OpenGLTrace::record(glDrawArraysInstancedCall, mode, first, count, primcount);
+		}
+		GLEW_GET_FUN(__glewDrawArraysInstanced)(mode, first, count, primcount);
+	}
+
+	inline void glDrawArraysInstancedBaseInstance(GLenum mode, GLint first, GLsizei count, GLsizei primcount, GLuint baseinstance) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			OpenGLTrace::record(glDrawArraysInstancedBaseInstanceCall, mode, first, count, primcount, baseinstance);
+		}
+		GLEW_GET_FUN(__glewDrawArraysInstancedBaseInstance)(mode, first, count, primcount, baseinstance);
+	}
+
+	inline void glDrawBuffer(GLenum mode) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glDrawBufferCall, mode);
+		}
+		::glDrawBuffer(mode);
+	}
+
+	inline void glDrawBuffers(GLsizei n, const GLenum *bufs) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glDrawBuffersCall, bufs, (size_t)n * sizeof(GLenum), n);
+		}
+		GLEW_GET_FUN(__glewDrawBuffers)(n, bufs);
+	}
+
+	inline void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void *indices) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			const void *client = OpenGLTrace::getClientData(GL_ELEMENT_ARRAY_BUFFER, indices);
+			OpenGLTrace::recordBlob(glDrawElementsCall, client, (size_t)count * OpenGLTrace::getTypeSize(type), mode, count, type, indices);
+		}
+		::glDrawElements(mode, count, type, indices);
+	}
+
+	inline void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			const void *client = OpenGLTrace::getClientData(GL_ELEMENT_ARRAY_BUFFER, indices);
+			OpenGLTrace::recordBlob(glDrawElementsInstancedCall, client, (size_t)count * OpenGLTrace::getTypeSize(type), mode, count, type, indices, primcount);
+		}
+		GLEW_GET_FUN(__glewDrawElementsInstanced)(mode, count, type, indices, primcount);
+	}
+
+	inline void glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount, GLint basevertex) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			const void *client = OpenGLTrace::getClientData(GL_ELEMENT_ARRAY_BUFFER, indices);
+			OpenGLTrace::recordBlob(glDrawElementsInstancedBaseVertexCall, client, (size_t)count * OpenGLTrace::getTypeSize(type), mode, count, type, indices, primcount, basevertex);
+		}
+		GLEW_GET_FUN(__glewDrawElementsInstancedBaseVertex)(mode, count, type, indices, primcount, basevertex);
+	}
+
+	inline void glDrawElementsInstancedBaseVertexBaseInstance(GLenum mode, GLsizei count, GLenum type, const void *indices, GLsizei primcount, GLint basevertex, GLuint baseinstance) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			const void *client = OpenGLTrace::getClientData(GL_ELEMENT_ARRAY_BUFFER, indices);
+			OpenGLTrace::recordBlob(glDrawElementsInstancedBaseVertexBaseInstanceCall, client, (size_t)count * OpenGLTrace::getTypeSize(type), mode, count, type, indices, primcount, basevertex, baseinstance);
+		}
+		GLEW_GET_FUN(__glewDrawElementsInstancedBaseVertexBaseInstance)(mode, count, type, indices, primcount, basevertex, baseinstance);
+	}
+
+	inline void glEnable(GLenum cap) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glEnableCall, cap);
+		}
+		::glEnable(cap);
+	}
+
+	inline void glEnableVertexAttribArray(GLuint index) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glEnableVertexAttribArrayCall, index);
+		}
+		GLEW_GET_FUN(__glewEnableVertexAttribArray)(index);
+	}
+
+	inline GLsync glFenceSync(GLenum condition, GLbitfield flags) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+		}
+		GLsync sync = GLEW_GET_FUN(__glewFenceSync)(condition, flags);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glFenceSyncCall, condition, flags, sync);
+		}
+		return sync;
+	}
+
+	inline void glFramebufferRenderbuffer(GLenum target, GLenum attachment, GLenum renderbuffertarget, GLuint renderbuffer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(renderbufferObject, renderbuffer);
+			OpenGLTrace::record(glFramebufferRenderbufferCall, target, attachment, renderbuffertarget, renderbuffer);
+		}
+		GLEW_GET_FUN(__glewFramebufferRenderbuffer)(target, attachment, renderbuffertarget, renderbuffer);
+	}
+
+	inline void glFramebufferTexture2D(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(textureObject, texture);
+			OpenGLTrace::record(glFramebufferTexture2DCall, target, attachment, textarget, texture, level);
+		}
+		GLEW_GET_FUN(__glewFramebufferTexture2D)(target, attachment, textarget, texture, level);
+	}
+
+	inline void glFramebufferTextureLayer(GLenum target, GLenum attachment, GLuint texture, GLint level, GLint layer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(textureObject, texture);
+			OpenGLTrace::record(glFramebufferTextureLayerCall, target, attachment, texture, level, layer);
+		}
+		GLEW_GET_FUN(__glewFramebufferTextureLayer)(target, attachment, texture, level, layer);
+	}
+
+	inline void glGenBuffers(GLsizei n, GLuint *buffers) {
+		GLEW_GET_FUN(__glewGenBuffers)(n, buffers);
+		OpenGLTrace::addObjects(bufferObject, n, buffers);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glGenBuffersCall, n, buffers);
+		}
+	}
+
+	inline void glGenFramebuffers(GLsizei n, GLuint *framebuffers) {
+		GLEW_GET_FUN(__glewGenFramebuffers)(n, framebuffers);
+		OpenGLTrace::addObjects(framebufferObject, n, framebuffers);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glGenFramebuffersCall, n, framebuffers);
+		}
+	}
+
+	inline void glGenQueries(GLsizei n, GLuint *ids) {
+		GLEW_GET_FUN(__glewGenQueries)(n, ids);
+		OpenGLTrace::addObjects(queryObject, n, ids);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glGenQueriesCall, n, ids);
+		}
+	}
+
+	inline void glGenRenderbuffers(GLsizei n, GLuint *renderbuffers) {
+		GLEW_GET_FUN(__glewGenRenderbuffers)(n, renderbuffers);
+		OpenGLTrace::addObjects(renderbufferObject, n, renderbuffers);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glGenRenderbuffersCall, n, renderbuffers);
+		}
+	}
+
+	inline void glGenTextures(GLsizei n, GLuint *textures) {
+		::glGenTextures(n, textures);
+		OpenGLTrace::addObjects(textureObject, n, textures);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glGenTexturesCall, n, textures);
+		}
+	}
+
+	inline void glGenVertexArrays(GLsizei n, GLuint *arrays) {
+		GLEW_GET_FUN(__glewGenVertexArrays)(n, arrays);
+		OpenGLTrace::addObjects(vertexArrayObject, n, arrays);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordNames(glGenVertexArraysCall, n, arrays);
+		}
+	}
+
+	inline void glGetBooleanv(GLenum pname, GLboolean *params) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glGetBooleanvCall, pname);
+		}
+		::glGetBooleanv(pname, params);
+	}
+
+	inline GLenum glGetError() {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glGetErrorCall);
+		}
+		return ::glGetError();
+	}
+
+	inline void glGetIntegerv(GLenum pname, GLint *params) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glGetIntegervCall, pname);
+		}
+		::glGetIntegerv(pname, params);
+	}
+
+	inline void glGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length, GLchar *infoLog) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(programObject, program);
+			OpenGLTrace::record(glGetProgramInfoLogCall, program, bufSize);
+		}
+		GLEW_GET_FUN(__glewGetProgramInfoLog)(program, bufSize, length, infoLog);
+	}
+
+	inline void glGetProgramiv(GLuint program, GLenum pname, GLint *param) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(programObject, program);
+			OpenGLTrace::record(glGetProgramivCall, program, pname);
+		}
+		GLEW_GET_FUN(__glewGetProgramiv)(program, pname, param);
+	}
+
+	inline void glGetQueryObjectiv(GLuint id, GLenum pname, GLint *params) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(queryObject, id);
+			OpenGLTrace::record(glGetQueryObjectivCall, id, pname);
+		}
+		GLEW_GET_FUN(__glewGetQueryObjectiv)(id, pname, params);
+	}
+
+	inline void glGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(queryObject, id);
+			OpenGLTrace::record(glGetQueryObjectui64vCall, id, pname);
+		}
+		GLEW_GET_FUN(__glewGetQueryObjectui64v)(id, pname, params);
+	}
+
+	inline void glGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length, GLchar *infoLog) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(shaderObject, shader);
+			OpenGLTrace::record(glGetShaderInfoLogCall, shader, bufSize);
+		}
+		GLEW_GET_FUN(__glewGetShaderInfoLog)(shader, bufSize, length, infoLog);
+	}
+
+	inline void glGetShaderiv(GLuint shader, GLenum pname, GLint *param) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(shaderObject, shader);
+			OpenGLTrace::record(glGetShaderivCall, shader, pname);
+		}
+		GLEW_GET_FUN(__glewGetShaderiv)(shader, pname, param);
+	}
+
+	inline GLint glGetUniformLocation(GLuint program, const GLchar *name) {
+		GLint location = GLEW_GET_FUN(__glewGetUniformLocation)(program, name);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(programObject, program);
+			OpenGLTrace::recordBlob(glGetUniformLocationCall, name, strlen(name), program, location);
+		}
+		return location;
+	}
+
+	inline GLboolean glIsEnabled(GLenum cap) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glIsEnabledCall, cap);
+		}
+		return ::glIsEnabled(cap);
+	}
+
+	inline void glLinkProgram(GLuint program) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(programObject, program);
+			OpenGLTrace::record(glLinkProgramCall, program);
+		}
+		GLEW_GET_FUN(__glewLinkProgram)(program);
+	}
+
+	inline void *glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+		GLuint buffer = OpenGLTrace::getBoundBuffer(target);
+		void *pointer = GLEW_GET_FUN(__glewMapBufferRange)(target, offset, length, access);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glMapBufferRangeCall, target, offset, length, access, buffer);
+		}
+		OpenGLTrace::addMapping(buffer, offset, length, access, pointer);
+		return pointer;
+	}
+
+	inline void glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void *indirect, GLsizei primcount, GLsizei stride) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::flushMappedWrites();
+			const void *client = OpenGLTrace::getClientData(GL_DRAW_INDIRECT_BUFFER, indirect);
+			OpenGLTrace::recordBlob(glMultiDrawElementsIndirectCall, client, (size_t)primcount * (stride != 0 ? (size_t)stride : 5 * sizeof(GLuint)), mode, type, indirect, primcount, stride);
+		}
+		GLEW_GET_FUN(__glewMultiDrawElementsIndirect)(mode, type, indirect, primcount, stride);
+	}
+
+	inline void glPixelStorei(GLenum pname, GLint param) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glPixelStoreiCall, pname, param);
+		}
+		::glPixelStorei(pname, param);
+	}
+
+	inline void glPolygonOffset(GLfloat factor, GLfloat units) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glPolygonOffsetCall, factor, units);
+		}
+		::glPolygonOffset(factor, units);
+	}
+
+	inline void glQueryCounter(GLuint id, GLenum target) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(queryObject, id);
+			OpenGLTrace::record(glQueryCounterCall, id, target);
+		}
+		GLEW_GET_FUN(__glewQueryCounter)(id, target);
+	}
+
+	inline void glReadBuffer(GLenum mode) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glReadBufferCall, mode);
+		}
+		::glReadBuffer(mode);
+	}
+
+	inline void glReadPixels(GLint x, GLint y, GLsizei width, GLsizei height, GLenum format, GLenum type, void *pixels) {
+		if (OpenGLTrace::isCapturing()) {
+			// Reading into client memory replays into a scratch buffer, only offsets into a pack buffer are kept
+			bool packBuffer = OpenGLTrace::getBoundBuffer(GL_PIXEL_PACK_BUFFER) != 0;
+			OpenGLTrace::record(glReadPixelsCall, x, y, width, height, format, type, pixels, packBuffer);
+		}
+		::glReadPixels(x, y, width, height, format, type, pixels);
+	}
+
+	inline void glRenderbufferStorageMultisample(GLenum target, GLsizei samples, GLenum internalformat, GLsizei width, GLsizei height) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glRenderbufferStorageMultisampleCall, target, samples, internalformat, width, height);
+		}
+		GLEW_GET_FUN(__glewRenderbufferStorageMultisample)(target, samples, internalformat, width, height);
+		OpenGLMemory::setRenderbufferStorage(samples, internalformat, width, height);
+	}
+
+	inline void glShaderSource(GLuint shader, GLsizei count, const GLchar *const *string, const GLint *length) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(shaderObject, shader);
+			OpenGLTrace::recordShaderSource(shader, count, string, length);
+		}
+		GLEW_GET_FUN(__glewShaderSource)(shader, count, string, length);
+	}
+
+	inline void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void *pixels) {
+		OpenGLTrace::setTextureTarget(target);
+		if (OpenGLTrace::isCapturing()) {
+			const void *client = OpenGLTrace::getClientData(GL_PIXEL_UNPACK_BUFFER, pixels);
+			OpenGLTrace::recordBlob(glTexImage2DCall, client, client ? OpenGLTrace::getImageSize(width, height, 1, format, type) : 0, target, level, internalformat, width, height, border, format, type, pixels);
+		}
+		::glTexImage2D(target, level, internalformat, width, height, border, format, type, pixels);
+		OpenGLMemory::setTextureImage(target, level, internalformat, width, height, 1);
+	}
+
+	inline void glTexImage3D(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void *pixels) {
+		OpenGLTrace::setTextureTarget(target);
+		if (OpenGLTrace::isCapturing()) {
+			const void *client = OpenGLTrace::getClientData(GL_PIXEL_UNPACK_BUFFER, pixels);
+			OpenGLTrace::recordBlob(glTexImage3DCall, client, client ? OpenGLTrace::getImageSize(width, height, depth, format, type) : 0, target, level, internalFormat, width, height, depth, border, format, type, pixels);
+		}
+		GLEW_GET_FUN(__glewTexImage3D)(target, level, internalFormat, width, height, depth, border, format, type, pixels);
+		OpenGLMemory::setTextureImage(target, level, internalFormat, width, height, depth);
+	}
+
+	inline void glTexParameteri(GLenum target, GLenum pname, GLint param) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glTexParameteriCall, target, pname, param);
+		}
+		::glTexParameteri(target, pname, param);
+	}
+
+	inline void glTexSubImage2D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width, GLsizei height, GLenum format, GLenum type, const void *pixels) {
+		if (OpenGLTrace::isCapturing()) {
+			const void *client = OpenGLTrace::getClientData(GL_PIXEL_UNPACK_BUFFER, pixels);
+			OpenGLTrace::recordBlob(glTexSubImage2DCall, client, client ? OpenGLTrace::getImageSize(width, height, 1, format, type) : 0, target, level, xoffset, yoffset, width, height, format, type, pixels);
+		}
+		::glTexSubImage2D(target, level, xoffset, yoffset, width, height, format, type, pixels);
+	}
+
+	inline void glTexSubImage3D(GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void *pixels) {
+		if (OpenGLTrace::isCapturing()) {
+			const void *client = OpenGLTrace::getClientData(GL_PIXEL_UNPACK_BUFFER, pixels);
+			OpenGLTrace::recordBlob(glTexSubImage3DCall, client, client ? OpenGLTrace::getImageSize(width, height, depth, format, type) : 0, target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+		}
+		GLEW_GET_FUN(__glewTexSubImage3D)(target, level, xoffset, yoffset, zoffset, width, height, depth, format, type, pixels);
+	}
+
+	inline void glUniform1f(GLint location, GLfloat v0) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glUniform1fCall, location, v0);
+		}
+		GLEW_GET_FUN(__glewUniform1f)(location, v0);
+	}
+
+	inline void glUniform1i(GLint location, GLint v0) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glUniform1iCall, location, v0);
+		}
+		GLEW_GET_FUN(__glewUniform1i)(location, v0);
+	}
+
+	inline void glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glUniform2fCall, location, v0, v1);
+		}
+		GLEW_GET_FUN(__glewUniform2f)(location, v0, v1);
+	}
+
+	inline void glUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glUniform3fvCall, value, (size_t)count * 3 * sizeof(GLfloat), location, count);
+		}
+		GLEW_GET_FUN(__glewUniform3fv)(location, count, value);
+	}
+
+	inline void glUniform3ui(GLint location, GLuint v0, GLuint v1, GLuint v2) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glUniform3uiCall, location, v0, v1, v2);
+		}
+		GLEW_GET_FUN(__glewUniform3ui)(location, v0, v1, v2);
+	}
+
+	inline void glUniform4fv(GLint location, GLsizei count, const GLfloat *value) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glUniform4fvCall, value, (size_t)count * 4 * sizeof(GLfloat), location, count);
+		}
+		GLEW_GET_FUN(__glewUniform4fv)(location, count, value);
+	}
+
+	inline void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat *value) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::recordBlob(glUniformMatrix4fvCall, value, (size_t)count * 16 * sizeof(GLfloat), location, count, transpose);
+		}
+		GLEW_GET_FUN(__glewUniformMatrix4fv)(location, count, transpose, value);
+	}
+
+	inline GLboolean glUnmapBuffer(GLenum target) {
+		GLuint buffer = OpenGLTrace::getBoundBuffer(target);
+		OpenGLTrace::removeMapping(buffer);
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glUnmapBufferCall, target, buffer);
+		}
+		return GLEW_GET_FUN(__glewUnmapBuffer)(target);
+	}
+
+	inline void glUseProgram(GLuint program) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::reference(programObject, program);
+			OpenGLTrace::record(glUseProgramCall, program);
+		}
+		GLEW_GET_FUN(__glewUseProgram)(program);
+	}
+
+	inline void glVertexAttribBinding(GLuint attribindex, GLuint bindingindex) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glVertexAttribBindingCall, attribindex, bindingindex);
+		}
+		GLEW_GET_FUN(__glewVertexAttribBinding)(attribindex, bindingindex);
+	}
+
+	inline void glVertexAttribFormat(GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glVertexAttribFormatCall, attribindex, size, type, normalized, relativeoffset);
+		}
+		GLEW_GET_FUN(__glewVertexAttribFormat)(attribindex, size, type, normalized, relativeoffset);
+	}
+
+	inline void glVertexAttribIPointer(GLuint index, GLint size, GLenum type, GLsizei stride, const void *pointer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glVertexAttribIPointerCall, index, size, type, stride, pointer);
+		}
+		GLEW_GET_FUN(__glewVertexAttribIPointer)(index, size, type, stride, pointer);
+	}
+
+	inline void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void *pointer) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glVertexAttribPointerCall, index, size, type, normalized, stride, pointer);
+		}
+		GLEW_GET_FUN(__glewVertexAttribPointer)(index, size, type, normalized, stride, pointer);
+	}
+
+	inline void glVertexBindingDivisor(GLuint bindingindex, GLuint divisor) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glVertexBindingDivisorCall, bindingindex, divisor);
+		}
+		GLEW_GET_FUN(__glewVertexBindingDivisor)(bindingindex, divisor);
+	}
+
+	inline void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+		if (OpenGLTrace::isCapturing()) {
+			OpenGLTrace::record(glViewportCall, x, y, width, height);
+		}
+		::glViewport(x, y, width, height);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -19,7 +19,14 @@
 #		define ENCOOPENGLAPI __declspec(dllimport)
 #	endif
 #else
+#	include <GL/glew.h>
+
 #	define ENCOOPENGLAPI
 #endif
 
+// Inside the library every GL call goes through the capture layer of OpenGLRenderer::captureFrame() and OpenGLMemory
+#ifdef ENCOOPENGL_EXPORTS
+#	include "OpenGLTrace.h"
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,224 @@
+#include "stdafx.h"
+#include "AabbTree.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		// Fat boxes reach this many steps of displacement ahead
+		const f32 displacementMultiplier = 4.0f;
+	}
+
+	ENCOSHAREDAPI AabbTree::AabbTree(f32 margin) : m_root(nullNode), m_freeList(nullNode), m_proxyCount(0), m_margin(margin) {
+	}
+
+	ENCOSHAREDAPI u32 AabbTree::createProxy(const AABB &box, u32 userData) {
+		u32 proxy = allocateNode();
+		Node &node = m_nodes[proxy];
+		node.box = AABB(box.min - glm::vec3(m_margin), box.max + glm::vec3(m_margin));
+		node.userData = userData;
+		node.height = 0;
+		insertLeaf(proxy);
+		++m_proxyCount;
+		return proxy;
+	}
+
+	ENCOSHAREDAPI void AabbTree::destroyProxy(u32 proxy) {
+		removeLeaf(proxy);
+		freeNode(proxy);
+		--m_proxyCount;
+	}
+
+	ENCOSHAREDAPI bool AabbTree::moveProxy(u32 proxy, const AABB &box, const glm::vec3 &displacement) {
+		const AABB &fat = m_nodes[proxy].box;
+		if (fat.min.x <= box.min.x && fat.min.y <= box.min.y && fat.min.z <= box.min.z && fat.max.x >= box.max.x && fat.max.y >= box.max.y && fat.max.z >= box.max.z) {
+			return false;
+		}
+
+		removeLeaf(proxy);
+
+		AABB moved(box.min - glm::vec3(m_margin), box.max + glm::vec3(m_margin));
+		glm::vec3 ahead = displacement * displacementMultiplier;
+		moved.min += glm::min(ahead, glm::vec3(0.0f));
+		moved.max += glm::max(ahead, glm::vec3(0.0f));
+		m_nodes[proxy].box = moved;
+
+		insertLeaf(proxy);
+		return true;
+	}
+
+	ENCOSHAREDAPI uint AabbTree::getHeight() const {
+		return m_root == nullNode ? 0 : (uint)m_nodes[m_root].height;
+	}
+
+	ENCOSHAREDAPI void AabbTree::clear() {
+		m_nodes.clear();
+		m_root = m_freeList = nullNode;
+		m_proxyCount = 0;
+	}
+
+	u32 AabbTree::allocateNode() {
+		if (m_freeList == nullNode) {
+			m_nodes.push_back(Node());
+			m_freeList = (u32)(m_nodes.size() - 1);
+			m_nodes.back().parent = nullNode;
+		}
+
+		u32 index = m_freeList;
+		Node &node = m_nodes[index];
+		m_freeList = node.parent;
+		node.parent = nullNode;
+		node.children[0] = node.children[1] = nullNode;
+		node.userData = 0;
+		node.height = 0;
+		return index;
+	}
+
+	void AabbTree::freeNode(u32 node) {
+		m_nodes[node].parent = m_freeList;
+		m_nodes[node].height = -1;
+		m_freeList = node;
+	}
+
+	void AabbTree::insertLeaf(u32 leaf) {
+		if (m_root == nullNode) {
+			m_root = leaf;
+			m_nodes[leaf].parent = nullNode;
+			return;
+		}
+
+		// Walk down to the sibling that adds the least area to the tree, counting the growth of every ancestor
+		AABB box = m_nodes[leaf].box;
+		u32 index = m_root;
+		while (!m_nodes[index].isLeaf()) {
+			const Node &node = m_nodes[index];
+			f32 area = getArea(node.box);
+			f32 combinedArea = getArea(combine(node.box, box));
+			// Pairing with this node makes a new parent, descending pushes the leaf further down
+			f32 cost = 2.0f * combinedArea;
+			f32 inheritedCost = 2.0f * (combinedArea - area);
+
+			f32 childCosts[2];
+			for (uint i = 0; i < 2; ++i) {
+				const Node &child = m_nodes[node.children[i]];
+				f32 grown = getArea(combine(child.box, box));
+				childCosts[i] = (child.isLeaf() ? grown : grown - getArea(child.box)) + inheritedCost;
+			}
+
+			if (cost < childCosts[0] && cost < childCosts[1]) {
+				break;
+			}
+			index = childCosts[0] < childCosts[1] ? node.children[0] : node.children[1];
+		}
+
+		u32 sibling = index;
+		u32 oldParent = m_nodes[sibling].parent;
+		u32 newParent = allocateNode();
+		m_nodes[newParent].parent = oldParent;
+		m_nodes[newParent].box = combine(box, m_nodes[sibling].box);
+		m_nodes[newParent].height = m_nodes[sibling].height + 1;
+		m_nodes[newParent].children[0] = sibling;
+		m_nodes[newParent].children[1] = leaf;
+		m_nodes[sibling].parent = newParent;
+		m_nodes[leaf].parent = newParent;
+
+		if (oldParent == nullNode) {
+			m_root = newParent;
+		}
+		else if (m_nodes[oldParent].children[0] == sibling) {
+			m_nodes[oldParent].children[0] = newParent;
+		}
+		else {
+			m_nodes[oldParent].children[1] = newParent;
+		}
+
+		refit(m_nodes[leaf].parent);
+	}
+
+	void AabbTree::removeLeaf(u32 leaf) {
+		if (leaf == m_root) {
+			m_root = nullNode;
+			return;
+		}
+
+		// The sibling takes the place of the parent
+		u32 parent = m_nodes[leaf].parent;
+		u32 grandParent = m_nodes[parent].parent;
+		u32 sibling = m_nodes[parent].children[0] == leaf ? m_nodes[parent].children[1] : m_nodes[parent].children[0];
+
+		if (grandParent == nullNode) {
+			m_root = sibling;
+			m_nodes[sibling].parent = nullNode;
+			freeNode(parent);
+			return;
+		}
+
+		if (m_nodes[grandParent].children[0] == parent) {
+			m_nodes[grandParent].children[0] = sibling;
+		}
+		else {
+			m_nodes[grandParent].children[1] = sibling;
+		}
+		m_nodes[sibling].parent = grandParent;
+		freeNode(parent);
+
+		refit(grandParent);
+	}
+
+	void AabbTree::refit(u32 index) {
+		while (index != nullNode) {
+			rotate(index);
+
+			Node &node = m_nodes[index];
+			const Node &left = m_nodes[node.children[0]], &right = m_nodes[node.children[1]];
+			node.height = 1 + std::max(left.height, right.height);
+			node.box = combine(left.box, right.box);
+			index = node.parent;
+		}
+	}
+
+	void AabbTree::rotate(u32 a) {
+		// Swaps a child of a with a grandchild on the other side when that shrinks the surface area of the
+		// child it moves into. Unlike height balancing this keeps the tree tight while proxies keep moving.
+		Node &nodeA = m_nodes[a];
+		if (nodeA.height < 2) {
+			return;
+		}
+
+		u32 children[2] = { nodeA.children[0], nodeA.children[1] };
+		f32 bestGain = 0.0f;
+		uint bestSide = 0, bestGrandChild = 0;
+		for (uint side = 0; side < 2; ++side) {
+			// The child of side moves down into the other child, replacing one of its children
+			const Node &lower = m_nodes[children[1 - side]];
+			if (lower.isLeaf()) {
+				continue;
+			}
+			f32 area = getArea(lower.box);
+			const AABB &moved = m_nodes[children[side]].box;
+			for (uint i = 0; i < 2; ++i) {
+				f32 gain = area - getArea(combine(moved, m_nodes[lower.children[1 - i]].box));
+				if (gain > bestGain) {
+					bestGain = gain;
+					bestSide = side;
+					bestGrandChild = i;
+				}
+			}
+		}
+		if (bestGain <= 0.0f) {
+			return;
+		}
+
+		u32 down = children[bestSide], lower = children[1 - bestSide];
+		Node &nodeLower = m_nodes[lower];
+		u32 up = nodeLower.children[bestGrandChild], stay = nodeLower.children[1 - bestGrandChild];
+
+		nodeA.children[bestSide] = up;
+		m_nodes[up].parent = a;
+		nodeLower.children[bestGrandChild] = down;
+		m_nodes[down].parent = lower;
+
+		nodeLower.box = combine(m_nodes[down].box, m_nodes[stay].box);
+		nodeLower.height = 1 + std::max(m_nodes[down].height, m_nodes[stay].height);
+	}
+}
\ No newline at end of file
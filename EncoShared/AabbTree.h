@@ -0,0 +1,148 @@
+#ifndef __ENCOSHARED_AABBTREE_H__
+#define __ENCOSHARED_AABBTREE_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+
+#include <vector>
+
+namespace enco {
+	// Dynamic bounding volume hierarchy over fattened boxes. A proxy only has to be reinserted when its box leaves
+	// the fat box, so objects that move a little every frame rarely touch the tree. Leaves are inserted where they
+	// add the least surface area and rotations keep the surface area low as proxies move.
+	class AabbTree {
+	public:
+		static const u32 nullNode = 0xFFFFFFFF;
+		// Query stacks hold this many nodes, a balanced tree of a million leaves needs around 40
+		static const uint maxStackDepth = 256;
+
+		ENCOSHAREDAPI AabbTree(f32 margin = 0.1f);
+
+		ENCOSHAREDAPI u32 createProxy(const AABB &box, u32 userData);
+		ENCOSHAREDAPI void destroyProxy(u32 proxy);
+		// Returns true when the proxy was reinserted, displacement extends the fat box in the direction of motion
+		ENCOSHAREDAPI bool moveProxy(u32 proxy, const AABB &box, const glm::vec3 &displacement = glm::vec3(0.0f));
+
+		inline u32 getUserData(u32 proxy) const { return m_nodes[proxy].userData; }
+		inline const AABB &getFatBox(u32 proxy) const { return m_nodes[proxy].box; }
+		inline u32 getRoot() const { return m_root; }
+		inline uint getProxyCount() const { return m_proxyCount; }
+		ENCOSHAREDAPI uint getHeight() const;
+
+		ENCOSHAREDAPI void clear();
+
+		// Calls callback(proxy) for every proxy whose fat box overlaps box, stops when it returns false.
+		// Read only, so any number of threads may query while nobody modifies the tree.
+		template<typename Callback>
+		void query(const AABB &box, Callback &callback) const {
+			if (m_root == nullNode) {
+				return;
+			}
+
+			u32 stack[maxStackDepth];
+			uint size = 0;
+			stack[size++] = m_root;
+			while (size > 0) {
+				const Node &node = m_nodes[stack[--size]];
+				if (!overlaps(node.box, box)) {
+					continue;
+				}
+				if (node.isLeaf()) {
+					if (!callback((u32)(&node - &m_nodes[0]))) {
+						return;
+					}
+				}
+				else if (size + 2 <= maxStackDepth) {
+					stack[size++] = node.children[0];
+					stack[size++] = node.children[1];
+				}
+			}
+		}
+
+		// Calls callback(proxy, maxFraction) for every proxy whose fat box the segment from + (to - from) * t,
+		// t in [0, maxFraction] crosses. The callback returns the new maxFraction: 0 stops, the hit fraction clips
+		// the segment for a closest hit and maxFraction itself continues unchanged.
+		template<typename Callback>
+		void raycast(const glm::vec3 &from, const glm::vec3 &to, Callback &callback) const {
+			if (m_root == nullNode) {
+				return;
+			}
+
+			glm::vec3 direction = to - from;
+			glm::vec3 inverse(direction.x != 0.0f ? 1.0f / direction.x : 1e30f, direction.y != 0.0f ? 1.0f / direction.y : 1e30f, direction.z != 0.0f ? 1.0f / direction.z : 1e30f);
+			f32 maxFraction = 1.0f;
+
+			u32 stack[maxStackDepth];
+			uint size = 0;
+			stack[size++] = m_root;
+			while (size > 0) {
+				const Node &node = m_nodes[stack[--size]];
+				if (!crosses(node.box, from, inverse, maxFraction)) {
+					continue;
+				}
+				if (node.isLeaf()) {
+					maxFraction = callback((u32)(&node - &m_nodes[0]), maxFraction);
+					if (maxFraction <= 0.0f) {
+						return;
+					}
+				}
+				else if (size + 2 <= maxStackDepth) {
+					stack[size++] = node.children[0];
+					stack[size++] = node.children[1];
+				}
+			}
+		}
+
+		static inline bool overlaps(const AABB &a, const AABB &b) {
+			return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+		}
+
+		// Slab test of from + direction * t, t in [0, maxFraction], inverse holds 1 / direction per axis
+		static inline bool crosses(const AABB &box, const glm::vec3 &from, const glm::vec3 &inverse, f32 maxFraction) {
+			glm::vec3 t0 = (box.min - from) * inverse, t1 = (box.max - from) * inverse;
+			glm::vec3 lower = glm::min(t0, t1), upper = glm::max(t0, t1);
+			f32 enter = glm::max(glm::max(lower.x, lower.y), glm::max(lower.z, 0.0f));
+			f32 exit = glm::min(glm::min(upper.x, upper.y), glm::min(upper.z, maxFraction));
+			return enter <= exit;
+		}
+
+	private:
+		struct Node {
+			AABB box;
+			// Parent, or the next free node while the node is unused
+			u32 parent;
+			u32 children[2];
+			u32 userData;
+			// Leaves are 0, free nodes -1
+			i32 height;
+
+			inline bool isLeaf() const { return children[0] == nullNode; }
+		};
+
+		u32 allocateNode();
+		void freeNode(u32 node);
+		void insertLeaf(u32 leaf);
+		void removeLeaf(u32 leaf);
+		void rotate(u32 node);
+		void refit(u32 node);
+
+		static inline f32 getArea(const AABB &box) {
+			glm::vec3 size = box.max - box.min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		static inline AABB combine(const AABB &a, const AABB &b) {
+			return AABB(glm::min(a.min, b.min), glm::max(a.max, b.max));
+		}
+
+		std::vector<Node> m_nodes;
+		u32 m_root;
+		u32 m_freeList;
+		uint m_proxyCount;
+		f32 m_margin;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,273 @@
+#include "stdafx.h"
+#include "AnimationClip.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace enco {
+	namespace {
+		const f32 quaternionRange = 0.70710678f;
+
+		// The largest component is dropped and restored from the unit length, its index goes into the
+		// top bits of the first two values and the remaining three components into 15 bits each
+		void encodeQuaternion(glm::quat rotation, u16 *out) {
+			f32 components[4] = { rotation.x, rotation.y, rotation.z, rotation.w };
+			uint largest = 0;
+			for (uint i = 1; i < 4; ++i) {
+				if (std::abs(components[i]) > std::abs(components[largest])) {
+					largest = i;
+				}
+			}
+			f32 sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+			for (uint i = 0, j = 0; i < 4; ++i) {
+				if (i == largest) {
+					continue;
+				}
+				f32 normalized = (components[i] * sign / quaternionRange) * 0.5f + 0.5f;
+				out[j++] = (u16)(glm::clamp(normalized, 0.0f, 1.0f) * 32767.0f + 0.5f);
+			}
+			out[0] |= (u16)((largest & 1) << 15);
+			out[1] |= (u16)((largest >> 1) << 15);
+		}
+
+		glm::quat decodeQuaternion(const u16 *in) {
+			uint largest = (in[0] >> 15) | ((in[1] >> 15) << 1);
+			f32 components[4];
+			f32 sum = 0.0f;
+			for (uint i = 0, j = 0; i < 4; ++i) {
+				if (i == largest) {
+					continue;
+				}
+				f32 value = ((in[j++] & 0x7FFF) / 32767.0f * 2.0f - 1.0f) * quaternionRange;
+				components[i] = value;
+				sum += value * value;
+			}
+			components[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+			return glm::quat(components[3], components[0], components[1], components[2]);
+		}
+
+		glm::quat nlerp(const glm::quat &a, const glm::quat &b, f32 weight) {
+			f32 sign = glm::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+			return glm::normalize(a * (1.0f - weight) + b * (weight * sign));
+		}
+
+		void encodeVector(const glm::vec3 &value, const glm::vec3 &minimum, const glm::vec3 &extent, u16 *out) {
+			for (int i = 0; i < 3; ++i) {
+				f32 normalized = extent[i] > 0.0f ? (value[i] - minimum[i]) / extent[i] : 0.0f;
+				out[i] = (u16)(glm::clamp(normalized, 0.0f, 1.0f) * 65535.0f + 0.5f);
+			}
+		}
+
+		glm::vec3 decodeVector(const u16 *in, const glm::vec3 &minimum, const glm::vec3 &extent) {
+			return minimum + glm::vec3(in[0], in[1], in[2]) / 65535.0f * extent;
+		}
+
+		// Greedy reduction: from the last kept key, extend the segment as long as interpolating the
+		// decoded end points stays within tolerance of every source frame inside it
+		template<typename T, typename Interpolate, typename Error>
+		void reduceKeys(const std::vector<T> &source, const std::vector<T> &decoded, f32 tolerance, Interpolate interpolate, Error error, std::vector<u16> &keys) {
+			uint count = (uint)source.size();
+			keys.clear();
+			keys.push_back(0);
+
+			bool constant = true;
+			for (uint i = 1; i < count && constant; ++i) {
+				constant = error(decoded[0], source[i]) <= tolerance;
+			}
+			if (constant) {
+				return;
+			}
+
+			uint start = 0;
+			while (start < count - 1) {
+				uint end = start + 1;
+				while (end + 1 < count) {
+					uint candidate = end + 1;
+					bool fits = true;
+					for (uint i = start + 1; i < candidate && fits; ++i) {
+						f32 weight = (f32)(i - start) / (f32)(candidate - start);
+						fits = error(interpolate(decoded[start], decoded[candidate], weight), source[i]) <= tolerance;
+					}
+					if (!fits) {
+						break;
+					}
+					end = candidate;
+				}
+				keys.push_back((u16)end);
+				start = end;
+			}
+		}
+
+		glm::quat lerpQuaternion(const glm::quat &a, const glm::quat &b, f32 weight) {
+			return nlerp(a, b, weight);
+		}
+
+		f32 quaternionError(const glm::quat &a, const glm::quat &b) {
+			// Angle between the rotations
+			f32 cosHalfAngle = std::min(1.0f, std::abs(glm::dot(a, b)));
+			return 2.0f * std::acos(cosHalfAngle);
+		}
+
+		glm::vec3 lerpVector(const glm::vec3 &a, const glm::vec3 &b, f32 weight) {
+			return a + (b - a) * weight;
+		}
+
+		f32 vectorError(const glm::vec3 &a, const glm::vec3 &b) {
+			return glm::length(a - b);
+		}
+	}
+
+	ENCOSHAREDAPI AnimationClip::AnimationClip() : m_frameCount(0), m_sampleRate(30.0f), m_duration(0.0f) {
+	}
+
+	ENCOSHAREDAPI bool AnimationClip::compress(const std::vector<JointTransform> &poses, uint jointCount, f32 sampleRate, f32 rotationTolerance, f32 translationTolerance, f32 scaleTolerance) {
+		m_tracks.clear();
+		m_frameCount = 0;
+		m_duration = 0.0f;
+
+		uint frameCount = jointCount > 0 ? (uint)(poses.size() / jointCount) : 0;
+		if (frameCount == 0 || frameCount > maxFrames || poses.size() != (size_t)frameCount * jointCount || sampleRate <= 0.0f) {
+#ifdef _DEBUG
+			printf("Animation Error: %u poses do not form frames of %u joints\n", (uint)poses.size(), jointCount);
+#endif
+			return false;
+		}
+
+		m_frameCount = frameCount;
+		m_sampleRate = sampleRate;
+		m_duration = (frameCount - 1) / sampleRate;
+		m_tracks.resize(jointCount);
+
+		std::vector<glm::quat> rotations(frameCount);
+		std::vector<glm::vec3> translations(frameCount), scales(frameCount);
+		for (uint joint = 0; joint < jointCount; ++joint) {
+			for (uint frame = 0; frame < frameCount; ++frame) {
+				const JointTransform &transform = poses[frame * jointCount + joint];
+				rotations[frame] = glm::normalize(transform.rotation);
+				translations[frame] = transform.translation;
+				scales[frame] = transform.scale;
+			}
+
+			Track &track = m_tracks[joint];
+			compressRotations(rotations, rotationTolerance, track.rotation);
+			compressVectors(translations, translationTolerance, track.translation);
+			compressVectors(scales, scaleTolerance, track.scale);
+		}
+		return true;
+	}
+
+	ENCOSHAREDAPI void AnimationClip::sample(f32 time, bool loop, JointTransform *pose) const {
+		if (m_tracks.empty()) {
+			return;
+		}
+
+		if (loop && m_duration > 0.0f) {
+			time = std::fmod(time, m_duration);
+			time = time < 0.0f ? time + m_duration : time;
+		}
+		f32 frame = glm::clamp(time * m_sampleRate, 0.0f, (f32)(m_frameCount - 1));
+
+		for (size_t joint = 0; joint < m_tracks.size(); ++joint) {
+			const Track &track = m_tracks[joint];
+			JointTransform &transform = pose[joint];
+			f32 weight;
+
+			uint key = findKey(track.rotation, frame, weight);
+			transform.rotation = decodeQuaternion(&track.rotation.values[key * 3]);
+			if (weight > 0.0f) {
+				transform.rotation = nlerp(transform.rotation, decodeQuaternion(&track.rotation.values[key * 3 + 3]), weight);
+			}
+
+			key = findKey(track.translation, frame, weight);
+			transform.translation = decodeVector(&track.translation.values[key * 3], track.translation.minimum, track.translation.extent);
+			if (weight > 0.0f) {
+				transform.translation = lerpVector(transform.translation, decodeVector(&track.translation.values[key * 3 + 3], track.translation.minimum, track.translation.extent), weight);
+			}
+
+			key = findKey(track.scale, frame, weight);
+			transform.scale = decodeVector(&track.scale.values[key * 3], track.scale.minimum, track.scale.extent);
+			if (weight > 0.0f) {
+				transform.scale = lerpVector(transform.scale, decodeVector(&track.scale.values[key * 3 + 3], track.scale.minimum, track.scale.extent), weight);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI uint AnimationClip::getKeyCount() const {
+		uint count = 0;
+		for (size_t i = 0; i < m_tracks.size(); ++i) {
+			count += (uint)(m_tracks[i].rotation.frames.size() + m_tracks[i].translation.frames.size() + m_tracks[i].scale.frames.size());
+		}
+		return count;
+	}
+
+	ENCOSHAREDAPI size_t AnimationClip::getByteSize() const {
+		size_t size = m_tracks.size() * sizeof(Track);
+		for (size_t i = 0; i < m_tracks.size(); ++i) {
+			const Channel *channels[3] = { &m_tracks[i].rotation, &m_tracks[i].translation, &m_tracks[i].scale };
+			for (int j = 0; j < 3; ++j) {
+				size += (channels[j]->frames.size() + channels[j]->values.size()) * sizeof(u16);
+			}
+		}
+		return size;
+	}
+
+	void AnimationClip::compressRotations(const std::vector<glm::quat> &rotations, f32 tolerance, Channel &channel) {
+		channel.minimum = glm::vec3(0.0f);
+		channel.extent = glm::vec3(0.0f);
+
+		std::vector<u16> encoded(rotations.size() * 3);
+		std::vector<glm::quat> decoded(rotations.size());
+		for (size_t i = 0; i < rotations.size(); ++i) {
+			encodeQuaternion(rotations[i], &encoded[i * 3]);
+			decoded[i] = decodeQuaternion(&encoded[i * 3]);
+		}
+
+		reduceKeys(rotations, decoded, tolerance, lerpQuaternion, quaternionError, channel.frames);
+		channel.values.resize(channel.frames.size() * 3);
+		for (size_t i = 0; i < channel.frames.size(); ++i) {
+			memcpy(&channel.values[i * 3], &encoded[channel.frames[i] * 3], 3 * sizeof(u16));
+		}
+	}
+
+	void AnimationClip::compressVectors(const std::vector<glm::vec3> &vectors, f32 tolerance, Channel &channel) {
+		glm::vec3 minimum = vectors[0], maximum = vectors[0];
+		for (size_t i = 1; i < vectors.size(); ++i) {
+			minimum = glm::min(minimum, vectors[i]);
+			maximum = glm::max(maximum, vectors[i]);
+		}
+		channel.minimum = minimum;
+		channel.extent = maximum - minimum;
+
+		std::vector<u16> encoded(vectors.size() * 3);
+		std::vector<glm::vec3> decoded(vectors.size());
+		for (size_t i = 0; i < vectors.size(); ++i) {
+			encodeVector(vectors[i], channel.minimum, channel.extent, &encoded[i * 3]);
+			decoded[i] = decodeVector(&encoded[i * 3], channel.minimum, channel.extent);
+		}
+
+		reduceKeys(vectors, decoded, tolerance, lerpVector, vectorError, channel.frames);
+		channel.values.resize(channel.frames.size() * 3);
+		for (size_t i = 0; i < channel.frames.size(); ++i) {
+			memcpy(&channel.values[i * 3], &encoded[channel.frames[i] * 3], 3 * sizeof(u16));
+		}
+	}
+
+	uint AnimationClip::findKey(const Channel &channel, f32 frame, f32 &weight) {
+		weight = 0.0f;
+		if (channel.frames.size() < 2) {
+			return 0;
+		}
+
+		// First key after the frame, the one before it starts the segment
+		std::vector<u16>::const_iterator next = std::upper_bound(channel.frames.begin(), channel.frames.end(), (u16)frame);
+		if (next == channel.frames.end()) {
+			return (uint)channel.frames.size() - 1;
+		}
+
+		uint key = (uint)(next - channel.frames.begin()) - 1;
+		weight = (frame - channel.frames[key]) / (f32)(channel.frames[key + 1] - channel.frames[key]);
+		return key;
+	}
+}
\ No newline at end of file
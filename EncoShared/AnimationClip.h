@@ -0,0 +1,62 @@
+#ifndef __ENCOSHARED_ANIMATIONCLIP_H__
+#define __ENCOSHARED_ANIMATIONCLIP_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Skeleton.h"
+
+#include <vector>
+
+namespace enco {
+	// Compressed joint animation. Every joint has a rotation, translation and scale channel of keyframes:
+	// rotations are quantized with the smallest-three encoding into 48 bits, translations and scales into
+	// 16 bits per component over the range of the channel. Keys that linear interpolation between their
+	// neighbours reproduces within the tolerances are dropped, a constant channel keeps a single key.
+	class AnimationClip {
+	public:
+		static const uint maxFrames = 65536;
+
+		ENCOSHAREDAPI AnimationClip();
+
+		// poses holds frameCount * jointCount transforms, all joints of frame 0 first.
+		// rotationTolerance is in radians, the others in units of the channel.
+		ENCOSHAREDAPI bool compress(const std::vector<JointTransform> &poses, uint jointCount, f32 sampleRate, f32 rotationTolerance = 0.001f, f32 translationTolerance = 0.0005f, f32 scaleTolerance = 0.0005f);
+
+		// Writes getJointCount() transforms, time is wrapped into the clip when looping and clamped otherwise
+		ENCOSHAREDAPI void sample(f32 time, bool loop, JointTransform *pose) const;
+
+		inline f32 getDuration() const { return m_duration; }
+		inline uint getJointCount() const { return (uint)m_tracks.size(); }
+		inline uint getFrameCount() const { return m_frameCount; }
+
+		ENCOSHAREDAPI uint getKeyCount() const;
+		ENCOSHAREDAPI size_t getByteSize() const;
+
+	private:
+		// Three u16 per key, frames holds the source frame of every key
+		struct Channel {
+			std::vector<u16> frames;
+			std::vector<u16> values;
+			glm::vec3 minimum;
+			glm::vec3 extent;
+		};
+
+		struct Track {
+			Channel rotation;
+			Channel translation;
+			Channel scale;
+		};
+
+		static void compressRotations(const std::vector<glm::quat> &rotations, f32 tolerance, Channel &channel);
+		static void compressVectors(const std::vector<glm::vec3> &vectors, f32 tolerance, Channel &channel);
+		static uint findKey(const Channel &channel, f32 frame, f32 &weight);
+
+		std::vector<Track> m_tracks;
+		uint m_frameCount;
+		f32 m_sampleRate;
+		f32 m_duration;
+	};
+}
+
+#endif
\ No newline at end of file
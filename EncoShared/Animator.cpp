@@ -0,0 +1,52 @@
+#include "stdafx.h"
+#include "Animator.h"
+
+#include "Simd.h"
+
+namespace enco {
+	ENCOSHAREDAPI void Animator::update(std::vector<AnimationInstance> &instances, f32 deltaTime, JobSystem &jobSystem) {
+		jobSystem.parallelFor((uint)instances.size(), 16, [&instances, deltaTime](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				update(instances[i], deltaTime);
+			}
+		});
+	}
+
+	ENCOSHAREDAPI void Animator::update(AnimationInstance &instance, f32 deltaTime) {
+		if (!instance.skeleton) {
+			return;
+		}
+
+		uint jointCount = instance.skeleton->getJointCount();
+		instance.time += deltaTime * instance.speed;
+		if (instance.pose.size() != jointCount) {
+			instance.pose = instance.skeleton->getBindPose();
+		}
+
+		if (instance.tree) {
+			if (instance.parameters.size() < instance.tree->getParameterCount()) {
+				instance.parameters = instance.tree->getDefaultParameters();
+			}
+			instance.tree->evaluate(instance.time, instance.parameters.empty() ? nullptr : &instance.parameters[0], jointCount, jointCount ? &instance.pose[0] : nullptr, instance.scratch);
+		}
+
+		computePalette(instance);
+	}
+
+	ENCOSHAREDAPI void Animator::computePalette(AnimationInstance &instance) {
+		const Skeleton &skeleton = *instance.skeleton;
+		uint jointCount = skeleton.getJointCount();
+		instance.model.resize(jointCount);
+		instance.palette.resize(jointCount);
+
+		glm::mat4 local;
+		for (uint i = 0; i < jointCount; ++i) {
+			instance.pose[i].toMatrix(&local[0][0]);
+
+			int parent = skeleton.getParent(i);
+			const glm::mat4 &parentMatrix = parent == Skeleton::noParent ? instance.transform : instance.model[parent];
+			simdMultiplyMatrix(&parentMatrix[0][0], &local[0][0], &instance.model[i][0][0]);
+			simdMultiplyMatrix(&instance.model[i][0][0], &skeleton.getInverseBindMatrix(i)[0][0], &instance.palette[i][0][0]);
+		}
+	}
+}
\ No newline at end of file
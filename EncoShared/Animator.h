@@ -0,0 +1,45 @@
+#ifndef __ENCOSHARED_ANIMATOR_H__
+#define __ENCOSHARED_ANIMATOR_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "BlendTree.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+namespace enco {
+	struct AnimationInstance {
+		const Skeleton *skeleton;
+		const BlendTree *tree;
+		// One value per tree parameter, filled with the defaults of the tree when empty
+		std::vector<f32> parameters;
+		f32 time;
+		f32 speed;
+		glm::mat4 transform;
+
+		// Written by Animator::update. The palette maps bind pose vertices straight to world space,
+		// it already contains transform.
+		std::vector<JointTransform> pose;
+		std::vector<glm::mat4> palette;
+
+		BlendScratch scratch;
+		std::vector<glm::mat4> model;
+
+		inline AnimationInstance() : skeleton(nullptr), tree(nullptr), time(0.0f), speed(1.0f), transform(1.0f) {  }
+	};
+
+	// Advances, evaluates and builds the skinning palettes of many characters, one job per batch of instances
+	class Animator {
+	public:
+		ENCOSHAREDAPI static void update(std::vector<AnimationInstance> &instances, f32 deltaTime, JobSystem &jobSystem);
+
+		ENCOSHAREDAPI static void update(AnimationInstance &instance, f32 deltaTime);
+
+		// Model space matrices in parent order, then palette = model * inverse bind, both with SIMD products
+		ENCOSHAREDAPI static void computePalette(AnimationInstance &instance);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "MeshData.h"
+#include "Terrain.h"
+#include "WorldPartition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+
+namespace enco {
+	ENCOSHAREDAPI bool TextAsset::import(const std::string &path) {
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		std::stringstream stream;
+		stream << file.rdbuf();
+		m_text = stream.str();
+		return true;
+	}
+
+	ENCOSHAREDAPI AssetManager::AssetManager(const std::string &rootDirectory) : m_rootDirectory(rootDirectory), m_settle(false), m_hasCompleted(false), m_importSequence(0), m_running(true) {
+		std::replace(m_rootDirectory.begin(), m_rootDirectory.end(), '\\', '/');
+		while (m_rootDirectory.size() > 1 && m_rootDirectory.back() == '/') {
+			m_rootDirectory.pop_back();
+		}
+
+		registerType<TextAsset>(".glsl");
+		registerType<TextAsset>(".vert");
+		registerType<TextAsset>(".frag");
+		registerType<TextAsset>(".geom");
+		registerType<MeshAsset>(".emesh");
+		registerType<TerrainTileAsset>(".etile");
+		registerType<CellAsset>(".ecell");
+
+		m_importThread = std::thread(&AssetManager::runImports, this);
+	}
+
+	ENCOSHAREDAPI AssetManager::~AssetManager() {
+		disableHotReload();
+
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_running = false;
+		}
+		m_queueCondition.notify_all();
+		m_importThread.join();
+	}
+
+	ENCOSHAREDAPI void AssetManager::registerFactory(const std::string &extension, Factory factory) {
+		std::string key = extension;
+		std::transform(key.begin(), key.end(), key.begin(), ::tolower);
+		m_factories[key] = factory;
+	}
+
+	ENCOSHAREDAPI void AssetManager::addDependency(const std::string &dependent, const std::string &dependency) {
+		std::lock_guard<std::mutex> lock(m_slotMutex);
+		m_dependents[normalize(dependency)].insert(normalize(dependent));
+	}
+
+	ENCOSHAREDAPI void AssetManager::addReloadListener(ReloadListener listener) {
+		m_listeners.push_back(listener);
+	}
+
+	ENCOSHAREDAPI bool AssetManager::enableHotReload() {
+		return m_watcher.start(m_rootDirectory, [this](const std::string &path) {
+			std::string key = normalize(path);
+
+			std::unique_lock<std::mutex> lock(m_slotMutex);
+			bool known = m_slots.find(key) != m_slots.end();
+			lock.unlock();
+
+			if (known) {
+				enqueue(key, true);
+			}
+		});
+	}
+
+	ENCOSHAREDAPI void AssetManager::disableHotReload() {
+		m_watcher.stop();
+	}
+
+	ENCOSHAREDAPI void AssetManager::reload(const std::string &path) {
+		enqueue(normalize(path), true);
+	}
+
+	ENCOSHAREDAPI void AssetManager::unload(const std::string &path) {
+		std::lock_guard<std::mutex> lock(m_slotMutex);
+		m_slots.erase(normalize(path));
+	}
+
+	ENCOSHAREDAPI void AssetManager::commit() {
+		if (!m_hasCompleted.load(std::memory_order_acquire)) {
+			return;
+		}
+
+		std::vector<CompletedImport> completed;
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			completed.swap(m_completed);
+			m_hasCompleted = false;
+		}
+
+		for (size_t i = 0; i < completed.size(); ++i) {
+			CompletedImport &import = completed[i];
+			// A synchronous load read the file after this import started, so it has the same asset or a newer one
+			if (import.sequence < import.slot->importSequence) {
+				continue;
+			}
+			if (!import.asset) {
+				import.slot->failed = !import.slot->asset;
+				continue;
+			}
+			import.asset->finalize();
+			import.slot->failed = false;
+			import.slot->asset = import.asset;
+			import.slot->importSequence = import.sequence;
+			++import.slot->version;
+
+			for (size_t j = 0; j < m_listeners.size(); ++j) {
+				m_listeners[j](import.slot->path, import.slot->version);
+			}
+
+			// Only reloads invalidate dependents, the first load of an asset has nothing depending on it yet. Every
+			// asset is reloaded once per pass, so dependency cycles end.
+			if (import.slot->version > 1) {
+				std::vector<std::string> invalidated;
+				ReloadPass pass = import.pass ? import.pass : std::make_shared<std::set<std::string>>();
+				pass->insert(import.slot->path);
+				{
+					std::lock_guard<std::mutex> lock(m_slotMutex);
+					std::map<std::string, std::set<std::string>>::const_iterator it = m_dependents.find(import.slot->path);
+					if (it != m_dependents.end()) {
+						for (std::set<std::string>::const_iterator dependent = it->second.begin(); dependent != it->second.end(); ++dependent) {
+							if (pass->insert(*dependent).second) {
+								invalidated.push_back(*dependent);
+							}
+						}
+					}
+				}
+				for (size_t j = 0; j < invalidated.size(); ++j) {
+					enqueue(invalidated[j], true, pass);
+				}
+			}
+		}
+	}
+
+	std::shared_ptr<AssetSlot> AssetManager::loadSlot(const std::string &path, bool async) {
+		std::string key = normalize(path);
+
+		std::shared_ptr<AssetSlot> slot;
+		bool created = false;
+		{
+			std::lock_guard<std::mutex> lock(m_slotMutex);
+			std::shared_ptr<AssetSlot> &existing = m_slots[key];
+			if (!existing) {
+				existing = std::make_shared<AssetSlot>(key);
+				created = true;
+			}
+			slot = existing;
+		}
+
+		if (async) {
+			// Failed assets are tried again, the file may exist by now
+			if (created || slot->failed) {
+				enqueue(key, false);
+			}
+			return slot;
+		}
+		if (slot->asset) {
+			return slot;
+		}
+
+		// The asset is still queued by an earlier loadAsync() or failed before, a synchronous load imports it right away.
+		// An import the import thread already started is swapped in by commit() as a reload.
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			for (std::deque<QueuedImport>::iterator queued = m_queue.begin(); queued != m_queue.end(); ++queued) {
+				if (queued->path == key) {
+					m_queue.erase(queued);
+					break;
+				}
+			}
+		}
+
+		u64 sequence = ++m_importSequence;
+		std::shared_ptr<IAsset> asset = createAsset(key);
+		if (asset) {
+			asset->finalize();
+			slot->asset = asset;
+			slot->failed = false;
+			slot->importSequence = sequence;
+			++slot->version;
+		}
+		else {
+			slot->failed = true;
+		}
+		return slot;
+	}
+
+	std::shared_ptr<IAsset> AssetManager::createAsset(const std::string &path) {
+		size_t dot = path.find_last_of('.');
+		if (dot == std::string::npos) {
+			return nullptr;
+		}
+
+		std::string extension = path.substr(dot);
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		std::map<std::string, Factory>::const_iterator factory = m_factories.find(extension);
+		if (factory == m_factories.end()) {
+#ifdef _DEBUG
+			printf("AssetManager: No factory for %s\n", path.c_str());
+#endif
+			return nullptr;
+		}
+
+		std::shared_ptr<IAsset> asset = factory->second();
+		if (!asset->import(m_rootDirectory + "/" + path)) {
+#ifdef _DEBUG
+			printf("AssetManager: Failed to import %s\n", path.c_str());
+#endif
+			return nullptr;
+		}
+		return asset;
+	}
+
+	std::string AssetManager::normalize(const std::string &path) const {
+		std::string result = path;
+		std::replace(result.begin(), result.end(), '\\', '/');
+
+		if (result.compare(0, m_rootDirectory.size(), m_rootDirectory) == 0 && result.size() > m_rootDirectory.size() && result[m_rootDirectory.size()] == '/') {
+			result.erase(0, m_rootDirectory.size() + 1);
+		}
+		while (result.compare(0, 2, "./") == 0) {
+			result.erase(0, 2);
+		}
+		return result;
+	}
+
+	void AssetManager::enqueue(const std::string &path, bool settle, ReloadPass pass) {
+		{
+			std::lock_guard<std::mutex> lock(m_queueMutex);
+			m_settle = m_settle || settle;
+			for (std::deque<QueuedImport>::const_iterator queued = m_queue.begin(); queued != m_queue.end(); ++queued) {
+				if (queued->path == path) {
+					return;
+				}
+			}
+			QueuedImport import = { path, pass };
+			m_queue.push_back(import);
+		}
+		m_queueCondition.notify_one();
+	}
+
+	void AssetManager::runImports() {
+		std::unique_lock<std::mutex> lock(m_queueMutex);
+		for (;;) {
+			m_queueCondition.wait(lock, [this]() { return !m_running || !m_queue.empty(); });
+			if (!m_running) {
+				return;
+			}
+
+			// Editors usually write a file in several steps, wait until the burst settles. Only for changed files,
+			// assets that are streamed in every frame would never settle.
+			while (m_settle && m_queueCondition.wait_for(lock, std::chrono::milliseconds(50)) != std::cv_status::timeout && m_running) {
+			}
+			m_settle = false;
+
+			std::deque<QueuedImport> queue;
+			queue.swap(m_queue);
+			lock.unlock();
+
+			std::vector<CompletedImport> completed;
+			for (size_t i = 0; i < queue.size(); ++i) {
+				std::shared_ptr<AssetSlot> slot;
+				{
+					std::lock_guard<std::mutex> slotLock(m_slotMutex);
+					std::map<std::string, std::shared_ptr<AssetSlot>>::const_iterator it = m_slots.find(queue[i].path);
+					if (it != m_slots.end()) {
+						slot = it->second;
+					}
+				}
+
+				if (slot) {
+					// Failed imports are passed on as well so commit() can flag the slot
+					u64 sequence = ++m_importSequence;
+					CompletedImport import = { slot, createAsset(queue[i].path), sequence, queue[i].pass };
+					completed.push_back(import);
+				}
+			}
+
+			lock.lock();
+			if (!completed.empty()) {
+				m_completed.insert(m_completed.end(), completed.begin(), completed.end());
+				m_hasCompleted.store(true, std::memory_order_release);
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifndef __ENCOSHARED_ASSETMANAGER_H__
+#define __ENCOSHARED_ASSETMANAGER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "FileWatcher.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace enco {
+	class IAsset {
+	public:
+		IAsset() {  }
+		virtual ~IAsset() {  }
+
+		// Runs on the import thread. Parse the file into CPU memory only.
+		virtual bool import(const std::string &path) = 0;
+
+		// Runs on the main thread at the frame boundary right before the asset becomes visible.
+		// GPU resources are created here.
+		virtual void finalize() {  }
+	};
+
+	class TextAsset : public IAsset {
+	public:
+		ENCOSHAREDAPI virtual bool import(const std::string &path);
+
+		inline const std::string &getText() const { return m_text; }
+
+	private:
+		std::string m_text;
+	};
+
+	struct AssetSlot {
+		std::string path;
+		std::shared_ptr<IAsset> asset;
+		u32 version;
+		// The first import failed, e.g. because the file does not exist
+		bool failed;
+		// Imports are numbered when they start reading the file, the ones that started before asset did are stale
+		u64 importSequence;
+
+		inline AssetSlot(const std::string &path) : path(path), version(0), failed(false), importSequence(0) {  }
+	};
+
+	template<typename T>
+	class Asset {
+	public:
+		inline Asset() {  }
+		inline Asset(std::shared_ptr<AssetSlot> slot) : m_slot(slot) {  }
+
+		inline T *get() const { return m_slot ? static_cast<T *>(m_slot->asset.get()) : nullptr; }
+		inline T *operator->() const { return get(); }
+
+		inline bool isReady() const { return m_slot && m_slot->asset; }
+		inline bool isFailed() const { return m_slot && m_slot->failed; }
+		inline u32 getVersion() const { return m_slot ? m_slot->version : 0; }
+		inline std::string getPath() const { return m_slot ? m_slot->path : std::string(); }
+		// Equal for every handle of the same asset
+		inline const AssetSlot *getSlot() const { return m_slot.get(); }
+
+	private:
+		std::shared_ptr<AssetSlot> m_slot;
+	};
+
+	// Loads assets by extension and re-imports them in the background when their files change.
+	// Re-imported assets are swapped in all at once by commit(), which EncoContext calls once per frame.
+	class AssetManager {
+	public:
+		typedef std::function<std::shared_ptr<IAsset>()> Factory;
+		typedef std::function<void(const std::string &path, u32 version)> ReloadListener;
+
+		ENCOSHAREDAPI AssetManager(const std::string &rootDirectory = ".");
+		ENCOSHAREDAPI ~AssetManager();
+
+		ENCOSHAREDAPI void registerFactory(const std::string &extension, Factory factory);
+
+		template<typename T>
+		inline void registerType(const std::string &extension) { registerFactory(extension, []() { return std::shared_ptr<IAsset>(new T()); }); }
+
+		template<typename T>
+		inline Asset<T> load(const std::string &path) { return Asset<T>(loadSlot(path, false)); }
+
+		// The returned handle stays empty until the import finished and the next commit() ran.
+		template<typename T>
+		inline Asset<T> loadAsync(const std::string &path) { return Asset<T>(loadSlot(path, true)); }
+
+		// When dependency is reloaded, dependent is re-imported as well.
+		ENCOSHAREDAPI void addDependency(const std::string &dependent, const std::string &dependency);
+
+		ENCOSHAREDAPI void addReloadListener(ReloadListener listener);
+
+		ENCOSHAREDAPI bool enableHotReload();
+		ENCOSHAREDAPI void disableHotReload();
+		inline bool isHotReloadEnabled() const { return m_watcher.isRunning(); }
+
+		ENCOSHAREDAPI void reload(const std::string &path);
+		// Forgets the asset so its memory is freed once the last handle to it is gone, the next load imports it again
+		ENCOSHAREDAPI void unload(const std::string &path);
+
+		// Swaps in everything the import thread finished. Call at a frame boundary.
+		ENCOSHAREDAPI void commit();
+
+		inline std::string getRootDirectory() const { return m_rootDirectory; }
+
+	private:
+		// Paths reloaded because an asset they depend on changed, shared by every reload that one change caused
+		typedef std::shared_ptr<std::set<std::string>> ReloadPass;
+
+		struct QueuedImport {
+			std::string path;
+			ReloadPass pass;
+		};
+
+		struct CompletedImport {
+			std::shared_ptr<AssetSlot> slot;
+			std::shared_ptr<IAsset> asset;
+			u64 sequence;
+			ReloadPass pass;
+		};
+
+		std::shared_ptr<AssetSlot> loadSlot(const std::string &path, bool async);
+		std::shared_ptr<IAsset> createAsset(const std::string &path);
+		std::string normalize(const std::string &path) const;
+		// Changed files are imported once writes to them settled, loads right away
+		void enqueue(const std::string &path, bool settle, ReloadPass pass = nullptr);
+		void runImports();
+
+		std::string m_rootDirectory;
+		std::map<std::string, Factory> m_factories;
+
+		std::mutex m_slotMutex;
+		std::map<std::string, std::shared_ptr<AssetSlot>> m_slots;
+		std::map<std::string, std::set<std::string>> m_dependents;
+		std::vector<ReloadListener> m_listeners;
+
+		std::mutex m_queueMutex;
+		std::condition_variable m_queueCondition;
+		std::deque<QueuedImport> m_queue;
+		std::vector<CompletedImport> m_completed;
+		bool m_settle;
+		std::atomic<bool> m_hasCompleted;
+		std::atomic<u64> m_importSequence;
+		std::atomic<bool> m_running;
+		std::thread m_importThread;
+
+		FileWatcher m_watcher;
+	};
+}
+
+#endif
\ No newline at end of file
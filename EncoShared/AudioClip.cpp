@@ -0,0 +1,129 @@
+#include "stdafx.h"
+#include "AudioClip.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace enco {
+	namespace {
+		const uint decodeChunkFrames = 4096;
+	}
+
+	ENCOSHAREDAPI AudioClip::AudioClip() : m_channelCount(0), m_sampleRate(0) {
+	}
+
+	ENCOSHAREDAPI bool AudioClip::load(IAudioDecoder &decoder) {
+		m_channelCount = decoder.getChannelCount();
+		m_sampleRate = decoder.getSampleRate();
+		m_samples.clear();
+		if (m_channelCount == 0) {
+#ifdef _DEBUG
+			printf("Audio Error: Decoder has no channels\n");
+#endif
+			return false;
+		}
+		if (decoder.getFrameCount() > 0) {
+			m_samples.reserve((size_t)decoder.getFrameCount() * m_channelCount);
+		}
+
+		std::vector<f32> chunk(decodeChunkFrames * m_channelCount);
+		for (;;) {
+			uint count = decoder.decode(&chunk[0], decodeChunkFrames);
+			m_samples.insert(m_samples.end(), chunk.begin(), chunk.begin() + count * m_channelCount);
+			if (count < decodeChunkFrames) {
+				break;
+			}
+		}
+		return !m_samples.empty();
+	}
+
+	ENCOSHAREDAPI bool AudioClip::load(const std::string &path) {
+		WavDecoder decoder;
+		return decoder.open(path) && load(decoder);
+	}
+
+	ENCOSHAREDAPI bool AudioClipAsset::import(const std::string &path) {
+		return m_clip.load(path);
+	}
+
+	ENCOSHAREDAPI AudioStream::AudioStream(std::unique_ptr<IAudioDecoder> decoder, bool loop) : m_decoder(std::move(decoder)), m_loop(loop), m_written(0), m_read(0), m_ended(false), m_refilling(false), m_underruns(0) {
+		if (m_decoder && m_decoder->getChannelCount() == 0) {
+			m_decoder.reset();
+		}
+		m_channelCount = m_decoder ? m_decoder->getChannelCount() : 1;
+		m_sampleRate = m_decoder ? m_decoder->getSampleRate() : 0;
+		m_ring.resize(ringFrames * m_channelCount);
+		m_decodeBuffer.resize(ringFrames / 2 * m_channelCount);
+		if (!m_decoder) {
+			m_ended = true;
+		}
+	}
+
+	ENCOSHAREDAPI AudioStream::~AudioStream() {
+	}
+
+	ENCOSHAREDAPI void AudioStream::refill() {
+		while (!m_ended.load(std::memory_order_relaxed)) {
+			u64 written = m_written.load(std::memory_order_relaxed);
+			uint space = ringFrames - (uint)(written - m_read.load(std::memory_order_acquire));
+			if (space == 0) {
+				break;
+			}
+
+			uint wanted = std::min(space, ringFrames / 2);
+			uint count = m_decoder->decode(&m_decodeBuffer[0], wanted);
+			while (count < wanted && m_loop && m_decoder->rewind()) {
+				uint more = m_decoder->decode(&m_decodeBuffer[count * m_channelCount], wanted - count);
+				if (more == 0) {
+					break;
+				}
+				count += more;
+			}
+
+			for (uint i = 0; i < count;) {
+				uint index = (uint)((written + i) % ringFrames);
+				uint run = std::min(count - i, ringFrames - index);
+				std::copy(m_decodeBuffer.begin() + i * m_channelCount, m_decodeBuffer.begin() + (i + run) * m_channelCount, m_ring.begin() + index * m_channelCount);
+				i += run;
+			}
+			m_written.store(written + count, std::memory_order_release);
+
+			if (count < wanted) {
+				m_ended.store(true, std::memory_order_release);
+			}
+		}
+		m_refilling.store(false, std::memory_order_release);
+	}
+
+	ENCOSHAREDAPI bool AudioStream::needsRefill() const {
+		if (m_ended.load(std::memory_order_acquire)) {
+			return false;
+		}
+		u64 buffered = m_written.load(std::memory_order_acquire) - m_read.load(std::memory_order_acquire);
+		return buffered < ringFrames / 2;
+	}
+
+	ENCOSHAREDAPI uint AudioStream::peek(f32 *frames, uint frameCount) const {
+		u64 read = m_read.load(std::memory_order_relaxed);
+		uint available = (uint)(m_written.load(std::memory_order_acquire) - read);
+		uint count = std::min(frameCount, available);
+
+		for (uint i = 0; i < count;) {
+			uint index = (uint)((read + i) % ringFrames);
+			uint run = std::min(count - i, ringFrames - index);
+			memcpy(frames + i * m_channelCount, &m_ring[index * m_channelCount], run * m_channelCount * sizeof(f32));
+			i += run;
+		}
+		return count;
+	}
+
+	ENCOSHAREDAPI void AudioStream::consume(uint frameCount) {
+		u64 read = m_read.load(std::memory_order_relaxed);
+		u64 written = m_written.load(std::memory_order_acquire);
+		m_read.store(std::min(read + frameCount, written), std::memory_order_release);
+	}
+
+	ENCOSHAREDAPI bool AudioStream::isFinished() const {
+		return m_ended.load(std::memory_order_acquire) && m_read.load(std::memory_order_acquire) == m_written.load(std::memory_order_acquire);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef __ENCOSHARED_AUDIOCLIP_H__
+#define __ENCOSHARED_AUDIOCLIP_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "AudioDecoder.h"
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// A short sound decoded completely into memory
+	class AudioClip {
+	public:
+		ENCOSHAREDAPI AudioClip();
+
+		ENCOSHAREDAPI bool load(IAudioDecoder &decoder);
+		// Any file WavDecoder reads
+		ENCOSHAREDAPI bool load(const std::string &path);
+
+		inline uint getChannelCount() const { return m_channelCount; }
+		inline uint getSampleRate() const { return m_sampleRate; }
+		inline u64 getFrameCount() const { return m_channelCount ? m_samples.size() / m_channelCount : 0; }
+		// Interleaved
+		inline const f32 *getSamples() const { return m_samples.empty() ? nullptr : &m_samples[0]; }
+
+	private:
+		uint m_channelCount;
+		uint m_sampleRate;
+		TaggedVector<f32, audioMemory> m_samples;
+	};
+
+	class AudioClipAsset : public IAsset {
+	public:
+		ENCOSHAREDAPI virtual bool import(const std::string &path);
+
+		inline const AudioClip &getClip() const { return m_clip; }
+
+	private:
+		AudioClip m_clip;
+	};
+
+	// A long sound decoded piece by piece into a ring buffer. refill() runs on a job while the audio thread
+	// reads the ring, one producer and one consumer that never wait for each other.
+	class AudioStream {
+	public:
+		// About a third of a second at 48 kHz
+		static const uint ringFrames = 16384;
+
+		ENCOSHAREDAPI AudioStream(std::unique_ptr<IAudioDecoder> decoder, bool loop = false);
+		ENCOSHAREDAPI ~AudioStream();
+
+		inline uint getChannelCount() const { return m_channelCount; }
+		inline uint getSampleRate() const { return m_sampleRate; }
+
+		// Producer: decodes until the ring is full or the source ended
+		ENCOSHAREDAPI void refill();
+		// True when the ring is less than half full and there is more to decode
+		ENCOSHAREDAPI bool needsRefill() const;
+		// Guards against queueing a second refill while one is running, true if the caller won
+		inline bool beginRefill() { return !m_refilling.exchange(true, std::memory_order_acquire); }
+
+		// Consumer: copies up to frameCount frames without consuming them, returns how many there were
+		ENCOSHAREDAPI uint peek(f32 *frames, uint frameCount) const;
+		ENCOSHAREDAPI void consume(uint frameCount);
+		// The source ended, everything it produced is in the ring
+		inline bool isEnded() const { return m_ended.load(std::memory_order_acquire); }
+		// The source ended and everything decoded was consumed
+		ENCOSHAREDAPI bool isFinished() const;
+
+		inline u64 getUnderrunCount() const { return m_underruns.load(std::memory_order_relaxed); }
+		inline void addUnderrun() { m_underruns.fetch_add(1, std::memory_order_relaxed); }
+
+	private:
+		AudioStream(const AudioStream &) = delete;
+		AudioStream &operator=(const AudioStream &) = delete;
+
+		std::unique_ptr<IAudioDecoder> m_decoder;
+		bool m_loop;
+		uint m_channelCount;
+		uint m_sampleRate;
+
+		TaggedVector<f32, audioMemory> m_ring;
+		TaggedVector<f32, audioMemory> m_decodeBuffer;
+		// Frames written and read since the start, the ring index is the count modulo ringFrames
+		std::atomic<u64> m_written;
+		std::atomic<u64> m_read;
+		std::atomic<bool> m_ended;
+		std::atomic<bool> m_refilling;
+		std::atomic<u64> m_underruns;
+	};
+}
+
+#endif
\ No newline at end of file
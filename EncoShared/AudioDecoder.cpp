@@ -0,0 +1,267 @@
+#include "stdafx.h"
+#include "AudioDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace enco {
+	static const int s_adpcmSteps[89] = {
+		7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+		107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+		876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+		5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+		27086, 29794, 32767
+	};
+
+	static const int s_adpcmIndexChanges[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+	namespace {
+		const u16 pcmFormat = 1;
+		const u16 adpcmFormat = 0x11;
+		const u16 floatFormat = 3;
+		const u16 extensibleFormat = 0xFFFE;
+
+		// PCM and float files are read in pieces of at most this many frames
+		const uint maxReadFrames = 4096;
+
+		inline u16 readU16(const u8 *p) {
+			return (u16)(p[0] | (p[1] << 8));
+		}
+
+		inline u32 readU32(const u8 *p) {
+			return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+		}
+
+		inline i16 decodeNibble(uint nibble, int &predictor, int &index) {
+			int step = s_adpcmSteps[index];
+			int delta = step >> 3;
+			if (nibble & 1) {
+				delta += step >> 2;
+			}
+			if (nibble & 2) {
+				delta += step >> 1;
+			}
+			if (nibble & 4) {
+				delta += step;
+			}
+			predictor += (nibble & 8) ? -delta : delta;
+			predictor = glm::clamp(predictor, -32768, 32767);
+			index = glm::clamp(index + s_adpcmIndexChanges[nibble], 0, 88);
+			return (i16)predictor;
+		}
+	}
+
+	ENCOSHAREDAPI WavDecoder::WavDecoder() : m_encoding(pcmEncoding), m_channelCount(0), m_sampleRate(0), m_bitsPerSample(0), m_blockAlign(0), m_framesPerBlock(0), m_frameCount(0), m_framesLeft(0), m_dataOffset(0), m_blockFrames(0), m_blockPosition(0) {
+	}
+
+	ENCOSHAREDAPI WavDecoder::~WavDecoder() {
+	}
+
+	ENCOSHAREDAPI bool WavDecoder::open(const std::string &path) {
+		m_file.close();
+		m_file.clear();
+
+		// Nothing of a previously opened file may leak into this one, a PCM file has no frames per block
+		m_encoding = pcmEncoding;
+		m_channelCount = m_sampleRate = m_bitsPerSample = m_blockAlign = m_framesPerBlock = 0;
+		m_frameCount = m_framesLeft = 0;
+		m_dataOffset = 0;
+		m_raw.clear();
+		m_block.clear();
+		m_blockFrames = m_blockPosition = 0;
+
+		m_file.open(path.c_str(), std::ios::in | std::ios::binary);
+		if (!m_file) {
+			return false;
+		}
+
+		u8 riff[12];
+		if (!m_file.read((char *)riff, sizeof(riff)) || memcmp(riff, "RIFF", 4) != 0 || memcmp(riff + 8, "WAVE", 4) != 0) {
+#ifdef _DEBUG
+			printf("Audio Error: %s is not a WAVE file\n", path.c_str());
+#endif
+			return false;
+		}
+
+		u16 format = 0;
+		u32 dataSize = 0;
+		u32 factFrames = 0;
+		bool hasFormat = false, hasData = false;
+		while (!hasData) {
+			u8 chunk[8];
+			if (!m_file.read((char *)chunk, sizeof(chunk))) {
+				break;
+			}
+			u32 size = readU32(chunk + 4);
+			std::streamoff next = (std::streamoff)m_file.tellg() + size + (size & 1);
+
+			if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+				std::vector<u8> fmt(size);
+				if (!m_file.read((char *)&fmt[0], size)) {
+					break;
+				}
+				format = readU16(&fmt[0]);
+				m_channelCount = readU16(&fmt[2]);
+				if (m_channelCount == 0) {
+					break;
+				}
+				m_sampleRate = readU32(&fmt[4]);
+				m_blockAlign = readU16(&fmt[12]);
+				m_bitsPerSample = readU16(&fmt[14]);
+				if (format == extensibleFormat && size >= 26) {
+					format = readU16(&fmt[24]);
+				}
+				if (format == adpcmFormat && size >= 22) {
+					m_framesPerBlock = readU16(&fmt[18]);
+				}
+				hasFormat = true;
+			}
+			else if (memcmp(chunk, "fact", 4) == 0 && size >= 4) {
+				u8 fact[4];
+				m_file.read((char *)fact, sizeof(fact));
+				factFrames = readU32(fact);
+			}
+			else if (memcmp(chunk, "data", 4) == 0) {
+				dataSize = size;
+				m_dataOffset = m_file.tellg();
+				hasData = true;
+				break;
+			}
+			m_file.seekg(next);
+		}
+
+		bool supported = hasFormat && hasData && m_channelCount >= 1 && m_channelCount <= 2 && m_sampleRate > 0 && m_blockAlign > 0;
+		if (supported && format == pcmFormat && (m_bitsPerSample == 8 || m_bitsPerSample == 16 || m_bitsPerSample == 24)) {
+			m_encoding = pcmEncoding;
+			m_frameCount = dataSize / m_blockAlign;
+		}
+		else if (supported && format == floatFormat && m_bitsPerSample == 32) {
+			m_encoding = floatEncoding;
+			m_frameCount = dataSize / m_blockAlign;
+		}
+		else if (supported && format == adpcmFormat && m_bitsPerSample == 4 && m_blockAlign > 4 * m_channelCount) {
+			m_encoding = adpcmEncoding;
+			uint expected = (m_blockAlign - 4 * m_channelCount) * 2 / m_channelCount + 1;
+			if (m_framesPerBlock == 0 || m_framesPerBlock > expected) {
+				m_framesPerBlock = expected;
+			}
+			u64 blocks = (dataSize + m_blockAlign - 1) / m_blockAlign;
+			m_frameCount = factFrames ? factFrames : blocks * m_framesPerBlock;
+			m_block.resize(m_framesPerBlock * m_channelCount);
+		}
+		else {
+#ifdef _DEBUG
+			printf("Audio Error: %s uses an unsupported encoding (format %u, %u bits, %u channels)\n", path.c_str(), format, m_bitsPerSample, m_channelCount);
+#endif
+			return false;
+		}
+
+		return rewind();
+	}
+
+	ENCOSHAREDAPI uint WavDecoder::decode(f32 *frames, uint frameCount) {
+		uint written = 0;
+		while (written < frameCount && m_framesLeft > 0) {
+			if (m_encoding == adpcmEncoding) {
+				if (m_blockPosition == m_blockFrames && !decodeBlock()) {
+					m_framesLeft = 0;
+					break;
+				}
+
+				uint count = (uint)std::min<u64>(std::min(frameCount - written, m_blockFrames - m_blockPosition), m_framesLeft);
+				memcpy(frames + written * m_channelCount, &m_block[m_blockPosition * m_channelCount], count * m_channelCount * sizeof(f32));
+				m_blockPosition += count;
+				m_framesLeft -= count;
+				written += count;
+				continue;
+			}
+
+			uint count = (uint)std::min<u64>(std::min(frameCount - written, maxReadFrames), m_framesLeft);
+			m_raw.resize(count * m_blockAlign);
+			if (!m_file.read((char *)&m_raw[0], m_raw.size())) {
+				m_framesLeft = 0;
+				break;
+			}
+
+			f32 *target = frames + written * m_channelCount;
+			uint samples = count * m_channelCount;
+			const u8 *source = &m_raw[0];
+			if (m_encoding == floatEncoding) {
+				for (uint i = 0; i < samples; ++i) {
+					u32 bits = readU32(source + i * 4);
+					memcpy(&target[i], &bits, sizeof(f32));
+				}
+			}
+			else if (m_bitsPerSample == 8) {
+				for (uint i = 0; i < samples; ++i) {
+					target[i] = (source[i] - 128) / 128.0f;
+				}
+			}
+			else if (m_bitsPerSample == 16) {
+				for (uint i = 0; i < samples; ++i) {
+					target[i] = (i16)readU16(source + i * 2) / 32768.0f;
+				}
+			}
+			else {
+				for (uint i = 0; i < samples; ++i) {
+					const u8 *p = source + i * 3;
+					i32 value = (i32)(((u32)p[0] << 8) | ((u32)p[1] << 16) | ((u32)p[2] << 24)) >> 8;
+					target[i] = value / 8388608.0f;
+				}
+			}
+
+			m_framesLeft -= count;
+			written += count;
+		}
+		return written;
+	}
+
+	ENCOSHAREDAPI bool WavDecoder::rewind() {
+		m_file.clear();
+		m_file.seekg(m_dataOffset);
+		m_framesLeft = m_frameCount;
+		m_blockFrames = m_blockPosition = 0;
+		return m_file.good();
+	}
+
+	bool WavDecoder::decodeBlock() {
+		// The last block of a file may be short
+		m_raw.resize(m_blockAlign);
+		m_file.read((char *)&m_raw[0], m_blockAlign);
+		uint size = (uint)m_file.gcount();
+		if (size <= 4 * m_channelCount) {
+			return false;
+		}
+
+		// Every channel starts with its first sample and step index, then groups of 4 bytes (8 samples)
+		// alternate between the channels
+		int predictors[2], indices[2];
+		for (uint channel = 0; channel < m_channelCount; ++channel) {
+			const u8 *header = &m_raw[channel * 4];
+			predictors[channel] = (i16)readU16(header);
+			indices[channel] = glm::clamp((int)header[2], 0, 88);
+			m_block[channel] = predictors[channel] / 32768.0f;
+		}
+
+		uint frames = std::min((size - 4 * m_channelCount) * 2 / m_channelCount + 1, m_framesPerBlock);
+		const u8 *data = &m_raw[4 * m_channelCount];
+		uint groups = (frames - 1 + 7) / 8;
+		for (uint group = 0; group < groups; ++group) {
+			for (uint channel = 0; channel < m_channelCount; ++channel) {
+				const u8 *bytes = data + (group * m_channelCount + channel) * 4;
+				for (uint i = 0; i < 8; ++i) {
+					uint frame = 1 + group * 8 + i;
+					if (frame >= frames) {
+						break;
+					}
+					uint nibble = (i & 1) ? bytes[i >> 1] >> 4 : bytes[i >> 1] & 0xF;
+					m_block[frame * m_channelCount + channel] = decodeNibble(nibble, predictors[channel], indices[channel]) / 32768.0f;
+				}
+			}
+		}
+
+		m_blockFrames = frames;
+		m_blockPosition = 0;
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#ifndef __ENCOSHARED_AUDIODECODER_H__
+#define __ENCOSHARED_AUDIODECODER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "MemoryTracker.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Turns a sound file into interleaved f32 frames, one call at a time so long files can be streamed
+	class IAudioDecoder {
+	public:
+		IAudioDecoder() {  }
+		virtual ~IAudioDecoder() {  }
+
+		virtual uint getChannelCount() const = 0;
+		virtual uint getSampleRate() const = 0;
+		// 0 when the length is not known up front
+		virtual u64 getFrameCount() const = 0;
+
+		// Returns the number of frames written, less than frameCount only at the end of the source
+		virtual uint decode(f32 *frames, uint frameCount) = 0;
+		virtual bool rewind() = 0;
+	};
+
+	// RIFF WAVE with 8, 16 or 24 bit PCM, 32 bit float or 4 bit IMA ADPCM, mono or stereo
+	class WavDecoder : public IAudioDecoder {
+	public:
+		ENCOSHAREDAPI WavDecoder();
+		ENCOSHAREDAPI virtual ~WavDecoder();
+
+		ENCOSHAREDAPI bool open(const std::string &path);
+
+		inline virtual uint getChannelCount() const { return m_channelCount; }
+		inline virtual uint getSampleRate() const { return m_sampleRate; }
+		inline virtual u64 getFrameCount() const { return m_frameCount; }
+
+		ENCOSHAREDAPI virtual uint decode(f32 *frames, uint frameCount);
+		ENCOSHAREDAPI virtual bool rewind();
+
+	private:
+		enum Encoding : u8 {
+			pcmEncoding,
+			floatEncoding,
+			adpcmEncoding,
+		};
+
+		WavDecoder(const WavDecoder &) = delete;
+		WavDecoder &operator=(const WavDecoder &) = delete;
+
+		bool decodeBlock();
+
+		std::ifstream m_file;
+		Encoding m_encoding;
+		uint m_channelCount;
+		uint m_sampleRate;
+		uint m_bitsPerSample;
+		uint m_blockAlign;
+		uint m_framesPerBlock;
+		u64 m_frameCount;
+		u64 m_framesLeft;
+		std::streamoff m_dataOffset;
+
+		// Raw bytes of the last read and, for ADPCM, the decoded block that is handed out piece by piece
+		TaggedVector<u8, audioMemory> m_raw;
+		TaggedVector<f32, audioMemory> m_block;
+		uint m_blockFrames;
+		uint m_blockPosition;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,458 @@
+#include "stdafx.h"
+#include "AudioMixer.h"
+#include "Simd.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const f32 minStep = 1.0f / 64.0f;
+		const uint streamInputMargin = 8;
+		const f32 quarterPi = 0.785398163f;
+
+		inline u32 getSlotIndex(AudioVoice voice) {
+			return (voice & 0xFFFF) - 1;
+		}
+
+		// Linear interpolation of frameCount frames from position on, step source frames apart. The caller keeps every
+		// position below sourceFrames, the frame after the last one is the last one again.
+		f64 resample(const f32 *source, uint channelCount, u64 sourceFrames, f64 position, f64 step, uint frameCount, f32 *left, f32 *right) {
+			u64 last = sourceFrames - 1;
+			uint i = 0;
+			for (; i + 4 <= frameCount; i += 4) {
+				f32 first[2][4], second[2][4], fractions[4];
+				for (uint lane = 0; lane < 4; ++lane) {
+					f64 at = position + (i + lane) * step;
+					u64 index = std::min((u64)at, last);
+					u64 next = std::min(index + 1, last);
+					fractions[lane] = (f32)(at - (f64)index);
+					for (uint channel = 0; channel < channelCount; ++channel) {
+						first[channel][lane] = source[index * channelCount + channel];
+						second[channel][lane] = source[next * channelCount + channel];
+					}
+				}
+
+				SimdFloat4 fraction = simdLoad(fractions);
+				SimdFloat4 a = simdLoad(first[0]);
+				simdStore(left + i, simdMulAdd(simdSub(simdLoad(second[0]), a), fraction, a));
+				if (channelCount == 2) {
+					a = simdLoad(first[1]);
+					simdStore(right + i, simdMulAdd(simdSub(simdLoad(second[1]), a), fraction, a));
+				}
+			}
+
+			for (; i < frameCount; ++i) {
+				f64 at = position + i * step;
+				u64 index = std::min((u64)at, last);
+				u64 next = std::min(index + 1, last);
+				f32 fraction = (f32)(at - (f64)index);
+				left[i] = source[index * channelCount] + (source[next * channelCount] - source[index * channelCount]) * fraction;
+				if (channelCount == 2) {
+					right[i] = source[index * 2 + 1] + (source[next * 2 + 1] - source[index * 2 + 1]) * fraction;
+				}
+			}
+			return position + frameCount * step;
+		}
+
+		// target += source * gain with the gain ramping from one block to the next, so volume and pan changes do not click
+		void accumulate(const f32 *source, f32 *target, uint frameCount, f32 from, f32 to) {
+			f32 delta = (to - from) / frameCount;
+			SimdFloat4 gain = simdSet(from + delta, from + 2.0f * delta, from + 3.0f * delta, from + 4.0f * delta);
+			SimdFloat4 increment = simdSet(4.0f * delta);
+			uint i = 0;
+			for (; i + 4 <= frameCount; i += 4) {
+				simdStore(target + i, simdMulAdd(simdLoad(source + i), gain, simdLoad(target + i)));
+				gain = simdAdd(gain, increment);
+			}
+			for (; i < frameCount; ++i) {
+				target[i] += source[i] * (from + delta * (i + 1));
+			}
+		}
+	}
+
+	ENCOSHAREDAPI AudioMixer::AudioMixer(uint sampleRate, uint maxVoices) : m_sampleRate(sampleRate), m_freeSlots(glm::clamp(maxVoices, 1u, 0xFFFFu)), m_commands(commandQueueSize),
+		m_refillRequests(glm::clamp(maxVoices, 1u, 0xFFFFu) * 4), m_finishedVoices(glm::clamp(maxVoices, 1u, 0xFFFFu)), m_listenerPosition(0.0f), m_listenerRight(1.0f, 0.0f, 0.0f),
+		m_masterVolume(1.0f), m_activeVoiceCount(0), m_droppedCommands(0), m_underruns(0) {
+		maxVoices = glm::clamp(maxVoices, 1u, 0xFFFFu);
+		m_slots.reset(new Slot[maxVoices]);
+		for (u32 i = 0; i < maxVoices; ++i) {
+			m_freeSlots.tryPush(i);
+		}
+
+		Voice empty;
+		empty.voice = invalidVoice;
+		empty.clip = nullptr;
+		empty.stream = nullptr;
+		empty.position = 0.0;
+		empty.gainLeft = empty.gainRight = 0.0f;
+		empty.fresh = empty.stopping = empty.started = empty.finished = false;
+		m_voices.assign(maxVoices, empty);
+		m_activeVoices.reserve(maxVoices);
+
+		m_busLeft.resize(maxBlockFrames);
+		m_busRight.resize(maxBlockFrames);
+		m_voiceLeft.resize(maxBlockFrames);
+		m_voiceRight.resize(maxBlockFrames);
+		// Enough stereo frames for a block at the highest pitch plus the frames to interpolate towards
+		m_streamInput.resize(((size_t)maxBlockFrames * maxPitch + streamInputMargin) * 2);
+	}
+
+	ENCOSHAREDAPI AudioMixer::~AudioMixer() {
+	}
+
+	ENCOSHAREDAPI AudioVoice AudioMixer::play(std::shared_ptr<AudioClip> clip, const AudioVoiceSettings &settings) {
+		if (!clip || clip->getFrameCount() == 0 || clip->getChannelCount() > 2) {
+			return invalidVoice;
+		}
+
+		Command command;
+		command.type = playCommand;
+		command.clip = clip.get();
+		command.stream = nullptr;
+		command.settings = settings;
+		return start(command, clip, nullptr);
+	}
+
+	ENCOSHAREDAPI AudioVoice AudioMixer::play(std::shared_ptr<AudioStream> stream, const AudioVoiceSettings &settings) {
+		if (!stream || stream->getSampleRate() == 0 || stream->getChannelCount() > 2) {
+			return invalidVoice;
+		}
+
+		Command command;
+		command.type = playCommand;
+		command.clip = nullptr;
+		command.stream = stream.get();
+		command.settings = settings;
+		return start(command, nullptr, stream);
+	}
+
+	ENCOSHAREDAPI void AudioMixer::stop(AudioVoice voice) {
+		Command command;
+		command.type = stopCommand;
+		command.voice = voice;
+		push(command);
+	}
+
+	ENCOSHAREDAPI void AudioMixer::setVolume(AudioVoice voice, f32 volume) {
+		Command command;
+		command.type = volumeCommand;
+		command.voice = voice;
+		command.settings.volume = volume;
+		push(command);
+	}
+
+	ENCOSHAREDAPI void AudioMixer::setPitch(AudioVoice voice, f32 pitch) {
+		Command command;
+		command.type = pitchCommand;
+		command.voice = voice;
+		command.settings.pitch = pitch;
+		push(command);
+	}
+
+	ENCOSHAREDAPI void AudioMixer::setPosition(AudioVoice voice, const glm::vec3 &position) {
+		Command command;
+		command.type = positionCommand;
+		command.voice = voice;
+		command.settings.position = position;
+		push(command);
+	}
+
+	ENCOSHAREDAPI void AudioMixer::setListener(const glm::vec3 &position, const glm::vec3 &forward, const glm::vec3 &up) {
+		Command command;
+		command.type = listenerCommand;
+		command.voice = invalidVoice;
+		command.settings.position = position;
+		command.forward = forward;
+		command.up = up;
+		push(command);
+	}
+
+	ENCOSHAREDAPI void AudioMixer::setMasterVolume(f32 volume) {
+		Command command;
+		command.type = masterVolumeCommand;
+		command.voice = invalidVoice;
+		command.settings.volume = volume;
+		push(command);
+	}
+
+	ENCOSHAREDAPI bool AudioMixer::isPlaying(AudioVoice voice) const {
+		u32 index = getSlotIndex(voice);
+		return voice != invalidVoice && index < m_voices.size() && m_slots[index].voice.load(std::memory_order_acquire) == voice;
+	}
+
+	ENCOSHAREDAPI void AudioMixer::update(JobSystem *jobSystem) {
+		// Refill requests are taken before the finished voices, a request from a voice that ended in between
+		// still finds its slot and a late one no longer matches the slot
+		AudioVoice voice;
+		while (m_refillRequests.tryPop(voice)) {
+			Slot &slot = m_slots[getSlotIndex(voice)];
+			if (slot.voice.load(std::memory_order_acquire) != voice || !slot.stream || !slot.stream->beginRefill()) {
+				continue;
+			}
+
+			std::shared_ptr<AudioStream> stream = slot.stream;
+			if (jobSystem) {
+				jobSystem->run([stream]() { stream->refill(); });
+			}
+			else {
+				stream->refill();
+			}
+		}
+
+		while (m_finishedVoices.tryPop(voice)) {
+			u32 index = getSlotIndex(voice);
+			Slot &slot = m_slots[index];
+			slot.clip.reset();
+			slot.stream.reset();
+			slot.voice.store(invalidVoice, std::memory_order_release);
+			m_freeSlots.tryPush(index);
+		}
+	}
+
+	ENCOSHAREDAPI void AudioMixer::mix(f32 *output, uint frameCount) {
+		Command command;
+		while (m_commands.tryPop(command)) {
+			apply(command);
+		}
+
+		for (uint offset = 0; offset < frameCount; offset += maxBlockFrames) {
+			uint blockFrames = std::min(frameCount - offset, (uint)maxBlockFrames);
+			std::fill(m_busLeft.begin(), m_busLeft.begin() + blockFrames, 0.0f);
+			std::fill(m_busRight.begin(), m_busRight.begin() + blockFrames, 0.0f);
+
+			for (size_t i = 0; i < m_activeVoices.size();) {
+				Voice &voice = m_voices[m_activeVoices[i]];
+				render(voice, blockFrames);
+
+				f32 gainLeft = voice.settings.volume * m_masterVolume, gainRight = gainLeft;
+				if (voice.settings.spatial) {
+					glm::vec3 direction = voice.settings.position - m_listenerPosition;
+					f32 distance = glm::length(direction);
+					f32 minDistance = std::max(voice.settings.minDistance, 0.001f);
+					f32 attenuation = minDistance / glm::clamp(distance, minDistance, std::max(voice.settings.maxDistance, minDistance));
+					// Constant power pan from hard left (-1) to hard right (1)
+					f32 pan = distance > 0.0001f ? glm::dot(direction / distance, m_listenerRight) : 0.0f;
+					f32 angle = (pan + 1.0f) * quarterPi;
+					gainLeft *= attenuation * cosf(angle);
+					gainRight *= attenuation * sinf(angle);
+				}
+				if (voice.stopping) {
+					gainLeft = gainRight = 0.0f;
+				}
+				if (voice.fresh) {
+					voice.gainLeft = gainLeft;
+					voice.gainRight = gainRight;
+					voice.fresh = false;
+				}
+
+				uint channelCount = voice.clip ? voice.clip->getChannelCount() : voice.stream->getChannelCount();
+				const f32 *right = channelCount == 2 ? &m_voiceRight[0] : &m_voiceLeft[0];
+				accumulate(&m_voiceLeft[0], &m_busLeft[0], blockFrames, voice.gainLeft, gainLeft);
+				accumulate(right, &m_busRight[0], blockFrames, voice.gainRight, gainRight);
+				voice.gainLeft = gainLeft;
+				voice.gainRight = gainRight;
+
+				if (voice.finished || voice.stopping) {
+					finish(voice);
+					m_activeVoices[i] = m_activeVoices.back();
+					m_activeVoices.pop_back();
+				}
+				else {
+					++i;
+				}
+			}
+
+			// Interleave and clip
+			f32 *target = output + offset * 2;
+			SimdFloat4 low = simdSet(-1.0f), high = simdSet(1.0f);
+			uint i = 0;
+			for (; i + 4 <= blockFrames; i += 4) {
+				f32 left[4], right[4];
+				simdStore(left, simdMin(simdMax(simdLoad(&m_busLeft[i]), low), high));
+				simdStore(right, simdMin(simdMax(simdLoad(&m_busRight[i]), low), high));
+				for (uint lane = 0; lane < 4; ++lane) {
+					target[(i + lane) * 2] = left[lane];
+					target[(i + lane) * 2 + 1] = right[lane];
+				}
+			}
+			for (; i < blockFrames; ++i) {
+				target[i * 2] = glm::clamp(m_busLeft[i], -1.0f, 1.0f);
+				target[i * 2 + 1] = glm::clamp(m_busRight[i], -1.0f, 1.0f);
+			}
+		}
+
+		m_activeVoiceCount.store((uint)m_activeVoices.size(), std::memory_order_relaxed);
+	}
+
+	AudioVoice AudioMixer::start(Command &command, std::shared_ptr<AudioClip> clip, std::shared_ptr<AudioStream> stream) {
+		u32 index;
+		if (!m_freeSlots.tryPop(index)) {
+			return invalidVoice;
+		}
+
+		// The slot belongs to this thread until the voice is handed to the audio thread
+		Slot &slot = m_slots[index];
+		++slot.generation;
+		command.voice = (index + 1) | ((u32)slot.generation << 16);
+		slot.clip = clip;
+		slot.stream = stream;
+		slot.voice.store(command.voice, std::memory_order_release);
+
+		if (!m_commands.tryPush(command)) {
+			m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+			slot.clip.reset();
+			slot.stream.reset();
+			slot.voice.store(invalidVoice, std::memory_order_release);
+			m_freeSlots.tryPush(index);
+			return invalidVoice;
+		}
+		return command.voice;
+	}
+
+	void AudioMixer::push(const Command &command) {
+		if (!m_commands.tryPush(command)) {
+			m_droppedCommands.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	void AudioMixer::apply(const Command &command) {
+		if (command.type == listenerCommand) {
+			m_listenerPosition = command.settings.position;
+			glm::vec3 right = glm::cross(command.forward, command.up);
+			f32 length = glm::length(right);
+			m_listenerRight = length > 0.0001f ? right / length : glm::vec3(1.0f, 0.0f, 0.0f);
+			return;
+		}
+		if (command.type == masterVolumeCommand) {
+			m_masterVolume = std::max(command.settings.volume, 0.0f);
+			return;
+		}
+
+		u32 index = getSlotIndex(command.voice);
+		if (command.voice == invalidVoice || index >= m_voices.size()) {
+			return;
+		}
+		Voice &voice = m_voices[index];
+
+		if (command.type == playCommand) {
+			voice.voice = command.voice;
+			voice.clip = command.clip;
+			voice.stream = command.stream;
+			voice.settings = command.settings;
+			voice.position = 0.0;
+			voice.gainLeft = voice.gainRight = 0.0f;
+			voice.fresh = true;
+			voice.stopping = voice.started = voice.finished = false;
+			m_activeVoices.push_back(index);
+			return;
+		}
+
+		// Commands for a voice that already ended are dropped here
+		if (voice.voice != command.voice) {
+			return;
+		}
+		switch (command.type) {
+		case stopCommand:
+			// Faded out over the next block
+			voice.stopping = true;
+			break;
+		case volumeCommand:
+			voice.settings.volume = command.settings.volume;
+			break;
+		case pitchCommand:
+			voice.settings.pitch = command.settings.pitch;
+			break;
+		case positionCommand:
+			voice.settings.position = command.settings.position;
+			break;
+		default:
+			break;
+		}
+	}
+
+	void AudioMixer::render(Voice &voice, uint frameCount) {
+		uint sourceRate = voice.clip ? voice.clip->getSampleRate() : voice.stream->getSampleRate();
+		f64 step = glm::clamp((f64)voice.settings.pitch * sourceRate / m_sampleRate, (f64)minStep, (f64)maxPitch);
+		if (voice.clip) {
+			renderClip(voice, step, frameCount);
+		}
+		else {
+			renderStream(voice, step, frameCount);
+		}
+	}
+
+	void AudioMixer::renderClip(Voice &voice, f64 step, uint frameCount) {
+		const AudioClip &clip = *voice.clip;
+		const f32 *samples = clip.getSamples();
+		uint channelCount = clip.getChannelCount();
+		u64 sourceFrames = clip.getFrameCount();
+
+		uint done = 0;
+		while (done < frameCount) {
+			if (voice.position >= (f64)sourceFrames) {
+				if (!voice.settings.loop) {
+					voice.finished = true;
+					break;
+				}
+				voice.position = fmod(voice.position, (f64)sourceFrames);
+			}
+
+			// Frames whose position is still inside the clip
+			uint count = (uint)std::min<f64>(frameCount - done, ceil(((f64)sourceFrames - voice.position) / step));
+			count = std::max(count, 1u);
+			voice.position = resample(samples, channelCount, sourceFrames, voice.position, step, count, &m_voiceLeft[done], &m_voiceRight[done]);
+			done += count;
+		}
+
+		std::fill(m_voiceLeft.begin() + done, m_voiceLeft.begin() + frameCount, 0.0f);
+		std::fill(m_voiceRight.begin() + done, m_voiceRight.begin() + frameCount, 0.0f);
+	}
+
+	void AudioMixer::renderStream(Voice &voice, f64 step, uint frameCount) {
+		AudioStream &stream = *voice.stream;
+		uint channelCount = stream.getChannelCount();
+
+		// Everything the source will ever produce is in the ring once it ended, so test that before peeking
+		bool ended = stream.isEnded();
+		uint needed = std::min((uint)(voice.position + (frameCount - 1) * step) + 2, (uint)(m_streamInput.size() / channelCount));
+		uint available = stream.peek(&m_streamInput[0], needed);
+
+		uint done = 0;
+		if (available >= 2) {
+			// Interpolation needs the frame after each position, so the last one available is held back
+			f64 last = (f64)(available - 1);
+			if (voice.position < last) {
+				done = (uint)std::min<f64>(frameCount, ceil((last - voice.position) / step));
+				f64 position = resample(&m_streamInput[0], channelCount, available, voice.position, step, done, &m_voiceLeft[0], &m_voiceRight[0]);
+				uint consumed = std::min((uint)position, available - 1);
+				stream.consume(consumed);
+				voice.position = position - consumed;
+			}
+			voice.started = true;
+		}
+
+		if (done < frameCount) {
+			if (ended) {
+				stream.consume(available);
+				voice.finished = true;
+			}
+			else if (voice.started) {
+				stream.addUnderrun();
+				m_underruns.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+		if (!voice.finished && stream.needsRefill()) {
+			m_refillRequests.tryPush(voice.voice);
+		}
+
+		std::fill(m_voiceLeft.begin() + done, m_voiceLeft.begin() + frameCount, 0.0f);
+		std::fill(m_voiceRight.begin() + done, m_voiceRight.begin() + frameCount, 0.0f);
+	}
+
+	void AudioMixer::finish(Voice &voice) {
+		m_finishedVoices.tryPush(voice.voice);
+		voice.voice = invalidVoice;
+		voice.clip = nullptr;
+		voice.stream = nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,157 @@
+#ifndef __ENCOSHARED_AUDIOMIXER_H__
+#define __ENCOSHARED_AUDIOMIXER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AudioClip.h"
+#include "ConcurrentQueue.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace enco {
+	struct AudioVoiceSettings {
+		f32 volume;
+		// Playback speed, also shifts the pitch
+		f32 pitch;
+		// Clips only, a looping stream is set up on the AudioStream
+		bool loop;
+
+		// Spatial voices are attenuated and panned relative to the listener
+		bool spatial;
+		glm::vec3 position;
+		// Full volume up to minDistance, falling off with 1 / distance up to maxDistance
+		f32 minDistance, maxDistance;
+
+		inline AudioVoiceSettings() : volume(1.0f), pitch(1.0f), loop(false), spatial(false), position(0.0f), minDistance(1.0f), maxDistance(50.0f) {  }
+	};
+
+	// Slot index + 1 in the low 16 bits and the generation of the slot in the high 16 bits, 0 is no voice
+	typedef u32 AudioVoice;
+
+	// Mixes clips and streams into interleaved stereo. The game threads only push commands into a lock-free
+	// queue, mix() runs on the audio thread, applies them and renders without allocating or locking: every
+	// buffer is allocated up front and finished voices go back through a second queue so update() can
+	// release them on the game thread.
+	class AudioMixer {
+	public:
+		static const AudioVoice invalidVoice = 0;
+		// mix() renders in blocks of at most this many frames
+		static const uint maxBlockFrames = 512;
+		static const uint maxPitch = 4;
+		static const uint commandQueueSize = 4096;
+
+		ENCOSHAREDAPI AudioMixer(uint sampleRate = 48000, uint maxVoices = 256);
+		ENCOSHAREDAPI ~AudioMixer();
+
+		// Game threads, returns invalidVoice when all voices are in use or the command queue is full
+		ENCOSHAREDAPI AudioVoice play(std::shared_ptr<AudioClip> clip, const AudioVoiceSettings &settings = AudioVoiceSettings());
+		ENCOSHAREDAPI AudioVoice play(std::shared_ptr<AudioStream> stream, const AudioVoiceSettings &settings = AudioVoiceSettings());
+		ENCOSHAREDAPI void stop(AudioVoice voice);
+		ENCOSHAREDAPI void setVolume(AudioVoice voice, f32 volume);
+		ENCOSHAREDAPI void setPitch(AudioVoice voice, f32 pitch);
+		ENCOSHAREDAPI void setPosition(AudioVoice voice, const glm::vec3 &position);
+		ENCOSHAREDAPI void setListener(const glm::vec3 &position, const glm::vec3 &forward, const glm::vec3 &up);
+		ENCOSHAREDAPI void setMasterVolume(f32 volume);
+		// Until update() saw the voice finish
+		ENCOSHAREDAPI bool isPlaying(AudioVoice voice) const;
+
+		// Once per frame on the game thread: releases finished voices and decodes streams on the job system,
+		// or right here without one
+		ENCOSHAREDAPI void update(JobSystem *jobSystem = nullptr);
+
+		// Audio thread
+		ENCOSHAREDAPI void mix(f32 *output, uint frameCount);
+
+		inline uint getSampleRate() const { return m_sampleRate; }
+		inline uint getMaxVoices() const { return (uint)m_voices.size(); }
+		inline uint getActiveVoiceCount() const { return m_activeVoiceCount.load(std::memory_order_relaxed); }
+		inline u64 getDroppedCommandCount() const { return m_droppedCommands.load(std::memory_order_relaxed); }
+		// Blocks in which a stream had not decoded far enough
+		inline u64 getUnderrunCount() const { return m_underruns.load(std::memory_order_relaxed); }
+
+	private:
+		enum CommandType : u8 {
+			playCommand,
+			stopCommand,
+			volumeCommand,
+			pitchCommand,
+			positionCommand,
+			listenerCommand,
+			masterVolumeCommand,
+		};
+
+		// Plain data, the shared pointers stay with the game side slot while the voice plays
+		struct Command {
+			CommandType type;
+			AudioVoice voice;
+			AudioClip *clip;
+			AudioStream *stream;
+			AudioVoiceSettings settings;
+			glm::vec3 forward, up;
+		};
+
+		struct Slot {
+			std::atomic<u32> voice;
+			u16 generation;
+			std::shared_ptr<AudioClip> clip;
+			std::shared_ptr<AudioStream> stream;
+
+			inline Slot() : voice(0), generation(0) {  }
+		};
+
+		struct Voice {
+			AudioVoice voice;
+			AudioClip *clip;
+			AudioStream *stream;
+			AudioVoiceSettings settings;
+			// In source frames, for streams only the fraction between the first two frames of the ring
+			f64 position;
+			f32 gainLeft, gainRight;
+			bool fresh, stopping, started, finished;
+		};
+
+		AudioMixer(const AudioMixer &) = delete;
+		AudioMixer &operator=(const AudioMixer &) = delete;
+
+		AudioVoice start(Command &command, std::shared_ptr<AudioClip> clip, std::shared_ptr<AudioStream> stream);
+		void push(const Command &command);
+		void apply(const Command &command);
+		// Renders the next frames of the voice into m_voiceLeft and m_voiceRight
+		void render(Voice &voice, uint frameCount);
+		void renderClip(Voice &voice, f64 step, uint frameCount);
+		void renderStream(Voice &voice, f64 step, uint frameCount);
+		void finish(Voice &voice);
+
+		uint m_sampleRate;
+
+		// Game side
+		std::unique_ptr<Slot[]> m_slots;
+		ConcurrentQueue<u32> m_freeSlots;
+
+		ConcurrentQueue<Command> m_commands;
+		// From the audio thread, streams running low and voices that ended
+		ConcurrentQueue<AudioVoice> m_refillRequests;
+		ConcurrentQueue<AudioVoice> m_finishedVoices;
+
+		// Audio side
+		TaggedVector<Voice, audioMemory> m_voices;
+		TaggedVector<u32, audioMemory> m_activeVoices;
+		glm::vec3 m_listenerPosition;
+		glm::vec3 m_listenerRight;
+		f32 m_masterVolume;
+		TaggedVector<f32, audioMemory> m_busLeft, m_busRight;
+		TaggedVector<f32, audioMemory> m_voiceLeft, m_voiceRight;
+		TaggedVector<f32, audioMemory> m_streamInput;
+
+		std::atomic<uint> m_activeVoiceCount;
+		std::atomic<u64> m_droppedCommands;
+		std::atomic<u64> m_underruns;
+	};
+}
+
+#endif
\ No newline at end of file
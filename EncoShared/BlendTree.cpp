@@ -0,0 +1,137 @@
+#include "stdafx.h"
+#include "BlendTree.h"
+
+namespace enco {
+	ENCOSHAREDAPI BlendTree::BlendTree() : m_root(invalidNode) {
+	}
+
+	ENCOSHAREDAPI uint BlendTree::addParameter(const std::string &name, f32 defaultValue) {
+		m_parameterNames.push_back(name);
+		m_parameterDefaults.push_back(defaultValue);
+		return (uint)m_parameterNames.size() - 1;
+	}
+
+	ENCOSHAREDAPI uint BlendTree::findParameter(const std::string &name) const {
+		for (size_t i = 0; i < m_parameterNames.size(); ++i) {
+			if (m_parameterNames[i] == name) {
+				return (uint)i;
+			}
+		}
+		return invalidNode;
+	}
+
+	ENCOSHAREDAPI uint BlendTree::addClip(const AnimationClip *clip, f32 speed, bool loop) {
+		Node node;
+		node.type = NodeType::clipNode;
+		node.clip = clip;
+		node.speed = speed;
+		node.loop = loop;
+		node.parameter = invalidNode;
+		return addNode(node);
+	}
+
+	ENCOSHAREDAPI uint BlendTree::addBlend(uint a, uint b, uint parameter) {
+		if (a >= m_nodes.size() || b >= m_nodes.size() || parameter >= m_parameterNames.size()) {
+			return invalidNode;
+		}
+
+		Node node;
+		node.type = NodeType::blendNode;
+		node.clip = nullptr;
+		node.speed = 1.0f;
+		node.loop = true;
+		node.parameter = parameter;
+		node.children.push_back(a);
+		node.children.push_back(b);
+		return addNode(node);
+	}
+
+	ENCOSHAREDAPI uint BlendTree::addBlend1D(const std::vector<uint> &children, const std::vector<f32> &thresholds, uint parameter) {
+		if (children.empty() || children.size() != thresholds.size() || parameter >= m_parameterNames.size()) {
+			return invalidNode;
+		}
+		for (size_t i = 0; i < children.size(); ++i) {
+			if (children[i] >= m_nodes.size() || (i > 0 && thresholds[i] < thresholds[i - 1])) {
+				return invalidNode;
+			}
+		}
+
+		Node node;
+		node.type = NodeType::blend1DNode;
+		node.clip = nullptr;
+		node.speed = 1.0f;
+		node.loop = true;
+		node.parameter = parameter;
+		node.children = children;
+		node.thresholds = thresholds;
+		return addNode(node);
+	}
+
+	ENCOSHAREDAPI void BlendTree::evaluate(f32 time, const f32 *parameters, uint jointCount, JointTransform *pose, BlendScratch &scratch) const {
+		if (m_root >= m_nodes.size()) {
+			return;
+		}
+		evaluateNode(m_root, time, parameters, jointCount, pose, scratch, 0);
+	}
+
+	void BlendTree::evaluateNode(uint node, f32 time, const f32 *parameters, uint jointCount, JointTransform *pose, BlendScratch &scratch, uint depth) const {
+		const Node &entry = m_nodes[node];
+		switch (entry.type) {
+		case NodeType::clipNode:
+			if (entry.clip && entry.clip->getJointCount() == jointCount) {
+				entry.clip->sample(time * entry.speed, entry.loop, pose);
+			}
+			break;
+
+		case NodeType::blendNode:
+			blendNodes(entry.children[0], entry.children[1], glm::clamp(parameters[entry.parameter], 0.0f, 1.0f), time, parameters, jointCount, pose, scratch, depth);
+			break;
+
+		case NodeType::blend1DNode: {
+			f32 value = parameters[entry.parameter];
+			size_t last = entry.children.size() - 1;
+			if (value <= entry.thresholds[0]) {
+				evaluateNode(entry.children[0], time, parameters, jointCount, pose, scratch, depth);
+			}
+			else if (value >= entry.thresholds[last]) {
+				evaluateNode(entry.children[last], time, parameters, jointCount, pose, scratch, depth);
+			}
+			else {
+				size_t upper = 1;
+				while (entry.thresholds[upper] < value) {
+					++upper;
+				}
+				f32 range = entry.thresholds[upper] - entry.thresholds[upper - 1];
+				f32 weight = range > 0.0f ? (value - entry.thresholds[upper - 1]) / range : 1.0f;
+				blendNodes(entry.children[upper - 1], entry.children[upper], weight, time, parameters, jointCount, pose, scratch, depth);
+			}
+			break;
+		}
+		}
+	}
+
+	void BlendTree::blendNodes(uint a, uint b, f32 weight, f32 time, const f32 *parameters, uint jointCount, JointTransform *pose, BlendScratch &scratch, uint depth) const {
+		if (weight <= 0.0f) {
+			evaluateNode(a, time, parameters, jointCount, pose, scratch, depth);
+			return;
+		}
+		if (weight >= 1.0f) {
+			evaluateNode(b, time, parameters, jointCount, pose, scratch, depth);
+			return;
+		}
+
+		evaluateNode(a, time, parameters, jointCount, pose, scratch, depth + 1);
+		// The scratch pose of this depth is only touched by deeper levels after a was evaluated
+		std::vector<JointTransform> &other = scratch.getPose(depth, jointCount);
+		evaluateNode(b, time, parameters, jointCount, &other[0], scratch, depth + 1);
+		for (uint i = 0; i < jointCount; ++i) {
+			pose[i] = JointTransform::blend(pose[i], other[i], weight);
+		}
+	}
+
+	uint BlendTree::addNode(const Node &node) {
+		m_nodes.push_back(node);
+		m_root = (uint)m_nodes.size() - 1;
+		return m_root;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#ifndef __ENCOSHARED_BLENDTREE_H__
+#define __ENCOSHARED_BLENDTREE_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AnimationClip.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Poses of the children of a node, reused between evaluations so that evaluating allocates nothing.
+	// A deque keeps the poses of outer levels in place while deeper levels are added.
+	class BlendScratch {
+	public:
+		inline std::vector<JointTransform> &getPose(uint depth, uint jointCount) {
+			if (m_poses.size() <= depth) {
+				m_poses.resize(depth + 1);
+			}
+			m_poses[depth].resize(jointCount);
+			return m_poses[depth];
+		}
+
+	private:
+		std::deque<std::vector<JointTransform> > m_poses;
+	};
+
+	// Tree of clip, two-way blend and 1D blend space nodes. The tree is shared and immutable while it is
+	// evaluated, per character state (parameters, time, scratch poses) lives in the caller.
+	class BlendTree {
+	public:
+		enum NodeType : u8 {
+			clipNode = 0,
+			blendNode,
+			blend1DNode
+		};
+
+		static const uint invalidNode = 0xFFFFFFFF;
+
+		ENCOSHAREDAPI BlendTree();
+
+		ENCOSHAREDAPI uint addParameter(const std::string &name, f32 defaultValue = 0.0f);
+		ENCOSHAREDAPI uint findParameter(const std::string &name) const;
+
+		ENCOSHAREDAPI uint addClip(const AnimationClip *clip, f32 speed = 1.0f, bool loop = true);
+		// Blends from a to b by the value of parameter, clamped to [0, 1]
+		ENCOSHAREDAPI uint addBlend(uint a, uint b, uint parameter);
+		// Blends the two children whose thresholds enclose the parameter, thresholds must be ascending
+		ENCOSHAREDAPI uint addBlend1D(const std::vector<uint> &children, const std::vector<f32> &thresholds, uint parameter);
+
+		// The last added node is the root unless set otherwise
+		inline void setRoot(uint node) { m_root = node; }
+		inline uint getRoot() const { return m_root; }
+
+		inline uint getParameterCount() const { return (uint)m_parameterNames.size(); }
+		inline const std::vector<f32> &getDefaultParameters() const { return m_parameterDefaults; }
+
+		// Children with zero weight are skipped, so only the clips that contribute are sampled
+		ENCOSHAREDAPI void evaluate(f32 time, const f32 *parameters, uint jointCount, JointTransform *pose, BlendScratch &scratch) const;
+
+	private:
+		struct Node {
+			NodeType type;
+			const AnimationClip *clip;
+			f32 speed;
+			bool loop;
+			uint parameter;
+			std::vector<uint> children;
+			std::vector<f32> thresholds;
+		};
+
+		void evaluateNode(uint node, f32 time, const f32 *parameters, uint jointCount, JointTransform *pose, BlendScratch &scratch, uint depth) const;
+		void blendNodes(uint a, uint b, f32 weight, f32 time, const f32 *parameters, uint jointCount, JointTransform *pose, BlendScratch &scratch, uint depth) const;
+		uint addNode(const Node &node);
+
+		std::vector<Node> m_nodes;
+		std::vector<std::string> m_parameterNames;
+		std::vector<f32> m_parameterDefaults;
+		uint m_root;
+	};
+}
+
+#endif
\ No newline at end of file
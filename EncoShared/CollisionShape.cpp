@@ -0,0 +1,174 @@
+#include "stdafx.h"
+#include "CollisionShape.h"
+#include "Simd.h"
+
+#include <algorithm>
+
+namespace enco {
+	ENCOSHAREDAPI CollisionShape CollisionShape::sphere(f32 radius) {
+		CollisionShape shape;
+		shape.m_type = sphereShape;
+		shape.m_radius = radius;
+		return shape;
+	}
+
+	ENCOSHAREDAPI CollisionShape CollisionShape::box(const glm::vec3 &halfExtents) {
+		CollisionShape shape;
+		shape.m_type = boxShape;
+		shape.m_halfExtents = halfExtents;
+		return shape;
+	}
+
+	ENCOSHAREDAPI CollisionShape CollisionShape::capsule(f32 radius, f32 halfHeight) {
+		CollisionShape shape;
+		shape.m_type = capsuleShape;
+		shape.m_radius = radius;
+		shape.m_halfExtents = glm::vec3(0.0f, halfHeight, 0.0f);
+		return shape;
+	}
+
+	ENCOSHAREDAPI CollisionShape CollisionShape::convex(const std::vector<glm::vec3> &points) {
+		CollisionShape shape;
+		shape.m_type = convexShape;
+		shape.m_points = points;
+		if (points.empty()) {
+			shape.m_points.push_back(glm::vec3(0.0f));
+		}
+
+		AABB bounds(shape.m_points[0], shape.m_points[0]);
+		for (size_t i = 1; i < shape.m_points.size(); ++i) {
+			bounds.merge(shape.m_points[i]);
+		}
+		shape.m_center = bounds.getCenter();
+		shape.m_halfExtents = bounds.getExtents();
+
+		// Padded with copies of the first point, which never changes the maximum
+		size_t padded = (shape.m_points.size() + 3) & ~(size_t)3;
+		shape.m_x.assign(padded, shape.m_points[0].x);
+		shape.m_y.assign(padded, shape.m_points[0].y);
+		shape.m_z.assign(padded, shape.m_points[0].z);
+		for (size_t i = 0; i < shape.m_points.size(); ++i) {
+			shape.m_x[i] = shape.m_points[i].x;
+			shape.m_y[i] = shape.m_points[i].y;
+			shape.m_z[i] = shape.m_points[i].z;
+		}
+		return shape;
+	}
+
+	ENCOSHAREDAPI glm::vec3 CollisionShape::supportCore(const glm::vec3 &direction) const {
+		switch (m_type) {
+		case boxShape:
+			return glm::vec3(direction.x >= 0.0f ? m_halfExtents.x : -m_halfExtents.x, direction.y >= 0.0f ? m_halfExtents.y : -m_halfExtents.y, direction.z >= 0.0f ? m_halfExtents.z : -m_halfExtents.z);
+		case capsuleShape:
+			return glm::vec3(0.0f, direction.y >= 0.0f ? m_halfExtents.y : -m_halfExtents.y, 0.0f);
+		case convexShape: {
+			// Four dot products at a time, keeping the best one per lane and its index
+			SimdFloat4 dx = simdSet(direction.x), dy = simdSet(direction.y), dz = simdSet(direction.z);
+			SimdFloat4 best = simdSet(-1e30f);
+			SimdFloat4 bestIndex = simdZero();
+			SimdFloat4 index = simdSet(0.0f, 1.0f, 2.0f, 3.0f), four = simdSet(4.0f);
+			for (size_t i = 0; i < m_x.size(); i += 4) {
+				SimdFloat4 dot = simdMulAdd(simdLoad(&m_x[i]), dx, simdMulAdd(simdLoad(&m_y[i]), dy, simdMul(simdLoad(&m_z[i]), dz)));
+				SimdFloat4 better = simdGreater(dot, best);
+				best = simdSelect(better, dot, best);
+				bestIndex = simdSelect(better, index, bestIndex);
+				index = simdAdd(index, four);
+			}
+
+			f32 lanes[4], indices[4];
+			simdStore(lanes, best);
+			simdStore(indices, bestIndex);
+			uint lane = 0;
+			for (uint i = 1; i < 4; ++i) {
+				if (lanes[i] > lanes[lane]) {
+					lane = i;
+				}
+			}
+			return m_points[std::min((size_t)indices[lane], m_points.size() - 1)];
+		}
+		default:
+			return glm::vec3(0.0f);
+		}
+	}
+
+	ENCOSHAREDAPI uint CollisionShape::supportFeature(const glm::vec3 &direction, f32 tolerance, glm::vec3 *points, uint maxPoints) const {
+		f32 length = glm::length(direction);
+		glm::vec3 unit = length > 0.0f ? direction / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		uint count = 0;
+		switch (m_type) {
+		case sphereShape:
+			points[count++] = glm::vec3(0.0f);
+			break;
+		case boxShape:
+			// Both signs of an axis almost perpendicular to direction belong to the feature
+			for (uint i = 0; i < 8 && count < maxPoints; ++i) {
+				glm::vec3 corner;
+				bool inside = true;
+				for (uint axis = 0; axis < 3 && inside; ++axis) {
+					bool positive = ((i >> axis) & 1) != 0;
+					inside = fabsf(unit[axis]) <= tolerance || positive == (unit[axis] > 0.0f);
+					corner[axis] = positive ? m_halfExtents[axis] : -m_halfExtents[axis];
+				}
+				if (inside) {
+					points[count++] = corner;
+				}
+			}
+			break;
+		case capsuleShape:
+			if (fabsf(unit.y) > tolerance) {
+				points[count++] = unit.y > 0.0f ? m_halfExtents : -m_halfExtents;
+			}
+			else {
+				points[count++] = -m_halfExtents;
+				if (maxPoints > 1) {
+					points[count++] = m_halfExtents;
+				}
+			}
+			break;
+		default: {
+			glm::vec3 farthest = supportCore(unit);
+			for (size_t i = 0; i < m_points.size() && count < maxPoints; ++i) {
+				glm::vec3 delta = m_points[i] - farthest;
+				if (glm::dot(delta, unit) >= -tolerance * glm::length(delta)) {
+					points[count++] = m_points[i];
+				}
+			}
+			break;
+		}
+		}
+		return count;
+	}
+
+	ENCOSHAREDAPI AABB CollisionShape::getBounds(const ShapeTransform &transform) const {
+		// The rotated local box, grown by the radius
+		glm::mat3 rotation = glm::mat3_cast(transform.orientation);
+		glm::vec3 center = transform.position + rotation * m_center;
+		glm::vec3 extents(m_radius);
+		for (uint i = 0; i < 3; ++i) {
+			extents += glm::abs(rotation[i]) * m_halfExtents[i];
+		}
+		return AABB(center - extents, center + extents);
+	}
+
+	ENCOSHAREDAPI glm::vec3 CollisionShape::getInertia(f32 mass) const {
+		switch (m_type) {
+		case sphereShape:
+			return glm::vec3(0.4f * mass * m_radius * m_radius);
+		case capsuleShape: {
+			// A cylinder and two half spheres, each half sphere shifted to its end of the segment
+			f32 radius = m_radius, halfHeight = m_halfExtents.y;
+			f32 cylinderVolume = 2.0f * halfHeight * radius * radius;
+			f32 sphereVolume = 4.0f / 3.0f * radius * radius * radius;
+			f32 cylinderMass = mass * cylinderVolume / (cylinderVolume + sphereVolume), sphereMass = mass - cylinderMass;
+			f32 axial = cylinderMass * radius * radius * 0.5f + sphereMass * radius * radius * 0.4f;
+			f32 lateral = cylinderMass * (radius * radius * 0.25f + halfHeight * halfHeight / 3.0f) + sphereMass * (radius * radius * 0.4f + halfHeight * halfHeight + 0.75f * halfHeight * radius);
+			return glm::vec3(lateral, axial, lateral);
+		}
+		default: {
+			// Convex shapes are approximated by their bounds
+			glm::vec3 squared = m_halfExtents * m_halfExtents;
+			return mass / 3.0f * glm::vec3(squared.y + squared.z, squared.x + squared.z, squared.x + squared.y);
+		}
+		}
+	}
+}
\ No newline at end of file
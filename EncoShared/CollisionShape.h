@@ -0,0 +1,72 @@
+#ifndef __ENCOSHARED_COLLISIONSHAPE_H__
+#define __ENCOSHARED_COLLISIONSHAPE_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+
+#include <vector>
+
+#include <glm\gtc\quaternion.hpp>
+
+namespace enco {
+	struct ShapeTransform {
+		glm::vec3 position;
+		glm::quat orientation;
+
+		inline ShapeTransform() : position(0.0f), orientation(1.0f, 0.0f, 0.0f, 0.0f) {  }
+		inline ShapeTransform(const glm::vec3 &position, const glm::quat &orientation) : position(position), orientation(orientation) {  }
+	};
+
+	enum CollisionShapeType : u8 {
+		sphereShape,
+		boxShape,
+		capsuleShape,
+		convexShape,
+	};
+
+	// Convex shapes in their own space. Every shape is a core (a point, a segment, a box or a point cloud) grown by
+	// radius, so spheres and capsules collide exactly and the narrowphase only runs GJK on the cores.
+	class CollisionShape {
+	public:
+		ENCOSHAREDAPI static CollisionShape sphere(f32 radius);
+		ENCOSHAREDAPI static CollisionShape box(const glm::vec3 &halfExtents);
+		// Along the y axis, the segment reaches from -halfHeight to halfHeight
+		ENCOSHAREDAPI static CollisionShape capsule(f32 radius, f32 halfHeight);
+		// The convex hull of points, which should be the hull vertices only
+		ENCOSHAREDAPI static CollisionShape convex(const std::vector<glm::vec3> &points);
+
+		inline CollisionShapeType getType() const { return m_type; }
+		inline f32 getRadius() const { return m_radius; }
+		inline const glm::vec3 &getHalfExtents() const { return m_halfExtents; }
+		inline f32 getHalfHeight() const { return m_halfExtents.y; }
+		inline uint getPointCount() const { return (uint)m_points.size(); }
+		inline const glm::vec3 &getPoint(uint index) const { return m_points[index]; }
+
+		// Farthest point of the core in direction, without the radius
+		ENCOSHAREDAPI glm::vec3 supportCore(const glm::vec3 &direction) const;
+		// Core points forming the face, edge or single point farthest in direction. A point belongs to it when the line
+		// from the farthest point to it is within tolerance (a sine) of perpendicular, whatever the size of the shape.
+		ENCOSHAREDAPI uint supportFeature(const glm::vec3 &direction, f32 tolerance, glm::vec3 *points, uint maxPoints) const;
+
+		ENCOSHAREDAPI AABB getBounds(const ShapeTransform &transform) const;
+		// Diagonal of the inertia tensor around the center for a solid body of the given mass
+		ENCOSHAREDAPI glm::vec3 getInertia(f32 mass) const;
+
+	private:
+		inline CollisionShape() : m_type(sphereShape), m_radius(0.0f), m_halfExtents(0.0f), m_center(0.0f) {  }
+
+		CollisionShapeType m_type;
+		f32 m_radius;
+		// Of the box, (0, halfHeight, 0) for capsules and the local bounds of convex points around m_center
+		glm::vec3 m_halfExtents;
+		glm::vec3 m_center;
+
+		// Convex points, and again as padded arrays of x, y and z for the SIMD support search
+		std::vector<glm::vec3> m_points;
+		std::vector<f32> m_x, m_y, m_z;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+#ifndef __ENCOSHARED_CONCURRENTQUEUE_H__
+#define __ENCOSHARED_CONCURRENTQUEUE_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace enco {
+	// Bounded lock-free multi-producer/multi-consumer queue (Dmitry Vyukov's sequence-number ring).
+	// Capacity is rounded up to a power of two. tryPush fails instead of blocking when the queue is full.
+	template<typename T>
+	class ConcurrentQueue {
+	public:
+		inline ConcurrentQueue(size_t capacity = 1024) : m_cells(roundUp(capacity)), m_mask(m_cells.size() - 1), m_enqueuePos(0), m_dequeuePos(0) {
+			for (size_t i = 0; i < m_cells.size(); ++i) {
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		inline bool tryPush(const T &value) {
+			size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell &cell = m_cells[pos & m_mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+				if (diff == 0) {
+					if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						cell.value = value;
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0) {
+					return false;
+				}
+				else {
+					pos = m_enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		inline bool tryPop(T &value) {
+			size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell &cell = m_cells[pos & m_mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+				if (diff == 0) {
+					if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						value = cell.value;
+						cell.sequence.store(pos + m_mask + 1, std::memory_order_release);
+						return true;
+					}
+				}
+				else if (diff < 0) {
+					return false;
+				}
+				else {
+					pos = m_dequeuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		inline size_t getCapacity() const { return m_cells.size(); }
+
+	private:
+		ConcurrentQueue(const ConcurrentQueue &) = delete;
+		ConcurrentQueue &operator=(const ConcurrentQueue &) = delete;
+
+		struct Cell {
+			std::atomic<size_t> sequence;
+			T value;
+
+			inline Cell() : sequence(0) {  }
+			inline Cell(const Cell &other) : sequence(other.sequence.load()), value(other.value) {  }
+		};
+
+		static inline size_t roundUp(size_t value) {
+			size_t result = 2;
+			while (result < value) {
+				result <<= 1;
+			}
+			return result;
+		}
+
+		std::vector<Cell> m_cells;
+		size_t m_mask;
+
+		// Keep producers and consumers on separate cache lines
+		u8 m_pad0[64];
+		std::atomic<size_t> m_enqueuePos;
+		u8 m_pad1[64];
+		std::atomic<size_t> m_dequeuePos;
+		u8 m_pad2[64];
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,282 @@
+#include "stdafx.h"
+#include "DebugDraw.h"
+#include "Font.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace enco {
+	// Corner i of a box takes max on the axes whose bit is set in i
+	static const u8 s_boxEdges[24] = { 0, 1, 2, 3, 4, 5, 6, 7, 0, 2, 1, 3, 4, 6, 5, 7, 0, 4, 1, 5, 2, 6, 3, 7 };
+
+	// Slots are shared by all DebugDraw instances and returned when a thread exits, which runs under the loader lock
+	// on Windows, so the free list is a lock-free stack. Its head is the top slot plus one in the low half and a
+	// counter in the high half that changes with every push and pop, so a stale head never matches.
+	// s_threadSlot is the slot plus one, 0 means the thread has none and maxThreads + 1 that it uses the overflow buffer.
+	static std::atomic<u64> s_freeSlotHead(0);
+	static std::atomic<uint> s_nextFreeSlot[DebugDraw::maxThreads];
+	static std::atomic<uint> s_nextThreadSlot(0);
+	static ENCO_THREAD_LOCAL uint s_threadSlot = 0;
+
+	namespace {
+		uint popFreeSlot() {
+			u64 head = s_freeSlotHead.load(std::memory_order_acquire);
+			while ((u32)head != 0) {
+				uint slot = (u32)head - 1;
+				u64 next = ((head >> 32) + 1) << 32 | s_nextFreeSlot[slot].load(std::memory_order_relaxed);
+				if (s_freeSlotHead.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire)) {
+					return slot + 1;
+				}
+			}
+			return 0;
+		}
+
+		void pushFreeSlot(uint slot) {
+			u64 head = s_freeSlotHead.load(std::memory_order_relaxed);
+			u64 next;
+			do {
+				s_nextFreeSlot[slot].store((u32)head, std::memory_order_relaxed);
+				next = ((head >> 32) + 1) << 32 | (slot + 1);
+			} while (!s_freeSlotHead.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+		}
+	}
+
+#ifndef _WIN32
+	// Without DllMain the slot is given back by the destructor of a thread local object
+	struct ThreadSlotRelease {
+		~ThreadSlotRelease() { DebugDraw::releaseThreadSlot(); }
+	};
+	static thread_local ThreadSlotRelease s_threadSlotRelease;
+#endif
+
+	ENCOSHAREDAPI DebugDraw::DebugDraw() : m_enabled(true) {
+	}
+
+	ENCOSHAREDAPI DebugDraw::~DebugDraw() {
+	}
+
+	ENCOSHAREDAPI void DebugDraw::line(const glm::vec3 &a, const glm::vec3 &b, const glm::vec4 &color) {
+		if (!m_enabled) {
+			return;
+		}
+
+		u32 packed = packColor(color);
+		DebugVertex vertices[2] = { { a, packed }, { b, packed } };
+		appendLines(vertices, 2);
+	}
+
+	ENCOSHAREDAPI void DebugDraw::box(const AABB &box, const glm::vec4 &color) {
+		this->box(box, glm::mat4(1.0f), color);
+	}
+
+	ENCOSHAREDAPI void DebugDraw::box(const AABB &box, const glm::mat4 &transform, const glm::vec4 &color) {
+		if (!m_enabled) {
+			return;
+		}
+
+		glm::vec3 corners[8];
+		for (int i = 0; i < 8; ++i) {
+			glm::vec3 corner((i & 1) ? box.max.x : box.min.x, (i & 2) ? box.max.y : box.min.y, (i & 4) ? box.max.z : box.min.z);
+			corners[i] = glm::vec3(transform * glm::vec4(corner, 1.0f));
+		}
+
+		u32 packed = packColor(color);
+		DebugVertex vertices[24];
+		for (int i = 0; i < 24; ++i) {
+			vertices[i].position = corners[s_boxEdges[i]];
+			vertices[i].color = packed;
+		}
+		appendLines(vertices, 24);
+	}
+
+	ENCOSHAREDAPI void DebugDraw::sphere(const glm::vec3 &center, f32 radius, const glm::vec4 &color, uint segments) {
+		if (!m_enabled) {
+			return;
+		}
+
+		const uint maxSegments = 64;
+		segments = glm::clamp(segments, 3u, maxSegments);
+
+		u32 packed = packColor(color);
+		DebugVertex vertices[maxSegments * 6];
+		uint count = 0;
+		for (uint i = 0; i < segments; ++i) {
+			f32 angles[2] = { 6.28318531f * i / segments, 6.28318531f * (i + 1) / segments };
+			for (int end = 0; end < 2; ++end) {
+				f32 c = std::cos(angles[end]) * radius, s = std::sin(angles[end]) * radius;
+				vertices[count + end].position = center + glm::vec3(c, s, 0.0f);
+				vertices[count + 2 + end].position = center + glm::vec3(c, 0.0f, s);
+				vertices[count + 4 + end].position = center + glm::vec3(0.0f, c, s);
+			}
+			for (int j = 0; j < 6; ++j) {
+				vertices[count + j].color = packed;
+			}
+			count += 6;
+		}
+		appendLines(vertices, count);
+	}
+
+	ENCOSHAREDAPI void DebugDraw::frustum(const glm::mat4 &viewProjection, const glm::vec4 &color) {
+		if (!m_enabled) {
+			return;
+		}
+
+		// The corners are ordered like the ones of a box
+		glm::vec3 corners[8];
+		Frustum::getCorners(viewProjection, corners);
+
+		u32 packed = packColor(color);
+		DebugVertex vertices[24];
+		for (int i = 0; i < 24; ++i) {
+			vertices[i].position = corners[s_boxEdges[i]];
+			vertices[i].color = packed;
+		}
+		appendLines(vertices, 24);
+	}
+
+	ENCOSHAREDAPI void DebugDraw::text(const glm::vec3 &anchor, const std::string &text, const glm::vec4 &color, uint scale) {
+		if (!m_enabled || text.empty()) {
+			return;
+		}
+
+		u32 packed = packColor(color);
+		f32 pixel = (f32)(scale ? scale : 1);
+		f32 x = 0.0f, y = 0.0f;
+
+		// Every horizontal run of set pixels becomes one quad, a glyph has at most two runs per row
+		DebugTextVertex vertices[glyphHeight * 2 * 6];
+		for (size_t i = 0; i < text.size(); ++i) {
+			int character = (u8)text[i];
+			if (character == '\n') {
+				x = 0.0f;
+				y -= (glyphHeight + 2) * pixel;
+				continue;
+			}
+			u16 glyph = BuiltinGlyphRasterizer::getGlyphBits(character);
+
+			uint count = 0;
+			for (uint row = 0; row < glyphHeight; ++row) {
+				uint bits = (glyph >> ((glyphHeight - 1 - row) * glyphWidth)) & 7;
+				for (uint column = 0; column < glyphWidth;) {
+					if (!(bits & (4 >> column))) {
+						++column;
+						continue;
+					}
+
+					uint start = column;
+					while (column < glyphWidth && (bits & (4 >> column))) {
+						++column;
+					}
+
+					f32 left = x + start * pixel, right = x + column * pixel;
+					f32 top = y - row * pixel, bottom = top - pixel;
+					glm::vec2 quad[6] = { glm::vec2(left, bottom), glm::vec2(right, bottom), glm::vec2(right, top), glm::vec2(left, bottom), glm::vec2(right, top), glm::vec2(left, top) };
+					for (int j = 0; j < 6; ++j) {
+						vertices[count].anchor = anchor;
+						vertices[count].offset = quad[j];
+						vertices[count].color = packed;
+						++count;
+					}
+				}
+			}
+			if (count > 0) {
+				appendText(vertices, count);
+			}
+			x += (glyphWidth + 1) * pixel;
+		}
+	}
+
+	ENCOSHAREDAPI void DebugDraw::clear() {
+		for (uint i = 0; i < maxThreads; ++i) {
+			m_buffers[i].lines.clear();
+			m_buffers[i].text.clear();
+		}
+		m_overflow.lines.clear();
+		m_overflow.text.clear();
+	}
+
+	ENCOSHAREDAPI uint DebugDraw::getLineVertexCount() const {
+		size_t count = m_overflow.lines.size();
+		for (uint i = 0; i < maxThreads; ++i) {
+			count += m_buffers[i].lines.size();
+		}
+		return (uint)count;
+	}
+
+	ENCOSHAREDAPI uint DebugDraw::getTextVertexCount() const {
+		size_t count = m_overflow.text.size();
+		for (uint i = 0; i < maxThreads; ++i) {
+			count += m_buffers[i].text.size();
+		}
+		return (uint)count;
+	}
+
+	ENCOSHAREDAPI void DebugDraw::gather(DebugVertex *lines, DebugTextVertex *text) const {
+		for (uint i = 0; i <= maxThreads; ++i) {
+			const ThreadBuffer &buffer = i < maxThreads ? m_buffers[i] : m_overflow;
+			if (lines) {
+				for (size_t j = 0; j < buffer.lines.size(); ++j) {
+					*lines++ = buffer.lines[j];
+				}
+			}
+			if (text) {
+				for (size_t j = 0; j < buffer.text.size(); ++j) {
+					*text++ = buffer.text[j];
+				}
+			}
+		}
+	}
+
+	ENCOSHAREDAPI u32 DebugDraw::packColor(const glm::vec4 &color) {
+		glm::vec4 clamped = glm::clamp(color, 0.0f, 1.0f) * 255.0f + 0.5f;
+		return (u32)clamped.r | ((u32)clamped.g << 8) | ((u32)clamped.b << 16) | ((u32)clamped.a << 24);
+	}
+
+	void DebugDraw::appendLines(const DebugVertex *vertices, uint count) {
+		uint slot = getThreadSlot();
+		if (slot < maxThreads) {
+			m_buffers[slot].lines.insert(m_buffers[slot].lines.end(), vertices, vertices + count);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_overflowMutex);
+		m_overflow.lines.insert(m_overflow.lines.end(), vertices, vertices + count);
+	}
+
+	void DebugDraw::appendText(const DebugTextVertex *vertices, uint count) {
+		uint slot = getThreadSlot();
+		if (slot < maxThreads) {
+			m_buffers[slot].text.insert(m_buffers[slot].text.end(), vertices, vertices + count);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_overflowMutex);
+		m_overflow.text.insert(m_overflow.text.end(), vertices, vertices + count);
+	}
+
+	uint DebugDraw::getThreadSlot() {
+		// Threads on the overflow buffer try again so they become lock-free once a slot is returned
+		if (s_threadSlot == 0 || s_threadSlot > maxThreads) {
+			s_threadSlot = popFreeSlot();
+			if (s_threadSlot == 0 && s_nextThreadSlot.load(std::memory_order_relaxed) < maxThreads) {
+				uint slot = s_nextThreadSlot.fetch_add(1, std::memory_order_relaxed);
+				s_threadSlot = slot < maxThreads ? slot + 1 : 0;
+			}
+			if (s_threadSlot == 0) {
+				s_threadSlot = maxThreads + 1;
+			}
+#ifndef _WIN32
+			(void)&s_threadSlotRelease;
+#endif
+		}
+		return s_threadSlot - 1;
+	}
+
+	ENCOSHAREDAPI void DebugDraw::releaseThreadSlot() {
+		if (s_threadSlot != 0 && s_threadSlot <= maxThreads) {
+			pushFreeSlot(s_threadSlot - 1);
+		}
+		s_threadSlot = 0;
+	}
+}
\ No newline at end of file
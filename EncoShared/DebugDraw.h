@@ -0,0 +1,96 @@
+#ifndef __ENCOSHARED_DEBUGDRAW_H__
+#define __ENCOSHARED_DEBUGDRAW_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+#include "MemoryTracker.h"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Colors are packed RGBA8 with red in the lowest byte
+	struct DebugVertex {
+		glm::vec3 position;
+		u32 color;
+	};
+
+	// Text is drawn in screen space: offset is in pixels from the projected anchor, y pointing up
+	struct DebugTextVertex {
+		glm::vec3 anchor;
+		glm::vec2 offset;
+		u32 color;
+	};
+
+	// Immediate mode debug geometry that can be added from any thread. Every thread appends to a buffer of
+	// its own without locking, the renderer gathers all of them into one vertex stream per primitive type.
+	// Drawing and clear() must not overlap with threads that add geometry. A thread gives its buffer slot
+	// back when it exits, so only maxThreads threads running at once are lock-free.
+	class DebugDraw {
+	public:
+		static const uint maxThreads = 64;
+		// Size of the built-in font in font pixels
+		static const uint glyphWidth = 3;
+		static const uint glyphHeight = 5;
+
+		ENCOSHAREDAPI DebugDraw();
+		ENCOSHAREDAPI ~DebugDraw();
+
+		// While disabled every call returns right away
+		inline void setEnabled(bool enabled) { m_enabled = enabled; }
+		inline bool isEnabled() const { return m_enabled; }
+
+		ENCOSHAREDAPI void line(const glm::vec3 &a, const glm::vec3 &b, const glm::vec4 &color);
+		ENCOSHAREDAPI void box(const AABB &box, const glm::vec4 &color);
+		// An oriented box: the local box moved by transform
+		ENCOSHAREDAPI void box(const AABB &box, const glm::mat4 &transform, const glm::vec4 &color);
+		// Three great circles
+		ENCOSHAREDAPI void sphere(const glm::vec3 &center, f32 radius, const glm::vec4 &color, uint segments = 16);
+		// The clip volume of viewProjection in the space it maps from
+		ENCOSHAREDAPI void frustum(const glm::mat4 &viewProjection, const glm::vec4 &color);
+		// Upper case ASCII in a 3x5 pixel font, lower case letters are drawn as upper case. scale is in
+		// screen pixels per font pixel.
+		ENCOSHAREDAPI void text(const glm::vec3 &anchor, const std::string &text, const glm::vec4 &color, uint scale = 2);
+
+		ENCOSHAREDAPI void clear();
+
+		ENCOSHAREDAPI uint getLineVertexCount() const;
+		ENCOSHAREDAPI uint getTextVertexCount() const;
+
+		// Copies the vertices of all threads, lines and text need room for the counts above or are nullptr to skip them
+		ENCOSHAREDAPI void gather(DebugVertex *lines, DebugTextVertex *text) const;
+
+		ENCOSHAREDAPI static u32 packColor(const glm::vec4 &color);
+
+		// Returns the buffer slot of the calling thread to the free list, called when a thread exits
+		ENCOSHAREDAPI static void releaseThreadSlot();
+
+	private:
+		struct ThreadBuffer {
+			TaggedVector<DebugVertex, rendererMemory> lines;
+			TaggedVector<DebugTextVertex, rendererMemory> text;
+			// Keeps the buffers of two threads off the same cache line
+			u8 padding[64];
+		};
+
+		DebugDraw(const DebugDraw &) = delete;
+		DebugDraw &operator=(const DebugDraw &) = delete;
+
+		void appendLines(const DebugVertex *vertices, uint count);
+		void appendText(const DebugTextVertex *vertices, uint count);
+
+		static uint getThreadSlot();
+
+		bool m_enabled;
+		ThreadBuffer m_buffers[maxThreads];
+
+		// Threads that find no free slot share one locked buffer
+		ThreadBuffer m_overflow;
+		std::mutex m_overflowMutex;
+	};
+}
+
+#endif
\ No newline at end of file
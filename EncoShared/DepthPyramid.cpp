@@ -0,0 +1,104 @@
+#include "stdafx.h"
+#include "DepthPyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace enco {
+	ENCOSHAREDAPI DepthPyramid::DepthPyramid() : m_viewProjection(1.0f) {
+	}
+
+	ENCOSHAREDAPI void DepthPyramid::build(const f32 *depth, uint width, uint height, const glm::mat4 &viewProjection) {
+		m_viewProjection = viewProjection;
+		m_levels.clear();
+		if (!depth || width == 0 || height == 0) {
+			return;
+		}
+
+		Level base;
+		base.width = width;
+		base.height = height;
+		base.depth.assign(depth, depth + (size_t)width * height);
+		m_levels.push_back(base);
+
+		while (m_levels.back().width > 1 || m_levels.back().height > 1) {
+			const Level &source = m_levels.back();
+			Level level;
+			level.width = std::max(1u, source.width / 2);
+			level.height = std::max(1u, source.height / 2);
+			level.depth.resize((size_t)level.width * level.height);
+
+			// The last row and column also cover the leftover texel of odd sizes
+			for (uint y = 0; y < level.height; ++y) {
+				uint y0 = y * 2;
+				uint y1 = y == level.height - 1 ? source.height : std::min(y0 + 2, source.height);
+				for (uint x = 0; x < level.width; ++x) {
+					uint x0 = x * 2;
+					uint x1 = x == level.width - 1 ? source.width : std::min(x0 + 2, source.width);
+
+					f32 farthest = 0.0f;
+					for (uint sy = y0; sy < y1; ++sy) {
+						for (uint sx = x0; sx < x1; ++sx) {
+							farthest = std::max(farthest, source.depth[(size_t)sy * source.width + sx]);
+						}
+					}
+					level.depth[(size_t)y * level.width + x] = farthest;
+				}
+			}
+			m_levels.push_back(level);
+		}
+	}
+
+	ENCOSHAREDAPI bool DepthPyramid::isOccluded(const BoundingSphere &sphere) const {
+		if (m_levels.empty()) {
+			return false;
+		}
+
+		// Screen rectangle and nearest depth of the box around the sphere
+		glm::vec2 minimum(1e30f), maximum(-1e30f);
+		f32 nearest = 1e30f;
+		for (int i = 0; i < 8; ++i) {
+			glm::vec3 corner = sphere.center + glm::vec3((i & 1) ? sphere.radius : -sphere.radius, (i & 2) ? sphere.radius : -sphere.radius, (i & 4) ? sphere.radius : -sphere.radius);
+			glm::vec4 clip = m_viewProjection * glm::vec4(corner, 1.0f);
+			if (clip.w <= 1e-5f) {
+				// Crosses the camera plane
+				return false;
+			}
+
+			glm::vec3 ndc = glm::vec3(clip) / clip.w;
+			minimum = glm::min(minimum, glm::vec2(ndc));
+			maximum = glm::max(maximum, glm::vec2(ndc));
+			nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+		}
+
+		if (nearest <= 0.0f || maximum.x < -1.0f || maximum.y < -1.0f || minimum.x > 1.0f || minimum.y > 1.0f) {
+			return false;
+		}
+
+		const Level &base = m_levels.front();
+		f32 x0 = (glm::clamp(minimum.x, -1.0f, 1.0f) * 0.5f + 0.5f) * base.width;
+		f32 x1 = (glm::clamp(maximum.x, -1.0f, 1.0f) * 0.5f + 0.5f) * base.width;
+		f32 y0 = (glm::clamp(minimum.y, -1.0f, 1.0f) * 0.5f + 0.5f) * base.height;
+		f32 y1 = (glm::clamp(maximum.y, -1.0f, 1.0f) * 0.5f + 0.5f) * base.height;
+
+		// Level on which the rectangle spans at most two texels per axis
+		f32 size = std::max(x1 - x0, y1 - y0);
+		uint levelIndex = size > 1.0f ? (uint)std::ceil(std::log(size) / std::log(2.0f)) : 0;
+		levelIndex = std::min(levelIndex, (uint)m_levels.size() - 1);
+		const Level &level = m_levels[levelIndex];
+
+		// Texel x of level k covers base texels [x << k, (x + 1) << k), the last one also the rest
+		uint lx0 = std::min((uint)x0 >> levelIndex, level.width - 1);
+		uint lx1 = std::min(std::min((uint)x1, base.width - 1) >> levelIndex, level.width - 1);
+		uint ly0 = std::min((uint)y0 >> levelIndex, level.height - 1);
+		uint ly1 = std::min(std::min((uint)y1, base.height - 1) >> levelIndex, level.height - 1);
+
+		f32 farthest = 0.0f;
+		for (uint y = ly0; y <= ly1; ++y) {
+			for (uint x = lx0; x <= lx1; ++x) {
+				farthest = std::max(farthest, level.depth[(size_t)y * level.width + x]);
+			}
+		}
+		return nearest > farthest;
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef __ENCOSHARED_DEPTHPYRAMID_H__
+#define __ENCOSHARED_DEPTHPYRAMID_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+
+#include <vector>
+
+namespace enco {
+	// CPU max-depth mip chain for occlusion tests, usually built from last frame's depth buffer
+	// (OpenGLRenderer::readbackDepth). Tests use the viewProjection the depth was rendered with.
+	class DepthPyramid {
+	public:
+		ENCOSHAREDAPI DepthPyramid();
+
+		// depth holds width * height window space depths in [0, 1], rows bottom to top as glReadPixels returns them
+		ENCOSHAREDAPI void build(const f32 *depth, uint width, uint height, const glm::mat4 &viewProjection);
+
+		// Conservative, only true if the whole sphere is behind the stored depth
+		ENCOSHAREDAPI bool isOccluded(const BoundingSphere &sphere) const;
+
+		inline bool isValid() const { return !m_levels.empty(); }
+		inline uint getLevelCount() const { return (uint)m_levels.size(); }
+
+	private:
+		struct Level {
+			uint width, height;
+			std::vector<f32> depth;
+		};
+
+		std::vector<Level> m_levels;
+		glm::mat4 m_viewProjection;
+	};
+}
+
+#endif
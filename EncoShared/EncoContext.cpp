@@ -1,22 +1,145 @@
 #include "stdafx.h"
 #include "EncoContext.h"
 
+#include <algorithm>
+
 namespace enco {
-	ENCOSHAREDAPI EncoContext::EncoContext(std::shared_ptr<IView> mainView, std::shared_ptr<IRenderer> renderer) : m_mainView(mainView), m_renderer(renderer) {
+	namespace {
+		// Longer frames are dropped instead of catching up, which would make the next frame even longer
+		const f32 maxFrameTime = 0.25f;
+		const uint maxPhysicsSteps = 4;
+	}
+
+	ENCOSHAREDAPI EncoContext::EncoContext(std::shared_ptr<IView> mainView, std::shared_ptr<IRenderer> renderer, const std::string &assetDirectory) : m_renderer(renderer), m_assetManager(new AssetManager(assetDirectory)), m_jobSystem(new JobSystem()), m_debugDraw(new DebugDraw()), m_audioMixer(new AudioMixer()), m_physicsWorld(new PhysicsWorld()), m_spatialQuery(new SpatialQuery(m_physicsWorld.get())), m_pathQuery(new PathQuery()), m_scene(new Scene()), m_worldPartition(new WorldPartition(*m_assetManager, *m_scene)), m_random(new Random()), m_sessionRecorder(new SessionRecorder()), m_fixedTimestep(1.0f / 60.0f), m_physicsAccumulator(0.0f), m_lastUpdate(std::chrono::steady_clock::now()), m_started(false) {
+		m_views.push_back(mainView);
 	}
 
 	ENCOSHAREDAPI EncoContext::~EncoContext() {
 	}
 
 	ENCOSHAREDAPI void EncoContext::start() {
-		m_mainView->create(m_renderer.get());
+		for (size_t i = 0; i < m_views.size(); ++i) {
+			m_views[i]->create(m_renderer.get());
+		}
+		m_lastUpdate = std::chrono::steady_clock::now();
+		m_physicsAccumulator = 0.0f;
+		m_started = true;
 	}
 
 	ENCOSHAREDAPI void EncoContext::stop() {
-		m_mainView->destroy();
+		m_assetManager->disableHotReload();
+
+		for (size_t i = m_views.size(); i > 0; --i) {
+			m_views[i - 1]->destroy();
+		}
+		m_started = false;
+	}
+
+	ENCOSHAREDAPI void EncoContext::startRecording() {
+		u64 seed = (u64)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+		m_random->setSeed(seed);
+		m_physicsAccumulator = 0.0f;
+		m_sessionRecorder->startRecording(seed, m_fixedTimestep, m_views);
+	}
+
+	ENCOSHAREDAPI bool EncoContext::stopRecording(const std::string &path) {
+		return m_sessionRecorder->stopRecording(path, m_views);
+	}
+
+	ENCOSHAREDAPI bool EncoContext::startReplay(const std::string &path) {
+		if (!m_sessionRecorder->startReplay(path)) {
+			return false;
+		}
+
+		const SessionRecording &recording = m_sessionRecorder->getRecording();
+		m_random->setSeed(recording.seed);
+		m_fixedTimestep = recording.fixedTimestep;
+		m_physicsAccumulator = 0.0f;
+		return true;
 	}
 
 	ENCOSHAREDAPI bool EncoContext::update() {
-		return m_mainView->update(0); // TODO: Add proper delta time
+		std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+
+		m_assetManager->commit();
+		m_worldPartition->update();
+		m_audioMixer->update(m_jobSystem.get());
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		f32 frameTime = std::chrono::duration<f32>(now - m_lastUpdate).count();
+		m_lastUpdate = now;
+		if (!m_sessionRecorder->beginFrame(frameTime)) {
+			return false;
+		}
+		m_physicsAccumulator += std::min(frameTime, maxFrameTime);
+		for (uint i = 0; m_physicsAccumulator >= m_fixedTimestep; ++i) {
+			if (i == maxPhysicsSteps) {
+				m_physicsAccumulator = 0.0f;
+				break;
+			}
+			if (m_fixedUpdateCallback) {
+				m_fixedUpdateCallback(m_fixedTimestep);
+			}
+			m_physicsWorld->step(m_fixedTimestep, m_jobSystem.get());
+			m_physicsAccumulator -= m_fixedTimestep;
+		}
+		m_spatialQuery->update(m_jobSystem.get());
+		m_pathQuery->update(m_jobSystem.get());
+		m_scene->updateTransforms();
+
+		if (!m_views.front()->update(frameTime)) {
+			return false;
+		}
+
+		for (size_t i = 1; i < m_views.size();) {
+			if (m_views[i]->update(frameTime)) {
+				++i;
+			}
+			else {
+				m_views[i]->destroy();
+				m_views.erase(m_views.begin() + i);
+			}
+		}
+		m_sessionRecorder->processInput(m_views);
+
+		// One pass over all views: the renderer only rebinds the drawable when the window changes and presents each window once
+		m_renderer->beginFrame();
+		for (size_t i = 0; i < m_views.size(); ++i) {
+			IView &view = *m_views[i];
+			glm::u32vec2 size = view.getSize();
+
+			m_renderer->beginView(view.getSDLWindow(), size.x, size.y);
+			if (IRenderTarget *target = view.getRenderTarget()) {
+				m_renderer->bindRenderTarget(target);
+			}
+			if (m_renderCallback) {
+				m_renderCallback(view, *m_renderer);
+			}
+			m_renderer->endView(view.getSDLWindow());
+		}
+		m_renderer->endFrame();
+		m_debugDraw->clear();
+
+		m_sessionRecorder->endFrame(std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - frameStart).count(), m_renderer->getGpuFrameTime());
+		return true;
+	}
+
+	ENCOSHAREDAPI void EncoContext::addView(std::shared_ptr<IView> view) {
+		m_views.push_back(view);
+		if (m_started) {
+			view->create(m_renderer.get());
+		}
+	}
+
+	ENCOSHAREDAPI void EncoContext::removeView(std::shared_ptr<IView> view) {
+		std::vector<std::shared_ptr<IView>>::iterator it = std::find(m_views.begin() + 1, m_views.end(), view);
+		if (it == m_views.end()) {
+			return;
+		}
+
+		if (m_started) {
+			view->destroy();
+		}
+		m_views.erase(it);
 	}
 }
\ No newline at end of file
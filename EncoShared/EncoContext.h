@@ -6,24 +6,99 @@
 #include "stdafx.h"
 #include "IView.h"
 #include "IRenderer.h"
+#include "AssetManager.h"
+#include "JobSystem.h"
+#include "DebugDraw.h"
+#include "AudioMixer.h"
+#include "PhysicsWorld.h"
+#include "SpatialQuery.h"
+#include "PathQuery.h"
+#include "Scene.h"
+#include "WorldPartition.h"
+#include "Random.h"
+#include "SessionRecorder.h"
 
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace enco {
 	class EncoContext {
 	public:
-		ENCOSHAREDAPI EncoContext(std::shared_ptr<IView> mainView, std::shared_ptr<IRenderer> renderer);
+		typedef std::function<void(IView &view, IRenderer &renderer)> RenderCallback;
+		typedef std::function<void(f32 deltaTime)> FixedUpdateCallback;
+
+		ENCOSHAREDAPI EncoContext(std::shared_ptr<IView> mainView, std::shared_ptr<IRenderer> renderer, const std::string &assetDirectory = ".");
 		ENCOSHAREDAPI ~EncoContext();
 
 		ENCOSHAREDAPI void start();
 		ENCOSHAREDAPI void stop();
 		ENCOSHAREDAPI bool update();
 
-		inline std::shared_ptr<IView> getMainView() const { return m_mainView; }
-		
+		// Additional views share the renderer context and all of its resources with the main view
+		ENCOSHAREDAPI void addView(std::shared_ptr<IView> view);
+		ENCOSHAREDAPI void removeView(std::shared_ptr<IView> view);
+
+		inline void setRenderCallback(RenderCallback callback) { m_renderCallback = callback; }
+		// Called before every physics step with the fixed timestep
+		inline void setFixedUpdateCallback(FixedUpdateCallback callback) { m_fixedUpdateCallback = callback; }
+
+		inline void setFixedTimestep(f32 timestep) { m_fixedTimestep = timestep; }
+		inline f32 getFixedTimestep() const { return m_fixedTimestep; }
+		// How far the frame is between the last physics step and the next one, for interpolating rendered transforms
+		inline f32 getPhysicsAlpha() const { return m_physicsAccumulator / m_fixedTimestep; }
+
+		// Seeds getRandom() and records the frame times and input of every update() until stopRecording()
+		ENCOSHAREDAPI void startRecording();
+		ENCOSHAREDAPI bool stopRecording(const std::string &path);
+		// Replays a recording with its seed and timestep from the next update() on, update() returns false after
+		// the last recorded frame. Start it where the recording was started, e.g. right after the level loaded.
+		ENCOSHAREDAPI bool startReplay(const std::string &path);
+
+		inline std::shared_ptr<IView> getMainView() const { return m_views.front(); }
+		inline const std::vector<std::shared_ptr<IView>> &getViews() const { return m_views; }
+		inline std::shared_ptr<IRenderer> getRenderer() const { return m_renderer; }
+		inline AssetManager &getAssetManager() const { return *m_assetManager; }
+		inline JobSystem &getJobSystem() const { return *m_jobSystem; }
+		// Cleared after every frame, so geometry added during update() is drawn by the render callback of that frame
+		inline DebugDraw &getDebugDraw() const { return *m_debugDraw; }
+		// update() releases finished voices and decodes streams on the job system, a platform device plays it
+		inline AudioMixer &getAudioMixer() const { return *m_audioMixer; }
+		// Stepped by update() at the fixed timestep, as often as the elapsed time asks for
+		inline PhysicsWorld &getPhysicsWorld() const { return *m_physicsWorld; }
+		// Batches submitted during a frame are answered by the next update(), after the physics steps
+		inline SpatialQuery &getSpatialQuery() const { return *m_spatialQuery; }
+		// Has no navigation mesh until the game sets one, batches are answered by update() like spatial queries
+		inline PathQuery &getPathQuery() const { return *m_pathQuery; }
+		inline Scene &getScene() const { return *m_scene; }
+		// Streams cells into the scene around the view positions the game sets, within a time budget per update()
+		inline WorldPartition &getWorldPartition() const { return *m_worldPartition; }
+		// Game code that has to replay the same way draws its random numbers from here
+		inline Random &getRandom() const { return *m_random; }
+		// Holds the timings of the frames replayed so far
+		inline SessionRecorder &getSessionRecorder() const { return *m_sessionRecorder; }
+
 	private:
-		std::shared_ptr<IView> m_mainView;
+		std::vector<std::shared_ptr<IView>> m_views;
 		std::shared_ptr<IRenderer> m_renderer;
+		std::unique_ptr<AssetManager> m_assetManager;
+		std::unique_ptr<JobSystem> m_jobSystem;
+		std::unique_ptr<DebugDraw> m_debugDraw;
+		std::unique_ptr<AudioMixer> m_audioMixer;
+		std::unique_ptr<PhysicsWorld> m_physicsWorld;
+		std::unique_ptr<SpatialQuery> m_spatialQuery;
+		std::unique_ptr<PathQuery> m_pathQuery;
+		std::unique_ptr<Scene> m_scene;
+		std::unique_ptr<WorldPartition> m_worldPartition;
+		std::unique_ptr<Random> m_random;
+		std::unique_ptr<SessionRecorder> m_sessionRecorder;
+		RenderCallback m_renderCallback;
+		FixedUpdateCallback m_fixedUpdateCallback;
+		f32 m_fixedTimestep;
+		f32 m_physicsAccumulator;
+		std::chrono::steady_clock::time_point m_lastUpdate;
+		bool m_started;
 	};
 }
 
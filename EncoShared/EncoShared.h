@@ -5,8 +5,60 @@
 
 #include "stdafx.h"
 
+#include "MemoryTracker.h"
+#include "ConcurrentQueue.h"
+#include "JobSystem.h"
+#include "Simd.h"
+#include "Random.h"
+#include "Input.h"
+
 #include "IView.h"
+#include "IRenderTarget.h"
 #include "IRenderer.h"
+#include "OffscreenView.h"
+#include "RenderGraph.h"
+#include "Frustum.h"
+#include "LightClusterGrid.h"
+#include "ShadowCascades.h"
+
+#include "FileWatcher.h"
+#include "AssetManager.h"
+#include "MeshData.h"
+#include "MeshSimplifier.h"
+#include "LodSelector.h"
+#include "DepthPyramid.h"
+#include "Meshlets.h"
+#include "Skeleton.h"
+#include "AnimationClip.h"
+#include "BlendTree.h"
+#include "Animator.h"
+#include "Skinning.h"
+#include "ParticleEmitter.h"
+#include "DebugDraw.h"
+#include "Font.h"
+#include "GlyphAtlas.h"
+#include "TextBatch.h"
+#include "RectPacker.h"
+#include "SpriteAtlas.h"
+#include "SpriteBatch.h"
+#include "AudioDecoder.h"
+#include "AudioClip.h"
+#include "AudioMixer.h"
+#include "AabbTree.h"
+#include "CollisionShape.h"
+#include "Narrowphase.h"
+#include "PhysicsWorld.h"
+#include "TriangleMesh.h"
+#include "SpatialQuery.h"
+#include "NavMesh.h"
+#include "NavMeshBuilder.h"
+#include "PathQuery.h"
+#include "Terrain.h"
+#include "Reflection.h"
+#include "SceneBlob.h"
+#include "Scene.h"
+#include "WorldPartition.h"
+#include "SessionRecorder.h"
 
 #include "EncoContext.h"
 
@@ -0,0 +1,207 @@
+#include "stdafx.h"
+#include "FileWatcher.h"
+
+#ifndef _WIN32
+#	include <sys/inotify.h>
+#	include <dirent.h>
+#	include <poll.h>
+#	include <unistd.h>
+#endif
+
+namespace enco {
+	ENCOSHAREDAPI FileWatcher::FileWatcher() : m_running(false) {
+#ifdef _WIN32
+		m_directoryHandle = INVALID_HANDLE_VALUE;
+		m_stopEvent = nullptr;
+#else
+		m_inotify = -1;
+		m_stopPipe[0] = m_stopPipe[1] = -1;
+#endif
+	}
+
+	ENCOSHAREDAPI FileWatcher::~FileWatcher() {
+		stop();
+	}
+
+#ifdef _WIN32
+
+	ENCOSHAREDAPI bool FileWatcher::start(const std::string &directory, Callback callback) {
+		stop();
+
+		m_directoryHandle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+		if (m_directoryHandle == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+
+		m_stopEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+		m_directory = directory;
+		m_callback = callback;
+		m_running = true;
+		m_thread = std::thread(&FileWatcher::run, this);
+		return true;
+	}
+
+	ENCOSHAREDAPI void FileWatcher::stop() {
+		if (!m_running) {
+			return;
+		}
+
+		m_running = false;
+		SetEvent(m_stopEvent);
+		m_thread.join();
+
+		CloseHandle(m_directoryHandle);
+		CloseHandle(m_stopEvent);
+		m_directoryHandle = INVALID_HANDLE_VALUE;
+		m_stopEvent = nullptr;
+	}
+
+	void FileWatcher::run() {
+		DWORD buffer[4096];
+		OVERLAPPED overlapped = {};
+		overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+		HANDLE handles[2] = { m_stopEvent, overlapped.hEvent };
+		const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME;
+
+		while (m_running) {
+			ResetEvent(overlapped.hEvent);
+			if (!ReadDirectoryChangesW(m_directoryHandle, buffer, sizeof(buffer), TRUE, filter, nullptr, &overlapped, nullptr)) {
+				break;
+			}
+
+			if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+				CancelIo(m_directoryHandle);
+				break;
+			}
+
+			DWORD bytes = 0;
+			if (!GetOverlappedResult(m_directoryHandle, &overlapped, &bytes, FALSE) || bytes == 0) {
+				continue;
+			}
+
+			const u8 *cursor = (const u8 *)buffer;
+			for (;;) {
+				const FILE_NOTIFY_INFORMATION *info = (const FILE_NOTIFY_INFORMATION *)cursor;
+				if (info->Action == FILE_ACTION_MODIFIED || info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+					int length = (int)(info->FileNameLength / sizeof(WCHAR));
+					int size = WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, nullptr, 0, nullptr, nullptr);
+					std::string name(size, '\0');
+					WideCharToMultiByte(CP_UTF8, 0, info->FileName, length, &name[0], size, nullptr, nullptr);
+					m_callback(m_directory + "/" + name);
+				}
+
+				if (info->NextEntryOffset == 0) {
+					break;
+				}
+				cursor += info->NextEntryOffset;
+			}
+		}
+
+		CloseHandle(overlapped.hEvent);
+	}
+
+#else
+
+	ENCOSHAREDAPI bool FileWatcher::start(const std::string &directory, Callback callback) {
+		stop();
+
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_inotify < 0) {
+			return false;
+		}
+		if (pipe(m_stopPipe) != 0) {
+			close(m_inotify);
+			m_inotify = -1;
+			return false;
+		}
+
+		m_directory = directory;
+		m_callback = callback;
+		addWatchRecursive(directory);
+
+		m_running = true;
+		m_thread = std::thread(&FileWatcher::run, this);
+		return true;
+	}
+
+	ENCOSHAREDAPI void FileWatcher::stop() {
+		if (!m_running) {
+			return;
+		}
+
+		m_running = false;
+		char wake = 0;
+		if (write(m_stopPipe[1], &wake, 1) < 0) {
+			// The thread still terminates on the next inotify event
+		}
+		m_thread.join();
+
+		close(m_inotify);
+		close(m_stopPipe[0]);
+		close(m_stopPipe[1]);
+		m_inotify = -1;
+		m_stopPipe[0] = m_stopPipe[1] = -1;
+		m_watches.clear();
+	}
+
+	void FileWatcher::addWatchRecursive(const std::string &directory) {
+		int watch = inotify_add_watch(m_inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (watch < 0) {
+			return;
+		}
+		m_watches[watch] = directory;
+
+		DIR *dir = opendir(directory.c_str());
+		if (!dir) {
+			return;
+		}
+		while (dirent *entry = readdir(dir)) {
+			if (entry->d_type == DT_DIR && entry->d_name[0] != '.') {
+				addWatchRecursive(directory + "/" + entry->d_name);
+			}
+		}
+		closedir(dir);
+	}
+
+	void FileWatcher::run() {
+		alignas(inotify_event) char buffer[4096];
+
+		pollfd fds[2];
+		fds[0].fd = m_inotify;
+		fds[0].events = POLLIN;
+		fds[1].fd = m_stopPipe[0];
+		fds[1].events = POLLIN;
+
+		while (m_running) {
+			if (poll(fds, 2, -1) <= 0 || (fds[1].revents & POLLIN)) {
+				continue;
+			}
+
+			ssize_t bytes;
+			while ((bytes = read(m_inotify, buffer, sizeof(buffer))) > 0) {
+				for (char *cursor = buffer; cursor < buffer + bytes;) {
+					const inotify_event *event = (const inotify_event *)cursor;
+					cursor += sizeof(inotify_event) + event->len;
+
+					std::map<int, std::string>::const_iterator it = m_watches.find(event->wd);
+					if (it == m_watches.end() || event->len == 0) {
+						continue;
+					}
+
+					std::string path = it->second + "/" + event->name;
+					if (event->mask & IN_ISDIR) {
+						if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+							addWatchRecursive(path);
+						}
+					}
+					else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+						m_callback(path);
+					}
+				}
+			}
+		}
+	}
+
+#endif
+}
\ No newline at end of file
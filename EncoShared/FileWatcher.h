@@ -0,0 +1,54 @@
+#ifndef __ENCOSHARED_FILEWATCHER_H__
+#define __ENCOSHARED_FILEWATCHER_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <string>
+#include <thread>
+
+namespace enco {
+	// Watches a directory tree on a background thread and reports modified files.
+	// The thread blocks inside the OS (inotify / ReadDirectoryChangesW) so an idle watcher costs nothing.
+	class FileWatcher {
+	public:
+		typedef std::function<void(const std::string &path)> Callback;
+
+		ENCOSHAREDAPI FileWatcher();
+		ENCOSHAREDAPI ~FileWatcher();
+
+		ENCOSHAREDAPI bool start(const std::string &directory, Callback callback);
+		ENCOSHAREDAPI void stop();
+
+		inline bool isRunning() const { return m_running; }
+		inline std::string getDirectory() const { return m_directory; }
+
+	private:
+		FileWatcher(const FileWatcher &) = delete;
+		FileWatcher &operator=(const FileWatcher &) = delete;
+
+		void run();
+
+		std::string m_directory;
+		Callback m_callback;
+		std::thread m_thread;
+		std::atomic<bool> m_running;
+
+#ifdef _WIN32
+		HANDLE m_directoryHandle;
+		HANDLE m_stopEvent;
+#else
+		void addWatchRecursive(const std::string &directory);
+
+		int m_inotify;
+		int m_stopPipe[2];
+		std::map<int, std::string> m_watches;
+#endif
+	};
+}
+
+#endif
\ No newline at end of file
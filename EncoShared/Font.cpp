@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "Font.h"
+
+namespace enco {
+	// Glyphs for ASCII 32 to 95, five rows of three bits from the top left
+	static const u16 s_glyphs[64] = {
+		0x0000, 0x2482, 0x5A00, 0x5F7D, 0x3C9E, 0x52A5, 0x2AAB, 0x2400,
+		0x1491, 0x4494, 0x0AA8, 0x05D0, 0x0014, 0x01C0, 0x0002, 0x12A4,
+		0x7B6F, 0x2C97, 0x73E7, 0x72CF, 0x5BC9, 0x79CF, 0x79EF, 0x7292,
+		0x7BEF, 0x7BCF, 0x0410, 0x0414, 0x1511, 0x0E38, 0x4454, 0x7282,
+		0x2BE3, 0x2BED, 0x6BAE, 0x3923, 0x6B6E, 0x79A7, 0x79A4, 0x396B,
+		0x5BED, 0x7497, 0x126A, 0x5BAD, 0x4927, 0x5FED, 0x6B6D, 0x2B6A,
+		0x6BA4, 0x2B73, 0x6BAD, 0x388E, 0x7492, 0x5B6F, 0x5B6A, 0x5BFD,
+		0x5AAD, 0x5A92, 0x72A7, 0x3493, 0x4889, 0x6496, 0x2A00, 0x0007
+	};
+
+	namespace {
+		// Font pixels are whole screen pixels so the glyphs stay sharp, a line is seven font pixels high
+		uint getFontPixel(uint pixelHeight) {
+			return pixelHeight >= 7 ? pixelHeight / 7 : 1;
+		}
+	}
+
+	ENCOSHAREDAPI FontMetrics BuiltinGlyphRasterizer::getMetrics(uint pixelHeight) const {
+		f32 pixel = (f32)getFontPixel(pixelHeight);
+
+		FontMetrics metrics;
+		metrics.ascent = glyphHeight * pixel;
+		metrics.descent = pixel;
+		metrics.lineGap = pixel;
+		return metrics;
+	}
+
+	ENCOSHAREDAPI bool BuiltinGlyphRasterizer::rasterize(u32 codepoint, uint pixelHeight, GlyphBitmap &glyph) const {
+		if (codepoint < 32 || codepoint == 127) {
+			return false;
+		}
+
+		uint pixel = getFontPixel(pixelHeight);
+		u16 bits = getGlyphBits(codepoint);
+
+		glyph.width = glyphWidth * pixel;
+		glyph.height = glyphHeight * pixel;
+		glyph.bearingX = 0.0f;
+		glyph.bearingY = (f32)glyph.height;
+		glyph.advance = (f32)((glyphWidth + 1) * pixel);
+		glyph.coverage.assign(glyph.width * glyph.height, 0);
+
+		for (uint y = 0; y < glyph.height; ++y) {
+			uint row = (bits >> ((glyphHeight - 1 - y / pixel) * glyphWidth)) & 7;
+			for (uint x = 0; x < glyph.width; ++x) {
+				if (row & (4 >> (x / pixel))) {
+					glyph.coverage[y * glyph.width + x] = 255;
+				}
+			}
+		}
+		return true;
+	}
+
+	ENCOSHAREDAPI u16 BuiltinGlyphRasterizer::getGlyphBits(u32 codepoint) {
+		if (codepoint >= 'a' && codepoint <= 'z') {
+			codepoint -= 'a' - 'A';
+		}
+		return s_glyphs[codepoint >= 32 && codepoint < 96 ? codepoint - 32 : '?' - 32];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,61 @@
+#ifndef __ENCOSHARED_FONT_H__
+#define __ENCOSHARED_FONT_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <vector>
+
+namespace enco {
+	// All values are in pixels at the size the glyph was rasterized at
+	struct FontMetrics {
+		f32 ascent;
+		f32 descent;
+		f32 lineGap;
+
+		inline FontMetrics() : ascent(0.0f), descent(0.0f), lineGap(0.0f) {  }
+	};
+
+	// 8 bit coverage, rows from the top. bearingX and bearingY place the top left of the bitmap relative to the
+	// pen on the baseline, y pointing up.
+	struct GlyphBitmap {
+		uint width, height;
+		f32 bearingX, bearingY;
+		f32 advance;
+		std::vector<u8> coverage;
+
+		inline GlyphBitmap() : width(0), height(0), bearingX(0.0f), bearingY(0.0f), advance(0.0f) {  }
+	};
+
+	// Turns code points into coverage bitmaps, e.g. by wrapping a TrueType library. Glyphs are requested
+	// from the thread that owns the GlyphAtlas only.
+	class IGlyphRasterizer {
+	public:
+		IGlyphRasterizer() {  }
+		virtual ~IGlyphRasterizer() {  }
+
+		virtual FontMetrics getMetrics(uint pixelHeight) const = 0;
+
+		// false when the font has no glyph for codepoint
+		virtual bool rasterize(u32 codepoint, uint pixelHeight, GlyphBitmap &glyph) const = 0;
+
+		virtual f32 getKerning(u32 left, u32 right, uint pixelHeight) const { return 0.0f; }
+	};
+
+	// The 3x5 pixel font of DebugDraw scaled up, so text works without a font file. Lower case letters
+	// are drawn as upper case.
+	class BuiltinGlyphRasterizer : public IGlyphRasterizer {
+	public:
+		static const uint glyphWidth = 3;
+		static const uint glyphHeight = 5;
+
+		ENCOSHAREDAPI virtual FontMetrics getMetrics(uint pixelHeight) const;
+		ENCOSHAREDAPI virtual bool rasterize(u32 codepoint, uint pixelHeight, GlyphBitmap &glyph) const;
+
+		// Five rows of three bits from the top left, '?' for characters the font does not have
+		ENCOSHAREDAPI static u16 getGlyphBits(u32 codepoint);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "stdafx.h"
+#include "Frustum.h"
+#include "Simd.h"
+
+namespace enco {
+	ENCOSHAREDAPI AABB AABB::transform(const glm::mat4 &matrix) const {
+		// Arvo: project the extents onto the absolute axes of the matrix
+		glm::vec3 center = glm::vec3(matrix * glm::vec4(getCenter(), 1.0f));
+		glm::vec3 extents = getExtents();
+		glm::vec3 newExtents(0.0f);
+		for (int i = 0; i < 3; ++i) {
+			newExtents += glm::abs(glm::vec3(matrix[i])) * extents[i];
+		}
+		return AABB(center - newExtents, center + newExtents);
+	}
+
+	ENCOSHAREDAPI void Frustum::set(const glm::mat4 &viewProjection) {
+		// Gribb/Hartmann plane extraction from the rows of the matrix
+		glm::vec4 row0(viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]);
+		glm::vec4 row1(viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]);
+		glm::vec4 row2(viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]);
+		glm::vec4 row3(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+
+		m_planes[leftPlane] = row3 + row0;
+		m_planes[rightPlane] = row3 - row0;
+		m_planes[bottomPlane] = row3 + row1;
+		m_planes[topPlane] = row3 - row1;
+		m_planes[nearPlane] = row3 + row2;
+		m_planes[farPlane] = row3 - row2;
+
+		for (int i = 0; i < planeCount; ++i) {
+			m_planes[i] /= glm::length(glm::vec3(m_planes[i]));
+		}
+	}
+
+	ENCOSHAREDAPI bool Frustum::intersects(const BoundingSphere &sphere) const {
+		for (int i = 0; i < planeCount; ++i) {
+			if (glm::dot(glm::vec3(m_planes[i]), sphere.center) + m_planes[i].w < -sphere.radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ENCOSHAREDAPI bool Frustum::intersects(const AABB &box) const {
+		glm::vec3 center = box.getCenter();
+		glm::vec3 extents = box.getExtents();
+		for (int i = 0; i < planeCount; ++i) {
+			glm::vec3 normal(m_planes[i]);
+			f32 radius = glm::dot(extents, glm::abs(normal));
+			if (glm::dot(normal, center) + m_planes[i].w < -radius) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	ENCOSHAREDAPI void Frustum::intersects(const f32 *centerX, const f32 *centerY, const f32 *centerZ, const f32 *extentX, const f32 *extentY, const f32 *extentZ, uint count, u8 *visible) const {
+		uint i = 0;
+		for (; i + 4 <= count; i += 4) {
+			SimdFloat4 cx = simdLoad(centerX + i), cy = simdLoad(centerY + i), cz = simdLoad(centerZ + i);
+			SimdFloat4 ex = simdLoad(extentX + i), ey = simdLoad(extentY + i), ez = simdLoad(extentZ + i);
+			SimdFloat4 outside = simdZero();
+			for (int j = 0; j < planeCount; ++j) {
+				const glm::vec4 &plane = m_planes[j];
+				SimdFloat4 distance = simdMulAdd(cx, simdSet(plane.x), simdMulAdd(cy, simdSet(plane.y), simdMulAdd(cz, simdSet(plane.z), simdSet(plane.w))));
+				SimdFloat4 radius = simdMulAdd(ex, simdSet(fabsf(plane.x)), simdMulAdd(ey, simdSet(fabsf(plane.y)), simdMul(ez, simdSet(fabsf(plane.z)))));
+				outside = simdOr(outside, simdLess(simdAdd(distance, radius), simdZero()));
+			}
+			int mask = simdMoveMask(outside);
+			for (int lane = 0; lane < 4; ++lane) {
+				visible[i + lane] = (mask >> lane) & 1 ? 0 : 1;
+			}
+		}
+		for (; i < count; ++i) {
+			glm::vec3 center(centerX[i], centerY[i], centerZ[i]), extents(extentX[i], extentY[i], extentZ[i]);
+			visible[i] = intersects(AABB(center - extents, center + extents)) ? 1 : 0;
+		}
+	}
+
+	ENCOSHAREDAPI void Frustum::getCorners(const glm::mat4 &viewProjection, glm::vec3 corners[8]) {
+		glm::mat4 inverse = glm::inverse(viewProjection);
+		for (int i = 0; i < 8; ++i) {
+			glm::vec4 corner = inverse * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 1.0f);
+			corners[i] = glm::vec3(corner) / corner.w;
+		}
+	}
+}
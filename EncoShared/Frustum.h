@@ -0,0 +1,67 @@
+#ifndef __ENCOSHARED_FRUSTUM_H__
+#define __ENCOSHARED_FRUSTUM_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+namespace enco {
+	struct AABB {
+		glm::vec3 min, max;
+
+		inline AABB() : min(0.0f), max(0.0f) {  }
+		inline AABB(const glm::vec3 &min, const glm::vec3 &max) : min(min), max(max) {  }
+
+		inline glm::vec3 getCenter() const { return (min + max) * 0.5f; }
+		inline glm::vec3 getExtents() const { return (max - min) * 0.5f; }
+
+		inline void merge(const glm::vec3 &point) { min = glm::min(min, point); max = glm::max(max, point); }
+		inline void merge(const AABB &other) { min = glm::min(min, other.min); max = glm::max(max, other.max); }
+
+		// Bounds of the box after an affine transformation
+		ENCOSHAREDAPI AABB transform(const glm::mat4 &matrix) const;
+	};
+
+	struct BoundingSphere {
+		glm::vec3 center;
+		f32 radius;
+
+		inline BoundingSphere() : center(0.0f), radius(0.0f) {  }
+		inline BoundingSphere(const glm::vec3 &center, f32 radius) : center(center), radius(radius) {  }
+	};
+
+	// Planes point inwards and are normalized, w holds the distance so that dot(plane.xyz, p) + plane.w >= 0 is inside
+	class Frustum {
+	public:
+		enum PlaneIndex : u8 {
+			leftPlane = 0,
+			rightPlane,
+			bottomPlane,
+			topPlane,
+			nearPlane,
+			farPlane,
+			planeCount
+		};
+
+		inline Frustum() {  }
+		inline explicit Frustum(const glm::mat4 &viewProjection) { set(viewProjection); }
+
+		ENCOSHAREDAPI void set(const glm::mat4 &viewProjection);
+
+		ENCOSHAREDAPI bool intersects(const BoundingSphere &sphere) const;
+		ENCOSHAREDAPI bool intersects(const AABB &box) const;
+		// Boxes given by the components of their centers and extents, tested four at a time. visible[i] is 1 when
+		// box i intersects and 0 otherwise.
+		ENCOSHAREDAPI void intersects(const f32 *centerX, const f32 *centerY, const f32 *centerZ, const f32 *extentX, const f32 *extentY, const f32 *extentZ, uint count, u8 *visible) const;
+
+		inline const glm::vec4 &getPlane(uint index) const { return m_planes[index]; }
+
+		// The eight corners of the clip volume in the space viewProjection maps from, near plane first
+		ENCOSHAREDAPI static void getCorners(const glm::mat4 &viewProjection, glm::vec3 corners[8]);
+
+	private:
+		glm::vec4 m_planes[planeCount];
+	};
+}
+
+#endif
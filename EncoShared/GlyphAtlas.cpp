@@ -0,0 +1,289 @@
+#include "stdafx.h"
+#include "GlyphAtlas.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace enco {
+	namespace {
+		const f32 farAway = 1e20f;
+
+		// Exact squared distance transform of one row or column (Felzenszwalb and Huttenlocher)
+		void distanceTransform(const f32 *input, f32 *output, int count, int *vertices, f32 *bounds) {
+			int k = 0;
+			vertices[0] = 0;
+			bounds[0] = -farAway;
+			bounds[1] = farAway;
+			for (int q = 1; q < count; ++q) {
+				f32 s = ((input[q] + q * q) - (input[vertices[k]] + vertices[k] * vertices[k])) / (2.0f * (q - vertices[k]));
+				while (s <= bounds[k]) {
+					--k;
+					s = ((input[q] + q * q) - (input[vertices[k]] + vertices[k] * vertices[k])) / (2.0f * (q - vertices[k]));
+				}
+				++k;
+				vertices[k] = q;
+				bounds[k] = s;
+				bounds[k + 1] = farAway;
+			}
+
+			k = 0;
+			for (int q = 0; q < count; ++q) {
+				while (bounds[k + 1] < q) {
+					++k;
+				}
+				f32 d = (f32)(q - vertices[k]);
+				output[q] = d * d + input[vertices[k]];
+			}
+		}
+
+		void distanceTransform(std::vector<f32> &grid, int width, int height) {
+			int length = std::max(width, height);
+			std::vector<f32> input(length), output(length), bounds(length + 1);
+			std::vector<int> vertices(length);
+
+			for (int x = 0; x < width; ++x) {
+				for (int y = 0; y < height; ++y) {
+					input[y] = grid[y * width + x];
+				}
+				distanceTransform(&input[0], &output[0], height, &vertices[0], &bounds[0]);
+				for (int y = 0; y < height; ++y) {
+					grid[y * width + x] = output[y];
+				}
+			}
+			for (int y = 0; y < height; ++y) {
+				distanceTransform(&grid[y * width], &output[0], width, &vertices[0], &bounds[0]);
+				std::copy(output.begin(), output.begin() + width, grid.begin() + y * width);
+			}
+		}
+
+		inline u64 makeKey(uint font, u32 codepoint) {
+			return ((u64)font << 32) | codepoint;
+		}
+	}
+
+	ENCOSHAREDAPI GlyphAtlas::GlyphAtlas(uint maxPages) : m_maxPages(std::max(maxPages, 1u)), m_head(noCell), m_tail(noCell), m_frame(1), m_residentCount(0), m_evictions(0), m_rasterized(0), m_overflows(0) {
+	}
+
+	ENCOSHAREDAPI GlyphAtlas::~GlyphAtlas() {
+	}
+
+	ENCOSHAREDAPI uint GlyphAtlas::addFont(std::shared_ptr<IGlyphRasterizer> rasterizer) {
+		const f32 pixelHeight = (f32)(fieldSize * oversampling);
+
+		Font font;
+		font.rasterizer = rasterizer;
+		font.metrics = rasterizer->getMetrics(fieldSize * oversampling);
+		font.metrics.ascent /= pixelHeight;
+		font.metrics.descent /= pixelHeight;
+		font.metrics.lineGap /= pixelHeight;
+		m_fonts.push_back(font);
+		return (uint)(m_fonts.size() - 1);
+	}
+
+	ENCOSHAREDAPI const FontMetrics &GlyphAtlas::getMetrics(uint font) const {
+		static const FontMetrics empty;
+		return font < m_fonts.size() ? m_fonts[font].metrics : empty;
+	}
+
+	ENCOSHAREDAPI f32 GlyphAtlas::getKerning(uint font, u32 left, u32 right) const {
+		if (font >= m_fonts.size()) {
+			return 0.0f;
+		}
+		return m_fonts[font].rasterizer->getKerning(left, right, fieldSize * oversampling) / (f32)(fieldSize * oversampling);
+	}
+
+	ENCOSHAREDAPI const AtlasGlyph *GlyphAtlas::getGlyph(uint font, u32 codepoint) {
+		if (font >= m_fonts.size()) {
+			return nullptr;
+		}
+
+		u64 key = makeKey(font, codepoint);
+		std::unordered_map<u64, Entry>::iterator found = m_entries.find(key);
+		if (found != m_entries.end()) {
+			Entry &entry = found->second;
+			if (entry.cell != noCell) {
+				m_cells[entry.cell].lastUsedFrame = m_frame;
+				if (m_head != entry.cell) {
+					unlink(entry.cell);
+					pushFront(entry.cell);
+				}
+			}
+			else if (entry.hasTexels) {
+				// Evicted or did not fit earlier
+				GlyphBitmap bitmap;
+				if (rasterize(font, codepoint, bitmap)) {
+					place(key, entry, bitmap);
+				}
+			}
+			return &entry.glyph;
+		}
+
+		GlyphBitmap bitmap;
+		bool valid = rasterize(font, codepoint, bitmap);
+
+		Entry &entry = m_entries[key];
+		entry.cell = noCell;
+		entry.hasTexels = valid && bitmap.width > 0 && bitmap.height > 0;
+		entry.glyph.page = noPage;
+		entry.glyph.x = entry.glyph.y = entry.glyph.width = entry.glyph.height = 0;
+		entry.glyph.left = entry.glyph.top = 0.0f;
+		entry.glyph.advance = valid ? bitmap.advance / (f32)(fieldSize * oversampling) : 0.0f;
+		if (entry.hasTexels) {
+			place(key, entry, bitmap);
+		}
+		return &entry.glyph;
+	}
+
+	ENCOSHAREDAPI void GlyphAtlas::beginFrame() {
+		++m_frame;
+	}
+
+	bool GlyphAtlas::rasterize(uint font, u32 codepoint, GlyphBitmap &bitmap) const {
+		const IGlyphRasterizer &rasterizer = *m_fonts[font].rasterizer;
+		if (rasterizer.rasterize(codepoint, fieldSize * oversampling, bitmap)) {
+			return true;
+		}
+		return codepoint != '?' && rasterizer.rasterize('?', fieldSize * oversampling, bitmap);
+	}
+
+	bool GlyphAtlas::place(u64 key, Entry &entry, const GlyphBitmap &bitmap) {
+		u32 cell = allocateCell();
+		if (cell == noCell) {
+			++m_overflows;
+			return false;
+		}
+		++m_rasterized;
+
+		// The coverage is thresholded on the oversampled grid and padded by the spread, the distance to the
+		// outline is measured there and averaged down to field texels
+		const int padding = spread * oversampling;
+		const int scale = oversampling;
+		int width = ((int)bitmap.width + 2 * padding + scale - 1) / scale * scale;
+		int height = ((int)bitmap.height + 2 * padding + scale - 1) / scale * scale;
+
+		std::vector<f32> toInside(width * height, farAway), toOutside(width * height, 0.0f);
+		for (uint y = 0; y < bitmap.height; ++y) {
+			for (uint x = 0; x < bitmap.width; ++x) {
+				if (bitmap.coverage[y * bitmap.width + x] >= 128) {
+					int index = (y + padding) * width + x + padding;
+					toInside[index] = 0.0f;
+					toOutside[index] = farAway;
+				}
+			}
+		}
+		distanceTransform(toInside, width, height);
+		distanceTransform(toOutside, width, height);
+
+		int fieldWidth = std::min(width / scale, (int)cellSize);
+		int fieldHeight = std::min(height / scale, (int)cellSize);
+
+		uint page = cell / cellsPerPage;
+		uint cellX = (cell % cellsPerPage) % cellsPerRow * cellSize;
+		uint cellY = (cell % cellsPerPage) / cellsPerRow * cellSize;
+		std::vector<u8> &pixels = m_pages[page];
+		for (uint y = 0; y < cellSize; ++y) {
+			std::fill(pixels.begin() + (cellY + y) * pageSize + cellX, pixels.begin() + (cellY + y) * pageSize + cellX + cellSize, (u8)0);
+		}
+
+		for (int y = 0; y < fieldHeight; ++y) {
+			for (int x = 0; x < fieldWidth; ++x) {
+				f32 sum = 0.0f;
+				for (int sy = 0; sy < scale; ++sy) {
+					for (int sx = 0; sx < scale; ++sx) {
+						int index = (y * scale + sy) * width + x * scale + sx;
+						// Distances are measured between pixel centers, the outline lies half a pixel in between
+						sum += toOutside[index] > 0.0f ? -(sqrtf(toOutside[index]) - 0.5f) : sqrtf(toInside[index]) - 0.5f;
+					}
+				}
+				f32 distance = sum / (scale * scale * scale);
+				f32 value = glm::clamp(0.5f - distance / (2.0f * spread), 0.0f, 1.0f);
+				pixels[(cellY + y) * pageSize + cellX + x] = (u8)(value * 255.0f + 0.5f);
+			}
+		}
+
+		DirtyCell dirty;
+		dirty.page = (u16)page;
+		dirty.x = (u16)cellX;
+		dirty.y = (u16)cellY;
+		m_dirtyCells.push_back(dirty);
+
+		const f32 pixelHeight = (f32)(fieldSize * oversampling);
+		entry.cell = cell;
+		entry.glyph.page = (u16)page;
+		entry.glyph.x = (u16)cellX;
+		entry.glyph.y = (u16)cellY;
+		entry.glyph.width = (u16)fieldWidth;
+		entry.glyph.height = (u16)fieldHeight;
+		entry.glyph.left = (bitmap.bearingX - padding) / pixelHeight;
+		entry.glyph.top = (bitmap.bearingY + padding) / pixelHeight;
+
+		m_cells[cell].key = key;
+		m_cells[cell].lastUsedFrame = m_frame;
+		pushFront(cell);
+		++m_residentCount;
+		return true;
+	}
+
+	u32 GlyphAtlas::allocateCell() {
+		if (m_freeCells.empty() && m_pages.size() < m_maxPages) {
+			m_pages.push_back(std::vector<u8>(pageSize * pageSize, 0));
+
+			u32 first = (u32)m_cells.size();
+			m_cells.resize(m_cells.size() + cellsPerPage);
+			for (u32 i = cellsPerPage; i > 0; --i) {
+				m_freeCells.push_back(first + i - 1);
+			}
+		}
+
+		if (!m_freeCells.empty()) {
+			u32 cell = m_freeCells.back();
+			m_freeCells.pop_back();
+			return cell;
+		}
+
+		u32 cell = m_tail;
+		if (cell == noCell || m_cells[cell].lastUsedFrame == m_frame) {
+			return noCell;
+		}
+
+		std::unordered_map<u64, Entry>::iterator evicted = m_entries.find(m_cells[cell].key);
+		if (evicted != m_entries.end()) {
+			evicted->second.cell = noCell;
+			evicted->second.glyph.page = noPage;
+		}
+		unlink(cell);
+		--m_residentCount;
+		++m_evictions;
+		return cell;
+	}
+
+	void GlyphAtlas::unlink(u32 cell) {
+		Cell &entry = m_cells[cell];
+		if (entry.previous != noCell) {
+			m_cells[entry.previous].next = entry.next;
+		}
+		else {
+			m_head = entry.next;
+		}
+		if (entry.next != noCell) {
+			m_cells[entry.next].previous = entry.previous;
+		}
+		else {
+			m_tail = entry.previous;
+		}
+		entry.previous = entry.next = noCell;
+	}
+
+	void GlyphAtlas::pushFront(u32 cell) {
+		Cell &entry = m_cells[cell];
+		entry.previous = noCell;
+		entry.next = m_head;
+		if (m_head != noCell) {
+			m_cells[m_head].previous = cell;
+		}
+		m_head = cell;
+		if (m_tail == noCell) {
+			m_tail = cell;
+		}
+	}
+}
\ No newline at end of file
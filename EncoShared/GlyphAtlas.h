@@ -0,0 +1,125 @@
+#ifndef __ENCOSHARED_GLYPHATLAS_H__
+#define __ENCOSHARED_GLYPHATLAS_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Font.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	// Lengths are in em, the pixel height the text is drawn at, with y pointing up
+	struct AtlasGlyph {
+		// noPage while the glyph has no texels in the atlas, e.g. a space
+		u16 page;
+		// Texel rectangle of the distance field including the spread around the outline
+		u16 x, y, width, height;
+		// Top left of that rectangle relative to the pen on the baseline
+		f32 left, top;
+		f32 advance;
+	};
+
+	// Signed distance fields of glyphs in 8 bit pages that are filled on demand. Every page is a grid of
+	// equal cells, so a glyph that was not used for the longest time can give its cell to a new one.
+	// Glyphs used in the current frame are never evicted, a new page is added instead as long as there
+	// are less than maxPages.
+	class GlyphAtlas {
+	public:
+		static const uint pageSize = 1024;
+		static const uint cellSize = 64;
+		static const uint cellsPerRow = pageSize / cellSize;
+		static const uint cellsPerPage = cellsPerRow * cellsPerRow;
+		// Pixel height the distance fields are generated for, they scale well to any other size
+		static const uint fieldSize = 48;
+		// Distance in field texels that covers the range from 0 to 255
+		static const uint spread = 6;
+		// Glyphs are rasterized this many times larger and filtered down
+		static const uint oversampling = 4;
+		static const u16 noPage = 0xFFFF;
+
+		struct DirtyCell {
+			u16 page;
+			u16 x, y;
+		};
+
+		ENCOSHAREDAPI GlyphAtlas(uint maxPages = 4);
+		ENCOSHAREDAPI ~GlyphAtlas();
+
+		// Returns the font id used by the other calls
+		ENCOSHAREDAPI uint addFont(std::shared_ptr<IGlyphRasterizer> rasterizer);
+
+		// Metrics in em
+		ENCOSHAREDAPI const FontMetrics &getMetrics(uint font) const;
+		ENCOSHAREDAPI f32 getKerning(uint font, u32 left, u32 right) const;
+
+		// Rasterizes the glyph on first use and marks it as used in this frame. Code points the font does not have
+		// are drawn as '?'. The pointer lives as long as the atlas, an evicted glyph only loses its page until it
+		// is asked for again. nullptr for an unknown font.
+		ENCOSHAREDAPI const AtlasGlyph *getGlyph(uint font, u32 codepoint);
+
+		ENCOSHAREDAPI void beginFrame();
+
+		inline uint getPageCount() const { return (uint)m_pages.size(); }
+		inline const u8 *getPageData(uint page) const { return &m_pages[page][0]; }
+
+		// Cells written since the last clearDirtyCells(), the renderer uploads and clears them
+		inline const std::vector<DirtyCell> &getDirtyCells() const { return m_dirtyCells; }
+		inline void clearDirtyCells() { m_dirtyCells.clear(); }
+
+		inline uint getResidentGlyphCount() const { return m_residentCount; }
+		inline u64 getEvictionCount() const { return m_evictions; }
+		inline u64 getRasterizedGlyphCount() const { return m_rasterized; }
+		// Glyphs that found no cell because every cell was in use this frame
+		inline u64 getOverflowCount() const { return m_overflows; }
+
+	private:
+		static const u32 noCell = 0xFFFFFFFF;
+
+		struct Font {
+			std::shared_ptr<IGlyphRasterizer> rasterizer;
+			FontMetrics metrics;
+		};
+
+		struct Entry {
+			AtlasGlyph glyph;
+			u32 cell;
+			bool hasTexels;
+		};
+
+		// Occupied cells form a list from the most to the least recently used
+		struct Cell {
+			u64 key;
+			u64 lastUsedFrame;
+			u32 previous, next;
+		};
+
+		GlyphAtlas(const GlyphAtlas &) = delete;
+		GlyphAtlas &operator=(const GlyphAtlas &) = delete;
+
+		bool rasterize(uint font, u32 codepoint, GlyphBitmap &bitmap) const;
+		bool place(u64 key, Entry &entry, const GlyphBitmap &bitmap);
+		u32 allocateCell();
+		void unlink(u32 cell);
+		void pushFront(u32 cell);
+
+		uint m_maxPages;
+		std::vector<Font> m_fonts;
+		std::vector<std::vector<u8> > m_pages;
+		std::vector<Cell> m_cells;
+		std::vector<u32> m_freeCells;
+		u32 m_head, m_tail;
+		std::unordered_map<u64, Entry> m_entries;
+		std::vector<DirtyCell> m_dirtyCells;
+
+		u64 m_frame;
+		uint m_residentCount;
+		u64 m_evictions;
+		u64 m_rasterized;
+		u64 m_overflows;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef __ENCOSHARED_IRENDERTARGET_H__
+#define __ENCOSHARED_IRENDERTARGET_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <functional>
+
+namespace enco {
+	enum TextureFormat : uint8 {
+		noFormat,
+		rgba8Format,
+		rgba16fFormat,
+		rgba32fFormat,
+		rg16fFormat,
+		r32fFormat,
+		depth24Format,
+		depth32fFormat,
+		depth24Stencil8Format,
+	};
+
+	struct RenderTargetDescription {
+		static const uint maxColorAttachments = 4;
+
+		uint width, height;
+		TextureFormat colorFormats[maxColorAttachments];
+		TextureFormat depthFormat;
+		// More than one sample renders into multisampled buffers that are resolved into the textures
+		uint samples;
+
+		inline RenderTargetDescription(uint width = 0, uint height = 0, TextureFormat colorFormat = rgba8Format, TextureFormat depthFormat = depth24Format, uint samples = 1) : width(width), height(height), depthFormat(depthFormat), samples(samples) {
+			colorFormats[0] = colorFormat;
+			for (uint i = 1; i < maxColorAttachments; ++i) {
+				colorFormats[i] = noFormat;
+			}
+		}
+
+		inline uint getColorCount() const {
+			uint count = 0;
+			while (count < maxColorAttachments && colorFormats[count] != noFormat) {
+				++count;
+			}
+			return count;
+		}
+	};
+
+	class IRenderTarget {
+	public:
+		IRenderTarget() {  }
+		virtual ~IRenderTarget() {  }
+
+		virtual const RenderTargetDescription &getDescription() const = 0;
+
+		inline uint getWidth() const { return getDescription().width; }
+		inline uint getHeight() const { return getDescription().height; }
+	};
+
+	// Receives tightly packed rows, bottom row first: RGBA8 for color readbacks, one f32 in [0, 1] per pixel for
+	// depth readbacks. The pointer is only valid during the call.
+	typedef std::function<void(const u8 *pixels, uint width, uint height, u64 frame)> ReadbackCallback;
+}
+
+#endif
\ No newline at end of file
@@ -4,10 +4,15 @@
 #pragma once
 
 #include "stdafx.h"
+#include "IRenderTarget.h"
+
+#include <memory>
 
 namespace enco {
 	typedef void *SDL_WINDOW;
 
+	class SpriteBatch;
+
 	enum RenderingBuffer : uint8 {
 		colorBuffer   = 1 << 0,
 		depthBuffer   = 1 << 1,
@@ -19,20 +24,41 @@ namespace enco {
 		IRenderer() {  }
 		virtual ~IRenderer() {  }
 
+		// The first call creates the context, every further window is attached to the same context and resources
 		virtual void createContext(int x, int y, uint width, uint height, uint colorBits, uint depthBits, uint stencilBits, bool fullscreen, SDL_WINDOW sdlWindow = nullptr) = 0;
-		virtual void deleteContext() = 0;
+		// Detaches the window (nullptr for a headless user), the context is deleted together with the last one
+		virtual void deleteContext(SDL_WINDOW sdlWindow = nullptr) = 0;
 
 		virtual int getSDLOptions() = 0;
 
 		virtual void beginFrame() = 0;
 		virtual void endFrame() = 0;
 
+		// Everything between beginView and endView is drawn into the given window, endView presents it
+		virtual void beginView(SDL_WINDOW sdlWindow, uint width, uint height) = 0;
+		virtual void endView(SDL_WINDOW sdlWindow) = 0;
+
+		virtual std::shared_ptr<IRenderTarget> createRenderTarget(const RenderTargetDescription &description) = 0;
+		// nullptr binds the window of the current view again
+		virtual void bindRenderTarget(IRenderTarget *target) = 0;
+
+		// Queues a copy of the first color attachment (or the window with nullptr). The callback runs a few frames later
+		// from endFrame once the copy finished, the GPU is never waited on unless too many readbacks are in flight.
+		virtual void readback(IRenderTarget *target, ReadbackCallback callback) = 0;
+
 		inline void setClearColor(const glm::vec3 &clearColor) { setClearColor(clearColor.r, clearColor.g, clearColor.b); }
 		virtual void setClearColor(f32 r, f32 g, f32 b) = 0;
 
 		virtual void setClearDepth(f64 clearDepth) = 0;
 
 		virtual void clearBuffer(int buffers) = 0;
+
+		// 2D layer: draws the sprites added to batch on top of the bound target, in pixels from its top left
+		virtual void drawSprites(SpriteBatch &batch) = 0;
+
+		// Milliseconds the GPU spent on the latest frame it finished, which lags a few frames behind. 0 where it
+		// cannot be measured.
+		virtual f32 getGpuFrameTime() const = 0;
 	};
 }
 
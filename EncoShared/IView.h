@@ -5,6 +5,7 @@
 
 #include "stdafx.h"
 #include "IRenderer.h"
+#include "Input.h"
 
 #include <memory>
 #include <string>
@@ -32,6 +33,7 @@ namespace enco {
 	protected:
 		glm::u32vec2 m_size;
 		std::string m_name;
+		Input m_input;
 
 		virtual void onResize() {  }
 		virtual void onRename() {  }
@@ -45,11 +47,16 @@ namespace enco {
 
 		virtual bool update(float deltaTime) = 0;
 
+		virtual SDL_WINDOW getSDLWindow() const { return nullptr; }
+		virtual IRenderTarget *getRenderTarget() const { return nullptr; }
+
 		inline void setSize(const glm::u32vec2 &size) { m_size = size; onResize(); }
 		inline void setName(const std::string &name) { m_name = name; onRename(); }
 
 		inline glm::u32vec2 getSize() const { return m_size; }
 		inline std::string getName() const { return m_name; }
+
+		inline Input &getInput() { return m_input; }
 	};
 }
 
@@ -0,0 +1,116 @@
+#include "stdafx.h"
+#include "Input.h"
+
+#include <cstring>
+
+namespace enco {
+	ENCOSHAREDAPI InputState::InputState() : mousePosition(0), mouseDelta(0), mouseWheel(0), mouseButtons(0), mouseButtonsPressed(0), mouseButtonsReleased(0), gamepadConnected(0) {
+		memset(gamepadButtons, 0, sizeof(gamepadButtons));
+		memset(gamepadButtonsPressed, 0, sizeof(gamepadButtonsPressed));
+		memset(gamepadButtonsReleased, 0, sizeof(gamepadButtonsReleased));
+		memset(gamepadAxes, 0, sizeof(gamepadAxes));
+	}
+
+	ENCOSHAREDAPI void InputState::clearEdges() {
+		keysPressed.reset();
+		keysReleased.reset();
+
+		mouseDelta = glm::ivec2(0);
+		mouseWheel = glm::ivec2(0);
+		mouseButtonsPressed = mouseButtonsReleased = 0;
+
+		memset(gamepadButtonsPressed, 0, sizeof(gamepadButtonsPressed));
+		memset(gamepadButtonsReleased, 0, sizeof(gamepadButtonsReleased));
+	}
+
+	ENCOSHAREDAPI void InputState::apply(const InputEvent &event) {
+		switch (event.type) {
+		case InputEventType::keyDownEvent:
+			if (event.code < maxKeys && !keys[event.code]) {
+				keys.set(event.code);
+				keysPressed.set(event.code);
+			}
+			break;
+		case InputEventType::keyUpEvent:
+			if (event.code < maxKeys && keys[event.code]) {
+				keys.reset(event.code);
+				keysReleased.set(event.code);
+			}
+			break;
+		case InputEventType::mouseMotionEvent:
+			mousePosition = glm::ivec2(event.motion.x, event.motion.y);
+			mouseDelta += glm::ivec2(event.motion.dx, event.motion.dy);
+			break;
+		case InputEventType::mouseButtonDownEvent:
+			if (event.code < maxMouseButtons) {
+				mouseButtons |= 1u << event.code;
+				mouseButtonsPressed |= 1u << event.code;
+			}
+			break;
+		case InputEventType::mouseButtonUpEvent:
+			if (event.code < maxMouseButtons) {
+				mouseButtons &= ~(1u << event.code);
+				mouseButtonsReleased |= 1u << event.code;
+			}
+			break;
+		case InputEventType::mouseWheelEvent:
+			mouseWheel += glm::ivec2(event.wheel.x, event.wheel.y);
+			break;
+		case InputEventType::gamepadButtonDownEvent:
+			if (event.device < maxGamepads && event.code < maxGamepadButtons) {
+				gamepadButtons[event.device] |= 1u << event.code;
+				gamepadButtonsPressed[event.device] |= 1u << event.code;
+			}
+			break;
+		case InputEventType::gamepadButtonUpEvent:
+			if (event.device < maxGamepads && event.code < maxGamepadButtons) {
+				gamepadButtons[event.device] &= ~(1u << event.code);
+				gamepadButtonsReleased[event.device] |= 1u << event.code;
+			}
+			break;
+		case InputEventType::gamepadAxisEvent:
+			if (event.device < maxGamepads && event.code < maxGamepadAxes) {
+				gamepadAxes[event.device][event.code] = event.axis;
+			}
+			break;
+		case InputEventType::gamepadConnectedEvent:
+			if (event.device < maxGamepads) {
+				gamepadConnected |= 1u << event.device;
+			}
+			break;
+		case InputEventType::gamepadDisconnectedEvent:
+			if (event.device < maxGamepads) {
+				gamepadConnected &= ~(1u << event.device);
+				gamepadButtonsReleased[event.device] |= gamepadButtons[event.device];
+				gamepadButtons[event.device] = 0;
+				memset(gamepadAxes[event.device], 0, sizeof(gamepadAxes[event.device]));
+			}
+			break;
+		}
+	}
+
+	ENCOSHAREDAPI Input::Input(size_t queueCapacity) : m_queue(queueCapacity), m_queueEnabled(false), m_droppedEvents(0), m_recording(false) {
+	}
+
+	ENCOSHAREDAPI void Input::swap() {
+		m_previous = m_snapshot;
+		m_snapshot = m_live;
+		m_live.clearEdges();
+
+		if (m_recording) {
+			m_frameEvents.swap(m_liveEvents);
+			m_liveEvents.clear();
+		}
+	}
+
+	ENCOSHAREDAPI void Input::push(const InputEvent &event) {
+		m_live.apply(event);
+		if (m_recording) {
+			m_liveEvents.push_back(event);
+		}
+
+		if (m_queueEnabled && !m_queue.tryPush(event)) {
+			++m_droppedEvents;
+		}
+	}
+}
\ No newline at end of file
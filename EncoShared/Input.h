@@ -0,0 +1,136 @@
+#ifndef __ENCOSHARED_INPUT_H__
+#define __ENCOSHARED_INPUT_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "ConcurrentQueue.h"
+
+#include <bitset>
+#include <vector>
+
+namespace enco {
+	enum InputEventType : uint8 {
+		keyDownEvent,
+		keyUpEvent,
+		mouseMotionEvent,
+		mouseButtonDownEvent,
+		mouseButtonUpEvent,
+		mouseWheelEvent,
+		gamepadButtonDownEvent,
+		gamepadButtonUpEvent,
+		gamepadAxisEvent,
+		gamepadConnectedEvent,
+		gamepadDisconnectedEvent,
+	};
+
+	enum MouseButton : uint8 {
+		leftMouseButton   = 0,
+		middleMouseButton = 1,
+		rightMouseButton  = 2,
+		x1MouseButton     = 3,
+		x2MouseButton     = 4,
+	};
+
+	// Key codes are USB HID usage ids, which is what SDL scancodes are as well.
+	struct InputEvent {
+		InputEventType type;
+		uint8 device;
+		uint16 code;
+		uint32 timestamp;
+		union {
+			struct { i32 x, y, dx, dy; } motion;
+			struct { i32 x, y; } wheel;
+			f32 axis;
+		};
+	};
+
+	struct InputState {
+		static const uint maxKeys = 512;
+		static const uint maxGamepads = 4;
+		static const uint maxGamepadAxes = 6;
+		// Buttons are bits of a uint32, higher ids are ignored
+		static const uint maxMouseButtons = 32;
+		static const uint maxGamepadButtons = 32;
+
+		std::bitset<maxKeys> keys;
+		std::bitset<maxKeys> keysPressed;
+		std::bitset<maxKeys> keysReleased;
+
+		glm::ivec2 mousePosition;
+		glm::ivec2 mouseDelta;
+		glm::ivec2 mouseWheel;
+		uint32 mouseButtons;
+		uint32 mouseButtonsPressed;
+		uint32 mouseButtonsReleased;
+
+		uint32 gamepadConnected;
+		uint32 gamepadButtons[maxGamepads];
+		uint32 gamepadButtonsPressed[maxGamepads];
+		uint32 gamepadButtonsReleased[maxGamepads];
+		f32 gamepadAxes[maxGamepads][maxGamepadAxes];
+
+		ENCOSHAREDAPI InputState();
+
+		ENCOSHAREDAPI void clearEdges();
+		ENCOSHAREDAPI void apply(const InputEvent &event);
+	};
+
+	// Accumulates events into a live state and hands out a stable snapshot per frame.
+	// Pressed/released edges are latched per event so a press and release inside one frame is not lost.
+	class Input {
+	public:
+		ENCOSHAREDAPI Input(size_t queueCapacity = 4096);
+
+		// Publishes the state accumulated since the last call as the current snapshot.
+		ENCOSHAREDAPI void swap();
+
+		ENCOSHAREDAPI void push(const InputEvent &event);
+
+		inline bool isKeyDown(uint16 key) const { return key < InputState::maxKeys && m_snapshot.keys[key]; }
+		inline bool wasKeyPressed(uint16 key) const { return key < InputState::maxKeys && m_snapshot.keysPressed[key]; }
+		inline bool wasKeyReleased(uint16 key) const { return key < InputState::maxKeys && m_snapshot.keysReleased[key]; }
+
+		inline bool isMouseButtonDown(MouseButton button) const { return button < InputState::maxMouseButtons && (m_snapshot.mouseButtons & (1u << button)) != 0; }
+		inline bool wasMouseButtonPressed(MouseButton button) const { return button < InputState::maxMouseButtons && (m_snapshot.mouseButtonsPressed & (1u << button)) != 0; }
+		inline bool wasMouseButtonReleased(MouseButton button) const { return button < InputState::maxMouseButtons && (m_snapshot.mouseButtonsReleased & (1u << button)) != 0; }
+
+		inline glm::ivec2 getMousePosition() const { return m_snapshot.mousePosition; }
+		inline glm::ivec2 getMouseDelta() const { return m_snapshot.mouseDelta; }
+		inline glm::ivec2 getMouseWheel() const { return m_snapshot.mouseWheel; }
+
+		inline bool isGamepadConnected(uint pad) const { return pad < InputState::maxGamepads && (m_snapshot.gamepadConnected & (1u << pad)) != 0; }
+		inline bool isGamepadButtonDown(uint pad, uint button) const { return pad < InputState::maxGamepads && button < InputState::maxGamepadButtons && (m_snapshot.gamepadButtons[pad] & (1u << button)) != 0; }
+		inline bool wasGamepadButtonPressed(uint pad, uint button) const { return pad < InputState::maxGamepads && button < InputState::maxGamepadButtons && (m_snapshot.gamepadButtonsPressed[pad] & (1u << button)) != 0; }
+		inline bool wasGamepadButtonReleased(uint pad, uint button) const { return pad < InputState::maxGamepads && button < InputState::maxGamepadButtons && (m_snapshot.gamepadButtonsReleased[pad] & (1u << button)) != 0; }
+		inline f32 getGamepadAxis(uint pad, uint axis) const { return pad < InputState::maxGamepads && axis < InputState::maxGamepadAxes ? m_snapshot.gamepadAxes[pad][axis] : 0.0f; }
+
+		inline const InputState &getState() const { return m_snapshot; }
+		inline const InputState &getPreviousState() const { return m_previous; }
+
+		// Every event is also published here when enabled. Consumers on other threads drain it with tryPop().
+		inline void setEventQueueEnabled(bool enabled) { m_queueEnabled = enabled; }
+		inline ConcurrentQueue<InputEvent> &getEventQueue() { return m_queue; }
+		inline uint64 getDroppedEventCount() const { return m_droppedEvents; }
+
+		// Keeps the events that led to each snapshot, e.g. to record a session
+		inline void setRecording(bool recording) { m_recording = recording; m_liveEvents.clear(); m_frameEvents.clear(); }
+		// Events pushed before the last swap(), empty unless recording
+		inline const std::vector<InputEvent> &getFrameEvents() const { return m_frameEvents; }
+
+	private:
+		InputState m_live;
+		InputState m_snapshot;
+		InputState m_previous;
+
+		ConcurrentQueue<InputEvent> m_queue;
+		bool m_queueEnabled;
+		uint64 m_droppedEvents;
+
+		bool m_recording;
+		std::vector<InputEvent> m_liveEvents;
+		std::vector<InputEvent> m_frameEvents;
+	};
+}
+
+#endif
\ No newline at end of file
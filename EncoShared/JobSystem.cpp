@@ -0,0 +1,123 @@
+#include "stdafx.h"
+#include "JobSystem.h"
+
+#include <chrono>
+
+namespace enco {
+	static ENCO_THREAD_LOCAL uint s_threadIndex = 0;
+
+	ENCOSHAREDAPI JobSystem::JobSystem(uint workerCount) : m_queue(4096), m_running(true), m_sleeping(0) {
+		if (workerCount == 0) {
+			uint hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		for (uint i = 0; i < workerCount; ++i) {
+			m_workers.push_back(std::thread(&JobSystem::workerMain, this, i + 1));
+		}
+	}
+
+	ENCOSHAREDAPI JobSystem::~JobSystem() {
+		m_running.store(false);
+		{
+			std::lock_guard<std::mutex> lock(m_sleepMutex);
+			m_wake.notify_all();
+		}
+		for (size_t i = 0; i < m_workers.size(); ++i) {
+			m_workers[i].join();
+		}
+
+		// Whatever is still queued runs here so no counter is left hanging
+		while (executeOne()) {
+		}
+	}
+
+	ENCOSHAREDAPI void JobSystem::run(const Job &job, JobCounter *counter) {
+		Task task;
+		task.job = job;
+		task.counter = counter;
+		if (counter) {
+			counter->m_value.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (!m_queue.tryPush(task)) {
+			// Queue full, running inline keeps the caller making progress
+			execute(task);
+			return;
+		}
+
+		if (m_sleeping.load(std::memory_order_relaxed) > 0) {
+			m_wake.notify_one();
+		}
+	}
+
+	ENCOSHAREDAPI void JobSystem::parallelFor(uint count, uint batchSize, const RangeJob &job) {
+		if (count == 0) {
+			return;
+		}
+		if (batchSize == 0) {
+			batchSize = 1;
+		}
+
+		JobCounter counter;
+		// The calling thread takes the first batch itself
+		for (uint begin = batchSize; begin < count; begin += batchSize) {
+			uint end = begin + batchSize < count ? begin + batchSize : count;
+			run([&job, begin, end]() { job(begin, end); }, &counter);
+		}
+		job(0, batchSize < count ? batchSize : count);
+		wait(counter);
+	}
+
+	ENCOSHAREDAPI void JobSystem::wait(JobCounter &counter) {
+		while (!counter.isDone()) {
+			if (!executeOne()) {
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	ENCOSHAREDAPI uint JobSystem::getThreadIndex() {
+		return s_threadIndex;
+	}
+
+	bool JobSystem::executeOne() {
+		Task task;
+		if (!m_queue.tryPop(task)) {
+			return false;
+		}
+		execute(task);
+		return true;
+	}
+
+	void JobSystem::execute(Task &task) {
+		task.job();
+		if (task.counter) {
+			task.counter->m_value.fetch_sub(1, std::memory_order_release);
+		}
+	}
+
+	void JobSystem::workerMain(uint index) {
+		s_threadIndex = index;
+
+		uint idleSpins = 0;
+		while (m_running.load(std::memory_order_relaxed)) {
+			if (executeOne()) {
+				idleSpins = 0;
+				continue;
+			}
+
+			if (++idleSpins < 64) {
+				std::this_thread::yield();
+				continue;
+			}
+
+			// A push racing with going to sleep is caught by the timeout
+			std::unique_lock<std::mutex> lock(m_sleepMutex);
+			++m_sleeping;
+			m_wake.wait_for(lock, std::chrono::milliseconds(2));
+			--m_sleeping;
+			idleSpins = 0;
+		}
+	}
+}
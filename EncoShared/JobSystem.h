@@ -0,0 +1,81 @@
+#ifndef __ENCOSHARED_JOBSYSTEM_H__
+#define __ENCOSHARED_JOBSYSTEM_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "ConcurrentQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace enco {
+	// Counts outstanding jobs, JobSystem::wait returns once it reaches zero
+	class JobCounter {
+	public:
+		inline JobCounter() : m_value(0) {  }
+
+		inline bool isDone() const { return m_value.load(std::memory_order_acquire) == 0; }
+
+	private:
+		friend class JobSystem;
+
+		JobCounter(const JobCounter &) = delete;
+		JobCounter &operator=(const JobCounter &) = delete;
+
+		std::atomic<int> m_value;
+	};
+
+	// Fixed pool of worker threads pulling from one lock-free queue. A thread that waits on a counter
+	// runs queued jobs itself instead of blocking, so jobs may spawn and wait for other jobs.
+	class JobSystem {
+	public:
+		typedef std::function<void()> Job;
+		typedef std::function<void(uint begin, uint end)> RangeJob;
+
+		// workerCount == 0 uses one worker less than there are hardware threads
+		ENCOSHAREDAPI JobSystem(uint workerCount = 0);
+		ENCOSHAREDAPI ~JobSystem();
+
+		ENCOSHAREDAPI void run(const Job &job, JobCounter *counter = nullptr);
+
+		// Splits [0, count) into batches of batchSize and returns when all of them ran
+		ENCOSHAREDAPI void parallelFor(uint count, uint batchSize, const RangeJob &job);
+
+		ENCOSHAREDAPI void wait(JobCounter &counter);
+
+		inline uint getWorkerCount() const { return (uint)m_workers.size(); }
+
+		// 0 on threads not owned by a job system, 1..getWorkerCount() on the workers
+		ENCOSHAREDAPI static uint getThreadIndex();
+
+	private:
+		struct Task {
+			Job job;
+			JobCounter *counter;
+
+			inline Task() : counter(nullptr) {  }
+		};
+
+		JobSystem(const JobSystem &) = delete;
+		JobSystem &operator=(const JobSystem &) = delete;
+
+		bool executeOne();
+		void execute(Task &task);
+		void workerMain(uint index);
+
+		ConcurrentQueue<Task> m_queue;
+		std::vector<std::thread> m_workers;
+		std::atomic<bool> m_running;
+
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		std::atomic<int> m_sleeping;
+	};
+}
+
+#endif
@@ -0,0 +1,234 @@
+#include "stdafx.h"
+#include "LightClusterGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace enco {
+	ENCOSHAREDAPI LightClusterGrid::LightClusterGrid(uint tilesX, uint tilesY, uint slices) : m_tilesX(tilesX), m_tilesY(tilesY), m_slices(slices), m_sliceScale(0.0f), m_sliceBias(0.0f), m_projection(0.0f), m_nearPlane(0.0f), m_farPlane(0.0f) {
+		m_clusters.resize(getClusterCount());
+		m_clusterBounds.resize(getClusterCount());
+		m_sliceData.resize(slices);
+		for (uint z = 0; z < slices; ++z) {
+			m_sliceData[z].columns.resize(tilesX);
+			m_sliceData[z].rows.resize(tilesY);
+		}
+	}
+
+	ENCOSHAREDAPI LightClusterGrid::~LightClusterGrid() {
+	}
+
+	ENCOSHAREDAPI void LightClusterGrid::update(const glm::mat4 &view, const glm::mat4 &projection, f32 nearPlane, f32 farPlane, const std::vector<Light> &lights, JobSystem &jobSystem) {
+		if (projection != m_projection || nearPlane != m_nearPlane || farPlane != m_farPlane) {
+			buildClusterBounds(projection, nearPlane, farPlane);
+		}
+
+		// Cull and move the lights into view space
+		Frustum frustum(projection);
+		std::vector<u8> visible(lights.size());
+		std::vector<LightShaderData> transformed(lights.size());
+		std::vector<VisibleLight> binning(lights.size());
+		jobSystem.parallelFor((uint)lights.size(), 256, [&](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				const Light &light = lights[i];
+				glm::vec3 position = glm::vec3(view * glm::vec4(light.position, 1.0f));
+
+				BoundingSphere bounds(position, light.range);
+				visible[i] = frustum.intersects(bounds) ? 1 : 0;
+				if (!visible[i]) {
+					continue;
+				}
+
+				glm::vec3 direction = glm::normalize(glm::vec3(view * glm::vec4(light.direction, 0.0f)));
+				transformed[i].positionRange = glm::vec4(position, light.range);
+				transformed[i].colorIntensity = glm::vec4(light.color, light.intensity);
+				transformed[i].directionOuterCone = glm::vec4(direction, light.outerCone);
+				transformed[i].innerConeType = glm::vec4(light.innerCone, (f32)light.type, 0.0f, 0.0f);
+
+				f32 nearDepth = std::max(-position.z - light.range, m_nearPlane);
+				f32 farDepth = std::max(-position.z + light.range, m_nearPlane);
+				f32 firstSlice = std::floor(std::log(nearDepth) * m_sliceScale + m_sliceBias);
+				f32 lastSlice = std::floor(std::log(farDepth) * m_sliceScale + m_sliceBias);
+
+				binning[i].bounds = bounds;
+				binning[i].firstSlice = (uint)glm::clamp(firstSlice, 0.0f, (f32)(m_slices - 1));
+				binning[i].lastSlice = (uint)glm::clamp(lastSlice, 0.0f, (f32)(m_slices - 1));
+			}
+		});
+
+		m_visibleLights.clear();
+		m_binning.clear();
+		for (size_t i = 0; i < lights.size(); ++i) {
+			if (visible[i]) {
+				m_visibleLights.push_back(transformed[i]);
+				m_binning.push_back(binning[i]);
+			}
+		}
+
+		// Every slice owns its clusters, so the jobs never touch the same memory
+		jobSystem.parallelFor(m_slices, 1, [this](uint begin, uint end) {
+			for (uint z = begin; z < end; ++z) {
+				binSlice(z);
+			}
+		});
+
+		// Compact the per-slice lists into one index list
+		std::vector<u32> sliceOffsets(m_slices);
+		u32 totalIndices = 0;
+		for (uint z = 0; z < m_slices; ++z) {
+			sliceOffsets[z] = totalIndices;
+			totalIndices += (u32)m_sliceData[z].indices.size();
+		}
+
+		m_lightIndices.resize(totalIndices);
+		jobSystem.parallelFor(m_slices, 1, [this, &sliceOffsets](uint begin, uint end) {
+			for (uint z = begin; z < end; ++z) {
+				const std::vector<u32> &indices = m_sliceData[z].indices;
+				if (!indices.empty()) {
+					std::copy(indices.begin(), indices.end(), m_lightIndices.begin() + sliceOffsets[z]);
+				}
+
+				uint first = getClusterIndex(0, 0, z);
+				for (uint i = 0; i < m_tilesX * m_tilesY; ++i) {
+					m_clusters[first + i].offset += sliceOffsets[z];
+				}
+			}
+		});
+	}
+
+	void LightClusterGrid::buildClusterBounds(const glm::mat4 &projection, f32 nearPlane, f32 farPlane) {
+		m_projection = projection;
+		m_nearPlane = nearPlane;
+		m_farPlane = farPlane;
+
+		f32 logRatio = std::log(farPlane / nearPlane);
+		m_sliceScale = (f32)m_slices / logRatio;
+		m_sliceBias = -(f32)m_slices * std::log(nearPlane) / logRatio;
+
+		// Rays through the tile corners, scaled to unit depth
+		glm::mat4 inverse = glm::inverse(projection);
+		std::vector<glm::vec3> corners((m_tilesX + 1) * (m_tilesY + 1));
+		for (uint y = 0; y <= m_tilesY; ++y) {
+			for (uint x = 0; x <= m_tilesX; ++x) {
+				glm::vec4 ndc(-1.0f + 2.0f * x / m_tilesX, -1.0f + 2.0f * y / m_tilesY, -1.0f, 1.0f);
+				glm::vec4 point = inverse * ndc;
+				glm::vec3 corner = glm::vec3(point) / point.w;
+				corners[y * (m_tilesX + 1) + x] = corner / -corner.z;
+			}
+		}
+
+		for (uint z = 0; z < m_slices; ++z) {
+			f32 sliceNear = nearPlane * std::pow(farPlane / nearPlane, (f32)z / m_slices);
+			f32 sliceFar = nearPlane * std::pow(farPlane / nearPlane, (f32)(z + 1) / m_slices);
+
+			Slice &slice = m_sliceData[z];
+			std::fill(slice.columns.begin(), slice.columns.end(), glm::vec2(1e30f, -1e30f));
+			std::fill(slice.rows.begin(), slice.rows.end(), glm::vec2(1e30f, -1e30f));
+
+			for (uint y = 0; y < m_tilesY; ++y) {
+				for (uint x = 0; x < m_tilesX; ++x) {
+					glm::vec3 first = corners[y * (m_tilesX + 1) + x];
+					AABB bounds(first * sliceNear, first * sliceNear);
+					for (uint corner = 0; corner < 4; ++corner) {
+						glm::vec3 ray = corners[(y + (corner >> 1)) * (m_tilesX + 1) + x + (corner & 1)];
+						bounds.merge(ray * sliceNear);
+						bounds.merge(ray * sliceFar);
+					}
+					m_clusterBounds[getClusterIndex(x, y, z)] = bounds;
+
+					slice.columns[x] = glm::vec2(std::min(slice.columns[x].x, bounds.min.x), std::max(slice.columns[x].y, bounds.max.x));
+					slice.rows[y] = glm::vec2(std::min(slice.rows[y].x, bounds.min.y), std::max(slice.rows[y].y, bounds.max.y));
+				}
+			}
+		}
+	}
+
+	void LightClusterGrid::binSlice(uint z) {
+		Slice &slice = m_sliceData[z];
+		slice.indices.clear();
+
+		// Narrow every light touching this slice down to a rectangle of tiles first
+		struct Candidate {
+			u32 light;
+			uint x0, x1, y0, y1;
+		};
+		std::vector<Candidate> candidates;
+		for (u32 i = 0; i < (u32)m_binning.size(); ++i) {
+			const VisibleLight &light = m_binning[i];
+			if (z < light.firstSlice || z > light.lastSlice) {
+				continue;
+			}
+
+			const glm::vec3 &center = light.bounds.center;
+			f32 radius = light.bounds.radius;
+
+			Candidate candidate;
+			candidate.light = i;
+			candidate.x0 = m_tilesX;
+			candidate.x1 = 0;
+			for (uint x = 0; x < m_tilesX; ++x) {
+				if (center.x + radius >= slice.columns[x].x && center.x - radius <= slice.columns[x].y) {
+					candidate.x0 = std::min(candidate.x0, x);
+					candidate.x1 = x;
+				}
+			}
+			candidate.y0 = m_tilesY;
+			candidate.y1 = 0;
+			for (uint y = 0; y < m_tilesY; ++y) {
+				if (center.y + radius >= slice.rows[y].x && center.y - radius <= slice.rows[y].y) {
+					candidate.y0 = std::min(candidate.y0, y);
+					candidate.y1 = y;
+				}
+			}
+
+			if (candidate.x0 <= candidate.x1 && candidate.y0 <= candidate.y1) {
+				candidates.push_back(candidate);
+			}
+		}
+
+		for (uint y = 0; y < m_tilesY; ++y) {
+			for (uint x = 0; x < m_tilesX; ++x) {
+				uint index = getClusterIndex(x, y, z);
+				LightCluster &cluster = m_clusters[index];
+				cluster.offset = (u32)slice.indices.size();
+
+				for (size_t i = 0; i < candidates.size(); ++i) {
+					const Candidate &candidate = candidates[i];
+					if (x >= candidate.x0 && x <= candidate.x1 && y >= candidate.y0 && y <= candidate.y1 && intersects(candidate.light, m_clusterBounds[index])) {
+						slice.indices.push_back(candidate.light);
+					}
+				}
+
+				cluster.count = (u32)slice.indices.size() - cluster.offset;
+			}
+		}
+	}
+
+	bool LightClusterGrid::intersects(uint light, const AABB &cluster) const {
+		const BoundingSphere &bounds = m_binning[light].bounds;
+		glm::vec3 closest = glm::clamp(bounds.center, cluster.min, cluster.max);
+		glm::vec3 delta = closest - bounds.center;
+		if (glm::dot(delta, delta) > bounds.radius * bounds.radius) {
+			return false;
+		}
+
+		const LightShaderData &data = m_visibleLights[light];
+		if ((LightType)(int)data.innerConeType.y != LightType::spotLight) {
+			return true;
+		}
+
+		// Cone against the bounding sphere of the cluster
+		glm::vec3 direction(data.directionOuterCone);
+		f32 cosAngle = data.directionOuterCone.w;
+		f32 sinAngle = std::sqrt(std::max(0.0f, 1.0f - cosAngle * cosAngle));
+
+		glm::vec3 center = cluster.getCenter();
+		f32 radius = glm::length(cluster.getExtents());
+		glm::vec3 toCenter = center - bounds.center;
+		f32 distanceSquared = glm::dot(toCenter, toCenter);
+		f32 alongAxis = glm::dot(toCenter, direction);
+		f32 closestDistance = cosAngle * std::sqrt(std::max(0.0f, distanceSquared - alongAxis * alongAxis)) - alongAxis * sinAngle;
+
+		return !(closestDistance > radius || alongAxis > radius + bounds.radius || alongAxis < -radius);
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef __ENCOSHARED_LIGHTCLUSTERGRID_H__
+#define __ENCOSHARED_LIGHTCLUSTERGRID_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+namespace enco {
+	enum LightType : u8 {
+		pointLight = 0,
+		spotLight
+	};
+
+	struct Light {
+		LightType type;
+		glm::vec3 position;
+		glm::vec3 direction;
+		glm::vec3 color;
+		f32 intensity;
+		f32 range;
+		// Cosines of the half angles, only used by spot lights
+		f32 innerCone, outerCone;
+
+		inline Light() : type(LightType::pointLight), position(0.0f), direction(0.0f, 0.0f, -1.0f), color(1.0f), intensity(1.0f), range(1.0f), innerCone(1.0f), outerCone(0.0f) {  }
+	};
+
+	// std430 layout of a light as the shader reads it, position and direction are in view space
+	struct LightShaderData {
+		glm::vec4 positionRange;
+		glm::vec4 colorIntensity;
+		glm::vec4 directionOuterCone;
+		glm::vec4 innerConeType;
+	};
+
+	struct LightCluster {
+		u32 offset;
+		u32 count;
+	};
+
+	// Splits the view frustum into tilesX * tilesY screen tiles and exponentially spaced depth slices.
+	// update() culls the lights against the frustum and bins them on the job system, one job per slice,
+	// into compact per-cluster ranges of one shared index list that can be uploaded as is.
+	class LightClusterGrid {
+	public:
+		ENCOSHAREDAPI LightClusterGrid(uint tilesX = 16, uint tilesY = 9, uint slices = 24);
+		ENCOSHAREDAPI ~LightClusterGrid();
+
+		// projection must be a perspective projection, nearPlane and farPlane are the distances it was built with
+		ENCOSHAREDAPI void update(const glm::mat4 &view, const glm::mat4 &projection, f32 nearPlane, f32 farPlane, const std::vector<Light> &lights, JobSystem &jobSystem);
+
+		inline uint getTilesX() const { return m_tilesX; }
+		inline uint getTilesY() const { return m_tilesY; }
+		inline uint getSlices() const { return m_slices; }
+		inline uint getClusterCount() const { return m_tilesX * m_tilesY * m_slices; }
+
+		// slice = floor(log(viewDepth) * scale + bias)
+		inline f32 getSliceScale() const { return m_sliceScale; }
+		inline f32 getSliceBias() const { return m_sliceBias; }
+
+		inline const std::vector<LightShaderData> &getLights() const { return m_visibleLights; }
+		inline const std::vector<LightCluster> &getClusters() const { return m_clusters; }
+		inline const std::vector<u32> &getLightIndices() const { return m_lightIndices; }
+
+		// Cluster index of tile (x, y) in slice z as the shader computes it
+		inline uint getClusterIndex(uint x, uint y, uint z) const { return (z * m_tilesY + y) * m_tilesX + x; }
+
+	private:
+		struct Slice {
+			std::vector<u32> indices;
+			// Conservative view space ranges of every tile column and row in this slice
+			std::vector<glm::vec2> columns;
+			std::vector<glm::vec2> rows;
+		};
+
+		struct VisibleLight {
+			BoundingSphere bounds;
+			uint firstSlice, lastSlice;
+		};
+
+		void buildClusterBounds(const glm::mat4 &projection, f32 nearPlane, f32 farPlane);
+		void binSlice(uint z);
+		bool intersects(uint light, const AABB &cluster) const;
+
+		uint m_tilesX, m_tilesY, m_slices;
+		f32 m_sliceScale, m_sliceBias;
+
+		glm::mat4 m_projection;
+		f32 m_nearPlane, m_farPlane;
+		std::vector<AABB> m_clusterBounds;
+		std::vector<Slice> m_sliceData;
+
+		std::vector<VisibleLight> m_binning;
+		std::vector<LightShaderData> m_visibleLights;
+		std::vector<LightCluster> m_clusters;
+		std::vector<u32> m_lightIndices;
+	};
+}
+
+#endif
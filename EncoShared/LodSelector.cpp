@@ -0,0 +1,64 @@
+#include "stdafx.h"
+#include "LodSelector.h"
+
+#include <algorithm>
+
+namespace enco {
+	ENCOSHAREDAPI LodSelector::LodSelector() : m_cameraPosition(0.0f), m_projectionScale(1.0f), m_pixelError(1.0f), m_hysteresis(0.25f), m_crossFadeTime(0.0f), m_lodBias(0) {
+	}
+
+	ENCOSHAREDAPI void LodSelector::setCamera(const glm::vec3 &position, const glm::mat4 &projection, uint viewportHeight) {
+		m_cameraPosition = position;
+		// projection[1][1] = 1 / tan(fovY / 2), so this converts size / distance into pixels
+		m_projectionScale = projection[1][1] * viewportHeight * 0.5f;
+	}
+
+	ENCOSHAREDAPI void LodSelector::update(std::vector<LodInstance> &instances, f32 deltaTime, JobSystem &jobSystem) {
+		jobSystem.parallelFor((uint)instances.size(), 512, [this, &instances, deltaTime](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				select(instances[i], deltaTime);
+			}
+		});
+	}
+
+	ENCOSHAREDAPI f32 LodSelector::getScreenError(const BoundingSphere &bounds, f32 worldError) const {
+		f32 distance = glm::length(bounds.center - m_cameraPosition) - bounds.radius;
+		if (distance <= 0.0f) {
+			return 1e30f;
+		}
+		return worldError * m_projectionScale / distance;
+	}
+
+	void LodSelector::select(LodInstance &instance, f32 deltaTime) const {
+		if (instance.fade < 1.0f) {
+			instance.fade = m_crossFadeTime > 0.0f ? std::min(1.0f, instance.fade + deltaTime / m_crossFadeTime) : 1.0f;
+		}
+
+		if (!instance.mesh) {
+			return;
+		}
+
+		uint lodCount = instance.mesh->getLodCount();
+		uint current = std::min((uint)instance.lod, lodCount - 1);
+
+		uint selected = 0;
+		for (uint lod = lodCount; lod > 0; --lod) {
+			f32 screenError = getScreenError(instance.bounds, instance.mesh->getLod(lod - 1).error * instance.scale);
+
+			// Levels coarser than the current one have to beat the lowered threshold
+			f32 threshold = lod - 1 > current ? m_pixelError * (1.0f - m_hysteresis) : m_pixelError;
+			if (screenError <= threshold) {
+				selected = lod - 1;
+				break;
+			}
+		}
+		selected = std::min(selected + m_lodBias, lodCount - 1);
+
+		// A new switch waits for the running fade, otherwise three levels would be visible
+		if (selected != current && instance.fade >= 1.0f) {
+			instance.previousLod = (u8)current;
+			instance.lod = (u8)selected;
+			instance.fade = m_crossFadeTime > 0.0f ? 0.0f : 1.0f;
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef __ENCOSHARED_LODSELECTOR_H__
+#define __ENCOSHARED_LODSELECTOR_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "MeshData.h"
+
+#include <vector>
+
+namespace enco {
+	struct LodInstance {
+		const MeshData *mesh;
+		// World space bounds, scale is the largest scale factor of the world transform
+		BoundingSphere bounds;
+		f32 scale;
+
+		// Written by LodSelector::update. While fade < 1 both lod and previousLod are drawn, lod dithered
+		// with fade and previousLod with the complementary pattern.
+		u8 lod;
+		u8 previousLod;
+		f32 fade;
+
+		inline LodInstance() : mesh(nullptr), scale(1.0f), lod(0), previousLod(0), fade(1.0f) {  }
+	};
+
+	// Picks the coarsest level whose error, projected to the screen, stays below a pixel threshold.
+	// A coarser level is only taken once it is hysteresis below the threshold again, so objects near a
+	// switching distance do not flip between two levels every frame.
+	class LodSelector {
+	public:
+		ENCOSHAREDAPI LodSelector();
+
+		inline void setPixelError(f32 pixels) { m_pixelError = pixels; }
+		// Fraction of the pixel error, e.g. 0.25 switches down at 75% of the threshold
+		inline void setHysteresis(f32 fraction) { m_hysteresis = fraction; }
+		// 0 switches instantly
+		inline void setCrossFadeTime(f32 seconds) { m_crossFadeTime = seconds; }
+		// Every level is dropped by this many steps, e.g. for low quality settings
+		inline void setLodBias(uint bias) { m_lodBias = bias; }
+
+		// projection must be a perspective projection, viewportHeight is in pixels
+		ENCOSHAREDAPI void setCamera(const glm::vec3 &position, const glm::mat4 &projection, uint viewportHeight);
+
+		ENCOSHAREDAPI void update(std::vector<LodInstance> &instances, f32 deltaTime, JobSystem &jobSystem);
+
+		// Size in pixels of an error of worldError units at the distance of bounds
+		ENCOSHAREDAPI f32 getScreenError(const BoundingSphere &bounds, f32 worldError) const;
+
+	private:
+		void select(LodInstance &instance, f32 deltaTime) const;
+
+		glm::vec3 m_cameraPosition;
+		f32 m_projectionScale;
+
+		f32 m_pixelError;
+		f32 m_hysteresis;
+		f32 m_crossFadeTime;
+		uint m_lodBias;
+	};
+}
+
+#endif
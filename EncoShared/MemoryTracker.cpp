@@ -0,0 +1,273 @@
+#include "stdafx.h"
+#include "MemoryTracker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#ifdef _WIN32
+#	include <dbghelp.h>
+#	pragma comment (lib, "dbghelp.lib")
+#else
+#	include <execinfo.h>
+#	include <cstdlib>
+#endif
+
+namespace enco {
+	namespace {
+		const char *tagNames[memoryTagCount] = { "general", "renderer", "assets", "audio", "ecs", "gpu buffers", "gpu textures" };
+
+		struct TagCounters {
+			std::atomic<i64> current;
+			std::atomic<i64> peak;
+			std::atomic<i64> budget;
+			std::atomic<u64> allocations;
+			std::atomic<i64> liveAllocations;
+			std::atomic<u64> overBudgetCount;
+			std::atomic<bool> captureStacks;
+		};
+
+		struct StackRecord {
+			MemoryTag tag;
+			size_t size;
+			u64 sequence;
+			uint frameCount;
+			void *frames[MemoryTracker::maxStackFrames];
+		};
+
+		// Allocations with the same call stack
+		struct StackGroup {
+			MemoryTag tag;
+			u64 count;
+			u64 bytes;
+			const StackRecord *record;
+		};
+
+		// Static storage is zeroed before any constructor runs, so allocations of other static objects count too
+		TagCounters counters[memoryTagCount];
+
+		// The records themselves come from the untracked heap
+		std::mutex stackMutex;
+		std::unordered_map<void *, StackRecord> stackRecords;
+		std::atomic<u64> stackSequence;
+		std::atomic<u64> stackRecordCount;
+
+		inline f64 toMiB(i64 bytes) {
+			return (f64)bytes / (1024.0 * 1024.0);
+		}
+
+		void count(MemoryTag tag, i64 size) {
+			TagCounters &tagCounters = counters[tag];
+			i64 current = tagCounters.current.fetch_add(size, std::memory_order_relaxed) + size;
+			if (size <= 0) {
+				return;
+			}
+
+			i64 peak = tagCounters.peak.load(std::memory_order_relaxed);
+			while (current > peak && !tagCounters.peak.compare_exchange_weak(peak, current, std::memory_order_relaxed)) {
+			}
+
+			i64 budget = tagCounters.budget.load(std::memory_order_relaxed);
+			if (budget > 0 && current > budget && current - size <= budget) {
+				tagCounters.overBudgetCount.fetch_add(1, std::memory_order_relaxed);
+#ifdef _DEBUG
+				printf("MemoryTracker Error: %s uses %.2f MiB, above its budget of %.2f MiB\n", tagNames[tag], toMiB(current), toMiB(budget));
+#endif
+			}
+		}
+
+		uint captureStack(void **frames) {
+			// Skips captureStack and addStack, allocate and the container's own frames are kept since inlining varies
+			const uint skip = 2;
+#ifdef _WIN32
+			return (uint)CaptureStackBackTrace(skip, MemoryTracker::maxStackFrames, frames, nullptr);
+#else
+			void *all[MemoryTracker::maxStackFrames + skip];
+			int count = backtrace(all, MemoryTracker::maxStackFrames + skip);
+			uint kept = count > (int)skip ? (uint)count - skip : 0;
+			memcpy(frames, all + skip, kept * sizeof(void *));
+			return kept;
+#endif
+		}
+
+		void printStack(const StackRecord &record) {
+#ifdef _WIN32
+			static bool symbolsLoaded = false;
+			HANDLE process = GetCurrentProcess();
+			if (!symbolsLoaded) {
+				SymSetOptions(SYMOPT_DEFERRED_LOADS | SYMOPT_LOAD_LINES | SYMOPT_UNDNAME);
+				symbolsLoaded = SymInitialize(process, nullptr, TRUE) != FALSE;
+			}
+
+			u8 buffer[sizeof(SYMBOL_INFO) + 256];
+			SYMBOL_INFO *symbol = (SYMBOL_INFO *)buffer;
+			for (uint i = 0; i < record.frameCount; ++i) {
+				DWORD64 address = (DWORD64)record.frames[i];
+				memset(buffer, 0, sizeof(buffer));
+				symbol->SizeOfStruct = sizeof(SYMBOL_INFO);
+				symbol->MaxNameLen = 255;
+				IMAGEHLP_LINE64 line;
+				memset(&line, 0, sizeof(line));
+				line.SizeOfStruct = sizeof(line);
+				DWORD displacement = 0;
+				if (symbolsLoaded && SymFromAddr(process, address, nullptr, symbol)) {
+					if (SymGetLineFromAddr64(process, address, &displacement, &line)) {
+						printf("        %s (%s:%u)\n", symbol->Name, line.FileName, (uint)line.LineNumber);
+					}
+					else {
+						printf("        %s\n", symbol->Name);
+					}
+				}
+				else {
+					printf("        0x%llx\n", (u64)address);
+				}
+			}
+#else
+			char **symbols = backtrace_symbols(record.frames, (int)record.frameCount);
+			for (uint i = 0; i < record.frameCount; ++i) {
+				if (symbols) {
+					printf("        %s\n", symbols[i]);
+				}
+				else {
+					printf("        %p\n", record.frames[i]);
+				}
+			}
+			free(symbols);
+#endif
+		}
+	}
+
+	ENCOSHAREDAPI void *MemoryTracker::allocate(MemoryTag tag, size_t size) {
+		void *pointer = ::operator new(size);
+		TagCounters &tagCounters = counters[tag];
+		tagCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+		tagCounters.liveAllocations.fetch_add(1, std::memory_order_relaxed);
+		count(tag, (i64)size);
+		if (tagCounters.captureStacks.load(std::memory_order_relaxed)) {
+			addStack(tag, pointer, size);
+		}
+		return pointer;
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::deallocate(MemoryTag tag, void *pointer, size_t size) {
+		if (!pointer) {
+			return;
+		}
+
+		counters[tag].liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+		count(tag, -(i64)size);
+		// Records stay behind when capturing is turned off, their allocations are still freed later
+		if (stackRecordCount.load(std::memory_order_relaxed) > 0) {
+			removeStack(pointer);
+		}
+		::operator delete(pointer);
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::add(MemoryTag tag, i64 size) {
+		count(tag, size);
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::setBudget(MemoryTag tag, i64 budget) {
+		counters[tag].budget = budget;
+	}
+
+	ENCOSHAREDAPI MemoryStats MemoryTracker::getStats(MemoryTag tag) {
+		const TagCounters &tagCounters = counters[tag];
+		MemoryStats stats;
+		stats.current = tagCounters.current.load(std::memory_order_relaxed);
+		stats.peak = tagCounters.peak.load(std::memory_order_relaxed);
+		stats.budget = tagCounters.budget.load(std::memory_order_relaxed);
+		stats.allocations = tagCounters.allocations.load(std::memory_order_relaxed);
+		stats.liveAllocations = tagCounters.liveAllocations.load(std::memory_order_relaxed);
+		stats.overBudgetCount = tagCounters.overBudgetCount.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::resetPeaks() {
+		for (uint i = 0; i < memoryTagCount; ++i) {
+			counters[i].peak = counters[i].current.load(std::memory_order_relaxed);
+		}
+	}
+
+	ENCOSHAREDAPI const char *MemoryTracker::getTagName(MemoryTag tag) {
+		return tag < memoryTagCount ? tagNames[tag] : "unknown";
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::printReport() {
+		printf("%-14s %12s %12s %12s %14s %10s\n", "memory", "current MiB", "peak MiB", "budget MiB", "allocations", "live");
+		for (uint i = 0; i < memoryTagCount; ++i) {
+			MemoryStats stats = getStats((MemoryTag)i);
+			printf("%-14s %12.2f %12.2f ", tagNames[i], toMiB(stats.current), toMiB(stats.peak));
+			if (stats.budget > 0) {
+				printf("%12.2f", toMiB(stats.budget));
+			}
+			else {
+				printf("%12s", "-");
+			}
+			printf(" %14llu %10lld%s\n", stats.allocations, stats.liveAllocations, stats.overBudgetCount > 0 ? "  over budget" : "");
+		}
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::setCallStackCapture(MemoryTag tag, bool enable) {
+		counters[tag].captureStacks = enable;
+	}
+
+	ENCOSHAREDAPI u64 MemoryTracker::getSequence() {
+		return stackSequence.load();
+	}
+
+	ENCOSHAREDAPI void MemoryTracker::printLeaks(u64 sequence, uint maxStacks) {
+		std::lock_guard<std::mutex> lock(stackMutex);
+
+		// Grouped by tag and frames, so a leak shows up once with its total no matter how often it happened
+		std::map<std::vector<void *>, StackGroup> groups;
+		for (std::unordered_map<void *, StackRecord>::const_iterator record = stackRecords.begin(); record != stackRecords.end(); ++record) {
+			if (record->second.sequence <= sequence) {
+				continue;
+			}
+			std::vector<void *> key(record->second.frames, record->second.frames + record->second.frameCount);
+			key.push_back((void *)(size_t)record->second.tag);
+			std::map<std::vector<void *>, StackGroup>::iterator group = groups.find(key);
+			if (group == groups.end()) {
+				StackGroup added = { record->second.tag, 0, 0, &record->second };
+				group = groups.insert(std::make_pair(key, added)).first;
+			}
+			++group->second.count;
+			group->second.bytes += record->second.size;
+		}
+
+		std::vector<StackGroup> sorted;
+		for (std::map<std::vector<void *>, StackGroup>::const_iterator group = groups.begin(); group != groups.end(); ++group) {
+			sorted.push_back(group->second);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const StackGroup &a, const StackGroup &b) { return a.bytes > b.bytes; });
+
+		printf("%u call stack(s) with live allocations after %llu\n", (uint)sorted.size(), sequence);
+		for (size_t i = 0; i < sorted.size() && i < maxStacks; ++i) {
+			printf("    %s: %llu allocation(s), %.3f MiB\n", tagNames[sorted[i].tag], sorted[i].count, toMiB((i64)sorted[i].bytes));
+			printStack(*sorted[i].record);
+		}
+	}
+
+	void MemoryTracker::addStack(MemoryTag tag, void *pointer, size_t size) {
+		StackRecord record;
+		record.tag = tag;
+		record.size = size;
+		record.frameCount = captureStack(record.frames);
+
+		std::lock_guard<std::mutex> lock(stackMutex);
+		record.sequence = ++stackSequence;
+		stackRecords[pointer] = record;
+		stackRecordCount = stackRecords.size();
+	}
+
+	void MemoryTracker::removeStack(void *pointer) {
+		std::lock_guard<std::mutex> lock(stackMutex);
+		stackRecords.erase(pointer);
+		stackRecordCount = stackRecords.size();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#ifndef __ENCOSHARED_MEMORYTRACKER_H__
+#define __ENCOSHARED_MEMORYTRACKER_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace enco {
+	enum MemoryTag : u8 {
+		generalMemory,
+		rendererMemory,
+		assetMemory,
+		audioMemory,
+		ecsMemory,
+		// Not on the heap: the buffers, textures and renderbuffers EncoOpenGL creates, by the size given to GL
+		gpuBufferMemory,
+		gpuTextureMemory,
+		memoryTagCount
+	};
+
+	struct MemoryStats {
+		// Bytes
+		i64 current;
+		i64 peak;
+		// 0 is no budget
+		i64 budget;
+		u64 allocations;
+		i64 liveAllocations;
+		// How often current went above the budget
+		u64 overBudgetCount;
+	};
+
+	// Per-tag counters of every allocation made through TaggedAllocator. Counting is a few relaxed atomics, so
+	// it is always on. Call stacks are only captured for the tags they were enabled for, to find what keeps
+	// allocating without freeing: mark a point with getSequence() and later print the stacks of everything
+	// allocated after it that is still alive.
+	class MemoryTracker {
+	public:
+		static const uint maxStackFrames = 16;
+
+		ENCOSHAREDAPI static void *allocate(MemoryTag tag, size_t size);
+		ENCOSHAREDAPI static void deallocate(MemoryTag tag, void *pointer, size_t size);
+		// For memory the tracker does not allocate itself, e.g. GPU objects. size is negative when it is freed,
+		// only current and peak change.
+		ENCOSHAREDAPI static void add(MemoryTag tag, i64 size);
+
+		ENCOSHAREDAPI static void setBudget(MemoryTag tag, i64 budget);
+		ENCOSHAREDAPI static MemoryStats getStats(MemoryTag tag);
+		ENCOSHAREDAPI static void resetPeaks();
+		ENCOSHAREDAPI static const char *getTagName(MemoryTag tag);
+		// current, peak and budget of every tag
+		ENCOSHAREDAPI static void printReport();
+
+		ENCOSHAREDAPI static void setCallStackCapture(MemoryTag tag, bool enable);
+		// Number of allocations with a call stack so far
+		ENCOSHAREDAPI static u64 getSequence();
+		// The call stacks of the allocations after sequence that are still alive, most bytes first
+		ENCOSHAREDAPI static void printLeaks(u64 sequence = 0, uint maxStacks = 20);
+
+	private:
+		MemoryTracker() = delete;
+
+		static void addStack(MemoryTag tag, void *pointer, size_t size);
+		static void removeStack(void *pointer);
+	};
+
+	// Standard allocator that counts its memory under Tag, e.g. std::vector<f32, TaggedAllocator<f32, audioMemory>>
+	template<typename T, MemoryTag Tag>
+	class TaggedAllocator {
+	public:
+		typedef T value_type;
+		typedef T *pointer;
+		typedef const T *const_pointer;
+		typedef T &reference;
+		typedef const T &const_reference;
+		typedef size_t size_type;
+		typedef ptrdiff_t difference_type;
+
+		template<typename U>
+		struct rebind {
+			typedef TaggedAllocator<U, Tag> other;
+		};
+
+		inline TaggedAllocator() {  }
+		template<typename U>
+		inline TaggedAllocator(const TaggedAllocator<U, Tag> &) {  }
+
+		inline T *allocate(size_t count) { return static_cast<T *>(MemoryTracker::allocate(Tag, count * sizeof(T))); }
+		inline void deallocate(T *pointer, size_t count) { MemoryTracker::deallocate(Tag, pointer, count * sizeof(T)); }
+		inline size_t max_size() const { return ((size_t)-1) / sizeof(T); }
+
+		template<typename U, typename... Args>
+		inline void construct(U *pointer, Args &&... args) { ::new((void *)pointer) U(std::forward<Args>(args)...); }
+		template<typename U>
+		inline void destroy(U *pointer) { pointer->~U(); }
+	};
+
+	template<typename T, typename U, MemoryTag Tag>
+	inline bool operator==(const TaggedAllocator<T, Tag> &, const TaggedAllocator<U, Tag> &) { return true; }
+	template<typename T, typename U, MemoryTag Tag>
+	inline bool operator!=(const TaggedAllocator<T, Tag> &, const TaggedAllocator<U, Tag> &) { return false; }
+
+	template<typename T, MemoryTag Tag>
+	using TaggedVector = std::vector<T, TaggedAllocator<T, Tag>>;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "stdafx.h"
+#include "MeshData.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	struct MeshFileHeader {
+		char magic[4];
+		u32 version;
+		u32 vertexCount;
+		u32 indexCount;
+		u32 lodCount;
+		f32 boundsMin[3];
+		f32 boundsMax[3];
+		f32 sphere[4];
+	};
+
+	namespace {
+		// Index ranges of the lods and the indices themselves have to stay within the mesh, draws read them unchecked
+		bool isValid(const MeshData &mesh) {
+			for (size_t i = 0; i < mesh.lods.size(); ++i) {
+				if ((u64)mesh.lods[i].indexOffset + mesh.lods[i].indexCount > mesh.indices.size()) {
+					return false;
+				}
+			}
+			for (size_t i = 0; i < mesh.indices.size(); ++i) {
+				if (mesh.indices[i] >= mesh.vertices.size()) {
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	ENCOSHAREDAPI MeshLod MeshData::getLod(uint lod) const {
+		if (lods.empty()) {
+			MeshLod full;
+			full.indexOffset = 0;
+			full.indexCount = (u32)indices.size();
+			full.error = 0.0f;
+			return full;
+		}
+		return lods[lod < lods.size() ? lod : lods.size() - 1];
+	}
+
+	ENCOSHAREDAPI void MeshData::computeBounds() {
+		if (vertices.empty()) {
+			bounds = AABB();
+			sphere = BoundingSphere();
+			return;
+		}
+
+		bounds = AABB(vertices[0].position, vertices[0].position);
+		for (size_t i = 1; i < vertices.size(); ++i) {
+			bounds.merge(vertices[i].position);
+		}
+
+		sphere.center = bounds.getCenter();
+		sphere.radius = 0.0f;
+		for (size_t i = 0; i < vertices.size(); ++i) {
+			sphere.radius = glm::max(sphere.radius, glm::length(vertices[i].position - sphere.center));
+		}
+	}
+
+	ENCOSHAREDAPI bool MeshData::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		MeshFileHeader header;
+		memcpy(header.magic, "EMSH", 4);
+		header.version = fileVersion;
+		header.vertexCount = (u32)vertices.size();
+		header.indexCount = (u32)indices.size();
+		header.lodCount = (u32)lods.size();
+		for (int i = 0; i < 3; ++i) {
+			header.boundsMin[i] = bounds.min[i];
+			header.boundsMax[i] = bounds.max[i];
+			header.sphere[i] = sphere.center[i];
+		}
+		header.sphere[3] = sphere.radius;
+
+		file.write((const char *)&header, sizeof(header));
+		if (!vertices.empty()) {
+			file.write((const char *)&vertices[0], vertices.size() * sizeof(MeshVertex));
+		}
+		if (!indices.empty()) {
+			file.write((const char *)&indices[0], indices.size() * sizeof(u32));
+		}
+		if (!lods.empty()) {
+			file.write((const char *)&lods[0], lods.size() * sizeof(MeshLod));
+		}
+
+		u32 skinCount = isSkinned() ? (u32)skinWeights.size() : 0;
+		file.write((const char *)&skinCount, sizeof(skinCount));
+		if (skinCount > 0) {
+			file.write((const char *)&skinWeights[0], skinWeights.size() * sizeof(SkinWeights));
+		}
+		return file.good();
+	}
+
+	ENCOSHAREDAPI bool MeshData::load(const std::string &path) {
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		MeshFileHeader header;
+		if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, "EMSH", 4) != 0 || header.version == 0 || header.version > fileVersion || header.lodCount > maxLods) {
+#ifdef _DEBUG
+			printf("Mesh Error: %s is not a mesh file of version %u or older\n", path.c_str(), fileVersion);
+#endif
+			return false;
+		}
+
+		// The counts are checked against the file size before anything is allocated for them
+		std::streamoff start = file.tellg();
+		file.seekg(0, std::ios::end);
+		u64 available = (u64)(file.tellg() - start);
+		file.seekg(start);
+		u64 required = (u64)header.vertexCount * sizeof(MeshVertex) + (u64)header.indexCount * sizeof(u32) + (u64)header.lodCount * sizeof(MeshLod);
+		if (required > available) {
+#ifdef _DEBUG
+			printf("Mesh Error: %s is truncated\n", path.c_str());
+#endif
+			return false;
+		}
+
+		vertices.resize(header.vertexCount);
+		indices.resize(header.indexCount);
+		lods.resize(header.lodCount);
+		if (!vertices.empty()) {
+			file.read((char *)&vertices[0], vertices.size() * sizeof(MeshVertex));
+		}
+		if (!indices.empty()) {
+			file.read((char *)&indices[0], indices.size() * sizeof(u32));
+		}
+		if (!lods.empty()) {
+			file.read((char *)&lods[0], lods.size() * sizeof(MeshLod));
+		}
+
+		skinWeights.clear();
+		u32 skinCount = 0;
+		bool skinMatches = true;
+		if (header.version >= 2 && file.read((char *)&skinCount, sizeof(skinCount)) && skinCount > 0) {
+			skinMatches = skinCount == header.vertexCount;
+			if (skinMatches) {
+				skinWeights.resize(skinCount);
+				file.read((char *)&skinWeights[0], skinWeights.size() * sizeof(SkinWeights));
+			}
+		}
+		if (!file || !skinMatches || !isValid(*this)) {
+#ifdef _DEBUG
+			printf("Mesh Error: %s is truncated, has indices outside of the mesh or skin weights for other vertices\n", path.c_str());
+#endif
+			vertices.clear();
+			indices.clear();
+			lods.clear();
+			skinWeights.clear();
+			return false;
+		}
+
+		for (int i = 0; i < 3; ++i) {
+			bounds.min[i] = header.boundsMin[i];
+			bounds.max[i] = header.boundsMax[i];
+			sphere.center[i] = header.sphere[i];
+		}
+		sphere.radius = header.sphere[3];
+		return true;
+	}
+
+	ENCOSHAREDAPI bool MeshAsset::import(const std::string &path) {
+		return m_mesh.load(path);
+	}
+}
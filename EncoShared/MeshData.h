@@ -0,0 +1,73 @@
+#ifndef __ENCOSHARED_MESHDATA_H__
+#define __ENCOSHARED_MESHDATA_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "Frustum.h"
+#include "MemoryTracker.h"
+
+#include <string>
+#include <vector>
+
+namespace enco {
+	struct MeshVertex {
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 texCoord;
+	};
+
+	// Up to four joints of a Skeleton per vertex, the weights of a vertex sum to 255
+	struct SkinWeights {
+		u8 joints[4];
+		u8 weights[4];
+	};
+
+	// A level of detail is a range of the shared index list, all levels use the same vertices.
+	// error is the geometric deviation from the full mesh in object space units.
+	struct MeshLod {
+		u32 indexOffset;
+		u32 indexCount;
+		f32 error;
+	};
+
+	// Triangle list mesh as stored in the binary .emesh format:
+	// header ("EMSH", version, counts, bounds), vertices, u32 indices, lods, since version 2 followed by
+	// a u32 count and that many skin weights. Version 1 files are still loaded.
+	class MeshData {
+	public:
+		static const u32 fileVersion = 2;
+		static const uint maxLods = 8;
+
+		TaggedVector<MeshVertex, assetMemory> vertices;
+		TaggedVector<u32, assetMemory> indices;
+		TaggedVector<MeshLod, assetMemory> lods;
+		// Empty or one entry per vertex
+		TaggedVector<SkinWeights, assetMemory> skinWeights;
+		AABB bounds;
+		BoundingSphere sphere;
+
+		// Without lods the whole index list is lod 0
+		inline uint getLodCount() const { return lods.empty() ? 1 : (uint)lods.size(); }
+		inline bool isSkinned() const { return !skinWeights.empty() && skinWeights.size() == vertices.size(); }
+		ENCOSHAREDAPI MeshLod getLod(uint lod) const;
+
+		ENCOSHAREDAPI void computeBounds();
+
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+		ENCOSHAREDAPI bool load(const std::string &path);
+	};
+
+	class MeshAsset : public IAsset {
+	public:
+		ENCOSHAREDAPI virtual bool import(const std::string &path);
+
+		inline const MeshData &getMesh() const { return m_mesh; }
+
+	private:
+		MeshData m_mesh;
+	};
+}
+
+#endif
@@ -0,0 +1,317 @@
+#include "stdafx.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <queue>
+
+namespace enco {
+	namespace {
+		// Symmetric 4x4 matrix of the summed plane equations, upper triangle only
+		struct Quadric {
+			f64 a00, a01, a02, a03, a11, a12, a13, a22, a23, a33;
+
+			inline Quadric() : a00(0), a01(0), a02(0), a03(0), a11(0), a12(0), a13(0), a22(0), a23(0), a33(0) {  }
+
+			inline void addPlane(const glm::vec3 &normal, f32 distance, f64 weight) {
+				f64 a = normal.x, b = normal.y, c = normal.z, d = distance;
+				a00 += weight * a * a; a01 += weight * a * b; a02 += weight * a * c; a03 += weight * a * d;
+				a11 += weight * b * b; a12 += weight * b * c; a13 += weight * b * d;
+				a22 += weight * c * c; a23 += weight * c * d;
+				a33 += weight * d * d;
+			}
+
+			inline void add(const Quadric &other) {
+				a00 += other.a00; a01 += other.a01; a02 += other.a02; a03 += other.a03;
+				a11 += other.a11; a12 += other.a12; a13 += other.a13;
+				a22 += other.a22; a23 += other.a23;
+				a33 += other.a33;
+			}
+
+			inline f64 evaluate(const glm::vec3 &p) const {
+				f64 x = p.x, y = p.y, z = p.z;
+				f64 result = a00 * x * x + 2 * a01 * x * y + 2 * a02 * x * z + 2 * a03 * x
+					+ a11 * y * y + 2 * a12 * y * z + 2 * a13 * y
+					+ a22 * z * z + 2 * a23 * z
+					+ a33;
+				return result > 0 ? result : 0;
+			}
+		};
+
+		struct Collapse {
+			f64 cost;
+			u32 from, to;
+			u32 fromVersion, toVersion;
+
+			inline bool operator>(const Collapse &other) const { return cost > other.cost; }
+		};
+
+		// Open edges get a plane perpendicular to their triangle so the border does not shrink
+		const f64 borderWeight = 10.0;
+	}
+
+	ENCOSHAREDAPI std::vector<u32> MeshSimplifier::simplify(const TaggedVector<MeshVertex, assetMemory> &vertices, const std::vector<u32> &indices, size_t targetIndexCount, f32 maxError, f32 *error) {
+		u32 vertexCount = (u32)vertices.size();
+
+		// Weld vertices with equal positions, the first one of each position represents it
+		std::vector<u32> order(vertexCount);
+		for (u32 i = 0; i < vertexCount; ++i) {
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&vertices](u32 a, u32 b) {
+			const glm::vec3 &p = vertices[a].position, &q = vertices[b].position;
+			return p.x != q.x ? p.x < q.x : (p.y != q.y ? p.y < q.y : (p.z != q.z ? p.z < q.z : a < b));
+		});
+		std::vector<u32> weld(vertexCount);
+		std::vector<u32> nextInGroup(vertexCount, 0xFFFFFFFF);
+		for (u32 i = 0; i < vertexCount; ++i) {
+			if (i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position) {
+				weld[order[i]] = weld[order[i - 1]];
+				nextInGroup[order[i - 1]] = order[i];
+			}
+			else {
+				weld[order[i]] = order[i];
+			}
+		}
+
+		std::vector<glm::u32vec3> triangles;
+		std::vector<glm::u32vec3> corners;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			glm::u32vec3 triangle(weld[indices[i]], weld[indices[i + 1]], weld[indices[i + 2]]);
+			if (triangle.x != triangle.y && triangle.y != triangle.z && triangle.x != triangle.z) {
+				triangles.push_back(triangle);
+				corners.push_back(glm::u32vec3(indices[i], indices[i + 1], indices[i + 2]));
+			}
+		}
+
+		std::vector<Quadric> quadrics(vertexCount);
+		std::vector<std::vector<u32>> vertexTriangles(vertexCount);
+		std::map<u64, u32> edgeUse;
+		for (u32 t = 0; t < (u32)triangles.size(); ++t) {
+			const glm::u32vec3 &triangle = triangles[t];
+			glm::vec3 p0 = vertices[triangle.x].position, p1 = vertices[triangle.y].position, p2 = vertices[triangle.z].position;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			f32 length = glm::length(normal);
+			if (length > 0.0f) {
+				normal /= length;
+				for (int k = 0; k < 3; ++k) {
+					quadrics[triangle[k]].addPlane(normal, -glm::dot(normal, p0), 1.0);
+				}
+			}
+
+			for (int k = 0; k < 3; ++k) {
+				vertexTriangles[triangle[k]].push_back(t);
+				u32 a = triangle[k], b = triangle[(k + 1) % 3];
+				++edgeUse[((u64)std::min(a, b) << 32) | std::max(a, b)];
+			}
+		}
+
+		for (u32 t = 0; t < (u32)triangles.size(); ++t) {
+			const glm::u32vec3 &triangle = triangles[t];
+			glm::vec3 p0 = vertices[triangle.x].position, p1 = vertices[triangle.y].position, p2 = vertices[triangle.z].position;
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			for (int k = 0; k < 3; ++k) {
+				u32 a = triangle[k], b = triangle[(k + 1) % 3];
+				if (edgeUse[((u64)std::min(a, b) << 32) | std::max(a, b)] != 1) {
+					continue;
+				}
+
+				glm::vec3 edge = vertices[b].position - vertices[a].position;
+				glm::vec3 borderNormal = glm::cross(edge, normal);
+				f32 length = glm::length(borderNormal);
+				if (length > 0.0f) {
+					borderNormal /= length;
+					f32 distance = -glm::dot(borderNormal, vertices[a].position);
+					quadrics[a].addPlane(borderNormal, distance, borderWeight);
+					quadrics[b].addPlane(borderNormal, distance, borderWeight);
+				}
+			}
+		}
+
+		std::vector<u8> triangleAlive(triangles.size(), 1);
+		std::vector<u8> vertexAlive(vertexCount, 0);
+		std::vector<u32> versions(vertexCount, 0);
+		for (size_t t = 0; t < triangles.size(); ++t) {
+			vertexAlive[triangles[t].x] = vertexAlive[triangles[t].y] = vertexAlive[triangles[t].z] = 1;
+		}
+
+		std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+		auto pushCollapse = [&](u32 from, u32 to) {
+			Quadric quadric = quadrics[from];
+			quadric.add(quadrics[to]);
+
+			Collapse collapse;
+			collapse.cost = quadric.evaluate(vertices[to].position);
+			collapse.from = from;
+			collapse.to = to;
+			collapse.fromVersion = versions[from];
+			collapse.toVersion = versions[to];
+			heap.push(collapse);
+		};
+		for (size_t t = 0; t < triangles.size(); ++t) {
+			for (int k = 0; k < 3; ++k) {
+				pushCollapse(triangles[t][k], triangles[t][(k + 1) % 3]);
+				pushCollapse(triangles[t][(k + 1) % 3], triangles[t][k]);
+			}
+		}
+
+		f64 maxCost = (f64)maxError * maxError;
+		f64 worstCost = 0.0;
+		size_t triangleCount = triangles.size();
+		while (triangleCount * 3 > targetIndexCount && !heap.empty()) {
+			Collapse collapse = heap.top();
+			heap.pop();
+
+			u32 from = collapse.from, to = collapse.to;
+			if (!vertexAlive[from] || !vertexAlive[to] || versions[from] != collapse.fromVersion || versions[to] != collapse.toVersion) {
+				continue;
+			}
+			if (collapse.cost > maxCost) {
+				break;
+			}
+
+			// Reject collapses that flip or degenerate a remaining triangle
+			bool valid = true;
+			const std::vector<u32> &fromTriangles = vertexTriangles[from];
+			for (size_t i = 0; i < fromTriangles.size() && valid; ++i) {
+				const glm::u32vec3 &triangle = triangles[fromTriangles[i]];
+				if (!triangleAlive[fromTriangles[i]] || triangle.x == to || triangle.y == to || triangle.z == to) {
+					continue;
+				}
+
+				glm::vec3 p[3], q[3];
+				for (int k = 0; k < 3; ++k) {
+					p[k] = vertices[triangle[k]].position;
+					q[k] = triangle[k] == from ? vertices[to].position : p[k];
+				}
+				glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+				glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+				valid = glm::dot(before, after) > 0.0f;
+			}
+			if (!valid) {
+				continue;
+			}
+
+			for (size_t i = 0; i < fromTriangles.size(); ++i) {
+				u32 t = fromTriangles[i];
+				if (!triangleAlive[t]) {
+					continue;
+				}
+
+				glm::u32vec3 &triangle = triangles[t];
+				if (triangle.x == to || triangle.y == to || triangle.z == to) {
+					triangleAlive[t] = 0;
+					--triangleCount;
+					continue;
+				}
+				for (int k = 0; k < 3; ++k) {
+					if (triangle[k] == from) {
+						triangle[k] = to;
+					}
+				}
+				vertexTriangles[to].push_back(t);
+			}
+
+			vertexAlive[from] = 0;
+			vertexTriangles[from].clear();
+			quadrics[to].add(quadrics[from]);
+			++versions[to];
+			worstCost = std::max(worstCost, collapse.cost);
+
+			std::vector<u32> &toTriangles = vertexTriangles[to];
+			std::vector<u32> remaining;
+			for (size_t i = 0; i < toTriangles.size(); ++i) {
+				if (triangleAlive[toTriangles[i]]) {
+					remaining.push_back(toTriangles[i]);
+				}
+			}
+			toTriangles.swap(remaining);
+
+			for (size_t i = 0; i < toTriangles.size(); ++i) {
+				const glm::u32vec3 &triangle = triangles[toTriangles[i]];
+				for (int k = 0; k < 3; ++k) {
+					if (triangle[k] != to) {
+						pushCollapse(to, triangle[k]);
+						pushCollapse(triangle[k], to);
+					}
+				}
+			}
+		}
+
+		// Back from welded positions to real vertices, picking the one whose attributes match the original corner best
+		std::vector<u32> result;
+		result.reserve(triangleCount * 3);
+		for (size_t t = 0; t < triangles.size(); ++t) {
+			if (!triangleAlive[t]) {
+				continue;
+			}
+
+			for (int k = 0; k < 3; ++k) {
+				u32 original = corners[t][k];
+				u32 target = triangles[t][k];
+				if (weld[original] == target) {
+					result.push_back(original);
+					continue;
+				}
+
+				const MeshVertex &reference = vertices[original];
+				u32 best = target;
+				f32 bestDistance = 1e30f;
+				for (u32 candidate = target; candidate != 0xFFFFFFFF; candidate = nextInGroup[candidate]) {
+					glm::vec3 normalDelta = vertices[candidate].normal - reference.normal;
+					glm::vec2 texCoordDelta = vertices[candidate].texCoord - reference.texCoord;
+					f32 distance = glm::dot(normalDelta, normalDelta) + glm::dot(texCoordDelta, texCoordDelta);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = candidate;
+					}
+				}
+				result.push_back(best);
+			}
+		}
+
+		if (error) {
+			*error = (f32)std::sqrt(worstCost);
+		}
+		return result;
+	}
+
+	ENCOSHAREDAPI void MeshSimplifier::generateLods(MeshData &mesh, uint lodCount, f32 reduction, f32 maxError) {
+		MeshLod base = mesh.getLod(0);
+		std::vector<u32> current(mesh.indices.begin() + base.indexOffset, mesh.indices.begin() + base.indexOffset + base.indexCount);
+
+		TaggedVector<u32, assetMemory> indices(current.begin(), current.end());
+		mesh.lods.clear();
+
+		MeshLod lod;
+		lod.indexOffset = 0;
+		lod.indexCount = (u32)current.size();
+		lod.error = 0.0f;
+		mesh.lods.push_back(lod);
+
+		lodCount = std::min(lodCount, MeshData::maxLods + 0);
+		f32 error = 0.0f;
+		for (uint level = 1; level < lodCount; ++level) {
+			size_t target = (size_t)(current.size() / 3 * reduction) * 3;
+
+			// Each level is simplified from the previous one, their errors add up
+			f32 levelError = 0.0f;
+			std::vector<u32> next = simplify(mesh.vertices, current, target, maxError - error, &levelError);
+			if (next.empty() || next.size() > current.size() * 9 / 10) {
+				break;
+			}
+			error += levelError;
+
+			lod.indexOffset = (u32)indices.size();
+			lod.indexCount = (u32)next.size();
+			lod.error = error;
+			mesh.lods.push_back(lod);
+
+			indices.insert(indices.end(), next.begin(), next.end());
+			current.swap(next);
+		}
+
+		mesh.indices.swap(indices);
+	}
+}
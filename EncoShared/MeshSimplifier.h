@@ -0,0 +1,27 @@
+#ifndef __ENCOSHARED_MESHSIMPLIFIER_H__
+#define __ENCOSHARED_MESHSIMPLIFIER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "MeshData.h"
+
+#include <vector>
+
+namespace enco {
+	// Offline quadric error (Garland/Heckbert) edge collapse. Collapses always move a vertex onto one of
+	// its neighbours, so simplified levels only need a new index list and share the vertex buffer.
+	// Vertices with equal positions are treated as one, which keeps UV and normal seams closed.
+	class MeshSimplifier {
+	public:
+		// Simplifies the triangle list indices (into vertices) until it has at most targetIndexCount indices
+		// or the next collapse would exceed maxError. error receives the deviation of the result.
+		ENCOSHAREDAPI static std::vector<u32> simplify(const TaggedVector<MeshVertex, assetMemory> &vertices, const std::vector<u32> &indices, size_t targetIndexCount, f32 maxError, f32 *error = nullptr);
+
+		// Replaces the lods of mesh with a chain where every level keeps about reduction of the triangles of
+		// the previous one. Stops early when a level cannot be reduced by at least 10% within maxError.
+		ENCOSHAREDAPI static void generateLods(MeshData &mesh, uint lodCount = 4, f32 reduction = 0.5f, f32 maxError = 1e30f);
+	};
+}
+
+#endif
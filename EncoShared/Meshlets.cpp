@@ -0,0 +1,240 @@
+#include "stdafx.h"
+#include "Meshlets.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace enco {
+	namespace {
+		// Normal cones keep their angle under rotation and uniform scale only, so other transforms skip the test
+		bool keepsNormalCones(const glm::mat4 &transform) {
+			glm::vec3 x(transform[0]), y(transform[1]), z(transform[2]);
+			f32 xx = glm::dot(x, x), yy = glm::dot(y, y), zz = glm::dot(z, z);
+			f32 tolerance = 1e-3f * std::max(xx, std::max(yy, zz));
+			return std::abs(xx - yy) <= tolerance && std::abs(xx - zz) <= tolerance &&
+				std::abs(glm::dot(x, y)) <= tolerance && std::abs(glm::dot(x, z)) <= tolerance && std::abs(glm::dot(y, z)) <= tolerance;
+		}
+	}
+
+	ENCOSHAREDAPI void MeshletData::build(MeshData &mesh, uint maxVertices, uint maxTriangles) {
+		m_meshlets.clear();
+
+		MeshLod lod = mesh.getLod(0);
+		u32 triangleCount = lod.indexCount / 3;
+		u32 vertexCount = (u32)mesh.vertices.size();
+		const std::vector<u32> source(mesh.indices.begin() + lod.indexOffset, mesh.indices.begin() + lod.indexOffset + triangleCount * 3);
+
+		// Triangles around every vertex
+		std::vector<u32> adjacencyStart(vertexCount + 1, 0);
+		for (size_t i = 0; i < source.size(); ++i) {
+			++adjacencyStart[source[i] + 1];
+		}
+		for (u32 v = 0; v < vertexCount; ++v) {
+			adjacencyStart[v + 1] += adjacencyStart[v];
+		}
+		std::vector<u32> adjacency(source.size());
+		std::vector<u32> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t i = 0; i < source.size(); ++i) {
+			adjacency[fill[source[i]]++] = (u32)(i / 3);
+		}
+
+		std::vector<u8> used(triangleCount, 0);
+		std::vector<u32> stamp(vertexCount, 0xFFFFFFFF);
+		std::vector<u32> reordered;
+		reordered.reserve(source.size());
+
+		std::vector<u32> meshletVertices;
+		std::vector<u32> candidates;
+		for (u32 seed = 0; seed < triangleCount; ++seed) {
+			if (used[seed]) {
+				continue;
+			}
+
+			u32 id = (u32)m_meshlets.size();
+			Meshlet meshlet;
+			meshlet.indexOffset = lod.indexOffset + (u32)reordered.size();
+			meshlet.triangleCount = 0;
+			meshletVertices.clear();
+			candidates.clear();
+
+			u32 next = seed;
+			while (next != 0xFFFFFFFF) {
+				used[next] = 1;
+				++meshlet.triangleCount;
+				for (int k = 0; k < 3; ++k) {
+					u32 vertex = source[next * 3 + k];
+					reordered.push_back(vertex);
+					if (stamp[vertex] != id) {
+						stamp[vertex] = id;
+						meshletVertices.push_back(vertex);
+						candidates.insert(candidates.end(), adjacency.begin() + adjacencyStart[vertex], adjacency.begin() + adjacencyStart[vertex + 1]);
+					}
+				}
+
+				if (meshlet.triangleCount >= maxTriangles) {
+					break;
+				}
+
+				// Grow over the neighbour that adds the fewest new vertices
+				next = 0xFFFFFFFF;
+				uint bestNew = 4;
+				size_t kept = 0;
+				for (size_t i = 0; i < candidates.size(); ++i) {
+					u32 triangle = candidates[i];
+					if (used[triangle]) {
+						continue;
+					}
+					candidates[kept++] = triangle;
+
+					uint newVertices = 0;
+					for (int k = 0; k < 3; ++k) {
+						newVertices += stamp[source[triangle * 3 + k]] != id ? 1 : 0;
+					}
+					if (newVertices < bestNew && meshletVertices.size() + newVertices <= maxVertices) {
+						bestNew = newVertices;
+						next = triangle;
+					}
+				}
+				candidates.resize(kept);
+			}
+
+			meshlet.vertexCount = (u32)meshletVertices.size();
+
+			AABB box(mesh.vertices[meshletVertices[0]].position, mesh.vertices[meshletVertices[0]].position);
+			for (size_t i = 1; i < meshletVertices.size(); ++i) {
+				box.merge(mesh.vertices[meshletVertices[i]].position);
+			}
+			meshlet.bounds.center = box.getCenter();
+			meshlet.bounds.radius = 0.0f;
+			for (size_t i = 0; i < meshletVertices.size(); ++i) {
+				meshlet.bounds.radius = std::max(meshlet.bounds.radius, glm::length(mesh.vertices[meshletVertices[i]].position - meshlet.bounds.center));
+			}
+
+			// Normal cone from the face normals
+			std::vector<glm::vec3> normals;
+			glm::vec3 axis(0.0f);
+			for (u32 i = meshlet.indexOffset - lod.indexOffset; i < (u32)reordered.size(); i += 3) {
+				glm::vec3 p0 = mesh.vertices[reordered[i]].position, p1 = mesh.vertices[reordered[i + 1]].position, p2 = mesh.vertices[reordered[i + 2]].position;
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				f32 length = glm::length(normal);
+				if (length > 0.0f) {
+					normals.push_back(normal / length);
+					axis += normal / length;
+				}
+			}
+
+			meshlet.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+			meshlet.coneCutoff = 1.0f;
+			if (glm::length(axis) > 1e-6f) {
+				meshlet.coneAxis = glm::normalize(axis);
+				f32 minimumDot = 1.0f;
+				for (size_t i = 0; i < normals.size(); ++i) {
+					minimumDot = std::min(minimumDot, glm::dot(normals[i], meshlet.coneAxis));
+				}
+				if (minimumDot > 0.0f) {
+					meshlet.coneCutoff = std::sqrt(1.0f - minimumDot * minimumDot);
+				}
+			}
+
+			m_meshlets.push_back(meshlet);
+		}
+
+		std::copy(reordered.begin(), reordered.end(), mesh.indices.begin() + lod.indexOffset);
+	}
+
+	ENCOSHAREDAPI MeshletCuller::MeshletCuller() : m_cameraPosition(0.0f), m_depthPyramid(nullptr), m_tested(0), m_frustumCulled(0), m_backfaceCulled(0), m_occlusionCulled(0) {
+	}
+
+	ENCOSHAREDAPI void MeshletCuller::setCamera(const glm::vec3 &position, const glm::mat4 &viewProjection) {
+		m_cameraPosition = position;
+		m_frustum.set(viewProjection);
+	}
+
+	ENCOSHAREDAPI void MeshletCuller::cull(const std::vector<MeshletInstance> &instances, JobSystem &jobSystem) {
+		// Flatten all meshlets of all instances into one range the jobs split evenly
+		m_instanceStarts.resize(instances.size() + 1);
+		m_instanceStarts[0] = 0;
+		for (size_t i = 0; i < instances.size(); ++i) {
+			uint count = instances[i].meshlets ? (uint)instances[i].meshlets->getMeshlets().size() : 0;
+			m_instanceStarts[i + 1] = m_instanceStarts[i] + count;
+		}
+
+		uint total = m_instanceStarts.back();
+		m_batches.resize((total + batchSize - 1) / batchSize);
+		jobSystem.parallelFor(total, batchSize, [this, &instances](uint begin, uint end) {
+			cullBatch(instances, begin, end, m_batches[begin / batchSize]);
+		});
+
+		m_commands.clear();
+		m_tested = total;
+		m_frustumCulled = m_backfaceCulled = m_occlusionCulled = 0;
+		for (size_t i = 0; i < m_batches.size(); ++i) {
+			const Batch &batch = m_batches[i];
+			for (size_t j = 0; j < batch.commands.size(); ++j) {
+				append(m_commands, batch.commands[j]);
+			}
+			m_frustumCulled += batch.frustumCulled;
+			m_backfaceCulled += batch.backfaceCulled;
+			m_occlusionCulled += batch.occlusionCulled;
+		}
+	}
+
+	void MeshletCuller::cullBatch(const std::vector<MeshletInstance> &instances, uint begin, uint end, Batch &batch) const {
+		batch.commands.clear();
+		batch.frustumCulled = batch.backfaceCulled = batch.occlusionCulled = 0;
+
+		size_t instanceIndex = std::upper_bound(m_instanceStarts.begin(), m_instanceStarts.end(), begin) - m_instanceStarts.begin() - 1;
+		bool coneCulling = keepsNormalCones(instances[instanceIndex].transform);
+		for (uint i = begin; i < end; ++i) {
+			if (i >= m_instanceStarts[instanceIndex + 1]) {
+				while (i >= m_instanceStarts[instanceIndex + 1]) {
+					++instanceIndex;
+				}
+				coneCulling = keepsNormalCones(instances[instanceIndex].transform);
+			}
+
+			const MeshletInstance &instance = instances[instanceIndex];
+			const Meshlet &meshlet = instance.meshlets->getMeshlets()[i - m_instanceStarts[instanceIndex]];
+
+			BoundingSphere bounds(glm::vec3(instance.transform * glm::vec4(meshlet.bounds.center, 1.0f)), meshlet.bounds.radius * instance.scale);
+			if (!m_frustum.intersects(bounds)) {
+				++batch.frustumCulled;
+				continue;
+			}
+
+			// The whole cone faces away when the view direction is within 90 degrees minus its spread of the axis
+			if (coneCulling) {
+				glm::vec3 axis = glm::normalize(glm::vec3(instance.transform * glm::vec4(meshlet.coneAxis, 0.0f)));
+				glm::vec3 toCenter = bounds.center - m_cameraPosition;
+				if (glm::dot(toCenter, axis) >= meshlet.coneCutoff * glm::length(toCenter) + bounds.radius) {
+					++batch.backfaceCulled;
+					continue;
+				}
+			}
+
+			if (m_depthPyramid && m_depthPyramid->isOccluded(bounds)) {
+				++batch.occlusionCulled;
+				continue;
+			}
+
+			DrawIndirectCommand command;
+			command.count = meshlet.triangleCount * 3;
+			command.instanceCount = 1;
+			command.firstIndex = meshlet.indexOffset;
+			command.baseVertex = 0;
+			command.baseInstance = instance.instance;
+			append(batch.commands, command);
+		}
+	}
+
+	void MeshletCuller::append(std::vector<DrawIndirectCommand> &commands, const DrawIndirectCommand &command) {
+		if (!commands.empty()) {
+			DrawIndirectCommand &last = commands.back();
+			if (last.baseInstance == command.baseInstance && last.firstIndex + last.count == command.firstIndex) {
+				last.count += command.count;
+				return;
+			}
+		}
+		commands.push_back(command);
+	}
+}
@@ -0,0 +1,107 @@
+#ifndef __ENCOSHARED_MESHLETS_H__
+#define __ENCOSHARED_MESHLETS_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "DepthPyramid.h"
+#include "JobSystem.h"
+#include "MeshData.h"
+
+#include <vector>
+
+namespace enco {
+	struct Meshlet {
+		// Range of MeshData::indices, the triangles of a meshlet are stored contiguously
+		u32 indexOffset;
+		u32 triangleCount;
+		u32 vertexCount;
+
+		BoundingSphere bounds;
+		// Every triangle normal lies within the cone around coneAxis, coneCutoff is the sine of its half angle.
+		// 1 disables backface culling for meshlets whose normals spread 90 degrees or more.
+		glm::vec3 coneAxis;
+		f32 coneCutoff;
+	};
+
+	// Layout of GL's DrawElementsIndirectCommand
+	struct DrawIndirectCommand {
+		u32 count;
+		u32 instanceCount;
+		u32 firstIndex;
+		i32 baseVertex;
+		u32 baseInstance;
+	};
+
+	class MeshletData {
+	public:
+		static const uint defaultMaxVertices = 64;
+		static const uint defaultMaxTriangles = 124;
+
+		// Splits lod 0 of mesh into meshlets by growing each one over neighbouring triangles. The triangles of
+		// that lod are reordered in place so every meshlet is one index range, which leaves regular draws intact.
+		ENCOSHAREDAPI void build(MeshData &mesh, uint maxVertices = defaultMaxVertices, uint maxTriangles = defaultMaxTriangles);
+
+		inline const std::vector<Meshlet> &getMeshlets() const { return m_meshlets; }
+
+	private:
+		std::vector<Meshlet> m_meshlets;
+	};
+
+	struct MeshletInstance {
+		const MeshletData *meshlets;
+		glm::mat4 transform;
+		// Largest scale factor of transform
+		f32 scale;
+		// Passed on as baseInstance, instanced vertex attributes start at this instance
+		u32 instance;
+
+		inline MeshletInstance() : meshlets(nullptr), transform(1.0f), scale(1.0f), instance(0) {  }
+	};
+
+	// Culls meshlets against the frustum, their normal cone and an optional depth pyramid on the job system
+	// and compacts the survivors into indirect draw commands. Consecutive surviving meshlets of an instance
+	// are merged into a single command. Instances with non-uniform scale or shear skip the normal cone test.
+	class MeshletCuller {
+	public:
+		ENCOSHAREDAPI MeshletCuller();
+
+		ENCOSHAREDAPI void setCamera(const glm::vec3 &position, const glm::mat4 &viewProjection);
+		inline void setDepthPyramid(const DepthPyramid *pyramid) { m_depthPyramid = pyramid; }
+
+		ENCOSHAREDAPI void cull(const std::vector<MeshletInstance> &instances, JobSystem &jobSystem);
+
+		inline const std::vector<DrawIndirectCommand> &getCommands() const { return m_commands; }
+
+		inline uint getTestedCount() const { return m_tested; }
+		inline uint getFrustumCulledCount() const { return m_frustumCulled; }
+		inline uint getBackfaceCulledCount() const { return m_backfaceCulled; }
+		inline uint getOcclusionCulledCount() const { return m_occlusionCulled; }
+
+	private:
+		struct Batch {
+			std::vector<DrawIndirectCommand> commands;
+			uint frustumCulled, backfaceCulled, occlusionCulled;
+		};
+
+		static const uint batchSize = 256;
+
+		void cullBatch(const std::vector<MeshletInstance> &instances, uint begin, uint end, Batch &batch) const;
+		static void append(std::vector<DrawIndirectCommand> &commands, const DrawIndirectCommand &command);
+
+		glm::vec3 m_cameraPosition;
+		Frustum m_frustum;
+		const DepthPyramid *m_depthPyramid;
+
+		std::vector<u32> m_instanceStarts;
+		std::vector<Batch> m_batches;
+		std::vector<DrawIndirectCommand> m_commands;
+
+		uint m_tested;
+		uint m_frustumCulled;
+		uint m_backfaceCulled;
+		uint m_occlusionCulled;
+	};
+}
+
+#endif
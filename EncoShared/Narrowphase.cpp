@@ -0,0 +1,678 @@
+#include "stdafx.h"
+#include "Narrowphase.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const uint maxGjkIterations = 64;
+		const uint maxEpaIterations = 64;
+		const uint maxEpaVertices = 128;
+		const uint maxEpaFaces = 256;
+		const uint maxFeaturePoints = 16;
+		// Relative to the size of the simplex, large shapes next to small ones lose precision in absolute terms
+		const f32 gjkTolerance = 1e-4f;
+		const f32 epaTolerance = 1e-4f;
+		// Sine of the angle within which points count as one face, so a slightly tilted box still rests on its
+		// whole face instead of rocking between corners
+		const f32 featureTolerance = 0.05f;
+
+		// A point of the Minkowski difference a - b along with the points of both shapes it came from
+		struct SupportPoint {
+			glm::vec3 a, b, w;
+		};
+
+		struct Pair {
+			const CollisionShape *shapes[2];
+			const ShapeTransform *transforms[2];
+			glm::quat inverses[2];
+
+			inline glm::vec3 supportCore(uint index, const glm::vec3 &direction) const {
+				return transforms[index]->position + transforms[index]->orientation * shapes[index]->supportCore(inverses[index] * direction);
+			}
+
+			inline SupportPoint support(const glm::vec3 &direction) const {
+				SupportPoint point;
+				point.a = supportCore(0, direction);
+				point.b = supportCore(1, -direction);
+				point.w = point.a - point.b;
+				return point;
+			}
+		};
+
+		struct Simplex {
+			SupportPoint points[4];
+			f32 weights[4];
+			uint count;
+
+			inline void keep(uint i0) {
+				points[0] = points[i0];
+				weights[0] = 1.0f;
+				count = 1;
+			}
+
+			inline void keep(uint i0, uint i1, f32 t) {
+				SupportPoint p0 = points[i0], p1 = points[i1];
+				points[0] = p0;
+				points[1] = p1;
+				weights[0] = 1.0f - t;
+				weights[1] = t;
+				count = 2;
+			}
+
+			inline glm::vec3 getClosest() const {
+				glm::vec3 result(0.0f);
+				for (uint i = 0; i < count; ++i) {
+					result += points[i].w * weights[i];
+				}
+				return result;
+			}
+		};
+
+		// Reduces the simplex to the feature closest to the origin (Ericson, Real-Time Collision Detection 5.1.5)
+		void solveSegment(Simplex &simplex) {
+			glm::vec3 a = simplex.points[0].w, ab = simplex.points[1].w - a;
+			f32 length = glm::dot(ab, ab);
+			f32 t = length > 0.0f ? -glm::dot(a, ab) / length : 0.0f;
+			if (t <= 0.0f) {
+				simplex.keep(0);
+			}
+			else if (t >= 1.0f) {
+				simplex.keep(1);
+			}
+			else {
+				simplex.keep(0, 1, t);
+			}
+		}
+
+		void solveTriangle(Simplex &simplex, uint i0, uint i1, uint i2) {
+			glm::vec3 a = simplex.points[i0].w, b = simplex.points[i1].w, c = simplex.points[i2].w;
+			glm::vec3 ab = b - a, ac = c - a, ap = -a;
+			f32 d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+			if (d1 <= 0.0f && d2 <= 0.0f) {
+				simplex.keep(i0);
+				return;
+			}
+
+			glm::vec3 bp = -b;
+			f32 d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+			if (d3 >= 0.0f && d4 <= d3) {
+				simplex.keep(i1);
+				return;
+			}
+
+			f32 vc = d1 * d4 - d3 * d2;
+			if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+				simplex.keep(i0, i1, d1 / (d1 - d3));
+				return;
+			}
+
+			glm::vec3 cp = -c;
+			f32 d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+			if (d6 >= 0.0f && d5 <= d6) {
+				simplex.keep(i2);
+				return;
+			}
+
+			f32 vb = d5 * d2 - d1 * d6;
+			if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+				simplex.keep(i0, i2, d2 / (d2 - d6));
+				return;
+			}
+
+			f32 va = d3 * d6 - d5 * d4;
+			if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+				simplex.keep(i1, i2, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+				return;
+			}
+
+			f32 sum = va + vb + vc;
+			if (sum <= 0.0f) {
+				// Degenerate triangle, the edges above already covered every point of it
+				simplex.keep(i0);
+				return;
+			}
+			SupportPoint p0 = simplex.points[i0], p1 = simplex.points[i1], p2 = simplex.points[i2];
+			simplex.points[0] = p0;
+			simplex.points[1] = p1;
+			simplex.points[2] = p2;
+			simplex.weights[0] = va / sum;
+			simplex.weights[1] = vb / sum;
+			simplex.weights[2] = vc / sum;
+			simplex.count = 3;
+		}
+
+		// Returns true when the origin is inside the tetrahedron
+		bool solveTetrahedron(Simplex &simplex) {
+			static const uint faces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+
+			Simplex best;
+			f32 bestDistance = 1e30f;
+			bool outside = false;
+			for (uint i = 0; i < 4; ++i) {
+				const uint *face = faces[i];
+				glm::vec3 a = simplex.points[face[0]].w;
+				glm::vec3 normal = glm::cross(simplex.points[face[1]].w - a, simplex.points[face[2]].w - a);
+				f32 origin = glm::dot(-a, normal), opposite = glm::dot(simplex.points[face[3]].w - a, normal);
+				if (origin * opposite > 0.0f) {
+					continue;
+				}
+
+				outside = true;
+				Simplex candidate = simplex;
+				solveTriangle(candidate, face[0], face[1], face[2]);
+				glm::vec3 closest = candidate.getClosest();
+				f32 distance = glm::dot(closest, closest);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = candidate;
+				}
+			}
+
+			if (!outside) {
+				return true;
+			}
+			simplex = best;
+			return false;
+		}
+
+		// Runs GJK on the cores, returns false when they overlap and leaves the last simplex behind for EPA
+		bool gjk(const Pair &pair, Simplex &simplex, glm::vec3 &pointA, glm::vec3 &pointB) {
+			glm::vec3 direction = pair.transforms[1]->position - pair.transforms[0]->position;
+			if (glm::dot(direction, direction) < 1e-12f) {
+				direction = glm::vec3(1.0f, 0.0f, 0.0f);
+			}
+			simplex.points[0] = pair.support(-direction);
+			simplex.weights[0] = 1.0f;
+			simplex.count = 1;
+
+			for (uint iteration = 0; iteration < maxGjkIterations; ++iteration) {
+				switch (simplex.count) {
+				case 2:
+					solveSegment(simplex);
+					break;
+				case 3:
+					solveTriangle(simplex, 0, 1, 2);
+					break;
+				case 4:
+					if (solveTetrahedron(simplex)) {
+						return false;
+					}
+					break;
+				}
+
+				glm::vec3 closest = simplex.getClosest();
+				f32 distance = glm::dot(closest, closest);
+				f32 scale = 0.0f;
+				for (uint i = 0; i < simplex.count; ++i) {
+					scale = std::max(scale, glm::dot(simplex.points[i].w, simplex.points[i].w));
+				}
+				if (distance <= gjkTolerance * gjkTolerance * scale) {
+					return false;
+				}
+
+				SupportPoint point = pair.support(-closest);
+				// No point of the difference is closer to the origin in the search direction
+				if (distance - glm::dot(closest, point.w) <= gjkTolerance * distance) {
+					break;
+				}
+				bool duplicate = false;
+				for (uint i = 0; i < simplex.count; ++i) {
+					glm::vec3 delta = simplex.points[i].w - point.w;
+					duplicate |= glm::dot(delta, delta) < 1e-12f;
+				}
+				if (duplicate) {
+					break;
+				}
+				simplex.points[simplex.count] = point;
+				simplex.weights[simplex.count] = 0.0f;
+				++simplex.count;
+			}
+
+			pointA = pointB = glm::vec3(0.0f);
+			for (uint i = 0; i < simplex.count; ++i) {
+				pointA += simplex.points[i].a * simplex.weights[i];
+				pointB += simplex.points[i].b * simplex.weights[i];
+			}
+			return true;
+		}
+
+		struct EpaFace {
+			uint indices[3];
+			glm::vec3 normal;
+			f32 distance;
+			bool removed;
+		};
+
+		struct Polytope {
+			SupportPoint vertices[maxEpaVertices];
+			EpaFace faces[maxEpaFaces];
+			uint vertexCount, faceCount;
+			glm::vec3 center;
+
+			inline bool addFace(uint i0, uint i1, uint i2) {
+				if (faceCount == maxEpaFaces) {
+					return false;
+				}
+				EpaFace &face = faces[faceCount];
+				glm::vec3 a = vertices[i0].w;
+				glm::vec3 normal = glm::cross(vertices[i1].w - a, vertices[i2].w - a);
+				f32 length = glm::length(normal);
+				if (length < 1e-12f) {
+					return true;
+				}
+				normal /= length;
+				// Faces point away from the interior, which contains the origin
+				if (glm::dot(normal, a - center) < 0.0f) {
+					std::swap(i1, i2);
+					normal = -normal;
+				}
+				face.indices[0] = i0;
+				face.indices[1] = i1;
+				face.indices[2] = i2;
+				face.normal = normal;
+				face.distance = glm::dot(normal, a);
+				face.removed = false;
+				++faceCount;
+				return true;
+			}
+		};
+
+		// Grows the final GJK simplex into a tetrahedron around the origin
+		bool completeSimplex(const Pair &pair, Simplex &simplex) {
+			static const glm::vec3 axes[6] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f),
+				glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+
+			if (simplex.count == 1) {
+				for (uint i = 0; i < 6 && simplex.count == 1; ++i) {
+					SupportPoint point = pair.support(axes[i]);
+					glm::vec3 delta = point.w - simplex.points[0].w;
+					if (glm::dot(delta, delta) > 1e-10f) {
+						simplex.points[simplex.count++] = point;
+					}
+				}
+			}
+			if (simplex.count == 2) {
+				glm::vec3 line = simplex.points[1].w - simplex.points[0].w;
+				for (uint i = 0; i < 6 && simplex.count == 2; ++i) {
+					glm::vec3 direction = glm::cross(line, axes[i]);
+					if (glm::dot(direction, direction) < 1e-10f) {
+						continue;
+					}
+					SupportPoint point = pair.support(direction);
+					if (glm::length(glm::cross(point.w - simplex.points[0].w, line)) > 1e-6f) {
+						simplex.points[simplex.count++] = point;
+					}
+				}
+			}
+			if (simplex.count == 3) {
+				glm::vec3 normal = glm::cross(simplex.points[1].w - simplex.points[0].w, simplex.points[2].w - simplex.points[0].w);
+				SupportPoint point = pair.support(normal);
+				if (fabsf(glm::dot(point.w - simplex.points[0].w, normal)) < 1e-10f) {
+					point = pair.support(-normal);
+				}
+				if (fabsf(glm::dot(point.w - simplex.points[0].w, normal)) < 1e-10f) {
+					return false;
+				}
+				simplex.points[simplex.count++] = point;
+			}
+			return simplex.count == 4;
+		}
+
+		// Expands the polytope towards the surface of the difference until the face closest to the origin stops moving
+		bool epa(const Pair &pair, Simplex &simplex, glm::vec3 &normal, f32 &depth, glm::vec3 &pointA, glm::vec3 &pointB) {
+			if (!completeSimplex(pair, simplex)) {
+				return false;
+			}
+
+			Polytope polytope;
+			polytope.vertexCount = 4;
+			polytope.faceCount = 0;
+			polytope.center = glm::vec3(0.0f);
+			for (uint i = 0; i < 4; ++i) {
+				polytope.vertices[i] = simplex.points[i];
+				polytope.center += simplex.points[i].w * 0.25f;
+			}
+			polytope.addFace(0, 1, 2);
+			polytope.addFace(0, 3, 1);
+			polytope.addFace(0, 2, 3);
+			polytope.addFace(1, 3, 2);
+
+			uint edges[maxEpaFaces * 3][2];
+			const EpaFace *closest = nullptr;
+			for (uint iteration = 0; iteration <= maxEpaIterations; ++iteration) {
+				closest = nullptr;
+				for (uint i = 0; i < polytope.faceCount; ++i) {
+					if (!closest || polytope.faces[i].distance < closest->distance) {
+						closest = &polytope.faces[i];
+					}
+				}
+				if (!closest) {
+					return false;
+				}
+				if (iteration == maxEpaIterations) {
+					break;
+				}
+
+				SupportPoint point = pair.support(closest->normal);
+				if (glm::dot(point.w, closest->normal) - closest->distance < epaTolerance || polytope.vertexCount == maxEpaVertices) {
+					break;
+				}
+
+				// Faces the new point sees are removed, the edges they share with faces it does not see form the horizon
+				uint vertex = polytope.vertexCount++;
+				polytope.vertices[vertex] = point;
+				uint edgeCount = 0;
+				for (uint i = 0; i < polytope.faceCount; ++i) {
+					EpaFace &face = polytope.faces[i];
+					if (face.removed || glm::dot(face.normal, point.w - polytope.vertices[face.indices[0]].w) <= 0.0f) {
+						continue;
+					}
+					face.removed = true;
+					for (uint j = 0; j < 3; ++j) {
+						uint from = face.indices[j], to = face.indices[(j + 1) % 3];
+						bool shared = false;
+						for (uint k = 0; k < edgeCount; ++k) {
+							if (edges[k][0] == to && edges[k][1] == from) {
+								edges[k][0] = edges[--edgeCount][0];
+								edges[k][1] = edges[edgeCount][1];
+								shared = true;
+								break;
+							}
+						}
+						if (!shared) {
+							edges[edgeCount][0] = from;
+							edges[edgeCount][1] = to;
+							++edgeCount;
+						}
+					}
+				}
+
+				// Compact the removed faces away before adding new ones
+				uint kept = 0;
+				for (uint i = 0; i < polytope.faceCount; ++i) {
+					if (!polytope.faces[i].removed) {
+						polytope.faces[kept++] = polytope.faces[i];
+					}
+				}
+				polytope.faceCount = kept;
+				for (uint i = 0; i < edgeCount; ++i) {
+					if (!polytope.addFace(edges[i][0], edges[i][1], vertex)) {
+						break;
+					}
+				}
+			}
+
+			// Barycentric coordinates of the origin projected onto the closest face
+			const SupportPoint &a = polytope.vertices[closest->indices[0]], &b = polytope.vertices[closest->indices[1]], &c = polytope.vertices[closest->indices[2]];
+			glm::vec3 projected = closest->normal * closest->distance;
+			glm::vec3 v0 = b.w - a.w, v1 = c.w - a.w, v2 = projected - a.w;
+			f32 d00 = glm::dot(v0, v0), d01 = glm::dot(v0, v1), d11 = glm::dot(v1, v1), d20 = glm::dot(v2, v0), d21 = glm::dot(v2, v1);
+			f32 denominator = d00 * d11 - d01 * d01;
+			f32 v = denominator != 0.0f ? (d11 * d20 - d01 * d21) / denominator : 0.0f;
+			f32 w = denominator != 0.0f ? (d00 * d21 - d01 * d20) / denominator : 0.0f;
+			f32 u = 1.0f - v - w;
+
+			normal = closest->normal;
+			depth = std::max(closest->distance, 0.0f);
+			pointA = a.a * u + b.a * v + c.a * w;
+			pointB = a.b * u + b.b * v + c.b * w;
+			return true;
+		}
+
+		// Sorts the points of a face around their center so they form a convex polygon
+		void sortPolygon(glm::vec3 *points, uint count, const glm::vec3 &normal) {
+			if (count < 3) {
+				return;
+			}
+			glm::vec3 center(0.0f);
+			for (uint i = 0; i < count; ++i) {
+				center += points[i];
+			}
+			center /= (f32)count;
+
+			glm::vec3 u = fabsf(normal.x) < 0.57f ? glm::cross(normal, glm::vec3(1.0f, 0.0f, 0.0f)) : glm::cross(normal, glm::vec3(0.0f, 1.0f, 0.0f));
+			u = glm::normalize(u);
+			glm::vec3 v = glm::cross(normal, u);
+			f32 angles[maxFeaturePoints];
+			for (uint i = 0; i < count; ++i) {
+				glm::vec3 offset = points[i] - center;
+				angles[i] = atan2f(glm::dot(offset, v), glm::dot(offset, u));
+			}
+			for (uint i = 1; i < count; ++i) {
+				for (uint j = i; j > 0 && angles[j] < angles[j - 1]; --j) {
+					std::swap(angles[j], angles[j - 1]);
+					std::swap(points[j], points[j - 1]);
+				}
+			}
+		}
+
+		// Feature of a shape in a world space direction, in world space and moved out to the surface by the radius
+		uint getFeature(const CollisionShape &shape, const ShapeTransform &transform, const glm::vec3 &direction, glm::vec3 *points) {
+			glm::vec3 local = glm::conjugate(transform.orientation) * direction;
+			uint count = shape.supportFeature(local, featureTolerance, points, maxFeaturePoints);
+			for (uint i = 0; i < count; ++i) {
+				points[i] = transform.position + transform.orientation * points[i] + direction * shape.getRadius();
+			}
+			return count;
+		}
+
+		// Clips the incident polygon against the side planes of the reference polygon (Sutherland-Hodgman)
+		uint clipPolygon(const glm::vec3 *reference, uint referenceCount, const glm::vec3 &normal, glm::vec3 *points, uint count) {
+			glm::vec3 buffer[maxFeaturePoints * 2 + 8];
+			glm::vec3 center(0.0f);
+			for (uint i = 0; i < referenceCount; ++i) {
+				center += reference[i];
+			}
+			center /= (f32)referenceCount;
+
+			for (uint edge = 0; edge < referenceCount && count > 0; ++edge) {
+				glm::vec3 from = reference[edge], to = reference[(edge + 1) % referenceCount];
+				glm::vec3 side = glm::cross(normal, to - from);
+				if (glm::dot(side, center - from) < 0.0f) {
+					side = -side;
+				}
+
+				if (count == 2) {
+					// A segment only moves its outside end onto the plane
+					f32 distance0 = glm::dot(side, points[0] - from), distance1 = glm::dot(side, points[1] - from);
+					if (distance0 < 0.0f && distance1 < 0.0f) {
+						count = 0;
+					}
+					else if (distance0 < 0.0f) {
+						points[0] += (points[1] - points[0]) * (distance0 / (distance0 - distance1));
+					}
+					else if (distance1 < 0.0f) {
+						points[1] += (points[0] - points[1]) * (distance1 / (distance1 - distance0));
+					}
+					continue;
+				}
+
+				uint clipped = 0;
+				for (uint i = 0; i < count; ++i) {
+					const glm::vec3 &current = points[i], &next = points[(i + 1) % count];
+					f32 currentDistance = glm::dot(side, current - from), nextDistance = glm::dot(side, next - from);
+					if (currentDistance >= 0.0f && clipped < maxFeaturePoints * 2) {
+						buffer[clipped++] = current;
+					}
+					if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f) && clipped < maxFeaturePoints * 2 && count > 1) {
+						buffer[clipped++] = current + (next - current) * (currentDistance / (currentDistance - nextDistance));
+					}
+				}
+				count = clipped;
+				for (uint i = 0; i < count; ++i) {
+					points[i] = buffer[i];
+				}
+			}
+			return count;
+		}
+
+		void addContact(ContactManifold &manifold, const glm::vec3 &position, f32 depth) {
+			manifold.positions[manifold.pointCount] = position;
+			manifold.depths[manifold.pointCount] = depth;
+			++manifold.pointCount;
+		}
+
+		// Keeps the deepest point, the one farthest from it and the two spanning the largest area with those
+		void reduceContacts(const glm::vec3 *points, const f32 *depths, uint count, const glm::vec3 &normal, ContactManifold &manifold) {
+			uint chosen[4];
+			chosen[0] = 0;
+			for (uint i = 1; i < count; ++i) {
+				if (depths[i] > depths[chosen[0]]) {
+					chosen[0] = i;
+				}
+			}
+
+			f32 best = -1.0f;
+			chosen[1] = chosen[0];
+			for (uint i = 0; i < count; ++i) {
+				f32 distance = glm::dot(points[i] - points[chosen[0]], points[i] - points[chosen[0]]);
+				if (distance > best) {
+					best = distance;
+					chosen[1] = i;
+				}
+			}
+
+			f32 most = 0.0f, least = 0.0f;
+			chosen[2] = chosen[3] = chosen[0];
+			for (uint i = 0; i < count; ++i) {
+				f32 area = glm::dot(glm::cross(points[chosen[0]] - points[i], points[chosen[1]] - points[i]), normal);
+				if (area > most) {
+					most = area;
+					chosen[2] = i;
+				}
+				if (area < least) {
+					least = area;
+					chosen[3] = i;
+				}
+			}
+
+			for (uint i = 0; i < 4; ++i) {
+				bool duplicate = false;
+				for (uint j = 0; j < i; ++j) {
+					duplicate |= chosen[j] == chosen[i];
+				}
+				if (!duplicate) {
+					addContact(manifold, points[chosen[i]], depths[chosen[i]]);
+				}
+			}
+		}
+
+		// Face contacts become up to four points, everything else the single point between the closest points
+		void buildManifold(const Pair &pair, const glm::vec3 &normal, f32 depth, f32 margin, const glm::vec3 &pointA, const glm::vec3 &pointB, ContactManifold &manifold) {
+			manifold.normal = normal;
+			manifold.pointCount = 0;
+
+			glm::vec3 featureA[maxFeaturePoints * 2 + 8], featureB[maxFeaturePoints * 2 + 8];
+			uint countA = getFeature(*pair.shapes[0], *pair.transforms[0], normal, featureA);
+			uint countB = getFeature(*pair.shapes[1], *pair.transforms[1], -normal, featureB);
+
+			if (countA >= 3 || countB >= 3) {
+				// The face with more points is the reference, the other feature gets clipped to it
+				bool referenceIsA = countA >= countB;
+				glm::vec3 *reference = referenceIsA ? featureA : featureB, *incident = referenceIsA ? featureB : featureA;
+				uint referenceCount = referenceIsA ? countA : countB, incidentCount = referenceIsA ? countB : countA;
+				glm::vec3 referenceNormal = referenceIsA ? normal : -normal;
+
+				sortPolygon(reference, referenceCount, referenceNormal);
+				// The plane of the face is exact where the normal from GJK or EPA is not, and across a large face
+				// even a small error in the normal adds up to a wrong depth
+				if (referenceCount >= 3) {
+					glm::vec3 faceNormal = glm::cross(reference[1] - reference[0], reference[2] - reference[0]);
+					f32 length = glm::length(faceNormal);
+					if (length > 1e-12f) {
+						faceNormal /= length;
+						referenceNormal = glm::dot(faceNormal, referenceNormal) < 0.0f ? -faceNormal : faceNormal;
+						manifold.normal = referenceIsA ? referenceNormal : -referenceNormal;
+					}
+				}
+				sortPolygon(incident, incidentCount, referenceNormal);
+				uint clipped = clipPolygon(reference, referenceCount, referenceNormal, incident, incidentCount);
+
+				glm::vec3 points[maxFeaturePoints * 2 + 8];
+				f32 depths[maxFeaturePoints * 2 + 8];
+				uint count = 0;
+				for (uint i = 0; i < clipped; ++i) {
+					f32 pointDepth = -glm::dot(incident[i] - reference[0], referenceNormal);
+					// Points apart by less than the margin are kept as well, they only limit how fast the gap closes
+					if (pointDepth >= std::min(depth, -margin) - epaTolerance) {
+						points[count] = incident[i] + referenceNormal * (pointDepth * 0.5f);
+						depths[count] = pointDepth;
+						++count;
+					}
+				}
+
+				if (count > ContactManifold::maxPoints) {
+					reduceContacts(points, depths, count, referenceNormal, manifold);
+				}
+				else {
+					for (uint i = 0; i < count; ++i) {
+						addContact(manifold, points[i], depths[i]);
+					}
+				}
+			}
+
+			if (manifold.pointCount == 0) {
+				manifold.normal = normal;
+				addContact(manifold, (pointA + pointB) * 0.5f, depth);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI bool Narrowphase::closestPoints(const CollisionShape &a, const ShapeTransform &transformA, const CollisionShape &b, const ShapeTransform &transformB, glm::vec3 &pointA, glm::vec3 &pointB) {
+		Pair pair;
+		pair.shapes[0] = &a;
+		pair.shapes[1] = &b;
+		pair.transforms[0] = &transformA;
+		pair.transforms[1] = &transformB;
+		pair.inverses[0] = glm::conjugate(transformA.orientation);
+		pair.inverses[1] = glm::conjugate(transformB.orientation);
+
+		Simplex simplex;
+		return gjk(pair, simplex, pointA, pointB);
+	}
+
+	ENCOSHAREDAPI bool Narrowphase::collide(const CollisionShape &a, const ShapeTransform &transformA, const CollisionShape &b, const ShapeTransform &transformB, ContactManifold &manifold, f32 margin) {
+		Pair pair;
+		pair.shapes[0] = &a;
+		pair.shapes[1] = &b;
+		pair.transforms[0] = &transformA;
+		pair.transforms[1] = &transformB;
+		pair.inverses[0] = glm::conjugate(transformA.orientation);
+		pair.inverses[1] = glm::conjugate(transformB.orientation);
+
+		f32 radius = a.getRadius() + b.getRadius();
+		Simplex simplex;
+		glm::vec3 pointA, pointB, normal;
+		f32 depth;
+		if (gjk(pair, simplex, pointA, pointB)) {
+			glm::vec3 delta = pointB - pointA;
+			f32 distance = glm::length(delta);
+			if (distance > radius + margin) {
+				return false;
+			}
+			// Cores touching at a single point leave no direction, the centers give one
+			if (distance > 1e-6f) {
+				normal = delta / distance;
+			}
+			else {
+				normal = transformB.position - transformA.position;
+				f32 length = glm::length(normal);
+				normal = length > 1e-6f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+			}
+			depth = radius - distance;
+		}
+		else {
+			if (!epa(pair, simplex, normal, depth, pointA, pointB)) {
+				return false;
+			}
+			depth += radius;
+		}
+
+		// From the cores out to the surfaces
+		pointA += normal * a.getRadius();
+		pointB -= normal * b.getRadius();
+		buildManifold(pair, normal, depth, margin, pointA, pointB, manifold);
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#ifndef __ENCOSHARED_NARROWPHASE_H__
+#define __ENCOSHARED_NARROWPHASE_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "CollisionShape.h"
+
+namespace enco {
+	struct ContactManifold {
+		static const uint maxPoints = 4;
+
+		// From the first shape to the second
+		glm::vec3 normal;
+		// Halfway between the surfaces
+		glm::vec3 positions[maxPoints];
+		f32 depths[maxPoints];
+		uint pointCount;
+
+		inline ContactManifold() : normal(0.0f), pointCount(0) {  }
+	};
+
+	// GJK between the shape cores decides whether shapes touch and where, EPA finds the penetration when the cores
+	// overlap. Face and edge contacts are clipped against each other to up to four points so boxes rest stably.
+	class Narrowphase {
+	public:
+		// Closest points of the cores (radius not included), returns false when the cores overlap
+		ENCOSHAREDAPI static bool closestPoints(const CollisionShape &a, const ShapeTransform &transformA, const CollisionShape &b, const ShapeTransform &transformB, glm::vec3 &pointA, glm::vec3 &pointB);
+
+		// Returns true and fills manifold when the shapes are closer than margin
+		ENCOSHAREDAPI static bool collide(const CollisionShape &a, const ShapeTransform &transformA, const CollisionShape &b, const ShapeTransform &transformB, ContactManifold &manifold, f32 margin = 0.0f);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "stdafx.h"
+#include "NavMesh.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const u32 noSlot = 0xFFFFFFFF;
+		// Slot 0xFFFF would make polygon 0xFFFF collide with invalidPolygon
+		const u32 maxSlots = 0xFFFF;
+		const int sideOffsetX[4] = { -1, 0, 1, 0 };
+		const int sideOffsetZ[4] = { 0, 1, 0, -1 };
+
+		// Positive when p is left of the edge from a to b seen from above
+		inline f32 cross2(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &p) {
+			return (b.z - a.z) * (p.x - a.x) - (b.x - a.x) * (p.z - a.z);
+		}
+
+		// Point of the edge from a to b where the coordinate along axis is t
+		inline glm::vec3 pointAt(const glm::vec3 &a, const glm::vec3 &b, uint axis, f32 t) {
+			f32 length = b[axis] - a[axis];
+			return length != 0.0f ? a + (b - a) * ((t - a[axis]) / length) : a;
+		}
+
+		glm::vec3 closestOnPolygon(const NavMeshTile &tile, const NavPolygon &polygon, const glm::vec3 &position) {
+			const glm::vec3 &first = tile.vertices[polygon.vertices[0]];
+			bool inside = true;
+			for (uint i = 0; i < polygon.vertexCount && inside; ++i) {
+				inside = cross2(tile.vertices[polygon.vertices[i]], tile.vertices[polygon.vertices[(i + 1) % polygon.vertexCount]], position) >= 0.0f;
+			}
+
+			if (inside) {
+				// Height from the fan triangle below position
+				for (uint i = 1; i + 1 < polygon.vertexCount; ++i) {
+					const glm::vec3 &b = tile.vertices[polygon.vertices[i]], &c = tile.vertices[polygon.vertices[i + 1]];
+					f32 area = cross2(first, b, c);
+					if (area <= 0.0f || cross2(first, b, position) < 0.0f || cross2(c, first, position) < 0.0f) {
+						continue;
+					}
+					f32 u = cross2(b, c, position) / area, v = cross2(c, first, position) / area;
+					return glm::vec3(position.x, first.y * u + b.y * v + c.y * (1.0f - u - v), position.z);
+				}
+				return glm::vec3(position.x, first.y, position.z);
+			}
+
+			// Closest point on the outline, measured across so a point on a slope keeps its place
+			glm::vec3 best = first;
+			f32 bestDistance = 1e30f;
+			for (uint i = 0; i < polygon.vertexCount; ++i) {
+				const glm::vec3 &a = tile.vertices[polygon.vertices[i]], &b = tile.vertices[polygon.vertices[(i + 1) % polygon.vertexCount]];
+				glm::vec2 edge(b.x - a.x, b.z - a.z), offset(position.x - a.x, position.z - a.z);
+				f32 length = glm::dot(edge, edge);
+				f32 t = length > 0.0f ? glm::clamp(glm::dot(offset, edge) / length, 0.0f, 1.0f) : 0.0f;
+				glm::vec3 point = a + (b - a) * t;
+				f32 distance = (point.x - position.x) * (point.x - position.x) + (point.z - position.z) * (point.z - position.z);
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					best = point;
+				}
+			}
+			return best;
+		}
+	}
+
+	ENCOSHAREDAPI NavMesh::NavMesh(const NavMeshSettings &settings) : m_settings(settings), m_version(0) {
+	}
+
+	ENCOSHAREDAPI NavMesh::~NavMesh() {
+	}
+
+	ENCOSHAREDAPI void NavMesh::getTileCoordinates(const glm::vec3 &position, int &x, int &z) const {
+		f32 tileWidth = m_settings.tileSize * m_settings.cellSize;
+		x = (int)floorf((position.x - m_settings.origin.x) / tileWidth);
+		z = (int)floorf((position.z - m_settings.origin.z) / tileWidth);
+	}
+
+	ENCOSHAREDAPI void NavMesh::setTile(std::shared_ptr<const NavMeshTile> tile) {
+		u32 slot = findSlot(tile->x, tile->z);
+		if (slot == noSlot) {
+			if (!m_freeSlots.empty()) {
+				slot = m_freeSlots.back();
+				m_freeSlots.pop_back();
+			}
+			else if (m_slots.size() < maxSlots) {
+				slot = (u32)m_slots.size();
+				m_slots.push_back(Slot());
+			}
+			else {
+#ifdef _DEBUG
+				printf("Navigation mesh is out of tile slots, tile %d, %d is dropped\n", tile->x, tile->z);
+#endif
+				return;
+			}
+			m_tileSlots[getTileKey(tile->x, tile->z)] = slot;
+		}
+
+		m_slots[slot].tile = tile;
+		++m_version;
+		linkTile(slot);
+		for (uint side = 0; side < 4; ++side) {
+			u32 neighbor = findSlot(tile->x + sideOffsetX[side], tile->z + sideOffsetZ[side]);
+			if (neighbor != noSlot) {
+				linkTile(neighbor);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI void NavMesh::removeTile(int x, int z) {
+		u32 slot = findSlot(x, z);
+		if (slot == noSlot) {
+			return;
+		}
+
+		m_slots[slot] = Slot();
+		m_freeSlots.push_back(slot);
+		m_tileSlots.erase(getTileKey(x, z));
+		++m_version;
+		for (uint side = 0; side < 4; ++side) {
+			u32 neighbor = findSlot(x + sideOffsetX[side], z + sideOffsetZ[side]);
+			if (neighbor != noSlot) {
+				linkTile(neighbor);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI std::shared_ptr<const NavMeshTile> NavMesh::getTile(int x, int z) const {
+		u32 slot = findSlot(x, z);
+		return slot != noSlot ? m_slots[slot].tile : nullptr;
+	}
+
+	u32 NavMesh::findSlot(int x, int z) const {
+		std::unordered_map<u64, u32>::const_iterator it = m_tileSlots.find(getTileKey(x, z));
+		return it != m_tileSlots.end() ? it->second : noSlot;
+	}
+
+	void NavMesh::linkTile(u32 slot) {
+		Slot &target = m_slots[slot];
+		const NavMeshTile &tile = *target.tile;
+		target.links.clear();
+		target.firstLinks.assign(tile.polygons.size() + 1, 0);
+
+		// Edges on a shared border are matched by their overlap along it, the tiles do not have to agree on vertices
+		f32 minOverlap = m_settings.cellSize * 0.1f;
+		for (size_t i = 0; i < tile.polygons.size(); ++i) {
+			target.firstLinks[i] = (u32)target.links.size();
+			const NavPolygon &polygon = tile.polygons[i];
+			for (uint j = 0; j < polygon.vertexCount; ++j) {
+				if (polygon.neighbors[j] < NavMeshTile::borderNeighbor || polygon.neighbors[j] == NavMeshTile::noNeighbor) {
+					continue;
+				}
+				uint side = polygon.neighbors[j] - NavMeshTile::borderNeighbor;
+				u32 otherSlot = findSlot(tile.x + sideOffsetX[side], tile.z + sideOffsetZ[side]);
+				if (otherSlot == noSlot) {
+					continue;
+				}
+
+				const NavMeshTile &other = *m_slots[otherSlot].tile;
+				u16 opposite = (u16)(NavMeshTile::borderNeighbor + ((side + 2) & 3));
+				uint axis = side == 0 || side == 2 ? 2 : 0;
+				const glm::vec3 &a = tile.vertices[polygon.vertices[j]], &b = tile.vertices[polygon.vertices[(j + 1) % polygon.vertexCount]];
+				f32 minimum = std::min(a[axis], b[axis]), maximum = std::max(a[axis], b[axis]);
+
+				for (size_t k = 0; k < other.polygons.size(); ++k) {
+					const NavPolygon &candidate = other.polygons[k];
+					for (uint l = 0; l < candidate.vertexCount; ++l) {
+						if (candidate.neighbors[l] != opposite) {
+							continue;
+						}
+						const glm::vec3 &c = other.vertices[candidate.vertices[l]], &d = other.vertices[candidate.vertices[(l + 1) % candidate.vertexCount]];
+						f32 lower = std::max(minimum, std::min(c[axis], d[axis])), upper = std::min(maximum, std::max(c[axis], d[axis]));
+						if (upper - lower < minOverlap) {
+							continue;
+						}
+						glm::vec3 lowerPoint = pointAt(a, b, axis, lower), upperPoint = pointAt(a, b, axis, upper);
+						if (fabsf(lowerPoint.y - pointAt(c, d, axis, lower).y) > m_settings.agentClimb || fabsf(upperPoint.y - pointAt(c, d, axis, upper).y) > m_settings.agentClimb) {
+							continue;
+						}
+
+						Link link;
+						link.target = (otherSlot << 16) | (u32)k;
+						// Seen from inside, the end of the edge towards b is on the left
+						bool ascending = b[axis] > a[axis];
+						link.left = ascending ? upperPoint : lowerPoint;
+						link.right = ascending ? lowerPoint : upperPoint;
+						target.links.push_back(link);
+					}
+				}
+			}
+		}
+		target.firstLinks[tile.polygons.size()] = (u32)target.links.size();
+	}
+
+	ENCOSHAREDAPI NavPolygonRef NavMesh::findNearestPolygon(const glm::vec3 &position, const glm::vec3 &extents, glm::vec3 &nearest) const {
+		int minX, minZ, maxX, maxZ;
+		getTileCoordinates(position - extents, minX, minZ);
+		getTileCoordinates(position + extents, maxX, maxZ);
+
+		NavPolygonRef best = invalidPolygon;
+		f32 bestDistance = 1e30f;
+		for (int z = minZ; z <= maxZ; ++z) {
+			for (int x = minX; x <= maxX; ++x) {
+				u32 slot = findSlot(x, z);
+				if (slot == noSlot) {
+					continue;
+				}
+				const NavMeshTile &tile = *m_slots[slot].tile;
+				if (position.y + extents.y < tile.bounds.min.y || position.y - extents.y > tile.bounds.max.y) {
+					continue;
+				}
+
+				for (size_t i = 0; i < tile.polygons.size(); ++i) {
+					glm::vec3 point = closestOnPolygon(tile, tile.polygons[i], position);
+					glm::vec3 offset = glm::abs(point - position);
+					if (offset.x > extents.x || offset.y > extents.y || offset.z > extents.z) {
+						continue;
+					}
+					f32 distance = glm::dot(offset, offset);
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						best = (slot << 16) | (u32)i;
+						nearest = point;
+					}
+				}
+			}
+		}
+		return best;
+	}
+
+	ENCOSHAREDAPI glm::vec3 NavMesh::getClosestPoint(NavPolygonRef polygon, const glm::vec3 &position) const {
+		return closestOnPolygon(getTileOf(polygon), getPolygon(polygon), position);
+	}
+
+	ENCOSHAREDAPI glm::vec3 NavMesh::getCenter(NavPolygonRef polygon) const {
+		const NavMeshTile &tile = getTileOf(polygon);
+		const NavPolygon &source = getPolygon(polygon);
+		glm::vec3 center(0.0f);
+		for (uint i = 0; i < source.vertexCount; ++i) {
+			center += tile.vertices[source.vertices[i]];
+		}
+		return center / (f32)source.vertexCount;
+	}
+
+	ENCOSHAREDAPI bool NavMesh::getPortal(NavPolygonRef from, NavPolygonRef to, glm::vec3 &left, glm::vec3 &right) const {
+		bool found = false;
+		auto match = [to, &left, &right, &found](NavPolygonRef neighbor, const glm::vec3 &neighborLeft, const glm::vec3 &neighborRight) {
+			if (neighbor == to && !found) {
+				left = neighborLeft;
+				right = neighborRight;
+				found = true;
+			}
+		};
+		forEachNeighbor(from, match);
+		return found;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef __ENCOSHARED_NAVMESH_H__
+#define __ENCOSHARED_NAVMESH_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	// Tile in the upper 16 bits, polygon in the tile in the lower ones
+	typedef u32 NavPolygonRef;
+
+	struct NavMeshSettings {
+		// Voxel size across and up
+		f32 cellSize;
+		f32 cellHeight;
+		f32 agentHeight;
+		f32 agentRadius;
+		// Highest step the agent walks up
+		f32 agentClimb;
+		// Steepest walkable slope in degrees
+		f32 maxSlope;
+		// How far simplified walls may stray from the voxel outline
+		f32 maxEdgeError;
+		// Cells along a side of a tile
+		uint tileSize;
+		// Corner of tile 0, 0
+		glm::vec3 origin;
+
+		inline NavMeshSettings() : cellSize(0.3f), cellHeight(0.2f), agentHeight(2.0f), agentRadius(0.6f), agentClimb(0.9f), maxSlope(45.0f), maxEdgeError(1.3f), tileSize(64), origin(0.0f) {  }
+	};
+
+	// Convex, the vertices wind counter-clockwise seen from above
+	struct NavPolygon {
+		static const uint maxVertices = 6;
+
+		u16 vertices[maxVertices];
+		// Polygon of the same tile behind each edge, NavMeshTile::noNeighbor or NavMeshTile::borderNeighbor + side
+		u16 neighbors[maxVertices];
+		u8 vertexCount;
+	};
+
+	struct NavMeshTile {
+		static const u16 noNeighbor = 0xFFFF;
+		// Sides are 0 = -x, 1 = +z, 2 = +x, 3 = -z
+		static const u16 borderNeighbor = 0xFFF0;
+
+		int x, z;
+		std::vector<glm::vec3> vertices;
+		std::vector<NavPolygon> polygons;
+		AABB bounds;
+	};
+
+	// Tiles of polygons the agents walk on, see NavMeshBuilder. Tiles that touch are linked across their shared
+	// border, so tiles may be rebuilt and replaced one at a time while the game runs. Only reads are thread safe.
+	class NavMesh {
+	public:
+		static const NavPolygonRef invalidPolygon = 0xFFFFFFFF;
+
+		ENCOSHAREDAPI NavMesh(const NavMeshSettings &settings = NavMeshSettings());
+		ENCOSHAREDAPI ~NavMesh();
+
+		inline const NavMeshSettings &getSettings() const { return m_settings; }
+		ENCOSHAREDAPI void getTileCoordinates(const glm::vec3 &position, int &x, int &z) const;
+
+		// Replaces the tile at tile->x, tile->z, references to polygons of the old tile become invalid
+		ENCOSHAREDAPI void setTile(std::shared_ptr<const NavMeshTile> tile);
+		ENCOSHAREDAPI void removeTile(int x, int z);
+		ENCOSHAREDAPI std::shared_ptr<const NavMeshTile> getTile(int x, int z) const;
+		inline uint getTileCount() const { return (uint)m_tileSlots.size(); }
+		// Changes with every setTile and removeTile
+		inline u32 getVersion() const { return m_version; }
+
+		// Polygon closest to position within extents on each axis, nearest is the closest point on it
+		ENCOSHAREDAPI NavPolygonRef findNearestPolygon(const glm::vec3 &position, const glm::vec3 &extents, glm::vec3 &nearest) const;
+		ENCOSHAREDAPI glm::vec3 getClosestPoint(NavPolygonRef polygon, const glm::vec3 &position) const;
+		ENCOSHAREDAPI glm::vec3 getCenter(NavPolygonRef polygon) const;
+
+		// Calls callback(neighbor, left, right) for every polygon that can be entered from polygon, left and right
+		// are the ends of the shared edge seen from inside polygon
+		template<typename Callback>
+		void forEachNeighbor(NavPolygonRef polygon, Callback &callback) const {
+			const Slot &slot = m_slots[polygon >> 16];
+			u32 index = polygon & 0xFFFF;
+			const NavPolygon &source = slot.tile->polygons[index];
+			for (uint i = 0; i < source.vertexCount; ++i) {
+				if (source.neighbors[i] < NavMeshTile::borderNeighbor) {
+					const glm::vec3 &a = slot.tile->vertices[source.vertices[i]], &b = slot.tile->vertices[source.vertices[(i + 1) % source.vertexCount]];
+					callback((polygon & 0xFFFF0000) | source.neighbors[i], b, a);
+				}
+			}
+			for (u32 i = slot.firstLinks[index]; i < slot.firstLinks[index + 1]; ++i) {
+				const Link &link = slot.links[i];
+				callback(link.target, link.left, link.right);
+			}
+		}
+
+		// Shared edge of two polygons that forEachNeighbor reports, false when they are not neighbors
+		ENCOSHAREDAPI bool getPortal(NavPolygonRef from, NavPolygonRef to, glm::vec3 &left, glm::vec3 &right) const;
+
+		inline bool isValid(NavPolygonRef polygon) const { return (polygon >> 16) < m_slots.size() && m_slots[polygon >> 16].tile && (polygon & 0xFFFF) < m_slots[polygon >> 16].tile->polygons.size(); }
+		inline const NavMeshTile &getTileOf(NavPolygonRef polygon) const { return *m_slots[polygon >> 16].tile; }
+		inline const NavPolygon &getPolygon(NavPolygonRef polygon) const { return m_slots[polygon >> 16].tile->polygons[polygon & 0xFFFF]; }
+
+	private:
+		// Edge of a polygon on the tile border crossing into a polygon of the neighboring tile
+		struct Link {
+			NavPolygonRef target;
+			glm::vec3 left, right;
+		};
+
+		struct Slot {
+			std::shared_ptr<const NavMeshTile> tile;
+			// Links of polygon i are [firstLinks[i], firstLinks[i + 1])
+			std::vector<u32> firstLinks;
+			std::vector<Link> links;
+		};
+
+		NavMesh(const NavMesh &) = delete;
+		NavMesh &operator=(const NavMesh &) = delete;
+
+		static inline u64 getTileKey(int x, int z) { return ((u64)(u32)x << 32) | (u32)z; }
+		u32 findSlot(int x, int z) const;
+		void linkTile(u32 slot);
+
+		NavMeshSettings m_settings;
+		std::vector<Slot> m_slots;
+		std::vector<u32> m_freeSlots;
+		std::unordered_map<u64, u32> m_tileSlots;
+		u32 m_version;
+	};
+}
+
+#endif
\ No newline at end of file
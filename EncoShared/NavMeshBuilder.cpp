@@ -0,0 +1,980 @@
+#include "stdafx.h"
+#include "NavMeshBuilder.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace enco {
+	namespace {
+		const u32 noSpan = 0xFFFFFFFF;
+		const u8 notConnected = 0xFF;
+		const u16 noRegion = 0;
+		// Walkable spans in the padding around the tile, their outlines are tile borders
+		const u16 borderRegion = 0x8000;
+		const u16 nullNeighbor = 0xFFFF;
+		const uint maxClipVertices = 12;
+		const uint maxContourIterations = 40000;
+		// Directions are 0 = -x, 1 = +z, 2 = +x, 3 = -z like the tile sides
+		const int offsetX[4] = { -1, 0, 1, 0 };
+		const int offsetZ[4] = { 0, 1, 0, -1 };
+
+		struct SolidSpan {
+			u16 min, max;
+			bool walkable;
+			u32 next;
+		};
+
+		// Solid spans per column, each list sorted from the bottom up
+		struct Heightfield {
+			int width, depth, height;
+			glm::vec3 min;
+			f32 cellSize, cellHeight;
+			std::vector<u32> columns;
+			std::vector<SolidSpan> spans;
+
+			inline u32 top(u32 span) const { return spans[span].next != noSpan ? spans[spans[span].next].min : 0xFFFF; }
+		};
+
+		// The open space above a walkable solid span
+		struct OpenSpan {
+			u16 y;
+			u16 clearance;
+			u16 region;
+			// Distance to the closest edge in half cells, for erosion
+			u8 distance;
+			bool walkable;
+			// Layer of the connected span in the neighboring column
+			u8 connections[4];
+		};
+
+		struct OpenHeightfield {
+			int width, depth;
+			std::vector<u32> first;
+			std::vector<u8> counts;
+			std::vector<OpenSpan> spans;
+
+			inline u32 getNeighbor(int x, int z, u32 span, uint direction) const {
+				u8 layer = spans[span].connections[direction];
+				return layer != notConnected ? first[(z + offsetZ[direction]) * width + x + offsetX[direction]] + layer : noSpan;
+			}
+		};
+
+		struct ContourPoint {
+			int x, y, z;
+			// Region across the edge that ends at this point, or the raw point a simplified one came from
+			u32 tag;
+		};
+
+		inline int cross2(const ContourPoint &a, const ContourPoint &b, const ContourPoint &p) {
+			return (b.z - a.z) * (p.x - a.x) - (b.x - a.x) * (p.z - a.z);
+		}
+
+		void addSpan(Heightfield &field, int x, int z, u16 minimum, u16 maximum, bool walkable, int mergeThreshold) {
+			u32 &column = field.columns[z * field.width + x];
+			u32 previous = noSpan, current = column;
+			while (current != noSpan) {
+				SolidSpan &span = field.spans[current];
+				if (span.min > maximum) {
+					break;
+				}
+				if (span.max < minimum) {
+					previous = current;
+					current = span.next;
+					continue;
+				}
+
+				// Overlapping spans merge, the surface on top decides whether the merged one is walkable
+				if (span.max > maximum + mergeThreshold) {
+					walkable = span.walkable;
+				}
+				else if (span.max + mergeThreshold >= maximum) {
+					walkable = walkable || span.walkable;
+				}
+				minimum = std::min(minimum, span.min);
+				maximum = std::max(maximum, span.max);
+				current = span.next;
+				if (previous != noSpan) {
+					field.spans[previous].next = current;
+				}
+				else {
+					column = current;
+				}
+			}
+
+			SolidSpan span;
+			span.min = minimum;
+			span.max = maximum;
+			span.walkable = walkable;
+			span.next = current;
+			field.spans.push_back(span);
+			if (previous != noSpan) {
+				field.spans[previous].next = (u32)field.spans.size() - 1;
+			}
+			else {
+				column = (u32)field.spans.size() - 1;
+			}
+		}
+
+		// Splits polygon at coordinate value along axis into the part below and the part above
+		void dividePolygon(const glm::vec3 *polygon, uint count, glm::vec3 *below, uint &belowCount, glm::vec3 *above, uint &aboveCount, f32 value, uint axis) {
+			f32 distances[maxClipVertices];
+			for (uint i = 0; i < count; ++i) {
+				distances[i] = value - polygon[i][axis];
+			}
+
+			belowCount = aboveCount = 0;
+			for (uint i = 0, j = count - 1; i < count; j = i, ++i) {
+				bool previousBelow = distances[j] >= 0.0f, currentBelow = distances[i] >= 0.0f;
+				if (previousBelow != currentBelow) {
+					f32 s = distances[j] / (distances[j] - distances[i]);
+					glm::vec3 crossing = polygon[j] + (polygon[i] - polygon[j]) * s;
+					below[belowCount++] = crossing;
+					above[aboveCount++] = crossing;
+					// Points on the line were added as the crossing
+					if (distances[i] > 0.0f) {
+						below[belowCount++] = polygon[i];
+					}
+					else if (distances[i] < 0.0f) {
+						above[aboveCount++] = polygon[i];
+					}
+				}
+				else {
+					if (distances[i] >= 0.0f) {
+						below[belowCount++] = polygon[i];
+						if (distances[i] != 0.0f) {
+							continue;
+						}
+					}
+					above[aboveCount++] = polygon[i];
+				}
+			}
+		}
+
+		void rasterizeTriangle(Heightfield &field, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, bool walkable, int mergeThreshold) {
+			glm::vec3 minimum = glm::min(a, glm::min(b, c)), maximum = glm::max(a, glm::max(b, c));
+			glm::vec3 fieldMax = field.min + glm::vec3(field.width * field.cellSize, field.height * field.cellHeight, field.depth * field.cellSize);
+			if (minimum.x > fieldMax.x || maximum.x < field.min.x || minimum.z > fieldMax.z || maximum.z < field.min.z) {
+				return;
+			}
+
+			// Rows and then cells are cut off the triangle one at a time, -1 skips the part before the field
+			f32 inverseCellSize = 1.0f / field.cellSize, inverseCellHeight = 1.0f / field.cellHeight;
+			int z0 = glm::clamp((int)floorf((minimum.z - field.min.z) * inverseCellSize), -1, field.depth - 1);
+			int z1 = glm::clamp((int)floorf((maximum.z - field.min.z) * inverseCellSize), -1, field.depth - 1);
+			glm::vec3 polygon[maxClipVertices], row[maxClipVertices], cell[maxClipVertices], rest[maxClipVertices];
+			uint polygonCount = 3, rowCount, cellCount, restCount;
+			polygon[0] = a;
+			polygon[1] = b;
+			polygon[2] = c;
+
+			for (int z = z0; z <= z1; ++z) {
+				dividePolygon(polygon, polygonCount, row, rowCount, rest, restCount, field.min.z + (z + 1) * field.cellSize, 2);
+				for (uint i = 0; i < restCount; ++i) {
+					polygon[i] = rest[i];
+				}
+				polygonCount = restCount;
+				if (rowCount < 3 || z < 0) {
+					continue;
+				}
+
+				f32 rowMin = row[0].x, rowMax = row[0].x;
+				for (uint i = 1; i < rowCount; ++i) {
+					rowMin = std::min(rowMin, row[i].x);
+					rowMax = std::max(rowMax, row[i].x);
+				}
+				int x0 = glm::clamp((int)floorf((rowMin - field.min.x) * inverseCellSize), -1, field.width - 1);
+				int x1 = glm::clamp((int)floorf((rowMax - field.min.x) * inverseCellSize), -1, field.width - 1);
+
+				for (int x = x0; x <= x1; ++x) {
+					dividePolygon(row, rowCount, cell, cellCount, rest, restCount, field.min.x + (x + 1) * field.cellSize, 0);
+					for (uint i = 0; i < restCount; ++i) {
+						row[i] = rest[i];
+					}
+					rowCount = restCount;
+					if (cellCount < 3 || x < 0) {
+						continue;
+					}
+
+					f32 bottom = cell[0].y, top = cell[0].y;
+					for (uint i = 1; i < cellCount; ++i) {
+						bottom = std::min(bottom, cell[i].y);
+						top = std::max(top, cell[i].y);
+					}
+					bottom -= field.min.y;
+					top -= field.min.y;
+					if (top < 0.0f || bottom > field.height * field.cellHeight) {
+						continue;
+					}
+					int spanMin = glm::clamp((int)floorf(bottom * inverseCellHeight), 0, field.height - 1);
+					int spanMax = glm::clamp((int)ceilf(top * inverseCellHeight), spanMin + 1, field.height);
+					addSpan(field, x, z, (u16)spanMin, (u16)spanMax, walkable, mergeThreshold);
+				}
+			}
+		}
+
+		// Curbs and stair edges sticking out of a walkable surface by less than a step are walkable too
+		void filterLowObstacles(Heightfield &field, int climb) {
+			for (size_t i = 0; i < field.columns.size(); ++i) {
+				bool previousWalkable = false;
+				int previousMax = 0;
+				for (u32 span = field.columns[i]; span != noSpan; span = field.spans[span].next) {
+					SolidSpan &current = field.spans[span];
+					bool walkable = current.walkable;
+					if (!walkable && previousWalkable && abs((int)current.max - previousMax) <= climb) {
+						current.walkable = true;
+					}
+					previousWalkable = walkable;
+					previousMax = current.max;
+				}
+			}
+		}
+
+		// Spans next to a drop higher than a step, or on a slope steeper than one across their neighbors
+		void filterLedges(Heightfield &field, int agentHeight, int climb) {
+			for (int z = 0; z < field.depth; ++z) {
+				for (int x = 0; x < field.width; ++x) {
+					for (u32 span = field.columns[z * field.width + x]; span != noSpan; span = field.spans[span].next) {
+						SolidSpan &current = field.spans[span];
+						if (!current.walkable) {
+							continue;
+						}
+
+						int bottom = current.max, top = (int)field.top(span);
+						int minDrop = 0xFFFF, accessibleMin = bottom, accessibleMax = bottom;
+						for (uint direction = 0; direction < 4; ++direction) {
+							int nx = x + offsetX[direction], nz = z + offsetZ[direction];
+							if (nx < 0 || nz < 0 || nx >= field.width || nz >= field.depth) {
+								minDrop = std::min(minDrop, -climb - bottom);
+								continue;
+							}
+
+							// The open space below the lowest span of the neighbor counts as a drop as well
+							u32 neighbor = field.columns[nz * field.width + nx];
+							int neighborTop = neighbor != noSpan ? field.spans[neighbor].min : 0xFFFF;
+							if (std::min(top, neighborTop) - std::max(bottom, -climb) > agentHeight) {
+								minDrop = std::min(minDrop, -climb - bottom);
+							}
+							for (; neighbor != noSpan; neighbor = field.spans[neighbor].next) {
+								int neighborBottom = field.spans[neighbor].max;
+								neighborTop = (int)field.top(neighbor);
+								if (std::min(top, neighborTop) - std::max(bottom, neighborBottom) > agentHeight) {
+									minDrop = std::min(minDrop, neighborBottom - bottom);
+									if (abs(neighborBottom - bottom) <= climb) {
+										accessibleMin = std::min(accessibleMin, neighborBottom);
+										accessibleMax = std::max(accessibleMax, neighborBottom);
+									}
+								}
+							}
+						}
+
+						if (minDrop < -climb || accessibleMax - accessibleMin > climb) {
+							current.walkable = false;
+						}
+					}
+				}
+			}
+		}
+
+		void filterLowCeilings(Heightfield &field, int agentHeight) {
+			for (size_t i = 0; i < field.spans.size(); ++i) {
+				if (field.spans[i].walkable && (int)field.top((u32)i) - field.spans[i].max < agentHeight) {
+					field.spans[i].walkable = false;
+				}
+			}
+		}
+
+		void buildOpenHeightfield(const Heightfield &field, int agentHeight, int climb, OpenHeightfield &open) {
+			open.width = field.width;
+			open.depth = field.depth;
+			open.first.resize(field.columns.size());
+			open.counts.resize(field.columns.size());
+			for (size_t i = 0; i < field.columns.size(); ++i) {
+				open.first[i] = (u32)open.spans.size();
+				for (u32 span = field.columns[i]; span != noSpan && open.spans.size() - open.first[i] < notConnected; span = field.spans[span].next) {
+					if (!field.spans[span].walkable) {
+						continue;
+					}
+					OpenSpan spanAbove;
+					spanAbove.y = field.spans[span].max;
+					spanAbove.clearance = (u16)std::min((int)field.top(span) - (int)field.spans[span].max, 0xFFFF);
+					spanAbove.region = noRegion;
+					spanAbove.distance = 0xFF;
+					spanAbove.walkable = true;
+					for (uint direction = 0; direction < 4; ++direction) {
+						spanAbove.connections[direction] = notConnected;
+					}
+					open.spans.push_back(spanAbove);
+				}
+				open.counts[i] = (u8)(open.spans.size() - open.first[i]);
+			}
+
+			// Neighbors are connected when the agent fits through the opening between them and can step across
+			for (int z = 0; z < open.depth; ++z) {
+				for (int x = 0; x < open.width; ++x) {
+					u32 column = z * open.width + x;
+					for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+						OpenSpan &current = open.spans[span];
+						for (uint direction = 0; direction < 4; ++direction) {
+							int nx = x + offsetX[direction], nz = z + offsetZ[direction];
+							if (nx < 0 || nz < 0 || nx >= open.width || nz >= open.depth) {
+								continue;
+							}
+							u32 neighborColumn = nz * open.width + nx;
+							for (u32 layer = 0; layer < open.counts[neighborColumn]; ++layer) {
+								const OpenSpan &neighbor = open.spans[open.first[neighborColumn] + layer];
+								int bottom = std::max(current.y, neighbor.y);
+								int top = std::min((int)current.y + current.clearance, (int)neighbor.y + neighbor.clearance);
+								if (top - bottom >= agentHeight && abs((int)neighbor.y - (int)current.y) <= climb) {
+									current.connections[direction] = (u8)layer;
+									break;
+								}
+							}
+						}
+					}
+				}
+			}
+		}
+
+		// Chamfer distance to the closest span that is not surrounded on all sides, spans closer than the agent
+		// radius are removed
+		void erode(OpenHeightfield &open, int radius) {
+			for (int z = 0; z < open.depth; ++z) {
+				for (int x = 0; x < open.width; ++x) {
+					u32 column = z * open.width + x;
+					for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+						uint connected = 0;
+						for (uint direction = 0; direction < 4; ++direction) {
+							connected += open.spans[span].connections[direction] != notConnected ? 1 : 0;
+						}
+						if (connected != 4) {
+							open.spans[span].distance = 0;
+						}
+					}
+				}
+			}
+
+			// Forward pass looks at -x and -z, the backward pass at +x and +z, diagonals through the neighbor
+			for (int pass = 0; pass < 2; ++pass) {
+				uint straight = pass == 0 ? 0 : 2, next = pass == 0 ? 3 : 1;
+				for (int step = 0; step < open.depth; ++step) {
+					int z = pass == 0 ? step : open.depth - 1 - step;
+					for (int stepX = 0; stepX < open.width; ++stepX) {
+						int x = pass == 0 ? stepX : open.width - 1 - stepX;
+						u32 column = z * open.width + x;
+						for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+							int distance = open.spans[span].distance;
+							const uint directions[2] = { straight, next };
+							for (uint i = 0; i < 2; ++i) {
+								uint direction = directions[i];
+								u32 neighbor = open.getNeighbor(x, z, span, direction);
+								if (neighbor == noSpan) {
+									continue;
+								}
+								distance = std::min(distance, open.spans[neighbor].distance + 2);
+								// The diagonal turns the same way as the other direction of the pass
+								uint turn = i == 0 ? next : (pass == 0 ? 2 : 0);
+								u32 diagonal = open.getNeighbor(x + offsetX[direction], z + offsetZ[direction], neighbor, turn);
+								if (diagonal != noSpan) {
+									distance = std::min(distance, open.spans[diagonal].distance + 3);
+								}
+							}
+							open.spans[span].distance = (u8)distance;
+						}
+					}
+				}
+			}
+
+			int threshold = radius * 2;
+			for (size_t i = 0; i < open.spans.size(); ++i) {
+				if (open.spans[i].distance < threshold) {
+					open.spans[i].walkable = false;
+				}
+			}
+		}
+
+		// Sweeps every row: a run of connected spans joins the region below it when it is the only run touching
+		// that region, which keeps every region free of holes
+		void buildRegions(OpenHeightfield &open, int border) {
+			for (int z = 0; z < open.depth; ++z) {
+				for (int x = 0; x < open.width; ++x) {
+					if (x >= border && z >= border && x < open.width - border && z < open.depth - border) {
+						continue;
+					}
+					u32 column = z * open.width + x;
+					for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+						if (open.spans[span].walkable) {
+							open.spans[span].region = borderRegion;
+						}
+					}
+				}
+			}
+
+			struct Sweep {
+				u16 region, neighbor, neighborCount;
+			};
+			std::vector<Sweep> sweeps;
+			std::vector<u16> previous;
+			u16 nextRegion = 1;
+			for (int z = border; z < open.depth - border; ++z) {
+				previous.assign(nextRegion, 0);
+				sweeps.assign(1, Sweep());
+
+				for (int x = border; x < open.width - border; ++x) {
+					u32 column = z * open.width + x;
+					for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+						OpenSpan &current = open.spans[span];
+						if (!current.walkable) {
+							continue;
+						}
+
+						u16 sweep = 0;
+						u32 left = x > border ? open.getNeighbor(x, z, span, 0) : noSpan;
+						if (left != noSpan && open.spans[left].walkable) {
+							sweep = open.spans[left].region;
+						}
+						if (sweep == 0) {
+							sweep = (u16)sweeps.size();
+							Sweep created = { 0, 0, 0 };
+							sweeps.push_back(created);
+						}
+
+						u32 below = z > border ? open.getNeighbor(x, z, span, 3) : noSpan;
+						if (below != noSpan && open.spans[below].walkable && open.spans[below].region != noRegion) {
+							u16 region = open.spans[below].region;
+							if (sweeps[sweep].neighbor == 0 || sweeps[sweep].neighbor == region) {
+								sweeps[sweep].neighbor = region;
+								++sweeps[sweep].neighborCount;
+								++previous[region];
+							}
+							else {
+								sweeps[sweep].neighbor = nullNeighbor;
+							}
+						}
+						current.region = sweep;
+					}
+				}
+
+				for (size_t i = 1; i < sweeps.size(); ++i) {
+					Sweep &sweep = sweeps[i];
+					if (sweep.neighbor != nullNeighbor && sweep.neighbor != 0 && previous[sweep.neighbor] == sweep.neighborCount) {
+						sweep.region = sweep.neighbor;
+					}
+					else if (nextRegion < borderRegion - 1) {
+						sweep.region = nextRegion++;
+					}
+					else {
+						sweep.region = noRegion;
+					}
+				}
+
+				for (int x = border; x < open.width - border; ++x) {
+					u32 column = z * open.width + x;
+					for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+						if (open.spans[span].walkable) {
+							open.spans[span].region = sweeps[open.spans[span].region].region;
+						}
+					}
+				}
+			}
+		}
+
+		// Highest floor of the four spans around the corner a contour point is on
+		int getCornerHeight(const OpenHeightfield &open, int x, int z, u32 span, uint direction) {
+			uint next = (direction + 1) & 3;
+			int height = open.spans[span].y;
+			u32 a = open.getNeighbor(x, z, span, direction);
+			if (a != noSpan) {
+				height = std::max(height, (int)open.spans[a].y);
+				u32 diagonal = open.getNeighbor(x + offsetX[direction], z + offsetZ[direction], a, next);
+				if (diagonal != noSpan) {
+					height = std::max(height, (int)open.spans[diagonal].y);
+				}
+			}
+			u32 b = open.getNeighbor(x, z, span, next);
+			if (b != noSpan) {
+				height = std::max(height, (int)open.spans[b].y);
+				u32 diagonal = open.getNeighbor(x + offsetX[next], z + offsetZ[next], b, direction);
+				if (diagonal != noSpan) {
+					height = std::max(height, (int)open.spans[diagonal].y);
+				}
+			}
+			return height;
+		}
+
+		// Follows the outline of a region clockwise around the cells, which is counter-clockwise seen from above
+		void walkContour(const OpenHeightfield &open, int x, int z, u32 span, std::vector<u8> &edges, std::vector<ContourPoint> &points) {
+			uint direction = 0;
+			while (!(edges[span] & (1 << direction))) {
+				++direction;
+			}
+			u32 start = span;
+			uint startDirection = direction;
+
+			for (uint iteration = 0; iteration < maxContourIterations; ++iteration) {
+				if (edges[span] & (1 << direction)) {
+					ContourPoint point;
+					point.x = x + (direction == 1 || direction == 2 ? 1 : 0);
+					point.y = getCornerHeight(open, x, z, span, direction);
+					point.z = z + (direction == 0 || direction == 1 ? 1 : 0);
+					u32 neighbor = open.getNeighbor(x, z, span, direction);
+					point.tag = neighbor != noSpan && open.spans[neighbor].walkable ? open.spans[neighbor].region : noRegion;
+					points.push_back(point);
+					edges[span] &= ~(1 << direction);
+					direction = (direction + 1) & 3;
+				}
+				else {
+					u32 neighbor = open.getNeighbor(x, z, span, direction);
+					if (neighbor == noSpan) {
+						return;
+					}
+					x += offsetX[direction];
+					z += offsetZ[direction];
+					span = neighbor;
+					direction = (direction + 3) & 3;
+				}
+				if (span == start && direction == startDirection) {
+					return;
+				}
+			}
+		}
+
+		f32 distanceToSegment(int x, int z, int ax, int az, int bx, int bz) {
+			f32 dx = (f32)(bx - ax), dz = (f32)(bz - az);
+			f32 length = dx * dx + dz * dz;
+			f32 t = length > 0.0f ? glm::clamp(((x - ax) * dx + (z - az) * dz) / length, 0.0f, 1.0f) : 0.0f;
+			f32 px = ax + t * dx - x, pz = az + t * dz - z;
+			return px * px + pz * pz;
+		}
+
+		// Keeps the points where the region on the other side changes, so neighboring regions share their
+		// vertices, and the corners of the tile. Adds points back until no part of the outline strays further than
+		// maxError.
+		void simplifyContour(const std::vector<ContourPoint> &points, f32 maxError, int borderMin, int borderMax, std::vector<ContourPoint> &simplified) {
+			uint count = (uint)points.size();
+			for (uint i = 0; i < count; ++i) {
+				bool corner = (points[i].x == borderMin || points[i].x == borderMax) && (points[i].z == borderMin || points[i].z == borderMax);
+				if (corner || points[i].tag != points[(i + 1) % count].tag) {
+					ContourPoint point = points[i];
+					point.tag = i;
+					simplified.push_back(point);
+				}
+			}
+
+			if (simplified.empty()) {
+				// Only walls around, start from the lower left and upper right corners
+				uint lowerLeft = 0, upperRight = 0;
+				for (uint i = 1; i < count; ++i) {
+					if (points[i].x < points[lowerLeft].x || (points[i].x == points[lowerLeft].x && points[i].z < points[lowerLeft].z)) {
+						lowerLeft = i;
+					}
+					if (points[i].x > points[upperRight].x || (points[i].x == points[upperRight].x && points[i].z > points[upperRight].z)) {
+						upperRight = i;
+					}
+				}
+				ContourPoint point = points[lowerLeft];
+				point.tag = lowerLeft;
+				simplified.push_back(point);
+				point = points[upperRight];
+				point.tag = upperRight;
+				simplified.push_back(point);
+			}
+
+			f32 maxDistance = maxError * maxError;
+			for (size_t i = 0; i < simplified.size();) {
+				size_t next = (i + 1) % simplified.size();
+				int ax = simplified[i].x, az = simplified[i].z, bx = simplified[next].x, bz = simplified[next].z;
+				uint a = simplified[i].tag, b = simplified[next].tag;
+
+				// Walked in the same order from both ends, so the two regions along a segment would pick the same point
+				uint current, step, end;
+				if (bx > ax || (bx == ax && bz > az)) {
+					step = 1;
+					current = (a + 1) % count;
+					end = b;
+				}
+				else {
+					step = count - 1;
+					current = (b + step) % count;
+					end = a;
+					std::swap(ax, bx);
+					std::swap(az, bz);
+				}
+
+				f32 worst = 0.0f;
+				uint worstIndex = count;
+				for (; current != end; current = (current + step) % count) {
+					f32 distance = distanceToSegment(points[current].x, points[current].z, ax, az, bx, bz);
+					if (distance > worst) {
+						worst = distance;
+						worstIndex = current;
+					}
+				}
+
+				if (worstIndex != count && worst > maxDistance) {
+					ContourPoint point = points[worstIndex];
+					point.tag = worstIndex;
+					simplified.insert(simplified.begin() + i + 1, point);
+				}
+				else {
+					++i;
+				}
+			}
+
+			for (size_t i = 0; i < simplified.size() && simplified.size() > 1;) {
+				const ContourPoint &point = simplified[i], &next = simplified[(i + 1) % simplified.size()];
+				if (point.x == next.x && point.z == next.z) {
+					simplified.erase(simplified.begin() + i);
+				}
+				else {
+					++i;
+				}
+			}
+		}
+
+		// Ear clipping, collinear points stay as corners of the triangles next to them
+		bool triangulate(const std::vector<ContourPoint> &points, std::vector<u32> &triangles) {
+			std::vector<u32> remaining(points.size());
+			for (size_t i = 0; i < remaining.size(); ++i) {
+				remaining[i] = (u32)i;
+			}
+
+			while (remaining.size() > 3) {
+				size_t count = remaining.size();
+				bool clipped = false;
+				for (size_t i = 0; i < count && !clipped; ++i) {
+					u32 previous = remaining[(i + count - 1) % count], current = remaining[i], next = remaining[(i + 1) % count];
+					const ContourPoint &a = points[previous], &b = points[current], &c = points[next];
+					if (cross2(a, b, c) <= 0) {
+						continue;
+					}
+
+					bool empty = true;
+					for (size_t j = 0; j < count && empty; ++j) {
+						const ContourPoint &p = points[remaining[j]];
+						if ((p.x == a.x && p.z == a.z) || (p.x == b.x && p.z == b.z) || (p.x == c.x && p.z == c.z)) {
+							continue;
+						}
+						empty = cross2(a, b, p) < 0 || cross2(b, c, p) < 0 || cross2(c, a, p) < 0;
+					}
+					if (!empty) {
+						continue;
+					}
+
+					triangles.push_back(previous);
+					triangles.push_back(current);
+					triangles.push_back(next);
+					remaining.erase(remaining.begin() + i);
+					clipped = true;
+				}
+
+				if (!clipped) {
+					// Left with a line of collinear points, or an outline the simplification made cross itself
+					for (size_t i = 1; i + 1 < remaining.size(); ++i) {
+						if (cross2(points[remaining[0]], points[remaining[i]], points[remaining[i + 1]]) != 0) {
+							return false;
+						}
+					}
+					return true;
+				}
+			}
+
+			if (cross2(points[remaining[0]], points[remaining[1]], points[remaining[2]]) > 0) {
+				triangles.insert(triangles.end(), remaining.begin(), remaining.end());
+			}
+			return true;
+		}
+
+		// Squared length of the edge the polygons share when merging them stays convex, otherwise -1
+		int getMergeValue(const std::vector<u32> &a, const std::vector<u32> &b, const std::vector<ContourPoint> &points, uint &edgeA, uint &edgeB) {
+			uint countA = (uint)a.size(), countB = (uint)b.size();
+			if (countA + countB - 2 > NavPolygon::maxVertices) {
+				return -1;
+			}
+
+			edgeA = edgeB = countA + countB;
+			for (uint i = 0; i < countA && edgeA == countA + countB; ++i) {
+				for (uint j = 0; j < countB; ++j) {
+					if (a[i] == b[(j + 1) % countB] && a[(i + 1) % countA] == b[j]) {
+						edgeA = i;
+						edgeB = j;
+						break;
+					}
+				}
+			}
+			if (edgeA == countA + countB) {
+				return -1;
+			}
+
+			if (cross2(points[a[(edgeA + countA - 1) % countA]], points[a[edgeA]], points[b[(edgeB + 2) % countB]]) < 0 ||
+				cross2(points[b[(edgeB + countB - 1) % countB]], points[b[edgeB]], points[a[(edgeA + 2) % countA]]) < 0) {
+				return -1;
+			}
+
+			const ContourPoint &start = points[a[edgeA]], &end = points[a[(edgeA + 1) % countA]];
+			return (end.x - start.x) * (end.x - start.x) + (end.z - start.z) * (end.z - start.z);
+		}
+
+		// Greedily merges the pair of polygons with the longest shared edge while the result stays convex
+		void mergePolygons(std::vector<std::vector<u32> > &polygons, const std::vector<ContourPoint> &points) {
+			for (;;) {
+				int bestValue = -1;
+				size_t bestA = 0, bestB = 0;
+				uint bestEdgeA = 0, bestEdgeB = 0;
+				for (size_t i = 0; i < polygons.size(); ++i) {
+					for (size_t j = i + 1; j < polygons.size(); ++j) {
+						uint edgeA, edgeB;
+						int value = getMergeValue(polygons[i], polygons[j], points, edgeA, edgeB);
+						if (value > bestValue) {
+							bestValue = value;
+							bestA = i;
+							bestB = j;
+							bestEdgeA = edgeA;
+							bestEdgeB = edgeB;
+						}
+					}
+				}
+				if (bestValue < 0) {
+					return;
+				}
+
+				const std::vector<u32> &a = polygons[bestA], &b = polygons[bestB];
+				std::vector<u32> merged;
+				for (size_t i = 0; i + 1 < a.size(); ++i) {
+					merged.push_back(a[(bestEdgeA + 1 + i) % a.size()]);
+				}
+				for (size_t i = 0; i + 1 < b.size(); ++i) {
+					merged.push_back(b[(bestEdgeB + 1 + i) % b.size()]);
+				}
+				polygons[bestA].swap(merged);
+				polygons.erase(polygons.begin() + bestB);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI std::shared_ptr<NavMeshTile> NavMeshBuilder::buildTile(const NavMeshSettings &settings, const TriangleMesh &geometry, int x, int z) {
+		if (geometry.getTriangleCount() == 0) {
+			return nullptr;
+		}
+
+		int agentHeight = (int)ceilf(settings.agentHeight / settings.cellHeight);
+		int climb = (int)floorf(settings.agentClimb / settings.cellHeight);
+		int radius = (int)ceilf(settings.agentRadius / settings.cellSize);
+		// Erosion and the ledge filter need to see past the tile border
+		int border = radius + 3;
+		int tileSize = (int)settings.tileSize;
+
+		Heightfield field;
+		field.width = field.depth = tileSize + border * 2;
+		field.cellSize = settings.cellSize;
+		field.cellHeight = settings.cellHeight;
+		const AABB &bounds = geometry.getBounds();
+		field.min = settings.origin + glm::vec3((x * tileSize - border) * settings.cellSize, 0.0f, (z * tileSize - border) * settings.cellSize);
+		field.min.y = bounds.min.y;
+		field.height = std::min((int)ceilf((bounds.max.y - bounds.min.y) / settings.cellHeight) + agentHeight + 1, 0xFFFE);
+		field.columns.assign(field.width * field.depth, noSpan);
+
+		AABB area(field.min, field.min + glm::vec3(field.width * settings.cellSize, bounds.max.y - bounds.min.y, field.depth * settings.cellSize));
+		f32 minNormalY = cosf(glm::radians(settings.maxSlope));
+		auto rasterize = [&geometry, &field, minNormalY, climb](u32 triangle) {
+			glm::vec3 a, b, c;
+			geometry.getTriangle(triangle, a, b, c);
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			f32 length = glm::length(normal);
+			rasterizeTriangle(field, a, b, c, length > 0.0f && normal.y >= minNormalY * length, climb);
+			return true;
+		};
+		geometry.query(area, rasterize);
+		if (field.spans.empty()) {
+			return nullptr;
+		}
+
+		filterLowObstacles(field, climb);
+		filterLedges(field, agentHeight, climb);
+		filterLowCeilings(field, agentHeight);
+
+		OpenHeightfield open;
+		buildOpenHeightfield(field, agentHeight, climb, open);
+		erode(open, radius);
+		buildRegions(open, border);
+
+		// Edges of a span where the region on the other side differs, contours start from them
+		std::vector<u8> edges(open.spans.size(), 0);
+		for (int cz = 0; cz < open.depth; ++cz) {
+			for (int cx = 0; cx < open.width; ++cx) {
+				u32 column = cz * open.width + cx;
+				for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+					u16 region = open.spans[span].region;
+					if (!open.spans[span].walkable || region == noRegion || region == borderRegion) {
+						continue;
+					}
+					u8 connected = 0;
+					for (uint direction = 0; direction < 4; ++direction) {
+						u32 neighbor = open.getNeighbor(cx, cz, span, direction);
+						if (neighbor != noSpan && open.spans[neighbor].walkable && open.spans[neighbor].region == region) {
+							connected |= 1 << direction;
+						}
+					}
+					// A single span alone in its region is too small to keep
+					edges[span] = connected != 0 ? connected ^ 0xF : 0;
+				}
+			}
+		}
+
+		std::shared_ptr<NavMeshTile> tile(new NavMeshTile());
+		tile->x = x;
+		tile->z = z;
+
+		// Vertices are welded by their cell corner, heights a step apart stay separate vertices of different layers
+		std::unordered_map<u64, std::vector<u16> > cornerVertices;
+		std::vector<ContourPoint> tileVertices;
+		std::vector<ContourPoint> raw, simplified;
+		std::vector<u32> triangles;
+		std::vector<std::vector<u32> > polygons;
+		f32 maxError = settings.maxEdgeError / settings.cellSize;
+		for (int cz = 0; cz < open.depth; ++cz) {
+			for (int cx = 0; cx < open.width; ++cx) {
+				u32 column = cz * open.width + cx;
+				for (u32 span = open.first[column]; span < open.first[column] + open.counts[column]; ++span) {
+					if (edges[span] == 0) {
+						continue;
+					}
+
+					raw.clear();
+					simplified.clear();
+					walkContour(open, cx, cz, span, edges, raw);
+					if (raw.size() < 3) {
+						continue;
+					}
+					simplifyContour(raw, maxError, border, border + tileSize, simplified);
+					if (simplified.size() < 3) {
+						continue;
+					}
+
+					triangles.clear();
+					if (!triangulate(simplified, triangles)) {
+#ifdef _DEBUG
+						printf("Navigation mesh tile %d, %d has a self intersecting contour of %u points\n", x, z, (uint)simplified.size());
+#endif
+					}
+					polygons.clear();
+					for (size_t i = 0; i < triangles.size(); i += 3) {
+						polygons.push_back(std::vector<u32>(triangles.begin() + i, triangles.begin() + i + 3));
+					}
+					mergePolygons(polygons, simplified);
+
+					for (size_t i = 0; i < polygons.size(); ++i) {
+						NavPolygon polygon;
+						polygon.vertexCount = (u8)polygons[i].size();
+						for (uint j = 0; j < polygon.vertexCount; ++j) {
+							const ContourPoint &point = simplified[polygons[i][j]];
+							std::vector<u16> &candidates = cornerVertices[((u64)(u32)point.x << 32) | (u32)point.z];
+							u16 vertex = NavMeshTile::noNeighbor;
+							for (size_t k = 0; k < candidates.size(); ++k) {
+								if (abs(tileVertices[candidates[k]].y - point.y) <= 2) {
+									vertex = candidates[k];
+									break;
+								}
+							}
+							if (vertex == NavMeshTile::noNeighbor) {
+								vertex = (u16)tileVertices.size();
+								candidates.push_back(vertex);
+								tileVertices.push_back(point);
+							}
+							polygon.vertices[j] = vertex;
+							polygon.neighbors[j] = NavMeshTile::noNeighbor;
+						}
+						tile->polygons.push_back(polygon);
+					}
+
+					if (tileVertices.size() >= NavMeshTile::noNeighbor || tile->polygons.size() >= NavMeshTile::borderNeighbor) {
+#ifdef _DEBUG
+						printf("Navigation mesh tile %d, %d has too many polygons, use smaller tiles\n", x, z);
+#endif
+						return nullptr;
+					}
+				}
+			}
+		}
+		if (tile->polygons.empty()) {
+			return nullptr;
+		}
+
+		// Polygons sharing an edge are neighbors, edges along the tile border are linked to the next tile
+		std::unordered_map<u32, u32> edgeOwners;
+		for (size_t i = 0; i < tile->polygons.size(); ++i) {
+			const NavPolygon &polygon = tile->polygons[i];
+			for (uint j = 0; j < polygon.vertexCount; ++j) {
+				edgeOwners[((u32)polygon.vertices[j] << 16) | polygon.vertices[(j + 1) % polygon.vertexCount]] = (u32)(i * NavPolygon::maxVertices + j);
+			}
+		}
+		int borderMin = border, borderMax = border + tileSize;
+		for (size_t i = 0; i < tile->polygons.size(); ++i) {
+			NavPolygon &polygon = tile->polygons[i];
+			for (uint j = 0; j < polygon.vertexCount; ++j) {
+				u16 a = polygon.vertices[j], b = polygon.vertices[(j + 1) % polygon.vertexCount];
+				std::unordered_map<u32, u32>::const_iterator owner = edgeOwners.find(((u32)b << 16) | a);
+				if (owner != edgeOwners.end()) {
+					polygon.neighbors[j] = (u16)(owner->second / NavPolygon::maxVertices);
+					continue;
+				}
+
+				const ContourPoint &start = tileVertices[a], &end = tileVertices[b];
+				if (start.x == borderMin && end.x == borderMin) {
+					polygon.neighbors[j] = NavMeshTile::borderNeighbor;
+				}
+				else if (start.z == borderMax && end.z == borderMax) {
+					polygon.neighbors[j] = NavMeshTile::borderNeighbor + 1;
+				}
+				else if (start.x == borderMax && end.x == borderMax) {
+					polygon.neighbors[j] = NavMeshTile::borderNeighbor + 2;
+				}
+				else if (start.z == borderMin && end.z == borderMin) {
+					polygon.neighbors[j] = NavMeshTile::borderNeighbor + 3;
+				}
+			}
+		}
+
+		tile->vertices.resize(tileVertices.size());
+		tile->bounds = AABB(glm::vec3(1e30f), glm::vec3(-1e30f));
+		for (size_t i = 0; i < tileVertices.size(); ++i) {
+			const ContourPoint &point = tileVertices[i];
+			tile->vertices[i] = field.min + glm::vec3(point.x * settings.cellSize, point.y * settings.cellHeight, point.z * settings.cellSize);
+			tile->bounds.merge(tile->vertices[i]);
+		}
+		return tile;
+	}
+
+	ENCOSHAREDAPI uint NavMeshBuilder::build(NavMesh &navMesh, const TriangleMesh &geometry, JobSystem *jobSystem) {
+		if (geometry.getTriangleCount() == 0) {
+			return 0;
+		}
+
+		int minX, minZ, maxX, maxZ;
+		navMesh.getTileCoordinates(geometry.getBounds().min, minX, minZ);
+		navMesh.getTileCoordinates(geometry.getBounds().max, maxX, maxZ);
+		uint width = (uint)(maxX - minX + 1), count = width * (uint)(maxZ - minZ + 1);
+
+		const NavMeshSettings &settings = navMesh.getSettings();
+		std::vector<std::shared_ptr<NavMeshTile> > tiles(count);
+		auto buildRange = [&settings, &geometry, &tiles, width, minX, minZ](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				tiles[i] = buildTile(settings, geometry, minX + (int)(i % width), minZ + (int)(i / width));
+			}
+		};
+		if (jobSystem) {
+			jobSystem->parallelFor(count, 1, buildRange);
+		}
+		else {
+			buildRange(0, count);
+		}
+
+		uint built = 0;
+		for (uint i = 0; i < count; ++i) {
+			if (tiles[i]) {
+				navMesh.setTile(tiles[i]);
+				++built;
+			}
+		}
+		return built;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef __ENCOSHARED_NAVMESHBUILDER_H__
+#define __ENCOSHARED_NAVMESHBUILDER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "NavMesh.h"
+#include "TriangleMesh.h"
+
+#include <memory>
+
+namespace enco {
+	// Builds navigation mesh tiles from level geometry: the triangles are voxelized, spans the agent does not fit on
+	// or is too close to a wall on are removed, the rest is split into monotone regions whose outlines are
+	// simplified and turned into convex polygons. Each tile is padded by the agent radius, so tiles built apart from
+	// each other line up at their borders.
+	class NavMeshBuilder {
+	public:
+		// Tile x, z of geometry, a triangle mesh in world space whose front faces wind counter-clockwise. Only reads
+		// geometry, so tiles may be rebuilt on the job system and swapped in with NavMesh::setTile when done.
+		// Returns nullptr when nothing in the tile is walkable.
+		ENCOSHAREDAPI static std::shared_ptr<NavMeshTile> buildTile(const NavMeshSettings &settings, const TriangleMesh &geometry, int x, int z);
+		// Every tile geometry covers, spread over the job system when there is one. Returns the number of tiles built.
+		ENCOSHAREDAPI static uint build(NavMesh &navMesh, const TriangleMesh &geometry, JobSystem *jobSystem = nullptr);
+	};
+}
+
+#endif
\ No newline at end of file
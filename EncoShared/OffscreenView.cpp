@@ -0,0 +1,36 @@
+#include "stdafx.h"
+#include "OffscreenView.h"
+
+namespace enco {
+	ENCOSHAREDAPI void OffscreenView::create(IRenderer *renderer) {
+		m_renderer = renderer;
+
+		// Without any window the renderer falls back to a headless context
+		m_renderer->createContext(0, 0, m_size.x, m_size.y, 32, 16, 0, false, nullptr);
+
+		m_description.width = m_size.x;
+		m_description.height = m_size.y;
+		m_renderTarget = m_renderer->createRenderTarget(m_description);
+		m_resized = false;
+	}
+
+	ENCOSHAREDAPI void OffscreenView::destroy() {
+		m_renderTarget.reset();
+		m_renderer->deleteContext(nullptr);
+	}
+
+	ENCOSHAREDAPI bool OffscreenView::update(float deltaTime) {
+		// EncoContext updates the views outside of beginView() and endView(), so the renderer has no target bound
+		if (m_resized && m_renderer && m_renderTarget) {
+			m_description.width = m_size.x;
+			m_description.height = m_size.y;
+			m_renderTarget = m_renderer->createRenderTarget(m_description);
+		}
+		m_resized = false;
+		return true;
+	}
+
+	ENCOSHAREDAPI void OffscreenView::onResize() {
+		m_resized = true;
+	}
+}
\ No newline at end of file
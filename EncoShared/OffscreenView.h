@@ -0,0 +1,34 @@
+#ifndef __ENCOSHARED_OFFSCREENVIEW_H__
+#define __ENCOSHARED_OFFSCREENVIEW_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "IView.h"
+
+namespace enco {
+	// A view without a window that renders into its own render target, e.g. for thumbnails or video frames.
+	class OffscreenView : public IView {
+	public:
+		inline OffscreenView(const std::string &name, const glm::u32vec2 &size, TextureFormat colorFormat = rgba8Format, TextureFormat depthFormat = depth24Format, uint samples = 1) : m_renderer(nullptr), m_description(size.x, size.y, colorFormat, depthFormat, samples), m_resized(false) { m_name = name; m_size = size; }
+
+		ENCOSHAREDAPI virtual void create(IRenderer *renderer);
+		ENCOSHAREDAPI virtual void destroy();
+
+		ENCOSHAREDAPI virtual bool update(float deltaTime);
+
+		inline virtual IRenderTarget *getRenderTarget() const { return m_renderTarget.get(); }
+
+	protected:
+		// The target is replaced by the next update(), between frames, since the renderer may be drawing into it
+		ENCOSHAREDAPI virtual void onResize();
+
+	private:
+		IRenderer *m_renderer;
+		RenderTargetDescription m_description;
+		std::shared_ptr<IRenderTarget> m_renderTarget;
+		bool m_resized;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,275 @@
+#include "stdafx.h"
+#include "ParticleEmitter.h"
+
+#include "Simd.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const int bitCounts[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+		// Random number from the serial of a particle, so batches can emit in parallel and in any order
+		inline f32 hashToUnit(u32 serial, u32 channel) {
+			u32 h = serial * 0x9E3779B9u + channel * 0x85EBCA6Bu;
+			h ^= h >> 16;
+			h *= 0x7FEB352Du;
+			h ^= h >> 15;
+			h *= 0x846CA68Bu;
+			h ^= h >> 16;
+			return (h >> 8) * (1.0f / 16777216.0f);
+		}
+
+		// Four random values in [-1, 1)
+		inline SimdFloat4 randomSigned(u32 serial, u32 channel) {
+			return simdSet(hashToUnit(serial, channel) * 2.0f - 1.0f, hashToUnit(serial + 1, channel) * 2.0f - 1.0f, hashToUnit(serial + 2, channel) * 2.0f - 1.0f, hashToUnit(serial + 3, channel) * 2.0f - 1.0f);
+		}
+	}
+
+	ENCOSHAREDAPI ParticleEmitter::ParticleEmitter(const ParticleEmitterSettings &settings) : m_settings(settings), m_planeCount(0), m_heightfield(nullptr), m_heightfieldTop(0.0f), m_count(0), m_capacity(0), m_emitAccumulator(0.0f), m_burst(0), m_serial(0) {
+		allocate(settings.maxParticles);
+	}
+
+	ENCOSHAREDAPI ParticleEmitter::~ParticleEmitter() {
+	}
+
+	ENCOSHAREDAPI void ParticleEmitter::setSettings(const ParticleEmitterSettings &settings) {
+		bool resize = settings.maxParticles != m_settings.maxParticles;
+		m_settings = settings;
+		if (resize) {
+			allocate(settings.maxParticles);
+		}
+	}
+
+	ENCOSHAREDAPI bool ParticleEmitter::addCollisionPlane(const glm::vec4 &plane) {
+		if (m_planeCount >= maxCollisionPlanes) {
+			return false;
+		}
+
+		f32 length = glm::length(glm::vec3(plane));
+		m_planes[m_planeCount++] = length > 0.0f ? plane / length : plane;
+		return true;
+	}
+
+	ENCOSHAREDAPI void ParticleEmitter::setHeightfield(const ParticleHeightfield *heightfield) {
+		m_heightfield = heightfield && heightfield->heights && heightfield->width > 0 && heightfield->depth > 0 ? heightfield : nullptr;
+		if (!m_heightfield) {
+			return;
+		}
+
+		const f32 *heights = m_heightfield->heights;
+		m_heightfieldTop = *std::max_element(heights, heights + m_heightfield->width * m_heightfield->depth) + m_heightfield->origin.y;
+	}
+
+	ENCOSHAREDAPI void ParticleEmitter::clear() {
+		m_count = 0;
+		m_burst = 0;
+		m_emitAccumulator = 0.0f;
+	}
+
+	ENCOSHAREDAPI void ParticleEmitter::update(f32 deltaTime, JobSystem &jobSystem) {
+		uint batchCount = (m_count + batchSize - 1) / batchSize;
+		m_batchAlive.resize(batchCount);
+
+		// Integrate, collide and count the survivors of every batch
+		jobSystem.parallelFor(batchCount, 1, [this, deltaTime](uint begin, uint end) {
+			for (uint batch = begin; batch < end; ++batch) {
+				m_batchAlive[batch] = integrate(batch * batchSize, std::min(m_count, (batch + 1) * batchSize), deltaTime);
+			}
+		});
+
+		// Compact into the second set of arrays, each batch writes behind the survivors of the batches before it
+		uint alive = 0;
+		for (uint batch = 0; batch < batchCount; ++batch) {
+			uint count = m_batchAlive[batch];
+			m_batchAlive[batch] = alive;
+			alive += count;
+		}
+		if (alive != m_count) {
+			jobSystem.parallelFor(batchCount, 1, [this](uint begin, uint end) {
+				for (uint batch = begin; batch < end; ++batch) {
+					compact(batch * batchSize, std::min(m_count, (batch + 1) * batchSize), m_batchAlive[batch]);
+				}
+			});
+			for (int stream = 0; stream < streamCount; ++stream) {
+				m_data[stream].swap(m_compacted[stream]);
+			}
+			m_count = alive;
+		}
+
+		m_emitAccumulator += m_settings.rate * deltaTime;
+		uint emitCount = (uint)m_emitAccumulator + m_burst;
+		m_emitAccumulator -= (f32)(uint)m_emitAccumulator;
+		m_burst = 0;
+
+		emitCount = std::min(emitCount, m_capacity - m_count);
+		if (emitCount == 0) {
+			return;
+		}
+
+		uint first = m_count;
+		u32 serial = m_serial;
+		jobSystem.parallelFor((emitCount + batchSize - 1) / batchSize, 1, [this, first, emitCount, serial](uint begin, uint end) {
+			for (uint batch = begin; batch < end; ++batch) {
+				uint offset = batch * batchSize;
+				emit(first + offset, first + std::min(emitCount, offset + batchSize), serial + offset);
+			}
+		});
+		m_count += emitCount;
+		m_serial += emitCount;
+	}
+
+	void ParticleEmitter::allocate(uint maxParticles) {
+		// Groups of four may run past the last particle, the padding keeps them inside the arrays
+		m_capacity = (maxParticles + 3) & ~3u;
+		for (int stream = 0; stream < streamCount; ++stream) {
+			m_data[stream].resize(m_capacity + 4);
+			m_compacted[stream].resize(m_capacity + 4);
+		}
+		m_count = std::min(m_count, m_capacity);
+	}
+
+	uint ParticleEmitter::integrate(uint begin, uint end, f32 deltaTime) {
+		f32 *px = &m_data[positionX][0], *py = &m_data[positionY][0], *pz = &m_data[positionZ][0];
+		f32 *vx = &m_data[velocityX][0], *vy = &m_data[velocityY][0], *vz = &m_data[velocityZ][0];
+		f32 *lives = &m_data[life][0];
+		const f32 *rates = &m_data[lifeRate][0];
+
+		SimdFloat4 dt = simdSet(deltaTime);
+		SimdFloat4 damping = simdSet(std::max(0.0f, 1.0f - m_settings.drag * deltaTime));
+		SimdFloat4 gravityX = simdSet(m_settings.gravity.x * deltaTime), gravityY = simdSet(m_settings.gravity.y * deltaTime), gravityZ = simdSet(m_settings.gravity.z * deltaTime);
+		SimdFloat4 bounce = simdSet(1.0f + m_settings.restitution);
+		SimdFloat4 restitution = simdSet(-m_settings.restitution);
+		SimdFloat4 zero = simdZero(), one = simdSet(1.0f);
+		SimdFloat4 heightfieldTop = simdSet(m_heightfieldTop);
+
+		uint alive = 0;
+		for (uint i = begin; i < end; i += 4) {
+			SimdFloat4 x = simdLoad(px + i), y = simdLoad(py + i), z = simdLoad(pz + i);
+			SimdFloat4 velX = simdMulAdd(simdLoad(vx + i), damping, gravityX);
+			SimdFloat4 velY = simdMulAdd(simdLoad(vy + i), damping, gravityY);
+			SimdFloat4 velZ = simdMulAdd(simdLoad(vz + i), damping, gravityZ);
+			x = simdMulAdd(velX, dt, x);
+			y = simdMulAdd(velY, dt, y);
+			z = simdMulAdd(velZ, dt, z);
+
+			for (uint p = 0; p < m_planeCount; ++p) {
+				SimdFloat4 nx = simdSet(m_planes[p].x), ny = simdSet(m_planes[p].y), nz = simdSet(m_planes[p].z);
+				SimdFloat4 distance = simdMulAdd(nx, x, simdMulAdd(ny, y, simdMulAdd(nz, z, simdSet(m_planes[p].w))));
+				SimdFloat4 inside = simdLess(distance, zero);
+				if (!simdMoveMask(inside)) {
+					continue;
+				}
+
+				// Push back onto the plane and reflect the velocity that points into it
+				SimdFloat4 push = simdAnd(inside, distance);
+				x = simdSub(x, simdMul(nx, push));
+				y = simdSub(y, simdMul(ny, push));
+				z = simdSub(z, simdMul(nz, push));
+
+				SimdFloat4 normalVelocity = simdMulAdd(nx, velX, simdMulAdd(ny, velY, simdMul(nz, velZ)));
+				SimdFloat4 reflect = simdMul(simdAnd(simdAnd(inside, simdLess(normalVelocity, zero)), normalVelocity), bounce);
+				velX = simdSub(velX, simdMul(nx, reflect));
+				velY = simdSub(velY, simdMul(ny, reflect));
+				velZ = simdSub(velZ, simdMul(nz, reflect));
+			}
+
+			// SSE2 has no gather, so the heights are only sampled per lane for groups that reach below the
+			// highest point of the field. Contacts treat the ground as flat.
+			if (m_heightfield && simdMoveMask(simdLess(y, heightfieldTop))) {
+				f32 lanesX[4], lanesZ[4];
+				simdStore(lanesX, x);
+				simdStore(lanesZ, z);
+				SimdFloat4 ground = simdSet(sampleHeight(lanesX[0], lanesZ[0]), sampleHeight(lanesX[1], lanesZ[1]), sampleHeight(lanesX[2], lanesZ[2]), sampleHeight(lanesX[3], lanesZ[3]));
+				SimdFloat4 below = simdLess(y, ground);
+				y = simdSelect(below, ground, y);
+				velY = simdSelect(simdAnd(below, simdLess(velY, zero)), simdMul(velY, restitution), velY);
+			}
+
+			SimdFloat4 age = simdMulAdd(simdLoad(rates + i), dt, simdLoad(lives + i));
+			simdStore(px + i, x);
+			simdStore(py + i, y);
+			simdStore(pz + i, z);
+			simdStore(vx + i, velX);
+			simdStore(vy + i, velY);
+			simdStore(vz + i, velZ);
+			simdStore(lives + i, age);
+
+			int mask = simdMoveMask(simdLess(age, one));
+			if (end - i < 4) {
+				mask &= (1 << (end - i)) - 1;
+			}
+			alive += bitCounts[mask];
+		}
+		return alive;
+	}
+
+	void ParticleEmitter::compact(uint begin, uint end, uint destination) {
+		const f32 *lives = &m_data[life][0];
+		SimdFloat4 one = simdSet(1.0f);
+
+		for (uint i = begin; i < end; i += 4) {
+			int mask = simdMoveMask(simdLess(simdLoad(lives + i), one));
+			if (end - i < 4) {
+				mask &= (1 << (end - i)) - 1;
+			}
+
+			// Whole groups of survivors are copied four at a time
+			if (mask == 0xF) {
+				for (int stream = 0; stream < streamCount; ++stream) {
+					simdStore(&m_compacted[stream][destination], simdLoad(&m_data[stream][i]));
+				}
+				destination += 4;
+				continue;
+			}
+
+			for (uint lane = 0; mask; ++lane, mask >>= 1) {
+				if (mask & 1) {
+					for (int stream = 0; stream < streamCount; ++stream) {
+						m_compacted[stream][destination] = m_data[stream][i + lane];
+					}
+					++destination;
+				}
+			}
+		}
+	}
+
+	void ParticleEmitter::emit(uint begin, uint end, u32 serial) {
+		const ParticleEmitterSettings &settings = m_settings;
+		SimdFloat4 originX = simdSet(settings.position.x), originY = simdSet(settings.position.y), originZ = simdSet(settings.position.z);
+		SimdFloat4 originJitterX = simdSet(settings.positionJitter.x), originJitterY = simdSet(settings.positionJitter.y), originJitterZ = simdSet(settings.positionJitter.z);
+		SimdFloat4 speedX = simdSet(settings.velocity.x), speedY = simdSet(settings.velocity.y), speedZ = simdSet(settings.velocity.z);
+		SimdFloat4 speedJitterX = simdSet(settings.velocityJitter.x), speedJitterY = simdSet(settings.velocityJitter.y), speedJitterZ = simdSet(settings.velocityJitter.z);
+		SimdFloat4 lifetime = simdSet(settings.lifetime), lifetimeJitter = simdSet(settings.lifetimeJitter);
+		SimdFloat4 minimumLifetime = simdSet(1e-3f), one = simdSet(1.0f);
+
+		// Batches start at multiples of four from the first new particle, so only the last group of the
+		// last batch runs past end, into slots behind getCount() or the padding
+		for (uint i = begin; i < end; i += 4, serial += 4) {
+			simdStore(&m_data[positionX][i], simdMulAdd(randomSigned(serial, 0), originJitterX, originX));
+			simdStore(&m_data[positionY][i], simdMulAdd(randomSigned(serial, 1), originJitterY, originY));
+			simdStore(&m_data[positionZ][i], simdMulAdd(randomSigned(serial, 2), originJitterZ, originZ));
+			simdStore(&m_data[velocityX][i], simdMulAdd(randomSigned(serial, 3), speedJitterX, speedX));
+			simdStore(&m_data[velocityY][i], simdMulAdd(randomSigned(serial, 4), speedJitterY, speedY));
+			simdStore(&m_data[velocityZ][i], simdMulAdd(randomSigned(serial, 5), speedJitterZ, speedZ));
+
+			SimdFloat4 particleLifetime = simdMax(simdMulAdd(randomSigned(serial, 6), lifetimeJitter, lifetime), minimumLifetime);
+			simdStore(&m_data[life][i], simdZero());
+			simdStore(&m_data[lifeRate][i], simdDiv(one, particleLifetime));
+		}
+	}
+
+	f32 ParticleEmitter::sampleHeight(f32 x, f32 z) const {
+		const ParticleHeightfield &field = *m_heightfield;
+		f32 inverseCellSize = 1.0f / field.cellSize;
+		f32 u = glm::clamp((x - field.origin.x) * inverseCellSize, 0.0f, (f32)(field.width - 1));
+		f32 v = glm::clamp((z - field.origin.z) * inverseCellSize, 0.0f, (f32)(field.depth - 1));
+		uint x0 = (uint)u, z0 = (uint)v;
+		uint x1 = std::min(x0 + 1, field.width - 1), z1 = std::min(z0 + 1, field.depth - 1);
+		f32 fx = u - x0, fz = v - z0;
+
+		f32 top = field.heights[z0 * field.width + x0] * (1.0f - fx) + field.heights[z0 * field.width + x1] * fx;
+		f32 bottom = field.heights[z1 * field.width + x0] * (1.0f - fx) + field.heights[z1 * field.width + x1] * fx;
+		return field.origin.y + top * (1.0f - fz) + bottom * fz;
+	}
+}
\ No newline at end of file
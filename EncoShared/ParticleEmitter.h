@@ -0,0 +1,128 @@
+#ifndef __ENCOSHARED_PARTICLEEMITTER_H__
+#define __ENCOSHARED_PARTICLEEMITTER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+namespace enco {
+	struct ParticleEmitterSettings {
+		glm::vec3 position;
+		// New particles get a uniformly random offset in [-jitter, jitter] per component
+		glm::vec3 positionJitter;
+		glm::vec3 velocity;
+		glm::vec3 velocityJitter;
+
+		// Particles per second
+		f32 rate;
+		f32 lifetime;
+		f32 lifetimeJitter;
+
+		glm::vec3 gravity;
+		// Fraction of the velocity lost per second
+		f32 drag;
+		// Fraction of the normal velocity kept when bouncing off a plane or the heightfield
+		f32 restitution;
+
+		f32 startSize, endSize;
+		glm::vec4 startColor, endColor;
+
+		uint maxParticles;
+
+		inline ParticleEmitterSettings() : position(0.0f), positionJitter(0.0f), velocity(0.0f, 1.0f, 0.0f), velocityJitter(0.5f), rate(100.0f), lifetime(2.0f), lifetimeJitter(0.0f),
+			gravity(0.0f, -9.81f, 0.0f), drag(0.0f), restitution(0.5f), startSize(0.1f), endSize(0.1f), startColor(1.0f), endColor(1.0f, 1.0f, 1.0f, 0.0f), maxParticles(65536) {  }
+	};
+
+	// Regular grid of heights, heights[z * width + x] is the height at origin + (x, 0, z) * cellSize
+	struct ParticleHeightfield {
+		const f32 *heights;
+		uint width, depth;
+		glm::vec3 origin;
+		f32 cellSize;
+
+		inline ParticleHeightfield() : heights(nullptr), width(0), depth(0), origin(0.0f), cellSize(1.0f) {  }
+	};
+
+	// Particles are stored as one float array per component (structure of arrays) so that every step works on
+	// four particles per SIMD instruction. update() integrates, collides and compacts the dead particles away
+	// and then emits new ones, each step split into jobs of batchSize particles.
+	class ParticleEmitter {
+	public:
+		static const uint batchSize = 4096;
+		static const uint maxCollisionPlanes = 8;
+
+		ENCOSHAREDAPI ParticleEmitter(const ParticleEmitterSettings &settings = ParticleEmitterSettings());
+		ENCOSHAREDAPI ~ParticleEmitter();
+
+		// Changing maxParticles drops the particles that do not fit any more
+		ENCOSHAREDAPI void setSettings(const ParticleEmitterSettings &settings);
+		inline const ParticleEmitterSettings &getSettings() const { return m_settings; }
+
+		// Planes point away from the solid side, dot(plane.xyz, p) + plane.w >= 0 is free space
+		ENCOSHAREDAPI bool addCollisionPlane(const glm::vec4 &plane);
+		inline void clearCollisionPlanes() { m_planeCount = 0; }
+
+		// The heights have to stay alive while the emitter uses them, nullptr disables the heightfield.
+		// Set the heightfield again after changing its heights.
+		ENCOSHAREDAPI void setHeightfield(const ParticleHeightfield *heightfield);
+
+		// Emits count particles on the next update in addition to the rate
+		inline void burst(uint count) { m_burst += count; }
+		ENCOSHAREDAPI void clear();
+
+		ENCOSHAREDAPI void update(f32 deltaTime, JobSystem &jobSystem);
+
+		inline uint getCount() const { return m_count; }
+		inline uint getCapacity() const { return m_capacity; }
+
+		// getCount() values each, life runs from 0 at emission to 1 when the particle dies
+		inline const f32 *getPositionsX() const { return &m_data[positionX][0]; }
+		inline const f32 *getPositionsY() const { return &m_data[positionY][0]; }
+		inline const f32 *getPositionsZ() const { return &m_data[positionZ][0]; }
+		inline const f32 *getLife() const { return &m_data[life][0]; }
+
+	private:
+		enum Stream : u8 {
+			positionX = 0,
+			positionY,
+			positionZ,
+			velocityX,
+			velocityY,
+			velocityZ,
+			life,
+			lifeRate,
+			streamCount
+		};
+
+		ParticleEmitter(const ParticleEmitter &) = delete;
+		ParticleEmitter &operator=(const ParticleEmitter &) = delete;
+
+		void allocate(uint maxParticles);
+		uint integrate(uint begin, uint end, f32 deltaTime);
+		void compact(uint begin, uint end, uint destination);
+		void emit(uint begin, uint end, u32 serial);
+		f32 sampleHeight(f32 x, f32 z) const;
+
+		ParticleEmitterSettings m_settings;
+		glm::vec4 m_planes[maxCollisionPlanes];
+		uint m_planeCount;
+		const ParticleHeightfield *m_heightfield;
+		f32 m_heightfieldTop;
+
+		// Padded to whole SIMD groups, the second set receives the compacted particles
+		std::vector<f32> m_data[streamCount];
+		std::vector<f32> m_compacted[streamCount];
+		std::vector<uint> m_batchAlive;
+		uint m_count;
+		uint m_capacity;
+
+		f32 m_emitAccumulator;
+		uint m_burst;
+		u32 m_serial;
+	};
+}
+
+#endif
\ No newline at end of file
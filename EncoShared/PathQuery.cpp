@@ -0,0 +1,370 @@
+#include "stdafx.h"
+#include "PathQuery.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace enco {
+	namespace {
+		const u32 noNode = 0xFFFFFFFF;
+		const u32 noEntry = 0xFFFFFFFF;
+		const uint pathBatchSize = 8;
+
+		// Positive when c is right of the line from a to b seen from above
+		inline f32 area2(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+			return (b.x - a.x) * (c.z - a.z) - (c.x - a.x) * (b.z - a.z);
+		}
+
+		inline bool equal(const glm::vec3 &a, const glm::vec3 &b) {
+			glm::vec3 delta = a - b;
+			return glm::dot(delta, delta) < 1e-6f;
+		}
+	}
+
+	ENCOSHAREDAPI void PathBatch::clear() {
+		m_requests.clear();
+		m_statuses.clear();
+		m_paths.clear();
+		m_done.store(false, std::memory_order_release);
+	}
+
+	ENCOSHAREDAPI PathQuery::PathQuery(const NavMesh *navMesh, uint cacheSize) : m_navMesh(navMesh), m_extents(2.0f, 4.0f, 2.0f), m_maxNodes(4096), m_pools(1), m_cacheSize(cacheSize), m_head(noEntry), m_tail(noEntry), m_cacheVersion(0), m_cacheHits(0), m_cacheMisses(0) {
+		if (m_navMesh) {
+			m_cacheVersion = m_navMesh->getVersion();
+		}
+	}
+
+	ENCOSHAREDAPI PathQuery::~PathQuery() {
+	}
+
+	ENCOSHAREDAPI void PathQuery::setNavMesh(const NavMesh *navMesh) {
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		m_navMesh = navMesh;
+		m_cacheEntries.clear();
+		m_cacheLookup.clear();
+		m_head = m_tail = noEntry;
+		m_cacheVersion = m_navMesh ? m_navMesh->getVersion() : 0;
+	}
+
+	ENCOSHAREDAPI void PathQuery::submit(PathHandle batch) {
+		batch->m_done.store(false, std::memory_order_release);
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		m_pending.push_back(batch);
+	}
+
+	ENCOSHAREDAPI void PathQuery::update(JobSystem *jobSystem) {
+		{
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			m_running.swap(m_pending);
+		}
+		if (m_running.empty()) {
+			return;
+		}
+
+		if (jobSystem) {
+			if (m_pools.size() < jobSystem->getWorkerCount() + 1) {
+				m_pools.resize(jobSystem->getWorkerCount() + 1);
+			}
+			JobCounter counter;
+			for (size_t i = 0; i < m_running.size(); ++i) {
+				PathBatch *batch = m_running[i].get();
+				jobSystem->run([this, batch, jobSystem]() { process(*batch, jobSystem); }, &counter);
+			}
+			jobSystem->wait(counter);
+		}
+		else {
+			for (size_t i = 0; i < m_running.size(); ++i) {
+				process(*m_running[i], nullptr);
+			}
+		}
+		m_running.clear();
+	}
+
+	ENCOSHAREDAPI void PathQuery::execute(PathBatch &batch, JobSystem *jobSystem) {
+		if (jobSystem && m_pools.size() < jobSystem->getWorkerCount() + 1) {
+			m_pools.resize(jobSystem->getWorkerCount() + 1);
+		}
+		process(batch, jobSystem);
+	}
+
+	void PathQuery::process(PathBatch &batch, JobSystem *jobSystem) {
+		batch.m_done.store(false, std::memory_order_release);
+		uint count = batch.getPathCount();
+		batch.m_statuses.assign(count, pathNotFound);
+		batch.m_paths.resize(count);
+
+		// A thread runs one range at a time, so the pool of its index is never shared
+		auto findRange = [this, &batch](uint begin, uint end) {
+			NodePool &pool = m_pools[JobSystem::getThreadIndex()];
+			for (uint i = begin; i < end; ++i) {
+				batch.m_statuses[i] = findPath(pool, batch.m_requests[i].start, batch.m_requests[i].end, batch.m_paths[i]);
+			}
+		};
+		if (jobSystem && count > pathBatchSize) {
+			jobSystem->parallelFor(count, pathBatchSize, findRange);
+		}
+		else {
+			findRange(0, count);
+		}
+		batch.m_done.store(true, std::memory_order_release);
+	}
+
+	ENCOSHAREDAPI PathStatus PathQuery::findPath(const glm::vec3 &start, const glm::vec3 &end, std::vector<glm::vec3> &path) {
+		return findPath(m_pools[0], start, end, path);
+	}
+
+	PathStatus PathQuery::findPath(NodePool &pool, const glm::vec3 &start, const glm::vec3 &end, std::vector<glm::vec3> &path) {
+		path.clear();
+		if (!m_navMesh) {
+			return pathNotFound;
+		}
+
+		glm::vec3 startPoint, endPoint;
+		NavPolygonRef startPolygon = m_navMesh->findNearestPolygon(start, m_extents, startPoint);
+		NavPolygonRef endPolygon = m_navMesh->findNearestPolygon(end, m_extents, endPoint);
+		if (startPolygon == NavMesh::invalidPolygon || endPolygon == NavMesh::invalidPolygon) {
+			return pathNotFound;
+		}
+
+		PathStatus status = pathFound;
+		pool.corridor.clear();
+		u64 key = ((u64)startPolygon << 32) | endPolygon;
+		if (startPolygon == endPolygon) {
+			pool.corridor.push_back(startPolygon);
+		}
+		else if (!findCached(key, pool.corridor)) {
+			if (search(pool, startPolygon, startPoint, endPolygon, endPoint)) {
+				addCached(key, pool.corridor);
+			}
+			else {
+				status = pathPartial;
+				endPoint = m_navMesh->getClosestPoint(pool.corridor.back(), endPoint);
+			}
+		}
+
+		straighten(pool.corridor, startPoint, endPoint, path);
+		return status;
+	}
+
+	bool PathQuery::search(NodePool &pool, NavPolygonRef startPolygon, const glm::vec3 &start, NavPolygonRef endPolygon, const glm::vec3 &end) const {
+		std::vector<Node> &nodes = pool.nodes;
+		std::vector<std::pair<f32, u32> > &open = pool.open;
+		nodes.clear();
+		pool.lookup.clear();
+		open.clear();
+
+		Node first = { startPolygon, noNode, 0.0f, glm::distance(start, end), start, false };
+		nodes.push_back(first);
+		pool.lookup[startPolygon] = 0;
+		open.push_back(std::make_pair(first.total, 0u));
+
+		// The node closest to the end is where a partial path leads
+		u32 best = 0;
+		f32 bestHeuristic = first.total;
+		bool found = false;
+		uint maxNodes = m_maxNodes;
+		std::greater<std::pair<f32, u32> > later;
+		while (!open.empty()) {
+			std::pop_heap(open.begin(), open.end(), later);
+			std::pair<f32, u32> top = open.back();
+			open.pop_back();
+			u32 current = top.second;
+			if (nodes[current].closed || top.first > nodes[current].total) {
+				continue;
+			}
+			nodes[current].closed = true;
+			if (nodes[current].polygon == endPolygon) {
+				best = current;
+				found = true;
+				break;
+			}
+
+			// Costs run between the middles of the edges crossed, the last one to the end itself
+			auto expand = [&pool, &nodes, &open, &later, &end, endPolygon, current, maxNodes, &best, &bestHeuristic](NavPolygonRef neighbor, const glm::vec3 &left, const glm::vec3 &right) {
+				glm::vec3 position = (left + right) * 0.5f;
+				f32 cost = nodes[current].cost + glm::distance(nodes[current].position, position);
+				f32 heuristic = glm::distance(position, end);
+				if (neighbor == endPolygon) {
+					cost += heuristic;
+					heuristic = 0.0f;
+				}
+				f32 total = cost + heuristic;
+
+				u32 index;
+				std::unordered_map<NavPolygonRef, u32>::const_iterator it = pool.lookup.find(neighbor);
+				if (it == pool.lookup.end()) {
+					if (nodes.size() >= maxNodes) {
+						return;
+					}
+					index = (u32)nodes.size();
+					nodes.push_back(Node());
+					pool.lookup[neighbor] = index;
+				}
+				else {
+					index = it->second;
+					if (total >= nodes[index].total) {
+						return;
+					}
+				}
+
+				Node node = { neighbor, current, cost, total, position, false };
+				nodes[index] = node;
+				open.push_back(std::make_pair(total, index));
+				std::push_heap(open.begin(), open.end(), later);
+				if (heuristic < bestHeuristic) {
+					bestHeuristic = heuristic;
+					best = index;
+				}
+			};
+			m_navMesh->forEachNeighbor(nodes[current].polygon, expand);
+		}
+
+		pool.corridor.clear();
+		for (u32 node = best; node != noNode; node = nodes[node].parent) {
+			pool.corridor.push_back(nodes[node].polygon);
+		}
+		std::reverse(pool.corridor.begin(), pool.corridor.end());
+		return found;
+	}
+
+	// The funnel from the apex narrows portal by portal, when one side crosses the other that corner is a
+	// turn of the path and the new apex
+	void PathQuery::straighten(const std::vector<NavPolygonRef> &corridor, const glm::vec3 &start, const glm::vec3 &end, std::vector<glm::vec3> &path) const {
+		std::vector<glm::vec3> lefts(1, start), rights(1, start);
+		for (size_t i = 0; i + 1 < corridor.size(); ++i) {
+			glm::vec3 left, right;
+			if (!m_navMesh->getPortal(corridor[i], corridor[i + 1], left, right)) {
+				break;
+			}
+			lefts.push_back(left);
+			rights.push_back(right);
+		}
+		lefts.push_back(end);
+		rights.push_back(end);
+
+		path.push_back(start);
+		glm::vec3 apex = start, left = start, right = start;
+		size_t apexIndex = 0, leftIndex = 0, rightIndex = 0;
+		for (size_t i = 1; i < lefts.size(); ++i) {
+			if (area2(apex, right, rights[i]) <= 0.0f) {
+				if (equal(apex, right) || area2(apex, left, rights[i]) > 0.0f) {
+					right = rights[i];
+					rightIndex = i;
+				}
+				else {
+					// Portals sharing a vertex would add the same corner again
+					if (!equal(path.back(), left)) {
+						path.push_back(left);
+					}
+					apex = right = left;
+					apexIndex = rightIndex = leftIndex;
+					i = apexIndex;
+					continue;
+				}
+			}
+
+			if (area2(apex, left, lefts[i]) >= 0.0f) {
+				if (equal(apex, left) || area2(apex, right, lefts[i]) < 0.0f) {
+					left = lefts[i];
+					leftIndex = i;
+				}
+				else {
+					if (!equal(path.back(), right)) {
+						path.push_back(right);
+					}
+					apex = left = right;
+					apexIndex = leftIndex = rightIndex;
+					i = apexIndex;
+					continue;
+				}
+			}
+		}
+
+		if (!equal(path.back(), end)) {
+			path.push_back(end);
+		}
+	}
+
+	bool PathQuery::findCached(u64 key, std::vector<NavPolygonRef> &corridor) {
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		validateCache();
+		std::unordered_map<u64, u32>::const_iterator it = m_cacheLookup.find(key);
+		if (it == m_cacheLookup.end()) {
+			++m_cacheMisses;
+			return false;
+		}
+		++m_cacheHits;
+		unlink(it->second);
+		pushFront(it->second);
+		corridor = m_cacheEntries[it->second].corridor;
+		return true;
+	}
+
+	void PathQuery::addCached(u64 key, const std::vector<NavPolygonRef> &corridor) {
+		if (m_cacheSize == 0) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_cacheMutex);
+		validateCache();
+		if (m_cacheLookup.find(key) != m_cacheLookup.end()) {
+			return;
+		}
+
+		u32 entry;
+		if (m_cacheEntries.size() < m_cacheSize) {
+			entry = (u32)m_cacheEntries.size();
+			m_cacheEntries.push_back(CacheEntry());
+		}
+		else {
+			entry = m_tail;
+			unlink(entry);
+			m_cacheLookup.erase(m_cacheEntries[entry].key);
+		}
+		m_cacheEntries[entry].key = key;
+		m_cacheEntries[entry].corridor = corridor;
+		m_cacheLookup[key] = entry;
+		pushFront(entry);
+	}
+
+	// Corridors cross polygons of tiles that may have been replaced since
+	void PathQuery::validateCache() {
+		if (m_cacheVersion == m_navMesh->getVersion()) {
+			return;
+		}
+		m_cacheEntries.clear();
+		m_cacheLookup.clear();
+		m_head = m_tail = noEntry;
+		m_cacheVersion = m_navMesh->getVersion();
+	}
+
+	void PathQuery::unlink(u32 entry) {
+		CacheEntry &target = m_cacheEntries[entry];
+		if (target.previous != noEntry) {
+			m_cacheEntries[target.previous].next = target.next;
+		}
+		else {
+			m_head = target.next;
+		}
+		if (target.next != noEntry) {
+			m_cacheEntries[target.next].previous = target.previous;
+		}
+		else {
+			m_tail = target.previous;
+		}
+		target.previous = target.next = noEntry;
+	}
+
+	void PathQuery::pushFront(u32 entry) {
+		CacheEntry &target = m_cacheEntries[entry];
+		target.previous = noEntry;
+		target.next = m_head;
+		if (m_head != noEntry) {
+			m_cacheEntries[m_head].previous = entry;
+		}
+		m_head = entry;
+		if (m_tail == noEntry) {
+			m_tail = entry;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#ifndef __ENCOSHARED_PATHQUERY_H__
+#define __ENCOSHARED_PATHQUERY_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "NavMesh.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	enum PathStatus : u8 {
+		pathNotFound = 0,
+		// The end could not be reached, the path leads as close to it as the search got
+		pathPartial,
+		pathFound
+	};
+
+	// Paths requested together and found together. The batch must not change after it was submitted until isDone()
+	// returns true, the results are valid from then on.
+	class PathBatch {
+	public:
+		inline PathBatch() : m_done(false) {  }
+
+		inline uint addPath(const glm::vec3 &start, const glm::vec3 &end) { Request request = { start, end }; m_requests.push_back(request); return (uint)m_requests.size() - 1; }
+		// Makes the batch reusable, the capacity is kept
+		ENCOSHAREDAPI void clear();
+
+		inline bool isDone() const { return m_done.load(std::memory_order_acquire); }
+
+		inline PathStatus getStatus(uint path) const { return m_statuses[path]; }
+		// Corners from start to end, both moved onto the navigation mesh
+		inline const std::vector<glm::vec3> &getPath(uint path) const { return m_paths[path]; }
+		inline uint getPathCount() const { return (uint)m_requests.size(); }
+
+	private:
+		friend class PathQuery;
+
+		struct Request {
+			glm::vec3 start, end;
+		};
+
+		PathBatch(const PathBatch &) = delete;
+		PathBatch &operator=(const PathBatch &) = delete;
+
+		std::vector<Request> m_requests;
+		std::vector<PathStatus> m_statuses;
+		std::vector<std::vector<glm::vec3> > m_paths;
+		std::atomic<bool> m_done;
+	};
+
+	typedef std::shared_ptr<PathBatch> PathHandle;
+
+	// A* over the polygons of a NavMesh, straightened by the funnel algorithm. Batches may be submitted from any
+	// thread and are answered by update(), the paths of a batch in parallel with one node pool per thread. The
+	// polygon corridors of recent paths are cached by their start and end polygon, so agents heading the same way
+	// only pay for the straightening. The navigation mesh must not change while paths are searched.
+	class PathQuery {
+	public:
+		ENCOSHAREDAPI PathQuery(const NavMesh *navMesh = nullptr, uint cacheSize = 1024);
+		ENCOSHAREDAPI ~PathQuery();
+
+		ENCOSHAREDAPI void setNavMesh(const NavMesh *navMesh);
+		// How far start and end may be from the navigation mesh on each axis
+		inline void setSearchExtents(const glm::vec3 &extents) { m_extents = extents; }
+		// Polygons a search may visit before it settles for a partial path
+		inline void setMaxNodes(uint maxNodes) { m_maxNodes = maxNodes; }
+
+		// Thread safe, the batch is answered by the next update()
+		ENCOSHAREDAPI void submit(PathHandle batch);
+		// Answers every submitted batch and returns when all of them are done
+		ENCOSHAREDAPI void update(JobSystem *jobSystem);
+		// Answers batch right away, spread over the job system when there is one
+		ENCOSHAREDAPI void execute(PathBatch &batch, JobSystem *jobSystem = nullptr);
+		// One path on the calling thread, not at the same time as update() or execute()
+		ENCOSHAREDAPI PathStatus findPath(const glm::vec3 &start, const glm::vec3 &end, std::vector<glm::vec3> &path);
+
+		inline u64 getCacheHits() const { return m_cacheHits; }
+		inline u64 getCacheMisses() const { return m_cacheMisses; }
+
+	private:
+		struct Node {
+			NavPolygonRef polygon;
+			u32 parent;
+			f32 cost, total;
+			// Where the path enters the polygon
+			glm::vec3 position;
+			bool closed;
+		};
+
+		// Search state of one thread, reused by every path it finds
+		struct NodePool {
+			std::vector<Node> nodes;
+			std::unordered_map<NavPolygonRef, u32> lookup;
+			// Total cost and node, entries that were improved on later stay in the heap and are skipped
+			std::vector<std::pair<f32, u32> > open;
+			std::vector<NavPolygonRef> corridor;
+		};
+
+		// Cached corridors form a list from the most to the least recently used
+		struct CacheEntry {
+			u64 key;
+			std::vector<NavPolygonRef> corridor;
+			u32 previous, next;
+		};
+
+		PathQuery(const PathQuery &) = delete;
+		PathQuery &operator=(const PathQuery &) = delete;
+
+		void process(PathBatch &batch, JobSystem *jobSystem);
+		PathStatus findPath(NodePool &pool, const glm::vec3 &start, const glm::vec3 &end, std::vector<glm::vec3> &path);
+		bool search(NodePool &pool, NavPolygonRef startPolygon, const glm::vec3 &start, NavPolygonRef endPolygon, const glm::vec3 &end) const;
+		void straighten(const std::vector<NavPolygonRef> &corridor, const glm::vec3 &start, const glm::vec3 &end, std::vector<glm::vec3> &path) const;
+
+		bool findCached(u64 key, std::vector<NavPolygonRef> &corridor);
+		void addCached(u64 key, const std::vector<NavPolygonRef> &corridor);
+		void validateCache();
+		void unlink(u32 entry);
+		void pushFront(u32 entry);
+
+		const NavMesh *m_navMesh;
+		glm::vec3 m_extents;
+		uint m_maxNodes;
+		std::vector<NodePool> m_pools;
+
+		std::mutex m_cacheMutex;
+		uint m_cacheSize;
+		std::vector<CacheEntry> m_cacheEntries;
+		std::unordered_map<u64, u32> m_cacheLookup;
+		u32 m_head, m_tail;
+		u32 m_cacheVersion;
+		u64 m_cacheHits;
+		u64 m_cacheMisses;
+
+		std::mutex m_pendingMutex;
+		std::vector<PathHandle> m_pending;
+		std::vector<PathHandle> m_running;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,501 @@
+#include "stdafx.h"
+#include "PhysicsWorld.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		// Contacts are created this far before the surfaces touch, so fast bodies slow down before they pass through
+		const f32 speculativeMargin = 0.02f;
+		const f32 baumgarte = 0.2f;
+		const f32 penetrationSlop = 0.005f;
+		// Slower impacts do not bounce, which keeps resting contacts from jittering
+		const f32 restitutionThreshold = 1.0f;
+		const f32 sleepLinearVelocity = 0.05f;
+		const f32 sleepAngularVelocity = 0.05f;
+		const f32 timeToSleep = 0.5f;
+		// Contact points closer than this to one of the last step inherit its impulses
+		const f32 warmStartDistance = 0.05f;
+		const u32 noIsland = 0xFFFFFFFF;
+
+		inline glm::vec3 getTangent(const glm::vec3 &normal) {
+			glm::vec3 tangent = fabsf(normal.x) < 0.57f ? glm::vec3(0.0f, normal.z, -normal.y) : glm::vec3(normal.y, -normal.x, 0.0f);
+			return glm::normalize(tangent);
+		}
+	}
+
+	ENCOSHAREDAPI PhysicsWorld::PhysicsWorld() : m_bodyCount(0), m_gravity(0.0f, -9.81f, 0.0f), m_solverIterations(8), m_contactCount(0), m_islandCount(0) {
+	}
+
+	ENCOSHAREDAPI PhysicsWorld::~PhysicsWorld() {
+	}
+
+	ENCOSHAREDAPI RigidBody PhysicsWorld::addBody(const RigidBodySettings &settings) {
+		if (!settings.shape) {
+			return invalidBody;
+		}
+
+		u32 index;
+		if (!m_freeBodies.empty()) {
+			index = m_freeBodies.back();
+			m_freeBodies.pop_back();
+		}
+		else {
+			index = (u32)m_bodies.size();
+			m_bodies.push_back(Body());
+		}
+
+		Body &body = m_bodies[index];
+		body.shape = settings.shape;
+		body.transform = settings.transform;
+		body.transform.orientation = glm::normalize(body.transform.orientation);
+		body.friction = settings.friction;
+		body.restitution = settings.restitution;
+		body.sleepTime = 0.0f;
+		body.used = true;
+		body.sleeping = false;
+
+		if (settings.mass > 0.0f) {
+			glm::vec3 inertia = settings.shape->getInertia(settings.mass);
+			body.inverseMass = 1.0f / settings.mass;
+			body.inverseInertia = glm::vec3(inertia.x > 0.0f ? 1.0f / inertia.x : 0.0f, inertia.y > 0.0f ? 1.0f / inertia.y : 0.0f, inertia.z > 0.0f ? 1.0f / inertia.z : 0.0f);
+			body.linearVelocity = settings.linearVelocity;
+			body.angularVelocity = settings.angularVelocity;
+		}
+		else {
+			body.inverseMass = 0.0f;
+			body.inverseInertia = glm::vec3(0.0f);
+			body.linearVelocity = body.angularVelocity = glm::vec3(0.0f);
+		}
+		updateInertia(body);
+
+		body.proxy = m_broadphase.createProxy(body.shape->getBounds(body.transform), index);
+		++m_bodyCount;
+		return index;
+	}
+
+	ENCOSHAREDAPI void PhysicsWorld::removeBody(RigidBody body) {
+		if (body >= m_bodies.size() || !m_bodies[body].used) {
+			return;
+		}
+
+		// Whatever rested on the body has to notice it is gone
+		Body &removed = m_bodies[body];
+		PhysicsWorld *world = this;
+		auto wakeTouching = [world](u32 proxy) { world->wake(world->m_broadphase.getUserData(proxy)); return true; };
+		m_broadphase.query(m_broadphase.getFatBox(removed.proxy), wakeTouching);
+
+		m_broadphase.destroyProxy(removed.proxy);
+		removed.shape.reset();
+		removed.used = false;
+		removed.sleeping = true;
+		m_freeBodies.push_back(body);
+		--m_bodyCount;
+	}
+
+	ENCOSHAREDAPI void PhysicsWorld::setTransform(RigidBody body, const ShapeTransform &transform) {
+		Body &target = m_bodies[body];
+		target.transform = transform;
+		target.transform.orientation = glm::normalize(transform.orientation);
+		updateInertia(target);
+		m_broadphase.moveProxy(target.proxy, target.shape->getBounds(target.transform));
+		wake(body);
+	}
+
+	ENCOSHAREDAPI void PhysicsWorld::setLinearVelocity(RigidBody body, const glm::vec3 &velocity) {
+		if (m_bodies[body].inverseMass > 0.0f) {
+			m_bodies[body].linearVelocity = velocity;
+			wake(body);
+		}
+	}
+
+	ENCOSHAREDAPI void PhysicsWorld::setAngularVelocity(RigidBody body, const glm::vec3 &velocity) {
+		if (m_bodies[body].inverseMass > 0.0f) {
+			m_bodies[body].angularVelocity = velocity;
+			wake(body);
+		}
+	}
+
+	ENCOSHAREDAPI void PhysicsWorld::applyImpulse(RigidBody body, const glm::vec3 &impulse, const glm::vec3 &point) {
+		Body &target = m_bodies[body];
+		if (target.inverseMass > 0.0f) {
+			target.linearVelocity += impulse * target.inverseMass;
+			target.angularVelocity += target.inverseInertiaWorld * glm::cross(point - target.transform.position, impulse);
+			wake(body);
+		}
+	}
+
+	ENCOSHAREDAPI void PhysicsWorld::step(f32 deltaTime, JobSystem *jobSystem) {
+		if (deltaTime <= 0.0f) {
+			return;
+		}
+
+		m_awakeBodies.clear();
+		for (u32 i = 0; i < (u32)m_bodies.size(); ++i) {
+			if (m_bodies[i].used && !m_bodies[i].sleeping && m_bodies[i].inverseMass > 0.0f) {
+				m_awakeBodies.push_back(i);
+			}
+		}
+
+		// Gravity, then the broadphase sees where the bodies are heading
+		forEach(jobSystem, (uint)m_awakeBodies.size(), 512, [this, deltaTime](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				Body &body = m_bodies[m_awakeBodies[i]];
+				body.linearVelocity += m_gravity * deltaTime;
+				updateInertia(body);
+			}
+		});
+		for (size_t i = 0; i < m_awakeBodies.size(); ++i) {
+			Body &body = m_bodies[m_awakeBodies[i]];
+			m_broadphase.moveProxy(body.proxy, body.shape->getBounds(body.transform), body.linearVelocity * deltaTime);
+		}
+
+		findPairs(jobSystem);
+
+		m_constraints.resize(m_pairs.size());
+		m_touching.assign(m_pairs.size(), 0);
+		forEach(jobSystem, (uint)m_pairs.size(), 128, [this](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				const Body &a = m_bodies[m_pairs[i].a], &b = m_bodies[m_pairs[i].b];
+				m_touching[i] = Narrowphase::collide(*a.shape, a.transform, *b.shape, b.transform, m_constraints[i].manifold, speculativeMargin) ? 1 : 0;
+			}
+		});
+
+		// Sleeping bodies touched by awake ones join their island
+		m_contactCount = 0;
+		for (size_t i = 0; i < m_pairs.size(); ++i) {
+			if (!m_touching[i]) {
+				continue;
+			}
+			m_contactCount += m_constraints[i].manifold.pointCount;
+			u32 bodies[2] = { m_pairs[i].a, m_pairs[i].b };
+			for (uint j = 0; j < 2; ++j) {
+				Body &body = m_bodies[bodies[j]];
+				if (body.sleeping && body.inverseMass > 0.0f) {
+					wake(bodies[j]);
+					m_awakeBodies.push_back(bodies[j]);
+				}
+			}
+		}
+
+		buildIslands();
+
+		uint threadCount = jobSystem ? jobSystem->getWorkerCount() + 1 : 1;
+		forEach(jobSystem, m_islandCount, std::max(1u, m_islandCount / (threadCount * 4)), [this, deltaTime](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				solveIsland(i, deltaTime);
+			}
+		});
+
+		// The impulses are kept for the next step before the bodies move
+		m_cachedPairs.clear();
+		m_cachedContacts.clear();
+		for (size_t i = 0; i < m_pairs.size(); ++i) {
+			if (!m_touching[i]) {
+				continue;
+			}
+			const ContactConstraint &constraint = m_constraints[i];
+			const Body &a = m_bodies[m_pairs[i].a];
+			glm::quat inverse = glm::conjugate(a.transform.orientation);
+
+			CachedContact cached;
+			cached.pointCount = constraint.manifold.pointCount;
+			for (uint j = 0; j < cached.pointCount; ++j) {
+				cached.localPoints[j] = inverse * (constraint.manifold.positions[j] - a.transform.position);
+				cached.normalImpulse[j] = constraint.normalImpulse[j];
+				cached.tangentImpulse[j] = constraint.tangents[0] * constraint.tangentImpulse[j][0] + constraint.tangents[1] * constraint.tangentImpulse[j][1];
+			}
+			m_cachedPairs.push_back(m_pairs[i]);
+			m_cachedContacts.push_back(cached);
+		}
+
+		forEach(jobSystem, (uint)m_awakeBodies.size(), 512, [this, deltaTime](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				Body &body = m_bodies[m_awakeBodies[i]];
+				body.transform.position += body.linearVelocity * deltaTime;
+				glm::quat spin(0.0f, body.angularVelocity.x, body.angularVelocity.y, body.angularVelocity.z);
+				body.transform.orientation = glm::normalize(body.transform.orientation + spin * body.transform.orientation * (0.5f * deltaTime));
+
+				bool resting = glm::dot(body.linearVelocity, body.linearVelocity) < sleepLinearVelocity * sleepLinearVelocity &&
+					glm::dot(body.angularVelocity, body.angularVelocity) < sleepAngularVelocity * sleepAngularVelocity;
+				body.sleepTime = resting ? body.sleepTime + deltaTime : 0.0f;
+			}
+		});
+
+		// An island sleeps once all of its bodies rested long enough
+		for (uint island = 0; island < m_islandCount; ++island) {
+			f32 minSleepTime = 1e30f;
+			for (u32 i = m_islandBodyStart[island]; i < m_islandBodyStart[island + 1]; ++i) {
+				minSleepTime = std::min(minSleepTime, m_bodies[m_islandBodies[i]].sleepTime);
+			}
+			if (minSleepTime < timeToSleep) {
+				continue;
+			}
+			for (u32 i = m_islandBodyStart[island]; i < m_islandBodyStart[island + 1]; ++i) {
+				Body &body = m_bodies[m_islandBodies[i]];
+				body.sleeping = true;
+				body.linearVelocity = body.angularVelocity = glm::vec3(0.0f);
+			}
+		}
+	}
+
+	void PhysicsWorld::forEach(JobSystem *jobSystem, uint count, uint batchSize, const JobSystem::RangeJob &job) {
+		if (count == 0) {
+			return;
+		}
+		if (jobSystem && count > batchSize) {
+			jobSystem->parallelFor(count, batchSize, job);
+		}
+		else {
+			job(0, count);
+		}
+	}
+
+	void PhysicsWorld::wake(u32 body) {
+		Body &target = m_bodies[body];
+		if (target.used && target.inverseMass > 0.0f) {
+			target.sleeping = false;
+			target.sleepTime = 0.0f;
+		}
+	}
+
+	void PhysicsWorld::updateInertia(Body &body) {
+		glm::mat3 rotation = glm::mat3_cast(body.transform.orientation);
+		glm::mat3 scaled = rotation;
+		for (uint i = 0; i < 3; ++i) {
+			scaled[i] *= body.inverseInertia[i];
+		}
+		body.inverseInertiaWorld = scaled * glm::transpose(rotation);
+	}
+
+	void PhysicsWorld::findPairs(JobSystem *jobSystem) {
+		// Every awake body queries the tree on its own. A pair of two awake bodies is reported by the lower one,
+		// a pair with a sleeping or static body by the awake one, so no pair shows up twice.
+		uint threadCount = jobSystem ? jobSystem->getWorkerCount() + 1 : 1;
+		m_threadPairs.resize(threadCount);
+		for (uint i = 0; i < threadCount; ++i) {
+			m_threadPairs[i].clear();
+		}
+
+		forEach(jobSystem, (uint)m_awakeBodies.size(), 256, [this, jobSystem](uint begin, uint end) {
+			std::vector<Pair> &pairs = m_threadPairs[jobSystem ? JobSystem::getThreadIndex() : 0];
+			for (uint i = begin; i < end; ++i) {
+				u32 self = m_awakeBodies[i];
+				const Body &body = m_bodies[self];
+				const std::vector<Body> &bodies = m_bodies;
+				const AabbTree &broadphase = m_broadphase;
+				auto collect = [self, &bodies, &broadphase, &pairs](u32 proxy) {
+					u32 other = broadphase.getUserData(proxy);
+					const Body &otherBody = bodies[other];
+					if (other == self || (other < self && !otherBody.sleeping && otherBody.inverseMass > 0.0f)) {
+						return true;
+					}
+					Pair pair;
+					pair.a = std::min(self, other);
+					pair.b = std::max(self, other);
+					pairs.push_back(pair);
+					return true;
+				};
+				m_broadphase.query(m_broadphase.getFatBox(body.proxy), collect);
+			}
+		});
+
+		m_pairs.clear();
+		for (uint i = 0; i < threadCount; ++i) {
+			m_pairs.insert(m_pairs.end(), m_threadPairs[i].begin(), m_threadPairs[i].end());
+		}
+		std::sort(m_pairs.begin(), m_pairs.end());
+	}
+
+	u32 PhysicsWorld::findRoot(u32 body) {
+		while (m_parents[body] != body) {
+			m_parents[body] = m_parents[m_parents[body]];
+			body = m_parents[body];
+		}
+		return body;
+	}
+
+	void PhysicsWorld::buildIslands() {
+		m_parents.resize(m_bodies.size());
+		m_islandOf.resize(m_bodies.size());
+		for (size_t i = 0; i < m_awakeBodies.size(); ++i) {
+			m_parents[m_awakeBodies[i]] = m_awakeBodies[i];
+			m_islandOf[m_awakeBodies[i]] = noIsland;
+		}
+
+		// Static bodies do not connect islands, they are never written by the solver
+		for (size_t i = 0; i < m_pairs.size(); ++i) {
+			const Pair &pair = m_pairs[i];
+			if (m_touching[i] && m_bodies[pair.a].inverseMass > 0.0f && m_bodies[pair.b].inverseMass > 0.0f) {
+				u32 rootA = findRoot(pair.a), rootB = findRoot(pair.b);
+				if (rootA != rootB) {
+					m_parents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+				}
+			}
+		}
+
+		m_islandCount = 0;
+		for (size_t i = 0; i < m_awakeBodies.size(); ++i) {
+			u32 root = findRoot(m_awakeBodies[i]);
+			if (m_islandOf[root] == noIsland) {
+				m_islandOf[root] = m_islandCount++;
+			}
+			m_islandOf[m_awakeBodies[i]] = m_islandOf[root];
+		}
+
+		// Counting sort of bodies and contacts by island
+		m_islandBodyStart.assign(m_islandCount + 1, 0);
+		m_islandContactStart.assign(m_islandCount + 1, 0);
+		for (size_t i = 0; i < m_awakeBodies.size(); ++i) {
+			++m_islandBodyStart[m_islandOf[m_awakeBodies[i]] + 1];
+		}
+		for (size_t i = 0; i < m_pairs.size(); ++i) {
+			if (m_touching[i]) {
+				u32 body = m_bodies[m_pairs[i].a].inverseMass > 0.0f ? m_pairs[i].a : m_pairs[i].b;
+				++m_islandContactStart[m_islandOf[body] + 1];
+			}
+		}
+		for (uint i = 0; i < m_islandCount; ++i) {
+			m_islandBodyStart[i + 1] += m_islandBodyStart[i];
+			m_islandContactStart[i + 1] += m_islandContactStart[i];
+		}
+
+		m_islandBodies.resize(m_awakeBodies.size());
+		m_islandContacts.resize(m_islandContactStart[m_islandCount]);
+		std::vector<u32> bodyOffsets(m_islandBodyStart.begin(), m_islandBodyStart.end() - 1);
+		std::vector<u32> contactOffsets(m_islandContactStart.begin(), m_islandContactStart.end() - 1);
+		for (size_t i = 0; i < m_awakeBodies.size(); ++i) {
+			m_islandBodies[bodyOffsets[m_islandOf[m_awakeBodies[i]]]++] = m_awakeBodies[i];
+		}
+		for (size_t i = 0; i < m_pairs.size(); ++i) {
+			if (m_touching[i]) {
+				u32 body = m_bodies[m_pairs[i].a].inverseMass > 0.0f ? m_pairs[i].a : m_pairs[i].b;
+				m_islandContacts[contactOffsets[m_islandOf[body]]++] = (u32)i;
+			}
+		}
+	}
+
+	void PhysicsWorld::prepareContact(u32 index, f32 deltaTime) {
+		ContactConstraint &constraint = m_constraints[index];
+		const Pair &pair = m_pairs[index];
+		Body &a = m_bodies[pair.a], &b = m_bodies[pair.b];
+		const ContactManifold &manifold = constraint.manifold;
+		glm::vec3 normal = manifold.normal;
+
+		constraint.tangents[0] = getTangent(normal);
+		constraint.tangents[1] = glm::cross(normal, constraint.tangents[0]);
+		constraint.friction = sqrtf(a.friction * b.friction);
+		f32 restitution = std::max(a.restitution, b.restitution);
+
+		const CachedContact *cached = nullptr;
+		std::vector<Pair>::const_iterator found = std::lower_bound(m_cachedPairs.begin(), m_cachedPairs.end(), pair);
+		if (found != m_cachedPairs.end() && *found == pair) {
+			cached = &m_cachedContacts[found - m_cachedPairs.begin()];
+		}
+		glm::quat inverseA = glm::conjugate(a.transform.orientation);
+
+		for (uint i = 0; i < manifold.pointCount; ++i) {
+			glm::vec3 offsetA = manifold.positions[i] - a.transform.position, offsetB = manifold.positions[i] - b.transform.position;
+			constraint.offsetsA[i] = offsetA;
+			constraint.offsetsB[i] = offsetB;
+
+			glm::vec3 crossA = glm::cross(offsetA, normal), crossB = glm::cross(offsetB, normal);
+			f32 mass = a.inverseMass + b.inverseMass + glm::dot(crossA, a.inverseInertiaWorld * crossA) + glm::dot(crossB, b.inverseInertiaWorld * crossB);
+			constraint.normalMass[i] = mass > 0.0f ? 1.0f / mass : 0.0f;
+			for (uint j = 0; j < 2; ++j) {
+				glm::vec3 tangentA = glm::cross(offsetA, constraint.tangents[j]), tangentB = glm::cross(offsetB, constraint.tangents[j]);
+				f32 tangentMass = a.inverseMass + b.inverseMass + glm::dot(tangentA, a.inverseInertiaWorld * tangentA) + glm::dot(tangentB, b.inverseInertiaWorld * tangentB);
+				constraint.tangentMass[i][j] = tangentMass > 0.0f ? 1.0f / tangentMass : 0.0f;
+			}
+
+			// Penetration is pushed out over a few steps, a gap may close within this step
+			glm::vec3 velocity = b.linearVelocity + glm::cross(b.angularVelocity, offsetB) - a.linearVelocity - glm::cross(a.angularVelocity, offsetA);
+			f32 normalVelocity = glm::dot(velocity, normal);
+			f32 depth = manifold.depths[i];
+			f32 target = depth > 0.0f ? baumgarte * std::max(depth - penetrationSlop, 0.0f) / deltaTime : depth / deltaTime;
+			if (normalVelocity < -restitutionThreshold) {
+				target = std::max(target, -restitution * normalVelocity);
+			}
+			constraint.targetVelocity[i] = target;
+
+			constraint.normalImpulse[i] = 0.0f;
+			constraint.tangentImpulse[i][0] = constraint.tangentImpulse[i][1] = 0.0f;
+			if (!cached) {
+				continue;
+			}
+			glm::vec3 local = inverseA * offsetA;
+			for (uint j = 0; j < cached->pointCount; ++j) {
+				glm::vec3 delta = cached->localPoints[j] - local;
+				if (glm::dot(delta, delta) < warmStartDistance * warmStartDistance) {
+					constraint.normalImpulse[i] = cached->normalImpulse[j];
+					constraint.tangentImpulse[i][0] = glm::dot(cached->tangentImpulse[j], constraint.tangents[0]);
+					constraint.tangentImpulse[i][1] = glm::dot(cached->tangentImpulse[j], constraint.tangents[1]);
+					break;
+				}
+			}
+
+			glm::vec3 impulse = normal * constraint.normalImpulse[i] + constraint.tangents[0] * constraint.tangentImpulse[i][0] + constraint.tangents[1] * constraint.tangentImpulse[i][1];
+			if (a.inverseMass > 0.0f) {
+				a.linearVelocity -= impulse * a.inverseMass;
+				a.angularVelocity -= a.inverseInertiaWorld * glm::cross(offsetA, impulse);
+			}
+			if (b.inverseMass > 0.0f) {
+				b.linearVelocity += impulse * b.inverseMass;
+				b.angularVelocity += b.inverseInertiaWorld * glm::cross(offsetB, impulse);
+			}
+		}
+	}
+
+	void PhysicsWorld::solveContact(ContactConstraint &constraint, const Pair &pair) {
+		Body &a = m_bodies[pair.a], &b = m_bodies[pair.b];
+		const glm::vec3 &normal = constraint.manifold.normal;
+		bool movesA = a.inverseMass > 0.0f, movesB = b.inverseMass > 0.0f;
+
+		for (uint i = 0; i < constraint.manifold.pointCount; ++i) {
+			const glm::vec3 &offsetA = constraint.offsetsA[i], &offsetB = constraint.offsetsB[i];
+
+			// Friction first, bounded by the normal impulse of the last iteration
+			for (uint j = 0; j < 3; ++j) {
+				glm::vec3 velocity = b.linearVelocity + glm::cross(b.angularVelocity, offsetB) - a.linearVelocity - glm::cross(a.angularVelocity, offsetA);
+				glm::vec3 direction;
+				f32 delta;
+				if (j < 2) {
+					direction = constraint.tangents[j];
+					f32 limit = constraint.friction * constraint.normalImpulse[i];
+					f32 accumulated = glm::clamp(constraint.tangentImpulse[i][j] - glm::dot(velocity, direction) * constraint.tangentMass[i][j], -limit, limit);
+					delta = accumulated - constraint.tangentImpulse[i][j];
+					constraint.tangentImpulse[i][j] = accumulated;
+				}
+				else {
+					direction = normal;
+					f32 accumulated = std::max(constraint.normalImpulse[i] + (constraint.targetVelocity[i] - glm::dot(velocity, direction)) * constraint.normalMass[i], 0.0f);
+					delta = accumulated - constraint.normalImpulse[i];
+					constraint.normalImpulse[i] = accumulated;
+				}
+
+				glm::vec3 impulse = direction * delta;
+				if (movesA) {
+					a.linearVelocity -= impulse * a.inverseMass;
+					a.angularVelocity -= a.inverseInertiaWorld * glm::cross(offsetA, impulse);
+				}
+				if (movesB) {
+					b.linearVelocity += impulse * b.inverseMass;
+					b.angularVelocity += b.inverseInertiaWorld * glm::cross(offsetB, impulse);
+				}
+			}
+		}
+	}
+
+	void PhysicsWorld::solveIsland(uint island, f32 deltaTime) {
+		u32 begin = m_islandContactStart[island], end = m_islandContactStart[island + 1];
+		for (u32 i = begin; i < end; ++i) {
+			prepareContact(m_islandContacts[i], deltaTime);
+		}
+		for (uint iteration = 0; iteration < m_solverIterations; ++iteration) {
+			for (u32 i = begin; i < end; ++i) {
+				u32 contact = m_islandContacts[i];
+				solveContact(m_constraints[contact], m_pairs[contact]);
+			}
+		}
+	}
+}
\ No newline at end of file
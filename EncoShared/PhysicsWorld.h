@@ -0,0 +1,158 @@
+#ifndef __ENCOSHARED_PHYSICSWORLD_H__
+#define __ENCOSHARED_PHYSICSWORLD_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AabbTree.h"
+#include "CollisionShape.h"
+#include "JobSystem.h"
+#include "Narrowphase.h"
+
+#include <memory>
+#include <vector>
+
+namespace enco {
+	typedef u32 RigidBody;
+
+	struct RigidBodySettings {
+		std::shared_ptr<const CollisionShape> shape;
+		ShapeTransform transform;
+		glm::vec3 linearVelocity;
+		glm::vec3 angularVelocity;
+		// 0 makes the body static
+		f32 mass;
+		f32 friction;
+		f32 restitution;
+
+		inline RigidBodySettings() : linearVelocity(0.0f), angularVelocity(0.0f), mass(1.0f), friction(0.5f), restitution(0.0f) {  }
+	};
+
+	// Rigid bodies colliding through a dynamic AABB tree broadphase and the GJK/EPA narrowphase. Touching bodies
+	// form islands that are solved independently on the job system with sequential impulses, warm started from the
+	// contacts of the previous step. Islands that come to rest fall asleep until an awake body touches them.
+	class PhysicsWorld {
+	public:
+		static const RigidBody invalidBody = 0xFFFFFFFF;
+
+		ENCOSHAREDAPI PhysicsWorld();
+		ENCOSHAREDAPI ~PhysicsWorld();
+
+		ENCOSHAREDAPI RigidBody addBody(const RigidBodySettings &settings);
+		ENCOSHAREDAPI void removeBody(RigidBody body);
+
+		inline const ShapeTransform &getTransform(RigidBody body) const { return m_bodies[body].transform; }
+		inline const glm::vec3 &getLinearVelocity(RigidBody body) const { return m_bodies[body].linearVelocity; }
+		inline const glm::vec3 &getAngularVelocity(RigidBody body) const { return m_bodies[body].angularVelocity; }
+		inline const CollisionShape &getShape(RigidBody body) const { return *m_bodies[body].shape; }
+		inline bool isStatic(RigidBody body) const { return m_bodies[body].inverseMass == 0.0f; }
+		inline bool isSleeping(RigidBody body) const { return m_bodies[body].sleeping; }
+
+		// These wake the body up
+		ENCOSHAREDAPI void setTransform(RigidBody body, const ShapeTransform &transform);
+		ENCOSHAREDAPI void setLinearVelocity(RigidBody body, const glm::vec3 &velocity);
+		ENCOSHAREDAPI void setAngularVelocity(RigidBody body, const glm::vec3 &velocity);
+		ENCOSHAREDAPI void applyImpulse(RigidBody body, const glm::vec3 &impulse, const glm::vec3 &point);
+
+		inline void setGravity(const glm::vec3 &gravity) { m_gravity = gravity; }
+		inline const glm::vec3 &getGravity() const { return m_gravity; }
+		inline void setSolverIterations(uint iterations) { m_solverIterations = iterations; }
+
+		// Not thread safe with respect to the other methods, the steps run on the job system when there is one
+		ENCOSHAREDAPI void step(f32 deltaTime, JobSystem *jobSystem = nullptr);
+
+		inline uint getBodyCount() const { return m_bodyCount; }
+		inline uint getAwakeBodyCount() const { return (uint)m_awakeBodies.size(); }
+		inline uint getPairCount() const { return (uint)m_pairs.size(); }
+		inline uint getContactCount() const { return m_contactCount; }
+		inline uint getIslandCount() const { return m_islandCount; }
+		// Proxy user data is the body
+		inline const AabbTree &getBroadphase() const { return m_broadphase; }
+
+	private:
+		struct Body {
+			std::shared_ptr<const CollisionShape> shape;
+			ShapeTransform transform;
+			glm::vec3 linearVelocity;
+			glm::vec3 angularVelocity;
+			f32 inverseMass;
+			glm::vec3 inverseInertia;
+			glm::mat3 inverseInertiaWorld;
+			f32 friction;
+			f32 restitution;
+			u32 proxy;
+			f32 sleepTime;
+			bool used;
+			bool sleeping;
+		};
+
+		// Bodies a < b, the key sorts pairs and finds them again in the next step
+		struct Pair {
+			u32 a, b;
+
+			inline u64 getKey() const { return ((u64)a << 32) | b; }
+			inline bool operator<(const Pair &other) const { return getKey() < other.getKey(); }
+			inline bool operator==(const Pair &other) const { return a == other.a && b == other.b; }
+		};
+
+		struct ContactConstraint {
+			ContactManifold manifold;
+			glm::vec3 tangents[2];
+			f32 friction;
+			glm::vec3 offsetsA[ContactManifold::maxPoints], offsetsB[ContactManifold::maxPoints];
+			f32 normalMass[ContactManifold::maxPoints];
+			f32 tangentMass[ContactManifold::maxPoints][2];
+			f32 targetVelocity[ContactManifold::maxPoints];
+			f32 normalImpulse[ContactManifold::maxPoints];
+			f32 tangentImpulse[ContactManifold::maxPoints][2];
+		};
+
+		// Impulses of the last step, contact points are stored relative to body a
+		struct CachedContact {
+			glm::vec3 localPoints[ContactManifold::maxPoints];
+			f32 normalImpulse[ContactManifold::maxPoints];
+			glm::vec3 tangentImpulse[ContactManifold::maxPoints];
+			uint pointCount;
+		};
+
+		PhysicsWorld(const PhysicsWorld &) = delete;
+		PhysicsWorld &operator=(const PhysicsWorld &) = delete;
+
+		void forEach(JobSystem *jobSystem, uint count, uint batchSize, const JobSystem::RangeJob &job);
+		void wake(u32 body);
+		void updateInertia(Body &body);
+		void findPairs(JobSystem *jobSystem);
+		void buildIslands();
+		void prepareContact(u32 index, f32 deltaTime);
+		void solveContact(ContactConstraint &constraint, const Pair &pair);
+		void solveIsland(uint island, f32 deltaTime);
+		u32 findRoot(u32 body);
+
+		std::vector<Body> m_bodies;
+		std::vector<u32> m_freeBodies;
+		uint m_bodyCount;
+		AabbTree m_broadphase;
+
+		glm::vec3 m_gravity;
+		uint m_solverIterations;
+
+		std::vector<u32> m_awakeBodies;
+		std::vector<std::vector<Pair>> m_threadPairs;
+		std::vector<Pair> m_pairs;
+		std::vector<ContactConstraint> m_constraints;
+		std::vector<u8> m_touching;
+		uint m_contactCount;
+
+		// Union-find over bodies, then islands as ranges of contact and body indices
+		std::vector<u32> m_parents;
+		std::vector<u32> m_islandOf;
+		std::vector<u32> m_islandContactStart, m_islandContacts;
+		std::vector<u32> m_islandBodyStart, m_islandBodies;
+		uint m_islandCount;
+
+		std::vector<Pair> m_cachedPairs;
+		std::vector<CachedContact> m_cachedContacts;
+	};
+}
+
+#endif
\ No newline at end of file
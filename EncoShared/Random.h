@@ -0,0 +1,48 @@
+#ifndef __ENCOSHARED_RANDOM_H__
+#define __ENCOSHARED_RANDOM_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+namespace enco {
+	// xorshift128+ seeded through splitmix64. The sequence only depends on the seed, on every platform and
+	// compiler, so a recorded session plays out the same when replayed with its seed.
+	class Random {
+	public:
+		inline Random(u64 seed = 1) { setSeed(seed); }
+
+		inline void setSeed(u64 seed) {
+			m_seed = seed;
+			for (uint i = 0; i < 2; ++i) {
+				seed += 0x9E3779B97F4A7C15ull;
+				u64 z = seed;
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+				m_state[i] = z ^ (z >> 31);
+			}
+		}
+		inline u64 getSeed() const { return m_seed; }
+
+		inline u64 next() {
+			u64 x = m_state[0];
+			const u64 y = m_state[1];
+			m_state[0] = y;
+			x ^= x << 23;
+			m_state[1] = x ^ y ^ (x >> 17) ^ (y >> 26);
+			return m_state[1] + y;
+		}
+
+		// [0, count)
+		inline u32 nextBelow(u32 count) { return count ? (u32)((next() >> 32) * count >> 32) : 0; }
+		// [0, 1)
+		inline f32 nextFloat() { return (f32)(next() >> 40) * (1.0f / 16777216.0f); }
+		inline f32 nextFloat(f32 min, f32 max) { return min + (max - min) * nextFloat(); }
+
+	private:
+		u64 m_seed;
+		u64 m_state[2];
+	};
+}
+
+#endif
\ No newline at end of file
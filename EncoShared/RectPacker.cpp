@@ -0,0 +1,95 @@
+#include "stdafx.h"
+#include "RectPacker.h"
+
+#include <algorithm>
+
+namespace enco {
+	ENCOSHAREDAPI RectPacker::RectPacker(uint width, uint height) {
+		reset(width, height);
+	}
+
+	ENCOSHAREDAPI void RectPacker::reset(uint width, uint height) {
+		m_width = width;
+		m_height = height;
+		m_usedArea = 0;
+		m_skyline.clear();
+
+		Segment ground = { 0, 0, width };
+		m_skyline.push_back(ground);
+	}
+
+	ENCOSHAREDAPI bool RectPacker::insert(uint width, uint height, uint &x, uint &y) {
+		if (width == 0 || height == 0 || width > m_width || height > m_height) {
+			return false;
+		}
+
+		// Lowest bottom edge first, the narrower segment on ties so wide gaps stay free for wide rectangles
+		size_t best = m_skyline.size();
+		uint bestEnd = 0xFFFFFFFF, bestWidth = 0xFFFFFFFF;
+		for (size_t i = 0; i < m_skyline.size(); ++i) {
+			uint top = fit(i, width);
+			if (top == 0xFFFFFFFF || top + height > m_height) {
+				continue;
+			}
+			if (top + height < bestEnd || (top + height == bestEnd && m_skyline[i].width < bestWidth)) {
+				best = i;
+				bestEnd = top + height;
+				bestWidth = m_skyline[i].width;
+			}
+		}
+		if (best == m_skyline.size()) {
+			return false;
+		}
+
+		x = m_skyline[best].x;
+		y = bestEnd - height;
+
+		Segment placed = { x, bestEnd, width };
+		m_skyline.insert(m_skyline.begin() + best, placed);
+
+		// Cut the segments the new one covers
+		for (size_t i = best + 1; i < m_skyline.size();) {
+			Segment &segment = m_skyline[i];
+			uint end = placed.x + placed.width;
+			if (segment.x >= end) {
+				break;
+			}
+
+			uint shrink = end - segment.x;
+			if (shrink < segment.width) {
+				segment.x += shrink;
+				segment.width -= shrink;
+				break;
+			}
+			m_skyline.erase(m_skyline.begin() + i);
+		}
+
+		// Neighbours at the same height become one segment
+		for (size_t i = 0; i + 1 < m_skyline.size();) {
+			if (m_skyline[i].y == m_skyline[i + 1].y) {
+				m_skyline[i].width += m_skyline[i + 1].width;
+				m_skyline.erase(m_skyline.begin() + i + 1);
+			}
+			else {
+				++i;
+			}
+		}
+
+		m_usedArea += (u64)width * height;
+		return true;
+	}
+
+	uint RectPacker::fit(size_t index, uint width) const {
+		if (m_skyline[index].x + width > m_width) {
+			return 0xFFFFFFFF;
+		}
+
+		uint top = 0;
+		uint remaining = width;
+		for (size_t i = index; remaining > 0; ++i) {
+			top = std::max(top, m_skyline[i].y);
+			remaining -= std::min(remaining, m_skyline[i].width);
+		}
+		return top;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef __ENCOSHARED_RECTPACKER_H__
+#define __ENCOSHARED_RECTPACKER_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <vector>
+
+namespace enco {
+	// Skyline packer: the used area is kept as the height profile of its top edge and every rectangle goes to
+	// the position that leaves the profile lowest. Rectangles are never removed, reset() starts over.
+	class RectPacker {
+	public:
+		ENCOSHAREDAPI RectPacker(uint width = 0, uint height = 0);
+
+		ENCOSHAREDAPI void reset(uint width, uint height);
+
+		// false when the rectangle does not fit anywhere
+		ENCOSHAREDAPI bool insert(uint width, uint height, uint &x, uint &y);
+
+		inline uint getWidth() const { return m_width; }
+		inline uint getHeight() const { return m_height; }
+		// Fraction of the area covered by inserted rectangles
+		inline f32 getOccupancy() const { return m_width && m_height ? (f32)m_usedArea / ((u64)m_width * m_height) : 0.0f; }
+
+	private:
+		struct Segment {
+			uint x, y, width;
+		};
+
+		// Row the rectangle starts at when its left edge is at segment index, 0xFFFFFFFF when it sticks out on the right
+		uint fit(size_t index, uint width) const;
+
+		uint m_width, m_height;
+		u64 m_usedArea;
+		std::vector<Segment> m_skyline;
+	};
+}
+
+#endif
\ No newline at end of file
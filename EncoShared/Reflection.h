@@ -0,0 +1,66 @@
+#ifndef __ENCOSHARED_REFLECTION_H__
+#define __ENCOSHARED_REFLECTION_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace enco {
+	enum FieldType : u8 {
+		FieldTypeU32,
+		FieldTypeI32,
+		FieldTypeF32,
+		FieldTypeVec2,
+		FieldTypeVec3,
+		FieldTypeVec4,
+		// x, y, z, w like glm::quat
+		FieldTypeQuat,
+		// u32 index into the string table of a SceneBlob
+		FieldTypeString
+	};
+
+	inline u32 getFieldSize(FieldType type) {
+		switch (type) {
+		case FieldTypeVec2: return 8;
+		case FieldTypeVec3: return 12;
+		case FieldTypeVec4: case FieldTypeQuat: return 16;
+		default: return 4;
+		}
+	}
+
+	struct ReflectedField {
+		std::string name;
+		FieldType type;
+		u32 offset;
+
+		inline ReflectedField(const std::string &name, FieldType type, u32 offset) : name(name), type(type), offset(offset) {  }
+	};
+
+	// Layout of a plain component struct. Data saved with another layout is migrated field by field, matching
+	// fields by name and type. Fields the data does not have keep the value in defaults, or zero without defaults.
+	struct ReflectedType {
+		// Called on migrated components when the data was saved with another version, after the fields were matched
+		typedef void (*Migration)(u32 version, void *components, uint count);
+
+		std::string name;
+		u32 version;
+		u32 size;
+		const void *defaults;
+		Migration migration;
+		std::vector<ReflectedField> fields;
+
+		inline ReflectedType(const std::string &name, u32 version, u32 size, const void *defaults = nullptr, Migration migration = nullptr) : name(name), version(version), size(size), defaults(defaults), migration(migration) {  }
+
+		inline ReflectedType &addField(const std::string &name, FieldType type, u32 offset) { fields.push_back(ReflectedField(name, type, offset)); return *this; }
+	};
+}
+
+// ENCO_REFLECT(Transform, 1).ENCO_FIELD(Transform, position, FieldTypeVec3).ENCO_FIELD(Transform, rotation, FieldTypeQuat)
+#define ENCO_REFLECT(type, version) enco::ReflectedType(#type, version, (enco::u32)sizeof(type))
+#define ENCO_FIELD(type, member, fieldType) addField(#member, enco::fieldType, (enco::u32)offsetof(type, member))
+
+#endif
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "stdafx.h"
+#include "RenderGraph.h"
+
+#include <algorithm>
+
+namespace enco {
+	ENCOSHAREDAPI RenderResource RenderGraphBuilder::create(const std::string &name, const RenderTargetDescription &description, const glm::vec4 &clearColor, f64 clearDepth) {
+		RenderGraph::Resource resource;
+		resource.name = name;
+		resource.description = description;
+		resource.clearColor = clearColor;
+		resource.clearDepth = clearDepth;
+		resource.imported = nullptr;
+		resource.isImported = false;
+		resource.readerCount = 0;
+		resource.firstPass = resource.lastPass = m_pass;
+		resource.pooled = -1;
+		resource.written = false;
+
+		m_graph.m_resources.push_back(resource);
+		return (RenderResource)(m_graph.m_resources.size() - 1);
+	}
+
+	ENCOSHAREDAPI RenderResource RenderGraphBuilder::read(RenderResource resource) {
+		if (resource >= m_graph.m_resources.size()) {
+			return invalidRenderResource;
+		}
+
+		RenderGraph::Pass &pass = m_graph.m_passes[m_pass];
+		if (std::find(pass.reads.begin(), pass.reads.end(), resource) == pass.reads.end()) {
+			pass.reads.push_back(resource);
+			++m_graph.m_resources[resource].readerCount;
+		}
+		return resource;
+	}
+
+	ENCOSHAREDAPI RenderResource RenderGraphBuilder::write(RenderResource resource, int clearBuffers) {
+		if (resource >= m_graph.m_resources.size()) {
+			return invalidRenderResource;
+		}
+
+		RenderGraph::Pass &pass = m_graph.m_passes[m_pass];
+		if (!pass.writes.empty() && pass.writes.front() != resource) {
+#ifdef _DEBUG
+			printf("RenderGraph: Pass %s writes more than one target\n", pass.name.c_str());
+#endif
+			return invalidRenderResource;
+		}
+
+		if (pass.writes.empty()) {
+			pass.writes.push_back(resource);
+			pass.clears.push_back(clearBuffers);
+			m_graph.m_resources[resource].writers.push_back(m_pass);
+		}
+		else {
+			pass.clears.front() |= clearBuffers;
+		}
+		return resource;
+	}
+
+	ENCOSHAREDAPI void RenderGraphBuilder::setSideEffect() {
+		m_graph.m_passes[m_pass].sideEffect = true;
+	}
+
+	ENCOSHAREDAPI RenderGraph::RenderGraph() : m_compiled(false), m_frame(0), m_poolRetention(4), m_culledPasses(0), m_transientCount(0), m_physicalTargetsUsed(0) {
+	}
+
+	ENCOSHAREDAPI RenderGraph::~RenderGraph() {
+	}
+
+	ENCOSHAREDAPI void RenderGraph::reset() {
+		m_passes.clear();
+		m_resources.clear();
+		m_compiled = false;
+	}
+
+	ENCOSHAREDAPI void RenderGraph::addPass(const std::string &name, SetupCallback setup, ExecuteCallback execute) {
+		Pass pass;
+		pass.name = name;
+		pass.execute = execute;
+		pass.sideEffect = false;
+		pass.refCount = 0;
+		pass.culled = false;
+		m_passes.push_back(pass);
+
+		RenderGraphBuilder builder(*this, (u32)(m_passes.size() - 1));
+		setup(builder);
+		m_compiled = false;
+	}
+
+	ENCOSHAREDAPI RenderResource RenderGraph::importTarget(const std::string &name, IRenderTarget *target) {
+		Resource resource;
+		resource.name = name;
+		if (target) {
+			resource.description = target->getDescription();
+		}
+		resource.clearColor = glm::vec4(0.0f);
+		resource.clearDepth = 1.0;
+		resource.imported = target;
+		resource.isImported = true;
+		resource.readerCount = 0;
+		resource.firstPass = resource.lastPass = 0;
+		resource.pooled = -1;
+		resource.written = false;
+
+		m_resources.push_back(resource);
+		return (RenderResource)(m_resources.size() - 1);
+	}
+
+	ENCOSHAREDAPI void RenderGraph::compile() {
+		// Reference counting cull: a pass is alive while something reads what it writes.
+		// Imported targets outlive the graph, so writing one counts as a read.
+		std::vector<u32> readerCounts(m_resources.size());
+		for (size_t i = 0; i < m_resources.size(); ++i) {
+			readerCounts[i] = m_resources[i].readerCount + (m_resources[i].isImported ? 1 : 0);
+		}
+
+		std::vector<RenderResource> unreferenced;
+		for (size_t i = 0; i < m_passes.size(); ++i) {
+			Pass &pass = m_passes[i];
+			pass.refCount = (u32)pass.writes.size() + (pass.sideEffect ? 1 : 0);
+			pass.culled = false;
+			pass.acquire.clear();
+			pass.release.clear();
+		}
+		for (size_t i = 0; i < m_resources.size(); ++i) {
+			if (readerCounts[i] == 0) {
+				unreferenced.push_back((RenderResource)i);
+			}
+		}
+
+		while (!unreferenced.empty()) {
+			RenderResource resource = unreferenced.back();
+			unreferenced.pop_back();
+
+			const std::vector<u32> &writers = m_resources[resource].writers;
+			for (size_t i = 0; i < writers.size(); ++i) {
+				Pass &writer = m_passes[writers[i]];
+				if (writer.refCount == 0 || --writer.refCount > 0) {
+					continue;
+				}
+
+				for (size_t j = 0; j < writer.reads.size(); ++j) {
+					if (--readerCounts[writer.reads[j]] == 0) {
+						unreferenced.push_back(writer.reads[j]);
+					}
+				}
+			}
+		}
+
+		m_culledPasses = 0;
+		for (size_t i = 0; i < m_passes.size(); ++i) {
+			Pass &pass = m_passes[i];
+			pass.culled = pass.refCount == 0;
+			if (pass.culled) {
+				++m_culledPasses;
+			}
+		}
+
+		// Lifetimes over the surviving passes
+		const u32 unused = 0xFFFFFFFF;
+		m_transientCount = 0;
+		for (size_t i = 0; i < m_resources.size(); ++i) {
+			m_resources[i].firstPass = unused;
+			m_resources[i].lastPass = 0;
+		}
+		for (u32 i = 0; i < (u32)m_passes.size(); ++i) {
+			Pass &pass = m_passes[i];
+			if (pass.culled) {
+				continue;
+			}
+
+			for (int list = 0; list < 2; ++list) {
+				const std::vector<RenderResource> &resources = list == 0 ? pass.reads : pass.writes;
+				for (size_t j = 0; j < resources.size(); ++j) {
+					Resource &resource = m_resources[resources[j]];
+					resource.firstPass = std::min(resource.firstPass, i);
+					resource.lastPass = std::max(resource.lastPass, i);
+				}
+			}
+		}
+		for (size_t i = 0; i < m_resources.size(); ++i) {
+			Resource &resource = m_resources[i];
+			if (resource.isImported || resource.firstPass == unused) {
+				continue;
+			}
+
+			m_passes[resource.firstPass].acquire.push_back((RenderResource)i);
+			m_passes[resource.lastPass].release.push_back((RenderResource)i);
+			++m_transientCount;
+		}
+
+		m_compiled = true;
+	}
+
+	ENCOSHAREDAPI void RenderGraph::execute(IRenderer &renderer) {
+		if (!m_compiled) {
+			compile();
+		}
+
+		++m_frame;
+		m_physicalTargetsUsed = 0;
+
+		for (size_t i = 0; i < m_passes.size(); ++i) {
+			Pass &pass = m_passes[i];
+			if (pass.culled) {
+				continue;
+			}
+
+			for (size_t j = 0; j < pass.acquire.size(); ++j) {
+				Resource &resource = m_resources[pass.acquire[j]];
+				resource.pooled = acquireTarget(renderer, resource.description);
+				resource.written = false;
+			}
+
+			if (!pass.writes.empty()) {
+				Resource &target = m_resources[pass.writes.front()];
+				// Switching targets resolves a multisampled target before a later pass samples it
+				renderer.bindRenderTarget(getTarget(pass.writes.front()));
+
+				int clearBuffers = pass.clears.front();
+				if (!target.isImported && !target.written) {
+					clearBuffers |= target.description.getColorCount() > 0 ? RenderingBuffer::colorBuffer : 0;
+					clearBuffers |= target.description.depthFormat != noFormat ? RenderingBuffer::depthBuffer : 0;
+					clearBuffers |= target.description.depthFormat == depth24Stencil8Format ? RenderingBuffer::stencilBuffer : 0;
+				}
+				if (clearBuffers) {
+					renderer.setClearColor(target.clearColor.r, target.clearColor.g, target.clearColor.b);
+					renderer.setClearDepth(target.clearDepth);
+					renderer.clearBuffer(clearBuffers);
+				}
+				target.written = true;
+			}
+
+			pass.execute(renderer, *this);
+
+			for (size_t j = 0; j < pass.release.size(); ++j) {
+				Resource &resource = m_resources[pass.release[j]];
+				if (resource.pooled >= 0) {
+					m_pool[resource.pooled].inUse = false;
+				}
+			}
+		}
+
+		renderer.bindRenderTarget(nullptr);
+
+		// Drop targets the graph stopped asking for, e.g. after a resize
+		for (size_t i = m_pool.size(); i > 0; --i) {
+			if (!m_pool[i - 1].inUse && m_frame - m_pool[i - 1].lastUsedFrame > m_poolRetention) {
+				m_pool.erase(m_pool.begin() + (i - 1));
+			}
+		}
+		for (size_t i = 0; i < m_resources.size(); ++i) {
+			m_resources[i].pooled = -1;
+		}
+	}
+
+	ENCOSHAREDAPI IRenderTarget *RenderGraph::getTarget(RenderResource resource) const {
+		if (resource >= m_resources.size()) {
+			return nullptr;
+		}
+
+		const Resource &entry = m_resources[resource];
+		if (entry.isImported) {
+			return entry.imported;
+		}
+		return entry.pooled >= 0 ? m_pool[entry.pooled].target.get() : nullptr;
+	}
+
+	ENCOSHAREDAPI void RenderGraph::clearPool() {
+		m_pool.clear();
+		for (size_t i = 0; i < m_resources.size(); ++i) {
+			m_resources[i].pooled = -1;
+		}
+	}
+
+	int RenderGraph::acquireTarget(IRenderer &renderer, const RenderTargetDescription &description) {
+		for (size_t i = 0; i < m_pool.size(); ++i) {
+			PooledTarget &pooled = m_pool[i];
+			if (!pooled.inUse && isCompatible(pooled.description, description)) {
+				if (pooled.lastUsedFrame != m_frame) {
+					++m_physicalTargetsUsed;
+				}
+				pooled.inUse = true;
+				pooled.lastUsedFrame = m_frame;
+				return (int)i;
+			}
+		}
+
+		PooledTarget pooled;
+		pooled.description = description;
+		pooled.target = renderer.createRenderTarget(description);
+		pooled.lastUsedFrame = m_frame;
+		pooled.inUse = true;
+		m_pool.push_back(pooled);
+		++m_physicalTargetsUsed;
+		return (int)(m_pool.size() - 1);
+	}
+
+	bool RenderGraph::isCompatible(const RenderTargetDescription &a, const RenderTargetDescription &b) {
+		if (a.width != b.width || a.height != b.height || a.depthFormat != b.depthFormat || a.samples != b.samples) {
+			return false;
+		}
+		for (uint i = 0; i < RenderTargetDescription::maxColorAttachments; ++i) {
+			if (a.colorFormats[i] != b.colorFormats[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+}
\ No newline at end of file
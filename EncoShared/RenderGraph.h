@@ -0,0 +1,132 @@
+#ifndef __ENCOSHARED_RENDERGRAPH_H__
+#define __ENCOSHARED_RENDERGRAPH_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "IRenderer.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace enco {
+	class RenderGraph;
+
+	typedef u32 RenderResource;
+	static const RenderResource invalidRenderResource = 0xFFFFFFFF;
+
+	// Passes declare what they read and write while they are added, the graph is rebuilt every frame.
+	// compile() culls passes whose results nobody reads and computes the lifetime of every transient target.
+	// execute() then hands out pooled render targets so that transients with disjoint lifetimes and equal
+	// descriptions share one physical target, and clears a transient target before it is first written.
+	class RenderGraphBuilder {
+	public:
+		ENCOSHAREDAPI RenderResource create(const std::string &name, const RenderTargetDescription &description, const glm::vec4 &clearColor = glm::vec4(0.0f), f64 clearDepth = 1.0);
+		ENCOSHAREDAPI RenderResource read(RenderResource resource);
+		// clearBuffers clears an imported target on this write, transients are always cleared on their first write
+		ENCOSHAREDAPI RenderResource write(RenderResource resource, int clearBuffers = 0);
+
+		// The pass is never culled, e.g. because it uploads data or issues a readback
+		ENCOSHAREDAPI void setSideEffect();
+
+	private:
+		friend class RenderGraph;
+
+		inline RenderGraphBuilder(RenderGraph &graph, u32 pass) : m_graph(graph), m_pass(pass) {  }
+		RenderGraphBuilder &operator=(const RenderGraphBuilder &) = delete;
+
+		RenderGraph &m_graph;
+		u32 m_pass;
+	};
+
+	class RenderGraph {
+	public:
+		typedef std::function<void(RenderGraphBuilder &builder)> SetupCallback;
+		typedef std::function<void(IRenderer &renderer, const RenderGraph &graph)> ExecuteCallback;
+
+		ENCOSHAREDAPI RenderGraph();
+		ENCOSHAREDAPI ~RenderGraph();
+
+		// Forgets all passes and resources of the last frame, the target pool is kept
+		ENCOSHAREDAPI void reset();
+
+		ENCOSHAREDAPI void addPass(const std::string &name, SetupCallback setup, ExecuteCallback execute);
+
+		// nullptr imports the window of the current view
+		ENCOSHAREDAPI RenderResource importTarget(const std::string &name, IRenderTarget *target);
+
+		ENCOSHAREDAPI void compile();
+		ENCOSHAREDAPI void execute(IRenderer &renderer);
+
+		// Only valid while the pass that declared the resource executes
+		ENCOSHAREDAPI IRenderTarget *getTarget(RenderResource resource) const;
+
+		// Pooled targets that were not used for this many frames are released
+		inline void setPoolRetention(u32 frames) { m_poolRetention = frames; }
+		ENCOSHAREDAPI void clearPool();
+
+		inline uint getPassCount() const { return (uint)m_passes.size(); }
+		inline uint getCulledPassCount() const { return m_culledPasses; }
+		inline uint getTransientCount() const { return m_transientCount; }
+		inline uint getPhysicalTargetCount() const { return m_physicalTargetsUsed; }
+		inline uint getPoolSize() const { return (uint)m_pool.size(); }
+
+	private:
+		friend class RenderGraphBuilder;
+
+		struct Resource {
+			std::string name;
+			RenderTargetDescription description;
+			glm::vec4 clearColor;
+			f64 clearDepth;
+			IRenderTarget *imported;
+			bool isImported;
+
+			std::vector<u32> writers;
+			u32 readerCount;
+			u32 firstPass, lastPass;
+			int pooled;
+			bool written;
+		};
+
+		struct Pass {
+			std::string name;
+			ExecuteCallback execute;
+			std::vector<RenderResource> reads;
+			std::vector<RenderResource> writes;
+			std::vector<int> clears;
+			bool sideEffect;
+
+			u32 refCount;
+			bool culled;
+			std::vector<RenderResource> acquire;
+			std::vector<RenderResource> release;
+		};
+
+		struct PooledTarget {
+			RenderTargetDescription description;
+			std::shared_ptr<IRenderTarget> target;
+			u64 lastUsedFrame;
+			bool inUse;
+		};
+
+		int acquireTarget(IRenderer &renderer, const RenderTargetDescription &description);
+		static bool isCompatible(const RenderTargetDescription &a, const RenderTargetDescription &b);
+
+		std::vector<Pass> m_passes;
+		std::vector<Resource> m_resources;
+		std::vector<PooledTarget> m_pool;
+
+		bool m_compiled;
+		u64 m_frame;
+		u32 m_poolRetention;
+
+		uint m_culledPasses;
+		uint m_transientCount;
+		uint m_physicalTargetsUsed;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "stdafx.h"
+#include "Scene.h"
+#include "SceneBlob.h"
+
+#include <unordered_map>
+
+namespace enco {
+	namespace {
+		const u32 noIndex = 0xFFFFFFFF;
+		const Transform defaultTransform;
+
+		// Components of a saved scene besides Transform, indices refer to the entities and strings of the blob
+		struct SavedParent {
+			u32 parent;
+		};
+
+		struct SavedMesh {
+			u32 path;
+		};
+
+		ReflectedType getTransformType() {
+			ReflectedType type = ENCO_REFLECT(Transform, 1).ENCO_FIELD(Transform, position, FieldTypeVec3).ENCO_FIELD(Transform, rotation, FieldTypeQuat).ENCO_FIELD(Transform, scale, FieldTypeVec3);
+			type.defaults = &defaultTransform;
+			return type;
+		}
+
+		ReflectedType getParentType() {
+			return ENCO_REFLECT(SavedParent, 1).ENCO_FIELD(SavedParent, parent, FieldTypeU32);
+		}
+
+		ReflectedType getMeshType() {
+			return ENCO_REFLECT(SavedMesh, 1).ENCO_FIELD(SavedMesh, path, FieldTypeString);
+		}
+
+		glm::mat4 toMatrix(const Transform &transform) {
+			glm::mat3 rotation = glm::mat3_cast(transform.rotation);
+			glm::mat4 matrix(1.0f);
+			matrix[0] = glm::vec4(rotation[0] * transform.scale.x, 0.0f);
+			matrix[1] = glm::vec4(rotation[1] * transform.scale.y, 0.0f);
+			matrix[2] = glm::vec4(rotation[2] * transform.scale.z, 0.0f);
+			matrix[3] = glm::vec4(transform.position, 1.0f);
+			return matrix;
+		}
+	}
+
+	ENCOSHAREDAPI Scene::Scene() : m_nodeCount(0), m_entityCount(0) {
+	}
+
+	ENCOSHAREDAPI Scene::~Scene() {
+	}
+
+	ENCOSHAREDAPI Entity Scene::createEntity(Entity parent, const Transform &transform) {
+		if (parent != invalidEntity && !isAlive(parent)) {
+			return invalidEntity;
+		}
+
+		uint index;
+		if (!m_freeNodes.empty()) {
+			index = m_freeNodes.back();
+			m_freeNodes.pop_back();
+		}
+		else if (m_nodeCount < 0xFFFFFF) {
+			if (m_nodeCount == m_chunks.size() * chunkSize) {
+				m_chunks.push_back(Chunk(chunkSize));
+			}
+			index = m_nodeCount++;
+		}
+		else {
+			return invalidEntity;
+		}
+
+		Node &node = getNode(index);
+		Entity entity = makeEntity(index, node.generation);
+		node.transform = transform;
+		node.alive = true;
+		node.parent = parent;
+		if (parent != invalidEntity) {
+			Node &parentNode = getNode(getIndex(parent));
+			node.nextSibling = parentNode.firstChild;
+			parentNode.firstChild = entity;
+		}
+		markDirty(index);
+		++m_entityCount;
+		return entity;
+	}
+
+	ENCOSHAREDAPI void Scene::destroyEntity(Entity entity) {
+		if (!isAlive(entity)) {
+			return;
+		}
+
+		Node &node = getNode(getIndex(entity));
+		if (node.parent != invalidEntity) {
+			Entity *link = &getNode(getIndex(node.parent)).firstChild;
+			while (*link != entity) {
+				link = &getNode(getIndex(*link)).nextSibling;
+			}
+			*link = node.nextSibling;
+		}
+
+		m_stack.clear();
+		m_stack.push_back(getIndex(entity));
+		while (!m_stack.empty()) {
+			uint index = m_stack.back();
+			m_stack.pop_back();
+
+			Node &current = getNode(index);
+			for (Entity child = current.firstChild; child != invalidEntity; child = getNode(getIndex(child)).nextSibling) {
+				m_stack.push_back(getIndex(child));
+			}
+
+			u8 generation = current.generation + 1;
+			current = Node();
+			current.generation = generation;
+			m_freeNodes.push_back(index);
+			--m_entityCount;
+		}
+	}
+
+	ENCOSHAREDAPI bool Scene::isAlive(Entity entity) const {
+		uint index = getIndex(entity);
+		return entity != invalidEntity && index < m_nodeCount && getNode(index).alive && getNode(index).generation == (u8)(entity >> 24);
+	}
+
+	ENCOSHAREDAPI void Scene::setTransform(Entity entity, const Transform &transform) {
+		uint index = getIndex(entity);
+		getNode(index).transform = transform;
+		markDirty(index);
+	}
+
+	ENCOSHAREDAPI void Scene::updateTransforms() {
+		// A subtree whose ancestor is dirty as well may be visited twice, the ancestor's visit comes last or the
+		// subtree is no longer dirty by then, so the result is the same either way
+		for (size_t i = 0; i < m_dirty.size(); ++i) {
+			if (getNode(m_dirty[i]).dirty) {
+				updateWorld(m_dirty[i]);
+			}
+		}
+		m_dirty.clear();
+	}
+
+	ENCOSHAREDAPI bool Scene::save(const std::string &path) const {
+		// Depth first from the roots, children are pushed in list order so they are read back in it
+		std::vector<u32> indices(m_nodeCount, noIndex);
+		std::vector<uint> order, stack;
+		order.reserve(m_entityCount);
+		for (uint i = 0; i < m_nodeCount; ++i) {
+			if (getNode(i).alive && getNode(i).parent == invalidEntity) {
+				stack.push_back(i);
+			}
+		}
+		while (!stack.empty()) {
+			uint index = stack.back();
+			stack.pop_back();
+			indices[index] = (u32)order.size();
+			order.push_back(index);
+			for (Entity child = getNode(index).firstChild; child != invalidEntity; child = getNode(getIndex(child)).nextSibling) {
+				stack.push_back(getIndex(child));
+			}
+		}
+
+		SceneBlobWriter writer((u32)order.size());
+		std::vector<Transform> transforms(order.size());
+		std::vector<SavedParent> parents(order.size());
+		std::vector<SavedMesh> meshes(order.size());
+		std::unordered_map<const AssetSlot *, u32> meshPaths;
+		for (size_t i = 0; i < order.size(); ++i) {
+			const Node &node = getNode(order[i]);
+			transforms[i] = node.transform;
+			parents[i].parent = node.parent != invalidEntity ? indices[getIndex(node.parent)] : noIndex;
+			meshes[i].path = noIndex;
+			if (const AssetSlot *slot = node.mesh.getSlot()) {
+				std::unordered_map<const AssetSlot *, u32>::iterator it = meshPaths.find(slot);
+				meshes[i].path = it != meshPaths.end() ? it->second : (meshPaths[slot] = writer.addString(slot->path));
+			}
+		}
+
+		if (!order.empty()) {
+			writer.addComponents(getTransformType(), &transforms[0]);
+			writer.addComponents(getParentType(), &parents[0]);
+			writer.addComponents(getMeshType(), &meshes[0]);
+		}
+		return writer.save(path);
+	}
+
+	ENCOSHAREDAPI bool Scene::load(const std::string &path, AssetManager *assets) {
+		SceneBlob blob;
+		if (!blob.load(path)) {
+			return false;
+		}
+
+		u32 count = blob.getEntityCount();
+		const Transform *transforms = blob.getComponents<Transform>(getTransformType());
+		const SavedParent *parents = blob.getComponents<SavedParent>(getParentType());
+		const SavedMesh *meshes = blob.getComponents<SavedMesh>(getMeshType());
+		if (count && !transforms) {
+#ifdef _DEBUG
+			printf("Scene Error: %s has no transforms\n", path.c_str());
+#endif
+			return false;
+		}
+
+		std::vector<Entity> entities(count);
+		std::vector<Asset<MeshAsset>> meshAssets(assets && meshes ? blob.getStringCount() : 0);
+		for (u32 i = 0; i < count; ++i) {
+			u32 parent = parents ? parents[i].parent : noIndex;
+			entities[i] = createEntity(parent < i ? entities[parent] : invalidEntity, transforms[i]);
+
+			u32 mesh = meshes ? meshes[i].path : noIndex;
+			if (mesh < meshAssets.size() && entities[i] != invalidEntity) {
+				if (!meshAssets[mesh].getSlot()) {
+					meshAssets[mesh] = assets->loadAsync<MeshAsset>(blob.getString(mesh));
+				}
+				setMesh(entities[i], meshAssets[mesh]);
+			}
+		}
+		return true;
+	}
+
+	void Scene::markDirty(uint index) {
+		if (!getNode(index).dirty) {
+			getNode(index).dirty = true;
+			m_dirty.push_back(index);
+		}
+	}
+
+	void Scene::updateWorld(uint index) {
+		m_stack.clear();
+		m_stack.push_back(index);
+		while (!m_stack.empty()) {
+			Node &node = getNode(m_stack.back());
+			m_stack.pop_back();
+
+			node.world = node.parent != invalidEntity ? getNode(getIndex(node.parent)).world * toMatrix(node.transform) : toMatrix(node.transform);
+			node.dirty = false;
+			for (Entity child = node.firstChild; child != invalidEntity; child = getNode(getIndex(child)).nextSibling) {
+				m_stack.push_back(getIndex(child));
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+#ifndef __ENCOSHARED_SCENE_H__
+#define __ENCOSHARED_SCENE_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "MemoryTracker.h"
+#include "MeshData.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <glm\gtc\quaternion.hpp>
+
+namespace enco {
+	// Slot index + 1 in the low 24 bits and the generation of the slot in the high 8 bits, 0 is no entity
+	typedef u32 Entity;
+
+	struct Transform {
+		glm::vec3 position;
+		glm::quat rotation;
+		glm::vec3 scale;
+
+		inline Transform() : position(0.0f), scale(1.0f) {  }
+		inline Transform(const glm::vec3 &position, const glm::quat &rotation, const glm::vec3 &scale) : position(position), rotation(rotation), scale(scale) {  }
+	};
+
+	// Entities with a transform hierarchy and an optional mesh. Slots of destroyed entities are reused, so the
+	// memory taken only depends on how many entities are alive at once. World matrices are brought up to date by
+	// updateTransforms(), which only visits the entities that changed and their descendants.
+	class Scene {
+	public:
+		static const Entity invalidEntity = 0;
+
+		ENCOSHAREDAPI Scene();
+		ENCOSHAREDAPI ~Scene();
+
+		ENCOSHAREDAPI Entity createEntity(Entity parent = invalidEntity, const Transform &transform = Transform());
+		// Destroys the children as well
+		ENCOSHAREDAPI void destroyEntity(Entity entity);
+		ENCOSHAREDAPI bool isAlive(Entity entity) const;
+
+		inline Entity getParent(Entity entity) const { return getNode(getIndex(entity)).parent; }
+		inline Entity getFirstChild(Entity entity) const { return getNode(getIndex(entity)).firstChild; }
+		inline Entity getNextSibling(Entity entity) const { return getNode(getIndex(entity)).nextSibling; }
+
+		inline const Transform &getTransform(Entity entity) const { return getNode(getIndex(entity)).transform; }
+		ENCOSHAREDAPI void setTransform(Entity entity, const Transform &transform);
+		// As of the last updateTransforms()
+		inline const glm::mat4 &getWorldMatrix(Entity entity) const { return getNode(getIndex(entity)).world; }
+
+		inline const Asset<MeshAsset> &getMesh(Entity entity) const { return getNode(getIndex(entity)).mesh; }
+		inline void setMesh(Entity entity, const Asset<MeshAsset> &mesh) { getNode(getIndex(entity)).mesh = mesh; }
+
+		ENCOSHAREDAPI void updateTransforms();
+
+		// Writes every entity to a SceneBlob file, parents before their children
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+		// Adds the entities of a file written by save(), their meshes are loaded through assets when there is one
+		ENCOSHAREDAPI bool load(const std::string &path, AssetManager *assets = nullptr);
+
+		inline uint getEntityCount() const { return m_entityCount; }
+		// Slots ever used, the entities are found by trying every slot with isAlive()
+		inline uint getCapacity() const { return m_nodeCount; }
+		inline Entity getEntity(uint slot) const { return makeEntity(slot, getNode(slot).generation); }
+
+	private:
+		// Nodes are allocated in chunks that never move, so growing the scene never copies the entities there are
+		static const uint chunkShift = 10;
+		static const uint chunkSize = 1 << chunkShift;
+
+		struct Node {
+			Transform transform;
+			glm::mat4 world;
+			Asset<MeshAsset> mesh;
+			Entity parent, firstChild, nextSibling;
+			u8 generation;
+			bool alive;
+			bool dirty;
+
+			inline Node() : parent(invalidEntity), firstChild(invalidEntity), nextSibling(invalidEntity), generation(0), alive(false), dirty(false) {  }
+		};
+
+		typedef TaggedVector<Node, ecsMemory> Chunk;
+
+		Scene(const Scene &) = delete;
+		Scene &operator=(const Scene &) = delete;
+
+		inline Node &getNode(uint index) { return m_chunks[index >> chunkShift][index & (chunkSize - 1)]; }
+		inline const Node &getNode(uint index) const { return m_chunks[index >> chunkShift][index & (chunkSize - 1)]; }
+		static inline uint getIndex(Entity entity) { return (entity & 0xFFFFFF) - 1; }
+		static inline Entity makeEntity(uint index, u8 generation) { return ((Entity)generation << 24) | (index + 1); }
+
+		void markDirty(uint index);
+		void updateWorld(uint index);
+
+		TaggedVector<Chunk, ecsMemory> m_chunks;
+		uint m_nodeCount;
+		TaggedVector<uint, ecsMemory> m_freeNodes;
+		// Roots of the subtrees whose world matrices are out of date
+		TaggedVector<uint, ecsMemory> m_dirty;
+		TaggedVector<uint, ecsMemory> m_stack;
+		uint m_entityCount;
+	};
+}
+
+#endif
\ No newline at end of file
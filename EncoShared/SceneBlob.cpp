@@ -0,0 +1,317 @@
+#include "stdafx.h"
+#include "SceneBlob.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	namespace {
+		const u32 fileVersion = 1;
+
+		// References are u64 offsets from the start of the blob that loading turns into addresses, so the blob has
+		// the same layout on 32 and 64 bit builds. The fix-up table itself is never fixed up.
+		struct BlobHeader {
+			char magic[4];
+			u32 version;
+			u64 size;
+			u32 entityCount;
+			u32 componentCount;
+			u32 stringCount;
+			u32 fixupCount;
+			u64 components;
+			u64 strings;
+			u64 fixups;
+		};
+
+		struct BlobComponent {
+			u64 name;
+			u64 fields;
+			u64 data;
+			u32 version;
+			u32 size;
+			u32 fieldCount;
+			u32 padding;
+		};
+
+		struct BlobField {
+			u64 name;
+			u32 type;
+			u32 offset;
+		};
+
+		u64 allocate(std::vector<u8> &blob, size_t size, size_t alignment) {
+			size_t offset = (blob.size() + alignment - 1) & ~(alignment - 1);
+			blob.resize(offset + size, 0);
+			return offset;
+		}
+
+		void setReference(std::vector<u8> &blob, std::vector<u64> &fixups, u64 slot, u64 target) {
+			memcpy(&blob[(size_t)slot], &target, sizeof(target));
+			fixups.push_back(slot);
+		}
+
+		u64 writeString(std::vector<u8> &blob, const std::string &string) {
+			u64 offset = allocate(blob, string.size() + 1, 1);
+			memcpy(&blob[(size_t)offset], string.c_str(), string.size() + 1);
+			return offset;
+		}
+
+		bool contains(u64 begin, u64 end, u64 address, u64 bytes) {
+			return address >= begin && address <= end && end - address >= bytes;
+		}
+
+		bool containsString(u64 begin, u64 end, u64 address) {
+			return contains(begin, end, address, 1) && memchr((const void *)(uintptr_t)address, 0, (size_t)(end - address)) != nullptr;
+		}
+
+		bool sameLayout(const ReflectedType &type, const BlobField *fields, u32 fieldCount, u32 size) {
+			if (type.size != size || type.fields.size() != fieldCount) {
+				return false;
+			}
+			for (u32 i = 0; i < fieldCount; ++i) {
+				const ReflectedField &field = type.fields[i];
+				if (field.type != fields[i].type || field.offset != fields[i].offset || field.name != (const char *)(uintptr_t)fields[i].name) {
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	ENCOSHAREDAPI SceneBlobWriter::SceneBlobWriter(u32 entityCount) : m_entityCount(entityCount) {
+	}
+
+	ENCOSHAREDAPI void SceneBlobWriter::addComponents(const ReflectedType &type, const void *components) {
+		m_sections.push_back(Section(type));
+		const u8 *bytes = static_cast<const u8 *>(components);
+		m_sections.back().components.assign(bytes, bytes + (size_t)m_entityCount * type.size);
+	}
+
+	ENCOSHAREDAPI u32 SceneBlobWriter::addString(const std::string &string) {
+		std::map<std::string, u32>::iterator it = m_stringIndices.find(string);
+		if (it != m_stringIndices.end()) {
+			return it->second;
+		}
+
+		u32 index = (u32)m_strings.size();
+		m_strings.push_back(string);
+		m_stringIndices[string] = index;
+		return index;
+	}
+
+	ENCOSHAREDAPI bool SceneBlobWriter::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		std::vector<u8> blob(sizeof(BlobHeader), 0);
+		std::vector<u64> fixups;
+		BlobHeader header;
+		memcpy(header.magic, "ESCB", 4);
+		header.version = fileVersion;
+		header.entityCount = m_entityCount;
+		header.componentCount = (u32)m_sections.size();
+		header.stringCount = (u32)m_strings.size();
+		header.components = allocate(blob, m_sections.size() * sizeof(BlobComponent), 8);
+		header.strings = allocate(blob, m_strings.size() * sizeof(u64), 8);
+		fixups.push_back(offsetof(BlobHeader, components));
+		fixups.push_back(offsetof(BlobHeader, strings));
+
+		for (size_t i = 0; i < m_strings.size(); ++i) {
+			setReference(blob, fixups, header.strings + i * sizeof(u64), writeString(blob, m_strings[i]));
+		}
+
+		for (size_t i = 0; i < m_sections.size(); ++i) {
+			const ReflectedType &type = m_sections[i].type;
+			u64 fields = allocate(blob, type.fields.size() * sizeof(BlobField), 8);
+			for (size_t j = 0; j < type.fields.size(); ++j) {
+				u64 slot = fields + j * sizeof(BlobField);
+				BlobField field;
+				field.name = 0;
+				field.type = type.fields[j].type;
+				field.offset = type.fields[j].offset;
+				memcpy(&blob[(size_t)slot], &field, sizeof(field));
+				setReference(blob, fixups, slot + offsetof(BlobField, name), writeString(blob, type.fields[j].name));
+			}
+
+			u64 data = allocate(blob, m_sections[i].components.size(), 8);
+			if (!m_sections[i].components.empty()) {
+				memcpy(&blob[(size_t)data], &m_sections[i].components[0], m_sections[i].components.size());
+			}
+
+			u64 slot = header.components + i * sizeof(BlobComponent);
+			BlobComponent component;
+			memset(&component, 0, sizeof(component));
+			component.version = type.version;
+			component.size = type.size;
+			component.fieldCount = (u32)type.fields.size();
+			memcpy(&blob[(size_t)slot], &component, sizeof(component));
+			setReference(blob, fixups, slot + offsetof(BlobComponent, name), writeString(blob, type.name));
+			setReference(blob, fixups, slot + offsetof(BlobComponent, fields), fields);
+			setReference(blob, fixups, slot + offsetof(BlobComponent, data), data);
+		}
+
+		// The references of the header were listed as fix-ups up front
+		header.fixupCount = (u32)fixups.size();
+		header.fixups = allocate(blob, fixups.size() * sizeof(u64), 8);
+		if (!fixups.empty()) {
+			memcpy(&blob[(size_t)header.fixups], &fixups[0], fixups.size() * sizeof(u64));
+		}
+		header.size = blob.size();
+		memcpy(&blob[0], &header, sizeof(header));
+
+		file.write((const char *)&blob[0], blob.size());
+		return file.good();
+	}
+
+	ENCOSHAREDAPI SceneBlob::SceneBlob() : m_entityCount(0), m_stringCount(0), m_strings(nullptr) {
+	}
+
+	ENCOSHAREDAPI SceneBlob::~SceneBlob() {
+	}
+
+	ENCOSHAREDAPI bool SceneBlob::load(const std::string &path) {
+		m_blob.clear();
+		m_components.clear();
+		m_migrated.clear();
+		m_entityCount = m_stringCount = 0;
+		m_strings = nullptr;
+
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		u64 size = (u64)file.tellg();
+		file.seekg(0);
+		if (size < sizeof(BlobHeader) || size % sizeof(u64) != 0) {
+#ifdef _DEBUG
+			printf("SceneBlob Error: %s is not a scene blob\n", path.c_str());
+#endif
+			return false;
+		}
+
+		// A u64 array keeps the blob 8 byte aligned
+		m_blob.resize((size_t)(size / sizeof(u64)));
+		u8 *base = (u8 *)&m_blob[0];
+		if (!file.read((char *)base, size)) {
+			return false;
+		}
+
+		BlobHeader &header = *(BlobHeader *)base;
+		if (memcmp(header.magic, "ESCB", 4) != 0 || header.version == 0 || header.version > fileVersion || header.size != size || header.fixups % sizeof(u64) != 0 || header.fixups > size || (size - header.fixups) / sizeof(u64) < header.fixupCount) {
+#ifdef _DEBUG
+			printf("SceneBlob Error: %s is not a scene blob of version %u or older\n", path.c_str(), fileVersion);
+#endif
+			m_blob.clear();
+			return false;
+		}
+
+		const u64 *fixups = (const u64 *)(base + header.fixups);
+		for (u32 i = 0; i < header.fixupCount; ++i) {
+			u64 slot = fixups[i];
+			if (slot % sizeof(u64) != 0 || slot + sizeof(u64) > size || *(u64 *)(base + slot) > size) {
+#ifdef _DEBUG
+				printf("SceneBlob Error: %s has a reference outside of it\n", path.c_str());
+#endif
+				m_blob.clear();
+				return false;
+			}
+			*(u64 *)(base + slot) += (u64)(uintptr_t)base;
+		}
+
+		// Everything below only checks that the references stay inside the blob, nothing is copied
+		u64 begin = (u64)(uintptr_t)base, end = begin + size;
+		bool valid = contains(begin, end, header.components, (u64)header.componentCount * sizeof(BlobComponent)) && contains(begin, end, header.strings, (u64)header.stringCount * sizeof(u64));
+		const u64 *strings = (const u64 *)(uintptr_t)header.strings;
+		for (u32 i = 0; valid && i < header.stringCount; ++i) {
+			valid = containsString(begin, end, strings[i]);
+		}
+
+		const BlobComponent *components = (const BlobComponent *)(uintptr_t)header.components;
+		for (u32 i = 0; valid && i < header.componentCount; ++i) {
+			const BlobComponent &component = components[i];
+			valid = containsString(begin, end, component.name) && contains(begin, end, component.fields, (u64)component.fieldCount * sizeof(BlobField)) && contains(begin, end, component.data, (u64)header.entityCount * component.size);
+
+			const BlobField *fields = (const BlobField *)(uintptr_t)component.fields;
+			for (u32 j = 0; valid && j < component.fieldCount; ++j) {
+				valid = containsString(begin, end, fields[j].name) && fields[j].type <= FieldTypeString && (u64)fields[j].offset + getFieldSize((FieldType)fields[j].type) <= component.size;
+			}
+
+			Component entry;
+			entry.name = (const char *)(uintptr_t)component.name;
+			entry.fields = fields;
+			entry.data = (const u8 *)(uintptr_t)component.data;
+			entry.version = component.version;
+			entry.size = component.size;
+			entry.fieldCount = component.fieldCount;
+			m_components.push_back(entry);
+		}
+
+		if (!valid) {
+#ifdef _DEBUG
+			printf("SceneBlob Error: %s is damaged\n", path.c_str());
+#endif
+			m_blob.clear();
+			m_components.clear();
+			return false;
+		}
+
+		m_entityCount = header.entityCount;
+		m_stringCount = header.stringCount;
+		m_strings = strings;
+		return true;
+	}
+
+	ENCOSHAREDAPI const void *SceneBlob::getComponents(const ReflectedType &type) {
+		const Component *component = nullptr;
+		for (size_t i = 0; i < m_components.size() && !component; ++i) {
+			if (type.name == m_components[i].name) {
+				component = &m_components[i];
+			}
+		}
+		if (!component) {
+			return nullptr;
+		}
+
+		const BlobField *fields = (const BlobField *)component->fields;
+		if (sameLayout(type, fields, component->fieldCount, component->size) && (component->version == type.version || !type.migration)) {
+			return component->data;
+		}
+
+		std::map<std::string, std::vector<u8>>::iterator it = m_migrated.find(type.name);
+		if (it != m_migrated.end()) {
+			return it->second.empty() ? nullptr : &it->second[0];
+		}
+
+		// Pairs of source and destination offsets of the fields both layouts have
+		std::vector<std::pair<u32, u32>> copies;
+		std::vector<u32> sizes;
+		for (size_t i = 0; i < type.fields.size(); ++i) {
+			for (u32 j = 0; j < component->fieldCount; ++j) {
+				if (fields[j].type == type.fields[i].type && type.fields[i].name == (const char *)(uintptr_t)fields[j].name) {
+					copies.push_back(std::make_pair(fields[j].offset, type.fields[i].offset));
+					sizes.push_back(getFieldSize(type.fields[i].type));
+					break;
+				}
+			}
+		}
+
+		std::vector<u8> &migrated = m_migrated[type.name];
+		migrated.resize((size_t)m_entityCount * type.size, 0);
+		for (u32 i = 0; i < m_entityCount; ++i) {
+			u8 *destination = &migrated[(size_t)i * type.size];
+			const u8 *source = component->data + (size_t)i * component->size;
+			if (type.defaults) {
+				memcpy(destination, type.defaults, type.size);
+			}
+			for (size_t j = 0; j < copies.size(); ++j) {
+				memcpy(destination + copies[j].second, source + copies[j].first, sizes[j]);
+			}
+		}
+		if (component->version != type.version && type.migration && !migrated.empty()) {
+			type.migration(component->version, &migrated[0], m_entityCount);
+		}
+		return migrated.empty() ? nullptr : &migrated[0];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef __ENCOSHARED_SCENEBLOB_H__
+#define __ENCOSHARED_SCENEBLOB_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Reflection.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Collects one array of components per type, each with an element for every entity, and writes them as a
+	// blob a SceneBlob can use right after reading it.
+	class SceneBlobWriter {
+	public:
+		ENCOSHAREDAPI SceneBlobWriter(u32 entityCount);
+
+		// Copies entityCount components of type.size bytes each
+		ENCOSHAREDAPI void addComponents(const ReflectedType &type, const void *components);
+		// Index for FieldTypeString fields, equal strings share an index
+		ENCOSHAREDAPI u32 addString(const std::string &string);
+
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+
+	private:
+		struct Section {
+			ReflectedType type;
+			std::vector<u8> components;
+
+			inline Section(const ReflectedType &type) : type(type) {  }
+		};
+
+		u32 m_entityCount;
+		std::vector<Section> m_sections;
+		std::vector<std::string> m_strings;
+		std::map<std::string, u32> m_stringIndices;
+	};
+
+	// A saved scene read with a single read. Every reference inside the blob is stored as an offset and listed in a
+	// fix-up table, loading only adds the address of the blob to each of them. Components whose type still has the
+	// layout they were saved with are used in place, others are migrated the first time they are asked for.
+	class SceneBlob {
+	public:
+		ENCOSHAREDAPI SceneBlob();
+		ENCOSHAREDAPI ~SceneBlob();
+
+		ENCOSHAREDAPI bool load(const std::string &path);
+
+		inline u32 getEntityCount() const { return m_entityCount; }
+		inline u32 getStringCount() const { return m_stringCount; }
+		inline const char *getString(u32 index) const { return (const char *)(uintptr_t)m_strings[index]; }
+
+		// getEntityCount() components with the layout of type, nullptr when the blob has none of them. Stays valid
+		// as long as the blob.
+		ENCOSHAREDAPI const void *getComponents(const ReflectedType &type);
+
+		template<typename T>
+		inline const T *getComponents(const ReflectedType &type) { return static_cast<const T *>(getComponents(type)); }
+
+		// Types that had to be migrated so far
+		inline uint getMigratedCount() const { return (uint)m_migrated.size(); }
+
+	private:
+		struct Component {
+			const char *name;
+			const void *fields;
+			const u8 *data;
+			u32 version;
+			u32 size;
+			u32 fieldCount;
+		};
+
+		SceneBlob(const SceneBlob &) = delete;
+		SceneBlob &operator=(const SceneBlob &) = delete;
+
+		std::vector<u64> m_blob;
+		u32 m_entityCount;
+		u32 m_stringCount;
+		// Fixed up to addresses
+		const u64 *m_strings;
+		std::vector<Component> m_components;
+		std::map<std::string, std::vector<u8>> m_migrated;
+	};
+}
+
+#endif
\ No newline at end of file
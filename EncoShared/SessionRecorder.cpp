@@ -0,0 +1,313 @@
+#include "stdafx.h"
+#include "SessionRecorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	namespace {
+		const u32 fileVersion = 1;
+
+		struct SessionFileHeader {
+			char magic[4];
+			u32 version;
+			u64 seed;
+			f32 fixedTimestep;
+			u32 frameCount;
+			u32 eventCount;
+			u32 reserved;
+		};
+
+		template<typename T>
+		inline void write(std::vector<u8> &buffer, const T &value) {
+			const u8 *bytes = (const u8 *)&value;
+			buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+		}
+
+		template<typename T>
+		inline bool read(const std::vector<u8> &buffer, size_t &cursor, T &value) {
+			if (buffer.size() - cursor < sizeof(T)) {
+				return false;
+			}
+			memcpy(&value, &buffer[cursor], sizeof(T));
+			cursor += sizeof(T);
+			return true;
+		}
+
+		// Bytes after the common part of an event, only the union member its type uses is stored
+		inline size_t getPayloadSize(InputEventType type) {
+			switch (type) {
+			case mouseMotionEvent: return 4 * sizeof(i32);
+			case mouseWheelEvent: return 2 * sizeof(i32);
+			case gamepadAxisEvent: return sizeof(f32);
+			default: return 0;
+			}
+		}
+
+		f32 getPercentile(std::vector<f32> &values, f32 percentile) {
+			if (values.empty()) {
+				return 0.0f;
+			}
+			size_t index = std::min(values.size() - 1, (size_t)(percentile * values.size()));
+			std::nth_element(values.begin(), values.begin() + index, values.end());
+			return values[index];
+		}
+
+		f32 getMean(const std::vector<f32> &values) {
+			f64 sum = 0.0;
+			for (size_t i = 0; i < values.size(); ++i) {
+				sum += values[i];
+			}
+			return values.empty() ? 0.0f : (f32)(sum / values.size());
+		}
+
+		bool exceeds(f32 baseline, f32 current, f32 tolerance) {
+			return baseline > 0.0f && current > baseline * (1.0f + tolerance);
+		}
+	}
+
+	ENCOSHAREDAPI SessionRecording::SessionRecording() : seed(0), fixedTimestep(0.0f) {
+	}
+
+	ENCOSHAREDAPI void SessionRecording::clear() {
+		seed = 0;
+		fixedTimestep = 0.0f;
+		frames.clear();
+		events.clear();
+		eventViews.clear();
+	}
+
+	ENCOSHAREDAPI bool SessionRecording::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		SessionFileHeader header;
+		memcpy(header.magic, "ESES", 4);
+		header.version = fileVersion;
+		header.seed = seed;
+		header.fixedTimestep = fixedTimestep;
+		header.frameCount = (u32)frames.size();
+		header.eventCount = (u32)events.size();
+		header.reserved = 0;
+
+		std::vector<u8> buffer;
+		buffer.reserve(sizeof(header) + frames.size() * sizeof(Frame) + events.size() * 16);
+		write(buffer, header);
+		for (size_t i = 0; i < frames.size(); ++i) {
+			write(buffer, frames[i]);
+		}
+		for (size_t i = 0; i < events.size(); ++i) {
+			const InputEvent &event = events[i];
+			write(buffer, eventViews[i]);
+			write(buffer, (u8)event.type);
+			write(buffer, event.device);
+			write(buffer, event.code);
+			write(buffer, event.timestamp);
+			const u8 *payload = (const u8 *)&event.motion;
+			buffer.insert(buffer.end(), payload, payload + getPayloadSize(event.type));
+		}
+
+		file.write((const char *)&buffer[0], buffer.size());
+		return file.good();
+	}
+
+	ENCOSHAREDAPI bool SessionRecording::load(const std::string &path) {
+		clear();
+
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+		if (!file) {
+			return false;
+		}
+		std::vector<u8> buffer((size_t)file.tellg());
+		file.seekg(0);
+		if (!buffer.empty() && !file.read((char *)&buffer[0], buffer.size())) {
+			return false;
+		}
+
+		size_t cursor = 0;
+		SessionFileHeader header;
+		if (!read(buffer, cursor, header) || memcmp(header.magic, "ESES", 4) != 0 || header.version == 0 || header.version > fileVersion) {
+#ifdef _DEBUG
+			printf("SessionRecorder Error: %s is not a session of version %u or older\n", path.c_str(), fileVersion);
+#endif
+			return false;
+		}
+
+		bool valid = (buffer.size() - cursor) / sizeof(Frame) >= header.frameCount;
+		frames.resize(valid ? header.frameCount : 0);
+		u64 eventCount = 0;
+		for (size_t i = 0; i < frames.size(); ++i) {
+			read(buffer, cursor, frames[i]);
+			eventCount += frames[i].eventCount;
+		}
+		valid = valid && eventCount == header.eventCount;
+
+		// At least one byte per event, so a damaged count cannot make this allocate more than the file holds
+		if (valid && header.eventCount <= buffer.size() - cursor) {
+			events.resize(header.eventCount);
+			eventViews.resize(header.eventCount);
+		}
+		for (size_t i = 0; valid && i < events.size(); ++i) {
+			InputEvent &event = events[i];
+			memset(&event, 0, sizeof(event));
+			u8 type = 0;
+			valid = read(buffer, cursor, eventViews[i]) && read(buffer, cursor, type) && read(buffer, cursor, event.device) && read(buffer, cursor, event.code) && read(buffer, cursor, event.timestamp) && type <= gamepadDisconnectedEvent;
+			if (valid) {
+				event.type = (InputEventType)type;
+				size_t size = getPayloadSize(event.type);
+				valid = buffer.size() - cursor >= size;
+				if (valid) {
+					memcpy(&event.motion, &buffer[cursor], size);
+					cursor += size;
+				}
+			}
+		}
+
+		if (!valid || events.size() != header.eventCount) {
+#ifdef _DEBUG
+			printf("SessionRecorder Error: %s is damaged\n", path.c_str());
+#endif
+			clear();
+			return false;
+		}
+
+		seed = header.seed;
+		fixedTimestep = header.fixedTimestep;
+		return true;
+	}
+
+	ENCOSHAREDAPI SessionRecorder::SessionRecorder() : m_recording(false), m_replaying(false), m_frame(0), m_nextEvent(0) {
+	}
+
+	ENCOSHAREDAPI void SessionRecorder::startRecording(u64 seed, f32 fixedTimestep, const std::vector<std::shared_ptr<IView>> &views) {
+		stopReplay();
+
+		m_session.clear();
+		m_session.seed = seed;
+		m_session.fixedTimestep = fixedTimestep;
+		for (size_t i = 0; i < views.size(); ++i) {
+			views[i]->getInput().setRecording(true);
+		}
+		m_recording = true;
+		m_frame = 0;
+	}
+
+	ENCOSHAREDAPI bool SessionRecorder::stopRecording(const std::string &path, const std::vector<std::shared_ptr<IView>> &views) {
+		if (!m_recording) {
+			return false;
+		}
+
+		for (size_t i = 0; i < views.size(); ++i) {
+			views[i]->getInput().setRecording(false);
+		}
+		m_recording = false;
+		return m_session.save(path);
+	}
+
+	ENCOSHAREDAPI bool SessionRecorder::startReplay(const std::string &path) {
+		m_recording = false;
+		stopReplay();
+		if (!m_session.load(path)) {
+			return false;
+		}
+
+		m_replaying = true;
+		m_timings.clear();
+		return true;
+	}
+
+	ENCOSHAREDAPI void SessionRecorder::stopReplay() {
+		m_replaying = false;
+		m_frame = 0;
+		m_nextEvent = 0;
+	}
+
+	ENCOSHAREDAPI bool SessionRecorder::beginFrame(f32 &frameTime) {
+		if (m_replaying) {
+			if (m_frame >= m_session.frames.size()) {
+				return false;
+			}
+			frameTime = m_session.frames[m_frame].frameTime;
+		}
+		else if (m_recording) {
+			SessionRecording::Frame frame;
+			frame.frameTime = frameTime;
+			frame.eventCount = 0;
+			m_session.frames.push_back(frame);
+		}
+		return true;
+	}
+
+	ENCOSHAREDAPI void SessionRecorder::processInput(const std::vector<std::shared_ptr<IView>> &views) {
+		if (m_recording && !m_session.frames.empty()) {
+			for (size_t i = 0; i < views.size() && i < 256; ++i) {
+				const std::vector<InputEvent> &events = views[i]->getInput().getFrameEvents();
+				m_session.events.insert(m_session.events.end(), events.begin(), events.end());
+				m_session.eventViews.insert(m_session.eventViews.end(), events.size(), (u8)i);
+				m_session.frames.back().eventCount += (u32)events.size();
+			}
+		}
+		else if (m_replaying && m_frame < m_session.frames.size()) {
+			u32 count = m_session.frames[m_frame].eventCount;
+			for (u32 i = 0; i < count; ++i, ++m_nextEvent) {
+				u8 view = m_session.eventViews[m_nextEvent];
+				if (view < views.size()) {
+					views[view]->getInput().push(m_session.events[m_nextEvent]);
+				}
+			}
+			for (size_t i = 0; i < views.size(); ++i) {
+				views[i]->getInput().swap();
+			}
+		}
+	}
+
+	ENCOSHAREDAPI void SessionRecorder::endFrame(f32 cpuTime, f32 gpuTime) {
+		if (m_replaying) {
+			FrameTiming timing;
+			timing.cpuTime = cpuTime;
+			timing.gpuTime = gpuTime;
+			m_timings.push_back(timing);
+		}
+		if (m_replaying || m_recording) {
+			++m_frame;
+		}
+	}
+
+	ENCOSHAREDAPI FrameTimingSummary SessionRecorder::summarizeTimings() const {
+		std::vector<f32> cpu(m_timings.size()), gpu(m_timings.size());
+		for (size_t i = 0; i < m_timings.size(); ++i) {
+			cpu[i] = m_timings[i].cpuTime;
+			gpu[i] = m_timings[i].gpuTime;
+		}
+
+		FrameTimingSummary summary;
+		summary.frameCount = (uint)m_timings.size();
+		summary.cpuMean = getMean(cpu);
+		summary.gpuMean = getMean(gpu);
+		summary.cpuMedian = getPercentile(cpu, 0.5f);
+		summary.gpuMedian = getPercentile(gpu, 0.5f);
+		summary.cpu95 = getPercentile(cpu, 0.95f);
+		summary.gpu95 = getPercentile(gpu, 0.95f);
+		return summary;
+	}
+
+	ENCOSHAREDAPI bool SessionRecorder::saveTimings(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out);
+		if (!file) {
+			return false;
+		}
+
+		file << "frame,cpu,gpu\n";
+		for (size_t i = 0; i < m_timings.size(); ++i) {
+			file << i << ',' << m_timings[i].cpuTime << ',' << m_timings[i].gpuTime << '\n';
+		}
+		return file.good();
+	}
+
+	ENCOSHAREDAPI bool SessionRecorder::isRegression(const FrameTimingSummary &baseline, const FrameTimingSummary &current, f32 tolerance) {
+		return exceeds(baseline.cpuMean, current.cpuMean, tolerance) || exceeds(baseline.cpu95, current.cpu95, tolerance) || exceeds(baseline.gpuMean, current.gpuMean, tolerance) || exceeds(baseline.gpu95, current.gpu95, tolerance);
+	}
+}
\ No newline at end of file
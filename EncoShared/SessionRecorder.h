@@ -0,0 +1,97 @@
+#ifndef __ENCOSHARED_SESSIONRECORDER_H__
+#define __ENCOSHARED_SESSIONRECORDER_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "IView.h"
+#include "Input.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Milliseconds
+	struct FrameTiming {
+		f32 cpuTime;
+		f32 gpuTime;
+	};
+
+	struct FrameTimingSummary {
+		uint frameCount;
+		f32 cpuMean, cpuMedian, cpu95;
+		f32 gpuMean, gpuMedian, gpu95;
+	};
+
+	// Everything that decides how a session plays out: the seed of EncoContext::getRandom(), the fixed timestep,
+	// the frame time of every update() and the input events each view received in it
+	class SessionRecording {
+	public:
+		struct Frame {
+			f32 frameTime;
+			u32 eventCount;
+		};
+
+		ENCOSHAREDAPI SessionRecording();
+
+		ENCOSHAREDAPI void clear();
+
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+		ENCOSHAREDAPI bool load(const std::string &path);
+
+		u64 seed;
+		f32 fixedTimestep;
+		std::vector<Frame> frames;
+		// The events of all frames in order, eventViews holds the index of the view each one went to
+		std::vector<InputEvent> events;
+		std::vector<u8> eventViews;
+	};
+
+	// Records sessions and replays them frame by frame, measuring every replayed frame. EncoContext drives it
+	// from update(). A replay is meant for views that do not receive input of their own, e.g. OffscreenView.
+	class SessionRecorder {
+	public:
+		ENCOSHAREDAPI SessionRecorder();
+
+		ENCOSHAREDAPI void startRecording(u64 seed, f32 fixedTimestep, const std::vector<std::shared_ptr<IView>> &views);
+		ENCOSHAREDAPI bool stopRecording(const std::string &path, const std::vector<std::shared_ptr<IView>> &views);
+
+		ENCOSHAREDAPI bool startReplay(const std::string &path);
+		ENCOSHAREDAPI void stopReplay();
+
+		inline bool isRecording() const { return m_recording; }
+		inline bool isReplaying() const { return m_replaying; }
+		inline const SessionRecording &getRecording() const { return m_session; }
+		inline uint getFrameIndex() const { return m_frame; }
+
+		// Replays hand out the recorded frame time instead, false once every recorded frame was played
+		ENCOSHAREDAPI bool beginFrame(f32 &frameTime);
+		// Right after the views updated, records their events or pushes the recorded ones
+		ENCOSHAREDAPI void processInput(const std::vector<std::shared_ptr<IView>> &views);
+		ENCOSHAREDAPI void endFrame(f32 cpuTime, f32 gpuTime);
+
+		// One per replayed frame. GPU times lag behind by the few frames the renderer needs to read them back.
+		inline const std::vector<FrameTiming> &getTimings() const { return m_timings; }
+		ENCOSHAREDAPI FrameTimingSummary summarizeTimings() const;
+		// frame,cpu,gpu per line
+		ENCOSHAREDAPI bool saveTimings(const std::string &path) const;
+
+		// True when the mean or the 95th percentile of the CPU or GPU time of current exceeds the one of baseline
+		// by more than tolerance, e.g. 0.02 for 2%
+		ENCOSHAREDAPI static bool isRegression(const FrameTimingSummary &baseline, const FrameTimingSummary &current, f32 tolerance = 0.02f);
+
+	private:
+		SessionRecorder(const SessionRecorder &) = delete;
+		SessionRecorder &operator=(const SessionRecorder &) = delete;
+
+		SessionRecording m_session;
+		bool m_recording;
+		bool m_replaying;
+		uint m_frame;
+		size_t m_nextEvent;
+		std::vector<FrameTiming> m_timings;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#include "stdafx.h"
+#include "ShadowCascades.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm\gtc\matrix_transform.hpp>
+
+namespace enco {
+	ENCOSHAREDAPI ShadowCascades::ShadowCascades(uint cascadeCount, uint resolution) : m_cascadeCount(cascadeCount == 0 ? 1 : (cascadeCount > maxCascades ? maxCascades : cascadeCount)), m_resolution(resolution), m_splitLambda(0.75f), m_firstCachedCascade(2), m_cacheMoveThreshold(0.1f), m_casterDistance(100.0f), m_minCasterTexels(1.0f), m_lightDirection(0.0f), m_staticInvalid(true) {
+		for (uint i = 0; i < maxCascades; ++i) {
+			m_cascades[i].splitNear = m_cascades[i].splitFar = 0.0f;
+			m_cascades[i].texelSize = 0.0f;
+			m_cascades[i].isCached = false;
+			m_cascades[i].needsStaticUpdate = true;
+			m_cascades[i].cachedCenter = glm::vec3(0.0f);
+		}
+	}
+
+	ENCOSHAREDAPI ShadowCascades::~ShadowCascades() {
+	}
+
+	ENCOSHAREDAPI void ShadowCascades::update(const glm::mat4 &cameraView, const glm::mat4 &cameraProjection, f32 nearPlane, f32 farPlane, const glm::vec3 &lightDirection) {
+		glm::vec3 direction = glm::normalize(lightDirection);
+		if (glm::dot(direction, m_lightDirection) < 0.9999f) {
+			m_lightDirection = direction;
+			m_staticInvalid = true;
+		}
+
+		// The light rotation is the same for all cascades, only the ortho window moves
+		glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		glm::mat4 lightRotation = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+		glm::mat4 inverseView = glm::inverse(cameraView);
+		glm::mat4 inverseProjection = glm::inverse(cameraProjection);
+		glm::vec3 rays[4];
+		for (int i = 0; i < 4; ++i) {
+			glm::vec4 corner = inverseProjection * glm::vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, -1.0f, 1.0f);
+			glm::vec3 ray = glm::vec3(corner) / corner.w;
+			rays[i] = ray / -ray.z;
+		}
+
+		const glm::mat4 bias(
+			0.5f, 0.0f, 0.0f, 0.0f,
+			0.0f, 0.5f, 0.0f, 0.0f,
+			0.0f, 0.0f, 0.5f, 0.0f,
+			0.5f, 0.5f, 0.5f, 1.0f);
+
+		f32 splitNear = nearPlane;
+		for (uint i = 0; i < m_cascadeCount; ++i) {
+			ShadowCascade &cascade = m_cascades[i];
+
+			f32 fraction = (f32)(i + 1) / m_cascadeCount;
+			f32 logSplit = nearPlane * std::pow(farPlane / nearPlane, fraction);
+			f32 linearSplit = nearPlane + (farPlane - nearPlane) * fraction;
+			f32 splitFar = m_splitLambda * logSplit + (1.0f - m_splitLambda) * linearSplit;
+
+			cascade.splitNear = splitNear;
+			cascade.splitFar = splitFar;
+			splitNear = splitFar;
+
+			// Bounding sphere of the slice in view space, independent of the camera orientation
+			glm::vec3 centroid(0.0f);
+			for (int j = 0; j < 4; ++j) {
+				centroid += rays[j] * cascade.splitNear + rays[j] * cascade.splitFar;
+			}
+			centroid /= 8.0f;
+
+			f32 radius = 0.0f;
+			for (int j = 0; j < 4; ++j) {
+				radius = std::max(radius, glm::length(rays[j] * cascade.splitNear - centroid));
+				radius = std::max(radius, glm::length(rays[j] * cascade.splitFar - centroid));
+			}
+			// Rounding keeps float noise from resizing the cascade every frame
+			radius = std::ceil(radius * 16.0f) / 16.0f;
+
+			glm::vec3 center = glm::vec3(inverseView * glm::vec4(centroid, 1.0f));
+
+			bool wasCached = cascade.isCached;
+			cascade.isCached = i >= m_firstCachedCascade;
+			if (cascade.isCached) {
+				f32 threshold = m_cacheMoveThreshold * radius;
+				if (m_staticInvalid || !wasCached || glm::length(center - cascade.cachedCenter) > threshold) {
+					cascade.cachedCenter = center;
+					cascade.needsStaticUpdate = true;
+				}
+				else {
+					cascade.needsStaticUpdate = false;
+				}
+
+				// Grown by the move threshold so the slice stays covered while the cascade holds still
+				center = cascade.cachedCenter;
+				radius += threshold;
+			}
+			else {
+				cascade.needsStaticUpdate = true;
+			}
+
+			// Snap the window to whole texels in light space
+			cascade.texelSize = 2.0f * radius / m_resolution;
+			glm::vec3 lightCenter = glm::vec3(lightRotation * glm::vec4(center, 1.0f));
+			lightCenter.x = std::floor(lightCenter.x / cascade.texelSize) * cascade.texelSize;
+			lightCenter.y = std::floor(lightCenter.y / cascade.texelSize) * cascade.texelSize;
+
+			cascade.view = lightRotation;
+			cascade.projection = glm::ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius, -lightCenter.z - radius - m_casterDistance, -lightCenter.z + radius);
+			cascade.viewProjection = cascade.projection * cascade.view;
+			cascade.shadowMatrix = bias * cascade.viewProjection;
+			cascade.frustum.set(cascade.viewProjection);
+		}
+
+		m_staticInvalid = false;
+	}
+
+	ENCOSHAREDAPI void ShadowCascades::invalidateStatic() {
+		m_staticInvalid = true;
+	}
+
+	ENCOSHAREDAPI void ShadowCascades::cull(const std::vector<ShadowCaster> &casters, JobSystem &jobSystem) {
+		jobSystem.parallelFor(m_cascadeCount, 1, [this, &casters](uint begin, uint end) {
+			for (uint i = begin; i < end; ++i) {
+				cullCascade(i, casters);
+			}
+		});
+	}
+
+	void ShadowCascades::cullCascade(uint index, const std::vector<ShadowCaster> &casters) {
+		ShadowCascade &cascade = m_cascades[index];
+		cascade.staticCasters.clear();
+		cascade.dynamicCasters.clear();
+
+		bool skipStatic = cascade.isCached && !cascade.needsStaticUpdate;
+		f32 minSize = cascade.texelSize * m_minCasterTexels;
+
+		for (u32 i = 0; i < (u32)casters.size(); ++i) {
+			const ShadowCaster &caster = casters[i];
+			if (caster.isStatic && skipStatic) {
+				continue;
+			}
+			if (glm::length(caster.bounds.getExtents()) * 2.0f < minSize || !cascade.frustum.intersects(caster.bounds)) {
+				continue;
+			}
+
+			(caster.isStatic ? cascade.staticCasters : cascade.dynamicCasters).push_back(i);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+#ifndef __ENCOSHARED_SHADOWCASCADES_H__
+#define __ENCOSHARED_SHADOWCASCADES_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+#include "JobSystem.h"
+
+#include <vector>
+
+namespace enco {
+	struct ShadowCaster {
+		AABB bounds;
+		bool isStatic;
+
+		inline ShadowCaster() : isStatic(false) {  }
+		inline ShadowCaster(const AABB &bounds, bool isStatic) : bounds(bounds), isStatic(isStatic) {  }
+	};
+
+	struct ShadowCascade {
+		f32 splitNear, splitFar;
+		glm::mat4 view, projection, viewProjection;
+		// viewProjection followed by the [-1, 1] to [0, 1] bias, what the shader samples with
+		glm::mat4 shadowMatrix;
+		Frustum frustum;
+		f32 texelSize;
+
+		// Cached cascades keep their static casters in a separate map and only redraw them when this is set
+		bool isCached;
+		bool needsStaticUpdate;
+		glm::vec3 cachedCenter;
+
+		std::vector<u32> staticCasters;
+		std::vector<u32> dynamicCasters;
+	};
+
+	// Directional light cascades with stable splits: every cascade covers the bounding sphere of its slice
+	// of the view frustum, which does not change size when the camera rotates, and its origin is snapped to
+	// whole shadow map texels so edges do not shimmer when it moves. The distant cascades are cached, they
+	// keep their placement until the camera moved a fraction of their size or static casters changed.
+	class ShadowCascades {
+	public:
+		static const uint maxCascades = 4;
+
+		ENCOSHAREDAPI ShadowCascades(uint cascadeCount = 4, uint resolution = 2048);
+		ENCOSHAREDAPI ~ShadowCascades();
+
+		// 0 splits linearly, 1 logarithmically
+		inline void setSplitLambda(f32 lambda) { m_splitLambda = lambda; }
+		// Cascades from firstCachedCascade on are cached, cascadeCount disables caching
+		inline void setFirstCachedCascade(uint cascade) { m_firstCachedCascade = cascade; invalidateStatic(); }
+		// Fraction of a cached cascade's radius the camera may move before it is re-rendered
+		inline void setCacheMoveThreshold(f32 fraction) { m_cacheMoveThreshold = fraction; }
+		// How far behind a cascade casters are still picked up, in world units
+		inline void setCasterDistance(f32 distance) { m_casterDistance = distance; }
+		// Casters smaller than this many shadow map texels are skipped
+		inline void setMinCasterTexels(f32 texels) { m_minCasterTexels = texels; }
+
+		ENCOSHAREDAPI void update(const glm::mat4 &cameraView, const glm::mat4 &cameraProjection, f32 nearPlane, f32 farPlane, const glm::vec3 &lightDirection);
+
+		// Static casters were added, removed or moved
+		ENCOSHAREDAPI void invalidateStatic();
+
+		// Fills the caster lists of every cascade, one job per cascade. Cached cascades only list
+		// static casters when they are re-rendered this frame.
+		ENCOSHAREDAPI void cull(const std::vector<ShadowCaster> &casters, JobSystem &jobSystem);
+
+		inline uint getCascadeCount() const { return m_cascadeCount; }
+		inline uint getResolution() const { return m_resolution; }
+		inline const ShadowCascade &getCascade(uint index) const { return m_cascades[index]; }
+
+	private:
+		void cullCascade(uint index, const std::vector<ShadowCaster> &casters);
+
+		uint m_cascadeCount;
+		uint m_resolution;
+		f32 m_splitLambda;
+		uint m_firstCachedCascade;
+		f32 m_cacheMoveThreshold;
+		f32 m_casterDistance;
+		f32 m_minCasterTexels;
+
+		glm::vec3 m_lightDirection;
+		bool m_staticInvalid;
+
+		ShadowCascade m_cascades[maxCascades];
+	};
+}
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef __ENCOSHARED_SIMD_H__
+#define __ENCOSHARED_SIMD_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define ENCO_SIMD_SSE
+#	include <emmintrin.h>
+#endif
+
+namespace enco {
+	// Four packed floats, SSE2 where available and plain arrays otherwise so every kernel has one code path.
+	// Loads and stores are unaligned, masks are all-ones or all-zeros lanes.
+#ifdef ENCO_SIMD_SSE
+	typedef __m128 SimdFloat4;
+
+	inline SimdFloat4 simdLoad(const f32 *p) { return _mm_loadu_ps(p); }
+	inline void simdStore(f32 *p, SimdFloat4 a) { _mm_storeu_ps(p, a); }
+	inline SimdFloat4 simdSet(f32 x) { return _mm_set1_ps(x); }
+	inline SimdFloat4 simdSet(f32 x, f32 y, f32 z, f32 w) { return _mm_setr_ps(x, y, z, w); }
+	inline SimdFloat4 simdZero() { return _mm_setzero_ps(); }
+
+	inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { return _mm_add_ps(a, b); }
+	inline SimdFloat4 simdSub(SimdFloat4 a, SimdFloat4 b) { return _mm_sub_ps(a, b); }
+	inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { return _mm_mul_ps(a, b); }
+	inline SimdFloat4 simdDiv(SimdFloat4 a, SimdFloat4 b) { return _mm_div_ps(a, b); }
+	inline SimdFloat4 simdMulAdd(SimdFloat4 a, SimdFloat4 b, SimdFloat4 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+	inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { return _mm_min_ps(a, b); }
+	inline SimdFloat4 simdMax(SimdFloat4 a, SimdFloat4 b) { return _mm_max_ps(a, b); }
+
+	inline SimdFloat4 simdLess(SimdFloat4 a, SimdFloat4 b) { return _mm_cmplt_ps(a, b); }
+	inline SimdFloat4 simdGreater(SimdFloat4 a, SimdFloat4 b) { return _mm_cmpgt_ps(a, b); }
+	inline SimdFloat4 simdAnd(SimdFloat4 a, SimdFloat4 b) { return _mm_and_ps(a, b); }
+	inline SimdFloat4 simdOr(SimdFloat4 a, SimdFloat4 b) { return _mm_or_ps(a, b); }
+	// mask ? a : b
+	inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	// Bit i is set when lane i of the mask is set
+	inline int simdMoveMask(SimdFloat4 mask) { return _mm_movemask_ps(mask); }
+
+	template<int lane>
+	inline SimdFloat4 simdSplat(SimdFloat4 a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(lane, lane, lane, lane)); }
+#else
+#	include <cstring>
+
+	struct SimdFloat4 {
+		f32 v[4];
+	};
+
+	inline SimdFloat4 simdLoad(const f32 *p) { SimdFloat4 r = { { p[0], p[1], p[2], p[3] } }; return r; }
+	inline void simdStore(f32 *p, SimdFloat4 a) { p[0] = a.v[0]; p[1] = a.v[1]; p[2] = a.v[2]; p[3] = a.v[3]; }
+	inline SimdFloat4 simdSet(f32 x) { SimdFloat4 r = { { x, x, x, x } }; return r; }
+	inline SimdFloat4 simdSet(f32 x, f32 y, f32 z, f32 w) { SimdFloat4 r = { { x, y, z, w } }; return r; }
+	inline SimdFloat4 simdZero() { return simdSet(0.0f); }
+
+#	define ENCO_SIMD_LANES(expression) SimdFloat4 r; for (int i = 0; i < 4; ++i) { r.v[i] = (expression); } return r;
+	inline SimdFloat4 simdAdd(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(a.v[i] + b.v[i]) }
+	inline SimdFloat4 simdSub(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(a.v[i] - b.v[i]) }
+	inline SimdFloat4 simdMul(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(a.v[i] * b.v[i]) }
+	inline SimdFloat4 simdDiv(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(a.v[i] / b.v[i]) }
+	inline SimdFloat4 simdMulAdd(SimdFloat4 a, SimdFloat4 b, SimdFloat4 c) { ENCO_SIMD_LANES(a.v[i] * b.v[i] + c.v[i]) }
+	inline SimdFloat4 simdMin(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(a.v[i] < b.v[i] ? a.v[i] : b.v[i]) }
+	inline SimdFloat4 simdMax(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(a.v[i] > b.v[i] ? a.v[i] : b.v[i]) }
+
+	inline f32 simdBitsToLane(u32 bits) { f32 lane; memcpy(&lane, &bits, 4); return lane; }
+	inline u32 simdLaneBits(f32 lane) { u32 bits; memcpy(&bits, &lane, 4); return bits; }
+	inline SimdFloat4 simdLess(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(simdBitsToLane(a.v[i] < b.v[i] ? 0xFFFFFFFF : 0)) }
+	inline SimdFloat4 simdGreater(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(simdBitsToLane(a.v[i] > b.v[i] ? 0xFFFFFFFF : 0)) }
+	inline SimdFloat4 simdAnd(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(simdBitsToLane(simdLaneBits(a.v[i]) & simdLaneBits(b.v[i]))) }
+	inline SimdFloat4 simdOr(SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(simdBitsToLane(simdLaneBits(a.v[i]) | simdLaneBits(b.v[i]))) }
+	inline SimdFloat4 simdSelect(SimdFloat4 mask, SimdFloat4 a, SimdFloat4 b) { ENCO_SIMD_LANES(simdLaneBits(mask.v[i]) ? a.v[i] : b.v[i]) }
+	inline int simdMoveMask(SimdFloat4 mask) { int r = 0; for (int i = 0; i < 4; ++i) { r |= simdLaneBits(mask.v[i]) ? 1 << i : 0; } return r; }
+#	undef ENCO_SIMD_LANES
+
+	template<int lane>
+	inline SimdFloat4 simdSplat(SimdFloat4 a) { return simdSet(a.v[lane]); }
+#endif
+
+	// out = a * b for column-major 4x4 matrices, out may alias neither input
+	inline void simdMultiplyMatrix(const f32 *a, const f32 *b, f32 *out) {
+		SimdFloat4 a0 = simdLoad(a), a1 = simdLoad(a + 4), a2 = simdLoad(a + 8), a3 = simdLoad(a + 12);
+		for (int column = 0; column < 4; ++column) {
+			SimdFloat4 b4 = simdLoad(b + column * 4);
+			SimdFloat4 result = simdMul(a0, simdSplat<0>(b4));
+			result = simdMulAdd(a1, simdSplat<1>(b4), result);
+			result = simdMulAdd(a2, simdSplat<2>(b4), result);
+			result = simdMulAdd(a3, simdSplat<3>(b4), result);
+			simdStore(out + column * 4, result);
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include "stdafx.h"
+#include "Skeleton.h"
+
+#include "Simd.h"
+
+namespace enco {
+	ENCOSHAREDAPI void JointTransform::toMatrix(f32 *matrix) const {
+		f32 x = rotation.x, y = rotation.y, z = rotation.z, w = rotation.w;
+		f32 xx = x * x, yy = y * y, zz = z * z;
+		f32 xy = x * y, xz = x * z, yz = y * z;
+		f32 wx = w * x, wy = w * y, wz = w * z;
+
+		matrix[0] = (1.0f - 2.0f * (yy + zz)) * scale.x;
+		matrix[1] = 2.0f * (xy + wz) * scale.x;
+		matrix[2] = 2.0f * (xz - wy) * scale.x;
+		matrix[3] = 0.0f;
+
+		matrix[4] = 2.0f * (xy - wz) * scale.y;
+		matrix[5] = (1.0f - 2.0f * (xx + zz)) * scale.y;
+		matrix[6] = 2.0f * (yz + wx) * scale.y;
+		matrix[7] = 0.0f;
+
+		matrix[8] = 2.0f * (xz + wy) * scale.z;
+		matrix[9] = 2.0f * (yz - wx) * scale.z;
+		matrix[10] = (1.0f - 2.0f * (xx + yy)) * scale.z;
+		matrix[11] = 0.0f;
+
+		matrix[12] = translation.x;
+		matrix[13] = translation.y;
+		matrix[14] = translation.z;
+		matrix[15] = 1.0f;
+	}
+
+	ENCOSHAREDAPI JointTransform JointTransform::blend(const JointTransform &a, const JointTransform &b, f32 weight) {
+		JointTransform result;
+		result.translation = a.translation + (b.translation - a.translation) * weight;
+		result.scale = a.scale + (b.scale - a.scale) * weight;
+
+		f32 sign = glm::dot(a.rotation, b.rotation) < 0.0f ? -1.0f : 1.0f;
+		glm::quat rotation = a.rotation * (1.0f - weight) + b.rotation * (weight * sign);
+		result.rotation = glm::normalize(rotation);
+		return result;
+	}
+
+	ENCOSHAREDAPI int Skeleton::addJoint(const std::string &name, int parent, const JointTransform &bindPose) {
+		if (m_parents.size() >= maxJoints || parent >= (int)m_parents.size()) {
+#ifdef _DEBUG
+			printf("Skeleton Error: Cannot add joint %s\n", name.c_str());
+#endif
+			return noParent;
+		}
+
+		if (parent < 0) {
+			parent = noParent;
+		}
+
+		m_names.push_back(name);
+		m_parents.push_back(parent);
+		m_bindPose.push_back(bindPose);
+		return (int)m_parents.size() - 1;
+	}
+
+	ENCOSHAREDAPI void Skeleton::finalize() {
+		std::vector<glm::mat4> model(m_parents.size());
+		m_inverseBindMatrices.resize(m_parents.size());
+		for (size_t i = 0; i < m_parents.size(); ++i) {
+			glm::mat4 local;
+			m_bindPose[i].toMatrix(&local[0][0]);
+			if (m_parents[i] == noParent) {
+				model[i] = local;
+			}
+			else {
+				simdMultiplyMatrix(&model[m_parents[i]][0][0], &local[0][0], &model[i][0][0]);
+			}
+			m_inverseBindMatrices[i] = glm::inverse(model[i]);
+		}
+	}
+
+	ENCOSHAREDAPI int Skeleton::findJoint(const std::string &name) const {
+		for (size_t i = 0; i < m_names.size(); ++i) {
+			if (m_names[i] == name) {
+				return (int)i;
+			}
+		}
+		return noParent;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef __ENCOSHARED_SKELETON_H__
+#define __ENCOSHARED_SKELETON_H__
+
+#pragma once
+
+#include "stdafx.h"
+
+#include <string>
+#include <vector>
+
+#include <glm\gtc\quaternion.hpp>
+
+namespace enco {
+	struct JointTransform {
+		glm::vec3 translation;
+		glm::quat rotation;
+		glm::vec3 scale;
+
+		inline JointTransform() : translation(0.0f), rotation(1.0f, 0.0f, 0.0f, 0.0f), scale(1.0f) {  }
+
+		// Column-major translation * rotation * scale, written to 16 floats
+		ENCOSHAREDAPI void toMatrix(f32 *matrix) const;
+
+		// Lerps translation and scale and nlerps the rotation along the shorter arc
+		ENCOSHAREDAPI static JointTransform blend(const JointTransform &a, const JointTransform &b, f32 weight);
+	};
+
+	// Joints are stored parents first, so a single pass in index order computes model space transforms.
+	// Skinned vertices reference joints with a u8, which limits a skeleton to maxJoints joints.
+	class Skeleton {
+	public:
+		static const uint maxJoints = 256;
+		static const int noParent = -1;
+
+		// parent has to be added before, returns the joint index or noParent when the skeleton is full
+		ENCOSHAREDAPI int addJoint(const std::string &name, int parent, const JointTransform &bindPose);
+
+		// Computes the inverse bind matrices from the bind pose, call after the last addJoint
+		ENCOSHAREDAPI void finalize();
+
+		ENCOSHAREDAPI int findJoint(const std::string &name) const;
+
+		inline uint getJointCount() const { return (uint)m_parents.size(); }
+		inline int getParent(uint joint) const { return m_parents[joint]; }
+		inline const std::string &getName(uint joint) const { return m_names[joint]; }
+		inline const JointTransform &getBindPose(uint joint) const { return m_bindPose[joint]; }
+		inline const std::vector<JointTransform> &getBindPose() const { return m_bindPose; }
+		inline const glm::mat4 &getInverseBindMatrix(uint joint) const { return m_inverseBindMatrices[joint]; }
+
+	private:
+		std::vector<std::string> m_names;
+		std::vector<int> m_parents;
+		std::vector<JointTransform> m_bindPose;
+		std::vector<glm::mat4> m_inverseBindMatrices;
+	};
+}
+
+#endif
\ No newline at end of file
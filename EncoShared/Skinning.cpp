@@ -0,0 +1,66 @@
+#include "stdafx.h"
+#include "Skinning.h"
+
+#include "Simd.h"
+
+#include <cmath>
+
+namespace enco {
+	ENCOSHAREDAPI void Skinning::skin(const MeshVertex *source, const SkinWeights *weights, uint begin, uint end, const glm::mat4 *palette, uint paletteSize, MeshVertex *destination) {
+		const f32 weightScale = 1.0f / 255.0f;
+		f32 position[4], normal[4];
+
+		for (uint i = begin; i < end; ++i) {
+			const SkinWeights &skin = weights[i];
+			SimdFloat4 columns[4] = { simdZero(), simdZero(), simdZero(), simdZero() };
+			for (int j = 0; j < 4; ++j) {
+				if (skin.weights[j] == 0 || skin.joints[j] >= paletteSize) {
+					continue;
+				}
+
+				const f32 *matrix = &palette[skin.joints[j]][0][0];
+				SimdFloat4 weight = simdSet(skin.weights[j] * weightScale);
+				for (int column = 0; column < 4; ++column) {
+					columns[column] = simdMulAdd(simdLoad(matrix + column * 4), weight, columns[column]);
+				}
+			}
+
+			const MeshVertex &vertex = source[i];
+			SimdFloat4 result = simdMulAdd(columns[0], simdSet(vertex.position.x), columns[3]);
+			result = simdMulAdd(columns[1], simdSet(vertex.position.y), result);
+			result = simdMulAdd(columns[2], simdSet(vertex.position.z), result);
+			simdStore(position, result);
+
+			// Assumes uniformly scaled joints, otherwise normals would need the inverse transpose
+			result = simdMul(columns[0], simdSet(vertex.normal.x));
+			result = simdMulAdd(columns[1], simdSet(vertex.normal.y), result);
+			result = simdMulAdd(columns[2], simdSet(vertex.normal.z), result);
+			simdStore(normal, result);
+
+			MeshVertex &skinned = destination[i];
+			skinned.position = glm::vec3(position[0], position[1], position[2]);
+			f32 length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			skinned.normal = length > 0.0f ? glm::vec3(normal[0], normal[1], normal[2]) / length : vertex.normal;
+			skinned.texCoord = vertex.texCoord;
+		}
+	}
+
+	ENCOSHAREDAPI void Skinning::skin(const MeshData &mesh, const glm::mat4 *palette, uint paletteSize, MeshVertex *destination, JobSystem *jobSystem) {
+		if (!mesh.isSkinned()) {
+			return;
+		}
+
+		const MeshVertex *source = &mesh.vertices[0];
+		const SkinWeights *weights = &mesh.skinWeights[0];
+		uint count = (uint)mesh.vertices.size();
+		const uint batchSize = 4096;
+		if (!jobSystem || count <= batchSize) {
+			skin(source, weights, 0, count, palette, paletteSize, destination);
+			return;
+		}
+
+		jobSystem->parallelFor(count, batchSize, [source, weights, palette, paletteSize, destination](uint begin, uint end) {
+			skin(source, weights, begin, end, palette, paletteSize, destination);
+		});
+	}
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef __ENCOSHARED_SKINNING_H__
+#define __ENCOSHARED_SKINNING_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "JobSystem.h"
+#include "MeshData.h"
+
+namespace enco {
+	// Linear blend skinning on the CPU for renderers without vertex shader skinning, e.g. headless ones.
+	// The four weighted palette matrices of a vertex are summed with SIMD before transforming it once.
+	class Skinning {
+	public:
+		// Skins vertices [begin, end) into destination, which is indexed like source. Joints outside the palette
+		// are skipped together with their weight.
+		ENCOSHAREDAPI static void skin(const MeshVertex *source, const SkinWeights *weights, uint begin, uint end, const glm::mat4 *palette, uint paletteSize, MeshVertex *destination);
+
+		// destination has room for all vertices of the mesh, large meshes are split over the job system
+		ENCOSHAREDAPI static void skin(const MeshData &mesh, const glm::mat4 *palette, uint paletteSize, MeshVertex *destination, JobSystem *jobSystem = nullptr);
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,521 @@
+#include "stdafx.h"
+#include "SpatialQuery.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const uint maxAdvanceIterations = 32;
+		// Conservative advancement stops this close to the surface
+		const f32 advanceTolerance = 1e-4f;
+		const uint queryBatchSize = 64;
+
+		// The probe of sweeps and overlaps, the sphere radius is added on top
+		const CollisionShape pointShape = CollisionShape::sphere(0.0f);
+
+		// Exact ray tests for the common shapes, with the ray in the space of the shape
+		bool raySphere(const glm::vec3 &origin, const glm::vec3 &direction, f32 radius, f32 maxDistance, f32 &distance, glm::vec3 &normal) {
+			f32 b = glm::dot(origin, direction), c = glm::dot(origin, origin) - radius * radius;
+			if (c <= 0.0f) {
+				distance = 0.0f;
+				normal = -direction;
+				return true;
+			}
+			f32 discriminant = b * b - c;
+			if (b > 0.0f || discriminant < 0.0f) {
+				return false;
+			}
+			distance = -b - sqrtf(discriminant);
+			if (distance > maxDistance) {
+				return false;
+			}
+			normal = (origin + direction * distance) / radius;
+			return true;
+		}
+
+		bool rayBox(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &halfExtents, f32 maxDistance, f32 &distance, glm::vec3 &normal) {
+			f32 enter = 0.0f, leave = maxDistance;
+			int enterAxis = -1;
+			for (uint axis = 0; axis < 3; ++axis) {
+				if (fabsf(direction[axis]) < 1e-12f) {
+					if (fabsf(origin[axis]) > halfExtents[axis]) {
+						return false;
+					}
+					continue;
+				}
+				f32 inverse = 1.0f / direction[axis];
+				f32 t0 = (-halfExtents[axis] - origin[axis]) * inverse, t1 = (halfExtents[axis] - origin[axis]) * inverse;
+				if (t0 > t1) {
+					std::swap(t0, t1);
+				}
+				if (t0 > enter) {
+					enter = t0;
+					enterAxis = (int)axis;
+				}
+				leave = std::min(leave, t1);
+				if (enter > leave) {
+					return false;
+				}
+			}
+
+			distance = enter;
+			if (enterAxis < 0) {
+				normal = -direction;
+			}
+			else {
+				normal = glm::vec3(0.0f);
+				normal[enterAxis] = direction[enterAxis] > 0.0f ? -1.0f : 1.0f;
+			}
+			return true;
+		}
+
+		// Moves a sphere along the ray in steps that cannot pass the shape: the distance to the plane of the closest
+		// feature. Works for every convex shape through GJK.
+		bool advanceShape(const CollisionShape &shape, const ShapeTransform &transform, const glm::vec3 &origin, const glm::vec3 &direction, f32 radius, f32 maxDistance, f32 &distance, glm::vec3 &position, glm::vec3 &normal) {
+			ShapeTransform probe;
+			probe.position = origin;
+			f32 total = radius + shape.getRadius();
+			f32 t = 0.0f;
+			for (uint iteration = 0; iteration < maxAdvanceIterations; ++iteration) {
+				glm::vec3 pointA, pointB;
+				if (!Narrowphase::closestPoints(pointShape, probe, shape, transform, pointA, pointB)) {
+					// The center is inside the core, only possible when the sweep starts there
+					distance = t;
+					normal = -direction;
+					position = probe.position;
+					return true;
+				}
+
+				glm::vec3 delta = pointA - pointB;
+				f32 length = glm::length(delta);
+				glm::vec3 separation = length > 1e-12f ? delta / length : -direction;
+				f32 gap = length - total;
+				if (gap <= advanceTolerance) {
+					distance = t;
+					normal = separation;
+					position = pointB + separation * shape.getRadius();
+					return true;
+				}
+
+				f32 approach = -glm::dot(direction, separation);
+				if (approach <= 1e-6f) {
+					return false;
+				}
+				t += gap / approach;
+				if (t > maxDistance) {
+					return false;
+				}
+				probe.position = origin + direction * t;
+			}
+			return false;
+		}
+
+		// Ericson, Real-Time Collision Detection 5.1.5
+		glm::vec3 closestOnTriangle(const glm::vec3 &p, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+			glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+			f32 d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+			if (d1 <= 0.0f && d2 <= 0.0f) {
+				return a;
+			}
+			glm::vec3 bp = p - b;
+			f32 d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+			if (d3 >= 0.0f && d4 <= d3) {
+				return b;
+			}
+			f32 vc = d1 * d4 - d3 * d2;
+			if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+				return a + ab * (d1 / (d1 - d3));
+			}
+			glm::vec3 cp = p - c;
+			f32 d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+			if (d6 >= 0.0f && d5 <= d6) {
+				return c;
+			}
+			f32 vb = d5 * d2 - d1 * d6;
+			if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+				return a + ac * (d2 / (d2 - d6));
+			}
+			f32 va = d3 * d6 - d5 * d4;
+			if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+				return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+			}
+			f32 denominator = 1.0f / (va + vb + vc);
+			return a + ab * (vb * denominator) + ac * (vc * denominator);
+		}
+
+		bool advanceTriangle(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, const glm::vec3 &origin, const glm::vec3 &direction, f32 radius, f32 maxDistance, f32 &distance, glm::vec3 &position, glm::vec3 &normal) {
+			f32 t = 0.0f;
+			glm::vec3 center = origin;
+			for (uint iteration = 0; iteration < maxAdvanceIterations; ++iteration) {
+				glm::vec3 closest = closestOnTriangle(center, a, b, c);
+				glm::vec3 delta = center - closest;
+				f32 length = glm::length(delta);
+				f32 gap = length - radius;
+				if (gap <= advanceTolerance) {
+					distance = t;
+					position = closest;
+					normal = length > 1e-12f ? delta / length : -direction;
+					return true;
+				}
+
+				f32 approach = -glm::dot(direction, delta / length);
+				if (approach <= 1e-6f) {
+					return false;
+				}
+				t += gap / approach;
+				if (t > maxDistance) {
+					return false;
+				}
+				center = origin + direction * t;
+			}
+			return false;
+		}
+
+		inline glm::vec3 transformPoint(const glm::mat4 &matrix, const glm::vec3 &point) {
+			return glm::vec3(matrix * glm::vec4(point, 1.0f));
+		}
+
+		inline AABB sweptBox(const RayQuery &ray, f32 radius, f32 distance) {
+			glm::vec3 end = ray.origin + ray.direction * distance;
+			return AABB(glm::min(ray.origin, end) - glm::vec3(radius), glm::max(ray.origin, end) + glm::vec3(radius));
+		}
+	}
+
+	ENCOSHAREDAPI void QueryBatch::clear() {
+		m_rays.clear();
+		m_sweeps.clear();
+		m_overlaps.clear();
+		m_rayHits.clear();
+		m_sweepHits.clear();
+		m_overlapHits.clear();
+		m_done.store(false, std::memory_order_release);
+	}
+
+	ENCOSHAREDAPI SpatialQuery::SpatialQuery(const PhysicsWorld *world) : m_world(world), m_meshTree(0.0f) {
+	}
+
+	ENCOSHAREDAPI SpatialQuery::~SpatialQuery() {
+	}
+
+	ENCOSHAREDAPI u32 SpatialQuery::addMesh(std::shared_ptr<const TriangleMesh> mesh, const glm::mat4 &transform, u32 userData) {
+		if (!mesh || mesh->getTriangleCount() == 0) {
+			return invalidMesh;
+		}
+
+		u32 index;
+		if (!m_freeMeshes.empty()) {
+			index = m_freeMeshes.back();
+			m_freeMeshes.pop_back();
+		}
+		else {
+			index = (u32)m_meshes.size();
+			m_meshes.push_back(MeshInstance());
+		}
+
+		MeshInstance &instance = m_meshes[index];
+		instance.mesh = mesh;
+		instance.transform = transform;
+		instance.inverse = glm::inverse(transform);
+		instance.userData = userData;
+		instance.proxy = m_meshTree.createProxy(mesh->getBounds().transform(transform), index);
+		instance.used = true;
+		return index;
+	}
+
+	ENCOSHAREDAPI void SpatialQuery::setMeshTransform(u32 instance, const glm::mat4 &transform) {
+		MeshInstance &target = m_meshes[instance];
+		target.transform = transform;
+		target.inverse = glm::inverse(transform);
+		// Static meshes have no margin, so a mesh that moves is always reinserted with tight bounds
+		m_meshTree.destroyProxy(target.proxy);
+		target.proxy = m_meshTree.createProxy(target.mesh->getBounds().transform(transform), instance);
+	}
+
+	ENCOSHAREDAPI void SpatialQuery::removeMesh(u32 instance) {
+		if (instance >= m_meshes.size() || !m_meshes[instance].used) {
+			return;
+		}
+		m_meshTree.destroyProxy(m_meshes[instance].proxy);
+		m_meshes[instance].mesh.reset();
+		m_meshes[instance].used = false;
+		m_freeMeshes.push_back(instance);
+	}
+
+	ENCOSHAREDAPI void SpatialQuery::submit(QueryHandle batch) {
+		batch->m_done.store(false, std::memory_order_release);
+		std::lock_guard<std::mutex> lock(m_pendingMutex);
+		m_pending.push_back(batch);
+	}
+
+	ENCOSHAREDAPI void SpatialQuery::update(JobSystem *jobSystem) {
+		{
+			std::lock_guard<std::mutex> lock(m_pendingMutex);
+			m_running.swap(m_pending);
+		}
+		if (m_running.empty()) {
+			return;
+		}
+
+		if (jobSystem) {
+			// Each batch is one job that splits itself up, so small batches do not wait behind large ones
+			JobCounter counter;
+			for (size_t i = 0; i < m_running.size(); ++i) {
+				QueryBatch *batch = m_running[i].get();
+				jobSystem->run([this, batch, jobSystem]() { execute(*batch, jobSystem); }, &counter);
+			}
+			jobSystem->wait(counter);
+		}
+		else {
+			for (size_t i = 0; i < m_running.size(); ++i) {
+				execute(*m_running[i]);
+			}
+		}
+		m_running.clear();
+	}
+
+	ENCOSHAREDAPI void SpatialQuery::execute(QueryBatch &batch, JobSystem *jobSystem) const {
+		batch.m_done.store(false, std::memory_order_release);
+		batch.m_rayHits.assign(batch.m_rays.size(), QueryHit());
+		batch.m_sweepHits.assign(batch.m_sweeps.size(), QueryHit());
+		batch.m_overlapHits.resize(batch.m_overlaps.size());
+
+		uint count = batch.getQueryCount();
+		if (jobSystem && count > queryBatchSize) {
+			jobSystem->parallelFor(count, queryBatchSize, [this, &batch](uint begin, uint end) { answer(batch, begin, end); });
+		}
+		else {
+			answer(batch, 0, count);
+		}
+		batch.m_done.store(true, std::memory_order_release);
+	}
+
+	void SpatialQuery::answer(QueryBatch &batch, uint begin, uint end) const {
+		// Rays, then sweeps, then overlaps
+		uint rayCount = (uint)batch.m_rays.size(), sweepCount = (uint)batch.m_sweeps.size();
+		for (uint i = begin; i < end; ++i) {
+			if (i < rayCount) {
+				raycast(batch.m_rays[i], batch.m_rayHits[i]);
+			}
+			else if (i < rayCount + sweepCount) {
+				sweep(batch.m_sweeps[i - rayCount], batch.m_sweepHits[i - rayCount]);
+			}
+			else {
+				std::vector<QueryHit> &hits = batch.m_overlapHits[i - rayCount - sweepCount];
+				hits.clear();
+				overlap(batch.m_overlaps[i - rayCount - sweepCount], hits);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI bool SpatialQuery::raycast(const RayQuery &query, QueryHit &hit) const {
+		hit = QueryHit();
+		hit.distance = query.maxDistance;
+		bool found = castBodies(query, 0.0f, hit);
+		found |= castMeshes(query, 0.0f, hit);
+		if (!found) {
+			hit = QueryHit();
+		}
+		return found;
+	}
+
+	ENCOSHAREDAPI bool SpatialQuery::sweep(const SweepQuery &query, QueryHit &hit) const {
+		hit = QueryHit();
+		hit.distance = query.ray.maxDistance;
+		bool found = castBodies(query.ray, query.radius, hit);
+		found |= castMeshes(query.ray, query.radius, hit);
+		if (!found) {
+			hit = QueryHit();
+		}
+		return found;
+	}
+
+	bool SpatialQuery::castBodies(const RayQuery &ray, f32 radius, QueryHit &hit) const {
+		if (!m_world) {
+			return false;
+		}
+
+		const PhysicsWorld &world = *m_world;
+		const AabbTree &broadphase = world.getBroadphase();
+		bool found = false;
+		// Returns the closest distance so far, which the tree uses to skip farther boxes
+		auto test = [&world, &broadphase, &ray, radius, &hit, &found](u32 proxy) {
+			RigidBody body = broadphase.getUserData(proxy);
+			if (body == ray.ignoreBody) {
+				return hit.distance;
+			}
+
+			const CollisionShape &shape = world.getShape(body);
+			const ShapeTransform &transform = world.getTransform(body);
+			f32 distance;
+			glm::vec3 position, normal;
+			bool touched;
+			if (radius == 0.0f && (shape.getType() == sphereShape || shape.getType() == boxShape)) {
+				glm::quat inverse = glm::conjugate(transform.orientation);
+				glm::vec3 origin = inverse * (ray.origin - transform.position), direction = inverse * ray.direction;
+				touched = shape.getType() == sphereShape ? raySphere(origin, direction, shape.getRadius(), hit.distance, distance, normal) : rayBox(origin, direction, shape.getHalfExtents(), hit.distance, distance, normal);
+				normal = transform.orientation * normal;
+				position = ray.origin + ray.direction * distance;
+			}
+			else {
+				touched = advanceShape(shape, transform, ray.origin, ray.direction, radius, hit.distance, distance, position, normal);
+			}
+
+			if (touched && distance <= hit.distance) {
+				hit.type = bodyHit;
+				hit.object = body;
+				hit.triangle = 0;
+				hit.distance = distance;
+				hit.position = position;
+				hit.normal = normal;
+				found = true;
+			}
+			return hit.distance;
+		};
+
+		if (radius == 0.0f) {
+			f32 length = hit.distance;
+			auto cast = [&test, length](u32 proxy, f32) { return test(proxy) / length; };
+			broadphase.raycast(ray.origin, ray.origin + ray.direction * length, cast);
+		}
+		else {
+			auto touch = [&test](u32 proxy) { test(proxy); return true; };
+			broadphase.query(sweptBox(ray, radius, hit.distance), touch);
+		}
+		return found;
+	}
+
+	bool SpatialQuery::castMeshes(const RayQuery &ray, f32 radius, QueryHit &hit) const {
+		bool found = false;
+		const std::vector<MeshInstance> &meshes = m_meshes;
+		const AabbTree &tree = m_meshTree;
+
+		if (radius == 0.0f) {
+			// The local ray keeps the length of direction after scaling, so distances stay in world units
+			f32 length = hit.distance;
+			auto cast = [&meshes, &tree, &ray, &hit, &found, length](u32 proxy, f32) {
+				const MeshInstance &instance = meshes[tree.getUserData(proxy)];
+				glm::vec3 origin = transformPoint(instance.inverse, ray.origin);
+				glm::vec3 direction = glm::mat3(instance.inverse) * ray.direction;
+				u32 triangle;
+				f32 distance;
+				if (instance.mesh->raycast(origin, direction, hit.distance, triangle, distance)) {
+					glm::vec3 a, b, c;
+					instance.mesh->getTriangle(triangle, a, b, c);
+					glm::vec3 normal = glm::normalize(glm::transpose(glm::mat3(instance.inverse)) * glm::cross(b - a, c - a));
+					hit.type = meshHit;
+					hit.object = instance.userData;
+					hit.triangle = triangle;
+					hit.distance = distance;
+					hit.position = ray.origin + ray.direction * distance;
+					hit.normal = glm::dot(normal, ray.direction) > 0.0f ? -normal : normal;
+					found = true;
+				}
+				return hit.distance / length;
+			};
+			tree.raycast(ray.origin, ray.origin + ray.direction * length, cast);
+			return found;
+		}
+
+		AABB box = sweptBox(ray, radius, hit.distance);
+		auto touch = [&meshes, &tree, &ray, radius, &box, &hit, &found](u32 proxy) {
+			const MeshInstance &instance = meshes[tree.getUserData(proxy)];
+			const TriangleMesh &mesh = *instance.mesh;
+			// Sweeps run in world space, a scaled sphere would not be a sphere anymore
+			auto sweepTriangle = [&instance, &mesh, &ray, radius, &hit, &found](u32 triangle) {
+				glm::vec3 a, b, c;
+				mesh.getTriangle(triangle, a, b, c);
+				a = transformPoint(instance.transform, a);
+				b = transformPoint(instance.transform, b);
+				c = transformPoint(instance.transform, c);
+				f32 distance;
+				glm::vec3 position, normal;
+				if (advanceTriangle(a, b, c, ray.origin, ray.direction, radius, hit.distance, distance, position, normal) && distance <= hit.distance) {
+					hit.type = meshHit;
+					hit.object = instance.userData;
+					hit.triangle = triangle;
+					hit.distance = distance;
+					hit.position = position;
+					hit.normal = normal;
+					found = true;
+				}
+				return true;
+			};
+			mesh.query(box.transform(instance.inverse), sweepTriangle);
+			return true;
+		};
+		tree.query(box, touch);
+		return found;
+	}
+
+	ENCOSHAREDAPI uint SpatialQuery::overlap(const OverlapQuery &query, std::vector<QueryHit> &hits) const {
+		size_t first = hits.size();
+		AABB box(query.center - glm::vec3(query.radius), query.center + glm::vec3(query.radius));
+
+		if (m_world) {
+			const PhysicsWorld &world = *m_world;
+			const AabbTree &broadphase = world.getBroadphase();
+			ShapeTransform probe;
+			probe.position = query.center;
+			auto touch = [&world, &broadphase, &query, &probe, &hits](u32 proxy) {
+				RigidBody body = broadphase.getUserData(proxy);
+				if (body == query.ignoreBody) {
+					return true;
+				}
+				const CollisionShape &shape = world.getShape(body);
+				glm::vec3 pointA, pointB;
+				QueryHit hit;
+				if (!Narrowphase::closestPoints(pointShape, probe, shape, world.getTransform(body), pointA, pointB)) {
+					hit.position = query.center;
+				}
+				else {
+					glm::vec3 delta = pointA - pointB;
+					f32 length = glm::length(delta);
+					if (length > query.radius + shape.getRadius()) {
+						return true;
+					}
+					hit.normal = length > 1e-12f ? delta / length : glm::vec3(0.0f);
+					hit.position = pointB + hit.normal * shape.getRadius();
+				}
+				hit.type = bodyHit;
+				hit.object = body;
+				hits.push_back(hit);
+				return true;
+			};
+			broadphase.query(box, touch);
+		}
+
+		// One hit per mesh instance, at its closest triangle
+		const std::vector<MeshInstance> &meshes = m_meshes;
+		const AabbTree &tree = m_meshTree;
+		auto touch = [&meshes, &tree, &query, &box, &hits](u32 proxy) {
+			const MeshInstance &instance = meshes[tree.getUserData(proxy)];
+			const TriangleMesh &mesh = *instance.mesh;
+			QueryHit closest;
+			f32 closestDistance = query.radius * query.radius;
+			auto touchTriangle = [&instance, &mesh, &query, &closest, &closestDistance](u32 triangle) {
+				glm::vec3 a, b, c;
+				mesh.getTriangle(triangle, a, b, c);
+				glm::vec3 point = closestOnTriangle(query.center, transformPoint(instance.transform, a), transformPoint(instance.transform, b), transformPoint(instance.transform, c));
+				glm::vec3 delta = query.center - point;
+				f32 distance = glm::dot(delta, delta);
+				if (distance <= closestDistance) {
+					closestDistance = distance;
+					closest.type = meshHit;
+					closest.object = instance.userData;
+					closest.triangle = triangle;
+					closest.position = point;
+					closest.normal = distance > 1e-24f ? delta / sqrtf(distance) : glm::vec3(0.0f);
+				}
+				return true;
+			};
+			mesh.query(box.transform(instance.inverse), touchTriangle);
+			if (closest.type != noHit) {
+				hits.push_back(closest);
+			}
+			return true;
+		};
+		tree.query(box, touch);
+
+		return (uint)(hits.size() - first);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#ifndef __ENCOSHARED_SPATIALQUERY_H__
+#define __ENCOSHARED_SPATIALQUERY_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AabbTree.h"
+#include "JobSystem.h"
+#include "PhysicsWorld.h"
+#include "TriangleMesh.h"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace enco {
+	enum QueryHitType : u8 {
+		noHit = 0,
+		bodyHit,
+		meshHit
+	};
+
+	struct QueryHit {
+		QueryHitType type;
+		// The rigid body, or the user data of the mesh instance
+		u32 object;
+		// Triangle of the mesh in TriangleMesh order, 0 for bodies
+		u32 triangle;
+		// Along the ray or sweep, 0 for overlaps
+		f32 distance;
+		// On the surface of the object that was hit, for sweeps where the sphere touches it
+		glm::vec3 position;
+		glm::vec3 normal;
+
+		inline QueryHit() : type(noHit), object(0), triangle(0), distance(0.0f), position(0.0f), normal(0.0f) {  }
+	};
+
+	struct RayQuery {
+		glm::vec3 origin;
+		// Normalized
+		glm::vec3 direction;
+		f32 maxDistance;
+		// Skipped, for the body a line of sight or a bullet starts from
+		RigidBody ignoreBody;
+
+		inline RayQuery() : origin(0.0f), direction(0.0f, 0.0f, -1.0f), maxDistance(1e30f), ignoreBody(PhysicsWorld::invalidBody) {  }
+		inline RayQuery(const glm::vec3 &origin, const glm::vec3 &direction, f32 maxDistance, RigidBody ignoreBody = PhysicsWorld::invalidBody) : origin(origin), direction(direction), maxDistance(maxDistance), ignoreBody(ignoreBody) {  }
+	};
+
+	// A sphere moved along a ray, the hit is the first contact
+	struct SweepQuery {
+		RayQuery ray;
+		f32 radius;
+
+		inline SweepQuery() : radius(0.0f) {  }
+		inline SweepQuery(const RayQuery &ray, f32 radius) : ray(ray), radius(radius) {  }
+	};
+
+	// Every object touching the sphere, each reported once
+	struct OverlapQuery {
+		glm::vec3 center;
+		f32 radius;
+		RigidBody ignoreBody;
+
+		inline OverlapQuery() : center(0.0f), radius(0.0f), ignoreBody(PhysicsWorld::invalidBody) {  }
+		inline OverlapQuery(const glm::vec3 &center, f32 radius, RigidBody ignoreBody = PhysicsWorld::invalidBody) : center(center), radius(radius), ignoreBody(ignoreBody) {  }
+	};
+
+	// Queries filled on one thread and answered together. The batch must not change after it was submitted
+	// until isDone() returns true, the results are valid from then on.
+	class QueryBatch {
+	public:
+		inline QueryBatch() : m_done(false) {  }
+
+		inline uint addRay(const RayQuery &query) { m_rays.push_back(query); return (uint)m_rays.size() - 1; }
+		inline uint addSweep(const SweepQuery &query) { m_sweeps.push_back(query); return (uint)m_sweeps.size() - 1; }
+		inline uint addOverlap(const OverlapQuery &query) { m_overlaps.push_back(query); return (uint)m_overlaps.size() - 1; }
+		// Makes the batch reusable, the capacity is kept
+		ENCOSHAREDAPI void clear();
+
+		inline bool isDone() const { return m_done.load(std::memory_order_acquire); }
+
+		inline const QueryHit &getRayHit(uint query) const { return m_rayHits[query]; }
+		inline const QueryHit &getSweepHit(uint query) const { return m_sweepHits[query]; }
+		inline const std::vector<QueryHit> &getOverlapHits(uint query) const { return m_overlapHits[query]; }
+		inline uint getQueryCount() const { return (uint)(m_rays.size() + m_sweeps.size() + m_overlaps.size()); }
+
+	private:
+		friend class SpatialQuery;
+
+		QueryBatch(const QueryBatch &) = delete;
+		QueryBatch &operator=(const QueryBatch &) = delete;
+
+		std::vector<RayQuery> m_rays;
+		std::vector<SweepQuery> m_sweeps;
+		std::vector<OverlapQuery> m_overlaps;
+		std::vector<QueryHit> m_rayHits;
+		std::vector<QueryHit> m_sweepHits;
+		std::vector<std::vector<QueryHit>> m_overlapHits;
+		std::atomic<bool> m_done;
+	};
+
+	typedef std::shared_ptr<QueryBatch> QueryHandle;
+
+	// Ray, sphere sweep and sphere overlap queries against the bodies of a PhysicsWorld and static triangle meshes.
+	// Batches may be submitted from any thread and are answered by update(), each batch as one parallel job.
+	// Queries only read, so they must not overlap a physics step or changes to the meshes.
+	class SpatialQuery {
+	public:
+		static const u32 invalidMesh = 0xFFFFFFFF;
+
+		ENCOSHAREDAPI SpatialQuery(const PhysicsWorld *world = nullptr);
+		ENCOSHAREDAPI ~SpatialQuery();
+
+		inline void setPhysicsWorld(const PhysicsWorld *world) { m_world = world; }
+
+		// Mesh instances, userData is reported in QueryHit::object
+		ENCOSHAREDAPI u32 addMesh(std::shared_ptr<const TriangleMesh> mesh, const glm::mat4 &transform, u32 userData);
+		ENCOSHAREDAPI void setMeshTransform(u32 instance, const glm::mat4 &transform);
+		ENCOSHAREDAPI void removeMesh(u32 instance);
+		inline uint getMeshCount() const { return m_meshTree.getProxyCount(); }
+
+		// Thread safe, the batch is answered by the next update()
+		ENCOSHAREDAPI void submit(QueryHandle batch);
+		// Answers every submitted batch and returns when all of them are done
+		ENCOSHAREDAPI void update(JobSystem *jobSystem);
+		// Answers batch right away, spread over the job system when there is one
+		ENCOSHAREDAPI void execute(QueryBatch &batch, JobSystem *jobSystem = nullptr) const;
+
+		ENCOSHAREDAPI bool raycast(const RayQuery &query, QueryHit &hit) const;
+		ENCOSHAREDAPI bool sweep(const SweepQuery &query, QueryHit &hit) const;
+		// Appends to hits, returns the number of objects found
+		ENCOSHAREDAPI uint overlap(const OverlapQuery &query, std::vector<QueryHit> &hits) const;
+
+	private:
+		struct MeshInstance {
+			std::shared_ptr<const TriangleMesh> mesh;
+			glm::mat4 transform;
+			glm::mat4 inverse;
+			u32 userData;
+			u32 proxy;
+			bool used;
+		};
+
+		SpatialQuery(const SpatialQuery &) = delete;
+		SpatialQuery &operator=(const SpatialQuery &) = delete;
+
+		void answer(QueryBatch &batch, uint begin, uint end) const;
+		bool castBodies(const RayQuery &ray, f32 radius, QueryHit &hit) const;
+		bool castMeshes(const RayQuery &ray, f32 radius, QueryHit &hit) const;
+
+		const PhysicsWorld *m_world;
+		std::vector<MeshInstance> m_meshes;
+		std::vector<u32> m_freeMeshes;
+		AabbTree m_meshTree;
+
+		std::mutex m_pendingMutex;
+		std::vector<QueryHandle> m_pending;
+		std::vector<QueryHandle> m_running;
+	};
+}
+
+#endif
\ No newline at end of file
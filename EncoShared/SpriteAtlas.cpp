@@ -0,0 +1,231 @@
+#include "stdafx.h"
+#include "SpriteAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	struct SpriteAtlasFileHeader {
+		char magic[4];
+		u32 version;
+		u32 pageSize;
+		u32 pageCount;
+		u32 regionCount;
+	};
+
+	namespace {
+		bool isTaller(const SpriteImage *a, const SpriteImage *b) {
+			return a->height != b->height ? a->height > b->height : a->width > b->width;
+		}
+	}
+
+	ENCOSHAREDAPI SpriteAtlas::SpriteAtlas(uint pageSize, uint maxPages) : m_pageSize(pageSize), m_maxPages(std::max(maxPages, 1u)), m_generation(0) {
+	}
+
+	ENCOSHAREDAPI SpriteAtlas::~SpriteAtlas() {
+	}
+
+	ENCOSHAREDAPI void SpriteAtlas::clear() {
+		m_pages.clear();
+		m_regions.clear();
+		m_names.clear();
+		m_dirtyRects.clear();
+		++m_generation;
+	}
+
+	ENCOSHAREDAPI u32 SpriteAtlas::add(const std::string &name, const u8 *pixels, uint width, uint height) {
+		SpriteRegion region;
+		if (!pack(name, pixels, width, height, region)) {
+			return invalidRegion;
+		}
+
+		m_regions.push_back(region);
+		u32 id = (u32)(m_regions.size() - 1);
+		m_names[name] = id;
+		return id;
+	}
+
+	ENCOSHAREDAPI bool SpriteAtlas::build(const std::vector<SpriteImage> &images) {
+		clear();
+
+		std::vector<const SpriteImage *> sorted(images.size());
+		for (size_t i = 0; i < images.size(); ++i) {
+			sorted[i] = &images[i];
+		}
+		std::sort(sorted.begin(), sorted.end(), isTaller);
+
+		// Region ids follow the order of images, not the packing order
+		SpriteRegion empty = { 0, 0, 0, 0, 0 };
+		m_regions.assign(images.size(), empty);
+
+		bool complete = true;
+		for (size_t i = 0; i < sorted.size(); ++i) {
+			const SpriteImage &image = *sorted[i];
+			u32 id = (u32)(sorted[i] - &images[0]);
+			if (image.pixels.size() < (size_t)image.width * image.height * 4 || !pack(image.name, &image.pixels[0], image.width, image.height, m_regions[id])) {
+				complete = false;
+				continue;
+			}
+			m_names[image.name] = id;
+		}
+		return complete;
+	}
+
+	ENCOSHAREDAPI u32 SpriteAtlas::find(const std::string &name) const {
+		std::map<std::string, u32>::const_iterator found = m_names.find(name);
+		return found != m_names.end() ? found->second : invalidRegion;
+	}
+
+	ENCOSHAREDAPI bool SpriteAtlas::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		SpriteAtlasFileHeader header;
+		memcpy(header.magic, "EATL", 4);
+		header.version = fileVersion;
+		header.pageSize = m_pageSize;
+		header.pageCount = (u32)m_pages.size();
+		header.regionCount = (u32)m_names.size();
+		file.write((const char *)&header, sizeof(header));
+
+		// Only named regions are written, replaced ones are left behind
+		for (std::map<std::string, u32>::const_iterator i = m_names.begin(); i != m_names.end(); ++i) {
+			u32 length = (u32)i->first.size();
+			file.write((const char *)&length, sizeof(length));
+			file.write(i->first.c_str(), length);
+			file.write((const char *)&m_regions[i->second], sizeof(SpriteRegion));
+		}
+		for (size_t i = 0; i < m_pages.size(); ++i) {
+			file.write((const char *)&m_pages[i].pixels[0], m_pages[i].pixels.size());
+		}
+		return file.good();
+	}
+
+	ENCOSHAREDAPI bool SpriteAtlas::load(const std::string &path) {
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		SpriteAtlasFileHeader header;
+		if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, "EATL", 4) != 0 || header.version == 0 || header.version > fileVersion || header.pageSize == 0) {
+#ifdef _DEBUG
+			printf("SpriteAtlas Error: %s is not an atlas file of version %u or older\n", path.c_str(), fileVersion);
+#endif
+			return false;
+		}
+
+		clear();
+		m_pageSize = header.pageSize;
+		m_maxPages = std::max(m_maxPages, (uint)header.pageCount);
+
+		std::string name;
+		for (u32 i = 0; i < header.regionCount; ++i) {
+			u32 length = 0;
+			SpriteRegion region;
+			if (!file.read((char *)&length, sizeof(length)) || length > 4096) {
+				clear();
+				return false;
+			}
+			name.resize(length);
+			if (length > 0) {
+				file.read(&name[0], length);
+			}
+			if (!file.read((char *)&region, sizeof(region)) || region.page >= header.pageCount) {
+				clear();
+				return false;
+			}
+			m_regions.push_back(region);
+			m_names[name] = (u32)(m_regions.size() - 1);
+		}
+
+		for (u32 i = 0; i < header.pageCount; ++i) {
+			Page &page = addPage();
+			page.loaded = true;
+			if (!file.read((char *)&page.pixels[0], page.pixels.size())) {
+				clear();
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool SpriteAtlas::pack(const std::string &name, const u8 *pixels, uint width, uint height, SpriteRegion &region) {
+		uint paddedWidth = width + 2 * padding, paddedHeight = height + 2 * padding;
+		if (width == 0 || height == 0 || paddedWidth > m_pageSize || paddedHeight > m_pageSize) {
+#ifdef _DEBUG
+			printf("SpriteAtlas Error: %s (%ux%u) does not fit into a page of %u\n", name.c_str(), width, height, m_pageSize);
+#endif
+			return false;
+		}
+
+		uint x = 0, y = 0;
+		size_t page = 0;
+		for (; page < m_pages.size(); ++page) {
+			if (!m_pages[page].loaded && m_pages[page].packer.insert(paddedWidth, paddedHeight, x, y)) {
+				break;
+			}
+		}
+		if (page == m_pages.size()) {
+			if (m_pages.size() >= m_maxPages) {
+				return false;
+			}
+			addPage().packer.insert(paddedWidth, paddedHeight, x, y);
+		}
+
+		copy(m_pages[page], x, y, pixels, width, height);
+
+		region.page = (u16)page;
+		region.x = (u16)(x + padding);
+		region.y = (u16)(y + padding);
+		region.width = (u16)width;
+		region.height = (u16)height;
+		return true;
+	}
+
+	SpriteAtlas::Page &SpriteAtlas::addPage() {
+		m_pages.push_back(Page());
+		Page &page = m_pages.back();
+		page.packer.reset(m_pageSize, m_pageSize);
+		page.pixels.assign((size_t)m_pageSize * m_pageSize * 4, 0);
+		page.loaded = false;
+
+		// A new page is uploaded as a whole
+		DirtyRect dirty;
+		dirty.page = (u16)(m_pages.size() - 1);
+		dirty.x = dirty.y = 0;
+		dirty.width = dirty.height = (u16)std::min(m_pageSize, 0xFFFFu);
+		m_dirtyRects.push_back(dirty);
+		return page;
+	}
+
+	void SpriteAtlas::copy(Page &page, uint x, uint y, const u8 *pixels, uint width, uint height) {
+		// The padding repeats the nearest border texel
+		uint paddedWidth = width + 2 * padding, paddedHeight = height + 2 * padding;
+		for (uint row = 0; row < paddedHeight; ++row) {
+			uint sourceRow = (uint)glm::clamp((int)row - (int)padding, 0, (int)height - 1);
+			u8 *target = &page.pixels[((size_t)(y + row) * m_pageSize + x) * 4];
+			const u8 *source = pixels + (size_t)sourceRow * width * 4;
+			for (uint column = 0; column < padding; ++column) {
+				memcpy(target + column * 4, source, 4);
+				memcpy(target + (padding + width + column) * 4, source + (width - 1) * 4, 4);
+			}
+			memcpy(target + padding * 4, source, width * 4);
+		}
+
+		DirtyRect dirty;
+		dirty.page = (u16)(&page - &m_pages[0]);
+		dirty.x = (u16)x;
+		dirty.y = (u16)y;
+		dirty.width = (u16)paddedWidth;
+		dirty.height = (u16)paddedHeight;
+		m_dirtyRects.push_back(dirty);
+	}
+
+	ENCOSHAREDAPI bool SpriteAtlasAsset::import(const std::string &path) {
+		return m_atlas.load(path);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef __ENCOSHARED_SPRITEATLAS_H__
+#define __ENCOSHARED_SPRITEATLAS_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "RectPacker.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace enco {
+	// Texel rectangle of an image in an atlas page, without the padding around it
+	struct SpriteRegion {
+		u16 page;
+		u16 x, y, width, height;
+	};
+
+	// RGBA8 rows from the top
+	struct SpriteImage {
+		std::string name;
+		uint width, height;
+		std::vector<u8> pixels;
+	};
+
+	// RGBA8 pages with images packed into them by a RectPacker. Images can be packed offline with build()
+	// and saved, or added one at a time at runtime. Every image is surrounded by a copy of its border
+	// so filtering never picks up a neighbour.
+	//
+	// File format (.eatlas): "EATL", version, page size, page count, region count, then per region the
+	// name length, name and SpriteRegion, followed by the pixels of every page.
+	class SpriteAtlas {
+	public:
+		static const u32 fileVersion = 1;
+		static const uint padding = 1;
+		static const u32 invalidRegion = 0xFFFFFFFF;
+
+		struct DirtyRect {
+			u16 page;
+			u16 x, y, width, height;
+		};
+
+		ENCOSHAREDAPI SpriteAtlas(uint pageSize = 2048, uint maxPages = 8);
+		ENCOSHAREDAPI ~SpriteAtlas();
+
+		ENCOSHAREDAPI void clear();
+
+		// Packs image into the first page with room, returns the region id or invalidRegion when it is too large
+		// or all pages are full. Adding a name again replaces the region it pointed to.
+		ENCOSHAREDAPI u32 add(const std::string &name, const u8 *pixels, uint width, uint height);
+
+		// Clears the atlas and packs images tallest first, which fills the pages more tightly than adding them
+		// in arbitrary order. Region i is images[i]. Returns false if some did not fit, their regions are empty.
+		ENCOSHAREDAPI bool build(const std::vector<SpriteImage> &images);
+
+		// invalidRegion for unknown names
+		ENCOSHAREDAPI u32 find(const std::string &name) const;
+		inline const SpriteRegion &getRegion(u32 region) const { return m_regions[region]; }
+		inline uint getRegionCount() const { return (uint)m_regions.size(); }
+
+		inline uint getPageSize() const { return m_pageSize; }
+		inline uint getPageCount() const { return (uint)m_pages.size(); }
+		inline const u8 *getPageData(uint page) const { return &m_pages[page].pixels[0]; }
+
+		// Areas written since the last clearDirtyRects(), the renderer uploads and clears them
+		inline const std::vector<DirtyRect> &getDirtyRects() const { return m_dirtyRects; }
+		inline void clearDirtyRects() { m_dirtyRects.clear(); }
+		// Changes whenever pages are dropped by clear(), build() or load(), renderers recreate their textures then
+		inline u32 getGeneration() const { return m_generation; }
+
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+		ENCOSHAREDAPI bool load(const std::string &path);
+
+	private:
+		struct Page {
+			RectPacker packer;
+			std::vector<u8> pixels;
+			// Pages read by load() have no packer state, add() only packs into pages created after that
+			bool loaded;
+		};
+
+		SpriteAtlas(const SpriteAtlas &) = delete;
+		SpriteAtlas &operator=(const SpriteAtlas &) = delete;
+
+		bool pack(const std::string &name, const u8 *pixels, uint width, uint height, SpriteRegion &region);
+		Page &addPage();
+		void copy(Page &page, uint x, uint y, const u8 *pixels, uint width, uint height);
+
+		uint m_pageSize;
+		uint m_maxPages;
+		std::vector<Page> m_pages;
+		std::vector<SpriteRegion> m_regions;
+		std::map<std::string, u32> m_names;
+		std::vector<DirtyRect> m_dirtyRects;
+		u32 m_generation;
+	};
+
+	class SpriteAtlasAsset : public IAsset {
+	public:
+		ENCOSHAREDAPI virtual bool import(const std::string &path);
+
+		inline SpriteAtlas &getAtlas() { return m_atlas; }
+
+	private:
+		SpriteAtlas m_atlas;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,107 @@
+#include "stdafx.h"
+#include "SpriteBatch.h"
+#include "DebugDraw.h"
+
+#include <algorithm>
+
+namespace enco {
+	ENCOSHAREDAPI SpriteBatch::SpriteBatch(SpriteAtlas &atlas) : m_atlas(atlas) {
+	}
+
+	ENCOSHAREDAPI SpriteBatch::~SpriteBatch() {
+	}
+
+	ENCOSHAREDAPI void SpriteBatch::clear() {
+		m_instances.clear();
+		m_keys.clear();
+		m_order.clear();
+		m_draws.clear();
+	}
+
+	ENCOSHAREDAPI void SpriteBatch::add(u32 region, const glm::vec2 &center, const glm::vec2 &size, const glm::vec4 &color, f32 rotation, i16 layer) {
+		if (region >= m_atlas.getRegionCount()) {
+			return;
+		}
+
+		const SpriteRegion &source = m_atlas.getRegion(region);
+		SpriteInstance instance;
+		instance.center = center;
+		instance.size = size;
+		instance.rotation = rotation;
+		instance.texels[0] = source.x;
+		instance.texels[1] = source.y;
+		instance.texels[2] = source.x + source.width;
+		instance.texels[3] = source.y + source.height;
+		instance.color = DebugDraw::packColor(color);
+		m_instances.push_back(instance);
+
+		// Flipping the sign bit orders signed layers as unsigned keys
+		m_keys.push_back(((u32)(u16)(layer ^ (i16)0x8000) << 16) | source.page);
+	}
+
+	ENCOSHAREDAPI void SpriteBatch::add(u32 region, const glm::vec2 &center, const glm::vec4 &color, f32 rotation, i16 layer) {
+		if (region >= m_atlas.getRegionCount()) {
+			return;
+		}
+
+		const SpriteRegion &source = m_atlas.getRegion(region);
+		add(region, center, glm::vec2(source.width, source.height), color, rotation, layer);
+	}
+
+	ENCOSHAREDAPI void SpriteBatch::sort() {
+		uint count = (uint)m_keys.size();
+		m_order.resize(count);
+		m_sortScratch.resize(count);
+		for (uint i = 0; i < count; ++i) {
+			m_order[i] = i;
+		}
+
+		// Stable LSD radix sort of the indices, a byte that is the same for every key is skipped, which is
+		// most of them as long as few layers and pages are in use
+		u32 lowest = 0xFFFFFFFF, highest = 0;
+		for (uint i = 0; i < count; ++i) {
+			lowest = std::min(lowest, m_keys[i]);
+			highest = std::max(highest, m_keys[i]);
+		}
+		for (uint shift = 0; shift < 32 && count > 1; shift += 8) {
+			if (((lowest ^ highest) >> shift) == 0) {
+				break;
+			}
+
+			uint offsets[257] = { 0 };
+			for (uint i = 0; i < count; ++i) {
+				++offsets[((m_keys[i] >> shift) & 0xFF) + 1];
+			}
+			if (offsets[((lowest >> shift) & 0xFF) + 1] == count) {
+				continue;
+			}
+			for (uint i = 1; i < 257; ++i) {
+				offsets[i] += offsets[i - 1];
+			}
+			for (uint i = 0; i < count; ++i) {
+				u32 index = m_order[i];
+				m_sortScratch[offsets[(m_keys[index] >> shift) & 0xFF]++] = index;
+			}
+			m_order.swap(m_sortScratch);
+		}
+
+		m_draws.clear();
+		for (uint i = 0; i < count; ++i) {
+			u16 page = (u16)(m_keys[m_order[i]] & 0xFFFF);
+			if (m_draws.empty() || m_draws.back().page != page) {
+				SpriteDraw draw;
+				draw.page = page;
+				draw.first = i;
+				draw.count = 0;
+				m_draws.push_back(draw);
+			}
+			++m_draws.back().count;
+		}
+	}
+
+	ENCOSHAREDAPI void SpriteBatch::gather(SpriteInstance *instances) const {
+		for (size_t i = 0; i < m_order.size(); ++i) {
+			instances[i] = m_instances[m_order[i]];
+		}
+	}
+}
\ No newline at end of file
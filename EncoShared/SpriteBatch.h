@@ -0,0 +1,69 @@
+#ifndef __ENCOSHARED_SPRITEBATCH_H__
+#define __ENCOSHARED_SPRITEBATCH_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "MemoryTracker.h"
+#include "SpriteAtlas.h"
+
+#include <vector>
+
+namespace enco {
+	// One quad of the instanced draw, in pixels from the top left of the viewport
+	struct SpriteInstance {
+		glm::vec2 center;
+		glm::vec2 size;
+		// Radians, clockwise on screen
+		f32 rotation;
+		// Texel rectangle in the atlas page, left, top, right, bottom
+		u16 texels[4];
+		u32 color;
+	};
+
+	// A range of the sorted sprites that shares one atlas page
+	struct SpriteDraw {
+		u16 page;
+		u32 first;
+		u32 count;
+	};
+
+	// Collects 2D sprites of one atlas for a frame. Layers are drawn from low to high, within a layer sprites
+	// are grouped by page so consecutive layers on the same page merge into one draw. Sprites of one layer
+	// keep their order only while they share a page, overlapping sprites from different pages need
+	// different layers.
+	class SpriteBatch {
+	public:
+		ENCOSHAREDAPI SpriteBatch(SpriteAtlas &atlas);
+		ENCOSHAREDAPI ~SpriteBatch();
+
+		ENCOSHAREDAPI void clear();
+
+		ENCOSHAREDAPI void add(u32 region, const glm::vec2 &center, const glm::vec2 &size, const glm::vec4 &color = glm::vec4(1.0f), f32 rotation = 0.0f, i16 layer = 0);
+		// Uses the size of the region in texels
+		ENCOSHAREDAPI void add(u32 region, const glm::vec2 &center, const glm::vec4 &color = glm::vec4(1.0f), f32 rotation = 0.0f, i16 layer = 0);
+
+		// Sorts the sprites and builds the draws, the renderer calls this before gather()
+		ENCOSHAREDAPI void sort();
+		// Copies the sorted sprites to instances, which needs room for getCount()
+		ENCOSHAREDAPI void gather(SpriteInstance *instances) const;
+
+		inline SpriteAtlas &getAtlas() { return m_atlas; }
+		inline uint getCount() const { return (uint)m_instances.size(); }
+		inline const std::vector<SpriteDraw> &getDraws() const { return m_draws; }
+
+	private:
+		SpriteBatch(const SpriteBatch &) = delete;
+		SpriteBatch &operator=(const SpriteBatch &) = delete;
+
+		SpriteAtlas &m_atlas;
+		TaggedVector<SpriteInstance, rendererMemory> m_instances;
+		// Layer in the high and page in the low half
+		TaggedVector<u32, rendererMemory> m_keys;
+		TaggedVector<u32, rendererMemory> m_order;
+		TaggedVector<u32, rendererMemory> m_sortScratch;
+		std::vector<SpriteDraw> m_draws;
+	};
+}
+
+#endif
\ No newline at end of file
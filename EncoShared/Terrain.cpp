@@ -0,0 +1,434 @@
+#include "stdafx.h"
+#include "Terrain.h"
+#include "Simd.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	namespace {
+		const u32 fileVersion = 1;
+		const uint maxLevels = 24;
+		// Children are requested once the camera is within this much of the distance they are drawn at
+		const f32 prefetchScale = 1.25f;
+		// Frames a page has to be unused before a prefetched tile may take it
+		const u64 prefetchAge = 120;
+
+		struct TerrainFileHeader {
+			char magic[4];
+			u32 version;
+			u32 resolution;
+			f32 minHeight;
+			f32 maxHeight;
+		};
+
+		// ranges[i] is 1 where box i is within range of position, 2 where it is only within prefetchRange, 0 otherwise
+		void classifyDistances(const f32 *centerX, const f32 *centerY, const f32 *centerZ, const f32 *extentX, const f32 *extentY, const f32 *extentZ, uint count, const glm::vec3 &position, f32 range, f32 prefetchRange, u8 *ranges) {
+			SimdFloat4 px = simdSet(position.x), py = simdSet(position.y), pz = simdSet(position.z);
+			SimdFloat4 rangeSquared = simdSet(range * range), prefetchSquared = simdSet(prefetchRange * prefetchRange);
+			SimdFloat4 zero = simdZero();
+			uint i = 0;
+			for (; i + 4 <= count; i += 4) {
+				// Per axis distance from the box, |c - p| - e clamped to 0, with |x| as max(x, -x)
+				SimdFloat4 dx = simdSub(simdLoad(centerX + i), px), dy = simdSub(simdLoad(centerY + i), py), dz = simdSub(simdLoad(centerZ + i), pz);
+				dx = simdMax(simdSub(simdMax(dx, simdSub(zero, dx)), simdLoad(extentX + i)), zero);
+				dy = simdMax(simdSub(simdMax(dy, simdSub(zero, dy)), simdLoad(extentY + i)), zero);
+				dz = simdMax(simdSub(simdMax(dz, simdSub(zero, dz)), simdLoad(extentZ + i)), zero);
+				SimdFloat4 distance = simdMulAdd(dx, dx, simdMulAdd(dy, dy, simdMul(dz, dz)));
+				int inRange = simdMoveMask(simdLess(distance, rangeSquared));
+				int inPrefetch = simdMoveMask(simdLess(distance, prefetchSquared));
+				for (int lane = 0; lane < 4; ++lane) {
+					ranges[i + lane] = (inRange >> lane) & 1 ? 1 : ((inPrefetch >> lane) & 1 ? 2 : 0);
+				}
+			}
+			for (; i < count; ++i) {
+				f32 dx = std::max(fabsf(centerX[i] - position.x) - extentX[i], 0.0f);
+				f32 dy = std::max(fabsf(centerY[i] - position.y) - extentY[i], 0.0f);
+				f32 dz = std::max(fabsf(centerZ[i] - position.z) - extentZ[i], 0.0f);
+				f32 distance = dx * dx + dy * dy + dz * dz;
+				ranges[i] = distance < range * range ? 1 : (distance < prefetchRange * prefetchRange ? 2 : 0);
+			}
+		}
+	}
+
+	ENCOSHAREDAPI TerrainTile::TerrainTile() : resolution(0), minHeight(0.0f), maxHeight(0.0f) {
+	}
+
+	ENCOSHAREDAPI void TerrainTile::setHeights(const f32 *source, uint sourceResolution) {
+		resolution = sourceResolution;
+		uint count = resolution * resolution;
+		minHeight = count ? *std::min_element(source, source + count) : 0.0f;
+		maxHeight = count ? *std::max_element(source, source + count) : 0.0f;
+
+		f32 scale = maxHeight > minHeight ? 65535.0f / (maxHeight - minHeight) : 0.0f;
+		heights.resize(count);
+		for (uint i = 0; i < count; ++i) {
+			heights[i] = (u16)((source[i] - minHeight) * scale + 0.5f);
+		}
+		materials.resize(count, 0);
+	}
+
+	ENCOSHAREDAPI f32 TerrainTile::getHeight(uint x, uint z) const {
+		return minHeight + heights[z * resolution + x] * ((maxHeight - minHeight) / 65535.0f);
+	}
+
+	ENCOSHAREDAPI f32 TerrainTile::sampleHeight(f32 u, f32 v) const {
+		f32 x = glm::clamp(u, 0.0f, 1.0f) * (resolution - 1), z = glm::clamp(v, 0.0f, 1.0f) * (resolution - 1);
+		uint x0 = std::min((uint)x, resolution - 2), z0 = std::min((uint)z, resolution - 2);
+		f32 fx = x - x0, fz = z - z0;
+		f32 front = getHeight(x0, z0) + (getHeight(x0 + 1, z0) - getHeight(x0, z0)) * fx;
+		f32 back = getHeight(x0, z0 + 1) + (getHeight(x0 + 1, z0 + 1) - getHeight(x0, z0 + 1)) * fx;
+		return front + (back - front) * fz;
+	}
+
+	ENCOSHAREDAPI bool TerrainTile::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+		if (!file || heights.size() != resolution * resolution || materials.size() != heights.size()) {
+			return false;
+		}
+
+		TerrainFileHeader header;
+		memcpy(header.magic, "ETIL", 4);
+		header.version = fileVersion;
+		header.resolution = resolution;
+		header.minHeight = minHeight;
+		header.maxHeight = maxHeight;
+
+		file.write((const char *)&header, sizeof(header));
+		file.write((const char *)&heights[0], heights.size() * sizeof(u16));
+		file.write((const char *)&materials[0], materials.size());
+		return file.good();
+	}
+
+	ENCOSHAREDAPI bool TerrainTile::load(const std::string &path) {
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		TerrainFileHeader header;
+		if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, "ETIL", 4) != 0 || header.version == 0 || header.version > fileVersion || header.resolution < 3) {
+#ifdef _DEBUG
+			printf("Terrain Error: %s is not a terrain tile of version %u or older\n", path.c_str(), fileVersion);
+#endif
+			return false;
+		}
+
+		resolution = header.resolution;
+		minHeight = header.minHeight;
+		maxHeight = header.maxHeight;
+		heights.resize(resolution * resolution);
+		materials.resize(heights.size());
+		file.read((char *)&heights[0], heights.size() * sizeof(u16));
+		file.read((char *)&materials[0], materials.size());
+		return !!file;
+	}
+
+	ENCOSHAREDAPI bool TerrainTileAsset::import(const std::string &path) {
+		return m_tile.load(path);
+	}
+
+	ENCOSHAREDAPI Terrain::Terrain(AssetManager &assets, const TerrainSettings &settings) : m_assets(assets), m_settings(settings), m_levelCount(1), m_head(noPage), m_tail(noPage), m_cameraPosition(0.0f), m_frame(0), m_evictions(0) {
+		while (m_levelCount < maxLevels && getTileSize(m_levelCount - 1) < m_settings.worldSize) {
+			++m_levelCount;
+		}
+
+		// Level l is drawn up to lodDistance * 2^l and morphs into level l + 1 over the far morphRange of that.
+		// The coarsest level covers everything and never morphs.
+		m_morphs.resize(m_levelCount);
+		f32 previous = 0.0f;
+		for (uint level = 0; level < m_levelCount; ++level) {
+			f32 range = m_settings.lodDistance * (f32)(1 << level);
+			m_morphs[level] = level + 1 < m_levelCount ? glm::vec2(range - (range - previous) * m_settings.morphRange, range) : glm::vec2(1e30f, 2e30f);
+			previous = range;
+		}
+
+		Page empty = { 0, Asset<TerrainTileAsset>(), 0, 0, noPage, noPage };
+		m_pages.resize(m_settings.pageCount, empty);
+		for (u32 page = m_settings.pageCount; page > 0; --page) {
+			m_freePages.push_back(page - 1);
+		}
+	}
+
+	ENCOSHAREDAPI Terrain::~Terrain() {
+		for (std::unordered_map<u64, u32>::const_iterator it = m_residentPages.begin(); it != m_residentPages.end(); ++it) {
+			m_assets.unload(getPath(it->first));
+		}
+		for (size_t i = 0; i < m_loads.size(); ++i) {
+			m_assets.unload(getPath(m_loads[i].key));
+		}
+	}
+
+	ENCOSHAREDAPI void Terrain::update(const glm::vec3 &cameraPosition, const glm::mat4 &viewProjection) {
+		m_cameraPosition = cameraPosition;
+		m_instances.clear();
+		++m_frame;
+		receiveLoads();
+
+		u64 rootKey = getKey(m_levelCount - 1, 0, 0);
+		u32 rootPage = findPage(rootKey);
+		if (rootPage == noPage) {
+			request(rootKey, false);
+			return;
+		}
+
+		Frustum frustum(viewProjection);
+		Level *current = &m_levels[0], *next = &m_levels[1];
+		current->clear();
+		addCandidate(*current, rootKey, rootPage);
+
+		// Breadth first so each level is culled as one batch. The root stays resident even when it is out of view.
+		touch(rootPage);
+		for (uint level = m_levelCount; level-- > 0 && !current->keys.empty(); ) {
+			uint count = (uint)current->keys.size();
+			current->visible.resize(count);
+			frustum.intersects(&current->centerX[0], &current->centerY[0], &current->centerZ[0], &current->extentX[0], &current->extentY[0], &current->extentZ[0], count, &current->visible[0]);
+
+			next->clear();
+			for (uint i = 0; i < count; ++i) {
+				if (!current->visible[i]) {
+					continue;
+				}
+				u64 key = current->keys[i];
+				u32 page = current->pages[i];
+				touch(page);
+
+				// The quarters fill the four lanes, they are culled on their own and measured against the range of
+				// the children they would be replaced by
+				f32 centerX[4], centerY[4], centerZ[4], extentX[4], extentY[4], extentZ[4];
+				u8 visible[4], ranges[4] = { 0, 0, 0, 0 };
+				f32 half = current->extentX[i] * 0.5f;
+				for (uint quarter = 0; quarter < 4; ++quarter) {
+					centerX[quarter] = current->centerX[i] + (quarter & 1 ? half : -half);
+					centerY[quarter] = current->centerY[i];
+					centerZ[quarter] = current->centerZ[i] + (quarter >> 1 ? half : -half);
+					extentX[quarter] = extentZ[quarter] = half;
+					extentY[quarter] = current->extentY[i];
+				}
+				frustum.intersects(centerX, centerY, centerZ, extentX, extentY, extentZ, 4, visible);
+				if (level > 0) {
+					f32 range = m_morphs[level - 1].y;
+					classifyDistances(centerX, centerY, centerZ, extentX, extentY, extentZ, 4, m_cameraPosition, range, range * prefetchScale, ranges);
+				}
+
+				// Within its range a child is drawn in place of the quarter, once it is resident
+				uint x = getX(key), z = getZ(key);
+				for (uint quarter = 0; quarter < 4; ++quarter) {
+					if (!visible[quarter]) {
+						continue;
+					}
+					u64 childKey = level > 0 ? getKey(level - 1, x * 2 + (quarter & 1), z * 2 + (quarter >> 1)) : 0;
+					if (ranges[quarter] == 1) {
+						u32 childPage = findPage(childKey);
+						if (childPage != noPage) {
+							addCandidate(*next, childKey, childPage);
+							continue;
+						}
+						request(childKey, false);
+					}
+					else if (ranges[quarter] == 2) {
+						request(childKey, true);
+					}
+					addInstance(key, page, quarter);
+				}
+			}
+			std::swap(current, next);
+		}
+	}
+
+	ENCOSHAREDAPI bool Terrain::getHeight(const glm::vec3 &position, f32 &height) const {
+		f32 u = (position.x - m_settings.origin.x) / getTileSize(m_levelCount - 1), v = (position.z - m_settings.origin.z) / getTileSize(m_levelCount - 1);
+		u32 page = findPage(getKey(m_levelCount - 1, 0, 0));
+		if (page == noPage || u < 0.0f || v < 0.0f || u > 1.0f || v > 1.0f) {
+			return false;
+		}
+
+		// Down the quadtree as long as the child under position is resident
+		uint x = 0, z = 0;
+		for (uint level = m_levelCount - 1; level > 0; --level) {
+			uint childX = x * 2 + (u >= 0.5f ? 1 : 0), childZ = z * 2 + (v >= 0.5f ? 1 : 0);
+			u32 childPage = findPage(getKey(level - 1, childX, childZ));
+			if (childPage == noPage) {
+				break;
+			}
+			u = u * 2.0f - (u >= 0.5f ? 1.0f : 0.0f);
+			v = v * 2.0f - (v >= 0.5f ? 1.0f : 0.0f);
+			x = childX;
+			z = childZ;
+			page = childPage;
+		}
+
+		height = m_settings.origin.y + m_pages[page].asset->getTile().sampleHeight(u, v);
+		return true;
+	}
+
+	std::string Terrain::getPath(u64 key) const {
+		return m_settings.directory + "/" + std::to_string(getLevel(key)) + "/" + std::to_string(getX(key)) + "_" + std::to_string(getZ(key)) + ".etile";
+	}
+
+	u32 Terrain::findPage(u64 key) const {
+		std::unordered_map<u64, u32>::const_iterator it = m_residentPages.find(key);
+		return it != m_residentPages.end() ? it->second : noPage;
+	}
+
+	void Terrain::request(u64 key, bool prefetch) {
+		if (m_residentPages.count(key) || m_missing.count(key)) {
+			return;
+		}
+		for (size_t i = 0; i < m_loads.size(); ++i) {
+			if (m_loads[i].key == key) {
+				m_loads[i].prefetch = m_loads[i].prefetch && prefetch;
+				return;
+			}
+		}
+		// Half of the loads are kept for tiles that are needed right away
+		if (m_loads.size() >= (prefetch ? m_settings.maxLoads / 2 : m_settings.maxLoads)) {
+			return;
+		}
+
+		Load load = { key, m_assets.loadAsync<TerrainTileAsset>(getPath(key)), prefetch };
+		m_loads.push_back(load);
+	}
+
+	void Terrain::receiveLoads() {
+		// Tiles that were re-imported are uploaded again
+		for (std::unordered_map<u64, u32>::const_iterator it = m_residentPages.begin(); it != m_residentPages.end(); ++it) {
+			Page &page = m_pages[it->second];
+			if (page.asset.getVersion() != page.version) {
+				page.version = page.asset.getVersion();
+				m_uploads.push_back(it->second);
+			}
+		}
+
+		for (size_t i = 0; i < m_loads.size(); ) {
+			Load &load = m_loads[i];
+			bool failed = load.asset.isFailed();
+			if (load.asset.isReady() && load.asset->getTile().resolution != m_settings.tileResolution) {
+#ifdef _DEBUG
+				printf("Terrain Error: %s has %u samples per side instead of %u\n", getPath(load.key).c_str(), load.asset->getTile().resolution, m_settings.tileResolution);
+#endif
+				failed = true;
+			}
+
+			if (!failed && !load.asset.isReady()) {
+				++i;
+				continue;
+			}
+
+			u32 index = failed ? noPage : allocatePage(load.prefetch);
+			if (!failed && index == noPage && !load.prefetch) {
+				++i;
+				continue;
+			}
+			if (index == noPage) {
+				// Missing tiles are never asked for again, prefetched tiles that found no page once they are needed
+				if (failed) {
+					m_missing.insert(load.key);
+				}
+				m_assets.unload(getPath(load.key));
+			}
+			else {
+				Page &page = m_pages[index];
+				page.key = load.key;
+				page.asset = load.asset;
+				page.version = load.asset.getVersion();
+				page.lastUsed = m_frame;
+				pushFront(index);
+				m_residentPages[load.key] = index;
+				m_uploads.push_back(index);
+			}
+
+			m_loads[i] = m_loads.back();
+			m_loads.pop_back();
+		}
+	}
+
+	u32 Terrain::allocatePage(bool prefetch) {
+		if (!m_freePages.empty()) {
+			u32 page = m_freePages.back();
+			m_freePages.pop_back();
+			return page;
+		}
+
+		// Tiles drawn last frame are kept, the new tile waits until the camera moved away from something. Tiles that
+		// are only prefetched must not push out anything that was drawn recently, or a full budget would thrash.
+		u32 victim = m_tail;
+		if (victim == noPage || m_pages[victim].lastUsed + (prefetch ? prefetchAge : 1) >= m_frame) {
+			return noPage;
+		}
+
+		Page &page = m_pages[victim];
+		unlink(victim);
+		m_residentPages.erase(page.key);
+		m_assets.unload(getPath(page.key));
+		page.asset = Asset<TerrainTileAsset>();
+		++m_evictions;
+		return victim;
+	}
+
+	void Terrain::addCandidate(Level &level, u64 key, u32 page) {
+		const TerrainTile &tile = m_pages[page].asset->getTile();
+		f32 size = getTileSize(getLevel(key));
+		level.keys.push_back(key);
+		level.pages.push_back(page);
+		level.centerX.push_back(m_settings.origin.x + (getX(key) + 0.5f) * size);
+		level.centerY.push_back(m_settings.origin.y + (tile.minHeight + tile.maxHeight) * 0.5f);
+		level.centerZ.push_back(m_settings.origin.z + (getZ(key) + 0.5f) * size);
+		level.extentX.push_back(size * 0.5f);
+		level.extentY.push_back((tile.maxHeight - tile.minHeight) * 0.5f);
+		level.extentZ.push_back(size * 0.5f);
+	}
+
+	void Terrain::addInstance(u64 key, u32 page, uint quarter) {
+		const TerrainTile &tile = m_pages[page].asset->getTile();
+		uint level = getLevel(key);
+		f32 size = getTileSize(level), half = size * 0.5f;
+		f32 texels = (f32)((m_settings.tileResolution - 1) / 2);
+
+		TerrainInstance instance;
+		instance.offset = glm::vec2(m_settings.origin.x + getX(key) * size + (quarter & 1) * half, m_settings.origin.z + getZ(key) * size + (quarter >> 1) * half);
+		instance.size = half;
+		instance.page = (f32)page;
+		instance.texelOffset = glm::vec2((quarter & 1) * texels, (quarter >> 1) * texels);
+		instance.morph = m_morphs[level];
+		instance.height = glm::vec2(m_settings.origin.y + tile.minHeight, tile.maxHeight - tile.minHeight);
+		m_instances.push_back(instance);
+	}
+
+	void Terrain::touch(u32 page) {
+		m_pages[page].lastUsed = m_frame;
+		unlink(page);
+		pushFront(page);
+	}
+
+	void Terrain::unlink(u32 page) {
+		Page &entry = m_pages[page];
+		if (entry.previous != noPage) {
+			m_pages[entry.previous].next = entry.next;
+		}
+		else if (m_head == page) {
+			m_head = entry.next;
+		}
+		if (entry.next != noPage) {
+			m_pages[entry.next].previous = entry.previous;
+		}
+		else if (m_tail == page) {
+			m_tail = entry.previous;
+		}
+		entry.previous = entry.next = noPage;
+	}
+
+	void Terrain::pushFront(u32 page) {
+		Page &entry = m_pages[page];
+		entry.previous = noPage;
+		entry.next = m_head;
+		if (m_head != noPage) {
+			m_pages[m_head].previous = page;
+		}
+		m_head = page;
+		if (m_tail == noPage) {
+			m_tail = page;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef __ENCOSHARED_TERRAIN_H__
+#define __ENCOSHARED_TERRAIN_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "Frustum.h"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace enco {
+	// Square grid of height and material samples, heights are stored as fractions of [minHeight, maxHeight].
+	// A tile one level coarser takes every second sample of its four children, so a morphed vertex lands
+	// exactly on the height the coarser tile has there.
+	class TerrainTile {
+	public:
+		ENCOSHAREDAPI TerrainTile();
+
+		// resolution * resolution heights, row by row along +x with rows along +z
+		ENCOSHAREDAPI void setHeights(const f32 *heights, uint resolution);
+		ENCOSHAREDAPI f32 getHeight(uint x, uint z) const;
+		// Bilinear, u and v are in [0, 1] across the tile
+		ENCOSHAREDAPI f32 sampleHeight(f32 u, f32 v) const;
+
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+		ENCOSHAREDAPI bool load(const std::string &path);
+
+		uint resolution;
+		f32 minHeight, maxHeight;
+		std::vector<u16> heights;
+		// One material index per sample, 0 where nothing was painted
+		std::vector<u8> materials;
+	};
+
+	class TerrainTileAsset : public IAsset {
+	public:
+		ENCOSHAREDAPI virtual bool import(const std::string &path);
+
+		inline const TerrainTile &getTile() const { return m_tile; }
+
+	private:
+		TerrainTile m_tile;
+	};
+
+	struct TerrainSettings {
+		// Side of the square the terrain covers, starting at origin along +x and +z
+		f32 worldSize;
+		// Side of the finest tiles, every coarser level doubles it up to one tile that covers the world
+		f32 leafSize;
+		// Samples along a side of each tile, 2^n + 1
+		uint tileResolution;
+		// Leaf tiles are drawn within this distance of the camera, each coarser level within twice the distance of
+		// the previous one. At least twice leafSize, or levels more than one apart could meet.
+		f32 lodDistance;
+		// Part of each level's range over which its vertices morph into the next coarser level
+		f32 morphRange;
+		// Tiles resident at once, each one a layer of the GPU textures
+		uint pageCount;
+		// Tile imports in flight at once
+		uint maxLoads;
+		// Tiles are loaded from <directory>/<level>/<x>_<z>.etile, level 0 being the finest
+		std::string directory;
+		glm::vec3 origin;
+
+		inline TerrainSettings() : worldSize(8192.0f), leafSize(64.0f), tileResolution(65), lodDistance(192.0f), morphRange(0.3f), pageCount(512), maxLoads(16), directory("terrain"), origin(0.0f) {  }
+	};
+
+	// One quarter of a tile drawn with the shared grid. The grid is stretched over offset to offset + size,
+	// morphs between morph.x and morph.y from the camera and reads its heights from the texture layer page at
+	// texelOffset, where they are scaled into height.x + [0, 1] * height.y.
+	struct TerrainInstance {
+		glm::vec2 offset;
+		f32 size;
+		f32 page;
+		glm::vec2 texelOffset;
+		glm::vec2 morph;
+		glm::vec2 height;
+	};
+
+	// Continuous distance based LOD over a quadtree of tiles (CDLOD). Tiles are streamed in through the asset
+	// manager as the camera gets close to them and evicted least recently used first once every page is taken,
+	// so the terrain never has to be resident as a whole. Where a tile is not resident yet the quarter of its
+	// parent covering it is drawn instead. The coarsest tile must exist, nothing is drawn before it arrived.
+	class Terrain {
+	public:
+		ENCOSHAREDAPI Terrain(AssetManager &assets, const TerrainSettings &settings = TerrainSettings());
+		ENCOSHAREDAPI ~Terrain();
+
+		inline const TerrainSettings &getSettings() const { return m_settings; }
+		inline uint getLevelCount() const { return m_levelCount; }
+
+		// Culls and selects the tiles for this camera, requests the ones it would like to have and takes in the
+		// ones that arrived. Call once per frame after AssetManager::commit().
+		ENCOSHAREDAPI void update(const glm::vec3 &cameraPosition, const glm::mat4 &viewProjection);
+
+		inline const std::vector<TerrainInstance> &getInstances() const { return m_instances; }
+		inline const glm::vec3 &getCameraPosition() const { return m_cameraPosition; }
+
+		// Pages whose tile changed since clearUploads(), the renderer copies them to its textures
+		inline const std::vector<u32> &getUploads() const { return m_uploads; }
+		inline void clearUploads() { m_uploads.clear(); }
+		// Tile held by page or nullptr, changes only in update()
+		inline const TerrainTile *getPageTile(u32 page) const { return m_pages[page].asset.isReady() ? &m_pages[page].asset->getTile() : nullptr; }
+
+		// Height of the finest resident tile at position, false outside the terrain or before anything arrived
+		ENCOSHAREDAPI bool getHeight(const glm::vec3 &position, f32 &height) const;
+
+		inline uint getResidentTileCount() const { return (uint)m_residentPages.size(); }
+		inline uint getLoadingTileCount() const { return (uint)m_loads.size(); }
+		inline u64 getEvictionCount() const { return m_evictions; }
+
+	private:
+		static const u32 noPage = 0xFFFFFFFF;
+
+		// Resident tiles form a list from the most to the least recently drawn
+		struct Page {
+			u64 key;
+			Asset<TerrainTileAsset> asset;
+			u32 version;
+			u64 lastUsed;
+			u32 previous, next;
+		};
+
+		struct Load {
+			u64 key;
+			Asset<TerrainTileAsset> asset;
+			// Requested ahead of time, nothing is drawn in its place yet
+			bool prefetch;
+		};
+
+		// Candidates of one level, the box components apart so they can be culled four at a time
+		struct Level {
+			std::vector<u64> keys;
+			std::vector<u32> pages;
+			std::vector<f32> centerX, centerY, centerZ;
+			std::vector<f32> extentX, extentY, extentZ;
+			std::vector<u8> visible;
+
+			inline void clear() { keys.clear(); pages.clear(); centerX.clear(); centerY.clear(); centerZ.clear(); extentX.clear(); extentY.clear(); extentZ.clear(); }
+		};
+
+		Terrain(const Terrain &) = delete;
+		Terrain &operator=(const Terrain &) = delete;
+
+		static inline u64 getKey(uint level, uint x, uint z) { return ((u64)level << 48) | ((u64)x << 24) | z; }
+		static inline uint getLevel(u64 key) { return (uint)(key >> 48); }
+		static inline uint getX(u64 key) { return (uint)(key >> 24) & 0xFFFFFF; }
+		static inline uint getZ(u64 key) { return (uint)key & 0xFFFFFF; }
+		inline f32 getTileSize(uint level) const { return m_settings.leafSize * (f32)(1 << level); }
+
+		std::string getPath(u64 key) const;
+		u32 findPage(u64 key) const;
+		void request(u64 key, bool prefetch);
+		void receiveLoads();
+		u32 allocatePage(bool prefetch);
+		void addCandidate(Level &level, u64 key, u32 page);
+		void addInstance(u64 key, u32 page, uint quarter);
+		void touch(u32 page);
+		void unlink(u32 page);
+		void pushFront(u32 page);
+
+		AssetManager &m_assets;
+		TerrainSettings m_settings;
+		uint m_levelCount;
+		std::vector<glm::vec2> m_morphs;
+
+		std::vector<Page> m_pages;
+		std::vector<u32> m_freePages;
+		std::unordered_map<u64, u32> m_residentPages;
+		u32 m_head, m_tail;
+		std::vector<Load> m_loads;
+		// Tiles whose file does not exist, e.g. beyond the edge of a world that is not a power of two
+		std::unordered_set<u64> m_missing;
+		std::vector<u32> m_uploads;
+
+		Level m_levels[2];
+		std::vector<TerrainInstance> m_instances;
+		glm::vec3 m_cameraPosition;
+		u64 m_frame;
+		u64 m_evictions;
+	};
+}
+
+#endif
\ No newline at end of file
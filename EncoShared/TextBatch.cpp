@@ -0,0 +1,156 @@
+#include "stdafx.h"
+#include "TextBatch.h"
+#include "DebugDraw.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		// Malformed sequences decode to U+FFFD one byte at a time
+		u32 decodeUtf8(const std::string &text, size_t &i) {
+			u8 lead = (u8)text[i++];
+			if (lead < 0x80) {
+				return lead;
+			}
+
+			uint length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+			if (length == 0 || i + length > text.size()) {
+				return 0xFFFD;
+			}
+
+			u32 codepoint = lead & (0x3F >> length);
+			for (uint j = 0; j < length; ++j) {
+				u8 next = (u8)text[i + j];
+				if ((next & 0xC0) != 0x80) {
+					return 0xFFFD;
+				}
+				codepoint = (codepoint << 6) | (next & 0x3F);
+			}
+			i += length;
+			return codepoint;
+		}
+	}
+
+	ENCOSHAREDAPI TextBatch::TextBatch(GlyphAtlas &atlas) : m_atlas(atlas), m_instanceCount(0), m_frame(0), m_hits(0), m_misses(0) {
+	}
+
+	ENCOSHAREDAPI TextBatch::~TextBatch() {
+	}
+
+	ENCOSHAREDAPI void TextBatch::beginFrame() {
+		for (size_t i = 0; i < m_instances.size(); ++i) {
+			m_instances[i].clear();
+		}
+		m_instanceCount = 0;
+
+		if (m_runs.size() > maxCachedRuns) {
+			for (std::unordered_map<u64, TextRun>::iterator i = m_runs.begin(); i != m_runs.end();) {
+				if (i->second.lastUsedFrame < m_frame) {
+					i = m_runs.erase(i);
+				}
+				else {
+					++i;
+				}
+			}
+		}
+
+		++m_frame;
+		m_atlas.beginFrame();
+	}
+
+	ENCOSHAREDAPI const TextRun &TextBatch::shape(uint font, const std::string &text) {
+		u64 key = hash(font, text);
+		std::unordered_map<u64, TextRun>::iterator found = m_runs.find(key);
+		if (found != m_runs.end() && found->second.font == font && found->second.text == text) {
+			found->second.lastUsedFrame = m_frame;
+			++m_hits;
+			return found->second;
+		}
+
+		// New or a hash collision, which simply replaces the older run
+		TextRun &run = m_runs[key];
+		run.font = font;
+		run.text = text;
+		shape(run);
+		++m_misses;
+		run.lastUsedFrame = m_frame;
+		return run;
+	}
+
+	ENCOSHAREDAPI glm::vec2 TextBatch::add(uint font, const std::string &text, const glm::vec2 &position, f32 pixelHeight, const glm::vec4 &color) {
+		const TextRun &run = shape(font, text);
+		u32 packed = DebugDraw::packColor(color);
+		f32 fieldScale = pixelHeight / GlyphAtlas::fieldSize;
+
+		for (size_t i = 0; i < run.glyphs.size(); ++i) {
+			const ShapedGlyph &shaped = run.glyphs[i];
+			const AtlasGlyph *glyph = m_atlas.getGlyph(font, shaped.codepoint);
+			if (!glyph || glyph->page == GlyphAtlas::noPage) {
+				continue;
+			}
+
+			if (glyph->page >= m_instances.size()) {
+				m_instances.resize(glyph->page + 1);
+			}
+
+			TextGlyphInstance instance;
+			instance.position = position + glm::vec2(shaped.position.x + glyph->left, shaped.position.y - glyph->top) * pixelHeight;
+			instance.size = glm::vec2(glyph->width, glyph->height) * fieldScale;
+			instance.texels[0] = glyph->x;
+			instance.texels[1] = glyph->y;
+			instance.texels[2] = glyph->x + glyph->width;
+			instance.texels[3] = glyph->y + glyph->height;
+			instance.color = packed;
+			m_instances[glyph->page].push_back(instance);
+			++m_instanceCount;
+		}
+		return run.size * pixelHeight;
+	}
+
+	void TextBatch::shape(TextRun &run) {
+		run.glyphs.clear();
+
+		const FontMetrics &metrics = m_atlas.getMetrics(run.font);
+		f32 lineHeight = metrics.ascent + metrics.descent + metrics.lineGap;
+		glm::vec2 pen(0.0f, metrics.ascent);
+		f32 width = 0.0f;
+		u32 previous = 0;
+
+		for (size_t i = 0; i < run.text.size();) {
+			u32 codepoint = decodeUtf8(run.text, i);
+			if (codepoint == '\n') {
+				width = std::max(width, pen.x);
+				pen = glm::vec2(0.0f, pen.y + lineHeight);
+				previous = 0;
+				continue;
+			}
+
+			const AtlasGlyph *glyph = m_atlas.getGlyph(run.font, codepoint);
+			if (!glyph) {
+				continue;
+			}
+			if (previous) {
+				pen.x += m_atlas.getKerning(run.font, previous, codepoint);
+			}
+
+			ShapedGlyph shaped;
+			shaped.codepoint = codepoint;
+			shaped.position = pen;
+			run.glyphs.push_back(shaped);
+
+			pen.x += glyph->advance;
+			previous = codepoint;
+		}
+
+		run.size = glm::vec2(std::max(width, pen.x), pen.y + metrics.descent);
+	}
+
+	u64 TextBatch::hash(uint font, const std::string &text) {
+		// FNV-1a
+		u64 hash = 14695981039346656037ULL ^ font;
+		for (size_t i = 0; i < text.size(); ++i) {
+			hash = (hash ^ (u8)text[i]) * 1099511628211ULL;
+		}
+		return hash;
+	}
+}
\ No newline at end of file
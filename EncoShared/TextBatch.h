@@ -0,0 +1,86 @@
+#ifndef __ENCOSHARED_TEXTBATCH_H__
+#define __ENCOSHARED_TEXTBATCH_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "GlyphAtlas.h"
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	// Pen position in em from the top left of the run, y pointing down to the baseline of the line
+	struct ShapedGlyph {
+		u32 codepoint;
+		glm::vec2 position;
+	};
+
+	// UTF-8 text laid out once and reused while the same string is drawn again
+	struct TextRun {
+		uint font;
+		std::string text;
+		std::vector<ShapedGlyph> glyphs;
+		// Extent in em
+		glm::vec2 size;
+		u64 lastUsedFrame;
+	};
+
+	// One quad of the instanced draw, in pixels from the top left of the viewport
+	struct TextGlyphInstance {
+		glm::vec2 position;
+		glm::vec2 size;
+		// Texel rectangle in the atlas page, left, top, right, bottom
+		u16 texels[4];
+		u32 color;
+	};
+
+	// Collects the text of a frame as glyph instances sorted by atlas page, so the renderer needs one draw per page.
+	// Shaped runs are cached by the hash of their string, HUDs that redraw the same labels and numbers every
+	// frame only pay for the lookup.
+	class TextBatch {
+	public:
+		// Runs beyond this count that were not used in the last frame are dropped at beginFrame()
+		static const uint maxCachedRuns = 4096;
+
+		ENCOSHAREDAPI TextBatch(GlyphAtlas &atlas);
+		ENCOSHAREDAPI ~TextBatch();
+
+		// Drops the instances of the last frame and starts a new frame in the atlas
+		ENCOSHAREDAPI void beginFrame();
+
+		ENCOSHAREDAPI const TextRun &shape(uint font, const std::string &text);
+
+		// position is the top left of the text in pixels, returns the size of the text in pixels
+		ENCOSHAREDAPI glm::vec2 add(uint font, const std::string &text, const glm::vec2 &position, f32 pixelHeight, const glm::vec4 &color);
+
+		inline GlyphAtlas &getAtlas() { return m_atlas; }
+
+		inline uint getPageCount() const { return (uint)m_instances.size(); }
+		inline const std::vector<TextGlyphInstance> &getInstances(uint page) const { return m_instances[page]; }
+		inline uint getInstanceCount() const { return m_instanceCount; }
+
+		inline u64 getRunCacheHits() const { return m_hits; }
+		inline u64 getRunCacheMisses() const { return m_misses; }
+
+	private:
+		TextBatch(const TextBatch &) = delete;
+		TextBatch &operator=(const TextBatch &) = delete;
+
+		void shape(TextRun &run);
+
+		static u64 hash(uint font, const std::string &text);
+
+		GlyphAtlas &m_atlas;
+		std::unordered_map<u64, TextRun> m_runs;
+		std::vector<std::vector<TextGlyphInstance> > m_instances;
+		uint m_instanceCount;
+
+		u64 m_frame;
+		u64 m_hits;
+		u64 m_misses;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "stdafx.h"
+#include "TriangleMesh.h"
+
+#include <algorithm>
+
+namespace enco {
+	namespace {
+		const uint binCount = 12;
+		// Leaves this small are kept when no split is cheaper than testing every triangle
+		const uint maxCheapLeafTriangles = 16;
+
+		inline f32 getArea(const AABB &box) {
+			glm::vec3 size = box.max - box.min;
+			return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+		}
+
+		inline AABB emptyBox() {
+			return AABB(glm::vec3(1e30f), glm::vec3(-1e30f));
+		}
+
+		// Entry distance of the ray into box, or a negative value when it misses within maxDistance
+		inline f32 enterBox(const AABB &box, const glm::vec3 &origin, const glm::vec3 &inverse, f32 maxDistance) {
+			glm::vec3 t0 = (box.min - origin) * inverse, t1 = (box.max - origin) * inverse;
+			glm::vec3 lower = glm::min(t0, t1), upper = glm::max(t0, t1);
+			f32 enter = std::max(std::max(lower.x, lower.y), std::max(lower.z, 0.0f));
+			f32 leave = std::min(std::min(upper.x, upper.y), std::min(upper.z, maxDistance));
+			return enter <= leave ? enter : -1.0f;
+		}
+
+		// Moeller-Trumbore, both sides
+		inline bool intersectTriangle(const glm::vec3 &origin, const glm::vec3 &direction, const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c, f32 &distance) {
+			glm::vec3 ab = b - a, ac = c - a;
+			glm::vec3 p = glm::cross(direction, ac);
+			f32 determinant = glm::dot(ab, p);
+			if (fabsf(determinant) < 1e-12f) {
+				return false;
+			}
+			f32 inverse = 1.0f / determinant;
+			glm::vec3 s = origin - a;
+			f32 u = glm::dot(s, p) * inverse;
+			if (u < 0.0f || u > 1.0f) {
+				return false;
+			}
+			glm::vec3 q = glm::cross(s, ab);
+			f32 v = glm::dot(direction, q) * inverse;
+			if (v < 0.0f || u + v > 1.0f) {
+				return false;
+			}
+			distance = glm::dot(ac, q) * inverse;
+			return distance >= 0.0f;
+		}
+	}
+
+	ENCOSHAREDAPI TriangleMesh::TriangleMesh() {
+	}
+
+	ENCOSHAREDAPI void TriangleMesh::build(const std::vector<glm::vec3> &positions, const std::vector<u32> &indices) {
+		m_positions = positions;
+		m_nodes.clear();
+		m_indices.clear();
+		m_bounds = AABB();
+
+		u32 triangleCount = (u32)(indices.size() / 3);
+		if (triangleCount == 0) {
+			return;
+		}
+
+		std::vector<u32> triangles(triangleCount);
+		std::vector<AABB> boxes(triangleCount);
+		std::vector<glm::vec3> centers(triangleCount);
+		for (u32 i = 0; i < triangleCount; ++i) {
+			const glm::vec3 &a = positions[indices[i * 3]], &b = positions[indices[i * 3 + 1]], &c = positions[indices[i * 3 + 2]];
+			triangles[i] = i;
+			boxes[i] = AABB(glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c)));
+			centers[i] = boxes[i].getCenter();
+		}
+
+		m_nodes.reserve(triangleCount * 2 / maxLeafTriangles + 1);
+		buildNode(triangles, boxes, centers, 0, triangleCount, 0);
+		m_bounds = m_nodes[0].box;
+
+		// Triangles are stored in the order the leaves reference them
+		m_indices.resize(triangleCount * 3);
+		for (u32 i = 0; i < triangleCount; ++i) {
+			for (uint j = 0; j < 3; ++j) {
+				m_indices[i * 3 + j] = indices[triangles[i] * 3 + j];
+			}
+		}
+	}
+
+	ENCOSHAREDAPI void TriangleMesh::build(const MeshData &mesh, uint lod) {
+		std::vector<glm::vec3> positions(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+			positions[i] = mesh.vertices[i].position;
+		}
+		MeshLod range = mesh.getLod(lod);
+		std::vector<u32> indices(mesh.indices.begin() + range.indexOffset, mesh.indices.begin() + range.indexOffset + range.indexCount);
+		build(positions, indices);
+	}
+
+	u32 TriangleMesh::buildNode(std::vector<u32> &triangles, std::vector<AABB> &boxes, std::vector<glm::vec3> &centers, u32 begin, u32 end, uint depth) {
+		u32 index = (u32)m_nodes.size();
+		m_nodes.push_back(Node());
+
+		AABB box = emptyBox(), centerBox = emptyBox();
+		for (u32 i = begin; i < end; ++i) {
+			box.merge(boxes[triangles[i]]);
+			centerBox.merge(centers[triangles[i]]);
+		}
+		m_nodes[index].box = box;
+
+		u32 count = end - begin;
+		glm::vec3 centerSize = centerBox.max - centerBox.min;
+		uint axis = centerSize.x > centerSize.y ? (centerSize.x > centerSize.z ? 0 : 2) : (centerSize.y > centerSize.z ? 1 : 2);
+		// Triangles sharing one center cannot be split, the traversal stack limits the depth
+		if (count <= maxLeafTriangles || centerSize[axis] <= 0.0f || depth + 2 >= maxStackDepth) {
+			m_nodes[index].offset = begin;
+			m_nodes[index].count = count;
+			return index;
+		}
+
+		// Bins along the longest axis of the centers, the split between two bins with the lowest area cost wins
+		AABB binBoxes[binCount];
+		u32 binCounts[binCount];
+		for (uint i = 0; i < binCount; ++i) {
+			binBoxes[i] = emptyBox();
+			binCounts[i] = 0;
+		}
+		f32 scale = binCount / centerSize[axis] * 0.9999f;
+		for (u32 i = begin; i < end; ++i) {
+			uint bin = std::min((uint)((centers[triangles[i]][axis] - centerBox.min[axis]) * scale), binCount - 1);
+			binBoxes[bin].merge(boxes[triangles[i]]);
+			++binCounts[bin];
+		}
+
+		f32 rightCosts[binCount];
+		AABB right = emptyBox();
+		u32 rightCount = 0;
+		for (uint i = binCount - 1; i > 0; --i) {
+			right.merge(binBoxes[i]);
+			rightCount += binCounts[i];
+			rightCosts[i] = rightCount > 0 ? getArea(right) * rightCount : 0.0f;
+		}
+
+		f32 bestCost = 1e30f;
+		uint bestSplit = 0;
+		AABB left = emptyBox();
+		u32 leftCount = 0;
+		for (uint i = 0; i + 1 < binCount; ++i) {
+			left.merge(binBoxes[i]);
+			leftCount += binCounts[i];
+			if (leftCount == 0 || leftCount == count) {
+				continue;
+			}
+			f32 cost = getArea(left) * leftCount + rightCosts[i + 1];
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestSplit = i + 1;
+			}
+		}
+
+		u32 middle;
+		if (bestSplit == 0) {
+			// Every center fell into one bin, split at the median instead
+			middle = begin + count / 2;
+			std::nth_element(triangles.begin() + begin, triangles.begin() + middle, triangles.begin() + end, [&centers, axis](u32 a, u32 b) { return centers[a][axis] < centers[b][axis]; });
+		}
+		else {
+			if (count <= maxCheapLeafTriangles && bestCost >= getArea(box) * count) {
+				m_nodes[index].offset = begin;
+				m_nodes[index].count = count;
+				return index;
+			}
+			f32 minimum = centerBox.min[axis];
+			middle = (u32)(std::partition(triangles.begin() + begin, triangles.begin() + end, [&centers, axis, minimum, scale, bestSplit](u32 triangle) {
+				return std::min((uint)((centers[triangle][axis] - minimum) * scale), binCount - 1) < bestSplit;
+			}) - triangles.begin());
+		}
+
+		buildNode(triangles, boxes, centers, begin, middle, depth + 1);
+		u32 second = buildNode(triangles, boxes, centers, middle, end, depth + 1);
+		m_nodes[index].offset = second;
+		m_nodes[index].count = 0;
+		return index;
+	}
+
+	ENCOSHAREDAPI bool TriangleMesh::raycast(const glm::vec3 &origin, const glm::vec3 &direction, f32 maxDistance, u32 &triangle, f32 &distance) const {
+		if (m_nodes.empty()) {
+			return false;
+		}
+
+		// Zero components would turn into NaN at the slabs of boxes the ray starts on
+		glm::vec3 inverse;
+		for (uint i = 0; i < 3; ++i) {
+			inverse[i] = 1.0f / (direction[i] != 0.0f ? direction[i] : 1e-30f);
+		}
+		if (enterBox(m_nodes[0].box, origin, inverse, maxDistance) < 0.0f) {
+			return false;
+		}
+
+		bool hit = false;
+		u32 stack[maxStackDepth];
+		uint size = 0;
+		stack[size++] = 0;
+		while (size > 0) {
+			const Node &node = m_nodes[stack[--size]];
+			if (node.count > 0) {
+				for (u32 i = node.offset; i < node.offset + node.count; ++i) {
+					f32 t;
+					if (intersectTriangle(origin, direction, m_positions[m_indices[i * 3]], m_positions[m_indices[i * 3 + 1]], m_positions[m_indices[i * 3 + 2]], t) && t <= maxDistance) {
+						maxDistance = t;
+						triangle = i;
+						hit = true;
+					}
+				}
+				continue;
+			}
+
+			// The nearer child is visited first so the hit it finds culls the other one
+			u32 first = (u32)(&node - &m_nodes[0]) + 1, second = node.offset;
+			f32 enterFirst = enterBox(m_nodes[first].box, origin, inverse, maxDistance);
+			f32 enterSecond = enterBox(m_nodes[second].box, origin, inverse, maxDistance);
+			if (enterFirst >= 0.0f && enterSecond >= 0.0f && enterSecond < enterFirst) {
+				std::swap(first, second);
+				std::swap(enterFirst, enterSecond);
+			}
+			if (enterSecond >= 0.0f && size < maxStackDepth) {
+				stack[size++] = second;
+			}
+			if (enterFirst >= 0.0f && size < maxStackDepth) {
+				stack[size++] = first;
+			}
+		}
+
+		if (hit) {
+			distance = maxDistance;
+		}
+		return hit;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef __ENCOSHARED_TRIANGLEMESH_H__
+#define __ENCOSHARED_TRIANGLEMESH_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "Frustum.h"
+#include "MeshData.h"
+
+#include <vector>
+
+namespace enco {
+	// Static bounding volume hierarchy over the triangles of a mesh, built once with binned surface area
+	// heuristic splits. Nodes are stored depth first: the first child follows its parent, the second is at
+	// offset. Read only after build, so any number of threads may query it.
+	class TriangleMesh {
+	public:
+		static const uint maxLeafTriangles = 4;
+		// A tree over a million triangles needs around 30
+		static const uint maxStackDepth = 64;
+
+		ENCOSHAREDAPI TriangleMesh();
+
+		ENCOSHAREDAPI void build(const std::vector<glm::vec3> &positions, const std::vector<u32> &indices);
+		ENCOSHAREDAPI void build(const MeshData &mesh, uint lod = 0);
+
+		// Closest triangle the ray from origin along direction hits within maxDistance, in units of direction.
+		// Both sides of a triangle are hit.
+		ENCOSHAREDAPI bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, f32 maxDistance, u32 &triangle, f32 &distance) const;
+
+		// Calls callback(triangle) for every triangle whose bounds overlap box, stops when it returns false
+		template<typename Callback>
+		void query(const AABB &box, Callback &callback) const {
+			if (m_nodes.empty()) {
+				return;
+			}
+
+			u32 stack[maxStackDepth];
+			uint size = 0;
+			stack[size++] = 0;
+			while (size > 0) {
+				const Node &node = m_nodes[stack[--size]];
+				if (!overlaps(node.box, box)) {
+					continue;
+				}
+				if (node.count > 0) {
+					for (u32 i = node.offset; i < node.offset + node.count; ++i) {
+						if (!callback(i)) {
+							return;
+						}
+					}
+				}
+				else if (size + 2 <= maxStackDepth) {
+					stack[size++] = (u32)(&node - &m_nodes[0]) + 1;
+					stack[size++] = node.offset;
+				}
+			}
+		}
+
+		// Triangles are numbered in tree order, not in the order of the indices they were built from
+		inline void getTriangle(u32 triangle, glm::vec3 &a, glm::vec3 &b, glm::vec3 &c) const {
+			a = m_positions[m_indices[triangle * 3]];
+			b = m_positions[m_indices[triangle * 3 + 1]];
+			c = m_positions[m_indices[triangle * 3 + 2]];
+		}
+		inline u32 getTriangleCount() const { return (u32)(m_indices.size() / 3); }
+		inline const AABB &getBounds() const { return m_bounds; }
+		inline uint getNodeCount() const { return (uint)m_nodes.size(); }
+
+	private:
+		struct Node {
+			AABB box;
+			// First triangle of a leaf, second child of an inner node
+			u32 offset;
+			// 0 for inner nodes
+			u32 count;
+		};
+
+		static inline bool overlaps(const AABB &a, const AABB &b) {
+			return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+		}
+
+		u32 buildNode(std::vector<u32> &triangles, std::vector<AABB> &boxes, std::vector<glm::vec3> &centers, u32 begin, u32 end, uint depth);
+
+		std::vector<glm::vec3> m_positions;
+		std::vector<u32> m_indices;
+		std::vector<Node> m_nodes;
+		AABB m_bounds;
+	};
+}
+
+#endif
\ No newline at end of file
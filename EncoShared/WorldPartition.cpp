@@ -0,0 +1,324 @@
+#include "stdafx.h"
+#include "WorldPartition.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	namespace {
+		const u32 fileVersion = 1;
+		// Entities created or destroyed between two looks at the clock
+		const uint clockInterval = 32;
+
+		struct CellFileHeader {
+			char magic[4];
+			u32 version;
+			u32 meshCount;
+			u32 entityCount;
+		};
+
+		struct CellFileEntity {
+			i32 parent;
+			i32 mesh;
+			f32 position[3];
+			// x, y, z, w
+			f32 rotation[4];
+			f32 scale[3];
+		};
+	}
+
+	ENCOSHAREDAPI bool CellData::save(const std::string &path) const {
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		CellFileHeader header;
+		memcpy(header.magic, "ECEL", 4);
+		header.version = fileVersion;
+		header.meshCount = (u32)meshes.size();
+		header.entityCount = (u32)entities.size();
+		file.write((const char *)&header, sizeof(header));
+
+		for (size_t i = 0; i < meshes.size(); ++i) {
+			u32 length = (u32)meshes[i].size();
+			file.write((const char *)&length, sizeof(length));
+			file.write(meshes[i].data(), length);
+		}
+
+		std::vector<CellFileEntity> records(entities.size());
+		for (size_t i = 0; i < entities.size(); ++i) {
+			const CellEntity &entity = entities[i];
+			CellFileEntity &record = records[i];
+			record.parent = entity.parent;
+			record.mesh = entity.mesh;
+			record.position[0] = entity.transform.position.x;
+			record.position[1] = entity.transform.position.y;
+			record.position[2] = entity.transform.position.z;
+			record.rotation[0] = entity.transform.rotation.x;
+			record.rotation[1] = entity.transform.rotation.y;
+			record.rotation[2] = entity.transform.rotation.z;
+			record.rotation[3] = entity.transform.rotation.w;
+			record.scale[0] = entity.transform.scale.x;
+			record.scale[1] = entity.transform.scale.y;
+			record.scale[2] = entity.transform.scale.z;
+		}
+		if (!records.empty()) {
+			file.write((const char *)&records[0], records.size() * sizeof(CellFileEntity));
+		}
+		return file.good();
+	}
+
+	ENCOSHAREDAPI bool CellData::load(const std::string &path) {
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		if (!file) {
+			return false;
+		}
+
+		CellFileHeader header;
+		if (!file.read((char *)&header, sizeof(header)) || memcmp(header.magic, "ECEL", 4) != 0 || header.version == 0 || header.version > fileVersion) {
+#ifdef _DEBUG
+			printf("WorldPartition Error: %s is not a cell of version %u or older\n", path.c_str(), fileVersion);
+#endif
+			return false;
+		}
+
+		meshes.resize(header.meshCount);
+		for (u32 i = 0; i < header.meshCount; ++i) {
+			u32 length;
+			if (!file.read((char *)&length, sizeof(length))) {
+				return false;
+			}
+			meshes[i].resize(length);
+			if (length && !file.read(&meshes[i][0], length)) {
+				return false;
+			}
+		}
+
+		std::vector<CellFileEntity> records(header.entityCount);
+		if (!records.empty() && !file.read((char *)&records[0], records.size() * sizeof(CellFileEntity))) {
+			return false;
+		}
+
+		entities.resize(records.size());
+		for (size_t i = 0; i < records.size(); ++i) {
+			const CellFileEntity &record = records[i];
+			if (record.parent >= (i32)i || record.parent < -1 || record.mesh >= (i32)header.meshCount || record.mesh < -1) {
+#ifdef _DEBUG
+				printf("WorldPartition Error: Entity %u of %s refers to a parent or mesh that does not exist\n", (uint)i, path.c_str());
+#endif
+				return false;
+			}
+
+			CellEntity &entity = entities[i];
+			entity.parent = record.parent;
+			entity.mesh = record.mesh;
+			entity.transform.position = glm::vec3(record.position[0], record.position[1], record.position[2]);
+			entity.transform.rotation = glm::quat(record.rotation[3], record.rotation[0], record.rotation[1], record.rotation[2]);
+			entity.transform.scale = glm::vec3(record.scale[0], record.scale[1], record.scale[2]);
+		}
+		return true;
+	}
+
+	ENCOSHAREDAPI bool CellAsset::import(const std::string &path) {
+		std::shared_ptr<CellData> data(new CellData());
+		if (!data->load(path)) {
+			return false;
+		}
+
+		m_data = data;
+		return true;
+	}
+
+	ENCOSHAREDAPI WorldPartition::WorldPartition(AssetManager &assets, Scene &scene, const WorldPartitionSettings &settings) : m_assets(assets), m_scene(scene), m_settings(settings), m_loadingCells(0), m_entityCount(0), m_pendingEntities(0), m_updateTime(0.0f) {
+	}
+
+	ENCOSHAREDAPI WorldPartition::~WorldPartition() {
+		for (std::unordered_map<u64, Cell>::iterator it = m_cells.begin(); it != m_cells.end(); ++it) {
+			while (!it->second.entities.empty()) {
+				destroyEntity(it->second);
+			}
+			if (it->second.requested) {
+				m_assets.unload(getPath(it->first));
+			}
+		}
+	}
+
+	ENCOSHAREDAPI void WorldPartition::update() {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		// Cells that came within reach
+		f32 cellSize = m_settings.cellSize, loadRadius = m_settings.loadRadius;
+		for (size_t i = 0; i < m_viewPositions.size(); ++i) {
+			glm::vec3 position = m_viewPositions[i] - m_settings.origin;
+			i32 minX = (i32)floorf((position.x - loadRadius) / cellSize), maxX = (i32)floorf((position.x + loadRadius) / cellSize);
+			i32 minZ = (i32)floorf((position.z - loadRadius) / cellSize), maxZ = (i32)floorf((position.z + loadRadius) / cellSize);
+			for (i32 z = minZ; z <= maxZ; ++z) {
+				for (i32 x = minX; x <= maxX; ++x) {
+					u64 key = getKey(x, z);
+					if (m_cells.find(key) == m_cells.end() && getDistance(x, z) < loadRadius) {
+						m_cells[key].distance = getDistance(x, z);
+					}
+				}
+			}
+		}
+
+		// Cells out of reach are forgotten once their entities are gone
+		m_work.clear();
+		m_loadingCells = 0;
+		for (std::unordered_map<u64, Cell>::iterator it = m_cells.begin(); it != m_cells.end(); ) {
+			Cell &cell = it->second;
+			cell.distance = getDistance(getX(it->first), getZ(it->first));
+			if (!isWanted(cell) && cell.entities.empty()) {
+				if (cell.requested) {
+					m_assets.unload(getPath(it->first));
+				}
+				it = m_cells.erase(it);
+				continue;
+			}
+
+			if (!cell.requested) {
+				m_work.push_back(std::make_pair(cell.distance, it->first));
+			}
+			else if (!cell.asset.isReady() && !cell.asset.isFailed()) {
+				++m_loadingCells;
+			}
+			++it;
+		}
+
+		std::sort(m_work.begin(), m_work.end());
+		for (size_t i = 0; i < m_work.size() && m_loadingCells < m_settings.maxLoads; ++i) {
+			Cell &cell = m_cells[m_work[i].second];
+			cell.asset = m_assets.loadAsync<CellAsset>(getPath(m_work[i].second));
+			cell.requested = true;
+			++m_loadingCells;
+		}
+
+		// Unloads go first so memory is freed before more is taken, then the closest cells
+		m_work.clear();
+		for (std::unordered_map<u64, Cell>::iterator it = m_cells.begin(); it != m_cells.end(); ++it) {
+			if (hasWork(it->second)) {
+				m_work.push_back(std::make_pair(isWanted(it->second) ? it->second.distance : -1.0f, it->first));
+			}
+		}
+		std::sort(m_work.begin(), m_work.end());
+
+		uint operations = 0;
+		bool outOfTime = false;
+		for (size_t i = 0; i < m_work.size() && !outOfTime; ++i) {
+			Cell &cell = m_cells[m_work[i].second];
+			while (hasWork(cell)) {
+				step(cell);
+				if (++operations % clockInterval == 0 && std::chrono::duration<f32>(std::chrono::steady_clock::now() - start).count() >= m_settings.timeBudget) {
+					outOfTime = true;
+					break;
+				}
+			}
+		}
+
+		m_pendingEntities = 0;
+		for (std::unordered_map<u64, Cell>::const_iterator it = m_cells.begin(); it != m_cells.end(); ++it) {
+			const Cell &cell = it->second;
+			if (!isWanted(cell) || (cell.asset.isReady() && cell.asset.getVersion() != cell.version)) {
+				m_pendingEntities += (uint)cell.entities.size();
+			}
+			else if (cell.data) {
+				m_pendingEntities += (uint)(cell.data->entities.size() - cell.entities.size());
+			}
+		}
+
+		m_updateTime = std::chrono::duration<f32>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	std::string WorldPartition::getPath(u64 key) const {
+		return m_settings.directory + "/" + std::to_string(getX(key)) + "_" + std::to_string(getZ(key)) + ".ecell";
+	}
+
+	f32 WorldPartition::getDistance(i32 x, i32 z) const {
+		glm::vec2 minimum = glm::vec2(m_settings.origin.x, m_settings.origin.z) + glm::vec2((f32)x, (f32)z) * m_settings.cellSize;
+		glm::vec2 maximum = minimum + m_settings.cellSize;
+
+		f32 distance = 1e30f;
+		for (size_t i = 0; i < m_viewPositions.size(); ++i) {
+			glm::vec2 position(m_viewPositions[i].x, m_viewPositions[i].z);
+			glm::vec2 offset = glm::max(glm::max(minimum - position, position - maximum), glm::vec2(0.0f));
+			distance = std::min(distance, glm::length(offset));
+		}
+		return distance;
+	}
+
+	bool WorldPartition::isWanted(const Cell &cell) const {
+		return cell.distance < m_settings.unloadRadius;
+	}
+
+	bool WorldPartition::hasWork(const Cell &cell) const {
+		if (!isWanted(cell)) {
+			return !cell.entities.empty();
+		}
+		// A re-imported cell is torn down and built again from the new data
+		if (cell.asset.isReady() && cell.asset.getVersion() != cell.version) {
+			return true;
+		}
+		return cell.data && cell.entities.size() < cell.data->entities.size();
+	}
+
+	void WorldPartition::step(Cell &cell) {
+		if (isWanted(cell) && !(cell.asset.isReady() && cell.asset.getVersion() != cell.version)) {
+			createEntity(cell);
+		}
+		else if (!cell.entities.empty()) {
+			destroyEntity(cell);
+		}
+		else {
+			cell.data = cell.asset->getData();
+			cell.version = cell.asset.getVersion();
+		}
+	}
+
+	void WorldPartition::createEntity(Cell &cell) {
+		const CellEntity &record = cell.data->entities[cell.entities.size()];
+		Entity parent = record.parent >= 0 ? cell.entities[record.parent] : Scene::invalidEntity;
+
+		// Children of entities that could not be created or were destroyed by the game are left out
+		Entity entity = Scene::invalidEntity;
+		if (record.parent < 0 || parent != Scene::invalidEntity) {
+			entity = m_scene.createEntity(parent, record.transform);
+		}
+		if (entity != Scene::invalidEntity) {
+			++m_entityCount;
+			if (record.mesh >= 0) {
+				const std::string &path = cell.data->meshes[record.mesh];
+				++m_meshUsers[path];
+				m_scene.setMesh(entity, m_assets.loadAsync<MeshAsset>(path));
+			}
+		}
+		cell.entities.push_back(entity);
+	}
+
+	void WorldPartition::destroyEntity(Cell &cell) {
+		// Children come after their parents, so destroying from the back never takes more than one entity at once
+		Entity entity = cell.entities.back();
+		const CellEntity &record = cell.data->entities[cell.entities.size() - 1];
+		cell.entities.pop_back();
+		if (entity == Scene::invalidEntity) {
+			return;
+		}
+
+		m_scene.destroyEntity(entity);
+		--m_entityCount;
+		if (record.mesh >= 0) {
+			releaseMesh(cell.data->meshes[record.mesh]);
+		}
+	}
+
+	void WorldPartition::releaseMesh(const std::string &path) {
+		std::unordered_map<std::string, uint>::iterator it = m_meshUsers.find(path);
+		if (--it->second == 0) {
+			m_meshUsers.erase(it);
+			m_assets.unload(path);
+		}
+	}
+}
\ No newline at end of file
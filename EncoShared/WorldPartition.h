@@ -0,0 +1,141 @@
+#ifndef __ENCOSHARED_WORLDPARTITION_H__
+#define __ENCOSHARED_WORLDPARTITION_H__
+
+#pragma once
+
+#include "stdafx.h"
+#include "AssetManager.h"
+#include "Scene.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	struct CellEntity {
+		// Index of an earlier entity of the same cell or -1 for a root
+		i32 parent;
+		// Index into CellData::meshes or -1
+		i32 mesh;
+		// Relative to the parent, roots are in world space
+		Transform transform;
+	};
+
+	// The entities of one cell of a WorldPartition, parents always come before their children
+	class CellData {
+	public:
+		ENCOSHAREDAPI bool save(const std::string &path) const;
+		ENCOSHAREDAPI bool load(const std::string &path);
+
+		// Asset paths
+		std::vector<std::string> meshes;
+		std::vector<CellEntity> entities;
+	};
+
+	class CellAsset : public IAsset {
+	public:
+		ENCOSHAREDAPI virtual bool import(const std::string &path);
+
+		// Shared so a cell can keep instantiating the data it started with while a re-import swaps in new data
+		inline std::shared_ptr<const CellData> getData() const { return m_data; }
+
+	private:
+		std::shared_ptr<const CellData> m_data;
+	};
+
+	struct WorldPartitionSettings {
+		// Side of the square cells along x and z, starting at origin
+		f32 cellSize;
+		// Cells are loaded once a view position is within loadRadius of them and unloaded once every view position
+		// is further away than unloadRadius, which has to be larger so cells on the border do not come and go
+		f32 loadRadius;
+		f32 unloadRadius;
+		// Cell imports in flight at once
+		uint maxLoads;
+		// Seconds update() may spend creating and destroying entities per frame
+		f32 timeBudget;
+		// Cells are loaded from <directory>/<x>_<z>.ecell, a cell without a file is empty
+		std::string directory;
+		glm::vec3 origin;
+
+		inline WorldPartitionSettings() : cellSize(64.0f), loadRadius(256.0f), unloadRadius(320.0f), maxLoads(8), timeBudget(0.001f), directory("world"), origin(0.0f) {  }
+	};
+
+	// Splits the world into a grid of cells that are loaded around the view positions through the asset manager
+	// and instantiated into a Scene a few entities at a time, so neither a large cell nor a fast moving view
+	// makes a frame take longer than the time budget. Only cells within reach of a view are known at all, the
+	// memory taken does not depend on the size of the world.
+	class WorldPartition {
+	public:
+		ENCOSHAREDAPI WorldPartition(AssetManager &assets, Scene &scene, const WorldPartitionSettings &settings = WorldPartitionSettings());
+		// Destroys the entities of every cell, the scene has to outlive the partition
+		ENCOSHAREDAPI ~WorldPartition();
+
+		inline const WorldPartitionSettings &getSettings() const { return m_settings; }
+
+		// Usually the cameras, nothing is loaded before the first call
+		inline void setViewPositions(const std::vector<glm::vec3> &positions) { m_viewPositions = positions; }
+		inline const std::vector<glm::vec3> &getViewPositions() const { return m_viewPositions; }
+
+		// Requests the cells around the view positions and creates and destroys entities until the time budget
+		// is used up, closest cells first. Call once per frame after AssetManager::commit().
+		ENCOSHAREDAPI void update();
+
+		// Cells within reach of a view whose file was imported or turned out not to exist
+		inline uint getCellCount() const { return (uint)m_cells.size(); }
+		inline uint getLoadingCellCount() const { return m_loadingCells; }
+		inline uint getEntityCount() const { return m_entityCount; }
+		// Entities still to be created or destroyed
+		inline uint getPendingEntityCount() const { return m_pendingEntities; }
+		// Seconds the last update() spent, mostly on entities
+		inline f32 getUpdateTime() const { return m_updateTime; }
+
+	private:
+		struct Cell {
+			Asset<CellAsset> asset;
+			std::shared_ptr<const CellData> data;
+			u32 version;
+			// Created so far, in the order of data->entities
+			std::vector<Entity> entities;
+			f32 distance;
+			bool requested;
+
+			inline Cell() : version(0), distance(0.0f), requested(false) {  }
+		};
+
+		WorldPartition(const WorldPartition &) = delete;
+		WorldPartition &operator=(const WorldPartition &) = delete;
+
+		static inline u64 getKey(i32 x, i32 z) { return ((u64)(u32)x << 32) | (u32)z; }
+		static inline i32 getX(u64 key) { return (i32)(u32)(key >> 32); }
+		static inline i32 getZ(u64 key) { return (i32)(u32)key; }
+
+		std::string getPath(u64 key) const;
+		f32 getDistance(i32 x, i32 z) const;
+		bool isWanted(const Cell &cell) const;
+		bool hasWork(const Cell &cell) const;
+		// Creates or destroys one entity
+		void step(Cell &cell);
+		void createEntity(Cell &cell);
+		void destroyEntity(Cell &cell);
+		void releaseMesh(const std::string &path);
+
+		AssetManager &m_assets;
+		Scene &m_scene;
+		WorldPartitionSettings m_settings;
+		std::vector<glm::vec3> m_viewPositions;
+
+		std::unordered_map<u64, Cell> m_cells;
+		// Entities using each mesh, a mesh nothing uses any more is unloaded
+		std::unordered_map<std::string, uint> m_meshUsers;
+		std::vector<std::pair<f32, u64>> m_work;
+
+		uint m_loadingCells;
+		uint m_entityCount;
+		uint m_pendingEntities;
+		f32 m_updateTime;
+	};
+}
+
+#endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 // dllmain.cpp : Definiert den Einstiegspunkt fr die DLL-Anwendung.
 #include "stdafx.h"
+#include "DebugDraw.h"
 
 #ifdef _WIN32
 
@@ -12,7 +13,10 @@ BOOL APIENTRY DllMain(HMODULE hModule,
 	{
 	case DLL_PROCESS_ATTACH:
 	case DLL_THREAD_ATTACH:
+		break;
 	case DLL_THREAD_DETACH:
+		enco::DebugDraw::releaseThreadSlot();
+		break;
 	case DLL_PROCESS_DETACH:
 		break;
 	}
@@ -17,6 +17,14 @@
 #	define ENCOSHAREDAPI
 #endif
 
+#ifdef _MSC_VER
+#	define ENCO_THREAD_LOCAL __declspec(thread)
+#	define ENCO_ALIGN(bytes) __declspec(align(bytes))
+#else
+#	define ENCO_THREAD_LOCAL __thread
+#	define ENCO_ALIGN(bytes) __attribute__((aligned(bytes)))
+#endif
+
 namespace enco {
 	typedef char int8, i8;
 	typedef short int16, i16;
@@ -0,0 +1,648 @@
+#include "FrameReplay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace enco {
+	namespace {
+		typedef std::chrono::high_resolution_clock Clock;
+
+		inline f64 getMilliseconds(Clock::time_point start, Clock::time_point end) {
+			return std::chrono::duration<f64, std::milli>(end - start).count();
+		}
+
+		inline GLint toInt(const FrameReplay::Command &command, uint index) { return (GLint)(i64)command.args[index]; }
+		inline GLuint toUint(const FrameReplay::Command &command, uint index) { return (GLuint)command.args[index]; }
+		inline GLintptr toIntptr(const FrameReplay::Command &command, uint index) { return (GLintptr)(i64)command.args[index]; }
+		inline GLboolean toBoolean(const FrameReplay::Command &command, uint index) { return command.args[index] != 0 ? GL_TRUE : GL_FALSE; }
+		inline const void *toPointer(const FrameReplay::Command &command, uint index) { return (const void *)(size_t)command.args[index]; }
+
+		inline GLfloat toFloat(const FrameReplay::Command &command, uint index) {
+			u32 bits = (u32)command.args[index];
+			GLfloat value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		inline GLdouble toDouble(const FrameReplay::Command &command, uint index) {
+			GLdouble value;
+			memcpy(&value, &command.args[index], sizeof(value));
+			return value;
+		}
+
+		// The recorded client memory, or the offset into the bound buffer
+		inline const void *toData(const FrameReplay::Command &command, uint index) {
+			return command.hasBlob ? (const void *)command.blob : toPointer(command, index);
+		}
+	}
+
+	FrameReplay::FrameReplay() : m_size(0, 0), m_rebuild(false), m_ready(false), m_played(false), m_program(0), m_skipped(0) {
+		m_queries[0] = m_queries[1] = 0;
+	}
+
+	FrameReplay::~FrameReplay() {
+		release();
+	}
+
+	bool FrameReplay::load(const std::string &path) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file) {
+			printf("GLReplay Error: could not open %s\n", path.c_str());
+			return false;
+		}
+		m_data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+		GLCaptureFileHeader header;
+		if (m_data.size() < sizeof(header)) {
+			printf("GLReplay Error: %s is not a capture\n", path.c_str());
+			return false;
+		}
+		memcpy(&header, &m_data[0], sizeof(header));
+		// The call numbers change between versions, so older captures cannot be replayed either
+		if (memcmp(header.magic, "EGLC", 4) != 0 || header.version != glCaptureFileVersion) {
+			printf("GLReplay Error: %s is not a capture of version %u\n", path.c_str(), glCaptureFileVersion);
+			return false;
+		}
+
+		m_size = glm::u32vec2(header.width, header.height);
+		size_t offset = sizeof(header);
+		for (uint i = 0; i < glCaptureSectionCount; ++i) {
+			if (m_data.size() - offset < header.sectionSizes[i] || !decode((GLCaptureSection)i, &m_data[0] + offset, (size_t)header.sectionSizes[i], header.callCounts[i])) {
+				printf("GLReplay Error: %s is damaged\n", path.c_str());
+				return false;
+			}
+			offset += (size_t)header.sectionSizes[i];
+		}
+
+		// Objects the frame deletes without having created them come from the setup
+		std::vector<FrameObject> created;
+		const std::vector<Command> &frame = m_sections[glCaptureFrame];
+		for (size_t i = 0; i < frame.size() && !m_rebuild; ++i) {
+			const Command &command = frame[i];
+			NameType type = getNameType(command.call);
+			switch (command.call) {
+			case glCreateProgramCall:
+			case glCreateShaderCall:
+				created.push_back(FrameObject{ programName, (u32)command.args[command.argCount - 1] });
+				break;
+			case glGenBuffersCall:
+			case glGenTexturesCall:
+			case glGenVertexArraysCall:
+			case glGenFramebuffersCall:
+			case glGenRenderbuffersCall:
+			case glGenQueriesCall:
+				for (size_t j = 0; j + sizeof(u32) <= command.blobSize; j += sizeof(u32)) {
+					u32 name;
+					memcpy(&name, command.blob + j, sizeof(name));
+					created.push_back(FrameObject{ type, name });
+				}
+				break;
+			case glDeleteProgramCall:
+			case glDeleteShaderCall:
+			case glDeleteBuffersCall:
+			case glDeleteTexturesCall:
+			case glDeleteVertexArraysCall:
+			case glDeleteFramebuffersCall:
+			case glDeleteRenderbuffersCall:
+			case glDeleteQueriesCall: {
+				std::vector<u32> names;
+				if (command.hasBlob) {
+					names.resize((size_t)command.blobSize / sizeof(u32));
+					if (!names.empty()) {
+						memcpy(&names[0], command.blob, names.size() * sizeof(u32));
+					}
+				}
+				else {
+					names.push_back((u32)command.args[0]);
+				}
+				for (size_t j = 0; j < names.size(); ++j) {
+					bool own = names[j] == 0;
+					for (size_t k = 0; k < created.size() && !own; ++k) {
+						own = created[k].type == type && created[k].name == names[j];
+					}
+					m_rebuild = m_rebuild || !own;
+				}
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		m_callTimings.assign(frame.size(), CallTiming());
+		return true;
+	}
+
+	FrameReplay::NameType FrameReplay::getNameType(GLCaptureCall call) {
+		switch (call) {
+		case glGenBuffersCall:
+		case glDeleteBuffersCall:
+			return bufferName;
+		case glGenTexturesCall:
+		case glDeleteTexturesCall:
+			return textureName;
+		case glGenVertexArraysCall:
+		case glDeleteVertexArraysCall:
+			return vertexArrayName;
+		case glGenFramebuffersCall:
+		case glDeleteFramebuffersCall:
+			return framebufferName;
+		case glGenRenderbuffersCall:
+		case glDeleteRenderbuffersCall:
+			return renderbufferName;
+		case glGenQueriesCall:
+		case glDeleteQueriesCall:
+			return queryName;
+		default:
+			return programName;
+		}
+	}
+
+	bool FrameReplay::decode(GLCaptureSection section, const u8 *data, size_t size, u32 count) {
+		std::vector<Command> &commands = m_sections[section];
+		commands.resize(count);
+		size_t cursor = 0;
+		for (u32 i = 0; i < count; ++i) {
+			Command &command = commands[i];
+			if (size - cursor < 4) {
+				return false;
+			}
+			u16 call;
+			memcpy(&call, data + cursor, sizeof(call));
+			command.call = (GLCaptureCall)call;
+			command.argCount = data[cursor + 2];
+			command.hasBlob = data[cursor + 3] != 0;
+			cursor += 4;
+
+			if (command.call >= glCaptureCallCount || command.argCount > 16 || size - cursor < command.argCount * sizeof(u64)) {
+				return false;
+			}
+			memset(command.args, 0, sizeof(command.args));
+			memcpy(command.args, data + cursor, command.argCount * sizeof(u64));
+			cursor += command.argCount * sizeof(u64);
+
+			command.blob = nullptr;
+			command.blobSize = 0;
+			if (command.hasBlob) {
+				if (size - cursor < sizeof(u64)) {
+					return false;
+				}
+				memcpy(&command.blobSize, data + cursor, sizeof(u64));
+				cursor += sizeof(u64);
+				if (size - cursor < command.blobSize) {
+					return false;
+				}
+				command.blob = data + cursor;
+				cursor += (size_t)command.blobSize;
+			}
+		}
+		return cursor == size;
+	}
+
+	void FrameReplay::setup() {
+		release();
+		const std::vector<Command> &commands = m_sections[glCaptureSetup];
+		for (size_t i = 0; i < commands.size(); ++i) {
+			execute(commands[i], false);
+		}
+		glGenQueries(2, m_queries);
+		m_ready = true;
+		m_played = false;
+	}
+
+	void FrameReplay::replay() {
+		if (!m_ready || (m_rebuild && m_played)) {
+			setup();
+		}
+
+		const std::vector<Command> &reset = m_sections[glCaptureReset];
+		for (size_t i = 0; i < reset.size(); ++i) {
+			execute(reset[i], false);
+		}
+		glFinish();
+
+		m_played = true;
+		glQueryCounter(m_queries[0], GL_TIMESTAMP);
+		const std::vector<Command> &frame = m_sections[glCaptureFrame];
+		Clock::time_point frameStart = Clock::now();
+		for (size_t i = 0; i < frame.size(); ++i) {
+			Clock::time_point start = Clock::now();
+			execute(frame[i], true);
+			f64 time = getMilliseconds(start, Clock::now());
+			m_callTimings[i].total += time;
+			m_callTimings[i].max = std::max(m_callTimings[i].max, time);
+		}
+		Clock::time_point frameEnd = Clock::now();
+		glQueryCounter(m_queries[1], GL_TIMESTAMP);
+		glFinish();
+		Clock::time_point finishEnd = Clock::now();
+
+		GLuint64 timestamps[2] = { 0, 0 };
+		glGetQueryObjectui64v(m_queries[0], GL_QUERY_RESULT, &timestamps[0]);
+		glGetQueryObjectui64v(m_queries[1], GL_QUERY_RESULT, &timestamps[1]);
+		m_frameTimes.push_back(getMilliseconds(frameStart, frameEnd));
+		m_finishTimes.push_back(getMilliseconds(frameEnd, finishEnd));
+		m_gpuTimes.push_back((f64)(timestamps[1] - timestamps[0]) / 1000000.0);
+
+		deleteFrameObjects();
+	}
+
+	void FrameReplay::release() {
+		if (!m_ready) {
+			return;
+		}
+
+		deleteFrameObjects();
+		for (std::unordered_map<u32, Mapping>::iterator mapping = m_mappings.begin(); mapping != m_mappings.end(); ++mapping) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, getName(bufferName, mapping->first));
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+		}
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+		m_mappings.clear();
+
+		for (std::unordered_map<u32, GLuint>::iterator name = m_names[programName].begin(); name != m_names[programName].end(); ++name) {
+			if (glIsProgram(name->second)) {
+				glDeleteProgram(name->second);
+			}
+			else {
+				glDeleteShader(name->second);
+			}
+		}
+		for (uint type = 0; type < nameTypeCount; ++type) {
+			std::vector<GLuint> names;
+			for (std::unordered_map<u32, GLuint>::iterator name = m_names[type].begin(); name != m_names[type].end(); ++name) {
+				names.push_back(name->second);
+			}
+			if (!names.empty()) {
+				GLsizei count = (GLsizei)names.size();
+				switch (type) {
+				case bufferName: glDeleteBuffers(count, &names[0]); break;
+				case textureName: glDeleteTextures(count, &names[0]); break;
+				case vertexArrayName: glDeleteVertexArrays(count, &names[0]); break;
+				case framebufferName: glDeleteFramebuffers(count, &names[0]); break;
+				case renderbufferName: glDeleteRenderbuffers(count, &names[0]); break;
+				case queryName: glDeleteQueries(count, &names[0]); break;
+				default: break;
+				}
+			}
+			m_names[type].clear();
+		}
+		for (std::unordered_map<u64, GLsync>::iterator sync = m_syncs.begin(); sync != m_syncs.end(); ++sync) {
+			glDeleteSync(sync->second);
+		}
+		m_syncs.clear();
+		m_locations.clear();
+		glDeleteQueries(2, m_queries);
+		m_program = 0;
+		m_ready = false;
+	}
+
+	void FrameReplay::resetTimings() {
+		m_callTimings.assign(m_sections[glCaptureFrame].size(), CallTiming());
+		m_frameTimes.clear();
+		m_finishTimes.clear();
+		m_gpuTimes.clear();
+		m_skipped = 0;
+	}
+
+	GLuint FrameReplay::getName(NameType type, u64 captured) const {
+		std::unordered_map<u32, GLuint>::const_iterator name = m_names[type].find((u32)captured);
+		return name != m_names[type].end() ? name->second : 0;
+	}
+
+	GLint FrameReplay::getLocation(u64 captured) const {
+		GLint location = (GLint)(i64)captured;
+		if (location < 0) {
+			return location;
+		}
+		std::unordered_map<u64, GLint>::const_iterator found = m_locations.find((u64)m_program << 32 | (u32)location);
+		return found != m_locations.end() ? found->second : location;
+	}
+
+	void FrameReplay::genNames(NameType type, const Command &command, bool frame) {
+		GLsizei count = (GLsizei)(command.blobSize / sizeof(u32));
+		if (count <= 0) {
+			return;
+		}
+		std::vector<GLuint> names((size_t)count);
+		switch (type) {
+		case bufferName: glGenBuffers(count, &names[0]); break;
+		case textureName: glGenTextures(count, &names[0]); break;
+		case vertexArrayName: glGenVertexArrays(count, &names[0]); break;
+		case framebufferName: glGenFramebuffers(count, &names[0]); break;
+		case renderbufferName: glGenRenderbuffers(count, &names[0]); break;
+		case queryName: glGenQueries(count, &names[0]); break;
+		default: break;
+		}
+		for (GLsizei i = 0; i < count; ++i) {
+			u32 captured;
+			memcpy(&captured, command.blob + i * sizeof(u32), sizeof(captured));
+			m_names[type][captured] = names[i];
+			if (frame) {
+				m_frameObjects.push_back(FrameObject{ type, captured });
+			}
+		}
+	}
+
+	void FrameReplay::deleteNames(NameType type, const Command &command) {
+		for (size_t i = 0; i + sizeof(u32) <= command.blobSize; i += sizeof(u32)) {
+			u32 captured;
+			memcpy(&captured, command.blob + i, sizeof(captured));
+			deleteName(type, captured);
+		}
+	}
+
+	void FrameReplay::deleteName(NameType type, u32 captured) {
+		std::unordered_map<u32, GLuint>::iterator name = m_names[type].find(captured);
+		if (name == m_names[type].end()) {
+			return;
+		}
+
+		GLuint replayed = name->second;
+		switch (type) {
+		case bufferName: glDeleteBuffers(1, &replayed); m_mappings.erase(captured); break;
+		case textureName: glDeleteTextures(1, &replayed); break;
+		case vertexArrayName: glDeleteVertexArrays(1, &replayed); break;
+		case framebufferName: glDeleteFramebuffers(1, &replayed); break;
+		case renderbufferName: glDeleteRenderbuffers(1, &replayed); break;
+		case queryName: glDeleteQueries(1, &replayed); break;
+		case programName:
+			if (glIsProgram(replayed)) {
+				glDeleteProgram(replayed);
+			}
+			else {
+				glDeleteShader(replayed);
+			}
+			break;
+		default: break;
+		}
+		m_names[type].erase(name);
+	}
+
+	void FrameReplay::deleteFrameObjects() {
+		for (size_t i = 0; i < m_frameObjects.size(); ++i) {
+			deleteName(m_frameObjects[i].type, m_frameObjects[i].name);
+		}
+		m_frameObjects.clear();
+
+		for (size_t i = 0; i < m_frameSyncs.size(); ++i) {
+			std::unordered_map<u64, GLsync>::iterator sync = m_syncs.find(m_frameSyncs[i]);
+			if (sync != m_syncs.end()) {
+				glDeleteSync(sync->second);
+				m_syncs.erase(sync);
+			}
+		}
+		m_frameSyncs.clear();
+	}
+
+	void FrameReplay::execute(const Command &command, bool frame) {
+		const Command &c = command;
+		switch (c.call) {
+		case glActiveTextureCall: glActiveTexture(toUint(c, 0)); break;
+		case glAttachShaderCall: glAttachShader(getName(programName, c.args[0]), getName(programName, c.args[1])); break;
+		case glBindBufferCall: glBindBuffer(toUint(c, 0), getName(bufferName, c.args[1])); break;
+		case glBindBufferBaseCall: glBindBufferBase(toUint(c, 0), toUint(c, 1), getName(bufferName, c.args[2])); break;
+		case glBindBufferRangeCall: glBindBufferRange(toUint(c, 0), toUint(c, 1), getName(bufferName, c.args[2]), toIntptr(c, 3), toIntptr(c, 4)); break;
+		case glBindFramebufferCall: glBindFramebuffer(toUint(c, 0), getName(framebufferName, c.args[1])); break;
+		case glBindRenderbufferCall: glBindRenderbuffer(toUint(c, 0), getName(renderbufferName, c.args[1])); break;
+		case glBindTextureCall: glBindTexture(toUint(c, 0), getName(textureName, c.args[1])); break;
+		case glBindVertexArrayCall: glBindVertexArray(getName(vertexArrayName, c.args[0])); break;
+		case glBindVertexBufferCall: glBindVertexBuffer(toUint(c, 0), getName(bufferName, c.args[1]), toIntptr(c, 2), toInt(c, 3)); break;
+		case glBlendFuncCall: glBlendFunc(toUint(c, 0), toUint(c, 1)); break;
+		case glBlendFuncSeparateCall: glBlendFuncSeparate(toUint(c, 0), toUint(c, 1), toUint(c, 2), toUint(c, 3)); break;
+		case glBlitFramebufferCall: glBlitFramebuffer(toInt(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toInt(c, 4), toInt(c, 5), toInt(c, 6), toInt(c, 7), toUint(c, 8), toUint(c, 9)); break;
+		case glBufferDataCall: glBufferData(toUint(c, 0), toIntptr(c, 1), c.blob, toUint(c, 2)); break;
+		case glBufferStorageCall: glBufferStorage(toUint(c, 0), toIntptr(c, 1), c.blob, toUint(c, 2)); break;
+		case glBufferSubDataCall: glBufferSubData(toUint(c, 0), toIntptr(c, 1), toIntptr(c, 2), c.blob); break;
+		case glCheckFramebufferStatusCall: glCheckFramebufferStatus(toUint(c, 0)); break;
+		case glClearCall: glClear(toUint(c, 0)); break;
+		case glClearColorCall: glClearColor(toFloat(c, 0), toFloat(c, 1), toFloat(c, 2), toFloat(c, 3)); break;
+		case glClearDepthCall: glClearDepth(toDouble(c, 0)); break;
+		case glClientWaitSyncCall: {
+			std::unordered_map<u64, GLsync>::const_iterator sync = m_syncs.find(c.args[0]);
+			if (sync != m_syncs.end()) {
+				glClientWaitSync(sync->second, toUint(c, 1), (GLuint64)c.args[2]);
+			}
+			else {
+				++m_skipped;
+			}
+			break;
+		}
+		case glCompileShaderCall: glCompileShader(getName(programName, c.args[0])); break;
+		case glCopyImageSubDataCall: {
+			GLenum srcTarget = toUint(c, 1), dstTarget = toUint(c, 7);
+			GLuint src = getName(srcTarget == GL_RENDERBUFFER ? renderbufferName : textureName, c.args[0]);
+			GLuint dst = getName(dstTarget == GL_RENDERBUFFER ? renderbufferName : textureName, c.args[6]);
+			glCopyImageSubData(src, srcTarget, toInt(c, 2), toInt(c, 3), toInt(c, 4), toInt(c, 5), dst, dstTarget, toInt(c, 8), toInt(c, 9), toInt(c, 10), toInt(c, 11), toInt(c, 12), toInt(c, 13), toInt(c, 14));
+			break;
+		}
+		case glCreateProgramCall:
+		case glCreateShaderCall: {
+			GLuint name = c.call == glCreateProgramCall ? glCreateProgram() : glCreateShader(toUint(c, 0));
+			u32 captured = (u32)c.args[c.argCount - 1];
+			m_names[programName][captured] = name;
+			if (frame) {
+				m_frameObjects.push_back(FrameObject{ programName, captured });
+			}
+			break;
+		}
+		case glDeleteBuffersCall: deleteNames(bufferName, c); break;
+		case glDeleteFramebuffersCall: deleteNames(framebufferName, c); break;
+		case glDeleteProgramCall:
+		case glDeleteShaderCall: deleteName(programName, (u32)c.args[0]); break;
+		case glDeleteQueriesCall: deleteNames(queryName, c); break;
+		case glDeleteRenderbuffersCall: deleteNames(renderbufferName, c); break;
+		case glDeleteSyncCall: {
+			std::unordered_map<u64, GLsync>::iterator sync = m_syncs.find(c.args[0]);
+			if (sync != m_syncs.end()) {
+				glDeleteSync(sync->second);
+				m_syncs.erase(sync);
+			}
+			else {
+				++m_skipped;
+			}
+			break;
+		}
+		case glDeleteTexturesCall: deleteNames(textureName, c); break;
+		case glDeleteVertexArraysCall: deleteNames(vertexArrayName, c); break;
+		case glDepthFuncCall: glDepthFunc(toUint(c, 0)); break;
+		case glDepthMaskCall: glDepthMask(toBoolean(c, 0)); break;
+		case glDisableCall: glDisable(toUint(c, 0)); break;
+		case glDrawArraysCall: glDrawArrays(toUint(c, 0), toInt(c, 1), toInt(c, 2)); break;
+		case glDrawArraysInstancedCall: glDrawArraysInstanced(toUint(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3)); break;
+		case glDrawArraysInstancedBaseInstanceCall: glDrawArraysInstancedBaseInstance(toUint(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toUint(c, 4)); break;
+		case glDrawBufferCall: glDrawBuffer(toUint(c, 0)); break;
+		case glDrawBuffersCall: glDrawBuffers(toInt(c, 0), (const GLenum *)c.blob); break;
+		case glDrawElementsCall: glDrawElements(toUint(c, 0), toInt(c, 1), toUint(c, 2), toData(c, 3)); break;
+		case glDrawElementsInstancedCall: glDrawElementsInstanced(toUint(c, 0), toInt(c, 1), toUint(c, 2), toData(c, 3), toInt(c, 4)); break;
+		case glDrawElementsInstancedBaseVertexCall: glDrawElementsInstancedBaseVertex(toUint(c, 0), toInt(c, 1), toUint(c, 2), toData(c, 3), toInt(c, 4), toInt(c, 5)); break;
+		case glDrawElementsInstancedBaseVertexBaseInstanceCall: glDrawElementsInstancedBaseVertexBaseInstance(toUint(c, 0), toInt(c, 1), toUint(c, 2), toData(c, 3), toInt(c, 4), toInt(c, 5), toUint(c, 6)); break;
+		case glEnableCall: glEnable(toUint(c, 0)); break;
+		case glEnableVertexAttribArrayCall: glEnableVertexAttribArray(toUint(c, 0)); break;
+		case glFenceSyncCall: {
+			m_syncs[c.args[2]] = glFenceSync(toUint(c, 0), toUint(c, 1));
+			if (frame) {
+				m_frameSyncs.push_back(c.args[2]);
+			}
+			break;
+		}
+		case glFramebufferRenderbufferCall: glFramebufferRenderbuffer(toUint(c, 0), toUint(c, 1), toUint(c, 2), getName(renderbufferName, c.args[3])); break;
+		case glFramebufferTexture2DCall: glFramebufferTexture2D(toUint(c, 0), toUint(c, 1), toUint(c, 2), getName(textureName, c.args[3]), toInt(c, 4)); break;
+		case glFramebufferTextureLayerCall: glFramebufferTextureLayer(toUint(c, 0), toUint(c, 1), getName(textureName, c.args[2]), toInt(c, 3), toInt(c, 4)); break;
+		case glGenBuffersCall: genNames(bufferName, c, frame); break;
+		case glGenFramebuffersCall: genNames(framebufferName, c, frame); break;
+		case glGenQueriesCall: genNames(queryName, c, frame); break;
+		case glGenRenderbuffersCall: genNames(renderbufferName, c, frame); break;
+		case glGenTexturesCall: genNames(textureName, c, frame); break;
+		case glGenVertexArraysCall: genNames(vertexArrayName, c, frame); break;
+		case glGetBooleanvCall: {
+			GLboolean values[16];
+			glGetBooleanv(toUint(c, 0), values);
+			break;
+		}
+		case glGetErrorCall: glGetError(); break;
+		case glGetIntegervCall: {
+			GLint values[16];
+			glGetIntegerv(toUint(c, 0), values);
+			break;
+		}
+		case glGetProgramInfoLogCall:
+		case glGetShaderInfoLogCall: {
+			GLsizei size = std::max(toInt(c, 1), 1);
+			if (m_scratch.size() < (size_t)size) {
+				m_scratch.resize((size_t)size);
+			}
+			if (c.call == glGetProgramInfoLogCall) {
+				glGetProgramInfoLog(getName(programName, c.args[0]), size, nullptr, (GLchar *)&m_scratch[0]);
+			}
+			else {
+				glGetShaderInfoLog(getName(programName, c.args[0]), size, nullptr, (GLchar *)&m_scratch[0]);
+			}
+			break;
+		}
+		case glGetProgramivCall: {
+			GLint values[4];
+			glGetProgramiv(getName(programName, c.args[0]), toUint(c, 1), values);
+			break;
+		}
+		case glGetQueryObjectivCall: {
+			GLint value;
+			glGetQueryObjectiv(getName(queryName, c.args[0]), toUint(c, 1), &value);
+			break;
+		}
+		case glGetQueryObjectui64vCall: {
+			GLuint64 value;
+			glGetQueryObjectui64v(getName(queryName, c.args[0]), toUint(c, 1), &value);
+			break;
+		}
+		case glGetShaderivCall: {
+			GLint value;
+			glGetShaderiv(getName(programName, c.args[0]), toUint(c, 1), &value);
+			break;
+		}
+		case glGetUniformLocationCall:
+		case uniformNameCall: {
+			std::string name((const char *)c.blob, (size_t)c.blobSize);
+			GLint location = glGetUniformLocation(getName(programName, c.args[0]), name.c_str());
+			m_locations[c.args[0] << 32 | (u32)c.args[1]] = location;
+			break;
+		}
+		case glIsEnabledCall: glIsEnabled(toUint(c, 0)); break;
+		case glLinkProgramCall: glLinkProgram(getName(programName, c.args[0])); break;
+		case glMapBufferRangeCall: {
+			void *pointer = glMapBufferRange(toUint(c, 0), toIntptr(c, 1), toIntptr(c, 2), toUint(c, 3));
+			if (pointer) {
+				Mapping mapping = { (u8 *)pointer, (i64)c.args[1], (i64)c.args[2] };
+				m_mappings[(u32)c.args[4]] = mapping;
+			}
+			break;
+		}
+		case glMultiDrawElementsIndirectCall: glMultiDrawElementsIndirect(toUint(c, 0), toUint(c, 1), toData(c, 2), toInt(c, 3), toInt(c, 4)); break;
+		case glPixelStoreiCall: glPixelStorei(toUint(c, 0), toInt(c, 1)); break;
+		case glPolygonOffsetCall: glPolygonOffset(toFloat(c, 0), toFloat(c, 1)); break;
+		case glQueryCounterCall: glQueryCounter(getName(queryName, c.args[0]), toUint(c, 1)); break;
+		case glReadBufferCall: glReadBuffer(toUint(c, 0)); break;
+		case glReadPixelsCall: {
+			// Without a pack buffer the pixels went to client memory, here they go to scratch memory
+			void *pixels = (void *)toPointer(c, 6);
+			if (!c.args[7]) {
+				size_t size = (size_t)std::max(toInt(c, 2), 0) * (size_t)std::max(toInt(c, 3), 0) * 16;
+				if (m_scratch.size() < std::max(size, (size_t)1)) {
+					m_scratch.resize(std::max(size, (size_t)1));
+				}
+				pixels = &m_scratch[0];
+			}
+			glReadPixels(toInt(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toUint(c, 4), toUint(c, 5), pixels);
+			break;
+		}
+		case glRenderbufferStorageMultisampleCall: glRenderbufferStorageMultisample(toUint(c, 0), toInt(c, 1), toUint(c, 2), toInt(c, 3), toInt(c, 4)); break;
+		case glShaderSourceCall: {
+			const GLchar *source = c.blob ? (const GLchar *)c.blob : "";
+			GLint length = (GLint)c.blobSize;
+			glShaderSource(getName(programName, c.args[0]), 1, &source, &length);
+			break;
+		}
+		case glTexImage2DCall: glTexImage2D(toUint(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toInt(c, 4), toInt(c, 5), toUint(c, 6), toUint(c, 7), toData(c, 8)); break;
+		case glTexImage3DCall: glTexImage3D(toUint(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toInt(c, 4), toInt(c, 5), toInt(c, 6), toUint(c, 7), toUint(c, 8), toData(c, 9)); break;
+		case glTexParameteriCall: glTexParameteri(toUint(c, 0), toUint(c, 1), toInt(c, 2)); break;
+		case glTexSubImage2DCall: glTexSubImage2D(toUint(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toInt(c, 4), toInt(c, 5), toUint(c, 6), toUint(c, 7), toData(c, 8)); break;
+		case glTexSubImage3DCall: glTexSubImage3D(toUint(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3), toInt(c, 4), toInt(c, 5), toInt(c, 6), toInt(c, 7), toUint(c, 8), toUint(c, 9), toData(c, 10)); break;
+		case glUniform1fCall: glUniform1f(getLocation(c.args[0]), toFloat(c, 1)); break;
+		case glUniform1fvCall: glUniform1fv(getLocation(c.args[0]), toInt(c, 1), (const GLfloat *)c.blob); break;
+		case glUniform1iCall: glUniform1i(getLocation(c.args[0]), toInt(c, 1)); break;
+		case glUniform1ivCall: glUniform1iv(getLocation(c.args[0]), toInt(c, 1), (const GLint *)c.blob); break;
+		case glUniform1uivCall: glUniform1uiv(getLocation(c.args[0]), toInt(c, 1), (const GLuint *)c.blob); break;
+		case glUniform2fCall: glUniform2f(getLocation(c.args[0]), toFloat(c, 1), toFloat(c, 2)); break;
+		case glUniform2fvCall: glUniform2fv(getLocation(c.args[0]), toInt(c, 1), (const GLfloat *)c.blob); break;
+		case glUniform2ivCall: glUniform2iv(getLocation(c.args[0]), toInt(c, 1), (const GLint *)c.blob); break;
+		case glUniform2uivCall: glUniform2uiv(getLocation(c.args[0]), toInt(c, 1), (const GLuint *)c.blob); break;
+		case glUniform3fvCall: glUniform3fv(getLocation(c.args[0]), toInt(c, 1), (const GLfloat *)c.blob); break;
+		case glUniform3ivCall: glUniform3iv(getLocation(c.args[0]), toInt(c, 1), (const GLint *)c.blob); break;
+		case glUniform3uiCall: glUniform3ui(getLocation(c.args[0]), toUint(c, 1), toUint(c, 2), toUint(c, 3)); break;
+		case glUniform3uivCall: glUniform3uiv(getLocation(c.args[0]), toInt(c, 1), (const GLuint *)c.blob); break;
+		case glUniform4fvCall: glUniform4fv(getLocation(c.args[0]), toInt(c, 1), (const GLfloat *)c.blob); break;
+		case glUniform4ivCall: glUniform4iv(getLocation(c.args[0]), toInt(c, 1), (const GLint *)c.blob); break;
+		case glUniform4uivCall: glUniform4uiv(getLocation(c.args[0]), toInt(c, 1), (const GLuint *)c.blob); break;
+		case glUniformMatrix2fvCall: glUniformMatrix2fv(getLocation(c.args[0]), toInt(c, 1), toBoolean(c, 2), (const GLfloat *)c.blob); break;
+		case glUniformMatrix3fvCall: glUniformMatrix3fv(getLocation(c.args[0]), toInt(c, 1), toBoolean(c, 2), (const GLfloat *)c.blob); break;
+		case glUniformMatrix4fvCall: glUniformMatrix4fv(getLocation(c.args[0]), toInt(c, 1), toBoolean(c, 2), (const GLfloat *)c.blob); break;
+		case glUnmapBufferCall:
+			glUnmapBuffer(toUint(c, 0));
+			m_mappings.erase((u32)c.args[1]);
+			break;
+		case glUseProgramCall:
+			glUseProgram(getName(programName, c.args[0]));
+			m_program = (u32)c.args[0];
+			break;
+		case glVertexAttribBindingCall: glVertexAttribBinding(toUint(c, 0), toUint(c, 1)); break;
+		case glVertexAttribFormatCall: glVertexAttribFormat(toUint(c, 0), toInt(c, 1), toUint(c, 2), toBoolean(c, 3), toUint(c, 4)); break;
+		case glVertexAttribIFormatCall: glVertexAttribIFormat(toUint(c, 0), toInt(c, 1), toUint(c, 2), toUint(c, 3)); break;
+		case glVertexAttribIPointerCall: glVertexAttribIPointer(toUint(c, 0), toInt(c, 1), toUint(c, 2), toInt(c, 3), toPointer(c, 4)); break;
+		case glVertexAttribPointerCall: glVertexAttribPointer(toUint(c, 0), toInt(c, 1), toUint(c, 2), toBoolean(c, 3), toInt(c, 4), toPointer(c, 5)); break;
+		case glVertexBindingDivisorCall: glVertexBindingDivisor(toUint(c, 0), toUint(c, 1)); break;
+		case glViewportCall: glViewport(toInt(c, 0), toInt(c, 1), toInt(c, 2), toInt(c, 3)); break;
+		case mappedWriteCall: {
+			// Writes go through the replay's own mapping like they went through the captured one
+			std::unordered_map<u32, Mapping>::const_iterator mapping = m_mappings.find((u32)c.args[0]);
+			i64 offset = (i64)c.args[1];
+			if (mapping != m_mappings.end() && offset >= mapping->second.offset && offset + (i64)c.blobSize <= mapping->second.offset + mapping->second.length) {
+				memcpy(mapping->second.pointer + (offset - mapping->second.offset), c.blob, (size_t)c.blobSize);
+			}
+			else {
+				GLint previous = 0;
+				glGetIntegerv(GL_COPY_WRITE_BUFFER, &previous);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, getName(bufferName, c.args[0]));
+				glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)offset, (GLsizeiptr)c.blobSize, c.blob);
+				glBindBuffer(GL_COPY_WRITE_BUFFER, (GLuint)previous);
+			}
+			break;
+		}
+		default:
+			++m_skipped;
+			break;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef __GLREPLAY_FRAMEREPLAY_H__
+#define __GLREPLAY_FRAMEREPLAY_H__
+
+#pragma once
+
+#include <EncoShared\EncoShared.h>
+#include <EncoOpenGL\EncoOpenGL.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace enco {
+	// Replays a capture of OpenGLRenderer::captureFrame() in the current context. setup() creates the objects
+	// once, every replay() restores the state of the start of the frame and times each call of it, so the
+	// driver cost of one frame can be measured over and over.
+	class FrameReplay {
+	public:
+		struct Command {
+			GLCaptureCall call;
+			u8 argCount;
+			bool hasBlob;
+			u64 args[16];
+			const u8 *blob;
+			u64 blobSize;
+		};
+
+		// Milliseconds
+		struct CallTiming {
+			f64 total;
+			f64 max;
+		};
+
+		FrameReplay();
+		~FrameReplay();
+
+		bool load(const std::string &path);
+
+		// Needs a current context with the extensions initialized
+		void setup();
+		void replay();
+		// Deletes every object of the replay
+		void release();
+		// Drops the timings so far, e.g. of warmup replays
+		void resetTimings();
+
+		inline glm::u32vec2 getSize() const { return m_size; }
+		inline const std::vector<Command> &getFrameCommands() const { return m_sections[glCaptureFrame]; }
+		// One per command of the frame, summed over all replays
+		inline const std::vector<CallTiming> &getCallTimings() const { return m_callTimings; }
+		// CPU time of issuing the frame, the glFinish() after it and the GPU time, one per replay
+		inline const std::vector<f64> &getFrameTimes() const { return m_frameTimes; }
+		inline const std::vector<f64> &getFinishTimes() const { return m_finishTimes; }
+		inline const std::vector<f64> &getGpuTimes() const { return m_gpuTimes; }
+		inline uint getReplayCount() const { return (uint)m_frameTimes.size(); }
+		// Calls that referred to objects the capture does not contain, e.g. fences of earlier frames
+		inline uint getSkippedCount() const { return m_skipped; }
+
+	private:
+		FrameReplay(const FrameReplay &) = delete;
+		FrameReplay &operator=(const FrameReplay &) = delete;
+
+		// Shaders and programs share one namespace, like in GL
+		enum NameType : u8 {
+			bufferName,
+			textureName,
+			vertexArrayName,
+			framebufferName,
+			renderbufferName,
+			queryName,
+			programName,
+			nameTypeCount
+		};
+
+		struct Mapping {
+			u8 *pointer;
+			i64 offset;
+			i64 length;
+		};
+
+		struct FrameObject {
+			NameType type;
+			u32 name;
+		};
+
+		// The kind of name a Gen*() or Delete*() call takes
+		static NameType getNameType(GLCaptureCall call);
+		bool decode(GLCaptureSection section, const u8 *data, size_t size, u32 count);
+		void execute(const Command &command, bool frame);
+
+		GLuint getName(NameType type, u64 captured) const;
+		GLint getLocation(u64 captured) const;
+		void genNames(NameType type, const Command &command, bool frame);
+		void deleteNames(NameType type, const Command &command);
+		void deleteName(NameType type, u32 captured);
+		void deleteFrameObjects();
+
+		glm::u32vec2 m_size;
+		std::vector<u8> m_data;
+		std::vector<Command> m_sections[glCaptureSectionCount];
+		// The frame deletes objects of the setup, which then has to run again before every replay
+		bool m_rebuild;
+		bool m_ready;
+		bool m_played;
+
+		std::unordered_map<u32, GLuint> m_names[nameTypeCount];
+		std::unordered_map<u64, GLsync> m_syncs;
+		// Captured program << 32 | captured location -> location
+		std::unordered_map<u64, GLint> m_locations;
+		std::unordered_map<u32, Mapping> m_mappings;
+		std::vector<FrameObject> m_frameObjects;
+		std::vector<u64> m_frameSyncs;
+		u32 m_program;
+		std::vector<u8> m_scratch;
+
+		GLuint m_queries[2];
+		std::vector<CallTiming> m_callTimings;
+		std::vector<f64> m_frameTimes;
+		std::vector<f64> m_finishTimes;
+		std::vector<f64> m_gpuTimes;
+		uint m_skipped;
+	};
+}
+
+#endif
\ No newline at end of file
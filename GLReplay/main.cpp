@@ -0,0 +1,160 @@
+#include <EncoShared\EncoShared.h>
+#include <EncoOpenGL\EncoOpenGL.h>
+
+#include "FrameReplay.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace enco;
+
+namespace {
+	struct FunctionTiming {
+		GLCaptureCall call;
+		uint count;
+		f64 total;
+	};
+
+	void printUsage() {
+		printf("GLReplay capture.eglc [--iterations 100] [--warmup 5] [--top 20] [--csv calls.csv] [--llvmpipe]\n");
+	}
+
+	f64 getMean(const std::vector<f64> &values) {
+		f64 sum = 0.0;
+		for (size_t i = 0; i < values.size(); ++i) {
+			sum += values[i];
+		}
+		return values.empty() ? 0.0 : sum / (f64)values.size();
+	}
+
+	void printReport(const FrameReplay &replay, uint top) {
+		const std::vector<FrameReplay::Command> &commands = replay.getFrameCommands();
+		const std::vector<FrameReplay::CallTiming> &timings = replay.getCallTimings();
+		f64 replays = (f64)std::max(replay.getReplayCount(), 1u);
+
+		printf("%u replays of %u calls\n", replay.getReplayCount(), (uint)commands.size());
+		printf("frame cpu %.3f ms, finish %.3f ms, gpu %.3f ms\n\n", getMean(replay.getFrameTimes()), getMean(replay.getFinishTimes()), getMean(replay.getGpuTimes()));
+
+		std::vector<FunctionTiming> functions(glCaptureCallCount);
+		for (uint i = 0; i < glCaptureCallCount; ++i) {
+			functions[i].call = (GLCaptureCall)i;
+			functions[i].count = 0;
+			functions[i].total = 0.0;
+		}
+		for (size_t i = 0; i < commands.size(); ++i) {
+			++functions[commands[i].call].count;
+			functions[commands[i].call].total += timings[i].total / replays;
+		}
+		std::sort(functions.begin(), functions.end(), [](const FunctionTiming &a, const FunctionTiming &b) { return a.total > b.total; });
+		printf("%-36s %8s %12s\n", "function", "calls", "ms/frame");
+		for (size_t i = 0; i < functions.size() && functions[i].count > 0; ++i) {
+			printf("%-36s %8u %12.4f\n", getGLCaptureCallName(functions[i].call), functions[i].count, functions[i].total);
+		}
+
+		std::vector<uint> order(commands.size());
+		for (size_t i = 0; i < order.size(); ++i) {
+			order[i] = (uint)i;
+		}
+		std::sort(order.begin(), order.end(), [&timings](uint a, uint b) { return timings[a].total > timings[b].total; });
+		printf("\n%-8s %-36s %12s %12s\n", "index", "call", "mean ms", "max ms");
+		for (size_t i = 0; i < order.size() && i < top; ++i) {
+			const FrameReplay::CallTiming &timing = timings[order[i]];
+			printf("%-8u %-36s %12.4f %12.4f\n", order[i], getGLCaptureCallName(commands[order[i]].call), timing.total / replays, timing.max);
+		}
+
+		if (replay.getSkippedCount() > 0) {
+			printf("\n%u call(s) skipped, they referred to objects outside the capture\n", replay.getSkippedCount());
+		}
+	}
+
+	bool writeCsv(const FrameReplay &replay, const std::string &path) {
+		std::ofstream file(path);
+		if (!file) {
+			return false;
+		}
+
+		const std::vector<FrameReplay::Command> &commands = replay.getFrameCommands();
+		const std::vector<FrameReplay::CallTiming> &timings = replay.getCallTimings();
+		f64 replays = (f64)std::max(replay.getReplayCount(), 1u);
+		file << "index,call,meanMs,maxMs\n";
+		for (size_t i = 0; i < commands.size(); ++i) {
+			file << i << "," << getGLCaptureCallName(commands[i].call) << "," << timings[i].total / replays << "," << timings[i].max << "\n";
+		}
+		return file.good();
+	}
+}
+
+int main(int argc, char **argv) {
+	std::string capture, csv;
+	uint iterations = 100, warmup = 5, top = 20;
+
+	for (int i = 1; i < argc; ++i) {
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--iterations") == 0 && hasValue) {
+			iterations = (uint)std::max(atoi(argv[++i]), 1);
+		}
+		else if (strcmp(argv[i], "--warmup") == 0 && hasValue) {
+			warmup = (uint)std::max(atoi(argv[++i]), 0);
+		}
+		else if (strcmp(argv[i], "--top") == 0 && hasValue) {
+			top = (uint)std::max(atoi(argv[++i]), 0);
+		}
+		else if (strcmp(argv[i], "--csv") == 0 && hasValue) {
+			csv = argv[++i];
+		}
+		else if (strcmp(argv[i], "--llvmpipe") == 0) {
+			OpenGLRenderer::forceLlvmpipe();
+		}
+		else if (argv[i][0] != '-' && capture.empty()) {
+			capture = argv[i];
+		}
+		else {
+			printUsage();
+			return 2;
+		}
+	}
+	if (capture.empty()) {
+		printUsage();
+		return 2;
+	}
+
+	FrameReplay replay;
+	if (!replay.load(capture)) {
+		return 1;
+	}
+
+	OpenGLRenderer renderer;
+	glm::u32vec2 size = replay.getSize();
+	renderer.createContext(0, 0, std::max(size.x, 1u), std::max(size.y, 1u), 32, 24, 8, false, nullptr);
+	const char *name = renderer.isHeadless() ? (const char *)glGetString(GL_RENDERER) : nullptr;
+	if (!name) {
+		printf("GLReplay Error: no GL context\n");
+		return 1;
+	}
+	printf("GLReplay: %s on %s\n", capture.c_str(), name);
+
+	replay.setup();
+	for (uint i = 0; i < warmup; ++i) {
+		replay.replay();
+	}
+	replay.resetTimings();
+	for (uint i = 0; i < iterations; ++i) {
+		replay.replay();
+	}
+
+	printReport(replay, top);
+	int result = 0;
+	if (!csv.empty() && !writeCsv(replay, csv)) {
+		printf("GLReplay Error: could not write %s\n", csv.c_str());
+		result = 1;
+	}
+
+	replay.release();
+	renderer.deleteContext(nullptr);
+	return result;
+}
\ No newline at end of file